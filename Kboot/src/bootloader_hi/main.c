@@ -221,20 +221,30 @@ static uint32_t app_sha256()
 
 /*
  * Check the current application CRC32 value
+ * Byte lookup table is generated first (1KB of RAM),
+ * it is ~8 times faster than calculating the CRC bit by bit
+ * (.bss is not cleared on startup, so no 'table ready' flag is used)
  */
+static uint32_t crc32_table[256];
+
 //-------------------------
 static uint32_t app_crc32()
 {
     uint32_t crc = 0xFFFFFFFF;
     uint32_t byte, mask;
+
+    for (uint32_t i = 0; i < 256; i++) {
+        byte = i;
+        for (uint32_t j = 0; j < 8; j++) {
+            mask = -(byte & 1);
+            byte = (byte >> 1) ^ (0xEDB88320 & mask);
+        }
+        crc32_table[i] = byte;
+    }
     // Read from flash and update CRC32 value
     for (uint32_t n = 5; n < (cfg_size+5); n++) {
         byte = app_flash_ptr[cfg_address + n];
-        crc = crc ^ byte;
-        for (uint32_t j = 0; j < 8; j++) {
-            mask = -(crc & 1);
-            crc = (crc >> 1) ^ (0xEDB88320 & mask);
-        }
+        crc = (crc >> 8) ^ crc32_table[(crc ^ byte) & 0xFF];
     }
     crc32 = ~crc;
     if (crc32 != cfg_crc) {
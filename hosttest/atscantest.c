@@ -0,0 +1,275 @@
+/*
+ * AT response scanner test on host
+ *
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Recorded ESP8266/ESP32 and SIM800 AT traces are fed to a small uart ring buffer
+ * in random size chunks, as the uart ISR does, and scanned with 'at_scan.c'.
+ * The match events are compared with a brute force search over the whole trace:
+ *  - 'keep' mode: only the bytes reported by at_scan_unmatched() are removed,
+ *    all matches are expected, ordered by end position and pattern index
+ *  - 'flush' mode: the buffer is removed up to the match end after each match,
+ *    as _at_Cmd_Response() does, only the first match ending at each byte and
+ *    not overlapping the previous match is expected
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "at_scan.h"
+
+#define MAX_EVENTS  256
+
+typedef struct _trace_t {
+    const char *name;
+    const char *patterns[AT_SCAN_MAX_PATTERNS];
+    int npatterns;
+    const char *data;
+} trace_t;
+
+typedef struct _event_t {
+    int pattern;
+    size_t start;   // stream position of the match start
+} event_t;
+
+static uint32_t test_count = 200;
+static int errors = 0;
+
+// === Recorded AT traces ===
+static const trace_t traces[] = {
+    {
+        "esp8266 connect",
+        { "OK\r\n", "ERROR\r\n", "FAIL\r\n", "busy p..." }, 4,
+        "AT+CWJAP_CUR=\"LoBoInternet\",\"*********\"\r\n"
+        "busy p...\r\nWIFI DISCONNECT\r\nWIFI CONNECTED\r\nWIFI GOT IP\r\n\r\nOK\r\n"
+        "AT+CIFSR\r\n+CIFSR:STAIP,\"192.168.0.21\"\r\n+CIFSR:STAMAC,\"5c:cf:7f:01:23:45\"\r\n\r\nOK\r\n"
+        "AT+CWJAP_CUR?\r\n+CWJAP_CUR:\"LoBoInternet\",\"00:11:22:33:44:55\",6,-63\r\n\r\nERROR\r\n"
+    },
+    {
+        "esp8266 socket",
+        { ",CLOSED", ",CONNECT", "ready", "+IPD,", "SEND OK", "OK" }, 6,
+        "AT+CIPSTART=0,\"TCP\",\"loboris.eu\",80\r\n0,CONNECT\r\n\r\nOK\r\n"
+        "AT+CIPSEND=0,18\r\n\r\nOK\r\n> \r\nRecv 18 bytes\r\n\r\nSEND OK\r\n"
+        "\r\n+IPD,0,64:HTTP/1.1 200 OK\r\nServer: nginx\r\nContent-Length: 5\r\n\r\nhello"
+        "\r\n+IPD,0,12:OK,CLOSED,OK\r\n0,CLOSED\r\n"
+        "\r\n ets Jan  8 2013,rst cause:2, boot mode:(3,6)\r\n\r\nready\r\n"
+    },
+    {
+        "sim800 ppp",
+        { "OK", "ERROR", "CONNECT", "NO CARRIER", "+CREG: 0,1", "+CREG: 0,5" }, 6,
+        "AT\r\r\nOK\r\nATE0\r\r\nOK\r\n"
+        "AT+CREG?\r\n+CREG: 0,2\r\n\r\nOK\r\nAT+CREG?\r\n+CREG: 0,5\r\n\r\nOK\r\n"
+        "AT+CGDCONT=1,\"IP\",\"internet\"\r\n\r\nOK\r\nATDT*99***1#\r\n\r\nCONNECT 150000000\r\n"
+        "~\xFF\x7D\x23\xC0\x21\x7E~NO CARRIEROK\r\n\r\nNO CARRIER\r\n+CME ERROR: 100\r\n"
+    },
+    {
+        "suffixes",
+        { "OK", "SEND OK", "K", "ND", "SEND", "OKOK" }, 6,
+        "SEND OK\r\nSENDOKOKOK\r\nSSEND OKK\r\nOOKK SEN SEND\r\nOKOKOKOK"
+    },
+};
+#define NTRACES (sizeof(traces) / sizeof(traces[0]))
+
+// Brute force search of all matches, ordered by end position, then by pattern index
+//----------------------------------------------------------------------------------------
+static int find_all(const trace_t *t, size_t data_len, event_t *events, bool flush)
+{
+    int n = 0;
+    size_t min_start = 0;
+    for (size_t end = 1; end <= data_len; end++) {
+        for (int p = 0; p < t->npatterns; p++) {
+            size_t len = strlen(t->patterns[p]);
+            if ((len == 0) || (len > end)) continue;
+            size_t start = end - len;
+            if ((flush) && (start < min_start)) continue;
+            if (memcmp(t->data + start, t->patterns[p], len) != 0) continue;
+            if (n >= MAX_EVENTS) return n;
+            events[n].pattern = p;
+            events[n].start = start;
+            n++;
+            if (flush) {
+                min_start = end;
+                break;
+            }
+        }
+    }
+    return n;
+}
+
+// Feed the trace to the ring buffer in random chunks and collect the scanner events
+//-----------------------------------------------------------------------------------------------------------------
+static int scan_trace(at_scanner_t *sc, const trace_t *t, size_t data_len, size_t buf_size, event_t *events, bool flush)
+{
+    uint8_t *buf = malloc(buf_size);
+    uart_ringbuf_t r;
+    at_scan_event_t event;
+    size_t fed = 0;
+    size_t removed = 0;     // stream position of the buffer head
+    int n = 0;
+
+    // not a uart buffer, so uart_buf_put() can be used as the producer
+    uart_buf_init(&r, buf, buf_size, UART_NUM_MAX);
+    at_scan_start(sc, &r, 0);
+    while (1) {
+        if (fed < data_len) {
+            size_t chunk = 1 + (rand() % 24);
+            size_t room = buf_size - uart_buf_length(&r, NULL);
+            if (chunk > (data_len - fed)) chunk = data_len - fed;
+            if (chunk > room) chunk = room;
+            fed += uart_buf_put(&r, (uint8_t *)t->data + fed, chunk);
+        }
+        bool found = false;
+        while (at_scan_next(sc, &r, &event)) {
+            found = true;
+            if (n < MAX_EVENTS) {
+                events[n].pattern = event.pattern;
+                events[n].start = removed + event.pos;
+                n++;
+            }
+            if (event.len != strlen(t->patterns[event.pattern])) {
+                printf("%s: wrong match length %u\r\n", t->name, (unsigned)event.len);
+                errors++;
+            }
+            if (flush) {
+                removed += uart_buf_remove(&r, event.pos + event.len);
+            }
+        }
+        // remove the data which can not be a part of a match
+        size_t unmatched = at_scan_unmatched(sc, &r);
+        if ((!flush) || (rand() & 1)) removed += uart_buf_remove(&r, unmatched);
+        if ((!found) && (fed >= data_len)) break;
+    }
+    if (uart_buf_overflow(&r) != 0) {
+        printf("%s: unexpected buffer overflow\r\n", t->name);
+        errors++;
+    }
+    free(buf);
+    return n;
+}
+
+//-----------------------------------------------------------------------
+static void compare(const trace_t *t, size_t buf_size, bool flush, bool show)
+{
+    event_t expected[MAX_EVENTS];
+    event_t got[MAX_EVENTS];
+    at_scanner_t *sc = malloc(sizeof(at_scanner_t));
+    size_t data_len = strlen(t->data);
+
+    sc->key_len = 0;
+    if (!at_scan_compile(sc, t->patterns, t->npatterns)) {
+        printf("%s: patterns not compiled\r\n", t->name);
+        errors++;
+        free(sc);
+        return;
+    }
+    int n_expected = find_all(t, data_len, expected, flush);
+    int n_got = scan_trace(sc, t, data_len, buf_size, got, flush);
+    if (show) printf("%-16s %-6s %4u bytes, %3d matches\r\n", t->name, (flush) ? "flush" : "keep", (unsigned)data_len, n_expected);
+
+    bool ok = (n_got == n_expected);
+    for (int i = 0; (ok) && (i < n_got); i++) {
+        if ((got[i].pattern != expected[i].pattern) || (got[i].start != expected[i].start)) ok = false;
+    }
+    if (!ok) {
+        printf("%s (%s, buffer %u): %d matches, expected %d\r\n", t->name, (flush) ? "flush" : "keep", (unsigned)buf_size, n_got, n_expected);
+        for (int i = 0; (i < n_got) || (i < n_expected); i++) {
+            if (i < n_got) printf("  got [%d]@%u", got[i].pattern, (unsigned)got[i].start);
+            else printf("  got -      ");
+            if (i < n_expected) printf("  expected [%d]@%u", expected[i].pattern, (unsigned)expected[i].start);
+            printf("\r\n");
+        }
+        errors++;
+    }
+    free(sc);
+}
+
+// The automaton is rebuilt only when the pattern set changes
+//------------------------
+static void test_compile(void)
+{
+    const char *set1[] = { "OK\r\n", "ERROR\r\n" };
+    const char *set2[] = { "OK\r\n", "ERROR\r\n", "FAIL" };
+    const char *set3[] = { "OK\r\n", "ERROR" };
+    at_scanner_t *sc = malloc(sizeof(at_scanner_t));
+
+    sc->key_len = 0;
+    at_scan_compile(sc, set1, 2);
+    sc->state = 1;  // marker, cleared by at_scan_init()
+    at_scan_compile(sc, set1, 2);
+    if (sc->state != 1) {
+        printf("compile: same patterns compiled again\r\n");
+        errors++;
+    }
+    at_scan_compile(sc, set2, 3);
+    if ((sc->state != 0) || (sc->npatterns != 3)) {
+        printf("compile: changed pattern set not compiled\r\n");
+        errors++;
+    }
+    sc->state = 1;
+    at_scan_compile(sc, set3, 2);
+    if ((sc->state != 0) || (sc->pattern_len[1] != 5)) {
+        printf("compile: changed pattern not compiled\r\n");
+        errors++;
+    }
+    free(sc);
+}
+
+//=============================
+int main(int argc, char **argv) {
+    int c;
+
+    while ( (c = getopt(argc, argv, "n:h")) != -1) {
+        switch (c) {
+            case 'n':
+                test_count = strtol(optarg, NULL, 0);
+                break;
+            default:
+                printf("Usage:\r\n  atscantest [-n count]\r\n");
+                return 1;
+        }
+    }
+
+    srand(1);
+    test_compile();
+    for (unsigned i = 0; i < NTRACES; i++) {
+        compare(&traces[i], 1024, false, true);
+        compare(&traces[i], 1024, true, true);
+        for (uint32_t n = 0; n < test_count; n++) {
+            // small buffers, the data wraps around the buffer end
+            compare(&traces[i], 32 << (n % 3), false, false);
+            compare(&traces[i], 32 << (n % 3), true, false);
+        }
+    }
+    printf("AT scanner test: %s (%d errors)\r\n", (errors) ? "FAILED" : "passed", errors);
+    return (errors) ? 1 : 0;
+}
@@ -0,0 +1,375 @@
+/*
+ * Camera frame conversion test and benchmark on host
+ *
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * camframe_convert() (used by the camera preview to copy the frames to the display)
+ * is compared with a reference swap + scale + rotate written pixel by pixel, for
+ * random frame, window and frame buffer sizes, positions (clipping), rotations and
+ * buffer alignments; the frame buffer must be bit-exact, including the pixels
+ * outside the window. The window sizes from camframe_fit() are checked for the
+ * camera frame sizes and common display sizes.
+ * Pixel rate of the fused conversion is compared with the previous swap pass +
+ * send_data_scale() copy.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "camframe.h"
+
+#define MAX_SIZE    400
+#define FB_FILL     0xA55A
+
+static uint32_t test_count = 3000;
+static uint32_t bench_count = 100;
+static int errors = 0;
+
+// === Reference functions ===
+
+// Pixel (x, y) of the camera frame, with the pixel pairs swapped back
+//----------------------------------------------------------------------------
+static uint16_t ref_pixel(const uint16_t *buf, int width, int x, int y)
+{
+    return buf[(y * width) + (x ^ 1)];
+}
+
+// Blend each color component separately
+//------------------------------------------------------------
+static uint16_t ref_blend(uint16_t a, uint16_t b, uint32_t w)
+{
+    uint32_t r = ((((a >> 11) & 0x1F) * (32 - w)) + (((b >> 11) & 0x1F) * w)) >> 5;
+    uint32_t g = ((((a >> 5) & 0x3F) * (32 - w)) + (((b >> 5) & 0x3F) * w)) >> 5;
+    uint32_t bl = (((a & 0x1F) * (32 - w)) + ((b & 0x1F) * w)) >> 5;
+    return (r << 11) | (g << 5) | bl;
+}
+
+// Every window pixel is rotated back to the unrotated window, then
+// scaled to the frame position (16.16 fixed point), the pixel is written if inside the frame buffer
+//---------------------------------------------------------------------------------------------------------------
+static void ref_convert(uint16_t *fb, int fb_width, int fb_height, int x1, int y1, int dst_width, int dst_height,
+                        const uint16_t *buf, int width, int height, uint8_t rot, bool bilinear)
+{
+    int ux = (rot & 1) ? dst_height : dst_width;
+    int uy = (rot & 1) ? dst_width : dst_height;
+    int64_t xstep = ((int64_t)width << 16) / ux;
+    int64_t ystep = ((int64_t)height << 16) / uy;
+
+    for (int v=0; v<dst_height; v++) {
+        for (int u=0; u<dst_width; u++) {
+            int tx = x1 + u;
+            int ty = y1 + v;
+            if ((tx < 0) || (ty < 0) || (tx >= fb_width) || (ty >= fb_height)) continue;
+            int p, q;
+            switch (rot) {
+                case 0: p = u; q = v; break;
+                case 1: p = v; q = dst_width - 1 - u; break;
+                case 2: p = dst_width - 1 - u; q = dst_height - 1 - v; break;
+                default: p = dst_height - 1 - v; q = u; break;
+            }
+            int64_t sx = p * xstep;
+            int64_t sy = q * ystep;
+            int x = sx >> 16;
+            int y = sy >> 16;
+            uint16_t c;
+            if (!bilinear) c = ref_pixel(buf, width, x, y);
+            else {
+                int xn = (x < (width - 1)) ? x + 1 : x;
+                int yn = (y < (height - 1)) ? y + 1 : y;
+                uint32_t wx = (sx >> 11) & 0x1F;
+                uint32_t wy = (sy >> 11) & 0x1F;
+                uint16_t c0 = ref_blend(ref_pixel(buf, width, x, y), ref_pixel(buf, width, xn, y), wx);
+                uint16_t c1 = ref_blend(ref_pixel(buf, width, x, yn), ref_pixel(buf, width, xn, yn), wx);
+                c = ref_blend(c0, c1, wy);
+            }
+            fb[(ty * fb_width) + tx] = c;
+        }
+    }
+}
+
+// === Previous camera preview functions, used for the benchmark ===
+
+//------------------------------------------------------
+static void old_swap_pixels(uint16_t *cbuff, int size)
+{
+    uint16_t tmpclr;
+    for (int i=0; i<size; i+=2) {
+        tmpclr = cbuff[i];
+        cbuff[i] = cbuff[i+1];
+        cbuff[i+1] = tmpclr;
+    }
+}
+
+// send_data_scale() frame buffer path, scale = 0
+//------------------------------------------------------------------------------------------
+static void old_send_data_scale(uint16_t *fb, int fb_width, int fb_height, int width, int height, uint16_t *buf)
+{
+    if ((width == fb_width) && (height == fb_height)) {
+        memcpy(fb, buf, width*height*2);
+        return;
+    }
+    int xyscale = width / fb_width;
+    if ((width % fb_width) > 0) xyscale++;
+    if (xyscale <= 1) xyscale = 1;
+    for (int y = 0; y < height; y++) {
+        int ty = y/xyscale;
+        if (ty >= fb_height) break;
+        for (int x = 0; x < width; x++) {
+            int tx = x/xyscale;
+            if (tx >= fb_width) break;
+            fb[(ty * fb_width) + tx] = buf[(y * width) + x];
+        }
+    }
+}
+
+// === Tests ===
+
+//-----------------------
+static int rnd(int n)
+{
+    return rand() % n;
+}
+
+// Random conversion compared with the reference
+//----------------------------
+static void test_convert(void)
+{
+    // +4 pixels for the alignment offsets
+    uint16_t *frame = malloc((MAX_SIZE * MAX_SIZE + 4) * 2);
+    uint16_t *frame_copy = malloc(MAX_SIZE * MAX_SIZE * 2);
+    uint16_t *fb = malloc((MAX_SIZE * MAX_SIZE + 4) * 2);
+    uint16_t *fb_ref = malloc(MAX_SIZE * MAX_SIZE * 2);
+
+    for (uint32_t n = 0; n < test_count; n++) {
+        int width = 2 * (1 + rnd(MAX_SIZE / 2));
+        int height = 1 + rnd(MAX_SIZE);
+        uint8_t rot = rnd(4);
+        bool bilinear = rnd(2);
+        int fb_width = 1 + rnd(MAX_SIZE);
+        int fb_height = 1 + rnd(MAX_SIZE);
+        int dst_width, dst_height;
+        if ((n % 4) == 0) {
+            // not scaled, 1:1 copy if not rotated
+            dst_width = (rot & 1) ? height : width;
+            dst_height = (rot & 1) ? width : height;
+        }
+        else {
+            dst_width = 1 + rnd(MAX_SIZE);
+            dst_height = 1 + rnd(MAX_SIZE);
+        }
+        int x1 = rnd(fb_width + dst_width) - dst_width;
+        int y1 = rnd(fb_height + dst_height) - dst_height;
+        if ((n % 8) == 0) x1 &= ~1;
+        if ((n % 3) == 0) {
+            x1 = 0;
+            y1 = 0;
+        }
+        uint16_t *buf = frame + rnd(4);
+        uint16_t *fbuf = fb + rnd(4);
+
+        for (int i = 0; i < (width * height); i++) buf[i] = rand();
+        memcpy(frame_copy, buf, width * height * 2);
+        for (int i = 0; i < (fb_width * fb_height); i++) {
+            fbuf[i] = FB_FILL;
+            fb_ref[i] = FB_FILL;
+        }
+
+        camframe_win_t win;
+        bool res = camframe_convert(fbuf, fb_width, fb_height, x1, y1, dst_width, dst_height, buf, width, height, rot, bilinear, &win);
+        ref_convert(fb_ref, fb_width, fb_height, x1, y1, dst_width, dst_height, buf, width, height, rot, bilinear);
+
+        // expected written area
+        int ex1 = (x1 < 0) ? 0 : x1;
+        int ey1 = (y1 < 0) ? 0 : y1;
+        int ex2 = ((x1 + dst_width) > fb_width) ? fb_width - 1 : x1 + dst_width - 1;
+        int ey2 = ((y1 + dst_height) > fb_height) ? fb_height - 1 : y1 + dst_height - 1;
+        bool visible = (ex1 <= ex2) && (ey1 <= ey2);
+
+        char case_str[128];
+        snprintf(case_str, sizeof(case_str), "frame %dx%d -> (%d,%d) %dx%d, fb %dx%d, rot=%u, bilinear=%d",
+                width, height, x1, y1, dst_width, dst_height, fb_width, fb_height, rot, bilinear);
+        if (res != visible) {
+            printf("%s: returned %d\r\n", case_str, res);
+            errors++;
+            continue;
+        }
+        if ((res) && ((win.x1 != ex1) || (win.y1 != ey1) || (win.x2 != ex2) || (win.y2 != ey2))) {
+            printf("%s: window (%d,%d,%d,%d), expected (%d,%d,%d,%d)\r\n", case_str, win.x1, win.y1, win.x2, win.y2, ex1, ey1, ex2, ey2);
+            errors++;
+        }
+        if (memcmp(buf, frame_copy, width * height * 2) != 0) {
+            printf("%s: frame changed\r\n", case_str);
+            errors++;
+        }
+        for (int i = 0; i < (fb_width * fb_height); i++) {
+            if (fbuf[i] != fb_ref[i]) {
+                printf("%s: pixel (%d,%d) %04X, expected %04X\r\n", case_str, i % fb_width, i / fb_width, fbuf[i], fb_ref[i]);
+                errors++;
+                break;
+            }
+        }
+    }
+
+    // odd frame width is not accepted
+    camframe_win_t win;
+    if (camframe_convert(fb, 16, 16, 0, 0, 8, 8, frame, 15, 8, 0, false, &win)) {
+        printf("odd frame width accepted\r\n");
+        errors++;
+    }
+
+    free(frame);
+    free(frame_copy);
+    free(fb);
+    free(fb_ref);
+}
+
+// Camera frame sizes fitted to the display sizes
+//------------------------
+static void test_fit(void)
+{
+    static const int frames[][2] = { {160, 120}, {176, 144}, {320, 240}, {352, 288}, {640, 480}, {800, 600} };
+    static const int displays[][2] = { {320, 240}, {240, 320}, {160, 128}, {480, 320}, {128, 128} };
+
+    for (unsigned f = 0; f < (sizeof(frames) / sizeof(frames[0])); f++) {
+        for (unsigned d = 0; d < (sizeof(displays) / sizeof(displays[0])); d++) {
+            for (uint8_t rot = 0; rot < 4; rot++) {
+                for (int bilinear = 0; bilinear < 2; bilinear++) {
+                    int w = (rot & 1) ? frames[f][1] : frames[f][0];
+                    int h = (rot & 1) ? frames[f][0] : frames[f][1];
+                    int dw = displays[d][0];
+                    int dh = displays[d][1];
+                    int fw, fh;
+                    camframe_fit(frames[f][0], frames[f][1], rot, bilinear, dw, dh, &fw, &fh);
+
+                    bool ok = (fw > 0) && (fh > 0) && (fw <= dw) && (fh <= dh);
+                    if ((w <= dw) && (h <= dh)) ok = ok && (fw == w) && (fh == h);
+                    else if (bilinear) {
+                        // one side fills the display, the other keeps the aspect ratio
+                        ok = ok && (((fw == dw) && (fh == ((h * dw) / w))) || ((fh == dh) && (fw == ((w * dh) / h))));
+                    }
+                    else {
+                        // the smallest integer scale which fits
+                        int scale = w / fw;
+                        ok = ok && (fw == (w / scale)) && (fh == (h / scale));
+                        ok = ok && (scale > 1) && (((w / (scale - 1)) > dw) || ((h / (scale - 1)) > dh));
+                    }
+                    if (!ok) {
+                        printf("fit: frame %dx%d, display %dx%d, rot=%u, bilinear=%d: %dx%d\r\n",
+                                frames[f][0], frames[f][1], dw, dh, rot, bilinear, fw, fh);
+                        errors++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// === Benchmark ===
+
+//-----------------------
+static double time_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+//------------------------------------------------------------------------------------------------------------------
+static void bench(const char *name, int width, int height, int fb_width, int fb_height, uint8_t rot, bool bilinear, bool old)
+{
+    uint16_t *frame = malloc(width * height * 2);
+    uint16_t *fb = malloc(fb_width * fb_height * 2);
+    for (int i = 0; i < (width * height); i++) frame[i] = rand();
+
+    int dst_width, dst_height;
+    camframe_win_t win;
+    camframe_fit(width, height, rot, bilinear, fb_width, fb_height, &dst_width, &dst_height);
+    double t = time_ms();
+    for (uint32_t i = 0; i < bench_count; i++) {
+        if (old) {
+            old_swap_pixels(frame, width * height);
+            old_send_data_scale(fb, fb_width, fb_height, width, height, frame);
+        }
+        else camframe_convert(fb, fb_width, fb_height, 0, 0, dst_width, dst_height, frame, width, height, rot, bilinear, &win);
+    }
+    t = time_ms() - t;
+    printf("%-28s %4dx%-4d %10.3f %10.1f %10.1f\r\n", name, dst_width, dst_height, t / bench_count,
+            (bench_count * 1000.0) / t, ((double)width * height * bench_count) / (t * 1000.0));
+    free(frame);
+    free(fb);
+}
+
+//=============================
+int main(int argc, char **argv) {
+    int c;
+
+    while ( (c = getopt(argc, argv, "n:b:h")) != -1) {
+        switch (c) {
+            case 'n':
+                test_count = strtol(optarg, NULL, 0);
+                break;
+            case 'b':
+                bench_count = strtol(optarg, NULL, 0);
+                break;
+            default:
+                printf("Usage:\r\n  camframetest [-n count] [-b count]\r\n");
+                return 1;
+        }
+    }
+    if (bench_count == 0) {
+        printf("Wrong parameters\r\n");
+        return 1;
+    }
+
+    srand(1);
+    test_convert();
+    test_fit();
+    printf("Camera frame test: %s (%d errors)\r\n", (errors) ? "FAILED" : "passed", errors);
+
+    printf("------------------------------------------------------------------------\r\n");
+    printf("%-28s %9s %10s %10s %10s\r\n", "Frame -> 320x240 display", "window", "ms/frame", "frames/s", "Mpix/s");
+    printf("------------------------------------------------------------------------\r\n");
+    bench("QVGA old swap + copy", 320, 240, 320, 240, 0, false, true);
+    bench("QVGA fused 1:1", 320, 240, 320, 240, 0, false, false);
+    bench("QVGA fused 1:1 rotate 180", 320, 240, 320, 240, 2, false, false);
+    bench("QVGA fused rotate 90", 320, 240, 320, 240, 1, false, false);
+    bench("QVGA fused rotate 90 bilin.", 320, 240, 320, 240, 1, true, false);
+    bench("VGA old swap + scale", 640, 480, 320, 240, 0, false, true);
+    bench("VGA fused 1/2 nearest", 640, 480, 320, 240, 0, false, false);
+    bench("VGA fused 1/2 bilinear", 640, 480, 320, 240, 0, true, false);
+    printf("------------------------------------------------------------------------\r\n");
+    printf("Mpix/s: camera frame pixels\r\n");
+
+    return (errors) ? 1 : 0;
+}
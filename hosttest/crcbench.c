@@ -0,0 +1,194 @@
+/*
+ * hal_crc32/hal_crc16/hal_crc8 test and benchmark on host
+ *
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The slicing-by-8 functions from the SDK 'utility.c' are compared with the
+ * byte table loops they replaced, for all start alignments, short and long buffers
+ * and for the CRC calculated in chunks (as 'calc_app_crc32()' does it).
+ * Throughput in MB/s of both versions is reported.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "utility.h"
+
+static uint32_t bench_size = 2*1024*1024;
+static uint32_t bench_count = 10;
+static int errors = 0;
+
+// === Byte table versions, as used before slicing-by-8 ===
+
+//--------------------------------------------------------------------
+static uint8_t ref_crc8(const void* data, size_t length, uint8_t crc)
+{
+    const uint8_t *pbuf = (const uint8_t *)data;
+    while (length--) crc = Crc8LookupTable[crc ^ *pbuf++];
+    return crc;
+}
+
+//-----------------------------------------------------------------------------------
+static uint16_t ref_crc16(const void* data, size_t length, uint16_t previousCrc16)
+{
+    uint16_t crc = ~previousCrc16;
+    const uint8_t *pbuf = (const uint8_t *)data;
+    while (length--) crc = (crc<<8) ^ Crc16LookupTable[((crc>>8) ^ *pbuf++) & 0x00FF];
+    return crc;
+}
+
+//-----------------------------------------------------------------------------------
+static uint32_t ref_crc32(const void* data, size_t length, uint32_t previousCrc32)
+{
+    uint32_t crc = ~previousCrc32;
+    const uint8_t *pbuf = (const uint8_t *)data;
+    while (length--) crc = (crc >> 8) ^ Crc32LookupTable[(crc & 0xFF) ^ *pbuf++];
+    return ~crc;
+}
+
+//-----------------------
+static double time_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+//------------------------------------------------------------------------
+static void check(const char *name, uint32_t got, uint32_t expected, size_t offset, size_t len)
+{
+    if (got != expected) {
+        printf("%s mismatch: offset=%u, len=%u: %08X <> %08X\r\n", name, (unsigned)offset, (unsigned)len, got, expected);
+        errors++;
+    }
+}
+
+// Compare with the byte loops for all alignments and lengths 0 ~ 300
+//-------------------------------
+static void test_crc(uint8_t *buf)
+{
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t len = 0; len <= 300; len++) {
+            check("crc32", hal_crc32(buf + offset, len, 0), ref_crc32(buf + offset, len, 0), offset, len);
+            check("crc16", hal_crc16(buf + offset, len, 0), ref_crc16(buf + offset, len, 0), offset, len);
+            check("crc8", hal_crc8(buf + offset, len, 0), ref_crc8(buf + offset, len, 0), offset, len);
+            // continued crc
+            check("crc32 prev", hal_crc32(buf + offset, len, 0x12345678), ref_crc32(buf + offset, len, 0x12345678), offset, len);
+            check("crc16 prev", hal_crc16(buf + offset, len, 0x1234), ref_crc16(buf + offset, len, 0x1234), offset, len);
+            check("crc8 prev", hal_crc8(buf + offset, len, 0x5A), ref_crc8(buf + offset, len, 0x5A), offset, len);
+        }
+    }
+
+    // standard check value
+    check("crc32 check", hal_crc32("123456789", 9, 0), 0xCBF43926, 0, 9);
+
+    // calculated in 1 KB chunks from an odd address, as the firmware CRC is
+    uint32_t crc = 0;
+    size_t pos = 0;
+    size_t size = 100000;
+    while (pos < size) {
+        size_t sz = ((size - pos) >= 1024) ? 1024 : (size - pos);
+        crc = hal_crc32(buf + 5 + pos, sz, crc);
+        pos += sz;
+    }
+    check("crc32 chunks", crc, ref_crc32(buf + 5, size, 0), 5, size);
+}
+
+//---------------------------------------------------------------------------------------------
+static void bench(const char *name, uint32_t (*func)(const void*, size_t, uint32_t), uint8_t *buf)
+{
+    volatile uint32_t crc = 0;
+    double t = time_ms();
+    for (uint32_t i = 0; i < bench_count; i++) {
+        crc = func(buf, bench_size, crc);
+    }
+    t = time_ms() - t;
+    printf("%-16s %10.2f %10.1f\r\n", name, t / bench_count, ((double)bench_size * bench_count) / (t * 1000.0));
+}
+
+// Wrappers with the same signature for the benchmark
+static uint32_t hal_crc32_w(const void* d, size_t l, uint32_t c) { return hal_crc32(d, l, c); }
+static uint32_t ref_crc32_w(const void* d, size_t l, uint32_t c) { return ref_crc32(d, l, c); }
+static uint32_t hal_crc16_w(const void* d, size_t l, uint32_t c) { return hal_crc16(d, l, (uint16_t)c); }
+static uint32_t ref_crc16_w(const void* d, size_t l, uint32_t c) { return ref_crc16(d, l, (uint16_t)c); }
+static uint32_t hal_crc8_w(const void* d, size_t l, uint32_t c) { return hal_crc8(d, l, (uint8_t)c); }
+static uint32_t ref_crc8_w(const void* d, size_t l, uint32_t c) { return ref_crc8(d, l, (uint8_t)c); }
+
+//=============================
+int main(int argc, char **argv) {
+    int c;
+
+    while ( (c = getopt(argc, argv, "s:n:h")) != -1) {
+        switch (c) {
+            case 's':
+                bench_size = strtol(optarg, NULL, 0);
+                break;
+            case 'n':
+                bench_count = strtol(optarg, NULL, 0);
+                break;
+            default:
+                printf("Usage:\r\n  crcbench [-s size] [-n count]\r\n");
+                return 1;
+        }
+    }
+    if ((bench_size < 200000) || (bench_count == 0)) {
+        printf("Wrong parameters\r\n");
+        return 1;
+    }
+
+    uint8_t *buf = malloc(bench_size + 8);
+    if (buf == NULL) {
+        printf("Error allocating buffer\r\n");
+        return 1;
+    }
+    srand(1);
+    for (uint32_t i = 0; i < bench_size + 8; i++) buf[i] = rand();
+
+    test_crc(buf);
+    printf("CRC test: %s (%d errors)\r\n", (errors) ? "FAILED" : "passed", errors);
+
+    printf("-----------------------------------------\r\n");
+    printf("%-16s %10s %10s\r\n", "Function", "ms/call", "MB/s");
+    printf("-----------------------------------------\r\n");
+    bench("hal_crc32", hal_crc32_w, buf);
+    bench("crc32 bytes", ref_crc32_w, buf);
+    bench("hal_crc16", hal_crc16_w, buf);
+    bench("crc16 bytes", ref_crc16_w, buf);
+    bench("hal_crc8", hal_crc8_w, buf);
+    bench("crc8 bytes", ref_crc8_w, buf);
+    printf("-----------------------------------------\r\n");
+
+    free(buf);
+    return (errors) ? 1 : 0;
+}
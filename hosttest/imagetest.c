@@ -0,0 +1,623 @@
+/*
+ * Image processing functions test and benchmark on host
+ *
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The functions from 'image/image_ops.c' (used by the 'image' module) are compared
+ * with reference versions written pixel by pixel on whole frame copies, for random
+ * image sizes and content: the neighborhood operations done in place with the small
+ * row buffer must be bit-exact, the blobs must match a flood fill labeling.
+ * Each operation is benchmarked on a QVGA frame, time per frame and pixels per second
+ * are reported.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+
+#include "image_ops.h"
+
+#define MAX_WIDTH   90
+#define MAX_HEIGHT  70
+#define MAX_LABELS  4096
+#define ROWBUF_FILL 0xA5
+
+static uint32_t test_count = 400;
+static uint32_t bench_count = 100;
+static int errors = 0;
+
+// === Reference functions, working on a copy of the whole image ===
+
+//----------------------------------------------------------------------------
+static uint8_t ref_pixel(const uint8_t *src, int width, int height, int x, int y)
+{
+    // edge pixels are repeated outside the image
+    if (x < 0) x = 0;
+    if (x >= width) x = width - 1;
+    if (y < 0) y = 0;
+    if (y >= height) y = height - 1;
+    return src[(y * width) + x];
+}
+
+//-------------------------------------------------------------------------
+static void ref_sobel(const uint8_t *src, uint8_t *dst, int width, int height)
+{
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int gx = 0, gy = 0;
+            for (int i = -1; i <= 1; i++) {
+                int w = (i == 0) ? 2 : 1;
+                gx += w * (ref_pixel(src, width, height, x + 1, y + i) - ref_pixel(src, width, height, x - 1, y + i));
+                gy += w * (ref_pixel(src, width, height, x + i, y + 1) - ref_pixel(src, width, height, x + i, y - 1));
+            }
+            int mag = abs(gx) + abs(gy);
+            dst[(y * width) + x] = (mag > 255) ? 255 : mag;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------
+static void ref_morph(const uint8_t *src, uint8_t *dst, int width, int height, bool dilate)
+{
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int m = (dilate) ? 0 : 255;
+            for (int j = -1; j <= 1; j++) {
+                for (int i = -1; i <= 1; i++) {
+                    int v = ref_pixel(src, width, height, x + i, y + j);
+                    if ((dilate) ? (v > m) : (v < m)) m = v;
+                }
+            }
+            dst[(y * width) + x] = m;
+        }
+    }
+}
+
+// Separable kernel, rounded after each pass (with the same reciprocal as image_blur())
+//-----------------------------------------------------------------------------------------------------
+static void ref_blur(const uint8_t *src, uint8_t *dst, int width, int height, int size, bool gaussian)
+{
+    static const int box[5] = { 1, 1, 1, 1, 1 };
+    static const int gauss3[3] = { 1, 2, 1 };
+    static const int gauss5[5] = { 1, 4, 6, 4, 1 };
+    int r = (size >= 5) ? 2 : 1;
+    const int *k = (gaussian) ? ((r == 2) ? gauss5 : gauss3) : box;
+    int norm = 0;
+    for (int i = 0; i <= (2 * r); i++) norm += k[i];
+    uint32_t recip = (65536 + (norm / 2)) / norm;
+
+    uint8_t *tmp = malloc(width * height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint32_t sum = 0;
+            for (int i = -r; i <= r; i++) sum += k[i + r] * ref_pixel(src, width, height, x + i, y);
+            tmp[(y * width) + x] = ((sum * recip) + 32768) >> 16;
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint32_t sum = 0;
+            for (int i = -r; i <= r; i++) sum += k[i + r] * ref_pixel(tmp, width, height, x, y + i);
+            dst[(y * width) + x] = ((sum * recip) + 32768) >> 16;
+        }
+    }
+    free(tmp);
+}
+
+// 8-connected labeling by flood fill, 'label' and 'stack' have width * height entries
+//----------------------------------------------------------------------------------------------------------------------
+static int ref_blobs(const uint8_t *src, int width, int height, uint8_t threshold, image_blob_t *blobs, int *label, int *stack)
+{
+    int npix = width * height;
+    int nblobs = 0;
+    memset(label, 0, npix * sizeof(int));
+    for (int p = 0; p < npix; p++) {
+        if ((src[p] <= threshold) || (label[p])) continue;
+        image_blob_t *b = &blobs[nblobs++];
+        b->x1 = b->x2 = p % width;
+        b->y1 = b->y2 = p / width;
+        b->area = b->sum_x = b->sum_y = 0;
+        int sp = 0;
+        stack[sp++] = p;
+        label[p] = 1;
+        while (sp) {
+            int q = stack[--sp];
+            int x = q % width;
+            int y = q / width;
+            b->area++;
+            b->sum_x += x;
+            b->sum_y += y;
+            if (x < b->x1) b->x1 = x;
+            if (x > b->x2) b->x2 = x;
+            if (y < b->y1) b->y1 = y;
+            if (y > b->y2) b->y2 = y;
+            for (int j = -1; j <= 1; j++) {
+                for (int i = -1; i <= 1; i++) {
+                    int xx = x + i;
+                    int yy = y + j;
+                    if ((xx < 0) || (yy < 0) || (xx >= width) || (yy >= height)) continue;
+                    int n = (yy * width) + xx;
+                    if ((src[n] > threshold) && (!label[n])) {
+                        label[n] = 1;
+                        stack[sp++] = n;
+                    }
+                }
+            }
+        }
+    }
+    return nblobs;
+}
+
+// Blobs are found in different order, sort by the top left corner and area
+//-----------------------------------------------------
+static int blob_compare(const void *a, const void *b)
+{
+    const image_blob_t *ba = a;
+    const image_blob_t *bb = b;
+    if (ba->y1 != bb->y1) return (int)ba->y1 - (int)bb->y1;
+    if (ba->x1 != bb->x1) return (int)ba->x1 - (int)bb->x1;
+    return (int)ba->area - (int)bb->area;
+}
+
+// === Tests ===
+
+//------------------------------------------------------------------------------------------------------
+static void check(const char *name, const uint8_t *got, const uint8_t *expected, int len, int width, int height)
+{
+    if (memcmp(got, expected, len) != 0) {
+        int i = 0;
+        while (got[i] == expected[i]) i++;
+        printf("%s %dx%d: differs at %d: %d <> %d\r\n", name, width, height, i, got[i], expected[i]);
+        errors++;
+    }
+}
+
+// Neighborhood operations in place, with the row buffer filled with garbage
+//----------------------------------------------------------------------------------
+static void test_neighborhood(const uint8_t *src, uint8_t *img, uint8_t *ref, uint8_t *rowbuf, int width, int height)
+{
+    int npix = width * height;
+    char name[32];
+
+    memcpy(img, src, npix);
+    memset(rowbuf, ROWBUF_FILL, IMAGE_ROWBUF_SIZE(width));
+    image_sobel(img, width, height, rowbuf);
+    ref_sobel(src, ref, width, height);
+    check("sobel", img, ref, npix, width, height);
+
+    for (int dilate = 0; dilate < 2; dilate++) {
+        memcpy(img, src, npix);
+        memset(rowbuf, ROWBUF_FILL, IMAGE_ROWBUF_SIZE(width));
+        image_morph(img, width, height, dilate, rowbuf);
+        ref_morph(src, ref, width, height, dilate);
+        check((dilate) ? "dilate" : "erode", img, ref, npix, width, height);
+    }
+
+    for (int size = 3; size <= 5; size += 2) {
+        for (int gaussian = 0; gaussian < 2; gaussian++) {
+            memcpy(img, src, npix);
+            memset(rowbuf, ROWBUF_FILL, IMAGE_BLUR_ROWBUF_SIZE(width));
+            image_blur(img, width, height, size, gaussian, rowbuf);
+            ref_blur(src, ref, width, height, size, gaussian);
+            sprintf(name, "blur %s%d", (gaussian) ? "gauss" : "box", size);
+            check(name, img, ref, npix, width, height);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void test_blobs(uint8_t *img, int width, int height, void *work, int max_labels)
+{
+    int npix = width * height;
+    image_blob_t *ref_list = malloc(npix * sizeof(image_blob_t));
+    int *label = malloc(npix * sizeof(int));
+    int *stack = malloc(npix * sizeof(int));
+    image_blob_t *list;
+    bool overflow;
+
+    // random binary pattern, many small blobs joining in different ways
+    int density = 30 + (rand() % 30);
+    for (int i = 0; i < npix; i++) img[i] = ((rand() % 100) < density) ? 100 + (rand() % 156) : rand() % 100;
+    int n = image_blobs(img, width, height, 99, max_labels, work, &list, &overflow);
+    int n_ref = ref_blobs(img, width, height, 99, ref_list, label, stack);
+    qsort(list, n, sizeof(image_blob_t), blob_compare);
+    qsort(ref_list, n_ref, sizeof(image_blob_t), blob_compare);
+    if ((overflow) || (n != n_ref) || (memcmp(list, ref_list, n * sizeof(image_blob_t)) != 0)) {
+        printf("blobs %dx%d: %d blobs, expected %d, overflow %d\r\n", width, height, n, n_ref, overflow);
+        errors++;
+    }
+
+    // with too few labels only the overflow is reported, the found blobs are still consistent
+    if (n_ref > 4) {
+        n = image_blobs(img, width, height, 99, 4, work, &list, &overflow);
+        uint32_t area = 0;
+        for (int i = 0; i < n; i++) area += list[i].area;
+        uint32_t ref_area = 0;
+        for (int i = 0; i < n_ref; i++) ref_area += ref_list[i].area;
+        if ((!overflow) || (n > 3) || (area > ref_area)) {
+            printf("blobs %dx%d: %d blobs with 4 labels, overflow %d\r\n", width, height, n, overflow);
+            errors++;
+        }
+    }
+    free(ref_list);
+    free(label);
+    free(stack);
+}
+
+//---------------------------------------------------------------------------------------------
+static void test_point(const uint8_t *src, uint8_t *img, uint8_t *ref, int width, int height)
+{
+    int npix = width * height;
+
+    // histogram and statistics of a random region
+    int x = rand() % width;
+    int y = rand() % height;
+    int w = 1 + (rand() % (width - x));
+    int h = 1 + (rand() % (height - y));
+    uint32_t hist[256];
+    image_stats_t stats;
+    image_histogram(src, IMAGE_FORMAT_GRAYSCALE, width, x, y, w, h, hist);
+    image_hist_stats(hist, &stats);
+    uint32_t ref_hist[256] = { 0 };
+    double sum = 0, sum2 = 0;
+    for (int row = y; row < (y + h); row++) {
+        for (int col = x; col < (x + w); col++) {
+            uint8_t v = src[(row * width) + col];
+            ref_hist[v]++;
+            sum += v;
+            sum2 += (double)v * v;
+        }
+    }
+    int count = w * h;
+    int vmin = 0, vmax = 255, median = 0;
+    while (ref_hist[vmin] == 0) vmin++;
+    while (ref_hist[vmax] == 0) vmax--;
+    for (int acc = 0; (acc + (int)ref_hist[median]) * 2 < count; median++) acc += ref_hist[median];
+    double mean = sum / count;
+    int stdev = (int)sqrt((sum2 / count) - (mean * mean) + 1e-9);
+    if ((memcmp(hist, ref_hist, sizeof(hist)) != 0) || (stats.count != (uint32_t)count) || (stats.min != vmin) || (stats.max != vmax) ||
+            (stats.median != median) || (stats.mean != (int)(mean + 0.5)) || (stats.stdev != stdev)) {
+        printf("stats %dx%d: min %d/%d, max %d/%d, median %d/%d, mean %d/%.2f, stdev %d/%d\r\n", w, h,
+                stats.min, vmin, stats.max, vmax, stats.median, median, stats.mean, mean, stats.stdev, stdev);
+        errors++;
+    }
+
+    // threshold
+    uint8_t low = rand();
+    uint8_t high = rand();
+    bool invert = rand() & 1;
+    memcpy(img, src, npix);
+    image_threshold(img, npix, low, high, invert);
+    for (int i = 0; i < npix; i++) ref[i] = (((src[i] >= low) && (src[i] <= high)) != invert) ? 255 : 0;
+    check("threshold", img, ref, npix, width, height);
+
+    // frame difference, in place into the first image
+    uint8_t threshold = rand() % 64;
+    uint8_t *other = malloc(npix);
+    uint32_t ref_count = 0;
+    for (int i = 0; i < npix; i++) {
+        other[i] = src[i] + (rand() % 80) - 40;
+        int d = abs((int)src[i] - (int)other[i]);
+        if (d > threshold) ref_count++;
+        ref[i] = (threshold == 0) ? d : ((d > threshold) ? 255 : 0);
+    }
+    memcpy(img, src, npix);
+    uint32_t diff_count = image_diff(img, img, other, npix, threshold);
+    check("diff", img, ref, npix, width, height);
+    if (diff_count != ref_count) {
+        printf("diff %dx%d: count %u, expected %u\r\n", width, height, diff_count, ref_count);
+        errors++;
+    }
+    free(other);
+
+    // crop in place
+    memcpy(img, src, npix);
+    image_crop(img, img, width, 1, x, y, w, h);
+    for (int row = 0; row < h; row++) memcpy(ref + (row * w), src + ((y + row) * width) + x, w);
+    check("crop", img, ref, w * h, width, height);
+}
+
+// RGB565 conversions in place, luma of all colors, RGB565 histogram and crop
+//--------------------------------
+static void test_color(void)
+{
+    int npix = 65536;
+    uint16_t *rgb = malloc(npix * 2);
+    uint16_t *img = malloc(npix * 2);
+    uint8_t *gray = malloc(npix);
+    for (int i = 0; i < npix; i++) rgb[i] = i;
+
+    memcpy(img, rgb, npix * 2);
+    image_to_gray(img, (uint8_t *)img, npix);
+    for (int i = 0; i < npix; i++) {
+        int r = ((i >> 11) * 255 + 15) / 31;
+        int g = (((i >> 5) & 0x3F) * 255 + 31) / 63;
+        int b = ((i & 0x1F) * 255 + 15) / 31;
+        gray[i] = ((77 * r) + (150 * g) + (29 * b) + 128) >> 8;
+    }
+    // the 5/6-bit components are expanded by bit replication, which may differ by 1 from rounding
+    int max_diff = 0;
+    for (int i = 0; i < npix; i++) {
+        int d = abs((int)((uint8_t *)img)[i] - (int)gray[i]);
+        if (d > max_diff) max_diff = d;
+    }
+    if (max_diff > 1) {
+        printf("to_gray: max difference %d\r\n", max_diff);
+        errors++;
+    }
+
+    // gray -> RGB565 in place and back, gray levels are kept within the 5-bit precision
+    for (int i = 0; i < 256; i++) gray[i] = i;
+    memcpy(img, gray, 256);
+    image_to_rgb565((uint8_t *)img, img, 256);
+    for (int i = 0; i < 256; i++) {
+        uint16_t c = img[i];
+        if (((c >> 11) != (i >> 3)) || (((c >> 5) & 0x3F) != (i >> 2)) || ((c & 0x1F) != (i >> 3))) {
+            printf("to_rgb565: %d -> %04X\r\n", i, c);
+            errors++;
+            break;
+        }
+    }
+    image_to_gray(img, (uint8_t *)img, 256);
+    for (int i = 0; i < 256; i++) {
+        if (abs((int)((uint8_t *)img)[i] - i) > 7) {
+            printf("gray round trip: %d -> %d\r\n", i, ((uint8_t *)img)[i]);
+            errors++;
+            break;
+        }
+    }
+
+    // RGB565 histogram of a 256x256 image with all colors, the region is the lower half
+    uint32_t hist[256];
+    uint32_t ref_hist[256] = { 0 };
+    image_histogram((const uint8_t *)rgb, IMAGE_FORMAT_RGB565, 256, 16, 128, 200, 128, hist);
+    for (int y = 128; y < 256; y++) {
+        for (int x = 16; x < 216; x++) ref_hist[image_rgb565_luma(rgb[(y * 256) + x])]++;
+    }
+    if (memcmp(hist, ref_hist, sizeof(hist)) != 0) {
+        printf("histogram RGB565: differs\r\n");
+        errors++;
+    }
+
+    // RGB565 crop in place
+    memcpy(img, rgb, npix * 2);
+    image_crop((uint8_t *)img, (uint8_t *)img, 256, 2, 3, 5, 101, 77);
+    for (int y = 0; y < 77; y++) {
+        if (memcmp(img + (y * 101), rgb + ((y + 5) * 256) + 3, 101 * 2) != 0) {
+            printf("crop RGB565: row %d differs\r\n", y);
+            errors++;
+            break;
+        }
+    }
+    free(rgb);
+    free(img);
+    free(gray);
+}
+
+//-------------------------------
+static void test_random(void)
+{
+    int npix = MAX_WIDTH * MAX_HEIGHT;
+    uint8_t *src = malloc(npix);
+    uint8_t *img = malloc(npix);
+    uint8_t *ref = malloc(npix);
+    uint8_t *rowbuf = malloc(IMAGE_BLUR_ROWBUF_SIZE(MAX_WIDTH));
+    void *work = malloc(IMAGE_BLOBS_WORK_SIZE(MAX_WIDTH, MAX_LABELS));
+
+    for (uint32_t n = 0; n < test_count; n++) {
+        int width = 1 + (rand() % MAX_WIDTH);
+        int height = 1 + (rand() % MAX_HEIGHT);
+        // gradients with random noise, clipped gradients for the saturation
+        for (int i = 0; i < (width * height); i++) {
+            int v = (((i % width) * 3) + ((i / width) * 5)) * (1 + (n % 3));
+            src[i] = ((rand() % 4) == 0) ? rand() : ((v > 255) ? 255 : v);
+        }
+        test_neighborhood(src, img, ref, rowbuf, width, height);
+        test_point(src, img, ref, width, height);
+        test_blobs(img, width, height, work, MAX_LABELS);
+    }
+    free(src);
+    free(img);
+    free(ref);
+    free(rowbuf);
+    free(work);
+}
+
+// === Benchmark ===
+
+enum {
+    OP_TO_GRAY = 0,
+    OP_TO_RGB565,
+    OP_HIST_RGB565,
+    OP_HIST_GRAY,
+    OP_THRESHOLD,
+    OP_DIFF,
+    OP_BLUR_BOX3,
+    OP_BLUR_BOX5,
+    OP_BLUR_GAUSS3,
+    OP_BLUR_GAUSS5,
+    OP_SOBEL,
+    OP_ERODE,
+    OP_DILATE,
+    OP_BLOBS,
+};
+
+//-----------------------
+static double time_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+// The operation is done repeatedly on the same QVGA frame, in place where the image module does it
+//------------------------------------------------------------------
+static void bench(const char *name, int op, int width, int height)
+{
+    int npix = width * height;
+    uint16_t *rgb = malloc(npix * 2);
+    uint8_t *gray = malloc(npix);
+    uint8_t *prev = malloc(npix);
+    uint8_t *dst = malloc(npix);
+    uint8_t *rowbuf = malloc(IMAGE_BLUR_ROWBUF_SIZE(width));
+    void *work = malloc(IMAGE_BLOBS_WORK_SIZE(width, 1024));
+    uint32_t hist[256];
+    image_stats_t stats;
+    image_blob_t *blobs;
+    bool overflow;
+    int nblobs = 0;
+
+    for (int i = 0; i < npix; i++) {
+        rgb[i] = rand();
+        gray[i] = ((i % width) ^ ((i / width) * 3)) + (rand() % 16);
+        prev[i] = gray[i] + (rand() % 32);
+    }
+    if (op == OP_BLOBS) {
+        // separate 8x8 squares
+        for (int i = 0; i < npix; i++) gray[i] = ((((i % width) & 8) == 0) && (((i / width) & 8) == 0)) ? 255 : 0;
+    }
+
+    double t = time_ms();
+    for (uint32_t i = 0; i < bench_count; i++) {
+        switch (op) {
+            case OP_TO_GRAY:
+                image_to_gray(rgb, dst, npix);
+                break;
+            case OP_TO_RGB565:
+                image_to_rgb565(gray, rgb, npix);
+                break;
+            case OP_HIST_RGB565:
+                image_histogram((const uint8_t *)rgb, IMAGE_FORMAT_RGB565, width, 0, 0, width, height, hist);
+                image_hist_stats(hist, &stats);
+                break;
+            case OP_HIST_GRAY:
+                image_histogram(gray, IMAGE_FORMAT_GRAYSCALE, width, 0, 0, width, height, hist);
+                image_hist_stats(hist, &stats);
+                break;
+            case OP_THRESHOLD:
+                memcpy(dst, gray, npix);
+                image_threshold(dst, npix, 64, 192, false);
+                break;
+            case OP_DIFF:
+                image_diff(dst, gray, prev, npix, 20);
+                break;
+            case OP_BLUR_BOX3:
+                image_blur(gray, width, height, 3, false, rowbuf);
+                break;
+            case OP_BLUR_BOX5:
+                image_blur(gray, width, height, 5, false, rowbuf);
+                break;
+            case OP_BLUR_GAUSS3:
+                image_blur(gray, width, height, 3, true, rowbuf);
+                break;
+            case OP_BLUR_GAUSS5:
+                image_blur(gray, width, height, 5, true, rowbuf);
+                break;
+            case OP_SOBEL:
+                image_sobel(gray, width, height, rowbuf);
+                break;
+            case OP_ERODE:
+                image_morph(gray, width, height, false, rowbuf);
+                break;
+            case OP_DILATE:
+                image_morph(gray, width, height, true, rowbuf);
+                break;
+            case OP_BLOBS:
+                nblobs = image_blobs(gray, width, height, 128, 1024, work, &blobs, &overflow);
+                break;
+        }
+    }
+    t = time_ms() - t;
+    printf("%-24s %10.3f %10.1f\r\n", name, t / bench_count, ((double)npix * bench_count) / (t * 1000.0));
+    if ((op == OP_BLOBS) && (nblobs != ((width / 16) * (height / 16)))) {
+        printf("blobs benchmark: %d blobs found\r\n", nblobs);
+        errors++;
+    }
+
+    free(rgb);
+    free(gray);
+    free(prev);
+    free(dst);
+    free(rowbuf);
+    free(work);
+}
+
+//=============================
+int main(int argc, char **argv) {
+    int c;
+
+    while ( (c = getopt(argc, argv, "n:b:h")) != -1) {
+        switch (c) {
+            case 'n':
+                test_count = strtol(optarg, NULL, 0);
+                break;
+            case 'b':
+                bench_count = strtol(optarg, NULL, 0);
+                break;
+            default:
+                printf("Usage:\r\n  imagetest [-n count] [-b count]\r\n");
+                return 1;
+        }
+    }
+    if (bench_count == 0) {
+        printf("Wrong parameters\r\n");
+        return 1;
+    }
+
+    srand(1);
+    test_color();
+    test_random();
+    printf("Image functions test: %s (%d errors)\r\n", (errors) ? "FAILED" : "passed", errors);
+
+    printf("-----------------------------------------------\r\n");
+    printf("%-24s %10s %10s\r\n", "Operation, 320x240", "ms/frame", "Mpix/s");
+    printf("-----------------------------------------------\r\n");
+    bench("to_gray", OP_TO_GRAY, 320, 240);
+    bench("to_rgb565", OP_TO_RGB565, 320, 240);
+    bench("histogram+stats RGB565", OP_HIST_RGB565, 320, 240);
+    bench("histogram+stats gray", OP_HIST_GRAY, 320, 240);
+    bench("threshold", OP_THRESHOLD, 320, 240);
+    bench("diff", OP_DIFF, 320, 240);
+    bench("blur box 3x3", OP_BLUR_BOX3, 320, 240);
+    bench("blur box 5x5", OP_BLUR_BOX5, 320, 240);
+    bench("blur gauss 3x3", OP_BLUR_GAUSS3, 320, 240);
+    bench("blur gauss 5x5", OP_BLUR_GAUSS5, 320, 240);
+    bench("sobel", OP_SOBEL, 320, 240);
+    bench("erode", OP_ERODE, 320, 240);
+    bench("dilate", OP_DILATE, 320, 240);
+    bench("blobs", OP_BLOBS, 320, 240);
+    printf("-----------------------------------------------\r\n");
+
+    return (errors) ? 1 : 0;
+}
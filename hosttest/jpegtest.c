@@ -0,0 +1,570 @@
+/*
+ * JPEG encoder test and benchmark on host
+ *
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The image module JPEG encoder ('image/jpeg_encoder.c') is tested by decoding
+ * its output with TJpgDec ('display/tjpgd.c', used by display.image()):
+ *  - the example JPEG images are decoded, converted to RGB565, encoded with
+ *    several qualities, grayscale and downscale options and decoded back,
+ *    the luminance PSNR against the source must be above the limits
+ *  - random sizes and contents, RGB565 and grayscale input, are encoded both
+ *    with jpeg_encoder_encode() and strip by strip, the outputs must be identical
+ *    and decodable, with the expected size
+ *  - the parameter, row count and write errors are checked
+ * Encoded size, compression ratio, PSNR and the encoder speed are reported.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+
+#include "jpeg_encoder.h"
+#include "tjpgd.h"
+
+#define EXAMPLES_DIR    "../k210-freertos/mpy_support/examples/display/"
+#define DECODER_POOL    8192
+
+static uint32_t test_count = 300;
+static uint32_t bench_count = 20;
+static int errors = 0;
+
+// RGB888 image
+typedef struct _image_t {
+    int width;
+    int height;
+    uint8_t *rgb;
+} image_t;
+
+// Growing output buffer for the encoder
+typedef struct _out_buf_t {
+    uint8_t *data;
+    uint32_t len;
+    uint32_t size;
+    int fail_after;     // number of writes after which the write fails, -1: never
+} out_buf_t;
+
+// === Encoder output ===
+
+//---------------------------------------------------------------
+static int write_buf(void *ctx, const uint8_t *data, uint32_t len)
+{
+    out_buf_t *out = (out_buf_t *)ctx;
+    if (out->fail_after == 0) return -1;
+    if (out->fail_after > 0) out->fail_after--;
+    if ((out->len + len) > out->size) {
+        out->size = (out->len + len) * 2;
+        out->data = realloc(out->data, out->size);
+    }
+    memcpy(out->data + out->len, data, len);
+    out->len += len;
+    return 0;
+}
+
+//--------------------------------------
+static void out_init(out_buf_t *out)
+{
+    out->data = NULL;
+    out->len = 0;
+    out->size = 0;
+    out->fail_after = -1;
+}
+
+// === TJpgDec decoder ===
+
+typedef struct _decoder_t {
+    const uint8_t *jpg;
+    uint32_t len;
+    uint32_t pos;
+    image_t *img;
+} decoder_t;
+
+//---------------------------------------------------------
+static UINT dec_input(JDEC *jd, BYTE *buf, UINT len)
+{
+    decoder_t *dec = (decoder_t *)jd->device;
+    if (len > (dec->len - dec->pos)) len = dec->len - dec->pos;
+    if (buf) memcpy(buf, dec->jpg + dec->pos, len);
+    dec->pos += len;
+    return len;
+}
+
+//---------------------------------------------------------
+static UINT dec_output(JDEC *jd, void *bitmap, JRECT *rect)
+{
+    decoder_t *dec = (decoder_t *)jd->device;
+    const uint8_t *src = (const uint8_t *)bitmap;
+    for (int y = rect->top; y <= rect->bottom; y++) {
+        for (int x = rect->left; x <= rect->right; x++) {
+            if ((x < dec->img->width) && (y < dec->img->height)) {
+                memcpy(dec->img->rgb + (((y * dec->img->width) + x) * 3), src, 3);
+            }
+            src += 3;
+        }
+    }
+    return 1;
+}
+
+// Decode JPEG data to RGB888 image
+//--------------------------------------------------------------------------
+static JRESULT decode(const uint8_t *jpg, uint32_t len, image_t *img)
+{
+    static uint8_t pool[DECODER_POOL] __attribute__((aligned(8)));
+    JDEC jd;
+    decoder_t dec = { jpg, len, 0, img };
+
+    img->rgb = NULL;
+    JRESULT res = jd_prepare(&jd, dec_input, pool, DECODER_POOL, &dec);
+    if (res != JDR_OK) return res;
+    img->width = jd.width;
+    img->height = jd.height;
+    img->rgb = calloc(jd.width * jd.height, 3);
+    return jd_decomp(&jd, dec_output, 0);
+}
+
+//----------------------------------------------------------------------
+static uint8_t *load_file(const char *name, uint32_t *len)
+{
+    FILE *f = fopen(name, "rb");
+    if (f == NULL) return NULL;
+    fseek(f, 0, SEEK_END);
+    *len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(*len);
+    if (fread(data, 1, *len, f) != *len) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+// === Image helpers ===
+
+//----------------------------------------------------------------------------
+static uint16_t *to_rgb565(const image_t *img)
+{
+    uint16_t *buf = malloc(img->width * img->height * 2);
+    for (int i = 0; i < (img->width * img->height); i++) {
+        const uint8_t *p = img->rgb + (i * 3);
+        buf[i] = ((p[0] & 0xF8) << 8) | ((p[1] & 0xFC) << 3) | (p[2] >> 3);
+    }
+    return buf;
+}
+
+// Luminance of the RGB565 pixel, as the encoder calculates it
+//------------------------------------
+static double luma565(uint16_t c)
+{
+    int r = ((c >> 8) & 0xF8) | (c >> 13);
+    int g = ((c >> 3) & 0xFC) | ((c >> 9) & 0x03);
+    int b = ((c << 3) & 0xF8) | ((c >> 2) & 0x07);
+    return (0.299 * r) + (0.587 * g) + (0.114 * b);
+}
+
+//------------------------------------------
+static double luma888(const uint8_t *p)
+{
+    return (0.299 * p[0]) + (0.587 * p[1]) + (0.114 * p[2]);
+}
+
+// Luminance PSNR of the decoded image against the RGB565 or grayscale source,
+// downscaled by 'scale' x 'scale' box average
+//------------------------------------------------------------------------------------------------------------------
+static double luma_psnr(const image_t *dec, const void *src, int width, int format, int scale)
+{
+    double err = 0;
+    for (int y = 0; y < dec->height; y++) {
+        for (int x = 0; x < dec->width; x++) {
+            double ref = 0;
+            for (int j = 0; j < scale; j++) {
+                for (int i = 0; i < scale; i++) {
+                    int idx = (((y * scale) + j) * width) + (x * scale) + i;
+                    if (format == JPEG_FORMAT_GRAYSCALE) ref += ((const uint8_t *)src)[idx];
+                    else ref += luma565(((const uint16_t *)src)[idx]);
+                }
+            }
+            double d = (ref / (scale * scale)) - luma888(dec->rgb + (((y * dec->width) + x) * 3));
+            err += d * d;
+        }
+    }
+    err /= dec->width * dec->height;
+    return (err > 0) ? 10.0 * log10((255.0 * 255.0) / err) : 99.0;
+}
+
+// PSNR of all color components of the decoded image against the RGB565 source,
+// downscaled by 'scale' x 'scale' box average
+//-----------------------------------------------------------------------------------------------
+static double rgb_psnr(const image_t *dec, const uint16_t *src, int width, int scale)
+{
+    double err = 0;
+    for (int y = 0; y < dec->height; y++) {
+        for (int x = 0; x < dec->width; x++) {
+            double ref[3] = { 0, 0, 0 };
+            for (int j = 0; j < scale; j++) {
+                for (int i = 0; i < scale; i++) {
+                    uint16_t c = src[(((y * scale) + j) * width) + (x * scale) + i];
+                    ref[0] += ((c >> 8) & 0xF8) | (c >> 13);
+                    ref[1] += ((c >> 3) & 0xFC) | ((c >> 9) & 0x03);
+                    ref[2] += ((c << 3) & 0xF8) | ((c >> 2) & 0x07);
+                }
+            }
+            const uint8_t *p = dec->rgb + (((y * dec->width) + x) * 3);
+            for (int k = 0; k < 3; k++) {
+                double d = (ref[k] / (scale * scale)) - p[k];
+                err += d * d;
+            }
+        }
+    }
+    err /= dec->width * dec->height * 3;
+    return (err > 0) ? 10.0 * log10((255.0 * 255.0) / err) : 99.0;
+}
+
+// Encode the whole image, returns the encoded size or error
+//-------------------------------------------------------------------------------------------------------------------------
+static int encode(out_buf_t *out, const void *src, int width, int height, int format, bool gray, int quality, int scale)
+{
+    jpeg_encoder_t *enc = malloc(sizeof(jpeg_encoder_t));
+    int bpp = (format == JPEG_FORMAT_GRAYSCALE) ? 1 : 2;
+    int res = jpeg_encoder_init(enc, width, height, format, gray, quality, scale, write_buf, out);
+    if (res == JPEG_OK) res = jpeg_encoder_encode(enc, (const uint8_t *)src, width * bpp);
+    free(enc);
+    return res;
+}
+
+// Encode strip by strip, as image.jpeg() does, the available rows are limited to 'max_rows' if > 0
+//-------------------------------------------------------------------------------------------------------------------------------------------
+static int encode_strips(out_buf_t *out, const void *src, int width, int height, int format, bool gray, int quality, int scale, int max_rows)
+{
+    jpeg_encoder_t *enc = malloc(sizeof(jpeg_encoder_t));
+    int bpp = (format == JPEG_FORMAT_GRAYSCALE) ? 1 : 2;
+    int res = jpeg_encoder_init(enc, width, height, format, gray, quality, scale, write_buf, out);
+    if (res == JPEG_OK) {
+        int strip_rows = jpeg_encoder_strip_rows(enc);
+        for (int y = 0; (y + scale) <= height; y += strip_rows) {
+            // stop at the last full output row
+            if ((y / scale) >= enc->out_height) break;
+            int rows = height - y;
+            if ((max_rows > 0) && (rows > max_rows)) rows = max_rows;
+            res = jpeg_encoder_strip(enc, (const uint8_t *)src + (y * width * bpp), width * bpp, rows);
+            if (res != JPEG_OK) break;
+        }
+        if (res == JPEG_OK) res = jpeg_encoder_finish(enc);
+    }
+    free(enc);
+    return res;
+}
+
+// === Tests ===
+
+// Example images round trip, the PSNR must be above 'min_psnr'
+//-------------------------------------------------------------------------------------------------------------------
+static void round_trip(const char *name, const uint16_t *src, int width, int height, bool gray, int quality, int scale, double min_psnr, double min_cpsnr)
+{
+    out_buf_t out;
+    image_t dec;
+    out_init(&out);
+    int res = encode(&out, src, width, height, JPEG_FORMAT_RGB565, gray, quality, scale);
+    if (res <= 0) {
+        printf("%s q%d: encoder error %d\r\n", name, quality, res);
+        errors++;
+        free(out.data);
+        return;
+    }
+    JRESULT jres = decode(out.data, out.len, &dec);
+    if ((jres != JDR_OK) || (dec.width != (width / scale)) || (dec.height != (height / scale))) {
+        printf("%s q%d: decoder error %d, size %dx%d\r\n", name, quality, jres, dec.width, dec.height);
+        errors++;
+        free(dec.rgb);
+        free(out.data);
+        return;
+    }
+    double psnr = luma_psnr(&dec, src, width, JPEG_FORMAT_RGB565, scale);
+    double cpsnr = (gray) ? 0 : rgb_psnr(&dec, src, width, scale);
+    bool neutral = true;
+    if (gray) {
+        // constant chroma, decoded as gray
+        for (int i = 0; i < (dec.width * dec.height); i++) {
+            const uint8_t *p = dec.rgb + (i * 3);
+            if ((abs(p[0] - p[1]) > 1) || (abs(p[1] - p[2]) > 1)) neutral = false;
+        }
+    }
+    printf("%-10s %3d %5s %5d %8d %8.1f %8.1f %8.1f\r\n", name, quality, (gray) ? "gray" : "color", scale, res,
+            (double)(width * height * 2) / res, psnr, cpsnr);
+    if ((psnr < min_psnr) || (cpsnr < min_cpsnr) || (!neutral) || (res != (int)out.len)) {
+        printf("%s q%d: PSNR %.1f/%.1f dB (min %.1f/%.1f), gray %d, size %d/%u\r\n", name, quality, psnr, cpsnr, min_psnr, min_cpsnr, neutral, res, out.len);
+        errors++;
+    }
+    free(dec.rgb);
+    free(out.data);
+}
+
+//-----------------------------
+static void test_examples(void)
+{
+    printf("---------------------------------------------------------------------\r\n");
+    printf("%-10s %3s %5s %5s %8s %8s %8s %8s\r\n", "Image", "q", "mode", "scale", "bytes", "ratio", "Y PSNR", "RGB PSNR");
+    printf("---------------------------------------------------------------------\r\n");
+    for (int n = 1; n <= 4; n++) {
+        char name[128];
+        uint32_t len;
+        image_t img;
+        snprintf(name, sizeof(name), EXAMPLES_DIR "test%d.jpg", n);
+        uint8_t *jpg = load_file(name, &len);
+        if ((jpg == NULL) || (decode(jpg, len, &img) != JDR_OK)) {
+            printf("%s: not loaded\r\n", name);
+            errors++;
+            free(jpg);
+            continue;
+        }
+        uint16_t *src = to_rgb565(&img);
+        snprintf(name, sizeof(name), "test%d.jpg", n);
+        // the chroma is subsampled (4:2:0), the color PSNR limits are lower
+        round_trip(name, src, img.width, img.height, false, 50, 1, 27.5, 24.0);
+        round_trip(name, src, img.width, img.height, false, 75, 1, 31.5, 26.5);
+        round_trip(name, src, img.width, img.height, false, 95, 1, 45.0, 30.5);
+        round_trip(name, src, img.width, img.height, true, 50, 1, 27.5, 0);
+        round_trip(name, src, img.width, img.height, false, 75, 2, 29.5, 23.5);
+        round_trip(name, src, img.width, img.height, false, 75, 4, 28.5, 21.0);
+        free(src);
+        free(img.rgb);
+        free(jpg);
+    }
+    printf("---------------------------------------------------------------------\r\n");
+}
+
+// Random sizes, formats, scales and contents, whole image and strip encoding must give the same data
+//---------------------------
+static void test_random(void)
+{
+    for (uint32_t n = 0; n < test_count; n++) {
+        int width = 1 + (rand() % 200);
+        int height = 1 + (rand() % 200);
+        int format = (rand() % 3 == 0) ? JPEG_FORMAT_GRAYSCALE : JPEG_FORMAT_RGB565;
+        bool gray = (rand() % 4) == 0;
+        int quality = 1 + (rand() % 100);
+        int scale = 1 << (rand() % 4);
+        while ((scale > width) || (scale > height)) scale >>= 1;
+
+        // smooth gradient with some noise
+        uint8_t *src = malloc(width * height * 2);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int r = ((x * 255) / width + (rand() % 8)) & 0xFF;
+                int g = ((y * 255) / height + (rand() % 8)) & 0xFF;
+                int b = (((x + y) * 127) / (width + height) + (rand() % 8)) & 0xFF;
+                if (format == JPEG_FORMAT_GRAYSCALE) src[(y * width) + x] = (r + g) / 2;
+                else ((uint16_t *)src)[(y * width) + x] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+            }
+        }
+
+        char case_str[96];
+        snprintf(case_str, sizeof(case_str), "%dx%d, format=%d, gray=%d, q=%d, scale=%d", width, height, format, gray, quality, scale);
+        out_buf_t out1, out2;
+        out_init(&out1);
+        out_init(&out2);
+        int res1 = encode(&out1, src, width, height, format, gray, quality, scale);
+        // exact strip rows (the strip functions get only the rows they need)
+        int res2 = encode_strips(&out2, src, width, height, format, gray, quality, scale, 16 * scale);
+        if ((res1 <= 0) || (res1 != res2) || (out1.len != out2.len) || (memcmp(out1.data, out2.data, out1.len) != 0)) {
+            printf("%s: encode %d, strips %d\r\n", case_str, res1, res2);
+            errors++;
+        }
+        else {
+            image_t dec;
+            JRESULT jres = decode(out1.data, out1.len, &dec);
+            if ((jres != JDR_OK) || (dec.width != (width / scale)) || (dec.height != (height / scale))) {
+                printf("%s: decoder error %d, size %dx%d\r\n", case_str, jres, dec.width, dec.height);
+                errors++;
+            }
+            else if (quality >= 50) {
+                double psnr = luma_psnr(&dec, src, width, format, scale);
+                if (psnr < 25.0) {
+                    printf("%s: PSNR %.1f dB\r\n", case_str, psnr);
+                    errors++;
+                }
+            }
+            free(dec.rgb);
+        }
+        free(out1.data);
+        free(out2.data);
+        free(src);
+    }
+}
+
+//---------------------------
+static void test_errors(void)
+{
+    static uint16_t src[64 * 64];
+    jpeg_encoder_t *enc = malloc(sizeof(jpeg_encoder_t));
+    out_buf_t out;
+    int res;
+
+    out_init(&out);
+    if ((jpeg_encoder_init(enc, 64, 64, JPEG_FORMAT_RGB565, false, 50, 3, write_buf, &out) != JPEG_ERR_PARAM) ||
+        (jpeg_encoder_init(enc, 4, 64, JPEG_FORMAT_RGB565, false, 50, 8, write_buf, &out) != JPEG_ERR_PARAM) ||
+        (jpeg_encoder_init(enc, 64, 64, 2, false, 50, 1, write_buf, &out) != JPEG_ERR_PARAM) ||
+        (jpeg_encoder_init(enc, 0, 64, JPEG_FORMAT_RGB565, false, 50, 1, write_buf, &out) != JPEG_ERR_PARAM) ||
+        (jpeg_encoder_init(enc, 64, 64, JPEG_FORMAT_RGB565, false, 50, 1, NULL, &out) != JPEG_ERR_PARAM)) {
+        printf("errors: wrong parameters accepted\r\n");
+        errors++;
+    }
+
+    // not enough rows, finish before the last strip, strip after the last one
+    jpeg_encoder_init(enc, 64, 40, JPEG_FORMAT_RGB565, false, 50, 1, write_buf, &out);
+    res = jpeg_encoder_strip(enc, (uint8_t *)src, 128, 15);
+    if (res != JPEG_ERR_ROWS) {
+        printf("errors: strip with missing rows: %d\r\n", res);
+        errors++;
+    }
+    res = jpeg_encoder_strip(enc, (uint8_t *)src, 128, 16);
+    if (res != JPEG_OK) {
+        printf("errors: first strip: %d\r\n", res);
+        errors++;
+    }
+    res = jpeg_encoder_finish(enc);
+    if (res != JPEG_ERR_ROWS) {
+        printf("errors: finish before the last strip: %d\r\n", res);
+        errors++;
+    }
+    jpeg_encoder_strip(enc, (uint8_t *)src, 128, 16);
+    // the last strip has 8 rows
+    res = jpeg_encoder_strip(enc, (uint8_t *)src, 128, 8);
+    if (res != JPEG_OK) {
+        printf("errors: last strip: %d\r\n", res);
+        errors++;
+    }
+    res = jpeg_encoder_strip(enc, (uint8_t *)src, 128, 16);
+    if (res != JPEG_ERR_ROWS) {
+        printf("errors: strip after the last one: %d\r\n", res);
+        errors++;
+    }
+    // downscaled image needs 'scale' source rows for each output row
+    jpeg_encoder_init(enc, 64, 64, JPEG_FORMAT_RGB565, false, 50, 2, write_buf, &out);
+    res = jpeg_encoder_strip(enc, (uint8_t *)src, 128, 31);
+    if (res != JPEG_ERR_ROWS) {
+        printf("errors: scaled strip with missing rows: %d\r\n", res);
+        errors++;
+    }
+    free(out.data);
+
+    // write errors are reported by the strip and finish functions
+    for (int fail = 0; fail < 4; fail++) {
+        out_init(&out);
+        out.fail_after = fail;
+        res = jpeg_encoder_init(enc, 64, 64, JPEG_FORMAT_RGB565, false, 50, 1, write_buf, &out);
+        if (res == JPEG_OK) res = jpeg_encoder_encode(enc, (uint8_t *)src, 128);
+        if (res != JPEG_ERR_WRITE) {
+            printf("errors: write failing after %d calls: %d\r\n", fail, res);
+            errors++;
+        }
+        free(out.data);
+    }
+    free(enc);
+}
+
+// === Benchmark ===
+
+//-----------------------
+static double time_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+//-----------------------------------------------------------------------------------------------------------
+static void bench(const char *name, const uint16_t *src, int width, int height, bool gray, int quality, int scale)
+{
+    out_buf_t out;
+    int res = 0;
+    double t = time_ms();
+    for (uint32_t i = 0; i < bench_count; i++) {
+        out_init(&out);
+        res = encode(&out, src, width, height, JPEG_FORMAT_RGB565, gray, quality, scale);
+        free(out.data);
+    }
+    t = time_ms() - t;
+    printf("%-20s %8d %10.3f %10.1f %10.2f\r\n", name, res, t / bench_count,
+            (bench_count * 1000.0) / t, ((double)width * height * bench_count) / (t * 1000.0));
+}
+
+//=============================
+int main(int argc, char **argv) {
+    int c;
+
+    while ( (c = getopt(argc, argv, "n:b:h")) != -1) {
+        switch (c) {
+            case 'n':
+                test_count = strtol(optarg, NULL, 0);
+                break;
+            case 'b':
+                bench_count = strtol(optarg, NULL, 0);
+                break;
+            default:
+                printf("Usage:\r\n  jpegtest [-n count] [-b count]\r\n");
+                return 1;
+        }
+    }
+    if (bench_count == 0) {
+        printf("Wrong parameters\r\n");
+        return 1;
+    }
+
+    srand(1);
+    test_examples();
+    test_random();
+    test_errors();
+    printf("JPEG encoder test: %s (%d errors)\r\n", (errors) ? "FAILED" : "passed", errors);
+
+    uint32_t len;
+    image_t img;
+    uint8_t *jpg = load_file(EXAMPLES_DIR "test1.jpg", &len);
+    if ((jpg) && (decode(jpg, len, &img) == JDR_OK)) {
+        uint16_t *src = to_rgb565(&img);
+        printf("------------------------------------------------------------\r\n");
+        printf("%-20s %8s %10s %10s %10s\r\n", "test1.jpg 320x240", "bytes", "ms/frame", "frames/s", "Mpix/s");
+        printf("------------------------------------------------------------\r\n");
+        bench("quality 50", src, img.width, img.height, false, 50, 1);
+        bench("quality 75", src, img.width, img.height, false, 75, 1);
+        bench("quality 50 gray", src, img.width, img.height, true, 50, 1);
+        bench("quality 75 scale 2", src, img.width, img.height, false, 75, 2);
+        printf("------------------------------------------------------------\r\n");
+        free(src);
+        free(img.rgb);
+    }
+    free(jpg);
+
+    return (errors) ? 1 : 0;
+}
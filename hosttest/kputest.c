@@ -0,0 +1,926 @@
+/*
+ * KPU CPU layers test on host
+ *
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The CPU layers of the KPU driver ('kpu_layers.c' from the SDK) are run on
+ * random layer arguments and data in a main buffer and compared with reference
+ * versions written element by element (float references in double precision).
+ * Integer layers and the layers only moving data must be bit-exact, float layers
+ * must be within a small relative error. The main buffer outside the layer
+ * output must not be changed.
+ * The CPU layers are benchmarked with the layer arguments of a kmodel file, as
+ * recorded in the model, or with the built-in layer arguments of a typical
+ * classifier if no model is given.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+
+#include "kpu_layers.h"
+
+#define MAIN_FILL       0x5A
+#define FLOAT_TOLERANCE 1e-6
+#define INPUT_RANGE     8.0
+
+static uint32_t test_count = 200;
+static uint32_t bench_count = 20;
+static const char *model_file = NULL;
+static int errors = 0;
+
+// === Helpers ===
+
+//-----------------------
+static float frand(void)
+{
+    return ((rand() / (float)RAND_MAX) * 2.0f * INPUT_RANGE) - INPUT_RANGE;
+}
+
+//------------------------------------
+static int rand_range(int low, int high)
+{
+    return low + (rand() % (high - low + 1));
+}
+
+// The main buffer is filled with a pattern, the layer input is placed at the start, the output after it
+//-----------------------------------------------------------
+static uint8_t *main_alloc(size_t in_size, size_t out_size)
+{
+    uint8_t *main_buffer = malloc(in_size + out_size + 64);
+    memset(main_buffer, MAIN_FILL, in_size + out_size + 64);
+    return main_buffer;
+}
+
+// Check the bytes after the output are unchanged
+//--------------------------------------------------------------------------------------------
+static void check_tail(const char *name, const uint8_t *main_buffer, size_t out_end, size_t size)
+{
+    for (size_t i = out_end; i < size; i++) {
+        if (main_buffer[i] != MAIN_FILL) {
+            printf("%s: main buffer changed at %u\r\n", name, (unsigned)i);
+            errors++;
+            return;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------------------
+static void check_bytes(const char *name, const uint8_t *got, const uint8_t *expected, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (got[i] != expected[i]) {
+            printf("%s: [%u] %d <> %d\r\n", name, (unsigned)i, got[i], expected[i]);
+            errors++;
+            return;
+        }
+    }
+}
+
+// Float results, the error limit is relative to the result plus 'range' (the input values range for sums)
+// A negative 'range' is used for the layers which must give the same result as the reference
+//------------------------------------------------------------------------------------------------------------
+static void check_floats(const char *name, const float *got, const double *expected, size_t count, double range)
+{
+    for (size_t i = 0; i < count; i++) {
+        double diff = fabs((double)got[i] - expected[i]);
+        double limit = (range < 0) ? 0.0 : FLOAT_TOLERANCE * (fabs(expected[i]) + range);
+        if ((diff > limit) || (isnan(got[i]))) {
+            printf("%s: [%u] %.9g <> %.9g\r\n", name, (unsigned)i, got[i], expected[i]);
+            errors++;
+            return;
+        }
+    }
+}
+
+//------------------------------------------------------------
+static double activation(double value, kpu_model_activation_t act)
+{
+    if ((act == KLA_RELU) || (act == KLA_RELU6)) {
+        if (value < 0.0) value = 0.0;
+        if ((act == KLA_RELU6) && (value > 6.0)) value = 6.0;
+    }
+    return value;
+}
+
+// === Element-wise layers ===
+
+//---------------------------
+static void test_add(void)
+{
+    kpu_model_add_layer_argument_t arg = { 0 };
+    uint32_t count = rand_range(1, 3000);
+    size_t size = count * sizeof(float);
+    uint8_t *main_buffer = main_alloc(size * 2, size);
+    float *a = (float *)main_buffer;
+    float *b = a + count;
+    double *expected = malloc(count * sizeof(double));
+
+    arg.main_mem_in_a_address = 0;
+    arg.main_mem_in_b_address = size;
+    arg.main_mem_out_address = size * 2;
+    arg.count = count;
+    for (uint32_t i = 0; i < count; i++) {
+        a[i] = frand();
+        b[i] = frand();
+        expected[i] = a[i] + b[i];
+    }
+    kpu_layer_add(main_buffer, &arg);
+    check_floats("add", (float *)(main_buffer + (size * 2)), expected, count, -1);
+    check_tail("add", main_buffer, size * 3, (size * 3) + 64);
+    free(main_buffer);
+    free(expected);
+}
+
+// The quantized add processes 8 elements at once, the count is rounded up
+//-------------------------------------
+static void test_quantized_add(void)
+{
+    kpu_model_quant_add_layer_argument_t arg = { 0 };
+    uint32_t count = rand_range(1, 3000);
+    uint32_t aligned = (count + 7) & ~7;
+    uint8_t *main_buffer = main_alloc(aligned * 2, aligned);
+    uint8_t *a = main_buffer;
+    uint8_t *b = a + aligned;
+    uint8_t *expected = malloc(aligned);
+
+    arg.main_mem_in_a_address = 0;
+    arg.main_mem_in_b_address = aligned;
+    arg.main_mem_out_address = aligned * 2;
+    arg.count = count;
+    arg.in_a_offset = rand_range(-128, 0);
+    arg.in_a_mul = rand_range(1, 30000);
+    arg.in_a_shift = rand_range(8, 16);
+    arg.in_b_offset = rand_range(-128, 0);
+    arg.in_b_mul = rand_range(1, 30000);
+    arg.in_b_shift = (rand() & 1) ? arg.in_a_shift : rand_range(8, 16);
+    arg.out_offset = rand_range(0, 128);
+    arg.out_mul = rand_range(1, 30000);
+    arg.out_shift = rand_range(12, 16);
+    for (uint32_t i = 0; i < aligned; i++) {
+        a[i] = rand();
+        b[i] = rand();
+        int64_t va = ((int64_t)a[i] + arg.in_a_offset) * arg.in_a_mul;
+        int64_t vb = ((int64_t)b[i] + arg.in_b_offset) * arg.in_b_mul;
+        int64_t v;
+        if (arg.in_a_shift == arg.in_b_shift) v = (va + vb) >> arg.in_a_shift;
+        else v = (va >> arg.in_a_shift) + (vb >> arg.in_b_shift);
+        v = ((v * arg.out_mul) >> arg.out_shift) + arg.out_offset;
+        expected[i] = (v < 0) ? 0 : ((v > 255) ? 255 : v);
+    }
+    kpu_layer_quantized_add(main_buffer, &arg);
+    check_bytes("quantized add", main_buffer + (aligned * 2), expected, aligned);
+    check_tail("quantized add", main_buffer, aligned * 3, (aligned * 3) + 64);
+    free(main_buffer);
+    free(expected);
+}
+
+//---------------------------------------
+static void test_quantize(void)
+{
+    uint32_t count = rand_range(1, 3000);
+    size_t in_size = count * sizeof(float);
+    uint8_t *main_buffer = main_alloc(in_size, count * sizeof(float));
+    float *src = (float *)main_buffer;
+    kpu_model_quant_param_t q = { (float)(rand_range(1, 100) / 256.0), frand() };
+    uint8_t *expected = malloc(count);
+    double *expected_f = malloc(count * sizeof(double));
+
+    // quantize
+    kpu_model_quantize_layer_argument_t qarg = { 0 };
+    qarg.main_mem_in_address = 0;
+    qarg.mem_out_address = in_size;
+    qarg.count = count;
+    qarg.quant_param = q;
+    for (uint32_t i = 0; i < count; i++) {
+        src[i] = q.bias + ((frand() + 8.0f) * q.scale * 18.0f) - (q.scale * 10.0f);
+        // truncated, the driver multiplies by 1 / scale
+        int v = (src[i] - q.bias) * (1.0f / q.scale);
+        expected[i] = (v < 0) ? 0 : ((v > 255) ? 255 : v);
+    }
+    kpu_layer_quantize(main_buffer, &qarg);
+    check_bytes("quantize", main_buffer + in_size, expected, count);
+    check_tail("quantize", main_buffer, in_size + count, in_size + (count * sizeof(float)) + 64);
+
+    // dequantize the quantized data
+    memset(main_buffer + in_size + count, MAIN_FILL, (count * 3) + 64);
+    memmove(main_buffer, main_buffer + in_size, count);
+    kpu_model_dequantize_layer_argument_t darg = { 0 };
+    darg.main_mem_in_address = 0;
+    darg.main_mem_out_address = in_size;
+    darg.count = count;
+    darg.quant_param = q;
+    for (uint32_t i = 0; i < count; i++) expected_f[i] = (float)((main_buffer[i] * q.scale) + q.bias);
+    kpu_layer_dequantize(main_buffer, &darg);
+    check_floats("dequantize", (float *)(main_buffer + in_size), expected_f, count, -1);
+    check_tail("dequantize", main_buffer, in_size * 2, (in_size * 2) + 64);
+
+    free(main_buffer);
+    free(expected);
+    free(expected_f);
+}
+
+// The requantize layer processes 8 elements at once, the count is rounded up
+//------------------------------------
+static void test_requantize(void)
+{
+    kpu_model_requantize_layer_argument_t arg = { 0 };
+    uint32_t count = rand_range(1, 3000);
+    uint32_t aligned = (count + 7) & ~7;
+    uint8_t *main_buffer = main_alloc(aligned, aligned);
+    uint8_t *expected = malloc(aligned);
+
+    arg.main_mem_in_address = 0;
+    arg.main_mem_out_address = aligned;
+    arg.count = count;
+    for (int i = 0; i < 256; i++) arg.table[i] = rand();
+    for (uint32_t i = 0; i < aligned; i++) {
+        main_buffer[i] = rand();
+        expected[i] = arg.table[main_buffer[i]];
+    }
+    kpu_layer_requantize(main_buffer, &arg);
+    check_bytes("requantize", main_buffer + aligned, expected, aligned);
+    check_tail("requantize", main_buffer, aligned * 2, (aligned * 2) + 64);
+    free(main_buffer);
+    free(expected);
+}
+
+// === Pooling layers ===
+
+// Output size of the pooling, as the model compiler calculates it
+//----------------------------------------------------------------------------------
+static uint32_t pool_out_size(uint32_t in_size, uint32_t kernel, uint32_t stride, uint32_t padding)
+{
+    return ((in_size + (2 * padding) - kernel) / stride) + 1;
+}
+
+//---------------------------------------
+static void test_max_pool(void)
+{
+    kpu_model_quant_max_pool2d_layer_argument_t arg = { 0 };
+    arg.kernel_width = rand_range(1, 4);
+    arg.kernel_height = (rand() & 1) ? arg.kernel_width : rand_range(1, 4);
+    arg.stride_width = rand_range(1, 3);
+    arg.stride_height = (rand() & 1) ? arg.stride_width : rand_range(1, 3);
+    arg.padding_width = rand_range(0, arg.kernel_width - 1);
+    arg.padding_height = rand_range(0, arg.kernel_height - 1);
+    arg.in_shape.width = rand_range(arg.kernel_width, 40);
+    arg.in_shape.height = rand_range(arg.kernel_height, 40);
+    arg.in_shape.channels = rand_range(1, 8);
+    arg.out_shape.width = pool_out_size(arg.in_shape.width, arg.kernel_width, arg.stride_width, arg.padding_width);
+    arg.out_shape.height = pool_out_size(arg.in_shape.height, arg.kernel_height, arg.stride_height, arg.padding_height);
+    arg.out_shape.channels = arg.in_shape.channels;
+
+    size_t in_size = arg.in_shape.width * arg.in_shape.height * arg.in_shape.channels;
+    size_t out_size = arg.out_shape.width * arg.out_shape.height * arg.out_shape.channels;
+    uint8_t *main_buffer = main_alloc(in_size, out_size);
+    uint8_t *expected = malloc(out_size);
+    arg.main_mem_in_address = 0;
+    arg.main_mem_out_address = in_size;
+    for (size_t i = 0; i < in_size; i++) main_buffer[i] = rand();
+
+    uint8_t *dst = expected;
+    for (uint32_t c = 0; c < arg.in_shape.channels; c++) {
+        const uint8_t *channel = main_buffer + (c * arg.in_shape.width * arg.in_shape.height);
+        for (uint32_t oy = 0; oy < arg.out_shape.height; oy++) {
+            for (uint32_t ox = 0; ox < arg.out_shape.width; ox++) {
+                // the padding is not counted
+                int value = 0;
+                for (uint32_t ky = 0; ky < arg.kernel_height; ky++) {
+                    for (uint32_t kx = 0; kx < arg.kernel_width; kx++) {
+                        int x = (int)((ox * arg.stride_width) + kx) - (int)arg.padding_width;
+                        int y = (int)((oy * arg.stride_height) + ky) - (int)arg.padding_height;
+                        if ((x < 0) || (y < 0) || (x >= (int)arg.in_shape.width) || (y >= (int)arg.in_shape.height)) continue;
+                        if (channel[(y * arg.in_shape.width) + x] > value) value = channel[(y * arg.in_shape.width) + x];
+                    }
+                }
+                *dst++ = value;
+            }
+        }
+    }
+    int prev_errors = errors;
+    kpu_layer_quantized_max_pool2d(main_buffer, &arg);
+    check_bytes("max pool", main_buffer + in_size, expected, out_size);
+    check_tail("max pool", main_buffer, in_size + out_size, in_size + out_size + 64);
+    if (errors != prev_errors) {
+        printf("  %ux%ux%u, kernel %ux%u, stride %ux%u, padding %ux%u\r\n", arg.in_shape.width, arg.in_shape.height, arg.in_shape.channels,
+                arg.kernel_width, arg.kernel_height, arg.stride_width, arg.stride_height, arg.padding_width, arg.padding_height);
+    }
+    free(main_buffer);
+    free(expected);
+}
+
+//---------------------------------------
+static void test_average_pool(void)
+{
+    kpu_model_ave_pool2d_layer_argument_t arg = { 0 };
+    arg.kernel_width = rand_range(1, 4);
+    arg.kernel_height = (rand() & 1) ? arg.kernel_width : rand_range(1, 4);
+    arg.stride_width = rand_range(1, 3);
+    arg.stride_height = (rand() & 1) ? arg.stride_width : rand_range(1, 3);
+    arg.padding_width = rand_range(0, arg.kernel_width - 1);
+    arg.padding_height = rand_range(0, arg.kernel_height - 1);
+    arg.in_shape.width = rand_range(arg.kernel_width, 40);
+    arg.in_shape.height = rand_range(arg.kernel_height, 40);
+    arg.in_shape.channels = rand_range(1, 8);
+    arg.out_shape.width = pool_out_size(arg.in_shape.width, arg.kernel_width, arg.stride_width, arg.padding_width);
+    arg.out_shape.height = pool_out_size(arg.in_shape.height, arg.kernel_height, arg.stride_height, arg.padding_height);
+    arg.out_shape.channels = arg.in_shape.channels;
+    arg.act = rand() % 3;
+
+    size_t in_count = arg.in_shape.width * arg.in_shape.height * arg.in_shape.channels;
+    size_t out_count = arg.out_shape.width * arg.out_shape.height * arg.out_shape.channels;
+    size_t in_size = in_count * sizeof(float);
+    size_t out_size = out_count * sizeof(float);
+    uint8_t *main_buffer = main_alloc(in_size, out_size);
+    float *src = (float *)main_buffer;
+    double *expected = malloc(out_count * sizeof(double));
+    arg.main_mem_in_address = 0;
+    arg.main_mem_out_address = in_size;
+    for (size_t i = 0; i < in_count; i++) src[i] = frand();
+
+    double *dst = expected;
+    for (uint32_t c = 0; c < arg.in_shape.channels; c++) {
+        const float *channel = src + (c * arg.in_shape.width * arg.in_shape.height);
+        for (uint32_t oy = 0; oy < arg.out_shape.height; oy++) {
+            for (uint32_t ox = 0; ox < arg.out_shape.width; ox++) {
+                // average of the window part inside the input
+                double sum = 0;
+                int count = 0;
+                for (uint32_t ky = 0; ky < arg.kernel_height; ky++) {
+                    for (uint32_t kx = 0; kx < arg.kernel_width; kx++) {
+                        int x = (int)((ox * arg.stride_width) + kx) - (int)arg.padding_width;
+                        int y = (int)((oy * arg.stride_height) + ky) - (int)arg.padding_height;
+                        if ((x < 0) || (y < 0) || (x >= (int)arg.in_shape.width) || (y >= (int)arg.in_shape.height)) continue;
+                        sum += channel[(y * arg.in_shape.width) + x];
+                        count++;
+                    }
+                }
+                *dst++ = activation(sum / count, arg.act);
+            }
+        }
+    }
+    kpu_layer_average_pool2d(main_buffer, &arg);
+    check_floats("average pool", (float *)(main_buffer + in_size), expected, out_count, INPUT_RANGE);
+    check_tail("average pool", main_buffer, in_size + out_size, in_size + out_size + 64);
+    free(main_buffer);
+    free(expected);
+}
+
+//--------------------------------------------------
+static void test_global_average_pool(void)
+{
+    kpu_model_gap2d_layer_argument_t arg = { 0 };
+    arg.kernel_size = rand_range(1, 200);
+    arg.channels = rand_range(1, 64);
+    size_t in_size = arg.kernel_size * arg.channels * sizeof(float);
+    size_t out_size = arg.channels * sizeof(float);
+    uint8_t *main_buffer = main_alloc(in_size, out_size);
+    float *src = (float *)main_buffer;
+    double *expected = malloc(arg.channels * sizeof(double));
+    arg.main_mem_in_address = 0;
+    arg.main_mem_out_address = in_size;
+
+    for (uint32_t c = 0; c < arg.channels; c++) {
+        double sum = 0;
+        for (uint32_t i = 0; i < arg.kernel_size; i++) {
+            src[(c * arg.kernel_size) + i] = frand();
+            sum += src[(c * arg.kernel_size) + i];
+        }
+        expected[c] = sum / arg.kernel_size;
+    }
+    kpu_layer_global_average_pool2d(main_buffer, &arg);
+    check_floats("global average pool", (float *)(main_buffer + in_size), expected, arg.channels, INPUT_RANGE);
+    check_tail("global average pool", main_buffer, in_size + out_size, in_size + out_size + 64);
+    free(main_buffer);
+    free(expected);
+}
+
+// === Vector layers ===
+
+//----------------------------------------------
+static void test_fully_connected(void)
+{
+    uint32_t in_channels = rand_range(1, 300);
+    uint32_t out_channels = rand_range(1, 70);
+    size_t arg_size = sizeof(kpu_model_fully_connected_layer_argument_t) + (((in_channels * out_channels) + out_channels) * sizeof(float));
+    kpu_model_fully_connected_layer_argument_t *arg = calloc(1, arg_size);
+    size_t in_size = in_channels * sizeof(float);
+    size_t out_size = out_channels * sizeof(float);
+    uint8_t *main_buffer = main_alloc(in_size, out_size);
+    float *src = (float *)main_buffer;
+    double *expected = malloc(out_channels * sizeof(double));
+
+    arg->main_mem_in_address = 0;
+    arg->main_mem_out_address = in_size;
+    arg->in_channels = in_channels;
+    arg->out_channels = out_channels;
+    arg->act = rand() % 3;
+    for (uint32_t i = 0; i < ((in_channels * out_channels) + out_channels); i++) arg->weights[i] = frand() / 8.0f;
+    for (uint32_t i = 0; i < in_channels; i++) src[i] = frand();
+    const float *bias = arg->weights + (in_channels * out_channels);
+    for (uint32_t oc = 0; oc < out_channels; oc++) {
+        // float sum in input order, as the driver accumulates it
+        float sum = 0.0f;
+        for (uint32_t ic = 0; ic < in_channels; ic++) sum += src[ic] * arg->weights[(oc * in_channels) + ic];
+        expected[oc] = activation(sum + bias[oc], arg->act);
+    }
+    kpu_layer_fully_connected(main_buffer, arg, arg->weights);
+    check_floats("fully connected", (float *)(main_buffer + in_size), expected, out_channels, -1);
+    check_tail("fully connected", main_buffer, in_size + out_size, in_size + out_size + 64);
+    free(main_buffer);
+    free(expected);
+    free(arg);
+}
+
+//-------------------------------
+static void test_softmax(void)
+{
+    kpu_model_softmax_layer_argument_t arg = { 0 };
+    arg.channels = rand_range(1, 1000);
+    size_t size = arg.channels * sizeof(float);
+    uint8_t *main_buffer = main_alloc(size, size);
+    float *src = (float *)main_buffer;
+    double *expected = malloc(arg.channels * sizeof(double));
+    arg.main_mem_in_address = 0;
+    arg.main_mem_out_address = size;
+
+    // wide range logits, all negative in some tests
+    float range = (rand() & 1) ? 4.0f : 20.0f;
+    float offset = (rand() & 1) ? 0.0f : -200.0f;
+    double max = -1e30, sum = 0;
+    for (uint32_t i = 0; i < arg.channels; i++) {
+        src[i] = (frand() * range) + offset;
+        if (src[i] > max) max = src[i];
+    }
+    for (uint32_t i = 0; i < arg.channels; i++) {
+        expected[i] = exp(src[i] - max);
+        sum += expected[i];
+    }
+    for (uint32_t i = 0; i < arg.channels; i++) expected[i] /= sum;
+    kpu_layer_softmax(main_buffer, &arg);
+    // the outputs are probabilities, very small values only need to be close in absolute terms
+    check_floats("softmax", (float *)(main_buffer + size), expected, arg.channels, 1e-6);
+    check_tail("softmax", main_buffer, size * 2, (size * 2) + 64);
+    free(main_buffer);
+    free(expected);
+}
+
+//-------------------------------------
+static void test_l2_normalization(void)
+{
+    kpu_model_l2_norm_layer_argument_t arg = { 0 };
+    arg.channels = rand_range(1, 1000);
+    size_t size = arg.channels * sizeof(float);
+    uint8_t *main_buffer = main_alloc(size, size);
+    float *src = (float *)main_buffer;
+    double *expected = malloc(arg.channels * sizeof(double));
+    arg.main_mem_in_address = 0;
+    arg.main_mem_out_address = size;
+
+    double sum = 0;
+    for (uint32_t i = 0; i < arg.channels; i++) {
+        src[i] = frand();
+        sum += (double)src[i] * src[i];
+    }
+    for (uint32_t i = 0; i < arg.channels; i++) expected[i] = src[i] / sqrt(sum);
+    kpu_layer_l2_normalization(main_buffer, &arg);
+    check_floats("l2 normalization", (float *)(main_buffer + size), expected, arg.channels, 0);
+    check_tail("l2 normalization", main_buffer, size * 2, (size * 2) + 64);
+    free(main_buffer);
+    free(expected);
+}
+
+// === Data layout layers ===
+
+//-------------------------------------
+static void test_layout(void)
+{
+    kpu_model_shape_t shape;
+    shape.width = rand_range(1, 20);
+    shape.height = rand_range(1, 20);
+    shape.channels = rand_range(1, 20);
+    uint32_t count = shape.width * shape.height * shape.channels;
+    size_t size = count * sizeof(float);
+    double *expected = malloc(count * 4 * sizeof(double));
+
+    // flatten, CHW -> HWC
+    kpu_model_tf_flatten_layer_argument_t farg = { 0 };
+    uint8_t *main_buffer = main_alloc(size, size);
+    float *src = (float *)main_buffer;
+    farg.main_mem_in_address = 0;
+    farg.main_mem_out_address = size;
+    farg.shape = shape;
+    for (uint32_t i = 0; i < count; i++) src[i] = frand();
+    for (uint32_t c = 0; c < shape.channels; c++) {
+        for (uint32_t y = 0; y < shape.height; y++) {
+            for (uint32_t x = 0; x < shape.width; x++) {
+                expected[(((y * shape.width) + x) * shape.channels) + c] = src[(((c * shape.height) + y) * shape.width) + x];
+            }
+        }
+    }
+    kpu_layer_tf_flatten(main_buffer, &farg);
+    check_floats("flatten", (float *)(main_buffer + size), expected, count, -1);
+    check_tail("flatten", main_buffer, size * 2, (size * 2) + 64);
+    free(main_buffer);
+
+    // nearest neighbor resize, up to 2x or down
+    kpu_model_resize_nearest_neighbor_layer_argument_t rarg = { 0 };
+    rarg.in_shape = shape;
+    rarg.out_width = rand_range(1, shape.width * 2);
+    rarg.out_height = rand_range(1, shape.height * 2);
+    uint32_t out_count = rarg.out_width * rarg.out_height * shape.channels;
+    main_buffer = main_alloc(size, out_count * sizeof(float));
+    src = (float *)main_buffer;
+    rarg.main_mem_in_address = 0;
+    rarg.main_mem_out_address = size;
+    for (uint32_t i = 0; i < count; i++) src[i] = frand();
+    double *dst = expected;
+    for (uint32_t c = 0; c < shape.channels; c++) {
+        for (uint32_t y = 0; y < rarg.out_height; y++) {
+            uint32_t in_y = (y * shape.height) / rarg.out_height;
+            for (uint32_t x = 0; x < rarg.out_width; x++) {
+                uint32_t in_x = (x * shape.width) / rarg.out_width;
+                *dst++ = src[(((c * shape.height) + in_y) * shape.width) + in_x];
+            }
+        }
+    }
+    kpu_layer_resize_nearest_neighbor(main_buffer, &rarg);
+    check_floats("resize", (float *)(main_buffer + size), expected, out_count, -1);
+    check_tail("resize", main_buffer, size + (out_count * sizeof(float)), size + (out_count * sizeof(float)) + 64);
+    free(main_buffer);
+
+    // concat of the parts of the main buffer
+    kpu_model_concat_layer_argument_t *carg = calloc(1, sizeof(kpu_model_concat_layer_argument_t) + (4 * sizeof(kpu_model_memory_range_t)));
+    carg->input_count = rand_range(1, 4);
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < carg->input_count; i++) {
+        carg->inputs_mem[i].start = rand_range(0, size - 1);
+        carg->inputs_mem[i].size = rand_range(0, size - carg->inputs_mem[i].start);
+        total += carg->inputs_mem[i].size;
+    }
+    main_buffer = main_alloc(size, total);
+    for (uint32_t i = 0; i < size; i++) main_buffer[i] = rand();
+    carg->main_mem_out_address = size;
+    uint8_t *cexp = malloc(total + 1);
+    uint8_t *p = cexp;
+    for (uint32_t i = 0; i < carg->input_count; i++) {
+        memcpy(p, main_buffer + carg->inputs_mem[i].start, carg->inputs_mem[i].size);
+        p += carg->inputs_mem[i].size;
+    }
+    kpu_layer_concat(main_buffer, carg);
+    check_bytes("concat", main_buffer + size, cexp, total);
+    check_tail("concat", main_buffer, size + total, size + total + 64);
+    free(main_buffer);
+    free(carg);
+    free(cexp);
+
+    // remove padding, every 16th byte
+    kpu_model_remove_padding_layer_argument_t parg = { 0 };
+    parg.channels = shape.channels;
+    main_buffer = main_alloc(shape.channels * 16, shape.channels);
+    for (uint32_t i = 0; i < (shape.channels * 16); i++) main_buffer[i] = rand();
+    parg.main_mem_in_address = 0;
+    parg.main_mem_out_address = shape.channels * 16;
+    uint8_t *pexp = malloc(shape.channels);
+    for (uint32_t i = 0; i < shape.channels; i++) pexp[i] = main_buffer[i * 16];
+    kpu_layer_remove_padding(main_buffer, &parg);
+    check_bytes("remove padding", main_buffer + (shape.channels * 16), pexp, shape.channels);
+    check_tail("remove padding", main_buffer, shape.channels * 17, (shape.channels * 17) + 64);
+    free(main_buffer);
+    free(pexp);
+    free(expected);
+}
+
+// === Benchmark ===
+
+typedef struct _bench_layer_t {
+    const char  *name;
+    uint32_t    type;
+    void        *arg;
+    size_t      main_size;  // main buffer size needed by the layer
+} bench_layer_t;
+
+//-----------------------
+static double time_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+// Run the CPU layer as the driver does, returns false for the layers run on the KPU
+//---------------------------------------------------------------------------------
+static bool run_layer(uint32_t type, const void *arg, uint8_t *main_buffer, const float *weights)
+{
+    switch (type) {
+        case KL_ADD:
+            kpu_layer_add(main_buffer, arg);
+            break;
+        case KL_QUANTIZED_ADD:
+            kpu_layer_quantized_add(main_buffer, arg);
+            break;
+        case KL_GLOBAL_AVERAGE_POOL2D:
+            kpu_layer_global_average_pool2d(main_buffer, arg);
+            break;
+        case KL_QUANTIZED_MAX_POOL2D:
+            kpu_layer_quantized_max_pool2d(main_buffer, arg);
+            break;
+        case KL_AVERAGE_POOL2D:
+            kpu_layer_average_pool2d(main_buffer, arg);
+            break;
+        case KL_QUANTIZE:
+            kpu_layer_quantize(main_buffer, arg);
+            break;
+        case KL_DEQUANTIZE:
+            kpu_layer_dequantize(main_buffer, arg);
+            break;
+        case KL_REQUANTIZE:
+            kpu_layer_requantize(main_buffer, arg);
+            break;
+        case KL_L2_NORMALIZATION:
+            kpu_layer_l2_normalization(main_buffer, arg);
+            break;
+        case KL_SOFTMAX:
+            kpu_layer_softmax(main_buffer, arg);
+            break;
+        case KL_CONCAT:
+        case KL_QUANTIZED_CONCAT:
+            kpu_layer_concat(main_buffer, arg);
+            break;
+        case KL_FULLY_CONNECTED:
+            kpu_layer_fully_connected(main_buffer, arg, weights);
+            break;
+        case KL_TENSORFLOW_FLATTEN:
+            kpu_layer_tf_flatten(main_buffer, arg);
+            break;
+        case KL_RESIZE_NEAREST_NEIGHBOR:
+            kpu_layer_resize_nearest_neighbor(main_buffer, arg);
+            break;
+        case KL_K210_REMOVE_PADDING:
+            kpu_layer_remove_padding(main_buffer, arg);
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+// Main buffer with float values, used by both float and quantized layers
+//------------------------------------------------
+static uint8_t *bench_main_alloc(size_t size)
+{
+    size = (size + 3) & ~3;
+    float *main_buffer = malloc(size + 64);
+    for (size_t i = 0; i < ((size + 64) / sizeof(float)); i++) main_buffer[i] = frand();
+    return (uint8_t *)main_buffer;
+}
+
+// Run the layer 'bench_count' times, returns the time of one run in us or -1 for the KPU layers
+//-------------------------------------------------------------------------------------------------------
+static double bench_layer(const char *name, uint32_t type, const void *arg, uint8_t *main_buffer, const char *info)
+{
+    const float *weights = NULL;
+    float *aligned = NULL;
+    if (type == KL_FULLY_CONNECTED) {
+        // the driver copies unaligned weights to an aligned buffer at load time
+        const kpu_model_fully_connected_layer_argument_t *fc = arg;
+        weights = fc->weights;
+        if (((uintptr_t)weights & 3) != 0) {
+            size_t size = ((fc->in_channels * fc->out_channels) + fc->out_channels) * sizeof(float);
+            aligned = malloc(size);
+            memcpy(aligned, fc->weights, size);
+            weights = aligned;
+        }
+    }
+
+    double t = time_ms();
+    for (uint32_t i = 0; i < bench_count; i++) {
+        if (!run_layer(type, arg, main_buffer, weights)) {
+            printf("%-36s %-22s %10s\r\n", name, kpu_layer_type_name(type), "KPU");
+            return -1;
+        }
+    }
+    t = ((time_ms() - t) * 1000.0) / bench_count;
+    printf("%-36s %-22s %10.1f\r\n", name, (info) ? info : kpu_layer_type_name(type), t);
+    free(aligned);
+    return t;
+}
+
+// Layer arguments of a kmodel (V3) file
+// The kernels only read the main buffer, so it can be filled with random data
+//--------------------------------------
+static bool bench_model(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        printf("Error opening '%s'\r\n", path);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *model = malloc(size);
+    bool ok = ((long)fread(model, 1, size, f) == size);
+    fclose(f);
+
+    const kpu_model_header_t *header = (const kpu_model_header_t *)model;
+    if ((!ok) || (size < (long)sizeof(kpu_model_header_t)) || (header->version != 3) || (header->arch != 0)) {
+        printf("'%s' is not a kmodel V3 file\r\n", path);
+        free(model);
+        return false;
+    }
+    const kpu_model_layer_header_t *layer_headers = (const kpu_model_layer_header_t *)(model + sizeof(kpu_model_header_t) + (header->output_count * sizeof(kpu_model_output_t)));
+    const uint8_t *body = (const uint8_t *)(layer_headers + header->layers_length);
+    uint8_t *main_buffer = bench_main_alloc(header->main_mem_usage);
+    char name[40];
+    double total = 0;
+
+    printf("%s: %u layers, main buffer %u bytes\r\n", path, header->layers_length, header->main_mem_usage);
+    for (uint32_t i = 0; i < header->layers_length; i++) {
+        if ((body + layer_headers[i].body_size) > (model + size)) {
+            printf("Layer %u: body outside the model\r\n", i);
+            ok = false;
+            break;
+        }
+        sprintf(name, "layer %u", i);
+        double t = bench_layer(name, layer_headers[i].type, body, main_buffer, NULL);
+        if (t > 0) total += t;
+        body += layer_headers[i].body_size;
+    }
+    printf("%-36s %-22s %10.1f\r\n", "CPU layers total", "", total);
+    free(main_buffer);
+    free(model);
+    return ok;
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void bench_max_pool(uint32_t width, uint32_t channels, uint32_t kernel, uint32_t stride, uint32_t padding)
+{
+    kpu_model_quant_max_pool2d_layer_argument_t arg = { 0 };
+    char name[40];
+    arg.in_shape.width = arg.in_shape.height = width;
+    arg.in_shape.channels = arg.out_shape.channels = channels;
+    arg.out_shape.width = arg.out_shape.height = pool_out_size(width, kernel, stride, padding);
+    arg.kernel_width = arg.kernel_height = kernel;
+    arg.stride_width = arg.stride_height = stride;
+    arg.padding_width = arg.padding_height = padding;
+    arg.main_mem_out_address = width * width * channels;
+    uint8_t *main_buffer = bench_main_alloc(arg.main_mem_out_address + (arg.out_shape.width * arg.out_shape.height * channels));
+    sprintf(name, "%ux%ux%u %ux%u/%u pad %u", width, width, channels, kernel, kernel, stride, padding);
+    bench_layer(name, KL_QUANTIZED_MAX_POOL2D, &arg, main_buffer, NULL);
+    free(main_buffer);
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void bench_average_pool(uint32_t width, uint32_t channels, uint32_t kernel, uint32_t stride, uint32_t padding)
+{
+    kpu_model_ave_pool2d_layer_argument_t arg = { 0 };
+    char name[40];
+    arg.in_shape.width = arg.in_shape.height = width;
+    arg.in_shape.channels = arg.out_shape.channels = channels;
+    arg.out_shape.width = arg.out_shape.height = pool_out_size(width, kernel, stride, padding);
+    arg.kernel_width = arg.kernel_height = kernel;
+    arg.stride_width = arg.stride_height = stride;
+    arg.padding_width = arg.padding_height = padding;
+    arg.act = KLA_LINEAR;
+    arg.main_mem_out_address = width * width * channels * sizeof(float);
+    uint8_t *main_buffer = bench_main_alloc(arg.main_mem_out_address + (arg.out_shape.width * arg.out_shape.height * channels * sizeof(float)));
+    sprintf(name, "%ux%ux%u %ux%u/%u pad %u", width, width, channels, kernel, kernel, stride, padding);
+    bench_layer(name, KL_AVERAGE_POOL2D, &arg, main_buffer, NULL);
+    free(main_buffer);
+}
+
+// The CPU layers after the last KPU convolution of a MobileNet v1 (224x224, 1000 classes) classifier
+//------------------------------
+static void bench_classifier(void)
+{
+    uint32_t count = 7 * 7 * 1024;
+    uint32_t classes = 1000;
+    size_t fc_size = ((1024 * classes) + classes) * sizeof(float);
+    uint8_t *main_buffer = bench_main_alloc((count * sizeof(float)) + count);
+    double total = 0;
+
+    kpu_model_dequantize_layer_argument_t dq = { 0 };
+    dq.main_mem_in_address = count * sizeof(float);
+    dq.main_mem_out_address = 0;
+    dq.count = count;
+    dq.quant_param.scale = 0.02f;
+    dq.quant_param.bias = -1.0f;
+    total += bench_layer("7x7x1024", KL_DEQUANTIZE, &dq, main_buffer, NULL);
+
+    kpu_model_gap2d_layer_argument_t gap = { 0 };
+    gap.main_mem_in_address = 0;
+    gap.main_mem_out_address = count * sizeof(float);
+    gap.kernel_size = 7 * 7;
+    gap.channels = 1024;
+    total += bench_layer("7x7x1024", KL_GLOBAL_AVERAGE_POOL2D, &gap, main_buffer, NULL);
+
+    kpu_model_fully_connected_layer_argument_t *fc = malloc(sizeof(kpu_model_fully_connected_layer_argument_t) + fc_size);
+    memset(fc, 0, sizeof(kpu_model_fully_connected_layer_argument_t));
+    fc->main_mem_in_address = count * sizeof(float);
+    fc->main_mem_out_address = 0;
+    fc->in_channels = 1024;
+    fc->out_channels = classes;
+    fc->act = KLA_LINEAR;
+    for (uint32_t i = 0; i < (fc_size / sizeof(float)); i++) fc->weights[i] = frand() / 64.0f;
+    total += bench_layer("1024 -> 1000", KL_FULLY_CONNECTED, fc, main_buffer, NULL);
+    free(fc);
+
+    kpu_model_softmax_layer_argument_t sm = { 0 };
+    sm.main_mem_in_address = 0;
+    sm.main_mem_out_address = count * sizeof(float);
+    sm.channels = classes;
+    total += bench_layer("1000", KL_SOFTMAX, &sm, main_buffer, NULL);
+
+    printf("%-36s %-22s %10.1f\r\n", "MobileNet v1 CPU layers total", "", total);
+    free(main_buffer);
+}
+
+//=============================
+int main(int argc, char **argv) {
+    int c;
+
+    while ( (c = getopt(argc, argv, "n:b:m:h")) != -1) {
+        switch (c) {
+            case 'n':
+                test_count = strtol(optarg, NULL, 0);
+                break;
+            case 'b':
+                bench_count = strtol(optarg, NULL, 0);
+                break;
+            case 'm':
+                model_file = optarg;
+                break;
+            default:
+                printf("Usage:\r\n  kputest [-n count] [-b count] [-m model.kmodel]\r\n");
+                return 1;
+        }
+    }
+    if (bench_count == 0) {
+        printf("Wrong parameters\r\n");
+        return 1;
+    }
+
+    srand(1);
+    for (uint32_t n = 0; n < test_count; n++) {
+        test_add();
+        test_quantized_add();
+        test_quantize();
+        test_requantize();
+        test_max_pool();
+        test_average_pool();
+        test_global_average_pool();
+        test_fully_connected();
+        test_softmax();
+        test_l2_normalization();
+        test_layout();
+    }
+    printf("KPU layers test: %s (%d errors)\r\n", (errors) ? "FAILED" : "passed", errors);
+
+    printf("---------------------------------------------------------------------\r\n");
+    printf("%-36s %-22s %10s\r\n", "Layer", "Type", "us/run");
+    printf("---------------------------------------------------------------------\r\n");
+    if (model_file) {
+        if (!bench_model(model_file)) errors++;
+    }
+    else {
+        bench_classifier();
+        bench_max_pool(112, 32, 2, 2, 0);
+        bench_max_pool(56, 64, 3, 2, 1);
+        bench_average_pool(28, 32, 3, 1, 1);
+    }
+    printf("---------------------------------------------------------------------\r\n");
+    return (errors) ? 1 : 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// K210 SDK device functions used by the C modules, provided by host models
+
+#ifndef _DEVICES_H
+#define _DEVICES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// === FFT accelerator, same definitions as in the SDK ===
+typedef struct tag_fft_data
+{
+    int16_t I1;
+    int16_t R1;
+    int16_t I2;
+    int16_t R2;
+} fft_data_t;
+
+typedef enum tag_fft_direction
+{
+    FFT_DIR_BACKWARD,
+    FFT_DIR_FORWARD,
+    FFT_DIR_MAX,
+} fft_direction_t;
+
+/**
+ * @brief       Do 16bit quantized complex FFT
+ *
+ * @param[in]   shift           The shifts selection in 9 stage
+ * @param[in]   direction       The direction
+ * @param[in]   input           The input data
+ * @param[in]   point           The FFT points count
+ * @param[out]  output          The output data
+ */
+void fft_complex_uint16(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point, uint64_t *output);
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Bit-exact fixed-point model of the K210 FFT accelerator, used in place of
+ * the SDK's fft_complex_uint16() by the ulab 'fft.HARDWARE' backend on host.
+ *
+ * The modelled arithmetic is:
+ *  - 64 to 512 complex int16 points, packed two per 64-bit word (fft_data_t), natural order in and out
+ *  - radix-2 decimation in time, stage 0 is the first (2 point) butterfly stage
+ *  - twiddle factors are Q15, round(cos * 32767) and round(sin * 32767), conjugated for the inverse transform
+ *  - the twiddle product is rounded to int16: (x * w + 0x4000) >> 15
+ *  - if bit 'stage' of 'shift' is set, the butterfly outputs are halved with rounding: (a + b + 1) >> 1,
+ *    otherwise they are saturated to the int16 range
+ *  - the inverse transform is not scaled by 1/n (beyond the selected shifts)
+ * The rounding of the silicon is not documented, this model defines the accuracy the
+ * 'fft.HARDWARE' backend is tested for; 'examples/fft_benchmark.py' measures it on the device.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "devices.h"
+
+#define FFT_MODEL_MAX_POINTS    512
+
+//-------------------------------------
+static int32_t fft_model_sat(int32_t x)
+{
+    if (x > 32767) return 32767;
+    if (x < -32768) return -32768;
+    return x;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+void fft_complex_uint16(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point, uint64_t *output)
+{
+    int16_t re[FFT_MODEL_MAX_POINTS], im[FFT_MODEL_MAX_POINTS];
+    const fft_data_t *in = (const fft_data_t *)input;
+    fft_data_t *out = (fft_data_t *)output;
+    int n = point;
+
+    if ((n != 64) && (n != 128) && (n != 256) && (n != 512)) {
+        printf("fft_complex_uint16: invalid fft point %d\r\n", n);
+        abort();
+    }
+
+    // unpack in bit reversed order
+    int bits = 0;
+    while ((1 << bits) < n) bits++;
+    for (int i = 0; i < n; i++) {
+        int j = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) j |= 1 << (bits - 1 - b);
+        }
+        re[j] = (i & 1) ? in[i/2].R2 : in[i/2].R1;
+        im[j] = (i & 1) ? in[i/2].I2 : in[i/2].I1;
+    }
+
+    double sign = (direction == FFT_DIR_FORWARD) ? -1.0 : 1.0;
+    for (int stage = 0; stage < bits; stage++) {
+        int half = 1 << stage;
+        for (int k = 0; k < half; k++) {
+            double theta = sign * M_PI * k / half;
+            int32_t wr = lrint(cos(theta) * 32767.0);
+            int32_t wi = lrint(sin(theta) * 32767.0);
+            for (int i = k; i < n; i += 2*half) {
+                int32_t xr = re[i + half];
+                int32_t xi = im[i + half];
+                int32_t br = (xr * wr - xi * wi + 0x4000) >> 15;
+                int32_t bi = (xr * wi + xi * wr + 0x4000) >> 15;
+                int32_t ar = re[i];
+                int32_t ai = im[i];
+                if (shift & (1 << stage)) {
+                    re[i] = (ar + br + 1) >> 1;
+                    im[i] = (ai + bi + 1) >> 1;
+                    re[i + half] = (ar - br + 1) >> 1;
+                    im[i + half] = (ai - bi + 1) >> 1;
+                } else {
+                    re[i] = fft_model_sat(ar + br);
+                    im[i] = fft_model_sat(ai + bi);
+                    re[i + half] = fft_model_sat(ar - br);
+                    im[i + half] = fft_model_sat(ai - bi);
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < n/2; i++) {
+        out[i].R1 = re[2*i];
+        out[i].I1 = im[2*i];
+        out[i].R2 = re[2*i+1];
+        out[i].I2 = im[2*i+1];
+    }
+}
@@ -0,0 +1,166 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Runs a MicroPython script on the host:
+ *   mpyhost [-m heap_kb] script.py [args]
+ * The script's exit code is 1 on an uncaught exception and the SystemExit value on sys.exit().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "py/compile.h"
+#include "py/runtime.h"
+#include "py/gc.h"
+#include "py/stackctrl.h"
+#include "py/mphal.h"
+#include "py/mperrno.h"
+
+#define HEAP_SIZE_DEFAULT   (8*1024*1024)
+
+//---------------------------------------
+static int execute_file(const char *file)
+{
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_lexer_t *lex = mp_lexer_new_from_file(file);
+        qstr source_name = lex->source_name;
+        #if MICROPY_PY___FILE__
+        mp_store_global(MP_QSTR___file__, MP_OBJ_NEW_QSTR(source_name));
+        #endif
+        mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+        mp_obj_t module_fun = mp_compile(&parse_tree, source_name, false);
+        mp_call_function_0(module_fun);
+        nlr_pop();
+        return 0;
+    }
+    mp_obj_t exc = MP_OBJ_FROM_PTR(nlr.ret_val);
+    if (mp_obj_is_subclass_fast(MP_OBJ_FROM_PTR(mp_obj_get_type(exc)), MP_OBJ_FROM_PTR(&mp_type_SystemExit))) {
+        mp_obj_t val = mp_obj_exception_get_value(exc);
+        if (val == mp_const_none) return 0;
+        return mp_obj_get_int(val) & 0xff;
+    }
+    mp_obj_print_exception(&mp_plat_print, exc);
+    return 1;
+}
+
+//=============================
+int main(int argc, char **argv)
+{
+    size_t heap_size = HEAP_SIZE_DEFAULT;
+    int c;
+
+    while ( (c = getopt(argc, argv, "+m:h")) != -1) {
+        switch (c) {
+            case 'm':
+                heap_size = strtol(optarg, NULL, 0) * 1024;
+                break;
+            default:
+                printf("Usage:\r\n  mpyhost [-m heap_kb] script.py [args]\r\n");
+                return 1;
+        }
+    }
+    if (optind >= argc) {
+        printf("Usage:\r\n  mpyhost [-m heap_kb] script.py [args]\r\n");
+        return 1;
+    }
+
+    mp_stack_ctrl_init();
+    mp_stack_set_limit(256*1024);
+    char *heap = malloc(heap_size);
+    if (heap == NULL) {
+        printf("Error allocating heap\r\n");
+        return 1;
+    }
+    gc_init(heap, heap + heap_size);
+    mp_init();
+
+    // the script's directory is the first module search path
+    const char *file = argv[optind];
+    const char *sep = strrchr(file, '/');
+    mp_obj_list_init(MP_OBJ_TO_PTR(mp_sys_path), 0);
+    mp_obj_list_append(mp_sys_path, (sep) ? mp_obj_new_str(file, sep - file) : MP_OBJ_NEW_QSTR(MP_QSTR_));
+    mp_obj_list_init(MP_OBJ_TO_PTR(mp_sys_argv), 0);
+    for (int i = optind; i < argc; i++) {
+        mp_obj_list_append(mp_sys_argv, mp_obj_new_str(argv[i], strlen(argv[i])));
+    }
+
+    int ret = execute_file(file);
+
+    mp_deinit();
+    free(heap);
+    return ret;
+}
+
+//---------------------------------------------------
+mp_import_stat_t mp_import_stat(const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        if (S_ISDIR(st.st_mode)) return MP_IMPORT_STAT_DIR;
+        if (S_ISREG(st.st_mode)) return MP_IMPORT_STAT_FILE;
+    }
+    return MP_IMPORT_STAT_NO_EXIST;
+}
+
+//---------------------------------------------------------------------------------
+mp_obj_t mp_builtin_open(size_t n_args, const mp_obj_t *args, mp_map_t *kwargs)
+{
+    mp_raise_OSError(MP_EOPNOTSUPP);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(mp_builtin_open_obj, 1, mp_builtin_open);
+
+//---------------------------
+void nlr_jump_fail(void *val)
+{
+    printf("FATAL: uncaught NLR %p\r\n", val);
+    exit(1);
+}
+
+vstr_t *mp_hal_stdout_capture = NULL;
+
+//----------------------------------------------------------
+void mp_hal_stdout_tx_strn(const char *str, size_t len)
+{
+    if (mp_hal_stdout_capture) vstr_add_strn(mp_hal_stdout_capture, str, len);
+    else fwrite(str, 1, len, stdout);
+}
+
+//-----------------------------------------------------------------
+void mp_hal_stdout_tx_strn_cooked(const char *str, size_t len)
+{
+    mp_hal_stdout_tx_strn(str, len);
+}
+
+//-----------------------------------------
+void mp_hal_stdout_tx_str(const char *str)
+{
+    mp_hal_stdout_tx_strn(str, strlen(str));
+}
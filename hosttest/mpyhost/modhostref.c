@@ -0,0 +1,249 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * 'hostref' module, the previous (reference) versions of the optimized
+ * C module functions, for the host tests and benchmarks,
+ * the access to the firmware C functions which are not exposed to Python
+ * and the GC heap checks
+ */
+
+#include "py/runtime.h"
+#include "py/obj.h"
+#include "py/gc.h"
+#include "py/mphal.h"
+
+#include "ndarray.h"
+#include "ipc_rpc_codec.h"
+
+// linalg.dot() before the typed, cache-blocked kernels.
+// Only the result index is corrected (it was stored transposed)
+//-----------------------------------------------------
+STATIC mp_obj_t hostref_dot(mp_obj_t _m1, mp_obj_t _m2)
+{
+    if(!MP_OBJ_IS_TYPE(_m1, &ulab_ndarray_type) || !MP_OBJ_IS_TYPE(_m2, &ulab_ndarray_type)) {
+        mp_raise_TypeError(translate("arguments must be ndarrays"));
+    }
+    ndarray_obj_t *m1 = MP_OBJ_TO_PTR(_m1);
+    ndarray_obj_t *m2 = MP_OBJ_TO_PTR(_m2);
+    if(m1->n != m2->m) {
+        mp_raise_ValueError(translate("matrix dimensions do not match"));
+    }
+    ndarray_obj_t *out = create_new_ndarray(m1->m, m2->n, NDARRAY_FLOAT);
+    mp_float_t *outdata = (mp_float_t *)out->array->items;
+    mp_float_t sum, v1, v2;
+    for(size_t i=0; i < m1->m; i++) { // rows of m1
+        for(size_t j=0; j < m2->n; j++) { // columns of m2
+            sum = 0.0;
+            for(size_t k=0; k < m2->m; k++) {
+                // (i, k) * (k, j)
+                v1 = ndarray_get_float_value(m1->array->items, m1->array->typecode, i*m1->n+k);
+                v2 = ndarray_get_float_value(m2->array->items, m2->array->typecode, k*m2->n+j);
+                sum += v1 * v2;
+            }
+            outdata[i*m2->n+j] = sum;
+        }
+    }
+    return MP_OBJ_FROM_PTR(out);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(hostref_dot_obj, hostref_dot);
+
+// The remote call serialization ('ipc_rpc_codec.c'), the objects are encoded
+// as the remote call arguments are: one object, or the array of all objects
+//-----------------------------------------------------------------
+STATIC mp_obj_t hostref_rpc_encode(size_t n_args, const mp_obj_t *args)
+{
+    vstr_t vstr;
+    size_t len = ipc_rpc_encode(NULL, n_args, args);
+    vstr_init_len(&vstr, len);
+    ipc_rpc_encode((uint8_t *)vstr.buf, n_args, args);
+    return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR(hostref_rpc_encode_obj, 1, hostref_rpc_encode);
+
+//-----------------------------------------------
+STATIC mp_obj_t hostref_rpc_decode(mp_obj_t data)
+{
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(data, &bufinfo, MP_BUFFER_READ);
+    return ipc_rpc_decode(bufinfo.buf, bufinfo.len);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(hostref_rpc_decode_obj, hostref_rpc_decode);
+
+// Calls func(*args) and returns its printed output (e.g. of utimeq.dump())
+//-------------------------------------------------------------------
+STATIC mp_obj_t hostref_capture(size_t n_args, const mp_obj_t *args)
+{
+    vstr_t vstr;
+    vstr_init(&vstr, 256);
+    vstr_t *prev = mp_hal_stdout_capture;
+    mp_hal_stdout_capture = &vstr;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_call_function_n_kw(args[0], n_args - 1, 0, args + 1);
+        nlr_pop();
+    }
+    else {
+        mp_hal_stdout_capture = prev;
+        nlr_jump(nlr.ret_val);
+    }
+    mp_hal_stdout_capture = prev;
+    return mp_obj_new_str_from_vstr(&mp_type_str, &vstr);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR(hostref_capture_obj, 1, hostref_capture);
+
+// ==== GC heap checks ==========================================================
+
+#define HOSTREF_FIN_WORDS   14
+#define HOSTREF_FIN_MAGIC   0x5a5aa5a5
+
+// Object with a finaliser, filled with a pattern which the finaliser checks,
+// the finaliser must see the object intact
+typedef struct _hostref_fin_obj_t {
+    mp_obj_base_t base;
+    uint32_t n;
+    uint32_t magic[HOSTREF_FIN_WORDS];
+} hostref_fin_obj_t;
+
+static size_t hostref_fin_deleted = 0;
+static size_t hostref_fin_errors = 0;
+
+const mp_obj_type_t hostref_fin_type;
+
+//-------------------------------------------------------
+STATIC bool hostref_fin_intact(hostref_fin_obj_t *self)
+{
+    for (int i = 0; i < HOSTREF_FIN_WORDS; i++) {
+        if (self->magic[i] != (HOSTREF_FIN_MAGIC ^ self->n)) return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------------
+STATIC mp_obj_t hostref_fin_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args)
+{
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+    hostref_fin_obj_t *self = m_new_obj_with_finaliser(hostref_fin_obj_t);
+    self->base.type = &hostref_fin_type;
+    self->n = mp_obj_get_int(args[0]);
+    for (int i = 0; i < HOSTREF_FIN_WORDS; i++) {
+        self->magic[i] = HOSTREF_FIN_MAGIC ^ self->n;
+    }
+    return MP_OBJ_FROM_PTR(self);
+}
+
+//-------------------------------------------------
+STATIC mp_obj_t hostref_fin_del(mp_obj_t self_in)
+{
+    hostref_fin_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!hostref_fin_intact(self)) hostref_fin_errors++;
+    // the GC is locked while the finalisers run, the allocation must fail
+    if (gc_alloc(16, 0) != NULL) hostref_fin_errors++;
+    hostref_fin_deleted++;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(hostref_fin_del_obj, hostref_fin_del);
+
+//---------------------------------------------------
+STATIC mp_obj_t hostref_fin_check(mp_obj_t self_in)
+{
+    return mp_obj_new_bool(hostref_fin_intact(MP_OBJ_TO_PTR(self_in)));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(hostref_fin_check_obj, hostref_fin_check);
+
+STATIC const mp_rom_map_elem_t hostref_fin_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___del__),     MP_ROM_PTR(&hostref_fin_del_obj) },
+    { MP_ROM_QSTR(MP_QSTR_check),       MP_ROM_PTR(&hostref_fin_check_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(hostref_fin_locals_dict, hostref_fin_locals_dict_table);
+
+//==========================================
+const mp_obj_type_t hostref_fin_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Fin,
+    .make_new = hostref_fin_make_new,
+    .locals_dict = (mp_obj_dict_t*)&hostref_fin_locals_dict,
+};
+
+// Returns (finalised objects, finalisers which found the object damaged or could allocate)
+//----------------------------------
+STATIC mp_obj_t hostref_fin_count(void)
+{
+    mp_obj_t tuple[2] = {
+        mp_obj_new_int_from_uint(hostref_fin_deleted),
+        mp_obj_new_int_from_uint(hostref_fin_errors),
+    };
+    return mp_obj_new_tuple(2, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(hostref_fin_count_obj, hostref_fin_count);
+
+// The allocation table kinds, as in 'py/gc.c' (2 bits per block)
+#define HOSTREF_AT_FREE     0
+#define HOSTREF_AT_TAIL     2
+#define HOSTREF_AT_MARK     3
+#define HOSTREF_ATB_KIND(block) ((MP_STATE_MEM(gc_alloc_table_start)[(block) / 4] >> (2 * ((block) & 3))) & 3)
+
+// Check the allocation table: a tail follows a head or a tail, and no head
+// is left marked after a collection
+//------------------------------
+STATIC mp_obj_t hostref_gc_verify(void)
+{
+    size_t n_total = MP_STATE_MEM(gc_alloc_table_byte_len) * 4;
+    int prev = HOSTREF_AT_FREE;
+    for (size_t block = 0; block < n_total; block++) {
+        int kind = HOSTREF_ATB_KIND(block);
+        if ((kind == HOSTREF_AT_TAIL) && (prev == HOSTREF_AT_FREE)) {
+            mp_raise_msg_varg(&mp_type_AssertionError, "tail after a free block at %u", (uint)block);
+        }
+        if (kind == HOSTREF_AT_MARK) {
+            mp_raise_msg_varg(&mp_type_AssertionError, "marked head at %u", (uint)block);
+        }
+        prev = kind;
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(hostref_gc_verify_obj, hostref_gc_verify);
+
+//===============================================================
+STATIC const mp_rom_map_elem_t hostref_module_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__),    MP_ROM_QSTR(MP_QSTR_hostref) },
+
+    { MP_ROM_QSTR(MP_QSTR_dot),         MP_ROM_PTR(&hostref_dot_obj) },
+    { MP_ROM_QSTR(MP_QSTR_rpc_encode),  MP_ROM_PTR(&hostref_rpc_encode_obj) },
+    { MP_ROM_QSTR(MP_QSTR_rpc_decode),  MP_ROM_PTR(&hostref_rpc_decode_obj) },
+    { MP_ROM_QSTR(MP_QSTR_capture),     MP_ROM_PTR(&hostref_capture_obj) },
+    { MP_ROM_QSTR(MP_QSTR_Fin),         MP_ROM_PTR(&hostref_fin_type) },
+    { MP_ROM_QSTR(MP_QSTR_fin_count),   MP_ROM_PTR(&hostref_fin_count_obj) },
+    { MP_ROM_QSTR(MP_QSTR_gc_verify),   MP_ROM_PTR(&hostref_gc_verify_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(hostref_module_globals, hostref_module_globals_table);
+
+//=========================================
+const mp_obj_module_t mp_module_hostref = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&hostref_module_globals,
+};
@@ -0,0 +1,4 @@
+static inline void mp_hal_set_interrupt_char(char c) { (void)c; }
+
+// While set, the output is appended to it instead of written to stdout (hostref.capture())
+extern struct _vstr_t *mp_hal_stdout_capture;
@@ -0,0 +1,145 @@
+# ulab.fft test on host
+#
+# The software backend is checked against a direct DFT and the inverse transform,
+# the hardware backend runs through the accelerator model ('fftmodel.c') and its
+# error against the software result must be within what int16 arithmetic allows.
+
+import math
+import ulab as np
+from ulab import fft
+
+errors = 0
+
+def check(cond, msg):
+    global errors
+    if not cond:
+        print("FAILED:", msg)
+        errors += 1
+
+def signal(n, seed, cplx=True):
+    # uniform noise in (-0.5, 0.5)
+    re = np.zeros(n)
+    im = np.zeros(n)
+    for i in range(n):
+        seed = (seed * 1103515245 + 12345) & 0x7fffffff
+        re[i] = seed / 0x7fffffff - 0.5
+        if cplx:
+            seed = (seed * 1103515245 + 12345) & 0x7fffffff
+            im[i] = seed / 0x7fffffff - 0.5
+    return re, im
+
+def tone(n, amp=1.0):
+    # two tones and some noise, as from a vibration sensor
+    x = np.zeros(n)
+    seed = 12345
+    for i in range(n):
+        seed = (seed * 1103515245 + 12345) & 0x7fffffff
+        x[i] = amp * (math.sin(2*math.pi*17.3*i/n) + 0.25*math.sin(2*math.pi*101.7*i/n) + 0.01*(seed/0x7fffffff - 0.5))
+    return x
+
+def dft(re, im, sign):
+    n = len(re)
+    yr = np.zeros(n)
+    yi = np.zeros(n)
+    for k in range(n):
+        a = 0.0
+        b = 0.0
+        for j in range(n):
+            t = sign * 2 * math.pi * ((k * j) % n) / n
+            c = math.cos(t)
+            s = math.sin(t)
+            a += re[j]*c - im[j]*s
+            b += re[j]*s + im[j]*c
+        yr[k] = a
+        yi[k] = b
+    return yr, yi
+
+# numerical.max() returns a one element array
+def max_err(ar, ai, br, bi):
+    return np.numerical.max(abs(ar - br) + abs(ai - bi))[0]
+
+def snr(ref_re, ref_im, re, im):
+    p = np.numerical.sum(ref_re*ref_re + ref_im*ref_im)
+    dre = re - ref_re
+    dim = im - ref_im
+    e = np.numerical.sum(dre*dre + dim*dim)
+    if e == 0:
+        return 999.0
+    return 10 * math.log(p / e) / math.log(10)
+
+# === software backend against the direct DFT, complex and real input ===
+n = 1
+while n <= 256:
+    xr, xi = signal(n, n)
+    yr, yi = dft(xr, xi, -1)
+    re, im = fft.fft(xr, xi, backend=fft.SOFTWARE)
+    e = max_err(re, im, yr, yi)
+    check(e < 1e-10 * n, "fft n={} error {}".format(n, e))
+    # ifft (numpy normalization)
+    yr, yi = dft(xr, xi, 1)
+    re, im = fft.ifft(xr, xi, backend=fft.SOFTWARE)
+    e = max_err(re * n, im * n, yr, yi)
+    check(e < 1e-10 * n, "ifft n={} error {}".format(n, e))
+    # real input, n/2 point transform and split
+    zero = np.zeros(n)
+    yr, yi = dft(xr, zero, -1)
+    re, im = fft.fft(xr, backend=fft.SOFTWARE)
+    e = max_err(re, im, yr, yi)
+    check(e < 1e-10 * n, "real fft n={} error {}".format(n, e))
+    n *= 2
+
+# round trip up to the largest length
+n = 2
+while n <= 4096:
+    xr, xi = signal(n, 7 * n)
+    re, im = fft.fft(xr, xi, backend=fft.SOFTWARE)
+    re, im = fft.ifft(re, im, backend=fft.SOFTWARE)
+    e = max_err(re, im, xr, xi)
+    check(e < 1e-12 * n, "ifft(fft(x)) n={} error {}".format(n, e))
+    n *= 2
+
+# === hardware backend (accelerator model) against the software backend ===
+print("    n  input      fft SNR(dB)  ifft SNR(dB)")
+for n in (64, 128, 256, 512):
+    for name, xr, xi in (("noise", ) + signal(n, 3 * n), ("tone", tone(n), np.zeros(n)), ("small", tone(n, 1e-3), np.zeros(n))):
+        ref_re, ref_im = fft.fft(xr, xi, backend=fft.SOFTWARE)
+        re, im = fft.fft(xr, xi, backend=fft.HARDWARE)
+        s_fft = snr(ref_re, ref_im, re, im)
+        ref_re, ref_im = fft.ifft(xr, xi, backend=fft.SOFTWARE)
+        re, im = fft.ifft(xr, xi, backend=fft.HARDWARE)
+        s_ifft = snr(ref_re, ref_im, re, im)
+        print("{:5d}  {:6s}  {:12.1f}  {:12.1f}".format(n, name, s_fft, s_ifft))
+        # every stage is halved, the rounding noise grows with log2(n)
+        check(s_fft > 50.0, "hardware fft n={} {} SNR {:.1f} dB".format(n, name, s_fft))
+        check(s_ifft > 50.0, "hardware ifft n={} {} SNR {:.1f} dB".format(n, name, s_ifft))
+    # the automatic backend uses the accelerator for these lengths
+    xr = tone(n)
+    re, im = fft.fft(xr)
+    hr, hi = fft.fft(xr, backend=fft.HARDWARE)
+    check(max_err(re, im, hr, hi) == 0, "fft.AUTO n={} does not use the hardware".format(n))
+
+# an impulse at 0 transforms to a constant, within one LSB of the scaled input
+for n in (64, 512):
+    xr = np.zeros(n)
+    xr[0] = 1.0
+    re, im = fft.fft(xr, backend=fft.HARDWARE)
+    check(max_err(re, im, np.ones(n), np.zeros(n)) < 2.0 * n / 32767, "hardware impulse n={}".format(n))
+
+# zero input is returned as zeros
+re, im = fft.fft(np.zeros(64), backend=fft.HARDWARE)
+check(max_err(re, im, np.zeros(64), np.zeros(64)) == 0, "hardware zeros")
+
+# unsupported lengths
+for n in (32, 1024):
+    try:
+        fft.fft(np.zeros(n), backend=fft.HARDWARE)
+        check(False, "hardware fft n={} not rejected".format(n))
+    except ValueError:
+        pass
+re, im = fft.fft(tone(1024))
+ref_re, ref_im = fft.fft(tone(1024), backend=fft.SOFTWARE)
+check(max_err(re, im, ref_re, ref_im) == 0, "fft.AUTO n=1024 does not use the software")
+
+print("FFT test: {} ({} errors)".format("FAILED" if errors else "passed", errors))
+if errors:
+    raise SystemExit(1)
@@ -0,0 +1,228 @@
+# ulab.filter sosfilt/lfilter test and benchmark on host
+#
+# FIR lfilter run on a stream of random chunks (the direct and the FFT overlap-add
+# path, with and without a precomputed spectrum) must give the same outputs and
+# final state as filter.convolve() of the whole signal. The float IIR filters are
+# compared with a direct form I reference, the Q15 filters with the same integer
+# arithmetic written in Python and must be bit-exact.
+# The filters are timed on an accelerometer stream, 3 axes x 4000 samples.
+
+import utime
+import ulab as np
+from ulab import filter
+
+errors = 0
+seed = 1
+
+def check(cond, msg):
+    global errors
+    if not cond:
+        print("FAILED:", msg)
+        errors += 1
+
+def rand(n):
+    global seed
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff
+    return seed % n
+
+def frand():
+    return (rand(2000001) - 1000000) / 1000000.0
+
+def signal(n, dtype=np.float):
+    if dtype == np.int16:
+        return np.array([rand(65536) - 32768 for _ in range(n)], dtype=np.int16)
+    return np.array([frand() for _ in range(n)])
+
+# filters the signal in random chunks with a persistent state, returns the outputs and the state
+def chunked(func, x, zi, maxchunk, **kw):
+    y = []
+    pos = 0
+    while pos < len(x):
+        n = min(1 + rand(maxchunk), len(x) - pos)
+        r, zi = func(x[pos:pos+n], zi=zi, **kw)
+        y.extend(list(r))
+        pos += n
+    return y, zi
+
+def close(got, expected, scale, tol=1e-9):
+    if len(got) != len(expected):
+        return False
+    for i in range(len(got)):
+        if abs(got[i] - expected[i]) > tol * scale:
+            return False
+    return True
+
+# === FIR: chunked lfilter and its final state give the full convolution ===
+for _ in range(60):
+    ntaps = 1 + rand(300)
+    n = 1 + rand(2000)
+    b = signal(ntaps)
+    x = signal(n)
+    full = list(filter.convolve(x, b))
+    scale = sum([abs(v) for v in b])
+    kw = {}
+    if (ntaps >= 64) and (rand(2) == 0):
+        kw["spectrum"] = filter.fir_spectrum(b)
+    # long chunks take the FFT path for the long filters, short ones the direct path
+    maxchunk = 1 + rand(3 * ntaps)
+    y, zi = chunked(lambda c, **k: filter.lfilter(b, np.array([1.0]), c, **k), x, np.zeros(ntaps - 1), maxchunk, **kw)
+    check(close(y + list(zi), full, scale), "FIR {} taps, {} samples, chunks up to {}{}".format(ntaps, n, maxchunk, ", spectrum" if kw else ""))
+
+# the result is also right in place (out=x) and unchunked
+b = signal(200)
+x = signal(3000)
+full = list(filter.convolve(x, b))
+zi = np.zeros(199)
+r, zi = filter.lfilter(b, np.array([1.0]), x, zi=zi, out=x)
+check((r is x) and close(list(r) + list(zi), full, 200), "FIR in place")
+
+# === float IIR: sosfilt and lfilter against direct form I ===
+def ref_iir(b, a, x):
+    # direct form I with the coefficients normalised by a[0]
+    y = []
+    for i in range(len(x)):
+        acc = 0.0
+        for k in range(len(b)):
+            if i >= k:
+                acc += b[k] * x[i-k]
+        for k in range(1, len(a)):
+            if i >= k:
+                acc -= a[k] * y[i-k]
+        y.append(acc / a[0])
+    return y
+
+def section():
+    # stable poles: a1 = -2r*cos(w), a2 = r*r, r < 1
+    r = 0.5 + rand(450) / 1000.0
+    c = frand()
+    return [frand(), frand(), frand(), 1.0, -2 * r * c, r * r]
+
+for _ in range(40):
+    sections = 1 + rand(4)
+    n = 1 + rand(500)
+    sos = [section() for _ in range(sections)]
+    x = signal(n)
+    expected = list(x)
+    for s in sos:
+        expected = ref_iir(s[0:3], s[3:6], expected)
+    y, zi = chunked(lambda c, **k: filter.sosfilt(np.array(sos), c, **k), x, np.zeros(2 * sections), 1 + rand(64))
+    check(close(y, expected, 1.0, 1e-9 * n), "sosfilt {} sections, {} samples".format(sections, n))
+
+    # lfilter of one section, with a0 != 1
+    s = [v * 2.0 for v in sos[0]]
+    expected = ref_iir(s[0:3], s[3:6], list(x))
+    y, zi = chunked(lambda c, **k: filter.lfilter(np.array(s[0:3]), np.array(s[3:6]), c, **k), x, np.zeros(2), 1 + rand(64))
+    check(close(y, expected, 1.0, 1e-9 * n), "lfilter IIR {} samples".format(n))
+
+# === Q15: bit-exact with the integer arithmetic, chunks and state from the caller ===
+def saturate(acc, qbits):
+    if qbits:
+        acc = (acc + (1 << (qbits - 1))) >> qbits
+    return max(-32768, min(32767, acc))
+
+def ref_q15(b, a, x, qbits):
+    y = []
+    for i in range(len(x)):
+        acc = 0
+        for k in range(len(b)):
+            if i >= k:
+                acc += b[k] * x[i-k]
+        for k in range(1, len(a)):
+            if i >= k:
+                acc -= a[k] * y[i-k]
+        y.append(saturate(acc, qbits))
+    return y
+
+def q15(n, limit):
+    return [rand(2 * limit) - limit for _ in range(n)]
+
+for _ in range(60):
+    shift = rand(3)
+    qbits = 15 - shift
+    nb = 1 + rand(12)
+    na = 1 + rand(4)
+    n = 1 + rand(300)
+    b = q15(nb, 8192)
+    a = [1 << qbits] + q15(na - 1, 4096)
+    x = signal(n, np.int16)
+    expected = ref_q15(b, a, list(x), qbits)
+    zi = np.zeros(nb + na - 2, dtype=np.int16)
+    y, zi = chunked(lambda c, **k: filter.lfilter(np.array(b, dtype=np.int16), np.array(a, dtype=np.int16), c, **k), x, zi, 1 + rand(40), shift=shift)
+    check(y == expected, "Q15 lfilter nb={} na={} shift={}".format(nb, na, shift))
+    # the state holds the last inputs and outputs, the oldest first
+    xs = ([0] * nb + list(x))[-(nb - 1):] if nb > 1 else []
+    ys = ([0] * na + expected)[-(na - 1):] if na > 1 else []
+    check(list(zi) == xs + ys, "Q15 lfilter state nb={} na={}".format(nb, na))
+
+    sections = 1 + rand(3)
+    sos = []
+    expected = list(x)
+    for _ in range(sections):
+        s = q15(3, 8192) + [1 << qbits] + q15(2, 4096)
+        sos.append(s)
+        expected = ref_q15(s[0:3], s[3:6], expected, qbits)
+    y, zi = chunked(lambda c, **k: filter.sosfilt(np.array(sos, dtype=np.int16), c, **k), x, np.zeros(4 * sections, dtype=np.int16), 1 + rand(40), shift=shift)
+    check(y == expected, "Q15 sosfilt {} sections shift={}".format(sections, shift))
+
+# in place
+x = signal(100, np.int16)
+b = np.array(q15(5, 8192), dtype=np.int16)
+a = np.array([16384, -8000, 3000], dtype=np.int16)
+expected = ref_q15(list(b), list(a), list(x), 14)
+r = filter.lfilter(b, a, x, out=x)
+check((r is x) and (list(x) == expected), "Q15 lfilter in place")
+
+# === argument checks ===
+b = signal(100)
+h = filter.fir_spectrum(b)
+for args in ((signal(200), np.array([1.0]), h), (b, np.array([2.0]), h), (b, np.array([1.0, 0.5]), h)):
+    try:
+        filter.lfilter(args[0], args[1], signal(500), spectrum=args[2])
+        check(False, "wrong spectrum accepted")
+    except ValueError:
+        pass
+try:
+    filter.lfilter(np.array([1, 2], dtype=np.int16), np.array([1, 2], dtype=np.int16), signal(10, np.int16), zi=np.zeros(3, dtype=np.int16))
+    check(False, "Q15 state of the wrong length accepted")
+except ValueError:
+    pass
+
+# === benchmark: 4 kHz x 3 axes, one second of data in chunks of 250 samples ===
+def bench(name, func, count=5):
+    t = utime.ticks_us()
+    for _ in range(count):
+        func()
+    t = utime.ticks_diff(utime.ticks_us(), t) / count
+    print("{:36s} {:10.1f}".format(name, t))
+
+axes = [signal(4000) for _ in range(3)]
+axes_q15 = [signal(4000, np.int16) for _ in range(3)]
+
+def stream(func, data, state):
+    for i in range(3):
+        for pos in range(0, 4000, 250):
+            func(data[i][pos:pos+250], state[i])
+
+print("{:36s} {:>10s}".format("filter (3 x 4000 samples)", "us"))
+sos = np.array([section() for _ in range(4)])
+zs = [np.zeros(8) for _ in range(3)]
+bench("sosfilt 4 sections float", lambda: stream(lambda c, z: filter.sosfilt(sos, c, zi=z, out=c), axes, zs))
+sos_q = np.array([q15(3, 8192) + [16384] + q15(2, 4096) for _ in range(4)], dtype=np.int16)
+zs = [np.zeros(16, dtype=np.int16) for _ in range(3)]
+bench("sosfilt 4 sections Q15", lambda: stream(lambda c, z: filter.sosfilt(sos_q, c, zi=z, out=c), axes_q15, zs))
+b_q = np.array(q15(9, 8192), dtype=np.int16)
+a_q = np.array([16384] + q15(2, 4096), dtype=np.int16)
+zs = [np.zeros(10, dtype=np.int16) for _ in range(3)]
+bench("lfilter 9/3 taps Q15", lambda: stream(lambda c, z: filter.lfilter(b_q, a_q, c, zi=z, out=c), axes_q15, zs))
+one = np.array([1.0])
+for ntaps in (64, 128):
+    b = signal(ntaps)
+    h = filter.fir_spectrum(b)
+    zs = [np.zeros(ntaps - 1) for _ in range(3)]
+    bench("lfilter FIR {} taps".format(ntaps), lambda: stream(lambda c, z: filter.lfilter(b, one, c, zi=z, out=c), axes, zs))
+    bench("lfilter FIR {} taps, spectrum".format(ntaps), lambda: stream(lambda c, z: filter.lfilter(b, one, c, zi=z, out=c, spectrum=h), axes, zs))
+    bench("convolve {} taps, whole signal".format(ntaps), lambda: [filter.convolve(axes[i], b) for i in range(3)])
+
+print("filter test: {} ({} errors)".format("FAILED" if errors else "passed", errors))
+if errors:
+    raise SystemExit(1)
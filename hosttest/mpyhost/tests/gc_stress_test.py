@@ -0,0 +1,86 @@
+# GC heap stress test on host
+#
+# Random allocation, reallocation and finaliser churn with frequent collections
+# (gc.threshold). All live objects must keep their contents, the finalisers
+# must see intact objects, and the allocation table is checked between the
+# steps: no tail after a free block and no heads left marked.
+
+import gc
+import hostref
+
+errors = 0
+seed = 12345
+
+def check(cond, msg):
+    global errors
+    if not cond:
+        print("FAILED:", msg)
+        errors += 1
+
+def rand(n):
+    global seed
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff
+    return seed % n
+
+def make(kind, n):
+    if kind == 0:
+        return [n + i for i in range(n % 40)]
+    if kind == 1:
+        return {("k%d" % i): i * n for i in range(n % 20)}
+    if kind == 2:
+        return bytearray((n + i) & 0xff for i in range(n % 300))
+    if kind == 3:
+        return "x%d" % n * (n % 30 + 1)
+    if kind == 4:
+        return hostref.Fin(n)
+    return (n, [n] * (n % 7), str(n))
+
+def intact(kind, n, obj):
+    if kind == 4:
+        return obj.check()
+    return obj == make(kind, n)
+
+def verify(msg):
+    try:
+        hostref.gc_verify()
+    except AssertionError as e:
+        check(False, "{}: {}".format(msg, e))
+
+gc.collect()
+gc.threshold(24000)
+slots = [None] * 500
+grow = []
+for it in range(30000):
+    i = rand(len(slots))
+    s = slots[i]
+    if s is not None:
+        check(intact(*s), "object {} {} damaged at iteration {}".format(s[0], s[1], it))
+    k = rand(6)
+    n = rand(1000)
+    slots[i] = (k, n, make(k, n))
+    # growing and shrinking containers (realloc in place and moved)
+    if rand(4) == 0:
+        grow.append(bytearray(rand(64)))
+    if (len(grow) > 200) or (rand(50) == 0):
+        while len(grow) > rand(20):
+            grow.pop()
+    if it % 500 == 0:
+        verify("iteration {}".format(it))
+    if it % 10000 == 9999:
+        gc.collect()
+        verify("after gc.collect()")
+
+for s in slots:
+    if s is not None:
+        check(intact(*s), "object {} {} damaged at the end".format(s[0], s[1]))
+slots = None
+gc.threshold(-1)
+gc.collect()
+verify("end")
+deleted, fin_errors = hostref.fin_count()
+check(fin_errors == 0, "{} finalisers found damaged objects or could allocate".format(fin_errors))
+check(deleted > 1000, "only {} objects finalised".format(deleted))
+
+print("GC stress test: {} ({} errors)".format("FAILED" if errors else "passed", errors))
+if errors:
+    raise SystemExit(1)
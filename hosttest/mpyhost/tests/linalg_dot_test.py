@@ -0,0 +1,114 @@
+# ulab.linalg.dot test and benchmark on host
+#
+# The typed, cache-blocked kernels are compared with the previous
+# linalg.dot loop (hostref.dot) for all type pairs and random shapes,
+# and both are timed for n x n matrices from 8x8 to 256x256.
+
+import utime
+import ulab as np
+import hostref
+
+errors = 0
+seed = 1
+
+def check(cond, msg):
+    global errors
+    if not cond:
+        print("FAILED:", msg)
+        errors += 1
+
+def rand(n):
+    global seed
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff
+    return seed % n
+
+TYPES = (
+    (np.uint8, "uint8", 0, 256),
+    (np.int8, "int8", -128, 256),
+    (np.uint16, "uint16", 0, 65536),
+    (np.int16, "int16", -32768, 65536),
+    (np.float, "float", -1000, 2000),
+)
+
+def matrix(m, n, t):
+    dtype, name, low, span = t
+    a = np.zeros((m, n), dtype=dtype)
+    for i in range(m):
+        for j in range(n):
+            if dtype == np.float:
+                a[i, j] = (rand(2000001) - 1000000) / 1000.0
+            else:
+                a[i, j] = low + rand(span)
+    return a
+
+def same(a, b):
+    if a.shape() != b.shape():
+        return False
+    m, n = a.shape()
+    for i in range(m):
+        for j in range(n):
+            if a[i, j] != b[i, j]:
+                return False
+    return True
+
+# === the kernels give the same results as the previous loop ===
+# (the sums are accumulated in the same order, so the results are exact)
+for t1 in TYPES:
+    for t2 in TYPES:
+        for _ in range(40):
+            m = 1 + rand(19)
+            k = 1 + rand(19)
+            n = 1 + rand(19)
+            a = matrix(m, k, t1)
+            b = matrix(k, n, t2)
+            check(same(np.linalg.dot(a, b), hostref.dot(a, b)), "dot {}x{} {} * {}x{} {}".format(m, k, t1[1], k, n, t2[1]))
+
+# matrices with packed data larger than a cache panel
+a = matrix(40, 300, TYPES[4])
+b = matrix(300, 70, TYPES[3])
+check(same(np.linalg.dot(a, b), hostref.dot(a, b)), "dot 40x300 * 300x70")
+
+# the result is row-major, not transposed
+a = np.array([[1, 2], [3, 4]])
+b = np.array([[5, 6], [7, 8]])
+r = np.linalg.dot(a, b)
+check((r[0, 1] == 22.0) and (r[1, 0] == 43.0), "dot 2x2 result {}".format(r))
+
+# === out= ===
+a = matrix(6, 5, TYPES[4])
+b = matrix(5, 7, TYPES[1])
+out = np.zeros((6, 7))
+r = np.linalg.dot(a, b, out=out)
+check((r is out) and same(out, hostref.dot(a, b)), "dot out=")
+for o in (np.zeros((7, 6)), np.zeros((6, 7), dtype=np.int16), a):
+    try:
+        np.linalg.dot(a, b, out=o)
+        check(False, "dot out= wrong array accepted")
+    except ValueError:
+        pass
+try:
+    np.linalg.dot(a, a)
+    check(False, "dot wrong dimensions accepted")
+except ValueError:
+    pass
+
+# === benchmark ===
+def bench(func, a, b, count):
+    t = utime.ticks_us()
+    for _ in range(count):
+        func(a, b)
+    return utime.ticks_diff(utime.ticks_us(), t) / count
+
+print("    n  type    previous(us)  dot(us)  speedup")
+for n in (8, 16, 32, 64, 128, 256):
+    count = max(1, 2000000 // (n*n*n))
+    for t in (TYPES[4], TYPES[3]):
+        a = matrix(n, n, t)
+        b = matrix(n, n, t)
+        t_ref = bench(hostref.dot, a, b, count)
+        t_dot = bench(np.linalg.dot, a, b, count)
+        print("{:5d}  {:6s}  {:12.1f}  {:7.1f}  {:7.1f}".format(n, t[1], t_ref, t_dot, t_ref / t_dot))
+
+print("linalg.dot test: {} ({} errors)".format("FAILED" if errors else "passed", errors))
+if errors:
+    raise SystemExit(1)
@@ -0,0 +1,218 @@
+# Remote call serialization ('ipc_rpc_codec.c') test on host
+#
+# The decoder is checked with the RFC 7049 appendix A vectors of the supported
+# subset and the encoder with the same vectors in the shortest form, all supported
+# types must survive a round trip (array.array and ulab ndarrays with their type
+# and shape), and malformed or truncated data must raise ValueError.
+
+import array
+import ulab as np
+import hostref
+
+errors = 0
+seed = 1
+
+def check(cond, msg):
+    global errors
+    if not cond:
+        print("FAILED:", msg)
+        errors += 1
+
+def rand(n):
+    global seed
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff
+    return seed % n
+
+NDARRAY = type(np.array([0]))
+
+def unhex(s):
+    return bytes([int(s[i:i+2], 16) for i in range(0, len(s), 2)])
+
+# lists are decoded as tuples, the ndarray type is compared in the printed form
+def same(a, b):
+    if isinstance(a, (list, tuple)):
+        if (not isinstance(b, tuple)) or (len(a) != len(b)):
+            return False
+        for i in range(len(a)):
+            if not same(a[i], b[i]):
+                return False
+        return True
+    if isinstance(a, dict):
+        if (not isinstance(b, dict)) or (len(a) != len(b)):
+            return False
+        for k in a:
+            if (k not in b) or (not same(a[k], b[k])):
+                return False
+        return True
+    if isinstance(a, (bytearray, memoryview)):
+        return isinstance(b, bytes) and (bytes(a) == b)
+    if isinstance(a, array.array):
+        # 'q' and 'Q' have the size of 'l' and 'L' and the same RFC 8746 tags
+        t = {"q": "l", "Q": "L"}.get(str(a)[7], str(a)[7])
+        return (type(b) == array.array) and (t == str(b)[7]) and (list(a) == list(b))
+    if type(a) == NDARRAY:
+        return (type(b) == NDARRAY) and (a.shape() == b.shape()) and (str(a) == str(b))
+    return (type(a) == type(b)) and (a == b)
+
+# === RFC 7049 appendix A, encoded in the shortest form ===
+VECTORS = (
+    (0, "00"), (1, "01"), (10, "0a"), (23, "17"), (24, "1818"), (25, "1819"),
+    (100, "1864"), (1000, "1903e8"), (1000000, "1a000f4240"),
+    (1000000000000, "1b000000e8d4a51000"), (-1, "20"), (-10, "29"), (-100, "3863"),
+    (-1000, "3903e7"), (False, "f4"), (True, "f5"), (None, "f6"),
+    ("", "60"), ("a", "6161"), ("IETF", "6449455446"), ("\"\\", "62225c"),
+    ("ü", "62c3bc"), ("水", "63e6b0b4"),
+    (b"", "40"), (b"\x01\x02\x03\x04", "4401020304"),
+    ([], "80"), ([1, 2, 3], "83010203"), ([1, [2, 3], [4, 5]], "8301820203820405"),
+    (list(range(1, 26)), "98190102030405060708090a0b0c0d0e0f101112131415161718181819"),
+    ({}, "a0"), ({1: 2, 3: 4}, "a201020304"), ({"a": 1, "b": [2, 3]}, "a26161016162820203"),
+    (["a", {"b": "c"}], "826161a161626163"),
+    # the limits of the head forms
+    (255, "18ff"), (256, "190100"), (65535, "19ffff"), (65536, "1a00010000"),
+    (4294967295, "1affffffff"), (4294967296, "1b0000000100000000"),
+    (-24, "37"), (-25, "3818"), (-256, "38ff"), (-257, "390100"),
+)
+for obj, enc in VECTORS:
+    data = unhex(enc)
+    check(same(obj, hostref.rpc_decode(data)), "decode {}".format(enc))
+    if not isinstance(obj, dict) or (len(obj) < 2):
+        # the dict items order is not defined
+        check(hostref.rpc_encode(obj) == data, "encode {}".format(enc))
+
+# the largest unsigned integer, floats in the 8 and 4-byte forms
+check(hostref.rpc_decode(unhex("1bffffffffffffffff")) == 18446744073709551615, "decode 2**64-1")
+check(hostref.rpc_decode(unhex("fb3ff199999999999a")) == 1.1, "decode 1.1")
+check(hostref.rpc_decode(unhex("fa47c35000")) == 100000.0, "decode 100000.0 (4-byte)")
+check(hostref.rpc_decode(unhex("fa7f7fffff")) == 16777215.0 * 2.0**104, "decode float32 max")
+check(hostref.rpc_encode(1.1) == unhex("fb3ff199999999999a"), "encode 1.1")
+check(hostref.rpc_encode(-4.1) == unhex("fbc010666666666666"), "encode -4.1")
+# several objects are encoded as an array, as the call arguments
+check(hostref.rpc_encode((1, 2), {}) == unhex("82820102a0"), "encode args, kwargs")
+
+# === round trips ===
+def rand_obj(depth):
+    k = rand(12 if depth < 4 else 7)
+    if k == 0: return rand(1 << 30) - (1 << 29)
+    if k == 1: return (rand(2000001) - 1000000) / 1024.0
+    if k == 2: return "".join([chr(32 + rand(95)) for _ in range(rand(20))]) + ("é€" if rand(2) else "")
+    if k == 3: return bytes([rand(256) for _ in range(rand(40))])
+    if k == 4: return (None, True, False)[rand(3)]
+    if k == 5: return bytearray([rand(256) for _ in range(rand(10))])
+    if k == 6: return rand(1 << 24) * rand(1 << 24) * (1 if rand(2) else -1)
+    if k == 7: return [rand_obj(depth + 1) for _ in range(rand(6))]
+    if k == 8: return tuple([rand_obj(depth + 1) for _ in range(rand(6))])
+    if k == 9:
+        d = {}
+        for _ in range(rand(5)):
+            d[(rand(1000), str(rand(1000)), rand(1000) / 8.0)[rand(3)]] = rand_obj(depth + 1)
+        return d
+    if k == 10: return rand_array()
+    return rand_ndarray()
+
+CODES = "bBhHiIlLqQfd"
+def rand_array():
+    t = CODES[rand(len(CODES))]
+    a = array.array(t)
+    for _ in range(rand(12)):
+        if t in "fd":
+            a.append((rand(2001) - 1000) / 16.0)
+        elif t in "BHILQ":
+            a.append(rand(256))
+        else:
+            a.append(rand(256) - 128)
+    return a
+
+DTYPES = (np.uint8, np.int8, np.uint16, np.int16, np.float)
+def rand_ndarray():
+    t = DTYPES[rand(len(DTYPES))]
+    m = 1 + rand(4)
+    n = 1 + rand(6)
+    a = np.zeros((m, n), dtype=t)
+    for i in range(m):
+        for j in range(n):
+            a[i, j] = (rand(2001) - 1000) / 8.0 if t == np.float else rand(100)
+    return a
+
+for i in range(500):
+    obj = rand_obj(0)
+    data = hostref.rpc_encode(obj)
+    check(same(obj, hostref.rpc_decode(data)), "round trip {}".format(obj))
+    # every proper prefix is incomplete
+    for n in range(len(data)):
+        try:
+            hostref.rpc_decode(data[:n])
+            check(False, "truncated data accepted: {}".format(data[:n]))
+        except ValueError:
+            pass
+    try:
+        hostref.rpc_decode(data + b"\x00")
+        check(False, "trailing data accepted")
+    except ValueError:
+        pass
+
+# all typecodes and the ndarray shapes, a row vector keeps its shape
+for t in CODES:
+    a = array.array(t, [1, 2, 3])
+    check(same(a, hostref.rpc_decode(hostref.rpc_encode(a))), "array '{}'".format(t))
+for t in DTYPES:
+    for shape in ((1, 5), (5, 1), (3, 4)):
+        a = np.ones(shape, dtype=t)
+        check(same(a, hostref.rpc_decode(hostref.rpc_encode(a))), "ndarray {} {}".format(t, shape))
+# one-dimensional RFC 8746 array (tag 40 with one dimension) is a row vector
+b = hostref.rpc_decode(unhex("d82882" "8103" "d848" "43010203"))
+check((type(b) == NDARRAY) and (b.shape() == (1, 3)) and (str(b) == str(np.array([1, 2, 3], dtype=np.int8))), "1-d multi-dimensional array")
+# not supported by ulab, decoded as array.array
+b = hostref.rpc_decode(unhex("d82882" "820201" "d84e" "48" "0100000002000000"))
+check((type(b) == array.array) and (list(b) == [1, 2]), "int32 multi-dimensional array")
+
+# === errors ===
+def bad(data, msg):
+    try:
+        hostref.rpc_decode(data)
+        check(False, msg)
+    except ValueError:
+        pass
+
+bad(b"", "empty data accepted")
+bad(unhex("9f01ff"), "indefinite length array accepted")
+bad(unhex("1c" + "00" * 16), "reserved additional information accepted")
+bad(unhex("f93c00"), "half float accepted")
+bad(unhex("9bffffffffffffffff"), "huge array length accepted")
+bad(unhex("bb7fffffffffffffff"), "huge map length accepted")
+bad(unhex("5bffffffffffffffff"), "huge bytes length accepted")
+bad(unhex("3bffffffffffffffff"), "negative integer below -2**63 accepted")
+bad(unhex("d8458401020304"), "typed array without byte string accepted")
+bad(unhex("d84e43010203"), "typed array of partial items accepted")
+bad(unhex("d82882820203d84843010203"), "multi-dimensional array of wrong size accepted")
+bad(unhex("d82882820000d84840"), "multi-dimensional array with dimension 0 accepted")
+bad(unhex("81" * 16 + "00"), "data nested too deep accepted")
+deep = 1
+for _ in range(15):
+    deep = [deep]
+check(same(deep, hostref.rpc_decode(hostref.rpc_encode(deep))), "15 levels of nesting")
+
+deep = [deep]
+try:
+    hostref.rpc_encode(deep)
+    check(False, "encoded data nested too deep")
+except ValueError:
+    pass
+for obj in (set([1]), 2**70, hostref.rpc_encode):
+    try:
+        hostref.rpc_encode(obj)
+        check(False, "encoded {}".format(type(obj)))
+    except (TypeError, OverflowError):
+        pass
+
+# random data is rejected or decoded, but nothing else
+for _ in range(3000):
+    data = bytes([rand(256) for _ in range(1 + rand(12))])
+    try:
+        hostref.rpc_decode(data)
+    except (ValueError, TypeError):
+        # TypeError: unhashable dictionary key
+        pass
+
+print("RPC codec test: {} ({} errors)".format("FAILED" if errors else "passed", errors))
+if errors:
+    raise SystemExit(1)
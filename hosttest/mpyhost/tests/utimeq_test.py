@@ -0,0 +1,172 @@
+# utimeq ('k210-freertos/mpy_support/modutimeq.c') test and benchmark on host
+#
+# Random push, pop and cancel(id) operations on ascending and descending queues
+# are compared with a sorted list: pop order, entries with equal times ordered
+# by their id, peek(idx) and peektime(idx) for all indexes (both the candidate
+# heap and the search used for the high indexes) and the dump() output.
+
+import utime
+import utimeq
+import hostref
+
+errors = 0
+seed = 1
+
+def check(cond, msg):
+    global errors
+    if not cond:
+        print("FAILED:", msg)
+        errors += 1
+
+def rand(n):
+    global seed
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff
+    return seed % n
+
+# the reference is a list of (time, id, callback, args) in the queue order
+def ref_sort(ref, asc):
+    ref.sort(key=lambda e: (e[0], e[1]), reverse=not asc)
+
+# (time, id) of the entries printed by dump()
+def dumped(q, full=False):
+    out = hostref.capture(q.dump, full) if full else hostref.capture(q.dump)
+    rows = []
+    for line in out.split("\n")[2:]:
+        f = line.split()
+        if len(f) >= 3:
+            rows.append((int(f[1]), int(f[2]), line.endswith("(empty)")))
+    return rows
+
+def check_queue(q, ref, msg):
+    check(len(q) == len(ref), "{}: length {} != {}".format(msg, len(q), len(ref)))
+    check(q.len() == (len(ref), q.len()[1]), "{}: len()".format(msg))
+    if not ref:
+        return
+    r = [0, 0, 0]
+    for i in range(len(ref)):
+        if q.peektime(i) != ref[i][0]:
+            check(False, "{}: peektime({})".format(msg, i))
+            break
+        q.peek(i, r)
+        if (r[0] != ref[i][0]) or (r[1] is not ref[i][2]) or (r[2] is not ref[i][3]):
+            check(False, "{}: peek({})".format(msg, i))
+            break
+    check(q.peektime() == ref[0][0], "{}: peektime()".format(msg))
+    rows = dumped(q)
+    check([(t, i) for t, i, _ in rows] == [(e[0], e[1]) for e in ref], "{}: dump".format(msg))
+
+for asc in (True, False):
+    for size in (1, 5, 40, 100):
+        q = utimeq.utimeq(size, asc=asc)
+        ref = []
+        for it in range(600):
+            op = rand(10)
+            if (op < 5) and (len(ref) < size):
+                # few distinct times, many entries with equal times
+                t = rand(20) * 100
+                if rand(4) == 0:
+                    t = t + 0.25
+                cb = ("cb", it)
+                args = [it]
+                i = q.push(t, cb, args)
+                ref.append((round(t), i, cb, args))
+            elif (op < 8) and ref:
+                ref_sort(ref, asc)
+                r = [0, 0, 0]
+                q.pop(r)
+                e = ref.pop(0)
+                check((r[0] == e[0]) and (r[1] is e[2]) and (r[2] is e[3]), "pop {} asc={} size={}".format(it, asc, size))
+            elif ref:
+                if rand(4) == 0:
+                    check(not q.cancel(1 << 40), "cancel of an unknown id")
+                else:
+                    e = ref.pop(rand(len(ref)))
+                    check(q.cancel(e[1]), "cancel {} asc={} size={}".format(it, asc, size))
+                    check(not q.cancel(e[1]), "second cancel {}".format(it))
+            ref_sort(ref, asc)
+            if (it % 7 == 0) or (size < 10):
+                check_queue(q, ref, "iteration {} asc={} size={}".format(it, asc, size))
+        # drain
+        ref_sort(ref, asc)
+        r = [0, 0, 0]
+        order = []
+        while q:
+            q.pop(r)
+            order.append(r[0])
+        check(order == [e[0] for e in ref], "drain asc={} size={}".format(asc, size))
+
+# entries with equal times are ordered by the id, the push order
+q = utimeq.utimeq(50)
+ids = [q.push(7, None, n) for n in range(50)]
+check(sorted(ids) == ids, "ids increase")
+r = [0, 0, 0]
+order = []
+while q:
+    q.pop(r)
+    order.append(r[2])
+check(order == list(range(50)), "equal times in push order")
+
+# dump(True) also prints the empty entries
+q = utimeq.utimeq(6)
+for t in (5, 3, 9):
+    q.push(t, None, None)
+rows = dumped(q, True)
+check((len(rows) == 6) and ([t for t, _, _ in rows[:3]] == [3, 5, 9]) and all([e for _, _, e in rows[3:]]), "dump(True)")
+
+# errors
+q = utimeq.utimeq(2)
+for args in ((), (0,), (-1,)):
+    try:
+        q.peektime(*args)
+        check(False, "peektime{} of an empty queue".format(args))
+    except IndexError:
+        pass
+try:
+    q.pop([0, 0, 0])
+    check(False, "pop of an empty queue")
+except IndexError:
+    pass
+q.push(1, None, None)
+q.push(2, None, None)
+try:
+    q.push(3, None, None)
+    check(False, "queue overflow")
+except IndexError:
+    pass
+for idx in (-1, 2):
+    try:
+        q.peektime(idx)
+        check(False, "peektime({})".format(idx))
+    except IndexError:
+        pass
+try:
+    q.pop([0, 0])
+    check(False, "pop into a short list")
+except TypeError:
+    pass
+
+# === benchmark ===
+def bench(name, func, count):
+    t = utime.ticks_us()
+    for _ in range(count):
+        func()
+    t = utime.ticks_diff(utime.ticks_us(), t) / count
+    print("{:36s} {:10.2f}".format(name, t))
+
+print("{:36s} {:>10s}".format("utimeq, 256 entries", "us"))
+q = utimeq.utimeq(256)
+for n in range(256):
+    q.push(rand(100000), None, None)
+r = [0, 0, 0]
+def pop_push():
+    q.pop(r)
+    q.push(r[0] + rand(100000), None, None)
+bench("pop + push", pop_push, 10000)
+bench("peektime(0)", lambda: q.peektime(0), 10000)
+bench("peektime(8)", lambda: q.peektime(8), 10000)
+bench("peektime(31)", lambda: q.peektime(31), 2000)
+bench("peektime(64)", lambda: q.peektime(64), 200)
+
+print("utimeq test: {} ({} errors)".format("FAILED" if errors else "passed", errors))
+if errors:
+    raise SystemExit(1)
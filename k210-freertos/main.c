@@ -71,6 +71,7 @@
 #include "uarths.h"
 #include "rtc.h"
 #include "modmachine.h"
+#include "ipc_rpc.h"
 //*****freeRTOS****
 #include "FreeRTOS.h"
 #include "task.h"
@@ -187,8 +188,8 @@ static void mp_task_proc0(void *pvParameter)
         mp_obj_list_init((mp_obj_list_t *)mp_sys_path, 0);
         mp_obj_list_append((mp_obj_t)mp_sys_path, MP_OBJ_NEW_QSTR(MP_QSTR_));
         mp_obj_list_init((mp_obj_list_t *)mp_sys_argv, 0) ;
-        // Set gc threshold to 4/5 of the heap size
-        MP_STATE_MEM(gc_alloc_threshold) = (mpy_config.config.heap_size1 * 4 / 5) & 0xFFFFFFFFFFFFFFF8;
+        // Set gc threshold mode from the configuration (4/5 of the heap size by default)
+        gc_threshold_init();
 
         // Initialize file system on internal Flash
         flash_fs_ok = init_flash_filesystem();
@@ -276,8 +277,10 @@ static void mp_task_proc1(void *pvParameter)
         mp_obj_list_init(mp_sys_path, 0);
         mp_obj_list_append(mp_sys_path, MP_OBJ_NEW_QSTR(MP_QSTR_));
         mp_obj_list_init(mp_sys_argv, 0) ;
-        // Set gc threshold to 4/5 of the heap size
-        MP_STATE_MEM(gc_alloc_threshold) = (mpy_config.config.heap_size2 * 4 / 5) & 0xFFFFFFFFFFFFFFF8;
+        // Set gc threshold mode from the configuration (4/5 of the heap size by default)
+        gc_threshold_init();
+        // Functions cached for remote calls were on the previous heap
+        MP_STATE_PORT(ipc_rpc_cache) = MP_OBJ_NULL;
 
         thread_msg_t msg;
         bool msg_processed = false;
@@ -317,15 +320,18 @@ static void mp_task_proc1(void *pvParameter)
         while (1) {
             // === Wait for command/message from main (or other) MicroPython task ===
             MP_THREAD_GIL_EXIT();
-            if (xQueueReceive(thread_entry2.threadQueue, &msg, 100 / portTICK_PERIOD_MS) == pdTRUE) {
-                MP_THREAD_GIL_ENTER();
-                vTaskDelay(1 / portTICK_PERIOD_MS);
+            BaseType_t msg_received = xQueueReceive(thread_entry2.threadQueue, &msg, 100 / portTICK_PERIOD_MS);
+            MP_THREAD_GIL_ENTER();
+            if (msg_received == pdTRUE) {
+                // Remote calls are run below without delay
+                if ((msg.type != THREAD_MSG_TYPE_INTEGER) || (msg.intdata != THREAD_IPC_TYPE_RPC)) vTaskDelay(1 / portTICK_PERIOD_MS);
                 // Got a message
                 if ((msg.type == THREAD_MSG_TYPE_INTEGER) || (msg.type == THREAD_MSG_TYPE_STRING)) {
                     msg_processed = false;
                     if (msg.type == THREAD_MSG_TYPE_INTEGER) {
                         // ** Integer type command **
                         if (msg.intdata == THREAD_IPC_TYPE_TERMINATE) break;
+                        if (msg.intdata == THREAD_IPC_TYPE_RPC) msg_processed = true;
                     }
                     else if (msg.type == THREAD_MSG_TYPE_STRING) {
                         // ** String type command **
@@ -365,6 +371,9 @@ static void mp_task_proc1(void *pvParameter)
                     if (msg.strdata) vPortFree(msg.strdata);
                 }
             }
+            // === Run the queued remote calls ===
+            ipc_rpc_process();
+
             xSemaphoreTake(inter_proc_mutex, portMAX_DELAY);
             task_ipc.busy = true;
             xSemaphoreGive(inter_proc_mutex);
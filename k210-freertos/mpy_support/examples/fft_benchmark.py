@@ -0,0 +1,47 @@
+# ulab FFT accuracy and throughput of the hardware and software backends
+#
+# The float software transform of each test signal is taken as the reference,
+# the hardware (int16 fixed point) error is reported as signal to noise ratio.
+
+import utime, math
+import ulab as np
+from ulab import fft
+
+REPEAT = 50
+
+def test_signal(n):
+    # two tones and some noise, as from a vibration sensor
+    x = np.zeros(n)
+    seed = 12345
+    for i in range(n):
+        seed = (seed * 1103515245 + 12345) & 0x7fffffff
+        x[i] = math.sin(2*math.pi*17.3*i/n) + 0.25*math.sin(2*math.pi*101.7*i/n) + 0.01*(seed/0x7fffffff - 0.5)
+    return x
+
+def snr(ref_re, ref_im, re, im):
+    p = np.numerical.sum(ref_re*ref_re + ref_im*ref_im)
+    dre = re - ref_re
+    dim = im - ref_im
+    e = np.numerical.sum(dre*dre + dim*dim)
+    if e == 0:
+        return 999.0
+    return 10 * math.log(p / e) / math.log(10)
+
+def run(func, x, backend):
+    t = utime.ticks_us()
+    for _ in range(REPEAT):
+        func(x, backend=backend)
+    return utime.ticks_diff(utime.ticks_us(), t) / REPEAT
+
+print("    n  backend   fft(us)  ifft(us)  spectrum(us)  SNR(dB)")
+for n in (64, 128, 256, 512, 1024, 2048):
+    x = test_signal(n)
+    ref_re, ref_im = fft.fft(x, backend=fft.SOFTWARE)
+    for backend, name in ((fft.SOFTWARE, 'software'), (fft.HARDWARE, 'hardware')):
+        if (backend == fft.HARDWARE) and (n > 512):
+            continue
+        re, im = fft.fft(x, backend=backend)
+        t_fft = run(fft.fft, x, backend)
+        t_ifft = run(fft.ifft, x, backend)
+        t_spec = run(np.extras.spectrogram, x, backend)
+        print("{:5d}  {:8s}  {:8.1f}  {:8.1f}  {:12.1f}  {:7.1f}".format(n, name, t_fft, t_ifft, t_spec, snr(ref_re, ref_im, re, im)))
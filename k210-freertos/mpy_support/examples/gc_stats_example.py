@@ -0,0 +1,37 @@
+# GC and allocation profiler
+#
+# The firmware must be built with CONFIG_MICROPY_GC_PROFILE enabled.
+# The statistics are kept separately for each MicroPython instance,
+# use 'instance=2' to get the second instance's statistics.
+
+import micropython, gc
+
+# Enable the profiler, clear the statistics and sample every 8th allocation
+micropython.gc_stats(True, reset=True, sample=8)
+
+def work():
+    data = []
+    for i in range(5000):
+        data.append([i] * (i % 40))
+        if len(data) > 200:
+            data = data[100:]
+    return len(data)
+
+work()
+gc.collect()
+
+st = micropython.gc_stats()
+print('collections:', st['collections'], st['reasons'])
+print('pause avg/max [us]:', st['pause'])
+print('pause histogram (<128us, <256us, ...):', st['pause_hist'])
+print('bytes scanned:', st['scanned'])
+print('allocations: {}, {} bytes'.format(st['allocs'], st['alloc_bytes']))
+# allocation sites are return addresses, resolve them with
+# 'riscv64-unknown-elf-addr2line -f -e MicroPython <address>'
+for site, count, nbytes in st['sites'][:5]:
+    print('  0x{:08x}: {} allocations, {} bytes'.format(site, count, nbytes))
+
+# Print the full report to the REPL
+micropython.gc_stats(dump=True)
+
+micropython.gc_stats(False)
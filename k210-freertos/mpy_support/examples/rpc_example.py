@@ -0,0 +1,46 @@
+# Calling functions on the second MicroPython instance
+#
+# The firmware must be built with two MicroPython instances.
+# The arguments and results are serialized, the call returns a future
+# and the main instance can continue its work while the call runs on the second core.
+
+import _thread, utime, ulab
+
+REMOTE = """
+import ulab, _thread
+def block_rms(x, gain=1.0):
+    return ulab.numerical.mean(x * x) ** 0.5 * gain
+_thread.rpc_register('block_rms', block_rms)
+"""
+
+# Define and register the function on the second instance
+_thread.ipc_command(REMOTE)
+utime.sleep_ms(100)
+
+x = ulab.linspace(-1, 1, 1024)
+
+# Submit the call, do some work, then get the result
+f = _thread.rpc_call('block_rms', (x,), {'gain': 2.0}, timeout=1000)
+s = 0
+for i in range(1000):
+    s += i
+print('block_rms:', f.result())
+print('queued, exec, total [us]:', f.stats())
+
+# Module functions can be called by name, they are imported on first use
+f = _thread.rpc_call('ulab.numerical.mean', (x,))
+print('mean:', f.result(500))
+
+# Exceptions raised on the second instance are raised by result()
+f = _thread.rpc_call('block_rms', ('abc',))
+try:
+    f.result()
+except Exception as e:
+    print('remote error:', type(e).__name__, e)
+
+# Several calls can be queued
+fs = [_thread.rpc_call('block_rms', (x,), {'gain': g}) for g in (1.0, 2.0, 3.0)]
+print([f.result() for f in fs])
+
+print('calls, errors, expired, cancelled, rejected, exec avg, exec max, latency avg, latency max:')
+print(_thread.rpc_stats())
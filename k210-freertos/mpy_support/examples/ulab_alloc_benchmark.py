@@ -0,0 +1,58 @@
+# ulab heap use and time per operation, new arrays vs in-place and out= operations
+#
+# The garbage collector is disabled while an operation is repeated, the heap
+# growth divided by the number of repetitions is the number of bytes allocated
+# by one operation. Operations which allocate nothing cause no GC pauses.
+
+import gc, utime
+import ulab as np
+from ulab import vector
+
+N = 1000
+REPEAT = 100
+
+b = np.linspace(1, 2, num=N)
+out = np.zeros(N)
+k = 1.5
+
+def a_axkb(a):
+    return a * k + b
+
+def a_axkb_inplace(a):
+    a *= k
+    a += b
+    return a
+
+def a_add_scalar(a):
+    return a + 2
+
+def a_iadd_scalar(a):
+    a += 2
+    return a
+
+def a_sin(a):
+    return vector.sin(a)
+
+def a_sin_out(a):
+    return vector.sin(a, out=out)
+
+def measure(name, func):
+    a = np.linspace(0, 1, num=N)
+    gc.collect()
+    gc.disable()
+    m = gc.mem_alloc()
+    t = utime.ticks_us()
+    for _ in range(REPEAT):
+        a = func(a)
+    t = utime.ticks_diff(utime.ticks_us(), t)
+    m = gc.mem_alloc() - m
+    gc.enable()
+    print("{:24s} {:8d} bytes/op {:8.1f} us/op".format(name, m // REPEAT, t / REPEAT))
+
+print("{} element float arrays".format(N))
+measure("a = a * k + b", a_axkb)
+measure("a *= k; a += b", a_axkb_inplace)
+measure("a = a + 2", a_add_scalar)
+measure("a += 2", a_iadd_scalar)
+measure("vector.sin(a)", a_sin)
+measure("vector.sin(a, out=out)", a_sin_out)
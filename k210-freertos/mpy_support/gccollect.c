@@ -28,15 +28,23 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "syslog.h"
 #include <setjmp.h>
 
 #include "py/mpconfig.h"
 #include "py/mpstate.h"
+#include "py/runtime.h"
 #include "py/gc.h"
 #include "py/mpthread.h"
 #include "mphalport.h"
+#include "modmachine.h"
 #include "gccollect.h"
+#include "gcprofile.h"
+
+// Allocation threshold controller state for both MicroPython instances
+gc_threshold_ctl_t gc_threshold_ctl[2] = { 0 };
+const char *gc_threshold_modes[GC_THRESHOLD_MODE_MAX] = { "fixed", "pause", "occupancy" };
 
 /*
 uintptr_t get_sp(void) {
@@ -91,13 +99,186 @@ static void gc_collect_inner(int level)
 }
 */
 
+// ==== Allocation threshold ===================================================
+
+// Returns the threshold mode index, -1 if unknown
+//-------------------------------------
+int gc_threshold_mode(const char *mode)
+{
+    for (int i=0; i<GC_THRESHOLD_MODE_MAX; i++) {
+        if (strcmp(mode, gc_threshold_modes[i]) == 0) return i;
+    }
+    return -1;
+}
+
+// Set the threshold in bytes for all threads of the running instance
+//---------------------------------------------------------------------
+static void gc_threshold_apply(gc_threshold_ctl_t *ctl, int32_t threshold)
+{
+    ctl->threshold = threshold;
+    mp_thread_set_gc_threshold((threshold < 0) ? (size_t)-1 : (threshold / MICROPY_BYTES_PER_GC_BLOCK));
+}
+
+// Limits for the adapted threshold
+// The threshold must be reached before the heap is full,
+// otherwise the collection is triggered by a failed allocation
+//-----------------------------------------------------------------------------
+static int32_t gc_threshold_limit(gc_threshold_ctl_t *ctl, int64_t threshold)
+{
+    int32_t heap = MP_STATE_MEM(gc_pool_end) - MP_STATE_MEM(gc_pool_start);
+    int32_t free = heap - ctl->last_live;
+    int32_t max = free - (free / 8);
+    int32_t min = heap / 64;
+    if (min < GC_THRESHOLD_MIN) min = GC_THRESHOLD_MIN;
+    if (min > max) min = max;
+
+    if (threshold > max) threshold = max;
+    if (threshold < min) threshold = min;
+    return (int32_t)threshold;
+}
+
+//-------------------------------------------------------------------------
+static void gc_threshold_configure(int mode, int32_t target, bool reset)
+{
+    gc_threshold_ctl_t *ctl = &gc_threshold_ctl[gc_instance_index()];
+    int32_t heap = MP_STATE_MEM(gc_pool_end) - MP_STATE_MEM(gc_pool_start);
+    int32_t threshold;
+
+    if (reset) memset(ctl, 0, sizeof(gc_threshold_ctl_t));
+    ctl->mode = mode;
+    ctl->target = target;
+    if (mode == GC_THRESHOLD_MODE_PAUSE) {
+        if (target <= 0) ctl->target = GC_THRESHOLD_PAUSE_DEFAULT;
+        // start from the current threshold, it is adapted after each collection
+        threshold = (ctl->threshold > 0) ? ctl->threshold : (heap * 4 / 5);
+        threshold = gc_threshold_limit(ctl, threshold);
+    }
+    else if (mode == GC_THRESHOLD_MODE_OCCUPANCY) {
+        if (target <= 0) ctl->target = GC_THRESHOLD_OCCUPANCY_DEFAULT;
+        threshold = gc_threshold_limit(ctl, ((int64_t)heap * ctl->target / 100) - ctl->last_live);
+    }
+    else {
+        if (target == 0) ctl->target = heap * 4 / 5;
+        threshold = (ctl->target < 0) ? -1 : ctl->target;
+    }
+    gc_threshold_apply(ctl, threshold);
+}
+
+// Initialize the threshold of the running instance from the configuration,
+// called after gc_init()
+//----------------------
+void gc_threshold_init()
+{
+    int mode = mpy_config.config.gc_mode;
+    if (mode >= GC_THRESHOLD_MODE_MAX) mode = GC_THRESHOLD_MODE_FIXED;
+    gc_threshold_configure(mode, mpy_config.config.gc_target, true);
+}
+
+// Set from gc.threshold()
+//---------------------------------------------------
+void gc_threshold_set(const char *mode, mp_int_t target)
+{
+    int imode = gc_threshold_mode(mode);
+    if (imode < 0) {
+        mp_raise_ValueError("unknown threshold mode");
+    }
+    if ((imode == GC_THRESHOLD_MODE_OCCUPANCY) && ((target < 0) || (target > 95))) {
+        mp_raise_ValueError("occupancy target 0~95 % expected");
+    }
+    if ((imode == GC_THRESHOLD_MODE_PAUSE) && (target < 0)) {
+        mp_raise_ValueError("pause target must be positive");
+    }
+    if (target > INT32_MAX) target = INT32_MAX;
+    if (target < -1) target = -1;
+    gc_threshold_configure(imode, target, false);
+}
+
+// Adapt the threshold after the collection
+// In the 'pause' mode a pause over the target reduces the threshold immediately
+// by the ratio of the target and the pause (aiming at 90% of the target, at most by half),
+// while the average pause is well below the target the threshold grows slowly (+1/4).
+// Only the sweep of the garbage depends on the threshold, marking the live heap and
+// scanning the whole allocation table don't; if they alone exceed the target
+// the threshold stays at its minimum.
+// In the 'occupancy' mode the threshold is the free space left until the
+// target percentage of the heap is used.
+//--------------------------------------------
+static void gc_threshold_update(uint32_t pause)
+{
+    gc_threshold_ctl_t *ctl = &gc_threshold_ctl[gc_instance_index()];
+    int32_t heap = MP_STATE_MEM(gc_pool_end) - MP_STATE_MEM(gc_pool_start);
+    int64_t threshold;
+
+    ctl->collections++;
+    ctl->last_pause = pause;
+    if (pause > ctl->max_pause) ctl->max_pause = pause;
+    ctl->last_live = MP_STATE_MEM(gc_live_blocks) * MICROPY_BYTES_PER_GC_BLOCK;
+
+    if (ctl->mode == GC_THRESHOLD_MODE_PAUSE) {
+        int64_t current = (ctl->threshold > 0) ? ctl->threshold : (heap * 4 / 5);
+        ctl->avg_pause = (ctl->avg_pause == 0) ? pause : (((ctl->avg_pause * 3) + pause) / 4);
+        if (pause > (uint32_t)ctl->target) {
+            ctl->over_target++;
+            threshold = (current * ctl->target * 9) / ((int64_t)pause * 10);
+            if (threshold < (current / 2)) threshold = current / 2;
+        }
+        else if (ctl->avg_pause < (((uint32_t)ctl->target * 7) / 10)) threshold = current + (current / 4);
+        else threshold = current;
+    }
+    else if (ctl->mode == GC_THRESHOLD_MODE_OCCUPANCY) {
+        threshold = ((int64_t)heap * ctl->target / 100) - ctl->last_live;
+    }
+    else return;
+
+    threshold = gc_threshold_limit(ctl, threshold);
+    // Ignore small changes
+    int64_t diff = threshold - ctl->threshold;
+    if ((diff < 0) ? (-diff > (ctl->threshold / 16)) : (diff > (ctl->threshold / 16))) {
+        LOGD("GC", "%s: pause %u us, live %u, threshold %d -> %d", gc_threshold_modes[ctl->mode],
+                pause, ctl->last_live, ctl->threshold, (int32_t)threshold);
+        ctl->adjustments++;
+        gc_threshold_apply(ctl, threshold);
+    }
+}
+
+// gc.threshold_info()
+// Returns (mode, target, threshold, last_pause, max_pause, live, collections, adjustments, over_target)
+//------------------------------------
+STATIC mp_obj_t gc_threshold_info(void)
+{
+    gc_threshold_ctl_t ctl;
+    memcpy(&ctl, &gc_threshold_ctl[gc_instance_index()], sizeof(gc_threshold_ctl_t));
+    mp_obj_t tuple[9] = {
+        mp_obj_new_str(gc_threshold_modes[ctl.mode], strlen(gc_threshold_modes[ctl.mode])),
+        mp_obj_new_int(ctl.target),
+        mp_obj_new_int(ctl.threshold),
+        mp_obj_new_int_from_uint(ctl.last_pause),
+        mp_obj_new_int_from_uint(ctl.max_pause),
+        mp_obj_new_int_from_uint(ctl.last_live),
+        mp_obj_new_int_from_uint(ctl.collections),
+        mp_obj_new_int_from_uint(ctl.adjustments),
+        mp_obj_new_int_from_uint(ctl.over_target),
+    };
+    return mp_obj_new_tuple(9, tuple);
+}
+MP_DEFINE_CONST_FUN_OBJ_0(gc_threshold_info_obj, gc_threshold_info);
+
+// ==== Garbage collection =====================================================
+
 //-------------------
 void gc_collect(void)
 {
+    uint64_t t_start = mp_hal_ticks_us();
+    #if MICROPY_GC_PROFILE
+    gc_profile_collect_start();
+    #endif
     // start the GC
     gc_collect_start();
 
     DEBUG_GC_printf("[GC_COLLECT] stacks\r\n");
+    #if MICROPY_GC_PROFILE
+    gc_profile_scan_class(GC_PROFILE_SCAN_STACK);
+    #endif
     //gc_collect_inner(0);
     gc_collect_regs_and_stack();
 
@@ -107,5 +288,9 @@ void gc_collect(void)
 #endif
     // end the GC
     gc_collect_end();
+    #if MICROPY_GC_PROFILE
+    gc_profile_collect_end();
+    #endif
+    gc_threshold_update(mp_hal_ticks_us() - t_start);
 }
 
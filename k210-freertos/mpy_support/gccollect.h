@@ -29,7 +29,46 @@
 #ifndef GC_COLLECT_H
 #define GC_COLLECT_H
 
+#include <stdint.h>
+#include "py/mpstate.h"
+
+// Allocation threshold modes
+#define GC_THRESHOLD_MODE_FIXED         0   // fixed threshold, 4/5 of the heap by default
+#define GC_THRESHOLD_MODE_PAUSE         1   // adapted to keep the collection pause below the target (us)
+#define GC_THRESHOLD_MODE_OCCUPANCY     2   // adapted to collect when the target percentage of the heap is used
+#define GC_THRESHOLD_MODE_MAX           3
+
+#define GC_THRESHOLD_PAUSE_DEFAULT      2000    // us
+#define GC_THRESHOLD_OCCUPANCY_DEFAULT  75      // percent of the heap
+#define GC_THRESHOLD_MIN                8192    // minimal adapted threshold, bytes
+
+typedef struct _gc_threshold_ctl_t {
+    uint8_t     mode;
+    int32_t     target;         // max pause in us, heap occupancy in percent or fixed threshold in bytes
+    int32_t     threshold;      // current threshold in bytes, -1 if disabled
+    uint32_t    collections;
+    uint32_t    adjustments;    // number of threshold changes
+    uint32_t    over_target;    // collections with the pause over the target
+    uint32_t    last_pause;     // us
+    uint32_t    avg_pause;      // us, moving average
+    uint32_t    max_pause;      // us
+    uint32_t    last_live;      // bytes used after the last collection
+} gc_threshold_ctl_t;
+
+extern gc_threshold_ctl_t gc_threshold_ctl[2];
+extern const char *gc_threshold_modes[GC_THRESHOLD_MODE_MAX];
+
+// Index of the running MicroPython instance,
+// the threads of an instance share the instance's heap
+//---------------------------------------
+static inline int gc_instance_index(void)
+{
+    return (MP_STATE_MEM(gc_pool_start) == mp_state_ctx2.mem.gc_pool_start) ? 1 : 0;
+}
+
 //uintptr_t get_sp(void);
 void gc_collect(void);
+int gc_threshold_mode(const char *mode);
+void gc_threshold_init();
 
 #endif
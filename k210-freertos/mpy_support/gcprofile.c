@@ -0,0 +1,326 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/mpstate.h"
+#include "py/mphal.h"
+#include "mphalport.h"
+#include "modmachine.h"
+#include "gccollect.h"
+#include "gcprofile.h"
+
+#if MICROPY_GC_PROFILE
+
+// Profiler data for both MicroPython instances,
+// each instance only updates its own entry while holding its GIL
+gc_profile_t gc_profile[2] = { 0 };
+
+static const char *reason_names[GC_PROFILE_REASON_MAX] = { "explicit", "threshold", "nomem" };
+static const qstr scan_qstrs[GC_PROFILE_SCAN_MAX] = { MP_QSTR_roots, MP_QSTR_pystack, MP_QSTR_stacks, MP_QSTR_heap };
+
+// Get the profiler data of the running instance, NULL if not enabled
+//----------------------------------------------
+static inline gc_profile_t *gc_profile_get(void)
+{
+    gc_profile_t *prof = &gc_profile[gc_instance_index()];
+    return (prof->enabled) ? prof : NULL;
+}
+
+//--------------------------------
+void gc_profile_reason(int reason)
+{
+    gc_profile_t *prof = gc_profile_get();
+    if (prof) prof->reason = reason;
+}
+
+//----------------------------------------
+void gc_profile_scan_class(int scan_class)
+{
+    gc_profile_t *prof = gc_profile_get();
+    if (prof) prof->scan_class = scan_class;
+}
+
+//-----------------------------------------------------
+void gc_profile_scanned(int scan_class, size_t n_bytes)
+{
+    gc_profile_t *prof = gc_profile_get();
+    if ((prof) && (prof->collecting)) {
+        if (scan_class == GC_PROFILE_SCAN_CURRENT) scan_class = prof->scan_class;
+        prof->recent[prof->collections % GC_PROFILE_RECENT].scanned[scan_class] += n_bytes;
+    }
+}
+
+//-----------------------------
+void gc_profile_collect_start()
+{
+    gc_profile_t *prof = gc_profile_get();
+    if (prof == NULL) return;
+
+    gc_profile_collect_t *col = &prof->recent[prof->collections % GC_PROFILE_RECENT];
+    memset(col, 0, sizeof(gc_profile_collect_t));
+    col->reason = prof->reason;
+    prof->reason = GC_PROFILE_REASON_EXPLICIT;
+    prof->scan_class = GC_PROFILE_SCAN_ROOTS;
+    prof->collecting = true;
+    prof->t_start = mp_hal_ticks_us();
+}
+
+//---------------------------
+void gc_profile_collect_end()
+{
+    gc_profile_t *prof = gc_profile_get();
+    if ((prof == NULL) || (!prof->collecting)) return;
+
+    uint32_t pause = mp_hal_ticks_us() - prof->t_start;
+    gc_profile_collect_t *col = &prof->recent[prof->collections % GC_PROFILE_RECENT];
+    col->time = mp_hal_ticks_ms();
+    col->pause = pause;
+    prof->collecting = false;
+
+    prof->reasons[col->reason]++;
+    prof->pause_total += pause;
+    if (pause > prof->pause_max) prof->pause_max = pause;
+    int bin = 0;
+    while ((bin < (GC_PROFILE_PAUSE_BINS-1)) && (pause >= (GC_PROFILE_PAUSE_BIN0_US << bin))) bin++;
+    prof->pause_hist[bin]++;
+    for (int i=0; i<GC_PROFILE_SCAN_MAX; i++) {
+        prof->scanned[i] += col->scanned[i];
+    }
+    prof->collections++;
+}
+
+//-----------------------------------------------
+void gc_profile_alloc(size_t n_bytes, void *site)
+{
+    gc_profile_t *prof = gc_profile_get();
+    if (prof == NULL) return;
+
+    prof->allocs++;
+    prof->alloc_bytes += n_bytes;
+    int bin = 0;
+    while ((bin < (GC_PROFILE_ALLOC_BINS-1)) && (n_bytes > (GC_PROFILE_ALLOC_BIN0 << bin))) bin++;
+    prof->alloc_hist[bin]++;
+
+    if (++prof->sample_cnt < prof->sample_rate) return;
+    prof->sample_cnt = 0;
+    // Sampled allocation, account it to the call site
+    for (int i=0; i<GC_PROFILE_SITES; i++) {
+        gc_profile_site_t *entry = &prof->sites[i];
+        if ((entry->site == (uintptr_t)site) || (entry->count == 0)) {
+            entry->site = (uintptr_t)site;
+            entry->count++;
+            entry->bytes += n_bytes;
+            return;
+        }
+    }
+    prof->sites_other++;
+}
+
+//----------------------------------------------
+static void gc_profile_reset(gc_profile_t *prof)
+{
+    bool enabled = prof->enabled;
+    uint32_t sample_rate = prof->sample_rate;
+    memset(prof, 0, sizeof(gc_profile_t));
+    prof->sample_rate = sample_rate;
+    prof->enabled = enabled;
+}
+
+// Sort the sampled sites by allocated bytes
+//---------------------------------------------------
+static void gc_profile_sort_sites(gc_profile_t *prof)
+{
+    for (int i=1; i<GC_PROFILE_SITES; i++) {
+        gc_profile_site_t entry = prof->sites[i];
+        int j = i - 1;
+        while ((j >= 0) && (prof->sites[j].bytes < entry.bytes)) {
+            prof->sites[j+1] = prof->sites[j];
+            j--;
+        }
+        prof->sites[j+1] = entry;
+    }
+}
+
+//-----------------------------------------------------------
+static void gc_profile_dump(gc_profile_t *prof, int instance)
+{
+    mp_printf(&mp_plat_print, "GC profile, instance %d (%s, allocation sampling 1/%u)\r\n",
+            instance+1, (prof->enabled) ? "enabled" : "disabled", prof->sample_rate);
+    mp_printf(&mp_plat_print, "Collections: %u (", prof->collections);
+    for (int i=0; i<GC_PROFILE_REASON_MAX; i++) {
+        mp_printf(&mp_plat_print, "%s%s: %u", (i) ? ", " : "", reason_names[i], prof->reasons[i]);
+    }
+    mp_printf(&mp_plat_print, ")\r\n");
+    if (prof->collections) {
+        mp_printf(&mp_plat_print, "Pause [us]: avg %u, max %u\r\n",
+                (uint32_t)(prof->pause_total / prof->collections), prof->pause_max);
+        for (int i=0; i<GC_PROFILE_PAUSE_BINS; i++) {
+            if (i < (GC_PROFILE_PAUSE_BINS-1)) mp_printf(&mp_plat_print, "  < %6u us: %u\r\n", GC_PROFILE_PAUSE_BIN0_US << i, prof->pause_hist[i]);
+            else mp_printf(&mp_plat_print, "  >=%6u us: %u\r\n", GC_PROFILE_PAUSE_BIN0_US << (i-1), prof->pause_hist[i]);
+        }
+        mp_printf(&mp_plat_print, "Scanned per collection [bytes]:");
+        for (int i=0; i<GC_PROFILE_SCAN_MAX; i++) {
+            mp_printf(&mp_plat_print, " %s %u", qstr_str(scan_qstrs[i]), (uint32_t)(prof->scanned[i] / prof->collections));
+        }
+        mp_printf(&mp_plat_print, "\r\nRecent collections:\r\n     time [ms] reason     pause [us]  roots    pystack  stacks   heap\r\n");
+        uint32_t n = (prof->collections < GC_PROFILE_RECENT) ? prof->collections : GC_PROFILE_RECENT;
+        for (uint32_t i=prof->collections-n; i<prof->collections; i++) {
+            gc_profile_collect_t *col = &prof->recent[i % GC_PROFILE_RECENT];
+            mp_printf(&mp_plat_print, "  %12u %-10s %10u", col->time, reason_names[col->reason], col->pause);
+            for (int j=0; j<GC_PROFILE_SCAN_MAX; j++) {
+                mp_printf(&mp_plat_print, " %8u", col->scanned[j]);
+            }
+            mp_printf(&mp_plat_print, "\r\n");
+        }
+    }
+    mp_printf(&mp_plat_print, "Allocations: %u, %u bytes\r\n", prof->allocs, (uint32_t)prof->alloc_bytes);
+    if (prof->allocs) {
+        for (int i=0; i<GC_PROFILE_ALLOC_BINS; i++) {
+            if (i < (GC_PROFILE_ALLOC_BINS-1)) mp_printf(&mp_plat_print, "  <= %5u: %u\r\n", GC_PROFILE_ALLOC_BIN0 << i, prof->alloc_hist[i]);
+            else mp_printf(&mp_plat_print, "  >  %5u: %u\r\n", GC_PROFILE_ALLOC_BIN0 << (i-1), prof->alloc_hist[i]);
+        }
+        mp_printf(&mp_plat_print, "Sampled allocation sites:\r\n");
+        for (int i=0; i<GC_PROFILE_SITES; i++) {
+            if (prof->sites[i].count == 0) continue;
+            mp_printf(&mp_plat_print, "  0x%p: %u allocations, %u bytes\r\n", (void *)prof->sites[i].site, prof->sites[i].count, prof->sites[i].bytes);
+        }
+        if (prof->sites_other) mp_printf(&mp_plat_print, "  other: %u allocations\r\n", prof->sites_other);
+    }
+}
+
+//-------------------------------------------------------
+static mp_obj_t uint_tuple(const uint32_t *values, int n)
+{
+    mp_obj_t items[n];
+    for (int i=0; i<n; i++) {
+        items[i] = mp_obj_new_int_from_uint(values[i]);
+    }
+    return mp_obj_new_tuple(n, items);
+}
+
+//-------------------------------------------------------------------------------------------------
+STATIC mp_obj_t mp_micropython_gc_stats(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_enable, ARG_reset, ARG_dump, ARG_sample, ARG_instance };
+    const mp_arg_t allowed_args[] = {
+        { MP_QSTR_enable,   MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_reset,    MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+        { MP_QSTR_dump,     MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+        { MP_QSTR_sample,   MP_ARG_KW_ONLY | MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_instance, MP_ARG_KW_ONLY | MP_ARG_INT,  {.u_int = 0} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    int instance = gc_instance_index();
+    if (args[ARG_instance].u_int != 0) {
+        if ((args[ARG_instance].u_int < 1) || (args[ARG_instance].u_int > ((mpy_config.config.use_two_main_tasks) ? 2 : 1))) {
+            mp_raise_ValueError("wrong instance");
+        }
+        instance = args[ARG_instance].u_int - 1;
+    }
+    gc_profile_t *prof = &gc_profile[instance];
+
+    if (args[ARG_sample].u_int > 0) prof->sample_rate = args[ARG_sample].u_int;
+    else if (prof->sample_rate == 0) prof->sample_rate = GC_PROFILE_SAMPLE_RATE;
+    if (args[ARG_reset].u_bool) gc_profile_reset(prof);
+    if (args[ARG_enable].u_obj != mp_const_none) {
+        prof->collecting = false;
+        prof->enabled = mp_obj_is_true(args[ARG_enable].u_obj);
+    }
+
+    // Work on a copy, creating the result allocates from the heap
+    gc_profile_t stats;
+    memcpy(&stats, prof, sizeof(gc_profile_t));
+    gc_profile_sort_sites(&stats);
+
+    if (args[ARG_dump].u_bool) {
+        gc_profile_dump(&stats, instance);
+        return mp_const_none;
+    }
+
+    mp_obj_t res = mp_obj_new_dict(0);
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_enabled), mp_obj_new_bool(stats.enabled));
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_instance), mp_obj_new_int(instance+1));
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_collections), mp_obj_new_int_from_uint(stats.collections));
+
+    mp_obj_t reasons = mp_obj_new_dict(0);
+    for (int i=0; i<GC_PROFILE_REASON_MAX; i++) {
+        mp_obj_dict_store(reasons, mp_obj_new_str(reason_names[i], strlen(reason_names[i])), mp_obj_new_int_from_uint(stats.reasons[i]));
+    }
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_reasons), reasons);
+
+    uint32_t pause[2] = { (stats.collections) ? (uint32_t)(stats.pause_total / stats.collections) : 0, stats.pause_max };
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_pause), uint_tuple(pause, 2));
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_pause_hist), uint_tuple(stats.pause_hist, GC_PROFILE_PAUSE_BINS));
+
+    mp_obj_t scanned = mp_obj_new_dict(0);
+    for (int i=0; i<GC_PROFILE_SCAN_MAX; i++) {
+        mp_obj_dict_store(scanned, MP_OBJ_NEW_QSTR(scan_qstrs[i]), mp_obj_new_int_from_ull(stats.scanned[i]));
+    }
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_scanned), scanned);
+
+    // Recent collections, oldest first: (time_ms, reason, pause_us, (roots, pystack, stacks, heap))
+    uint32_t n = (stats.collections < GC_PROFILE_RECENT) ? stats.collections : GC_PROFILE_RECENT;
+    mp_obj_t recent = mp_obj_new_list(0, NULL);
+    for (uint32_t i=stats.collections-n; i<stats.collections; i++) {
+        gc_profile_collect_t *col = &stats.recent[i % GC_PROFILE_RECENT];
+        mp_obj_t items[4] = {
+            mp_obj_new_int_from_uint(col->time),
+            mp_obj_new_str(reason_names[col->reason], strlen(reason_names[col->reason])),
+            mp_obj_new_int_from_uint(col->pause),
+            uint_tuple(col->scanned, GC_PROFILE_SCAN_MAX),
+        };
+        mp_obj_list_append(recent, mp_obj_new_tuple(4, items));
+    }
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_recent), recent);
+
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_allocs), mp_obj_new_int_from_uint(stats.allocs));
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_alloc_bytes), mp_obj_new_int_from_ull(stats.alloc_bytes));
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_alloc_hist), uint_tuple(stats.alloc_hist, GC_PROFILE_ALLOC_BINS));
+
+    // Sampled sites, largest first: (address, count, bytes)
+    mp_obj_t sites = mp_obj_new_list(0, NULL);
+    for (int i=0; i<GC_PROFILE_SITES; i++) {
+        if (stats.sites[i].count == 0) continue;
+        mp_obj_t items[3] = {
+            mp_obj_new_int_from_uint(stats.sites[i].site),
+            mp_obj_new_int_from_uint(stats.sites[i].count),
+            mp_obj_new_int_from_uint(stats.sites[i].bytes),
+        };
+        mp_obj_list_append(sites, mp_obj_new_tuple(3, items));
+    }
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_sites), sites);
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_sites_other), mp_obj_new_int_from_uint(stats.sites_other));
+    mp_obj_dict_store(res, MP_OBJ_NEW_QSTR(MP_QSTR_sample), mp_obj_new_int_from_uint(stats.sample_rate));
+
+    return res;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(mp_micropython_gc_stats_obj, 0, mp_micropython_gc_stats);
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * GC and allocation profiler
+ *
+ * Enabled in the build with CONFIG_MICROPY_GC_PROFILE and at run time
+ * with 'micropython.gc_stats(True)', separately for each MicroPython instance.
+ * Records the collection pause times and reasons, the number of bytes scanned
+ * for each class of roots and in the heap, and the allocation counts and sizes.
+ * Every n-th allocation is sampled and accounted to its call site (return address),
+ * the addresses can be resolved with 'addr2line' on the firmware ELF file.
+ */
+
+#ifndef _GC_PROFILE_H_
+#define _GC_PROFILE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "py/gc.h"
+
+#if MICROPY_GC_PROFILE
+
+#define GC_PROFILE_PAUSE_BINS       12  // <128 us, <256 us, ... <128 ms, >= 128 ms
+#define GC_PROFILE_PAUSE_BIN0_US    128
+#define GC_PROFILE_ALLOC_BINS       11  // <=16, <=32, ... <=8K, > 8K bytes
+#define GC_PROFILE_ALLOC_BIN0       16
+#define GC_PROFILE_SITES            32
+#define GC_PROFILE_RECENT           16  // number of last collections kept
+#define GC_PROFILE_SAMPLE_RATE      16  // default allocation sampling rate
+
+typedef struct _gc_profile_site_t {
+    uintptr_t   site;
+    uint32_t    count;
+    uint32_t    bytes;
+} gc_profile_site_t;
+
+typedef struct _gc_profile_collect_t {
+    uint32_t    time;                           // ms
+    uint32_t    pause;                          // us
+    uint8_t     reason;
+    uint32_t    scanned[GC_PROFILE_SCAN_MAX];   // bytes
+} gc_profile_collect_t;
+
+typedef struct _gc_profile_t {
+    bool                    enabled;
+    bool                    collecting;
+    uint8_t                 reason;             // reason for the next collection
+    int8_t                  scan_class;         // class of the roots being scanned
+    uint32_t                sample_rate;
+    uint32_t                sample_cnt;
+    uint64_t                t_start;
+    // collections
+    uint32_t                collections;
+    uint32_t                reasons[GC_PROFILE_REASON_MAX];
+    uint64_t                pause_total;
+    uint32_t                pause_max;
+    uint32_t                pause_hist[GC_PROFILE_PAUSE_BINS];
+    uint64_t                scanned[GC_PROFILE_SCAN_MAX];
+    gc_profile_collect_t    recent[GC_PROFILE_RECENT];
+    // allocations
+    uint32_t                allocs;
+    uint64_t                alloc_bytes;
+    uint32_t                alloc_hist[GC_PROFILE_ALLOC_BINS];
+    uint32_t                sites_other;        // sampled allocations not fitting into the sites table
+    gc_profile_site_t       sites[GC_PROFILE_SITES];
+} gc_profile_t;
+
+extern gc_profile_t gc_profile[2];
+
+void gc_profile_collect_start();
+void gc_profile_collect_end();
+
+#endif
+
+#endif
@@ -0,0 +1,630 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/mpthread.h"
+#include "mphalport.h"
+#include "ipc_channel.h"
+
+#if MICROPY_PY_THREAD
+
+// Protects the channel list and the channel reference counts,
+// it is created by mp_hal_init() before the MicroPython tasks are started
+SemaphoreHandle_t ipc_channel_mutex = NULL;
+
+static ipc_channel_t *ipc_channels = NULL;
+
+// ==== Shared channel ==========================================================
+
+/*
+ * Open the channel with the given name, create it if it does not exist
+ * If 'slot_size' or 'nslots' are 0 the existing channel parameters are used,
+ * otherwise they must match the existing channel
+ * Returns NULL if the channel does not exist and cannot be created
+ * or if the parameters don't match
+ */
+//------------------------------------------------------------------------------------
+ipc_channel_t *ipc_channel_open(const char *name, uint32_t slot_size, uint32_t nslots)
+{
+    ipc_channel_t *ch;
+
+    // Slots are 8-byte aligned
+    slot_size = (slot_size + 7) & ~7;
+
+    xSemaphoreTake(ipc_channel_mutex, portMAX_DELAY);
+    for (ch = ipc_channels; ch != NULL; ch = ch->next) {
+        if (strncmp(ch->name, name, IPC_CHANNEL_NAME_MAX) == 0) break;
+    }
+    if (ch) {
+        if (((slot_size != 0) && (slot_size != ch->slot_size)) || ((nslots != 0) && (nslots != ch->nslots))) ch = NULL;
+        else ch->refcount++;
+        xSemaphoreGive(ipc_channel_mutex);
+        return ch;
+    }
+    if (slot_size == 0) {
+        xSemaphoreGive(ipc_channel_mutex);
+        return NULL;
+    }
+    if (nslots == 0) nslots = IPC_CHANNEL_DEFAULT_SLOTS;
+
+    // Channel header, slot headers and slot data are allocated in one block
+    size_t hdr_size = (sizeof(ipc_channel_t) + 7) & ~7;
+    size_t slots_size = ((nslots * sizeof(ipc_channel_slot_t)) + 7) & ~7;
+    ch = pvPortMalloc(hdr_size + slots_size + (nslots * slot_size));
+    if (ch == NULL) {
+        xSemaphoreGive(ipc_channel_mutex);
+        return NULL;
+    }
+    memset(ch, 0, hdr_size + slots_size);
+    ch->space_sem = xSemaphoreCreateBinary();
+    ch->data_sem = xSemaphoreCreateBinary();
+    if ((ch->space_sem == NULL) || (ch->data_sem == NULL)) {
+        if (ch->space_sem) vSemaphoreDelete(ch->space_sem);
+        if (ch->data_sem) vSemaphoreDelete(ch->data_sem);
+        vPortFree(ch);
+        xSemaphoreGive(ipc_channel_mutex);
+        return NULL;
+    }
+    strncpy(ch->name, name, IPC_CHANNEL_NAME_MAX-1);
+    ch->slot_size = slot_size;
+    ch->nslots = nslots;
+    ch->refcount = 1;
+    ch->slots = (ipc_channel_slot_t *)((uint8_t *)ch + hdr_size);
+    ch->data = (uint8_t *)ch + hdr_size + slots_size;
+    // Slot 'i' is free for the writer at position 'i'
+    for (uint32_t i=0; i<nslots; i++) {
+        ch->slots[i].seq = i;
+    }
+
+    ch->next = ipc_channels;
+    ipc_channels = ch;
+    xSemaphoreGive(ipc_channel_mutex);
+    return ch;
+}
+
+// Close the channel handle, the channel is freed when the last handle is closed
+//-----------------------------------------
+void ipc_channel_close(ipc_channel_t *ch)
+{
+    xSemaphoreTake(ipc_channel_mutex, portMAX_DELAY);
+    if (ch->refcount > 0) ch->refcount--;
+    if (ch->refcount == 0) {
+        ipc_channel_t **prev = &ipc_channels;
+        while ((*prev != NULL) && (*prev != ch)) prev = &(*prev)->next;
+        if (*prev == ch) *prev = ch->next;
+        vSemaphoreDelete(ch->space_sem);
+        vSemaphoreDelete(ch->data_sem);
+        vPortFree(ch);
+    }
+    xSemaphoreGive(ipc_channel_mutex);
+}
+
+/*
+ * Claim the next free slot for writing
+ * The slot at position 'pos' is free for the writer when its sequence number equals 'pos'
+ * Returns false if all slots are in use
+ */
+//-------------------------------------------------------
+bool ipc_channel_claim(ipc_channel_t *ch, uintptr_t *pos)
+{
+    uintptr_t p = __atomic_load_n(&ch->head, __ATOMIC_RELAXED);
+    while (1) {
+        ipc_channel_slot_t *slot = &ch->slots[p % ch->nslots];
+        intptr_t dif = (intptr_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - p);
+        if (dif == 0) {
+            // on failure 'p' is updated to the current head
+            if (__atomic_compare_exchange_n(&ch->head, &p, p+1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *pos = p;
+                return true;
+            }
+        }
+        else if (dif < 0) return false;
+        else p = __atomic_load_n(&ch->head, __ATOMIC_RELAXED);
+    }
+}
+
+// Hand the claimed slot over to the reader
+//-----------------------------------------------------------------
+void ipc_channel_commit(ipc_channel_t *ch, uintptr_t pos, uint32_t len)
+{
+    ipc_channel_slot_t *slot = &ch->slots[pos % ch->nslots];
+    slot->len = len;
+    __atomic_store_n(&slot->seq, pos+1, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ch->data_waiters, __ATOMIC_RELAXED)) xSemaphoreGive(ch->data_sem);
+}
+
+/*
+ * Take the next committed slot for reading
+ * The slot at position 'pos' is committed when its sequence number equals 'pos'+1
+ * Returns false if there are no committed slots
+ */
+//------------------------------------------------------
+bool ipc_channel_take(ipc_channel_t *ch, uintptr_t *pos)
+{
+    uintptr_t p = __atomic_load_n(&ch->tail, __ATOMIC_RELAXED);
+    while (1) {
+        ipc_channel_slot_t *slot = &ch->slots[p % ch->nslots];
+        intptr_t dif = (intptr_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - (p+1));
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&ch->tail, &p, p+1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *pos = p;
+                return true;
+            }
+        }
+        else if (dif < 0) return false;
+        else p = __atomic_load_n(&ch->tail, __ATOMIC_RELAXED);
+    }
+}
+
+// Return the slot to the writer, it will be reused at position 'pos'+'nslots'
+//----------------------------------------------------------
+void ipc_channel_release(ipc_channel_t *ch, uintptr_t pos)
+{
+    ipc_channel_slot_t *slot = &ch->slots[pos % ch->nslots];
+    __atomic_store_n(&slot->seq, pos + ch->nslots, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ch->space_waiters, __ATOMIC_RELAXED)) xSemaphoreGive(ch->space_sem);
+}
+
+
+// ==== MicroPython Channel object ==============================================
+
+typedef struct _mp_obj_thread_channel_t {
+    mp_obj_base_t   base;
+    ipc_channel_t   *ch;
+    bool            claimed;    // a slot is claimed for writing
+    bool            taken;      // a slot is taken for reading
+    uint32_t        wgen;       // generation of the claimed slot, incremented on each claim
+    uint32_t        rgen;       // generation of the taken slot, incremented on each take
+    uintptr_t       wpos;
+    uintptr_t       rpos;
+} mp_obj_thread_channel_t;
+
+/*
+ * View of a claimed or taken slot
+ * The slot memory is outside the MicroPython heap and is handed over to the other
+ * side (or freed) on commit, release or close, so the view does not keep a pointer
+ * to it. The view refers to the channel object and the slot generation instead,
+ * every access checks that the slot is still held, stale views raise ValueError.
+ * Slices of a view are views of the same slot and are checked the same way.
+ */
+typedef struct _mp_obj_channel_view_t {
+    mp_obj_base_t   base;
+    mp_obj_thread_channel_t *channel;
+    uint32_t        gen;        // slot generation the view was made for
+    uint32_t        offset;     // start of the view in the slot
+    uint32_t        len;
+    bool            write;      // view of the claimed slot (writable)
+} mp_obj_channel_view_t;
+
+STATIC const mp_obj_type_t thread_channel_view_type;
+
+typedef bool (*ipc_channel_get_slot_t)(ipc_channel_t *ch, uintptr_t *pos);
+
+//--------------------------------------------------------------------
+STATIC mp_obj_thread_channel_t *thread_channel_get(mp_obj_t self_in)
+{
+    mp_obj_thread_channel_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->ch == NULL) {
+        mp_raise_ValueError("Channel closed");
+    }
+    return self;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------
+STATIC mp_obj_t thread_channel_new_view(mp_obj_thread_channel_t *channel, bool write, uint32_t offset, uint32_t len)
+{
+    mp_obj_channel_view_t *view = m_new_obj(mp_obj_channel_view_t);
+    view->base.type = &thread_channel_view_type;
+    view->channel = channel;
+    view->gen = (write) ? channel->wgen : channel->rgen;
+    view->offset = offset;
+    view->len = len;
+    view->write = write;
+    return MP_OBJ_FROM_PTR(view);
+}
+
+// Returns the view's data, or NULL if the slot was committed, released or the channel closed
+//-------------------------------------------------------------------
+STATIC uint8_t *thread_channel_view_data(mp_obj_channel_view_t *view)
+{
+    mp_obj_thread_channel_t *channel = view->channel;
+    if (channel->ch == NULL) return NULL;
+    if (view->write) {
+        if ((!channel->claimed) || (channel->wgen != view->gen)) return NULL;
+        return ipc_channel_slot_data(channel->ch, channel->wpos) + view->offset;
+    }
+    if ((!channel->taken) || (channel->rgen != view->gen)) return NULL;
+    return ipc_channel_slot_data(channel->ch, channel->rpos) + view->offset;
+}
+
+//-------------------------------------------------------------------------
+STATIC uint8_t *thread_channel_view_check(mp_obj_channel_view_t *view)
+{
+    uint8_t *data = thread_channel_view_data(view);
+    if (data == NULL) {
+        mp_raise_ValueError("Slot view is no longer valid");
+    }
+    return data;
+}
+
+//---------------------------------------------------------------------------------------------------
+STATIC void thread_channel_view_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    mp_obj_channel_view_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print, "<ChannelView %s, %u bytes%s>", (self->write) ? "rw" : "ro", self->len,
+            (thread_channel_view_data(self)) ? "" : ", invalid");
+}
+
+// A stale view has no data
+//--------------------------------------------------------------------------
+STATIC mp_obj_t thread_channel_view_unary_op(mp_unary_op_t op, mp_obj_t self_in)
+{
+    mp_obj_channel_view_t *self = MP_OBJ_TO_PTR(self_in);
+    uint32_t len = (thread_channel_view_data(self)) ? self->len : 0;
+    switch (op) {
+        case MP_UNARY_OP_BOOL: return mp_obj_new_bool(len != 0);
+        case MP_UNARY_OP_LEN: return MP_OBJ_NEW_SMALL_INT(len);
+        default: return MP_OBJ_NULL; // op not supported
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+STATIC mp_obj_t thread_channel_view_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t value)
+{
+    mp_obj_channel_view_t *self = MP_OBJ_TO_PTR(self_in);
+    if (value == MP_OBJ_NULL) {
+        // delete
+        return MP_OBJ_NULL; // op not supported
+    }
+    uint8_t *data = thread_channel_view_check(self);
+    if ((value != MP_OBJ_SENTINEL) && (!self->write)) {
+        mp_raise_TypeError("Slot view is read-only");
+    }
+    if (MP_OBJ_IS_TYPE(index_in, &mp_type_slice)) {
+        mp_bound_slice_t slice;
+        if (!mp_seq_get_fast_slice_indexes(self->len, index_in, &slice)) {
+            mp_raise_NotImplementedError("only slices with step=1 (aka None) are supported");
+        }
+        uint32_t len = slice.stop - slice.start;
+        if (value == MP_OBJ_SENTINEL) {
+            // load, the slice is a view of the same slot
+            return thread_channel_new_view(self->channel, self->write, self->offset + slice.start, len);
+        }
+        // store
+        mp_buffer_info_t bufinfo;
+        mp_get_buffer_raise(value, &bufinfo, MP_BUFFER_READ);
+        if (bufinfo.len != len) {
+            mp_raise_ValueError("Slice assignment must not change the view size");
+        }
+        memmove(data + slice.start, bufinfo.buf, len);
+        return mp_const_none;
+    }
+    size_t index = mp_get_index(self->base.type, self->len, index_in, false);
+    if (value == MP_OBJ_SENTINEL) {
+        // load
+        return MP_OBJ_NEW_SMALL_INT(data[index]);
+    }
+    // store
+    data[index] = mp_obj_get_int_truncated(value);
+    return mp_const_none;
+}
+
+// Used by the iterator
+//-----------------------------------------------------------------------------
+STATIC mp_obj_t thread_channel_view_getitem(mp_obj_t self_in, mp_obj_t index_in)
+{
+    return thread_channel_view_subscr(self_in, index_in, MP_OBJ_SENTINEL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(thread_channel_view_getitem_obj, thread_channel_view_getitem);
+
+/*
+ * The buffer is checked when it is requested. The functions using the buffer protocol
+ * use the data pointer during the call only, but an object made from the buffer,
+ * like memoryview(view), gets the raw pointer and is not checked
+ */
+//--------------------------------------------------------------------------------------------------------
+STATIC mp_int_t thread_channel_view_get_buffer(mp_obj_t self_in, mp_buffer_info_t *bufinfo, mp_uint_t flags)
+{
+    mp_obj_channel_view_t *self = MP_OBJ_TO_PTR(self_in);
+    if ((flags & MP_BUFFER_WRITE) && (!self->write)) {
+        return 1; // read-only view
+    }
+    bufinfo->buf = thread_channel_view_check(self);
+    bufinfo->len = self->len;
+    bufinfo->typecode = 'B';
+    return 0;
+}
+
+//=====================================================================
+STATIC const mp_rom_map_elem_t thread_channel_view_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___getitem__), MP_ROM_PTR(&thread_channel_view_getitem_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(thread_channel_view_locals_dict, thread_channel_view_locals_dict_table);
+
+//=================================================
+STATIC const mp_obj_type_t thread_channel_view_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_ChannelView,
+    .print = thread_channel_view_print,
+    .unary_op = thread_channel_view_unary_op,
+    .subscr = thread_channel_view_subscr,
+    .buffer_p = { .get_buffer = thread_channel_view_get_buffer },
+    .locals_dict = (mp_obj_dict_t*)&thread_channel_view_locals_dict,
+};
+
+/*
+ * Get the slot, wait for it if none is available and 'timeout' is not 0 (ms, -1 waits forever)
+ * The GIL is released while waiting and the pending events are handled
+ * at least every IPC_CHANNEL_WAIT_SLICE ms
+ */
+//---------------------------------------------------------------------------------------------------------------
+STATIC bool thread_channel_wait(ipc_channel_t *ch, bool write, mp_int_t timeout, uintptr_t *pos)
+{
+    ipc_channel_get_slot_t get_slot = (write) ? ipc_channel_claim : ipc_channel_take;
+    if (get_slot(ch, pos)) return true;
+    if (timeout == 0) return false;
+
+    uint32_t *waiters = (write) ? &ch->space_waiters : &ch->data_waiters;
+    SemaphoreHandle_t sem = (write) ? ch->space_sem : ch->data_sem;
+    mp_uint_t start = mp_hal_ticks_ms();
+    bool res = false;
+    while (1) {
+        mp_uint_t wait = IPC_CHANNEL_WAIT_SLICE;
+        if (timeout > 0) {
+            mp_uint_t elapsed = mp_hal_ticks_ms() - start;
+            if (elapsed >= (mp_uint_t)timeout) break;
+            if ((timeout - elapsed) < wait) wait = timeout - elapsed;
+        }
+        // Register as waiter before checking again, so the wake up can't be missed
+        __atomic_add_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+        res = get_slot(ch, pos);
+        if (!res) {
+            MP_THREAD_GIL_EXIT();
+            xSemaphoreTake(sem, wait / portTICK_PERIOD_MS);
+            MP_THREAD_GIL_ENTER();
+            res = get_slot(ch, pos);
+        }
+        __atomic_sub_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+        if (res) break;
+        mp_handle_pending();
+    }
+    return res;
+}
+
+//-----------------------------------------------------------------------------------------------
+STATIC void thread_channel_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    mp_obj_thread_channel_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->ch == NULL) {
+        mp_printf(print, "Channel(closed)");
+        return;
+    }
+    mp_printf(print, "Channel('%s', slot_size=%u, slots=%u)", self->ch->name, self->ch->slot_size, self->ch->nslots);
+}
+
+/*
+ * Channel(name [, slot_size, slots])
+ * Open the named channel, create it if it doesn't exist yet
+ */
+//----------------------------------------------------------------------------------------------------------------------------
+STATIC mp_obj_t thread_channel_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args)
+{
+    enum { ARG_name, ARG_slot_size, ARG_slots };
+    const mp_arg_t allowed_args[] = {
+        { MP_QSTR_name,      MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_slot_size,                   MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_slots,                       MP_ARG_INT, { .u_int = 0 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_map_t kw_args;
+    mp_map_init_fixed_table(&kw_args, n_kw, all_args + n_args);
+    mp_arg_parse_all(n_args, all_args, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    size_t name_len;
+    const char *name = mp_obj_str_get_data(args[ARG_name].u_obj, &name_len);
+    if ((name_len == 0) || (name_len >= IPC_CHANNEL_NAME_MAX)) {
+        mp_raise_ValueError("Channel name must have 1~15 characters");
+    }
+    if ((args[ARG_slot_size].u_int < 0) || (args[ARG_slots].u_int < 0) || (args[ARG_slots].u_int > IPC_CHANNEL_MAX_SLOTS)) {
+        mp_raise_ValueError("Wrong slot size or number of slots");
+    }
+
+    mp_obj_thread_channel_t *self = m_new_obj_with_finaliser(mp_obj_thread_channel_t);
+    self->base.type = &mp_thread_channel_type;
+    self->claimed = false;
+    self->taken = false;
+    self->wgen = 0;
+    self->rgen = 0;
+    self->ch = ipc_channel_open(name, args[ARG_slot_size].u_int, args[ARG_slots].u_int);
+    if (self->ch == NULL) {
+        if (args[ARG_slot_size].u_int == 0) mp_raise_ValueError("Channel does not exist");
+        mp_raise_msg(&mp_type_OSError, "Error opening channel (parameters don't match or not enough memory)");
+    }
+    return MP_OBJ_FROM_PTR(self);
+}
+
+/*
+ * Claim a free slot for writing, returns the writable view of the slot
+ * or None if no slot was available within the timeout
+ */
+//---------------------------------------------------------------------------
+STATIC mp_obj_t thread_channel_claim(size_t n_args, const mp_obj_t *args)
+{
+    mp_obj_thread_channel_t *self = thread_channel_get(args[0]);
+    mp_int_t timeout = (n_args > 1) ? mp_obj_get_int(args[1]) : -1;
+    if (self->claimed) {
+        mp_raise_ValueError("Slot already claimed");
+    }
+
+    uintptr_t pos;
+    if (!thread_channel_wait(self->ch, true, timeout, &pos)) return mp_const_none;
+
+    self->wpos = pos;
+    self->wgen++;
+    self->claimed = true;
+    return thread_channel_new_view(self, true, 0, self->ch->slot_size);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(thread_channel_claim_obj, 1, 2, thread_channel_claim);
+
+/*
+ * Commit the claimed slot, 'length' bytes are passed to the reader (whole slot by default)
+ * Committing 0 bytes discards the slot
+ */
+//----------------------------------------------------------------------------
+STATIC mp_obj_t thread_channel_commit(size_t n_args, const mp_obj_t *args)
+{
+    mp_obj_thread_channel_t *self = thread_channel_get(args[0]);
+    if (!self->claimed) {
+        mp_raise_ValueError("No slot claimed");
+    }
+    mp_int_t len = (n_args > 1) ? mp_obj_get_int(args[1]) : self->ch->slot_size;
+    if ((len < 0) || (len > self->ch->slot_size)) {
+        mp_raise_ValueError("Wrong length");
+    }
+
+    self->claimed = false;
+    ipc_channel_commit(self->ch, self->wpos, len);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(thread_channel_commit_obj, 1, 2, thread_channel_commit);
+
+/*
+ * Take the next committed slot, returns the read-only view of the slot data
+ * or None if no data was available within the timeout
+ */
+//-------------------------------------------------------------------------
+STATIC mp_obj_t thread_channel_getslot(size_t n_args, const mp_obj_t *args)
+{
+    mp_obj_thread_channel_t *self = thread_channel_get(args[0]);
+    mp_int_t timeout = (n_args > 1) ? mp_obj_get_int(args[1]) : -1;
+    if (self->taken) {
+        mp_raise_ValueError("Slot not released");
+    }
+
+    uintptr_t pos;
+    mp_uint_t start = mp_hal_ticks_ms();
+    while (1) {
+        if (!thread_channel_wait(self->ch, false, timeout, &pos)) return mp_const_none;
+        uint32_t len = ipc_channel_slot_len(self->ch, pos);
+        if (len > 0) {
+            self->rpos = pos;
+            self->rgen++;
+            self->taken = true;
+            return thread_channel_new_view(self, false, 0, len);
+        }
+        // discarded slot, skip it
+        ipc_channel_release(self->ch, pos);
+        if (timeout > 0) {
+            mp_uint_t elapsed = mp_hal_ticks_ms() - start;
+            timeout = (elapsed >= (mp_uint_t)timeout) ? 0 : (timeout - elapsed);
+            start += elapsed;
+        }
+    }
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(thread_channel_getslot_obj, 1, 2, thread_channel_getslot);
+
+// Return the taken slot to the writer
+//-------------------------------------------------------
+STATIC mp_obj_t thread_channel_release(mp_obj_t self_in)
+{
+    mp_obj_thread_channel_t *self = thread_channel_get(self_in);
+    if (!self->taken) {
+        mp_raise_ValueError("No slot taken");
+    }
+
+    self->taken = false;
+    ipc_channel_release(self->ch, self->rpos);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(thread_channel_release_obj, thread_channel_release);
+
+// Returns tuple: (slot_size, slots, slots_used)
+//----------------------------------------------------
+STATIC mp_obj_t thread_channel_info(mp_obj_t self_in)
+{
+    mp_obj_thread_channel_t *self = thread_channel_get(self_in);
+    uintptr_t head = __atomic_load_n(&self->ch->head, __ATOMIC_RELAXED);
+    uintptr_t tail = __atomic_load_n(&self->ch->tail, __ATOMIC_RELAXED);
+    mp_obj_t tuple[3];
+
+    tuple[0] = mp_obj_new_int(self->ch->slot_size);
+    tuple[1] = mp_obj_new_int(self->ch->nslots);
+    tuple[2] = mp_obj_new_int((head >= tail) ? (head - tail) : 0);
+    return mp_obj_new_tuple(3, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(thread_channel_info_obj, thread_channel_info);
+
+/*
+ * Close the channel handle
+ * A claimed slot is discarded, a taken slot is released,
+ * the views of the slots are no longer valid
+ */
+//-----------------------------------------------------
+STATIC mp_obj_t thread_channel_close(mp_obj_t self_in)
+{
+    mp_obj_thread_channel_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->ch == NULL) return mp_const_none;
+
+    if (self->claimed) {
+        self->claimed = false;
+        ipc_channel_commit(self->ch, self->wpos, 0);
+    }
+    if (self->taken) {
+        self->taken = false;
+        ipc_channel_release(self->ch, self->rpos);
+    }
+    ipc_channel_close(self->ch);
+    self->ch = NULL;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(thread_channel_close_obj, thread_channel_close);
+
+//=================================================================
+STATIC const mp_rom_map_elem_t thread_channel_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___del__),     MP_ROM_PTR(&thread_channel_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR_close),       MP_ROM_PTR(&thread_channel_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR_claim),       MP_ROM_PTR(&thread_channel_claim_obj) },
+    { MP_ROM_QSTR(MP_QSTR_commit),      MP_ROM_PTR(&thread_channel_commit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_get),         MP_ROM_PTR(&thread_channel_getslot_obj) },
+    { MP_ROM_QSTR(MP_QSTR_release),     MP_ROM_PTR(&thread_channel_release_obj) },
+    { MP_ROM_QSTR(MP_QSTR_info),        MP_ROM_PTR(&thread_channel_info_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(thread_channel_locals_dict, thread_channel_locals_dict_table);
+
+//========================================
+const mp_obj_type_t mp_thread_channel_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Channel,
+    .print = thread_channel_print,
+    .make_new = thread_channel_make_new,
+    .locals_dict = (mp_obj_dict_t*)&thread_channel_locals_dict,
+};
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Shared buffer channel for passing data between MicroPython threads
+ * and between the two MicroPython instances without copying.
+ *
+ * The channel is a ring of fixed size slots allocated on the FreeRTOS heap
+ * and registered by name, so both instances can open the same channel.
+ * The sender claims a free slot, fills it in place and commits it,
+ * the receiver takes the committed slot, reads it in place and releases it.
+ * Slot ownership is handed over using the slot sequence numbers only
+ * (bounded MPMC queue), no locks are taken on the data path.
+ * The semaphores are only used to wake up the blocked tasks.
+ * In MicroPython the slot is accessed through a ChannelView object, valid until
+ * the slot is committed or released or the channel is closed. The view and its
+ * slices check the slot on every access and raise ValueError when it is stale.
+ * The pointer obtained from the view's buffer (e.g. memoryview(view))
+ * is not checked and must not be kept after commit() or release().
+ */
+
+#ifndef _IPC_CHANNEL_H_
+#define _IPC_CHANNEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#include "py/obj.h"
+
+#define IPC_CHANNEL_NAME_MAX        16
+#define IPC_CHANNEL_MAX_SLOTS       64
+#define IPC_CHANNEL_DEFAULT_SLOTS   4
+#define IPC_CHANNEL_WAIT_SLICE      10  // ms, maximal time between checks of the pending events while blocked
+
+typedef struct _ipc_channel_slot_t {
+    uintptr_t           seq;            // slot sequence number
+    uint32_t            len;            // committed data length
+} ipc_channel_slot_t;
+
+typedef struct _ipc_channel_t {
+    struct _ipc_channel_t *next;
+    char                name[IPC_CHANNEL_NAME_MAX];
+    uint32_t            slot_size;
+    uint32_t            nslots;
+    uint32_t            refcount;       // number of open handles, protected by 'ipc_channel_mutex'
+    uintptr_t           head;           // next position to claim for writing
+    uintptr_t           tail;           // next position to take for reading
+    uint32_t            space_waiters;  // number of tasks waiting for a free slot
+    uint32_t            data_waiters;   // number of tasks waiting for a committed slot
+    SemaphoreHandle_t   space_sem;
+    SemaphoreHandle_t   data_sem;
+    ipc_channel_slot_t  *slots;
+    uint8_t             *data;
+} __attribute__((aligned(8))) ipc_channel_t;
+
+extern SemaphoreHandle_t ipc_channel_mutex;
+extern const mp_obj_type_t mp_thread_channel_type;
+
+ipc_channel_t *ipc_channel_open(const char *name, uint32_t slot_size, uint32_t nslots);
+void ipc_channel_close(ipc_channel_t *ch);
+bool ipc_channel_claim(ipc_channel_t *ch, uintptr_t *pos);
+void ipc_channel_commit(ipc_channel_t *ch, uintptr_t pos, uint32_t len);
+bool ipc_channel_take(ipc_channel_t *ch, uintptr_t *pos);
+void ipc_channel_release(ipc_channel_t *ch, uintptr_t pos);
+
+//--------------------------------------------------------------------------------
+static inline uint8_t *ipc_channel_slot_data(ipc_channel_t *ch, uintptr_t pos)
+{
+    return ch->data + ((pos % ch->nslots) * ch->slot_size);
+}
+
+//--------------------------------------------------------------------------------
+static inline uint32_t ipc_channel_slot_len(ipc_channel_t *ch, uintptr_t pos)
+{
+    return ch->slots[pos % ch->nslots].len;
+}
+
+#endif
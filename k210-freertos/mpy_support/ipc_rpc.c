@@ -0,0 +1,597 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/builtin.h"
+#include "py/mperrno.h"
+#include "py/mpthread.h"
+#include "mphalport.h"
+#include "modmachine.h"
+#include "ipc_rpc.h"
+#include "ipc_rpc_codec.h"
+
+#if MICROPY_PY_THREAD
+
+// Created by mp_hal_init() in two MicroPython instances mode
+QueueHandle_t ipc_rpc_queue = NULL;
+ipc_rpc_stats_t ipc_rpc_stats = { 0 };
+
+// ==== Serialization ===========================================================
+
+/*
+ * Serialize the object (or the array of 'n' objects if 'n' > 1)
+ * to the buffer allocated on FreeRTOS heap
+ * The size is calculated in the first pass, the data is written in the second one
+ */
+//---------------------------------------------------------------------
+STATIC uint8_t *rpc_encode(size_t n, const mp_obj_t *objs, uint32_t *len)
+{
+    size_t size = ipc_rpc_encode(NULL, n, objs);
+    uint8_t *buf = pvPortMalloc(size);
+    if (buf == NULL) {
+        mp_raise_msg(&mp_type_MemoryError, "Error allocating RPC data buffer");
+    }
+    *len = ipc_rpc_encode(buf, n, objs);
+    return buf;
+}
+
+
+// ==== Call handling ===========================================================
+
+// Check if running in the second MicroPython instance (main task or its threads)
+//---------------------------------
+STATIC bool ipc_rpc_in_instance2()
+{
+    return ((MainTaskHandle2 != NULL) &&
+            (pvTaskGetThreadLocalStoragePointer(NULL, THREAD_LSP_STATE) == pvTaskGetThreadLocalStoragePointer(MainTaskHandle2, THREAD_LSP_STATE)));
+}
+
+//------------------------------------------------
+STATIC void ipc_rpc_call_unref(ipc_rpc_call_t *call)
+{
+    if (__atomic_sub_fetch(&call->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        vSemaphoreDelete(call->done_sem);
+        if (call->args) vPortFree(call->args);
+        if (call->result) vPortFree(call->result);
+        vPortFree(call);
+    }
+}
+
+// Set the final state of the call which was not started and wake up the caller
+//------------------------------------------------------------------
+STATIC bool ipc_rpc_call_abort(ipc_rpc_call_t *call, uint32_t state)
+{
+    uint32_t expected = IPC_RPC_STATE_PENDING;
+    if (!__atomic_compare_exchange_n(&call->state, &expected, state, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) return false;
+    xSemaphoreGive(call->done_sem);
+    return true;
+}
+
+//---------------------------------------------------------
+STATIC void ipc_rpc_set_busy(bool busy)
+{
+    xSemaphoreTake(inter_proc_mutex, portMAX_DELAY);
+    task_ipc.busy = busy;
+    xSemaphoreGive(inter_proc_mutex);
+}
+
+//----------------------------------
+STATIC mp_obj_t ipc_rpc_get_cache()
+{
+    if (MP_STATE_PORT(ipc_rpc_cache) == MP_OBJ_NULL) {
+        MP_STATE_PORT(ipc_rpc_cache) = mp_obj_new_dict(0);
+    }
+    return MP_STATE_PORT(ipc_rpc_cache);
+}
+
+/*
+ * Get the function from the cache, import it on first use
+ * for 'module.function' or 'package.module.function' names the module is imported,
+ * names without module are searched in the main module and in the built-ins.
+ * Only the imported functions and the functions added by rpc_register() are cached,
+ * the names without module are looked up on every call, so a function defined
+ * again in the main module (or deleted from it) is not taken from a stale cache.
+ */
+//-----------------------------------------------------
+STATIC mp_obj_t ipc_rpc_get_function(const char *name)
+{
+    mp_obj_t cache = ipc_rpc_get_cache();
+    mp_obj_t key = MP_OBJ_NEW_QSTR(qstr_from_str(name));
+    mp_map_elem_t *elem = mp_map_lookup(mp_obj_dict_get_map(cache), key, MP_MAP_LOOKUP);
+    if (elem) return elem->value;
+
+    mp_obj_t fun = MP_OBJ_NULL;
+    const char *dot = strchr(name, '.');
+    bool imported = (dot != NULL);
+    if (imported) {
+        // Import the top level module and get the attributes,
+        // the package submodules which are not imported yet are imported
+        fun = mp_import_name(qstr_from_strn(name, dot - name), mp_const_none, MP_OBJ_NEW_SMALL_INT(0));
+        while (dot) {
+            const char *part = dot + 1;
+            dot = strchr(part, '.');
+            size_t len = (dot) ? (dot - part) : strlen(part);
+            qstr attr = qstr_from_strn(part, len);
+            mp_obj_t dest[2];
+            mp_load_method_maybe(fun, attr, dest);
+            if (dest[0] == MP_OBJ_NULL) {
+                if (!mp_obj_is_type(fun, &mp_type_module)) fun = mp_load_attr(fun, attr); // raises AttributeError
+                nlr_buf_t nlr;
+                if (nlr_push(&nlr) == 0) {
+                    fun = mp_import_name(qstr_from_strn(name, (part + len) - name), mp_const_true, MP_OBJ_NEW_SMALL_INT(0));
+                    nlr_pop();
+                }
+                else {
+                    nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_AttributeError, "RPC function '%s' not found", name));
+                }
+            }
+            else if (dest[1] != MP_OBJ_NULL) fun = mp_load_attr(fun, attr);
+            else fun = dest[0];
+        }
+    }
+    else {
+        elem = mp_map_lookup(&MP_STATE_VM(dict_main).map, key, MP_MAP_LOOKUP);
+        if (elem == NULL) elem = mp_map_lookup((mp_map_t *)&mp_module_builtins.globals->map, key, MP_MAP_LOOKUP);
+        if (elem == NULL) {
+            nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_NameError, "name '%s' isn't defined", name));
+        }
+        fun = elem->value;
+    }
+    if (!mp_obj_is_callable(fun)) {
+        mp_raise_TypeError("RPC function is not callable");
+    }
+    if (imported) mp_obj_dict_store(cache, key, fun);
+    return fun;
+}
+
+// Serialize the exception as [exception name, message]
+//-------------------------------------------------------------------
+STATIC void ipc_rpc_set_error(ipc_rpc_call_t *call, mp_obj_t exc)
+{
+    if (call->result) {
+        vPortFree(call->result);
+        call->result = NULL;
+    }
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        vstr_t vstr;
+        mp_print_t print;
+        vstr_init_print(&vstr, 32, &print);
+        mp_obj_print_helper(&print, exc, PRINT_STR);
+        mp_obj_t err[2];
+        err[0] = MP_OBJ_NEW_QSTR(mp_obj_get_type(exc)->name);
+        err[1] = mp_obj_new_str_from_vstr(&mp_type_str, &vstr);
+        call->result = rpc_encode(2, err, &call->result_len);
+        nlr_pop();
+    }
+    // if the error could not be serialized the result stays empty
+}
+
+//--------------------------------------------------
+STATIC void ipc_rpc_execute(ipc_rpc_call_t *call)
+{
+    uint32_t state = IPC_RPC_STATE_DONE;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_t fun = ipc_rpc_get_function(call->func);
+        // [args, kwargs]
+        mp_obj_t *call_args;
+        mp_obj_get_array_fixed_n(ipc_rpc_decode(call->args, call->args_len), 2, &call_args);
+        size_t n_args, n_kw;
+        mp_obj_t *args;
+        mp_obj_get_array(call_args[0], &n_args, &args);
+        mp_map_t *kw_map = mp_obj_dict_get_map(call_args[1]);
+        n_kw = kw_map->used;
+
+        mp_obj_t res;
+        if (n_kw == 0) res = mp_call_function_n_kw(fun, n_args, 0, args);
+        else {
+            mp_obj_t *all_args = m_new(mp_obj_t, n_args + (n_kw * 2));
+            memcpy(all_args, args, n_args * sizeof(mp_obj_t));
+            size_t idx = n_args;
+            for (size_t i=0; i<kw_map->alloc; i++) {
+                if (mp_map_slot_is_filled(kw_map, i)) {
+                    all_args[idx++] = kw_map->table[i].key;
+                    all_args[idx++] = kw_map->table[i].value;
+                }
+            }
+            res = mp_call_function_n_kw(fun, n_args, n_kw, all_args);
+        }
+        call->result = rpc_encode(1, &res, &call->result_len);
+        nlr_pop();
+    }
+    else {
+        state = IPC_RPC_STATE_ERROR;
+        ipc_rpc_set_error(call, MP_OBJ_FROM_PTR(nlr.ret_val));
+    }
+
+    call->t_end = mp_hal_shared_ticks_us();
+    __atomic_store_n(&call->state, state, __ATOMIC_RELEASE);
+    xSemaphoreGive(call->done_sem);
+
+    // Update statistics
+    uint64_t exec_us = call->t_end - call->t_start;
+    uint64_t latency_us = call->t_end - call->t_submit;
+    __atomic_add_fetch(&ipc_rpc_stats.calls, 1, __ATOMIC_RELAXED);
+    if (state == IPC_RPC_STATE_ERROR) __atomic_add_fetch(&ipc_rpc_stats.errors, 1, __ATOMIC_RELAXED);
+    ipc_rpc_stats.exec_us += exec_us;
+    ipc_rpc_stats.latency_us += latency_us;
+    if (exec_us > ipc_rpc_stats.exec_max_us) ipc_rpc_stats.exec_max_us = exec_us;
+    if (latency_us > ipc_rpc_stats.latency_max_us) ipc_rpc_stats.latency_max_us = latency_us;
+}
+
+/*
+ * Run all queued calls
+ * Executed from the second MicroPython instance main loop
+ */
+//=====================
+void ipc_rpc_process()
+{
+    if (ipc_rpc_queue == NULL) return;
+
+    ipc_rpc_call_t *call;
+    while (xQueueReceive(ipc_rpc_queue, &call, 0) == pdTRUE) {
+        uint64_t now = mp_hal_shared_ticks_us();
+        if ((call->deadline != 0) && (now > call->deadline)) {
+            if (ipc_rpc_call_abort(call, IPC_RPC_STATE_EXPIRED)) __atomic_add_fetch(&ipc_rpc_stats.expired, 1, __ATOMIC_RELAXED);
+        }
+        else {
+            uint32_t expected = IPC_RPC_STATE_PENDING;
+            // the call may have been cancelled while in the queue
+            if (__atomic_compare_exchange_n(&call->state, &expected, IPC_RPC_STATE_RUNNING, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                call->t_start = now;
+                ipc_rpc_set_busy(true);
+                ipc_rpc_execute(call);
+                ipc_rpc_set_busy(false);
+            }
+        }
+        ipc_rpc_call_unref(call);
+    }
+}
+
+
+// ==== MicroPython objects =====================================================
+
+typedef struct _mp_obj_rpc_future_t {
+    mp_obj_base_t   base;
+    ipc_rpc_call_t  *call;
+    mp_obj_t        value;      // deserialized result
+} mp_obj_rpc_future_t;
+
+// Wait for the call to finish, 'timeout' in ms, -1 waits forever
+//-----------------------------------------------------------------------
+STATIC bool rpc_future_wait(ipc_rpc_call_t *call, mp_int_t timeout)
+{
+    mp_uint_t start = mp_hal_ticks_ms();
+    while (__atomic_load_n(&call->state, __ATOMIC_ACQUIRE) < IPC_RPC_STATE_DONE) {
+        mp_uint_t wait = IPC_RPC_WAIT_SLICE;
+        if (timeout >= 0) {
+            mp_uint_t elapsed = mp_hal_ticks_ms() - start;
+            if (elapsed >= (mp_uint_t)timeout) return false;
+            if ((timeout - elapsed) < wait) wait = timeout - elapsed;
+        }
+        MP_THREAD_GIL_EXIT();
+        xSemaphoreTake(call->done_sem, wait / portTICK_PERIOD_MS);
+        MP_THREAD_GIL_ENTER();
+        mp_handle_pending();
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------
+STATIC mp_obj_rpc_future_t *rpc_future_get(mp_obj_t self_in)
+{
+    mp_obj_rpc_future_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->call == NULL) {
+        mp_raise_ValueError("RPC call not submitted");
+    }
+    return self;
+}
+
+//--------------------------------------------------------------------------------------------
+STATIC void rpc_future_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    static const char *state_names[] = { "pending", "running", "done", "error", "cancelled", "expired" };
+    mp_obj_rpc_future_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->call == NULL) {
+        mp_printf(print, "RpcFuture(not submitted)");
+        return;
+    }
+    mp_printf(print, "RpcFuture('%s', %s)", self->call->func, state_names[__atomic_load_n(&self->call->state, __ATOMIC_ACQUIRE)]);
+}
+
+//-----------------------------------------------------
+STATIC mp_obj_t rpc_future_done(mp_obj_t self_in)
+{
+    mp_obj_rpc_future_t *self = rpc_future_get(self_in);
+    return mp_obj_new_bool(__atomic_load_n(&self->call->state, __ATOMIC_ACQUIRE) >= IPC_RPC_STATE_DONE);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(rpc_future_done_obj, rpc_future_done);
+
+/*
+ * Wait for the call to finish and return its result
+ * The exception raised by the remote function is raised again,
+ * exceptions which are not built-in are raised as RuntimeError
+ */
+//--------------------------------------------------------------------
+STATIC mp_obj_t rpc_future_result(size_t n_args, const mp_obj_t *args)
+{
+    mp_obj_rpc_future_t *self = rpc_future_get(args[0]);
+    mp_int_t timeout = (n_args > 1) ? mp_obj_get_int(args[1]) : -1;
+    if (self->value != MP_OBJ_NULL) return self->value;
+
+    ipc_rpc_call_t *call = self->call;
+    if (!rpc_future_wait(call, timeout)) {
+        mp_raise_OSError(MP_ETIMEDOUT);
+    }
+
+    switch (call->state) {
+        case IPC_RPC_STATE_DONE:
+            self->value = ipc_rpc_decode(call->result, call->result_len);
+            return self->value;
+        case IPC_RPC_STATE_CANCELLED:
+            mp_raise_msg(&mp_type_RuntimeError, "RPC call cancelled");
+        case IPC_RPC_STATE_EXPIRED:
+            mp_raise_msg(&mp_type_OSError, "RPC call not started before timeout");
+    }
+
+    if (call->result == NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, "RPC call failed");
+    }
+    mp_obj_t *err;
+    mp_obj_get_array_fixed_n(ipc_rpc_decode(call->result, call->result_len), 2, &err);
+    size_t name_len;
+    const char *name = mp_obj_str_get_data(err[0], &name_len);
+    qstr name_qstr = qstr_find_strn(name, name_len);
+    if (name_qstr != MP_QSTRnull) {
+        mp_map_elem_t *elem = mp_map_lookup((mp_map_t *)&mp_module_builtins.globals->map, MP_OBJ_NEW_QSTR(name_qstr), MP_MAP_LOOKUP);
+        if ((elem) && (mp_obj_is_type(elem->value, &mp_type_type)) &&
+                (mp_obj_is_subclass_fast(elem->value, MP_OBJ_FROM_PTR(&mp_type_BaseException)))) {
+            nlr_raise(mp_obj_new_exception_arg1(MP_OBJ_TO_PTR(elem->value), err[1]));
+        }
+    }
+    nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_RuntimeError, "%s: %s", name, mp_obj_str_get_str(err[1])));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(rpc_future_result_obj, 1, 2, rpc_future_result);
+
+// Cancel the call if it was not started yet
+//-----------------------------------------------------
+STATIC mp_obj_t rpc_future_cancel(mp_obj_t self_in)
+{
+    mp_obj_rpc_future_t *self = rpc_future_get(self_in);
+    if (!ipc_rpc_call_abort(self->call, IPC_RPC_STATE_CANCELLED)) return mp_const_false;
+    __atomic_add_fetch(&ipc_rpc_stats.cancelled, 1, __ATOMIC_RELAXED);
+    return mp_const_true;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(rpc_future_cancel_obj, rpc_future_cancel);
+
+// Returns tuple: (queued_us, exec_us, total_us), None if the call was not executed
+//----------------------------------------------------
+STATIC mp_obj_t rpc_future_stats(mp_obj_t self_in)
+{
+    mp_obj_rpc_future_t *self = rpc_future_get(self_in);
+    ipc_rpc_call_t *call = self->call;
+    uint32_t state = __atomic_load_n(&call->state, __ATOMIC_ACQUIRE);
+    if ((state != IPC_RPC_STATE_DONE) && (state != IPC_RPC_STATE_ERROR)) return mp_const_none;
+
+    mp_obj_t tuple[3];
+    tuple[0] = mp_obj_new_int_from_ull(call->t_start - call->t_submit);
+    tuple[1] = mp_obj_new_int_from_ull(call->t_end - call->t_start);
+    tuple[2] = mp_obj_new_int_from_ull(call->t_end - call->t_submit);
+    return mp_obj_new_tuple(3, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(rpc_future_stats_obj, rpc_future_stats);
+
+//-----------------------------------------------------
+STATIC mp_obj_t rpc_future_del(mp_obj_t self_in)
+{
+    mp_obj_rpc_future_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->call) {
+        ipc_rpc_call_unref(self->call);
+        self->call = NULL;
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(rpc_future_del_obj, rpc_future_del);
+
+//=================================================================
+STATIC const mp_rom_map_elem_t rpc_future_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___del__),     MP_ROM_PTR(&rpc_future_del_obj) },
+    { MP_ROM_QSTR(MP_QSTR_done),        MP_ROM_PTR(&rpc_future_done_obj) },
+    { MP_ROM_QSTR(MP_QSTR_result),      MP_ROM_PTR(&rpc_future_result_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cancel),      MP_ROM_PTR(&rpc_future_cancel_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stats),       MP_ROM_PTR(&rpc_future_stats_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(rpc_future_locals_dict, rpc_future_locals_dict_table);
+
+//========================================
+const mp_obj_type_t mp_thread_rpc_future_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_RpcFuture,
+    .print = rpc_future_print,
+    .locals_dict = (mp_obj_dict_t*)&rpc_future_locals_dict,
+};
+
+/*
+ * rpc_call(func [, args, kwargs, timeout])
+ * Submit the call to the second MicroPython instance, returns the future object
+ * 'timeout' (ms) limits the time to wait for the free queue entry,
+ * the call is not started if the timeout expires while it is in the queue
+ */
+//--------------------------------------------------------------------------------------------
+STATIC mp_obj_t mod_thread_rpc_call(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_func, ARG_args, ARG_kwargs, ARG_timeout };
+    const mp_arg_t allowed_args[] = {
+        { MP_QSTR_func,    MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_args,                      MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_kwargs,                    MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_timeout,                   MP_ARG_INT, { .u_int = -1 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if ((!mpy_config.config.use_two_main_tasks) || (ipc_rpc_queue == NULL)) {
+        mp_raise_NotImplementedError("Not available in single MicroPython instance mode");
+    }
+    if (ipc_rpc_in_instance2()) {
+        mp_raise_NotImplementedError("Not available in the second MicroPython instance");
+    }
+
+    size_t name_len;
+    const char *name = mp_obj_str_get_data(args[ARG_func].u_obj, &name_len);
+    if ((name_len == 0) || (name_len >= IPC_RPC_NAME_MAX)) {
+        mp_raise_ValueError("Function name must have 1~47 characters");
+    }
+    mp_obj_t call_args[2];
+    call_args[0] = (args[ARG_args].u_obj == mp_const_none) ? mp_const_empty_tuple : args[ARG_args].u_obj;
+    call_args[1] = (args[ARG_kwargs].u_obj == mp_const_none) ? mp_obj_new_dict(0) : args[ARG_kwargs].u_obj;
+    if ((!mp_obj_is_type(call_args[0], &mp_type_tuple)) && (!mp_obj_is_type(call_args[0], &mp_type_list))) {
+        mp_raise_TypeError("args must be tuple or list");
+    }
+    if (!mp_obj_is_type(call_args[1], &mp_type_dict)) {
+        mp_raise_TypeError("kwargs must be dict");
+    }
+    mp_int_t timeout = args[ARG_timeout].u_int;
+
+    mp_obj_rpc_future_t *self = m_new_obj_with_finaliser(mp_obj_rpc_future_t);
+    self->base.type = &mp_thread_rpc_future_type;
+    self->call = NULL;
+    self->value = MP_OBJ_NULL;
+
+    ipc_rpc_call_t *call = pvPortMalloc(sizeof(ipc_rpc_call_t));
+    if (call == NULL) {
+        mp_raise_msg(&mp_type_MemoryError, "Error allocating RPC call");
+    }
+    memset(call, 0, sizeof(ipc_rpc_call_t));
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        call->args = rpc_encode(2, call_args, &call->args_len);
+        nlr_pop();
+    }
+    else {
+        vPortFree(call);
+        nlr_jump(nlr.ret_val);
+    }
+    strcpy(call->func, name);
+    call->state = IPC_RPC_STATE_PENDING;
+    call->refcount = 1;
+    call->done_sem = xSemaphoreCreateBinaryStatic(&call->done_sem_buf);
+    call->t_submit = mp_hal_shared_ticks_us();
+    if (timeout >= 0) call->deadline = call->t_submit + (timeout * 1000);
+    self->call = call;
+
+    // Wait for the free queue entry
+    mp_uint_t start = mp_hal_ticks_ms();
+    while (1) {
+        mp_uint_t wait = IPC_RPC_WAIT_SLICE;
+        bool last = false;
+        if (timeout >= 0) {
+            mp_uint_t elapsed = mp_hal_ticks_ms() - start;
+            if ((elapsed + wait) >= (mp_uint_t)timeout) {
+                wait = (elapsed >= (mp_uint_t)timeout) ? 0 : (timeout - elapsed);
+                last = true;
+            }
+        }
+        // the queue holds a reference
+        __atomic_add_fetch(&call->refcount, 1, __ATOMIC_ACQ_REL);
+        MP_THREAD_GIL_EXIT();
+        BaseType_t res = xQueueSend(ipc_rpc_queue, &call, wait / portTICK_PERIOD_MS);
+        MP_THREAD_GIL_ENTER();
+        if (res == pdTRUE) break;
+        __atomic_sub_fetch(&call->refcount, 1, __ATOMIC_ACQ_REL);
+
+        if (last) {
+            __atomic_add_fetch(&ipc_rpc_stats.rejected, 1, __ATOMIC_RELAXED);
+            rpc_future_del(MP_OBJ_FROM_PTR(self));
+            mp_raise_msg(&mp_type_OSError, "RPC queue full");
+        }
+        mp_handle_pending();
+    }
+    // Wake up the second instance main loop
+    mp_thread_sendmsg_to_mpy2(THREAD_MSG_TYPE_INTEGER, THREAD_IPC_TYPE_RPC, NULL, 0);
+
+    return MP_OBJ_FROM_PTR(self);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(mod_thread_rpc_call_obj, 1, mod_thread_rpc_call);
+
+/*
+ * rpc_register(name [, func])
+ * Executed in the second instance, add the function to the cache under the given name,
+ * remove it from the cache if 'func' is None or clear the cache if 'name' is None
+ */
+//----------------------------------------------------------------------------
+STATIC mp_obj_t mod_thread_rpc_register(size_t n_args, const mp_obj_t *args)
+{
+    if (!ipc_rpc_in_instance2()) {
+        mp_raise_NotImplementedError("Only available in the second MicroPython instance");
+    }
+    if (args[0] == mp_const_none) {
+        MP_STATE_PORT(ipc_rpc_cache) = MP_OBJ_NULL;
+        return mp_const_none;
+    }
+
+    mp_obj_t cache = ipc_rpc_get_cache();
+    mp_obj_t key = MP_OBJ_NEW_QSTR(mp_obj_str_get_qstr(args[0]));
+    if ((n_args > 1) && (args[1] != mp_const_none)) {
+        if (!mp_obj_is_callable(args[1])) {
+            mp_raise_TypeError("Function expected");
+        }
+        mp_obj_dict_store(cache, key, args[1]);
+    }
+    else {
+        mp_map_lookup(mp_obj_dict_get_map(cache), key, MP_MAP_LOOKUP_REMOVE_IF_FOUND);
+    }
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_thread_rpc_register_obj, 1, 2, mod_thread_rpc_register);
+
+/*
+ * Returns tuple: (calls, errors, expired, cancelled, rejected,
+ *                 exec_avg_us, exec_max_us, latency_avg_us, latency_max_us)
+ */
+//-------------------------------------
+STATIC mp_obj_t mod_thread_rpc_stats()
+{
+    ipc_rpc_stats_t stats = ipc_rpc_stats;
+    mp_obj_t tuple[9];
+
+    tuple[0] = mp_obj_new_int(stats.calls);
+    tuple[1] = mp_obj_new_int(stats.errors);
+    tuple[2] = mp_obj_new_int(stats.expired);
+    tuple[3] = mp_obj_new_int(stats.cancelled);
+    tuple[4] = mp_obj_new_int(stats.rejected);
+    tuple[5] = mp_obj_new_int_from_ull((stats.calls) ? stats.exec_us / stats.calls : 0);
+    tuple[6] = mp_obj_new_int_from_ull(stats.exec_max_us);
+    tuple[7] = mp_obj_new_int_from_ull((stats.calls) ? stats.latency_us / stats.calls : 0);
+    tuple[8] = mp_obj_new_int_from_ull(stats.latency_max_us);
+    return mp_obj_new_tuple(9, tuple);
+}
+MP_DEFINE_CONST_FUN_OBJ_0(mod_thread_rpc_stats_obj, mod_thread_rpc_stats);
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Remote function calls from the main MicroPython instance
+ * to the second MicroPython instance
+ *
+ * The caller submits the module qualified function name and the arguments
+ * serialized in CBOR ('ipc_rpc_codec.c') to a bounded FreeRTOS queue
+ * and gets the future object.
+ * The second instance imports the function once and keeps it in its cache,
+ * runs the calls in its main loop and posts the serialized result
+ * or exception back to the call structure.
+ * The call structures and the serialized data are allocated on the FreeRTOS heap.
+ */
+
+#ifndef _IPC_RPC_H_
+#define _IPC_RPC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "py/obj.h"
+
+#define IPC_RPC_QUEUE_LENGTH    8
+#define IPC_RPC_NAME_MAX        48
+#define IPC_RPC_WAIT_SLICE      10  // ms, maximal time between checks of the pending events while blocked
+
+// Call states
+#define IPC_RPC_STATE_PENDING   0
+#define IPC_RPC_STATE_RUNNING   1
+#define IPC_RPC_STATE_DONE      2
+#define IPC_RPC_STATE_ERROR     3
+#define IPC_RPC_STATE_CANCELLED 4
+#define IPC_RPC_STATE_EXPIRED   5
+
+typedef struct _ipc_rpc_call_t {
+    uint32_t            state;
+    uint32_t            refcount;       // the caller's future and the queue/executor
+    char                func[IPC_RPC_NAME_MAX];
+    uint8_t             *args;          // [args, kwargs]
+    uint32_t            args_len;
+    uint8_t             *result;        // result or [exception name, message]
+    uint32_t            result_len;
+    uint64_t            deadline;       // us, the call is not started after it, 0: no deadline
+    uint64_t            t_submit;       // us, time stamps from mp_hal_shared_ticks_us()
+    uint64_t            t_start;
+    uint64_t            t_end;
+    SemaphoreHandle_t   done_sem;
+    StaticSemaphore_t   done_sem_buf;
+} __attribute__((aligned(8))) ipc_rpc_call_t;
+
+typedef struct _ipc_rpc_stats_t {
+    uint32_t            calls;          // executed calls
+    uint32_t            errors;         // calls which raised an exception
+    uint32_t            expired;
+    uint32_t            cancelled;
+    uint32_t            rejected;       // not submitted, queue full
+    uint64_t            exec_us;        // total and maximal execution time
+    uint64_t            exec_max_us;
+    uint64_t            latency_us;     // total and maximal time from submit to result
+    uint64_t            latency_max_us;
+} __attribute__((aligned(8))) ipc_rpc_stats_t;
+
+extern QueueHandle_t ipc_rpc_queue;
+extern ipc_rpc_stats_t ipc_rpc_stats;
+
+extern const mp_obj_type_t mp_thread_rpc_future_type;
+MP_DECLARE_CONST_FUN_OBJ_KW(mod_thread_rpc_call_obj);
+MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(mod_thread_rpc_register_obj);
+MP_DECLARE_CONST_FUN_OBJ_0(mod_thread_rpc_stats_obj);
+
+void ipc_rpc_process();
+
+#endif
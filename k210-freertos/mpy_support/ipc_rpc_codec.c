@@ -0,0 +1,407 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/objarray.h"
+#include "py/objtuple.h"
+#include "py/binary.h"
+#include "ipc_rpc_codec.h"
+
+#if MODULE_ULAB_ENABLED
+#include "standard_lib/ulab/ndarray.h"
+#endif
+
+// RFC 8746 typed array tags (little endian) and the matching array typecodes
+STATIC const uint8_t rpc_typed_tags[] = { 64, 72, 69, 77, 70, 78, 71, 79, 85, 86 };
+STATIC const char rpc_typed_codes[] = "BbHhIiLlfd";
+
+typedef struct _rpc_enc_t {
+    uint8_t     *buf;       // NULL: only count the size
+    size_t      len;
+    int         depth;
+} rpc_enc_t;
+
+typedef struct _rpc_dec_t {
+    const uint8_t   *p;
+    const uint8_t   *end;
+    int             depth;
+} rpc_dec_t;
+
+// Typed array tag for the array typecode, 0 if not supported
+//--------------------------------------------
+STATIC int rpc_typed_array_tag(char typecode)
+{
+    if (typecode == 'f') return 85;
+    if (typecode == 'd') return 86;
+    if ((typecode == 0) || (strchr("bBhHiIlLqQ", typecode) == NULL)) return 0;
+    int tag = ((typecode >= 'a') && (typecode <= 'z')) ? 72 : 64;
+    switch (mp_binary_get_size('@', typecode, NULL)) {
+        case 1: return tag;
+        case 2: return tag + 5;
+        case 4: return tag + 6;
+        case 8: return tag + 7;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------
+STATIC void rpc_enc_put(rpc_enc_t *enc, const void *data, size_t len)
+{
+    if (enc->buf) memcpy(enc->buf + enc->len, data, len);
+    enc->len += len;
+}
+
+// Item head, the major type and the argument in the shortest form
+//-------------------------------------------------------------------
+STATIC void rpc_enc_head(rpc_enc_t *enc, uint8_t major, uint64_t val)
+{
+    uint8_t head[9];
+    int n;
+    if (val < 24) {
+        head[0] = (major << 5) | val;
+        n = 1;
+    }
+    else if (val <= 0xFF) {
+        head[0] = (major << 5) | 24;
+        n = 2;
+    }
+    else if (val <= 0xFFFF) {
+        head[0] = (major << 5) | 25;
+        n = 3;
+    }
+    else if (val <= 0xFFFFFFFF) {
+        head[0] = (major << 5) | 26;
+        n = 5;
+    }
+    else {
+        head[0] = (major << 5) | 27;
+        n = 9;
+    }
+    for (int i=n-1; i>0; i--) {
+        head[i] = val & 0xFF;
+        val >>= 8;
+    }
+    rpc_enc_put(enc, head, n);
+}
+
+//------------------------------------------------------------
+STATIC void rpc_enc_typed(rpc_enc_t *enc, mp_obj_array_t *arr)
+{
+    size_t nbytes = arr->len * mp_binary_get_size('@', arr->typecode, NULL);
+    rpc_enc_head(enc, 6, rpc_typed_array_tag(arr->typecode));
+    rpc_enc_head(enc, 2, nbytes);
+    rpc_enc_put(enc, arr->items, nbytes);
+}
+
+//--------------------------------------------------
+STATIC void rpc_enc_obj(rpc_enc_t *enc, mp_obj_t obj)
+{
+    if (enc->depth >= IPC_RPC_MAX_DEPTH) {
+        mp_raise_ValueError("RPC data nested too deep");
+    }
+
+    if (obj == mp_const_none) rpc_enc_head(enc, 7, 22);
+    else if (obj == mp_const_false) rpc_enc_head(enc, 7, 20);
+    else if (obj == mp_const_true) rpc_enc_head(enc, 7, 21);
+    else if (mp_obj_is_int(obj)) {
+        mp_int_t val = mp_obj_get_int(obj);
+        if (val >= 0) rpc_enc_head(enc, 0, val);
+        else rpc_enc_head(enc, 1, -1 - val);
+    }
+    #if MICROPY_PY_BUILTINS_FLOAT
+    else if (mp_obj_is_float(obj)) {
+        // always the 8-byte form
+        double val = mp_obj_get_float(obj);
+        uint64_t bits;
+        uint8_t data[9];
+        memcpy(&bits, &val, 8);
+        data[0] = (7 << 5) | 27;
+        for (int i=8; i>0; i--) {
+            data[i] = bits & 0xFF;
+            bits >>= 8;
+        }
+        rpc_enc_put(enc, data, 9);
+    }
+    #endif
+    else if (mp_obj_is_str(obj)) {
+        size_t len;
+        const char *str = mp_obj_str_get_data(obj, &len);
+        rpc_enc_head(enc, 3, len);
+        rpc_enc_put(enc, str, len);
+    }
+    else if ((mp_obj_is_type(obj, &mp_type_tuple)) || (mp_obj_is_type(obj, &mp_type_list))) {
+        size_t len;
+        mp_obj_t *items;
+        mp_obj_get_array(obj, &len, &items);
+        rpc_enc_head(enc, 4, len);
+        enc->depth++;
+        for (size_t i=0; i<len; i++) {
+            rpc_enc_obj(enc, items[i]);
+        }
+        enc->depth--;
+    }
+    else if (mp_obj_is_type(obj, &mp_type_dict)) {
+        mp_map_t *map = mp_obj_dict_get_map(obj);
+        rpc_enc_head(enc, 5, map->used);
+        enc->depth++;
+        for (size_t i=0; i<map->alloc; i++) {
+            if (mp_map_slot_is_filled(map, i)) {
+                rpc_enc_obj(enc, map->table[i].key);
+                rpc_enc_obj(enc, map->table[i].value);
+            }
+        }
+        enc->depth--;
+    }
+    #if MODULE_ULAB_ENABLED
+    else if (mp_obj_is_type(obj, &ulab_ndarray_type)) {
+        // Multi-dimensional array: [[rows, columns], typed array]
+        ndarray_obj_t *ndarray = MP_OBJ_TO_PTR(obj);
+        rpc_enc_head(enc, 6, 40);
+        rpc_enc_head(enc, 4, 2);
+        rpc_enc_head(enc, 4, 2);
+        rpc_enc_head(enc, 0, ndarray->m);
+        rpc_enc_head(enc, 0, ndarray->n);
+        rpc_enc_typed(enc, ndarray->array);
+    }
+    #endif
+    else if ((mp_obj_is_type(obj, &mp_type_array)) && (rpc_typed_array_tag(((mp_obj_array_t *)MP_OBJ_TO_PTR(obj))->typecode))) {
+        rpc_enc_typed(enc, MP_OBJ_TO_PTR(obj));
+    }
+    else {
+        // bytes, bytearray, memoryview or any other object with buffer protocol
+        mp_buffer_info_t bufinfo;
+        if (!mp_get_buffer(obj, &bufinfo, MP_BUFFER_READ)) {
+            nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_TypeError, "can't serialize '%s' object", mp_obj_get_type_str(obj)));
+        }
+        rpc_enc_head(enc, 2, bufinfo.len);
+        rpc_enc_put(enc, bufinfo.buf, bufinfo.len);
+    }
+}
+
+/*
+ * Serialize the object (or the array of 'n' objects if 'n' > 1) to 'buf'
+ * Returns the serialized length, only the length is calculated if 'buf' is NULL
+ */
+//-------------------------------------------------------------------------
+size_t ipc_rpc_encode(uint8_t *buf, size_t n, const mp_obj_t *objs)
+{
+    rpc_enc_t enc = { buf, 0, 0 };
+
+    if (n > 1) rpc_enc_head(&enc, 4, n);
+    for (size_t i=0; i<n; i++) {
+        rpc_enc_obj(&enc, objs[i]);
+    }
+    return enc.len;
+}
+
+//---------------------------------
+STATIC NORETURN void rpc_dec_error()
+{
+    mp_raise_ValueError("RPC data error");
+}
+
+//---------------------------------------------------------------------------
+STATIC uint64_t rpc_dec_head(rpc_dec_t *dec, uint8_t *major, uint8_t *info)
+{
+    if (dec->p >= dec->end) rpc_dec_error();
+    *major = *dec->p >> 5;
+    *info = *dec->p & 0x1F;
+    dec->p++;
+    if (*info < 24) return *info;
+    // indefinite length items are not used
+    if (*info > 27) rpc_dec_error();
+
+    int n = 1 << (*info - 24);
+    if ((dec->end - dec->p) < n) rpc_dec_error();
+    uint64_t val = 0;
+    for (int i=0; i<n; i++) {
+        val = (val << 8) | *dec->p++;
+    }
+    return val;
+}
+
+//-------------------------------------------------------------------
+STATIC const uint8_t *rpc_dec_data(rpc_dec_t *dec, uint64_t len)
+{
+    if ((uint64_t)(dec->end - dec->p) < len) rpc_dec_error();
+    const uint8_t *data = dec->p;
+    dec->p += len;
+    return data;
+}
+
+/*
+ * Typed array data as array.array
+ * or as ulab ndarray if the dimensions are given ('rows' > 0)
+ */
+//----------------------------------------------------------------------------------------
+STATIC mp_obj_t rpc_dec_typed(rpc_dec_t *dec, char typecode, uint64_t rows, uint64_t cols)
+{
+    uint8_t major, info;
+    uint64_t nbytes = rpc_dec_head(dec, &major, &info);
+    if (major != 2) rpc_dec_error();
+    const uint8_t *data = rpc_dec_data(dec, nbytes);
+    size_t size = mp_binary_get_size('@', typecode, NULL);
+    if ((nbytes % size) != 0) rpc_dec_error();
+    size_t len = nbytes / size;
+    if ((rows > 0) && ((rows > len) || (cols > len) || ((rows * cols) != len))) rpc_dec_error();
+
+    #if MODULE_ULAB_ENABLED
+    if ((rows > 0) && (len > 0) && ((typecode == NDARRAY_UINT8) || (typecode == NDARRAY_INT8) ||
+            (typecode == NDARRAY_UINT16) || (typecode == NDARRAY_INT16) || (typecode == NDARRAY_FLOAT))) {
+        ndarray_obj_t *ndarray = create_new_ndarray(rows, cols, typecode);
+        memcpy(ndarray->array->items, data, nbytes);
+        return MP_OBJ_FROM_PTR(ndarray);
+    }
+    #endif
+    mp_obj_array_t *arr = m_new_obj(mp_obj_array_t);
+    arr->base.type = &mp_type_array;
+    arr->typecode = typecode;
+    arr->free = 0;
+    arr->len = len;
+    arr->items = m_new(byte, nbytes);
+    memcpy(arr->items, data, nbytes);
+    return MP_OBJ_FROM_PTR(arr);
+}
+
+//----------------------------------------------
+STATIC char rpc_typed_array_typecode(uint64_t tag)
+{
+    for (int i=0; i<sizeof(rpc_typed_tags); i++) {
+        if (rpc_typed_tags[i] == tag) return rpc_typed_codes[i];
+    }
+    return 0;
+}
+
+STATIC mp_obj_t rpc_dec_obj(rpc_dec_t *dec);
+
+//------------------------------------------------------------
+STATIC mp_obj_t rpc_dec_tagged(rpc_dec_t *dec, uint64_t tag)
+{
+    uint8_t major, info;
+    char typecode;
+
+    if (tag == 40) {
+        // Multi-dimensional array: [[dimensions], typed array]
+        uint64_t dims[2];
+        if ((rpc_dec_head(dec, &major, &info) != 2) || (major != 4)) rpc_dec_error();
+        uint64_t ndims = rpc_dec_head(dec, &major, &info);
+        if ((major != 4) || (ndims < 1) || (ndims > 2)) rpc_dec_error();
+        for (int i=0; i<ndims; i++) {
+            dims[i] = rpc_dec_head(dec, &major, &info);
+            if ((major != 0) || (dims[i] == 0)) rpc_dec_error();
+        }
+        if (ndims == 1) {
+            dims[1] = dims[0];
+            dims[0] = 1;
+        }
+        tag = rpc_dec_head(dec, &major, &info);
+        typecode = rpc_typed_array_typecode(tag);
+        if ((major != 6) || (typecode == 0)) rpc_dec_error();
+        return rpc_dec_typed(dec, typecode, dims[0], dims[1]);
+    }
+    typecode = rpc_typed_array_typecode(tag);
+    if (typecode) return rpc_dec_typed(dec, typecode, 0, 0);
+    // Unknown tag, use the tagged item
+    return rpc_dec_obj(dec);
+}
+
+//-------------------------------------------
+STATIC mp_obj_t rpc_dec_obj(rpc_dec_t *dec)
+{
+    if (dec->depth >= IPC_RPC_MAX_DEPTH) rpc_dec_error();
+
+    uint8_t major, info;
+    uint64_t val = rpc_dec_head(dec, &major, &info);
+    const uint8_t *data;
+    mp_obj_t obj;
+
+    switch (major) {
+        case 0:
+            return mp_obj_new_int_from_ull(val);
+        case 1:
+            if (val > INT64_MAX) rpc_dec_error();
+            return mp_obj_new_int_from_ll(-1 - (int64_t)val);
+        case 2:
+            data = rpc_dec_data(dec, val);
+            return mp_obj_new_bytes(data, val);
+        case 3:
+            data = rpc_dec_data(dec, val);
+            return mp_obj_new_str((const char *)data, val);
+        case 4:
+            // every item is at least one byte long
+            if (val > (uint64_t)(dec->end - dec->p)) rpc_dec_error();
+            obj = mp_obj_new_tuple(val, NULL);
+            dec->depth++;
+            for (size_t i=0; i<val; i++) {
+                ((mp_obj_tuple_t *)MP_OBJ_TO_PTR(obj))->items[i] = rpc_dec_obj(dec);
+            }
+            dec->depth--;
+            return obj;
+        case 5:
+            if (val > (uint64_t)((dec->end - dec->p) / 2)) rpc_dec_error();
+            obj = mp_obj_new_dict(val);
+            dec->depth++;
+            for (size_t i=0; i<val; i++) {
+                mp_obj_t key = rpc_dec_obj(dec);
+                mp_obj_dict_store(obj, key, rpc_dec_obj(dec));
+            }
+            dec->depth--;
+            return obj;
+        case 6:
+            return rpc_dec_tagged(dec, val);
+        case 7:
+            if (info == 20) return mp_const_false;
+            if (info == 21) return mp_const_true;
+            if ((info == 22) || (info == 23)) return mp_const_none;
+            #if MICROPY_PY_BUILTINS_FLOAT
+            if (info == 26) {
+                uint32_t bits = val;
+                float fval;
+                memcpy(&fval, &bits, 4);
+                return mp_obj_new_float(fval);
+            }
+            if (info == 27) {
+                double dval;
+                memcpy(&dval, &val, 8);
+                return mp_obj_new_float(dval);
+            }
+            #endif
+            break;
+    }
+    rpc_dec_error();
+}
+
+// Deserialize the data, raises ValueError if it is not valid
+//-----------------------------------------------------------
+mp_obj_t ipc_rpc_decode(const uint8_t *data, size_t len)
+{
+    rpc_dec_t dec = { data, data + len, 0 };
+    mp_obj_t obj = rpc_dec_obj(&dec);
+    if (dec.p != dec.end) rpc_dec_error();
+    return obj;
+}
@@ -0,0 +1,52 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Serialization of the remote call arguments and results
+ *
+ * CBOR (RFC 7049) subset: integers, floats (decoded from the 4 and 8-byte forms,
+ * always encoded in the 8-byte form), None, booleans, strings, bytes, lists (tuples
+ * are encoded as lists and decoded as tuples) and dictionaries.
+ * array.array objects are encoded as RFC 8746 typed arrays, ulab ndarrays as
+ * RFC 8746 multi-dimensional arrays (tag 40) and keep their shape and type.
+ * Any other object with the buffer protocol is encoded as bytes.
+ * The codec does not depend on the OS and is also built for the host tests.
+ */
+
+#ifndef _IPC_RPC_CODEC_H_
+#define _IPC_RPC_CODEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "py/obj.h"
+
+#define IPC_RPC_MAX_DEPTH       16
+
+size_t ipc_rpc_encode(uint8_t *buf, size_t n, const mp_obj_t *objs);
+mp_obj_t ipc_rpc_decode(const uint8_t *data, size_t len);
+
+#endif
@@ -417,28 +417,23 @@ bool check_app_sha256(uint32_t address)
 //------------------------------------------------------
 uint32_t calc_app_crc32(uint32_t address, uint32_t size)
 {
-    uint32_t crc = 0xFFFFFFFF;
-    uint8_t byte;
-    //uint32_t mask;
-
-    w25qxx_enable_xip_mode();
+    // The data is read into an aligned RAM buffer, the word loads of hal_crc32()
+    // are not used on the XIP mapped flash
+    uint8_t __attribute__((aligned(8))) buffer[1024];
+    uint32_t crc = 0;
+    uint32_t idx = address + 5;
+    uint32_t sz;
 
     // Read from flash and update CRC32 value
-    for (uint32_t n = 5; n < (size+5); n++) {
-        byte = w25qxx_flash_ptr[address + n];
-        crc = (crc >> 8) ^ Crc32LookupTable[(crc & 0xFF) ^ byte];
-        /*
-        crc = crc ^ byte;
-        for (uint32_t j = 0; j < 8; j++) {
-            mask = -(crc & 1);
-            crc = (crc >> 1) ^ (0xEDB88320 & mask);
-        }
-        */
+    while (size > 0) {
+        sz = (size >= sizeof(buffer)) ? sizeof(buffer) : size;
+        if (w25qxx_read_data(idx, buffer, sz) != W25QXX_OK) return 0;
+        crc = hal_crc32(buffer, sz, crc);
+        idx += sz;
+        size -= sz;
     }
 
-    w25qxx_disable_xip_mode();
-
-    return (~crc);
+    return crc;
 }
 
 // Check the firmware's CRC32 value
@@ -74,10 +74,107 @@ STATIC int compare_times(const void * item, const void * parent) {
 	return ret;
 }
 
-//---------------------------------------------
-STATIC void sort_items(mp_obj_utimeq_t *heap) {
-	sort_asc = heap->ascending;
-    qsort(&heap->items, heap->len, sizeof(struct qentry), compare_times);
+// The queue is kept as a binary heap, items[0] is always the first entry
+// in the sort order (lowest time if ascending, highest if descending)
+// Entries with the same time are ordered by the entry id
+//-----------------------------------------------------------------------------------
+STATIC bool heap_before(mp_obj_utimeq_t *heap, struct qentry *item, struct qentry *parent) {
+    mp_int_t res = parent->time - item->time;
+    if (res == 0) res = parent->id - item->id;
+    return (heap->ascending) ? (res > 0) : (res < 0);
+}
+
+//----------------------------------------------------------------
+STATIC void heap_sift_up(mp_obj_utimeq_t *heap, mp_uint_t pos) {
+    struct qentry item = heap->items[pos];
+    while (pos > 0) {
+        mp_uint_t parent = (pos - 1) >> 1;
+        if (!heap_before(heap, &item, &heap->items[parent])) break;
+        heap->items[pos] = heap->items[parent];
+        pos = parent;
+    }
+    heap->items[pos] = item;
+}
+
+//------------------------------------------------------------------
+STATIC void heap_sift_down(mp_obj_utimeq_t *heap, mp_uint_t pos) {
+    struct qentry item = heap->items[pos];
+    mp_uint_t child;
+    while ((child = (pos << 1) + 1) < heap->len) {
+        if (((child + 1) < heap->len) && heap_before(heap, &heap->items[child + 1], &heap->items[child])) child++;
+        if (!heap_before(heap, &heap->items[child], &item)) break;
+        heap->items[pos] = heap->items[child];
+        pos = child;
+    }
+    heap->items[pos] = item;
+}
+
+// Remove the entry at heap position 'pos'
+//-------------------------------------------------------------
+STATIC void heap_remove(mp_obj_utimeq_t *heap, mp_uint_t pos) {
+    heap->len--;
+    if (pos < heap->len) {
+        heap->items[pos] = heap->items[heap->len];
+        if ((pos > 0) && heap_before(heap, &heap->items[pos], &heap->items[(pos - 1) >> 1])) heap_sift_up(heap, pos);
+        else heap_sift_down(heap, pos);
+    }
+    // we don't want to retain a pointers !
+    memset(&heap->items[heap->len], 0, sizeof(struct qentry));
+}
+
+// Maximal number of candidates kept on the stack by heap_get_nth()
+#define UTIMEQ_NTH_CANDIDATES   32
+
+// Get the entry at position 'pos' in the sort order, nothing is allocated
+// For the first positions the candidates for the next entry in order are kept
+// in a small heap of indexes on the stack, only 'pos' entries are visited.
+// For the higher positions the next entry in order is searched 'pos' times.
+//-------------------------------------------------------------------------
+STATIC struct qentry *heap_get_nth(mp_obj_utimeq_t *heap, mp_uint_t pos) {
+    if (pos == 0) return &heap->items[0];
+
+    if (pos >= UTIMEQ_NTH_CANDIDATES) {
+        struct qentry *item = &heap->items[0];
+        for (mp_uint_t n = 0; n < pos; n++) {
+            struct qentry *next = NULL;
+            for (mp_uint_t i = 1; i < heap->len; i++) {
+                if (heap_before(heap, item, &heap->items[i]) && ((next == NULL) || heap_before(heap, &heap->items[i], next))) {
+                    next = &heap->items[i];
+                }
+            }
+            item = next;
+        }
+        return item;
+    }
+
+    // each step removes one candidate and adds at most two, at most pos+1 are used
+    mp_uint_t cand[UTIMEQ_NTH_CANDIDATES];
+    mp_uint_t n_cand = 1;
+    mp_uint_t idx, i, child;
+    cand[0] = 0;
+    for (mp_uint_t n = 0; n < pos; n++) {
+        // remove the first candidate
+        idx = cand[0];
+        n_cand--;
+        i = 0;
+        while ((child = (i << 1) + 1) < n_cand) {
+            if (((child + 1) < n_cand) && heap_before(heap, &heap->items[cand[child + 1]], &heap->items[cand[child]])) child++;
+            if (!heap_before(heap, &heap->items[cand[child]], &heap->items[cand[n_cand]])) break;
+            cand[i] = cand[child];
+            i = child;
+        }
+        cand[i] = cand[n_cand];
+        // add its children as candidates
+        for (child = (idx << 1) + 1; (child <= ((idx << 1) + 2)) && (child < heap->len); child++) {
+            i = n_cand++;
+            while ((i > 0) && heap_before(heap, &heap->items[child], &heap->items[cand[(i - 1) >> 1]])) {
+                cand[i] = cand[(i - 1) >> 1];
+                i = (i - 1) >> 1;
+            }
+            cand[i] = child;
+        }
+    }
+    return &heap->items[cand[0]];
 }
 
 //----------------------------------------------------------------------------------------------------------------
@@ -123,14 +220,16 @@ STATIC mp_obj_t mod_utimeq_heappush(size_t n_args, const mp_obj_t *args) {
     else itime = mp_obj_get_int(args[1]);
 
     heap->items[l].time = itime;
-    heap->items[l].id = utimeq_id++;
+    mp_uint_t id = utimeq_id++;
+    heap->items[l].id = id;
     heap->items[l].callback = args[2];
     heap->items[l].args = args[3];
     heap->len++;
 
-    sort_items(heap);
+    heap_sift_up(heap, l);
 
-    return mp_const_none;
+    // return the entry id, can be used to cancel the entry
+    return mp_obj_new_int_from_ull(id);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_utimeq_heappush_obj, 4, 4, mod_utimeq_heappush);
 
@@ -150,19 +249,29 @@ STATIC mp_obj_t mod_utimeq_heappop(mp_obj_t heap_in, mp_obj_t list_ref) {
     ret->items[1] = item->callback;
     ret->items[2] = item->args;
 
-    heap->len -= 1;
-
-    if (heap->len) {
-    	memmove(&heap->items[0], &heap->items[1], sizeof(struct qentry) * heap->len);
-        //sort_items(heap);
-        // we don't want to retain a pointers !
-        memset(&heap->items[heap->len], 0, sizeof(struct qentry));
-    }
+    heap_remove(heap, 0);
 
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_utimeq_heappop_obj, mod_utimeq_heappop);
 
+// Remove the entry with the given id from the queue
+// Returns True if the entry was found
+//-------------------------------------------------------------------
+STATIC mp_obj_t mod_utimeq_cancel(mp_obj_t heap_in, mp_obj_t id_in) {
+    mp_obj_utimeq_t *heap = get_heap(heap_in);
+    mp_uint_t id = mp_obj_get_int(id_in);
+
+    for (mp_uint_t i = 0; i < heap->len; i++) {
+        if (heap->items[i].id == id) {
+            heap_remove(heap, i);
+            return mp_const_true;
+        }
+    }
+    return mp_const_false;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_utimeq_cancel_obj, mod_utimeq_cancel);
+
 //-----------------------------------------------------------------------------------------
 STATIC mp_obj_t mod_utimeq_heappeek(mp_obj_t heap_in, mp_obj_t idx_in, mp_obj_t list_ref) {
     mp_obj_utimeq_t *heap = get_heap(heap_in);
@@ -178,7 +287,7 @@ STATIC mp_obj_t mod_utimeq_heappeek(mp_obj_t heap_in, mp_obj_t idx_in, mp_obj_t
         mp_raise_TypeError(NULL);
     }
 
-    struct qentry *item = &heap->items[pos];
+    struct qentry *item = heap_get_nth(heap, pos);
     ret->items[0] = mp_obj_new_int_from_ll(item->time);
     ret->items[1] = item->callback;
     ret->items[2] = item->args;
@@ -201,7 +310,7 @@ STATIC mp_obj_t mod_utimeq_peektime(size_t n_args, const mp_obj_t *args) {
             nlr_raise(mp_obj_new_exception_msg(&mp_type_IndexError, "wrong heap index"));
     	}
     }
-    struct qentry *item = &heap->items[pos];
+    struct qentry *item = heap_get_nth(heap, pos);
     return mp_obj_new_int_from_ll(item->time);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_utimeq_peektime_obj, 1, 2, mod_utimeq_peektime);
@@ -226,15 +335,22 @@ STATIC mp_obj_t mod_utimeq_dump(size_t n_args, const mp_obj_t *args) {
     if (n_args == 2) {
     	if ( mp_obj_is_true(args[1])) maxlen = heap->alloc;
     }
+    // entries are printed in sorted order, sort the copy of the queue
+    struct qentry *items = m_new(struct qentry, heap->alloc);
+    memcpy(items, heap->items, sizeof(struct qentry) * heap->alloc);
+    sort_asc = heap->ascending;
+    qsort(items, heap->len, sizeof(struct qentry), compare_times);
+
     mp_printf(&mp_plat_print, "%4s%21s%10s%12s%12s\n", "Idx", "Time", "ID", "Callback", "Arg");
     mp_printf(&mp_plat_print, "-----------------------------------------------------------\n");
     for (int i = 0; i < maxlen; i++) {
-        mp_printf(&mp_plat_print, "%4d%21lld%10u%12p%12p", i, heap->items[i].time, heap->items[i].id,
-            MP_OBJ_TO_PTR(heap->items[i].callback), MP_OBJ_TO_PTR(heap->items[i].args));
+        mp_printf(&mp_plat_print, "%4d%21lld%10u %11p %11p", i, items[i].time, items[i].id,
+            MP_OBJ_TO_PTR(items[i].callback), MP_OBJ_TO_PTR(items[i].args));
         if (i >= heap->len) mp_printf(&mp_plat_print, "  (empty)\n");
         else mp_printf(&mp_plat_print, "\n");
     }
     mp_printf(&mp_plat_print, "-----------------------------------------------------------\n");
+    m_del(struct qentry, items, heap->alloc);
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_utimeq_dump_obj, 1, 2, mod_utimeq_dump);
@@ -253,6 +369,7 @@ STATIC mp_obj_t utimeq_unary_op(mp_unary_op_t op, mp_obj_t self_in) {
 STATIC const mp_rom_map_elem_t utimeq_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_push),     MP_ROM_PTR(&mod_utimeq_heappush_obj) },
     { MP_ROM_QSTR(MP_QSTR_pop),      MP_ROM_PTR(&mod_utimeq_heappop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cancel),   MP_ROM_PTR(&mod_utimeq_cancel_obj) },
     { MP_ROM_QSTR(MP_QSTR_peek),     MP_ROM_PTR(&mod_utimeq_heappeek_obj) },
     { MP_ROM_QSTR(MP_QSTR_peektime), MP_ROM_PTR(&mod_utimeq_peektime_obj) },
     { MP_ROM_QSTR(MP_QSTR_len),      MP_ROM_PTR(&mod_utimeq_len_obj) },
@@ -246,6 +246,11 @@ extern uint32_t _ram_end;
 // define which file system is used
 #define MICRO_PY_FLASHFS_USED                   (CONFIG_MICROPY_FILESYSTEM_TYPE)
 
+// The first sector after the file system is used to save the map of erased file system sectors
+// If enabled, the map is saved on reset and loaded on file system mount
+#define MICRO_PY_FLASH_ERASED_MAP_ADDR          (MICRO_PY_FLASHFS_START_ADDRESS + MICRO_PY_FLASHFS_SIZE)
+#define MICRO_PY_FLASH_SAVE_ERASED_MAP          (1)
+
 #define MICRO_PY_FLASH_CONFIG_START             (MICRO_PY_FLASHFS_START_ADDRESS + MICRO_PY_FLASHFS_SIZE + MICRO_PY_FLASH_ERASE_SECTOR_SIZE*2)
 #define MICRO_PY_FLASH_CONFIG_SIZE              (4096)
 
@@ -423,6 +428,12 @@ extern const struct _mp_print_t mp_debug_print;
 #define MICROPY_DEBUG_PRINTERS                  (0)
 #define MICROPY_ENABLE_GC                       (1) // !do not change!
 #define MICROPY_GC_ALLOC_THRESHOLD              (1) // !do not change!
+#define MICROPY_GC_ADAPTIVE_THRESHOLD           (1)
+#ifdef CONFIG_MICROPY_GC_PROFILE
+#define MICROPY_GC_PROFILE                      (1)
+#else
+#define MICROPY_GC_PROFILE                      (0)
+#endif
 #define MICROPY_REPL_EVENT_DRIVEN               (0)
 #define MICROPY_MALLOC_USES_ALLOCATED_SIZE      (0)
 #define MICROPY_HELPER_REPL                     (1)
@@ -596,6 +607,16 @@ extern const struct _mp_print_t mp_debug_print;
 #else
 #define MICROPY_USE_CAMERA                      (0)
 #endif
+#ifdef CONFIG_MICROPY_USE_IMAGE
+#define MICROPY_USE_IMAGE                       (1)
+#else
+#define MICROPY_USE_IMAGE                       (0)
+#endif
+#if defined(CONFIG_MICROPY_USE_KPU) && MICROPY_K210_KPU_USED
+#define MICROPY_USE_KPU                         (1)
+#else
+#define MICROPY_USE_KPU                         (0)
+#endif
 
 #ifdef CONFIG_MICROPY_PY_USE_ULAB
 #define MODULE_ULAB_ENABLED                     (1)
@@ -744,6 +765,20 @@ extern const struct _mp_obj_module_t mp_module_camera;
 #define BUILTIN_MODULE_CAMERA
 #endif
 
+#if MICROPY_USE_IMAGE
+extern const struct _mp_obj_module_t mp_module_image;
+#define BUILTIN_MODULE_IMAGE { MP_OBJ_NEW_QSTR(MP_QSTR_image), (mp_obj_t)&mp_module_image },
+#else
+#define BUILTIN_MODULE_IMAGE
+#endif
+
+#if MICROPY_USE_KPU
+extern const struct _mp_obj_module_t mp_module_kpu;
+#define BUILTIN_MODULE_KPU { MP_OBJ_NEW_QSTR(MP_QSTR_kpu), (mp_obj_t)&mp_module_kpu },
+#else
+#define BUILTIN_MODULE_KPU
+#endif
+
 #if MICROPY_PY_UTIMEQ_K210
 extern const struct _mp_obj_module_t mp_module_utimeq;
 #define BUILTIN_MODULE_UTIMEQ_K210 { MP_OBJ_NEW_QSTR(MP_QSTR_utimeq), (mp_obj_t)&mp_module_utimeq },
@@ -790,6 +825,8 @@ extern const struct _mp_obj_module_t ota_module;
     BUILTIN_MODULE_UCRYPTOLIB_K210 \
     BUILTIN_MODULE_DISPLAY \
     BUILTIN_MODULE_CAMERA \
+    BUILTIN_MODULE_IMAGE \
+    BUILTIN_MODULE_KPU \
     BUILTIN_MODULE_UTIMEQ_K210 \
     BUILTIN_MODULE_SQLITE \
     BUILTIN_MODULE_TEST \
@@ -811,6 +848,7 @@ extern const struct _mp_obj_module_t ota_module;
 #define MP_STATE_PORT MP_STATE_VM
 
 #define MICROPY_PORT_ROOT_POINTERS \
-    const char *readline_hist[32];
+    const char *readline_hist[32]; \
+    mp_obj_t ipc_rpc_cache;
 
 #endif
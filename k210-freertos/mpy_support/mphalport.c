@@ -52,6 +52,9 @@
 #include "mpthreadport.h"
 #include "modmachine.h"
 #include "machine_uart.h"
+#include "ipc_channel.h"
+#include "ipc_rpc.h"
+#include "clint.h"
 
 
 static handle_t mpy_wdt = 0;
@@ -112,6 +115,14 @@ mp_uint_t sys_ticks_us(void)
     return system_useconds;
 }
 
+// Time base shared by both processors (mcycle is per core),
+// used to compare the time stamps taken by the two MicroPython instances
+//------------------------------------
+mp_uint_t mp_hal_shared_ticks_us(void)
+{
+    return (clint->mtime * CLINT_CLOCK_DIV) / system_cpu_frequency;
+}
+
 //-----------------------------
 mp_uint_t mp_hal_ticks_ms(void)
 {
@@ -387,12 +398,18 @@ void mp_hal_init(void)
         mp_hal_uart_semaphore = xSemaphoreCreateBinary();
         configASSERT(mp_hal_uart_semaphore);
     }
+    if (ipc_channel_mutex == NULL) {
+        ipc_channel_mutex = xSemaphoreCreateMutex();
+        configASSERT(ipc_channel_mutex);
+    }
     if (mpy_config.config.use_two_main_tasks) {
         if (inter_proc_mutex == NULL) {
             inter_proc_mutex = xSemaphoreCreateMutex();
             configASSERT(inter_proc_mutex);
             inter_proc_semaphore = xSemaphoreCreateBinary();
             configASSERT(inter_proc_semaphore);
+            ipc_rpc_queue = xQueueCreate(IPC_RPC_QUEUE_LENGTH, sizeof(ipc_rpc_call_t *));
+            configASSERT(ipc_rpc_queue);
         }
     }
 
@@ -97,6 +97,7 @@ int mp_hal_send_file_block(uint8_t *buff, int size, bool docrc, int fsize);
 
 mp_uint_t mp_hal_ticks_cpu(void);
 mp_uint_t mp_hal_ticks_us(void);
+mp_uint_t mp_hal_shared_ticks_us(void);
 mp_uint_t mp_hal_ticks_ms(void);
 
 void mp_hal_usdelay(uint16_t us);
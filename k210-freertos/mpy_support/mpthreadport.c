@@ -214,12 +214,17 @@ int mp_thread_gc_others() {
 
         // get the thread's MP state
         state = (mp_state_ctx_t *)pvTaskGetThreadLocalStoragePointer(th->id, THREAD_LSP_STATE);
+        // each thread counts its own allocations, restart counting for all threads
+        state->mem.gc_alloc_amount = 0;
 
         // === Mark the root pointers on thread
         ptrs = (void**)(void*)state;
         root_start = (void *)&state->thread.dict_locals - (void *)state;
         root_end = (void *)&state->vm.qstr_last_chunk - (void *)state;
         DEBUG_GC_printf("  root pointers (%p [%p]) [%lu,%lu]\r\n", state, ptrs + root_start / sizeof(void*), root_start, root_end);
+        #if MICROPY_GC_PROFILE
+        gc_profile_scan_class(GC_PROFILE_SCAN_ROOTS);
+        #endif
         gc_collect_root(ptrs + root_start / sizeof(void*), (root_end - root_start) / sizeof(void*));
 
         void *args = pvTaskGetThreadLocalStoragePointer(th->id, THREAD_LSP_ARGS);
@@ -232,12 +237,18 @@ int mp_thread_gc_others() {
 
         if (mpy_config.config.pystack_enabled) {
             // === Mark the pointers on thread pystack
+            #if MICROPY_GC_PROFILE
+            gc_profile_scan_class(GC_PROFILE_SCAN_PYSTACK);
+            #endif
             ptrs = (void**)(void*)state->thread.pystack_start;
             gc_collect_root(ptrs, (state->thread.pystack_cur - state->thread.pystack_start) / sizeof(void*));
         }
 
         // === Mark the pointers on thread stack
         DEBUG_GC_printf("  stack\r\n");
+        #if MICROPY_GC_PROFILE
+        gc_profile_scan_class(GC_PROFILE_SCAN_STACK);
+        #endif
         void *sp = (void *)pxTaskGetStackTop(th->id);
         ptrs = (void**)(void*)sp;
         gc_collect_root(ptrs, ((void *)state->thread.stack_top - sp) / sizeof(void*));
@@ -246,6 +257,27 @@ int mp_thread_gc_others() {
     return n_th;
 }
 
+// Set the allocation threshold (in blocks) of all threads
+// of the running MicroPython instance and restart counting the allocations
+//-----------------------------------------------
+void mp_thread_set_gc_threshold(size_t threshold)
+{
+    mp_state_ctx_t *state;
+
+    MP_STATE_MEM(gc_alloc_threshold) = threshold;
+    MP_STATE_MEM(gc_alloc_amount) = 0;
+
+    mp_lock_thread_mutex();
+    for (thread_t *th = thread; th != NULL; th = th->next) {
+        if (!th->ready) continue;
+        if ((th->type != THREAD_TYPE_PYTHON) && (th->type != THREAD_TYPE_MAIN)) continue;
+        state = (mp_state_ctx_t *)pvTaskGetThreadLocalStoragePointer(th->id, THREAD_LSP_STATE);
+        state->mem.gc_alloc_threshold = threshold;
+        state->mem.gc_alloc_amount = 0;
+    }
+    mp_unlock_thread_mutex();
+}
+
 //------------------------------------
 int mp_thread_started(TaskHandle_t id)
 {
@@ -77,6 +77,7 @@
 #define THREAD_QUEUE_MAX_ITEMS		        8
 
 #define THREAD_IPC_TYPE_EXECUTE             1
+#define THREAD_IPC_TYPE_RPC                 2
 #define THREAD_IPC_TYPE_TERMINATE           0xA55A
 
 #define SYS_TASK_NOTIFY_SUSPEND             1ULL
@@ -168,6 +169,7 @@ TaskHandle_t mp_thread_create(void *entry, thread_entry_args_t *arg, size_t task
 void mp_thread_preinit(void *stack, uint32_t stack_len, void *pystack, int pystack_size, int task_proc);
 int mp_thread_num_threads();
 int mp_thread_gc_others();
+void mp_thread_set_gc_threshold(size_t threshold);
 
 void mp_thread_mutex_init(mp_thread_mutex_t *mutex);
 
@@ -0,0 +1,178 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "camframe.h"
+
+
+// Blend two RGB565 colors, 'w' is the weight of 'b' (0 ~ 32)
+// The color components are spread into 32-bit value to blend them all at once
+//----------------------------------------------------------------
+static inline uint32_t rgb565_blend(uint32_t a, uint32_t b, uint32_t w)
+{
+    a = (a | (a << 16)) & 0x07E0F81F;
+    b = (b | (b << 16)) & 0x07E0F81F;
+    uint32_t c = (((a * (32 - w)) + (b * w)) >> 5) & 0x07E0F81F;
+    return (c | (c >> 16)) & 0xFFFF;
+}
+
+// Copy the camera frame 'buf' (width x height, width is even) to the frame buffer 'fb' (fb_width x fb_height) window
+// (x1,y1), dst_width x dst_height in one pass, the frame is scaled to the window size and rotated
+// by 'rot'*90 degrees (clockwise), using the nearest pixel or bilinear interpolation.
+// Camera frame has swapped even and odd pixels, they are swapped back while copying.
+// The window is clipped to the frame buffer, the written area is returned in 'win'.
+// The frame is not changed. Returns false if nothing was written.
+//=============================================================================================================
+bool camframe_convert(uint16_t *fb, int fb_width, int fb_height, int x1, int y1, int dst_width, int dst_height,
+                      const uint16_t *buf, int width, int height, uint8_t rot, bool bilinear, camframe_win_t *win)
+{
+    // camera frame width is always even, every pixel has its pair
+    if ((dst_width <= 0) || (dst_height <= 0) || (width <= 0) || (height <= 0) || (width & 1)) return false;
+    rot &= 3;
+
+    // clip the window to the frame buffer
+    int u0 = (x1 < 0) ? -x1 : 0;
+    int v0 = (y1 < 0) ? -y1 : 0;
+    int u1 = dst_width;
+    int v1 = dst_height;
+    if ((x1 + u1) > fb_width) u1 = fb_width - x1;
+    if ((y1 + v1) > fb_height) v1 = fb_height - y1;
+    if ((u0 >= u1) || (v0 >= v1)) return false;
+    win->x1 = x1 + u0;
+    win->y1 = y1 + v0;
+    win->x2 = x1 + u1 - 1;
+    win->y2 = y1 + v1 - 1;
+
+    if ((rot == 0) && (width == dst_width) && (height == dst_height) && ((u0 & 1) == 0)) {
+        // Not scaled: copy the rows, swapping the pixel pairs, 4 pixels at once if aligned
+        int npix = u1 - u0;
+        for (int v=v0; v<v1; v++) {
+            const uint16_t *src = buf + (v * width) + u0;
+            uint16_t *dst = fb + ((y1 + v) * fb_width) + x1 + u0;
+            int n = 0;
+            if ((((uintptr_t)src | (uintptr_t)dst) & 7) == 0) {
+                const uint64_t *src64 = (const uint64_t *)src;
+                uint64_t *dst64 = (uint64_t *)dst;
+                for (; (n+4) <= npix; n+=4) {
+                    *dst64++ = RGB565_SWAP_PAIRS64(*src64);
+                    src64++;
+                }
+            }
+            for (; (n+2) <= npix; n+=2) {
+                dst[n] = src[n+1];
+                dst[n+1] = src[n];
+            }
+            if (n < npix) dst[n] = src[n+1];
+        }
+        return true;
+    }
+
+    // Source position (16.16 fixed point) of the window pixel (u, v) is
+    // (fx + u*dxu + v*dxv, fy + u*dyu + v*dyv)
+    int32_t ux = (rot & 1) ? dst_height : dst_width;    // unrotated window size
+    int32_t uy = (rot & 1) ? dst_width : dst_height;
+    int32_t xstep = (int32_t)(((int64_t)width << 16) / ux);
+    int32_t ystep = (int32_t)(((int64_t)height << 16) / uy);
+    int32_t fx = 0, fy = 0, dxu = 0, dyu = 0, dxv = 0, dyv = 0;
+    switch (rot) {
+        case 0:
+            dxu = xstep; dyv = ystep;
+            break;
+        case 1:
+            fy = (dst_width - 1) * ystep; dyu = -ystep; dxv = xstep;
+            break;
+        case 2:
+            fx = (dst_width - 1) * xstep; fy = (dst_height - 1) * ystep; dxu = -xstep; dyv = -ystep;
+            break;
+        default:
+            fx = (dst_height - 1) * xstep; dyu = ystep; dxv = -xstep;
+            break;
+    }
+
+    for (int v=v0; v<v1; v++) {
+        int32_t sx = fx + (u0 * dxu) + (v * dxv);
+        int32_t sy = fy + (u0 * dyu) + (v * dyv);
+        uint16_t *dst = fb + ((y1 + v) * fb_width) + x1;
+        if (!bilinear) {
+            for (int u=u0; u<u1; u++) {
+                dst[u] = buf[((sy >> 16) * width) + ((sx >> 16) ^ 1)];
+                sx += dxu;
+                sy += dyu;
+            }
+        }
+        else {
+            for (int u=u0; u<u1; u++) {
+                int x = sx >> 16;
+                int y = sy >> 16;
+                int xn = (x < (width - 1)) ? x + 1 : x;
+                const uint16_t *row0 = buf + (y * width);
+                const uint16_t *row1 = (y < (height - 1)) ? row0 + width : row0;
+                uint32_t wx = (sx >> 11) & 0x1F;
+                uint32_t wy = (sy >> 11) & 0x1F;
+                uint32_t c0 = rgb565_blend(row0[x ^ 1], row0[xn ^ 1], wx);
+                uint32_t c1 = rgb565_blend(row1[x ^ 1], row1[xn ^ 1], wx);
+                dst[u] = rgb565_blend(c0, c1, wy);
+                sx += dxu;
+                sy += dyu;
+            }
+        }
+    }
+    return true;
+}
+
+// Window size used to show the camera frame on the display
+// The frame size rotated by 'rot'*90 degrees is returned if it fits the display, otherwise
+// the frame is fitted to the display keeping the aspect ratio (bilinear),
+// or divided by the smallest integer scale which fits (nearest pixel)
+//=============================================================================================================
+void camframe_fit(int width, int height, uint8_t rot, bool bilinear, int disp_width, int disp_height, int *dst_width, int *dst_height)
+{
+    int dw = (rot & 1) ? height : width;
+    int dh = (rot & 1) ? width : height;
+
+    if ((dw > disp_width) || (dh > disp_height)) {
+        if (bilinear) {
+            if ((dw * disp_height) > (dh * disp_width)) {
+                dh = (dh * disp_width) / dw;
+                dw = disp_width;
+            }
+            else {
+                dw = (dw * disp_height) / dh;
+                dh = disp_height;
+            }
+        }
+        else {
+            int xscale = (dw + disp_width - 1) / disp_width;
+            int yscale = (dh + disp_height - 1) / disp_height;
+            if (yscale > xscale) xscale = yscale;
+            dw /= xscale;
+            dh /= xscale;
+        }
+    }
+    *dst_width = dw;
+    *dst_height = dh;
+}
@@ -195,6 +195,12 @@ STATIC mp_obj_t display_tft_init(mp_uint_t n_args, const mp_obj_t *pos_args, mp_
     // Set frame buffer(s)
     active_dstate->_tft_frame_buffer = NULL;
     active_dstate->tft_frame_buffer = NULL;
+    active_dstate->tft_back_buffer = NULL;
+    active_dstate->fb_full_threshold = TFT_DIRTY_FULL_THRESHOLD;
+    active_dstate->fb_sent_bytes = 0;
+    active_dstate->fb_sent_windows = 0;
+    active_dstate->fb_sent_full = 0;
+    fb_dirty_all();
     active_dstate->use_frame_buffer = (args[ARG_useFB].u_int > 0);
     if (active_dstate->use_frame_buffer) {
         self->buff_obj0 = mp_obj_new_frame_buffer((active_dstate->_width * active_dstate->_height * 2) + 8);
@@ -233,7 +239,7 @@ STATIC mp_obj_t display_tft_init(mp_uint_t n_args, const mp_obj_t *pos_args, mp_
         active_dstate->_bg = TFT_BLACK;
     }
     vTaskDelay(500);
-    if (active_dstate->use_frame_buffer) send_frame_buffer();
+    if (active_dstate->use_frame_buffer) send_frame_buffer(true);
 
     return mp_const_none;
 }
@@ -1246,6 +1252,7 @@ STATIC mp_obj_t display_tft_Image(size_t n_args, const mp_obj_t *pos_args, mp_ma
                 if ((x == 0) && (y == 0) && (width == active_dstate->_width) && (height == active_dstate->_height)) {
                     // Full frame buffer
                     fsize = mp_stream_posix_read((void *)ffd, active_dstate->tft_frame_buffer, fsize-8);
+                    fb_dirty_all();
                     if (fsize != (active_dstate->_width * active_dstate->_height*2)) {
                         mp_stream_close(ffd);
                         mp_raise_msg(&mp_type_OSError, "Error reading file");
@@ -1468,23 +1475,101 @@ STATIC mp_obj_t display_tft_set_speed(size_t n_args, const mp_obj_t *args)
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(display_tft_set_speed_obj, 1, 2, display_tft_set_speed);
 
-//------------------------------------------------
-STATIC mp_obj_t display_tft_show(mp_obj_t self_in)
+// Send the changed frame buffer areas to the display
+// If 'wait' is False, returns while the transfer runs in background and
+// the drawing continues in the other frame buffer (two frame buffers are required)
+//------------------------------------------------------------------------------------------
+STATIC mp_obj_t display_tft_show(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
 {
-    setupDevice(self_in);
-    send_frame_buffer();
+    const mp_arg_t allowed_args[] = {
+        { MP_QSTR_full, MP_ARG_BOOL, { .u_bool = false } },
+        { MP_QSTR_wait, MP_ARG_BOOL, { .u_bool = true } },
+    };
+
+    setupDevice(pos_args[0]);
+    display_tft_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if ((args[1].u_bool) || (!active_dstate->use_frame_buffer)) {
+        send_frame_buffer(args[0].u_bool);
+        return mp_const_none;
+    }
+    if ((self->buff_obj0 == mp_const_none) || (self->buff_obj1 == mp_const_none)) {
+        // the drawing would change the buffer being sent
+        mp_raise_ValueError("wait=False requires two frame buffers, use useFB(2)");
+    }
+
+    mp_obj_array_t *back_buf = (mp_obj_array_t *)((self->active_fb == 0) ? self->buff_obj1 : self->buff_obj0);
+    uint16_t *back = (uint16_t *)((uint8_t *)back_buf->items + 8);
+    uint16_t *front = active_dstate->tft_frame_buffer;
+    if (send_frame_buffer_async(args[0].u_bool, back)) {
+        // the sent buffer is not touched until the transfer is finished
+        active_dstate->_tft_frame_buffer = back_buf->items;
+        active_dstate->tft_frame_buffer = back;
+        active_dstate->tft_back_buffer = front;
+        self->active_fb ^= 1;
+    }
     return mp_const_none;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_1(display_tft_show_obj, display_tft_show);
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(display_tft_show_obj, 1, display_tft_show);
+
+// Check if the background frame buffer transfer is finished
+//-------------------------------------------------------
+STATIC mp_obj_t display_tft_flush_done(mp_obj_t self_in)
+{
+    setupDevice(self_in);
+    return mp_obj_new_bool(tft_flush_done());
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(display_tft_flush_done_obj, display_tft_flush_done);
+
+// Get (and optionally reset) the frame buffer transfer statistics
+// Returns tuple: (sent_bytes, sent_windows, full_frames)
+//------------------------------------------------------------------------
+STATIC mp_obj_t display_tft_fb_stats(size_t n_args, const mp_obj_t *args)
+{
+    setupDevice(args[0]);
+
+    mp_obj_t tuple[3];
+    tuple[0] = mp_obj_new_int_from_ull(active_dstate->fb_sent_bytes);
+    tuple[1] = mp_obj_new_int_from_uint(active_dstate->fb_sent_windows);
+    tuple[2] = mp_obj_new_int_from_uint(active_dstate->fb_sent_full);
+
+    if ((n_args > 1) && (mp_obj_is_true(args[1]))) {
+        active_dstate->fb_sent_bytes = 0;
+        active_dstate->fb_sent_windows = 0;
+        active_dstate->fb_sent_full = 0;
+    }
+    return mp_obj_new_tuple(3, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(display_tft_fb_stats_obj, 1, 2, display_tft_fb_stats);
+
+// Get or set the changed area (% of the screen) above which show() sends the whole frame buffer
+//----------------------------------------------------------------------------
+STATIC mp_obj_t display_tft_fb_threshold(size_t n_args, const mp_obj_t *args)
+{
+    setupDevice(args[0]);
+
+    if (n_args > 1) {
+        int threshold = mp_obj_get_int(args[1]);
+        if (threshold < 0) threshold = 0;
+        if (threshold > 100) threshold = 100;
+        active_dstate->fb_full_threshold = threshold;
+    }
+    return mp_obj_new_int(active_dstate->fb_full_threshold);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(display_tft_fb_threshold_obj, 1, 2, display_tft_fb_threshold);
 
 //-------------------------------------------------------------------------
 STATIC mp_obj_t display_tft_use_tft_fb(size_t n_args, const mp_obj_t *args)
 {
     setupDevice(args[0]);
     display_tft_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    tft_flush_wait();
 
     int n_fb = 0;
     if (n_args > 1) {
+        active_dstate->tft_back_buffer = NULL;
         n_fb = mp_obj_get_int(args[1]);
         if (n_fb < 0) n_fb = 0;
         if (n_fb > 2) n_fb = 2;
@@ -1510,6 +1595,7 @@ STATIC mp_obj_t display_tft_use_tft_fb(size_t n_args, const mp_obj_t *args)
                 active_dstate->_tft_frame_buffer = fbuf->items;
                 active_dstate->tft_frame_buffer = (uint16_t *)(active_dstate->_tft_frame_buffer + 8);
                 self->active_fb = 0;
+                fb_dirty_all();
             }
         }
         else {
@@ -1539,6 +1625,9 @@ STATIC mp_obj_t display_tft_active_tft_fb(size_t n_args, const mp_obj_t *args)
         mp_raise_msg(&mp_type_OSError, "Framebuffer not used");
     }
     if (n_args > 1) {
+        tft_flush_wait();
+        // the buffers are managed by the user, show() does not keep them consistent
+        active_dstate->tft_back_buffer = NULL;
         int act_fb = mp_obj_get_int(args[1]);
         if (act_fb < 0) act_fb = 0;
         if (act_fb > 1) act_fb = 1;
@@ -1546,6 +1635,7 @@ STATIC mp_obj_t display_tft_active_tft_fb(size_t n_args, const mp_obj_t *args)
         if (act_fb == 1) fbuf = (mp_obj_array_t *)self->buff_obj1;
         active_dstate->_tft_frame_buffer = fbuf->items;
         active_dstate->tft_frame_buffer = (uint16_t *)(active_dstate->_tft_frame_buffer + 8);
+        if (act_fb != self->active_fb) fb_dirty_all();
         self->active_fb = act_fb;
     }
 
@@ -1765,9 +1855,12 @@ STATIC const mp_rom_map_elem_t display_tft_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_text_y),              MP_ROM_PTR(&display_tft_get_Y_obj) },
     { MP_ROM_QSTR(MP_QSTR_setspeed),            MP_ROM_PTR(&display_tft_set_speed_obj) },
     { MP_ROM_QSTR(MP_QSTR_show),                MP_ROM_PTR(&display_tft_show_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flushDone),           MP_ROM_PTR(&display_tft_flush_done_obj) },
     { MP_ROM_QSTR(MP_QSTR_useFB),               MP_ROM_PTR(&display_tft_use_tft_fb_obj) },
     { MP_ROM_QSTR(MP_QSTR_activeFB),            MP_ROM_PTR(&display_tft_active_tft_fb_obj) },
     { MP_ROM_QSTR(MP_QSTR_readFB),              MP_ROM_PTR(&display_tft_fb_read_obj) },
+    { MP_ROM_QSTR(MP_QSTR_statFB),              MP_ROM_PTR(&display_tft_fb_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_thresholdFB),         MP_ROM_PTR(&display_tft_fb_threshold_obj) },
 
     // class constants
     { MP_ROM_QSTR(MP_QSTR_CENTER),              MP_ROM_INT(CENTER) },
@@ -772,7 +772,9 @@ static void _drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, color_t co
 //==============================================================================
 void TFT_drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, color_t color)
 {
+	fb_dirty_begin();
 	_drawLine(x0+active_dstate->dispWin.x1, y0+active_dstate->dispWin.y1, x1+active_dstate->dispWin.x1, y1+active_dstate->dispWin.y1, color);
+	fb_dirty_end();
 }
 
 // fill a rectangle
@@ -836,7 +838,9 @@ static void _drawRect(uint16_t x1,uint16_t y1,uint16_t w,uint16_t h, color_t col
 
 //===============================================================================
 void TFT_drawRect(uint16_t x1,uint16_t y1,uint16_t w,uint16_t h, color_t color) {
+	fb_dirty_begin();
 	_drawRect(x1+active_dstate->dispWin.x1, y1+active_dstate->dispWin.y1, w, h, color);
+	fb_dirty_end();
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -913,6 +917,7 @@ static void fillCircleHelper(int16_t x0, int16_t y0, int16_t r,	uint8_t cornerna
 //=============================================================================================
 void TFT_drawRoundRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t r, color_t color)
 {
+	fb_dirty_begin();
 	x += active_dstate->dispWin.x1;
 	y += active_dstate->dispWin.y1;
 
@@ -927,12 +932,14 @@ void TFT_drawRoundRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t r,
 	drawCircleHelper(x + w - r - 1, y + r, r, 2, color);
 	drawCircleHelper(x + w - r - 1, y + h - r - 1, r, 4, color);
 	drawCircleHelper(x + r, y + h - r - 1, r, 8, color);
+	fb_dirty_end();
 }
 
 // Fill a rounded rectangle
 //=============================================================================================
 void TFT_fillRoundRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t r, color_t color)
 {
+	fb_dirty_begin();
 	x += active_dstate->dispWin.x1;
 	y += active_dstate->dispWin.y1;
 
@@ -942,6 +949,7 @@ void TFT_fillRoundRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t r,
 	// draw four corners
 	fillCircleHelper(x + w - r - 1, y + r, r, 1, h - 2 * r - 1, color);
 	fillCircleHelper(x + r, y + r, r, 2, h - 2 * r - 1, color);
+	fb_dirty_end();
 }
 
 //-----------------------------------------------------------------------------------------------
@@ -967,11 +975,13 @@ static void _DrawLineByAngle(int16_t x, int16_t y, int16_t angle, uint16_t start
 //===========================================================================================================
 void TFT_drawLineByAngle(uint16_t x, uint16_t y, uint16_t start, uint16_t len, uint16_t angle, color_t color)
 {
+	fb_dirty_begin();
 	x += active_dstate->dispWin.x1;
 	y += active_dstate->dispWin.y1;
 
 	if (start == 0) _drawLineByAngle(x, y, angle, len, color);
 	else _DrawLineByAngle(x, y, angle, start, len, color);
+	fb_dirty_end();
 }
 
 
@@ -989,6 +999,7 @@ static void _drawTriangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, ui
 //================================================================================================================
 void TFT_drawTriangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, color_t color)
 {
+	fb_dirty_begin();
 	x0 += active_dstate->dispWin.x1;
 	y0 += active_dstate->dispWin.y1;
 	x1 += active_dstate->dispWin.x1;
@@ -999,6 +1010,7 @@ void TFT_drawTriangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16
 	_drawLine(x0, y0, x1, y1, color);
 	_drawLine(x1, y1, x2, y2, color);
 	_drawLine(x2, y2, x0, y0, color);
+	fb_dirty_end();
 }
 
 // Fill a triangle
@@ -1088,15 +1100,18 @@ static void _fillTriangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, ui
 //================================================================================================================
 void TFT_fillTriangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, color_t color)
 {
+	fb_dirty_begin();
 	_fillTriangle(
 			x0 + active_dstate->dispWin.x1, y0 + active_dstate->dispWin.y1,
 			x1 + active_dstate->dispWin.x1, y1 + active_dstate->dispWin.y1,
 			x2 + active_dstate->dispWin.x1, y2 + active_dstate->dispWin.y1,
 			color);
+	fb_dirty_end();
 }
 
 //====================================================================
 void TFT_drawCircle(int16_t x, int16_t y, int radius, color_t color) {
+	fb_dirty_begin();
 	x += active_dstate->dispWin.x1;
 	y += active_dstate->dispWin.y1;
 	int f = 1 - radius;
@@ -1127,16 +1142,19 @@ void TFT_drawCircle(int16_t x, int16_t y, int radius, color_t color) {
 		TFT_drawPixel(x + y1, y - x1, color);
 		TFT_drawPixel(x - y1, y - x1, color);
 	}
+	fb_dirty_end();
 }
 
 //====================================================================
 void TFT_fillCircle(int16_t x, int16_t y, int radius, color_t color) {
+	fb_dirty_begin();
 	x += active_dstate->dispWin.x1;
 	y += active_dstate->dispWin.y1;
 
     filling = true;
 	_drawFastVLine(x, y-radius, 2*radius+1, color);
 	fillCircleHelper(x, y, radius, 3, 0, color);
+	fb_dirty_end();
 }
 
 //----------------------------------------------------------------------------------------------------------------
@@ -1155,6 +1173,7 @@ static void _draw_ellipse_section(uint16_t x, uint16_t y, uint16_t x0, uint16_t
 //=====================================================================================================
 void TFT_drawEllipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, color_t color, uint8_t option)
 {
+	fb_dirty_begin();
 	x0 += active_dstate->dispWin.x1;
 	y0 += active_dstate->dispWin.y1;
 
@@ -1237,6 +1256,7 @@ void TFT_drawEllipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, color_t
 			ychg += rxrx2;
 		}
 	}
+	fb_dirty_end();
 }
 
 //-----------------------------------------------------------------------------------------------------------------------
@@ -1257,6 +1277,7 @@ static void _draw_filled_ellipse_section(uint16_t x, uint16_t y, uint16_t x0, ui
 //=====================================================================================================
 void TFT_fillEllipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, color_t color, uint8_t option)
 {
+	fb_dirty_begin();
 	x0 += active_dstate->dispWin.x1;
 	y0 += active_dstate->dispWin.y1;
 
@@ -1339,6 +1360,7 @@ void TFT_fillEllipse(uint16_t x0, uint16_t y0, uint16_t rx, uint16_t ry, color_t
 			ychg += rxrx2;
 		}
 	}
+	fb_dirty_end();
 }
 
 
@@ -1390,6 +1412,7 @@ static void _fillArcOffsetted(uint16_t cx, uint16_t cy, uint16_t radius, uint16_
 //===========================================================================================================================
 void TFT_drawArc(uint16_t cx, uint16_t cy, uint16_t r, uint16_t th, float start, float end, color_t color, color_t fillcolor)
 {
+	fb_dirty_begin();
 	cx += active_dstate->dispWin.x1;
 	cy += active_dstate->dispWin.y1;
 
@@ -1432,11 +1455,13 @@ void TFT_drawArc(uint16_t cx, uint16_t cy, uint16_t r, uint16_t th, float start,
 		_drawLine(cx + (r-th) * cos(aend * DEG_TO_RAD), cy + (r-th) * sin(aend * DEG_TO_RAD),
 			cx + (r-1) * cos(aend * DEG_TO_RAD), cy + (r-1) * sin(aend * DEG_TO_RAD), color);
 	}
+	fb_dirty_end();
 }
 
 //=============================================================================================================
 void TFT_drawPolygon(int cx, int cy, int sides, int diameter, color_t color, color_t fill, int rot, uint8_t th)
 {
+	fb_dirty_begin();
 	cx += active_dstate->dispWin.x1;
 	cy += active_dstate->dispWin.y1;
 
@@ -1478,6 +1503,7 @@ void TFT_drawPolygon(int cx, int cy, int sides, int diameter, color_t color, col
 			}
 		}
 	}
+	fb_dirty_end();
 }
 
 /*
@@ -2341,8 +2367,8 @@ static void _draw7seg(int16_t x, int16_t y, uint8_t ch)
 }
 //==============================================================================
 
-//======================================
-void TFT_print(char *st, int x, int y) {
+//--------------------------------------
+static void _print(char *st, int x, int y) {
     int stl, i, tmpw, tmph, fh;
     uint8_t ch;
 
@@ -2450,6 +2476,14 @@ void TFT_print(char *st, int x, int y) {
     }
 }
 
+//======================================
+void TFT_print(char *st, int x, int y)
+{
+    fb_dirty_begin();
+    _print(st, x, y);
+    fb_dirty_end();
+}
+
 
 // ================ Service functions ==========================================
 
@@ -2815,7 +2849,8 @@ static UINT tjd_output (
                     else src += 3; // skip
                 }
             }
-            if (!active_dstate->use_frame_buffer) {
+            if (active_dstate->use_frame_buffer) fb_dirty_add(dleft, dtop, dright, dbottom);
+            else {
                 uint64_t spi_startt = mp_hal_ticks_us();
                 send_data(dleft, dtop, dright+1, dbottom+1, len, dev->linbuf);
                 dev->spi_time += (mp_hal_ticks_us() - spi_startt);
@@ -2853,8 +2888,8 @@ static UINT tjd_output (
 
 // tft.jpgimage(X, Y, scale, file_name, buf, size]
 // X & Y can be < 0 !
-//=====================================================================================
-bool TFT_jpg_image(int x, int y, uint8_t scale, mp_obj_t fname, uint8_t *buf, int size)
+//-------------------------------------------------------------------------------------
+static bool _jpg_image(int x, int y, uint8_t scale, mp_obj_t fname, uint8_t *buf, int size)
 {
 	JPGIODEV dev;
 	char *work = NULL;		// Pointer to the working buffer (must be 4-byte aligned)
@@ -2957,8 +2992,17 @@ exit:
     return result;
 }
 
-//=======================================================================================
-int TFT_bmp_image(int x, int y, uint8_t scale, mp_obj_t fname, uint8_t *imgbuf, int size)
+//=====================================================================================
+bool TFT_jpg_image(int x, int y, uint8_t scale, mp_obj_t fname, uint8_t *buf, int size)
+{
+	fb_dirty_begin();
+	bool res = _jpg_image(x, y, scale, fname, buf, size);
+	fb_dirty_end();
+	return res;
+}
+
+//---------------------------------------------------------------------------------------
+static int _bmp_image(int x, int y, uint8_t scale, mp_obj_t fname, uint8_t *imgbuf, int size)
 {
     if (active_dstate->tft_active_mode == TFT_MODE_EPD) return -99;
     mp_obj_t fhndl = mp_const_none;
@@ -3239,8 +3283,17 @@ exit:
 	return err;
 }
 
-//==========================================================================================
-int TFT_png_image(int x, int y, uint8_t scale, const char* fname, uint8_t *imgbuf, int size)
+//=======================================================================================
+int TFT_bmp_image(int x, int y, uint8_t scale, mp_obj_t fname, uint8_t *imgbuf, int size)
+{
+	fb_dirty_begin();
+	int res = _bmp_image(x, y, scale, fname, imgbuf, size);
+	fb_dirty_end();
+	return res;
+}
+
+//------------------------------------------------------------------------------------------
+static int _png_image(int x, int y, uint8_t scale, const char* fname, uint8_t *imgbuf, int size)
 {
     if (active_dstate->tft_active_mode != TFT_MODE_EPD) return -99;
     int err=0;
@@ -3451,4 +3504,13 @@ exit:
     return err;
 }
 
+//==========================================================================================
+int TFT_png_image(int x, int y, uint8_t scale, const char* fname, uint8_t *imgbuf, int size)
+{
+	fb_dirty_begin();
+	int res = _png_image(x, y, scale, fname, imgbuf, size);
+	fb_dirty_end();
+	return res;
+}
+
 #endif // MICROPY_USE_DISPLAY
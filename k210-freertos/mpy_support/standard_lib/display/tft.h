@@ -47,6 +47,11 @@
 #define TFT_MODE_EPD    2
 #define TFT_MODE_EVE    3
 
+// Frame buffer dirty rectangles tracking
+#define TFT_DIRTY_RECTS_MAX         8   // maximal number of separate dirty rectangles
+#define TFT_DIRTY_MERGE_GAP         8   // rectangles closer than this (pixels) are merged
+#define TFT_DIRTY_FULL_THRESHOLD    60  // default dirty area (% of the screen) above which the whole frame is sent
+
 typedef struct {
 	uint16_t        x1;
 	uint16_t        y1;
@@ -104,6 +109,22 @@ typedef struct {
 
     void *_tft_frame_buffer __attribute__((aligned(8)));
     uint16_t *tft_frame_buffer __attribute__((aligned(8)));
+    // The other frame buffer while show(wait=False) flips the buffers, every show() copies the sent areas to it
+    uint16_t *tft_back_buffer;
+
+    // Frame buffer areas changed since the last send_frame_buffer()
+    dispWin_t fb_dirty[TFT_DIRTY_RECTS_MAX];
+    uint8_t   fb_dirty_count;
+    uint8_t   fb_dirty_last;     // index of the last extended rectangle, checked first
+    bool      fb_dirty_full;     // the whole frame buffer must be sent
+    uint8_t   fb_full_threshold; // dirty area (% of the screen) above which the whole frame is sent
+    uint32_t  fb_dirty_area;     // sum of the dirty rectangles areas
+    uint8_t   fb_dirty_nest;     // fb_dirty_begin() nesting level of the drawing primitives
+    dispWin_t fb_dirty_bound;    // bounding rectangle of the current drawing primitive
+    // Frame buffer transfer statistics
+    uint64_t  fb_sent_bytes;
+    uint32_t  fb_sent_windows;
+    uint32_t  fb_sent_full;
 } display_settings_t;
 
 
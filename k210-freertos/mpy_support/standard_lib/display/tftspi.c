@@ -47,9 +47,13 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
+#include "semphr.h"
 #include "syslog.h"
 #include "mphalport.h"
+#include "py/mpstate.h"
+#include "py/mpthread.h"
 #include "gpiohs.h"
+#include "camframe.h"
 
 
 #define WAIT_CYCLE  0U
@@ -239,6 +243,8 @@ static bool tft_hard_init(void)
 //----------------------------------------
 static void tft_write_command(uint8_t cmd)
 {
+    // every display operation starts with a command, do not interleave with the frame buffer transfer
+    tft_flush_wait();
     set_dcx_control();
     io_write(spi_dfs8, (const uint8_t *)(&cmd), 1);
 }
@@ -343,6 +349,306 @@ static void disp_spi_transfer_addrwin(uint16_t x1, uint16_t x2, uint16_t y1, uin
     tft_write_command(MEMORY_WRITE);
 }
 
+// ==== Frame buffer dirty rectangles =================================
+
+#define TFT_DIRTY_BOUNCE_PIXELS 4096
+
+// Used to send the frame buffer windows narrower than the display width
+static uint16_t fb_bounce_buf[TFT_DIRTY_BOUNCE_PIXELS] __attribute__((aligned(8)));
+
+#define TFT_FLUSH_CHUNK_PIXELS      16384
+#define TFT_FLUSH_TASK_STACK_SIZE   1024
+
+// Frame buffer areas being sent to the display
+typedef struct {
+    uint16_t  *fb;
+    uint16_t  width;
+    uint8_t   count;
+    dispWin_t rects[TFT_DIRTY_RECTS_MAX];
+} fb_flush_t;
+
+static fb_flush_t fb_flush;
+static TaskHandle_t fb_flush_task_handle = NULL;
+static SemaphoreHandle_t fb_flush_idle = NULL;   // available when no transfer is active
+
+//-----------------------------------------------
+static inline uint32_t dirty_area(dispWin_t *win)
+{
+    return (uint32_t)(win->x2 - win->x1 + 1) * (uint32_t)(win->y2 - win->y1 + 1);
+}
+
+// Check if the two rectangles overlap or are closer than TFT_DIRTY_MERGE_GAP
+//-----------------------------------------------------
+static inline bool dirty_near(dispWin_t *a, dispWin_t *b)
+{
+    return ((a->x1 <= (b->x2 + TFT_DIRTY_MERGE_GAP)) && (b->x1 <= (a->x2 + TFT_DIRTY_MERGE_GAP)) &&
+            (a->y1 <= (b->y2 + TFT_DIRTY_MERGE_GAP)) && (b->y1 <= (a->y2 + TFT_DIRTY_MERGE_GAP)));
+}
+
+//-----------------------------------------------------
+static inline void dirty_union(dispWin_t *a, dispWin_t *b)
+{
+    if (b->x1 < a->x1) a->x1 = b->x1;
+    if (b->y1 < a->y1) a->y1 = b->y1;
+    if (b->x2 > a->x2) a->x2 = b->x2;
+    if (b->y2 > a->y2) a->y2 = b->y2;
+}
+
+// Merge all rectangles near to the rectangle at 'idx' into it
+//-------------------------------------
+static void dirty_coalesce(uint8_t idx)
+{
+    dispWin_t *rects = active_dstate->fb_dirty;
+    bool merged = true;
+
+    while (merged) {
+        merged = false;
+        for (uint8_t i=0; i<active_dstate->fb_dirty_count; i++) {
+            if ((i == idx) || (!dirty_near(&rects[idx], &rects[i]))) continue;
+            active_dstate->fb_dirty_area -= dirty_area(&rects[i]);
+            dirty_union(&rects[idx], &rects[i]);
+            // remove the merged rectangle, the last one takes its place
+            active_dstate->fb_dirty_count--;
+            if (i != active_dstate->fb_dirty_count) {
+                rects[i] = rects[active_dstate->fb_dirty_count];
+                if (idx == active_dstate->fb_dirty_count) idx = i;
+            }
+            merged = true;
+            break;
+        }
+    }
+    active_dstate->fb_dirty_last = idx;
+}
+
+//---------------------------
+static void fb_dirty_clear()
+{
+    active_dstate->fb_dirty_nest = 0;
+    active_dstate->fb_dirty_full = false;
+    active_dstate->fb_dirty_count = 0;
+    active_dstate->fb_dirty_area = 0;
+}
+
+// Mark the whole frame buffer as changed
+//=================
+void fb_dirty_all()
+{
+    active_dstate->fb_dirty_full = true;
+    active_dstate->fb_dirty_count = 0;
+    active_dstate->fb_dirty_area = 0;
+}
+
+// Mark the frame buffer area (x1,y1),(x2,y2) (inclusive) as changed
+// Inside a drawing primitive (between fb_dirty_begin() and fb_dirty_end())
+// the area only extends the primitive's bounding rectangle
+//================================================
+void fb_dirty_add(int x1, int y1, int x2, int y2)
+{
+    if (active_dstate->fb_dirty_full) return;
+
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 >= active_dstate->_width) x2 = active_dstate->_width - 1;
+    if (y2 >= active_dstate->_height) y2 = active_dstate->_height - 1;
+    if ((x2 < x1) || (y2 < y1)) return;
+
+    dispWin_t win = { .x1 = x1, .y1 = y1, .x2 = x2, .y2 = y2 };
+    if (active_dstate->fb_dirty_nest) {
+        dirty_union(&active_dstate->fb_dirty_bound, &win);
+        return;
+    }
+
+    dispWin_t *rects = active_dstate->fb_dirty;
+    uint8_t idx;
+
+    // Check the last extended rectangle first
+    idx = active_dstate->fb_dirty_last;
+    if ((idx < active_dstate->fb_dirty_count) && (x1 >= rects[idx].x1) && (x2 <= rects[idx].x2) &&
+            (y1 >= rects[idx].y1) && (y2 <= rects[idx].y2)) return;
+
+    for (idx=0; idx<active_dstate->fb_dirty_count; idx++) {
+        if (dirty_near(&rects[idx], &win)) break;
+    }
+    if ((idx == active_dstate->fb_dirty_count) && (idx >= TFT_DIRTY_RECTS_MAX)) {
+        // No free slot, merge into the rectangle which grows the least
+        uint32_t min_growth = 0xFFFFFFFF;
+        for (uint8_t i=0; i<active_dstate->fb_dirty_count; i++) {
+            dispWin_t tmp = rects[i];
+            dirty_union(&tmp, &win);
+            uint32_t growth = dirty_area(&tmp) - dirty_area(&rects[i]);
+            if (growth < min_growth) {
+                min_growth = growth;
+                idx = i;
+            }
+        }
+    }
+    if (idx < active_dstate->fb_dirty_count) {
+        active_dstate->fb_dirty_area -= dirty_area(&rects[idx]);
+        dirty_union(&rects[idx], &win);
+    }
+    else {
+        rects[idx] = win;
+        active_dstate->fb_dirty_count++;
+    }
+    dirty_coalesce(idx);
+    active_dstate->fb_dirty_area += dirty_area(&rects[active_dstate->fb_dirty_last]);
+
+    if ((active_dstate->fb_dirty_area * 100) >= ((uint32_t)active_dstate->fb_full_threshold * active_dstate->_width * active_dstate->_height)) {
+        fb_dirty_all();
+    }
+}
+
+// Start of a drawing primitive, the frame buffer areas it changes are
+// collected into one bounding rectangle, added to the dirty list by fb_dirty_end()
+// The calls can be nested, only the outermost pair adds the rectangle
+//===================
+void fb_dirty_begin()
+{
+    if (active_dstate->fb_dirty_nest++ == 0) {
+        active_dstate->fb_dirty_bound.x1 = 0xFFFF;
+        active_dstate->fb_dirty_bound.y1 = 0xFFFF;
+        active_dstate->fb_dirty_bound.x2 = 0;
+        active_dstate->fb_dirty_bound.y2 = 0;
+    }
+}
+
+//=================
+void fb_dirty_end()
+{
+    if ((active_dstate->fb_dirty_nest == 0) || (--active_dstate->fb_dirty_nest != 0)) return;
+
+    dispWin_t *bound = &active_dstate->fb_dirty_bound;
+    if (bound->x2 >= bound->x1) fb_dirty_add(bound->x1, bound->y1, bound->x2, bound->y2);
+}
+
+// Send the frame buffer window, display must be selected
+// Long transfers are split into chunks, the SPI driver fails to send more than ~120 KB at once
+//-----------------------------------------------------------------------------
+static void send_frame_buffer_win(uint16_t *fb, uint16_t fb_width, dispWin_t *win)
+{
+    uint16_t width = win->x2 - win->x1 + 1;
+    uint16_t nrows;
+
+    if (width == fb_width) {
+        // full display width, the window rows are contiguous in the frame buffer
+        nrows = TFT_FLUSH_CHUNK_PIXELS / width;
+        for (uint16_t y=win->y1; y<=win->y2; y+=nrows) {
+            uint16_t yend = y + nrows - 1;
+            if (yend > win->y2) yend = win->y2;
+            disp_spi_transfer_addrwin(win->x1, win->x2, y, yend);
+            tft_write_rgb565(fb + (y * fb_width), width * (yend - y + 1));
+        }
+        return;
+    }
+    // collect the window rows into the bounce buffer and send them in chunks
+    nrows = TFT_DIRTY_BOUNCE_PIXELS / width;
+    for (uint16_t y=win->y1; y<=win->y2; y+=nrows) {
+        uint16_t yend = y + nrows - 1;
+        if (yend > win->y2) yend = win->y2;
+        uint16_t *buf = fb_bounce_buf;
+        for (uint16_t row=y; row<=yend; row++) {
+            memcpy(buf, fb + (row * fb_width) + win->x1, width * 2);
+            buf += width;
+        }
+        disp_spi_transfer_addrwin(win->x1, win->x2, y, yend);
+        tft_write_rgb565(fb_bounce_buf, width * (yend - y + 1));
+    }
+}
+
+// Take the frame buffer areas to be sent from the dirty rectangles list
+// If 'full' is set, or the changed area is above the threshold, the whole frame buffer is sent
+//-------------------------------------
+static void fb_flush_prepare(bool full)
+{
+    if (active_dstate->fb_dirty_nest) {
+        // a drawing primitive was interrupted (exception), add its area
+        active_dstate->fb_dirty_nest = 1;
+        fb_dirty_end();
+    }
+    fb_flush.fb = active_dstate->tft_frame_buffer;
+    fb_flush.width = active_dstate->_width;
+    if ((full) || (active_dstate->fb_dirty_full)) {
+        fb_flush.rects[0] = (dispWin_t){ .x1 = 0, .y1 = 0, .x2 = active_dstate->_width-1, .y2 = active_dstate->_height-1 };
+        fb_flush.count = 1;
+        active_dstate->fb_sent_bytes += active_dstate->_width * active_dstate->_height * 2;
+        active_dstate->fb_sent_full++;
+    }
+    else {
+        memcpy(fb_flush.rects, active_dstate->fb_dirty, active_dstate->fb_dirty_count * sizeof(dispWin_t));
+        fb_flush.count = active_dstate->fb_dirty_count;
+        active_dstate->fb_sent_bytes += active_dstate->fb_dirty_area * 2;
+    }
+    active_dstate->fb_sent_windows += fb_flush.count;
+    fb_dirty_clear();
+}
+
+//-------------------------
+static void fb_flush_send()
+{
+    LOGV(TAG, "Send %u frame buffer windows from %p", fb_flush.count, fb_flush.fb);
+    for (uint8_t i=0; i<fb_flush.count; i++) {
+        send_frame_buffer_win(fb_flush.fb, fb_flush.width, &fb_flush.rects[i]);
+    }
+}
+
+// Copy the frame buffer areas being sent to the other frame buffer
+//------------------------------------------
+static void fb_flush_copy(uint16_t *back)
+{
+    for (uint8_t i=0; i<fb_flush.count; i++) {
+        dispWin_t *win = &fb_flush.rects[i];
+        uint32_t width = win->x2 - win->x1 + 1;
+        for (uint32_t row=win->y1; row<=win->y2; row++) {
+            uint32_t offset = (row * fb_flush.width) + win->x1;
+            memcpy(back + offset, fb_flush.fb + offset, width * 2);
+        }
+    }
+}
+
+// Sends the requested frame buffer areas, the MicroPython task continues while the SPI DMA transfer runs
+//--------------------------------------------
+static void fb_flush_task(void *pvParameters)
+{
+    uint64_t notify_val = 0;
+    int notify_res = 0;
+
+    while (1) {
+        notify_res = xTaskNotifyWait(0, ULONG_MAX, &notify_val, 1000 / portTICK_RATE_MS);
+        if (notify_res != pdPASS) continue;
+
+        fb_flush_send();
+        xSemaphoreGive(fb_flush_idle);
+    }
+}
+
+// Wait until the asynchronous frame buffer transfer is finished
+// If the calling task holds the GIL, other MicroPython threads can run while waiting
+//===================
+void tft_flush_wait()
+{
+    if ((fb_flush_task_handle == NULL) || (xTaskGetCurrentTaskHandle() == fb_flush_task_handle)) return;
+    if (xSemaphoreTake(fb_flush_idle, 0) != pdTRUE) {
+        #if MICROPY_PY_THREAD
+        // not a MicroPython task (camera preview) if there is no MicroPython state
+        bool gil = (mp_get_state() != NULL) &&
+                (xSemaphoreGetMutexHolder(MP_STATE_VM(gil_mutex).handle) == xTaskGetCurrentTaskHandle());
+        if (gil) MP_THREAD_GIL_EXIT();
+        xSemaphoreTake(fb_flush_idle, portMAX_DELAY);
+        if (gil) MP_THREAD_GIL_ENTER();
+        #else
+        xSemaphoreTake(fb_flush_idle, portMAX_DELAY);
+        #endif
+    }
+    xSemaphoreGive(fb_flush_idle);
+}
+
+//===================
+bool tft_flush_done()
+{
+    if (fb_flush_task_handle == NULL) return true;
+    return (uxSemaphoreGetCount(fb_flush_idle) > 0);
+}
+
 // Set display pixel at given coordinates to given color
 //=================================================
 void drawPixel(int16_t x, int16_t y, color_t color)
@@ -350,6 +656,7 @@ void drawPixel(int16_t x, int16_t y, color_t color)
 	if (active_dstate->use_frame_buffer) {
         if ((y < active_dstate->_height) && (x < active_dstate->_width)) {
             active_dstate->tft_frame_buffer[(y*active_dstate->_width) + x] = color;
+            fb_dirty_add(x, y, x, y);
         }
 	    return;
 	}
@@ -371,6 +678,7 @@ void TFT_pushColorRep(int x1, int y1, int x2, int y2, color_t color, uint32_t le
                 }
             }
         }
+        fb_dirty_add(x1, y1, x2, y2);
         return;
     }
 
@@ -389,6 +697,7 @@ void send_data(int x1, int y1, int x2, int y2, uint32_t len, color_t *buf)
 {
     if (active_dstate->use_frame_buffer) {
         int idx = 0;
+        fb_dirty_add(x1, y1, x2-1, y2-1);
         for (int y=y1; y<y2; y++) {
             for (int x=x1; x<x2; x++) {
                 if ((y < active_dstate->_height) && (x < active_dstate->_width)) {
@@ -419,6 +728,7 @@ void send_data_scale(int x1, int y1, int width, int height, color_t *buf, int sc
     if ((x1==0) && (y1==0) && (width == active_dstate->_width) && (height == active_dstate->_height) && (scale <= 1)) {
         if (active_dstate->use_frame_buffer) {
             memcpy(active_dstate->tft_frame_buffer, buf, width*height*2);
+            fb_dirty_all();
             return;
         }
     }
@@ -431,6 +741,7 @@ void send_data_scale(int x1, int y1, int width, int height, color_t *buf, int sc
         if ((width % active_dstate->_width) > 0) xyscale++;
     }
     if (xyscale <= 1) xyscale = 1;
+    if (active_dstate->use_frame_buffer) fb_dirty_add(x1, y1, x1 + ((width-1) / xyscale), y1 + ((height-1) / xyscale));
 
     for (y = 0; y < height; y++) {
         ty = (y/xyscale) + y1; // display row
@@ -449,17 +760,81 @@ void send_data_scale(int x1, int y1, int width, int height, color_t *buf, int sc
     }
 }
 
-// ToDo: Why SPI drive cannot send more than ~120 KB at once !?
-//======================
-void send_frame_buffer()
+// Copy the camera frame to the frame buffer window (x1,y1), dst_width x dst_height
+// The frame is scaled and rotated by 'rot'*90 degrees (clockwise), see camframe_convert()
+//===================================================================================================
+void send_camera_frame(int x1, int y1, int dst_width, int dst_height, uint16_t *buf, int width, int height, uint8_t rot, bool bilinear)
 {
+    if ((!active_dstate->use_frame_buffer) || (active_dstate->tft_frame_buffer == NULL)) return;
+
+    camframe_win_t win;
+    if (camframe_convert(active_dstate->tft_frame_buffer, active_dstate->_width, active_dstate->_height,
+            x1, y1, dst_width, dst_height, buf, width, height, rot, bilinear, &win)) {
+        fb_dirty_add(win.x1, win.y1, win.x2, win.y2);
+    }
+}
+
+// Send the frame buffer areas changed since the last call
+// If 'full' is set, or the changed area is above the threshold, the whole frame buffer is sent
+//==============================
+void send_frame_buffer(bool full)
+{
+    tft_flush_wait();
     if ((active_dstate->use_frame_buffer) && active_dstate->tft_frame_buffer) {
-        LOGV(TAG, "Send frame buffer at %p", active_dstate->tft_frame_buffer);
-        // ** Send address window **
-        disp_spi_transfer_addrwin(0, active_dstate->_width-1, 0, active_dstate->_height-1);
-        // Send color buffer
-        tft_write_rgb565(active_dstate->tft_frame_buffer, active_dstate->_width*active_dstate->_height);
+        fb_flush_prepare(full);
+        fb_flush_send();
+        // keep the buffers flipped by show(wait=False) consistent
+        if (active_dstate->tft_back_buffer) fb_flush_copy(active_dstate->tft_back_buffer);
     }
+    else fb_dirty_clear();
+}
+
+// Start sending the changed frame buffer areas and return without waiting for the transfer to finish
+// If 'back' is given, the sent areas are copied to it, so that it can be used to draw the next frame
+// Returns false if the transfer was not started asynchronously
+//==========================================================
+bool send_frame_buffer_async(bool full, uint16_t *back)
+{
+    if ((!active_dstate->use_frame_buffer) || (active_dstate->tft_frame_buffer == NULL)) {
+        fb_dirty_clear();
+        return false;
+    }
+    if (fb_flush_task_handle == NULL) {
+        if (fb_flush_idle == NULL) {
+            fb_flush_idle = xSemaphoreCreateBinary();
+            if (fb_flush_idle == NULL) {
+                send_frame_buffer(full);
+                return false;
+            }
+            xSemaphoreGive(fb_flush_idle);
+        }
+        BaseType_t res = xTaskCreate(
+                fb_flush_task,                          // function entry
+                "Display_flush",                        // task name
+                TFT_FLUSH_TASK_STACK_SIZE,              // stack_deepth
+                NULL,                                   // function argument
+                MICROPY_TASK_PRIORITY+1,                // task priority
+                &fb_flush_task_handle);                 // task handle
+        if (res != pdPASS) {
+            fb_flush_task_handle = NULL;
+            LOGW(TAG, "Error creating display flush task");
+            send_frame_buffer(full);
+            return false;
+        }
+    }
+
+    // only one transfer can be active
+    xSemaphoreTake(fb_flush_idle, portMAX_DELAY);
+    fb_flush_prepare(full);
+    if (fb_flush.count == 0) {
+        xSemaphoreGive(fb_flush_idle);
+        return true;
+    }
+    xTaskNotify(fb_flush_task_handle, 1, eSetValueWithOverwrite);
+
+    // bring the back buffer up to date while the front buffer is being sent
+    if (back) fb_flush_copy(back);
+    return true;
 }
 
 //==================================
@@ -552,7 +927,8 @@ void _tft_setRotation(uint8_t rot) {
 	if (send) {
     	disp_spi_transfer_cmd_data(MEMORY_ACCESS_CTL, &madctl, 1);
 	}
-
+	// display orientation changed, the whole frame buffer must be sent
+	fb_dirty_all();
 }
 
 //=================================================
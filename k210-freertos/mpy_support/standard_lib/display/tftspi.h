@@ -201,8 +201,16 @@ void disp_spi_transfer_cmd_data(int8_t cmd, uint8_t *data, uint32_t len);
 void drawPixel(int16_t x, int16_t y, color_t color);
 void send_data(int x1, int y1, int x2, int y2, uint32_t len, color_t *buf);
 void send_data_scale(int x1, int y1, int width, int height, color_t *buf, int scale);
+void send_camera_frame(int x1, int y1, int dst_width, int dst_height, uint16_t *buf, int width, int height, uint8_t rot, bool bilinear);
 void TFT_pushColorRep(int x1, int y1, int x2, int y2, color_t data, uint32_t len);
-void send_frame_buffer();
+void send_frame_buffer(bool full);
+bool send_frame_buffer_async(bool full, uint16_t *back);
+void tft_flush_wait();
+bool tft_flush_done();
+void fb_dirty_add(int x1, int y1, int x2, int y2);
+void fb_dirty_all();
+void fb_dirty_begin();
+void fb_dirty_end();
 void TFT_display_setvars(display_config_t *dconfig);
 void tft_set_speed(uint32_t speed);
 uint32_t tft_get_speed();
@@ -0,0 +1,211 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "at_scan.h"
+
+
+/*
+ * Build the automaton for the given patterns
+ * Bytes not used in any pattern share the character class 0,
+ * so the transition table only has a column for each distinct pattern character.
+ * NULL or empty patterns are allowed, they never match.
+ * Returns false if the patterns do not fit in the scanner tables.
+ */
+//-------------------------------------------------------------------------------
+bool at_scan_init(at_scanner_t *sc, const char * const *patterns, int npatterns)
+{
+    uint8_t fail[AT_SCAN_MAX_STATES];
+    uint8_t queue[AT_SCAN_MAX_STATES];
+    int nclasses = 1;
+
+    memset(sc, 0, sizeof(at_scanner_t));
+    if ((npatterns < 0) || (npatterns > AT_SCAN_MAX_PATTERNS)) return false;
+    // 0xFF marks a missing trie edge while building
+    memset(sc->next, 0xFF, sizeof(sc->next));
+    sc->nstates = 1;
+
+    // === Build the trie ===
+    for (int i=0; i<npatterns; i++) {
+        const uint8_t *p = (const uint8_t *)patterns[i];
+        int len = (p) ? strlen((const char *)p) : 0;
+        if (len > 255) return false;
+        if (len == 0) continue;
+        sc->pattern_len[i] = len;
+        uint8_t state = 0;
+        for (int n=0; n<len; n++) {
+            if (sc->char_class[p[n]] == 0) {
+                if (nclasses >= AT_SCAN_MAX_CLASSES) return false;
+                sc->char_class[p[n]] = nclasses++;
+            }
+            uint8_t c = sc->char_class[p[n]];
+            if (sc->next[state][c] == 0xFF) {
+                if (sc->nstates >= AT_SCAN_MAX_STATES) return false;
+                sc->depth[sc->nstates] = sc->depth[state] + 1;
+                sc->next[state][c] = sc->nstates++;
+            }
+            state = sc->next[state][c];
+        }
+        sc->output[state] |= 1 << i;
+    }
+    sc->npatterns = npatterns;
+
+    // === Add the failure transitions, breadth first ===
+    int q_head = 0, q_tail = 0;
+    for (int c=0; c<AT_SCAN_MAX_CLASSES; c++) {
+        uint8_t s = sc->next[0][c];
+        if ((s == 0xFF) || (c >= nclasses)) sc->next[0][c] = 0;
+        else {
+            fail[s] = 0;
+            queue[q_tail++] = s;
+        }
+    }
+    while (q_head < q_tail) {
+        uint8_t state = queue[q_head++];
+        for (int c=0; c<AT_SCAN_MAX_CLASSES; c++) {
+            uint8_t s = sc->next[state][c];
+            if ((s == 0xFF) || (c >= nclasses)) sc->next[state][c] = sc->next[fail[state]][c];
+            else {
+                fail[s] = sc->next[fail[state]][c];
+                sc->output[s] |= sc->output[fail[s]];
+                queue[q_tail++] = s;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * Build the automaton only if the patterns differ from the ones the scanner
+ * was last built for, the same response sets are used for most AT commands.
+ * The pattern sets longer than AT_SCAN_KEY_SIZE are always compiled.
+ */
+//----------------------------------------------------------------------------------
+bool at_scan_compile(at_scanner_t *sc, const char * const *patterns, int npatterns)
+{
+    char key[AT_SCAN_KEY_SIZE];
+    int key_len = 0;
+
+    if ((npatterns < 0) || (npatterns > AT_SCAN_MAX_PATTERNS)) return false;
+    for (int i=0; i<npatterns; i++) {
+        int len = (patterns[i]) ? strlen(patterns[i]) : 0;
+        if ((key_len + len + 1) > AT_SCAN_KEY_SIZE) {
+            key_len = 0;
+            break;
+        }
+        if (len) memcpy(key + key_len, patterns[i], len);
+        key_len += len;
+        key[key_len++] = '\0';
+    }
+    if ((key_len > 0) && (sc->key_len == key_len) && (sc->npatterns == npatterns) && (memcmp(sc->key, key, key_len) == 0)) return true;
+
+    if (!at_scan_init(sc, patterns, npatterns)) return false;
+    if (key_len > 0) {
+        memcpy(sc->key, key, key_len);
+        sc->key_len = key_len;
+    }
+    return true;
+}
+
+// Start scanning at position 'pos' relative to the buffer head
+//------------------------------------------------------------------
+void at_scan_start(at_scanner_t *sc, uart_ringbuf_t *r, size_t pos)
+{
+    sc->scan_pos = r->head + pos;
+    sc->state = 0;
+    sc->pending = 0;
+}
+
+//--------------------------------------------------------------------
+static size_t scan_offset(at_scanner_t *sc, uart_ringbuf_t *r)
+{
+    size_t head = r->head;
+    size_t offset = sc->scan_pos - head;
+
+    if (offset > uart_buf_length(r, NULL)) {
+        // scanned data removed from buffer (or buffer flushed), continue at the buffer head
+        sc->scan_pos = head;
+        sc->state = 0;
+        sc->pending = 0;
+        return 0;
+    }
+    if (sc->depth[sc->state] > offset) {
+        // the start of a partial match was removed from buffer
+        sc->state = 0;
+        sc->pending = 0;
+    }
+    return offset;
+}
+
+/*
+ * Scan the bytes received since the last call and return the next match found
+ * Each received byte is examined only once; if more patterns end at the same byte,
+ * they are returned by successive calls, in pattern order.
+ * Returns false if no (more) match was found in the received data.
+ */
+//-----------------------------------------------------------------------------
+bool at_scan_next(at_scanner_t *sc, uart_ringbuf_t *r, at_scan_event_t *event)
+{
+    size_t offset = scan_offset(sc, r);
+
+    while (sc->pending == 0) {
+        uint8_t *data;
+        size_t len = uart_buf_peek(r, offset, &data);
+        if (len == 0) return false;
+
+        uint8_t state = sc->state;
+        size_t n = 0;
+        while (n < len) {
+            state = sc->next[state][sc->char_class[data[n++]]];
+            if (sc->output[state]) {
+                sc->pending = sc->output[state];
+                break;
+            }
+        }
+        sc->state = state;
+        offset += n;
+        sc->scan_pos += n;
+    }
+
+    int pattern = __builtin_ctz(sc->pending);
+    sc->pending &= ~(1 << pattern);
+    event->pattern = pattern;
+    event->len = sc->pattern_len[pattern];
+    event->pos = offset - event->len;
+    return true;
+}
+
+/*
+ * Returns the number of bytes at the buffer head which are already scanned
+ * and are not a part of a possible match
+ * Those bytes can be removed from the buffer without affecting the scan.
+ */
+//-------------------------------------------------------------
+size_t at_scan_unmatched(at_scanner_t *sc, uart_ringbuf_t *r)
+{
+    size_t offset = scan_offset(sc, r);
+    return offset - sc->depth[sc->state];
+}
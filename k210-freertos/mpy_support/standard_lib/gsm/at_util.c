@@ -29,6 +29,7 @@
 #if MICROPY_PY_USE_NETTWORK
 
 #include "at_util.h"
+#include "at_scan.h"
 #include <time.h>
 #include <string.h>
 #include "devices.h"
@@ -50,6 +51,189 @@ socket_obj_t *at_server_socket[AT_MAX_SERV_SOCKETS] = {NULL};
 
 char at_canonname[DNS_MAX_NAME_LENGTH+1] = {'\0'};
 
+// Response scanner of each uart, kept between the commands so the automaton is
+// rebuilt only when the command's responses differ from the previous ones
+// Used only by _at_Cmd_Response(), executed under the uart's AT mutex
+static at_scanner_t *at_scanners[UART_NUM_MAX] = {NULL};
+
+
+// ==== Socket receive buffers ==================================================
+// Received data is kept in the chain of fixed size chunks taken from the shared pool,
+// the buffer never needs to be reallocated or copied when more data is received.
+// !!socket buffer functions should be executed protected by mutex !!
+
+static at_sockbuf_chunk_t *sockbuf_pool = NULL;
+static at_sockbuf_chunk_t *sockbuf_free = NULL;
+static at_sockbuf_stats_t sockbuf_stats = { 0 };
+
+//--------------------------------------------------
+static at_sockbuf_chunk_t *sockbuf_chunk_alloc()
+{
+    at_sockbuf_chunk_t *chunk;
+
+    if (sockbuf_pool == NULL) {
+        // The pool is allocated on first use, as a single block, and never freed
+        sockbuf_pool = pvPortMalloc(AT_SOCKBUF_POOL_CHUNKS * sizeof(at_sockbuf_chunk_t));
+        if (sockbuf_pool) {
+            for (int i=0; i<AT_SOCKBUF_POOL_CHUNKS; i++) {
+                sockbuf_pool[i].next = sockbuf_free;
+                sockbuf_free = &sockbuf_pool[i];
+            }
+            sockbuf_stats.chunks = AT_SOCKBUF_POOL_CHUNKS;
+            sockbuf_stats.free = AT_SOCKBUF_POOL_CHUNKS;
+            sockbuf_stats.min_free = AT_SOCKBUF_POOL_CHUNKS;
+        }
+    }
+    if (sockbuf_free) {
+        chunk = sockbuf_free;
+        sockbuf_free = chunk->next;
+        sockbuf_stats.free--;
+        if (sockbuf_stats.free < sockbuf_stats.min_free) sockbuf_stats.min_free = sockbuf_stats.free;
+    }
+    else {
+        // pool exhausted, data which is already being received must not be lost
+        chunk = pvPortMalloc(sizeof(at_sockbuf_chunk_t));
+        if (chunk == NULL) return NULL;
+        sockbuf_stats.heap_chunks++;
+    }
+    chunk->next = NULL;
+    chunk->start = 0;
+    chunk->end = 0;
+    return chunk;
+}
+
+//-------------------------------------------------------
+static void sockbuf_chunk_release(at_sockbuf_chunk_t *chunk)
+{
+    if ((sockbuf_pool) && (chunk >= sockbuf_pool) && (chunk < (sockbuf_pool + AT_SOCKBUF_POOL_CHUNKS))) {
+        chunk->next = sockbuf_free;
+        sockbuf_free = chunk;
+        sockbuf_stats.free++;
+    }
+    else vPortFree(chunk);
+}
+
+//------------------------------------------------
+void at_sockbuf_init(at_sockbuf_t *b, size_t quota)
+{
+    memset(b, 0, sizeof(at_sockbuf_t));
+    b->quota = (quota < AT_SOCKBUF_CHUNK_SIZE) ? AT_SOCKBUF_CHUNK_SIZE : quota;
+}
+
+// Return all buffer's chunks to the pool
+//-----------------------------------
+void at_sockbuf_free(at_sockbuf_t *b)
+{
+    while (b->first) {
+        at_sockbuf_chunk_t *chunk = b->first;
+        b->first = chunk->next;
+        sockbuf_chunk_release(chunk);
+    }
+    b->last = NULL;
+    b->length = 0;
+    b->hold = false;
+}
+
+// Append data to the socket buffer
+// Returns the number of bytes stored, the rest is counted as overflow
+//-------------------------------------------------------------------
+int at_sockbuf_put(at_sockbuf_t *b, const uint8_t *src, size_t len)
+{
+    size_t stored = 0;
+
+    while (stored < len) {
+        at_sockbuf_chunk_t *chunk = b->last;
+        if ((chunk == NULL) || (chunk->end >= AT_SOCKBUF_CHUNK_SIZE)) {
+            chunk = sockbuf_chunk_alloc();
+            if (chunk == NULL) break;
+            if (b->last) b->last->next = chunk;
+            else b->first = chunk;
+            b->last = chunk;
+        }
+        size_t n = AT_SOCKBUF_CHUNK_SIZE - chunk->end;
+        if (n > (len - stored)) n = len - stored;
+        memcpy(chunk->data + chunk->end, src + stored, n);
+        chunk->end += n;
+        stored += n;
+    }
+    b->length += stored;
+    b->overflow += len - stored;
+    if (b->length > b->max_used) b->max_used = b->length;
+    return stored;
+}
+
+// Get and remove data from the socket buffer
+// If 'dest' is NULL, the data is only removed
+// Emptied chunks are returned to the pool
+//-------------------------------------------------------------
+int at_sockbuf_get(at_sockbuf_t *b, uint8_t *dest, size_t len)
+{
+    size_t copied = 0;
+
+    while ((copied < len) && (b->first)) {
+        at_sockbuf_chunk_t *chunk = b->first;
+        size_t n = chunk->end - chunk->start;
+        if (n > (len - copied)) n = len - copied;
+        if (dest) memcpy(dest + copied, chunk->data + chunk->start, n);
+        chunk->start += n;
+        copied += n;
+        if (chunk->start == chunk->end) {
+            b->first = chunk->next;
+            if (b->first == NULL) b->last = NULL;
+            sockbuf_chunk_release(chunk);
+        }
+    }
+    b->length -= copied;
+    return copied;
+}
+
+// Find the pattern in the socket buffer
+// Returns the pattern position or -1 if not found
+//-------------------------------------------------------------------------------
+int at_sockbuf_find(at_sockbuf_t *b, const char *pattern, int pattern_length)
+{
+    int pos = 0;
+
+    if (pattern_length <= 0) return -1;
+    for (at_sockbuf_chunk_t *chunk = b->first; chunk; chunk = chunk->next) {
+        for (int i=chunk->start; i<chunk->end; i++, pos++) {
+            if (chunk->data[i] != (uint8_t)pattern[0]) continue;
+            // compare the rest, the pattern can continue in the next chunk(s)
+            at_sockbuf_chunk_t *c = chunk;
+            int idx = i, n = 0;
+            while (n < pattern_length) {
+                if (idx >= c->end) {
+                    c = c->next;
+                    if (c == NULL) return -1; // not enough data left
+                    idx = c->start;
+                    continue;
+                }
+                if (c->data[idx] != (uint8_t)pattern[n]) break;
+                idx++;
+                n++;
+            }
+            if (n == pattern_length) return pos;
+        }
+    }
+    return -1;
+}
+
+// Set the receive hold state of the socket buffer
+// Returns true if the state was changed
+//----------------------------------------------
+bool at_sockbuf_hold(at_sockbuf_t *b, bool hold)
+{
+    if (b->hold == hold) return false;
+    b->hold = hold;
+    if (hold) sockbuf_stats.holds++;
+    return true;
+}
+
+//-------------------------------------------------
+void at_sockbuf_get_stats(at_sockbuf_stats_t *stats)
+{
+    memcpy(stats, &sockbuf_stats, sizeof(at_sockbuf_stats_t));
+}
 
 // Read maximum of 'size' bytes from uart buffer, waiting maximum of 'timeout' ms
 // Number of actual bytes read is returned
@@ -186,6 +370,8 @@ static void _copy_to_buf(at_command_t *command, size_t from_pos, int copy_len)
  * Main function for dealing with sending AT commands and parsing the response
  * - this function should be executed protected by mutex
  * - disables semaphore handling
+ * - the responses are matched in the order they are received (see 'at_scan.h'),
+ *   if more responses end at the same byte, the one with the lowest index is returned
  *
  * params:
  *   cmd        command or data to send, can be NULL
@@ -270,80 +456,75 @@ int _at_Cmd_Response(at_command_t *command)
 
     // === Wait for and check the response for terminating string(s) ===
     command->result = 0;
-    size_t len = 0;
     int res, pos;
-    int max_resp_len = 0;
-    int min_resp_len = 10000;
-    size_t buf_len = 0, bufsize = 0;
-    int resp_len;
+    size_t buf_len = 0;
     uint8_t n_matched = 0;
     int wait_end = mp_hal_ticks_ms() + command->timeout;
+    at_scan_event_t event;
 
-    for (int i=0; i<command->responses->nresp; i++) {
-        if (command->responses->resp[i]) {
-            if (strlen(command->responses->resp[i]) > max_resp_len) max_resp_len = strlen(command->responses->resp[i]);
-            if (strlen(command->responses->resp[i]) < min_resp_len) min_resp_len = strlen(command->responses->resp[i]);
+    // Received data is scanned for all terminating strings at once, each byte only once
+    if (at_scanners[command->at_uart_num] == NULL) {
+        at_scanners[command->at_uart_num] = pvPortMalloc(sizeof(at_scanner_t));
+        if (at_scanners[command->at_uart_num] == NULL) {
+            if (command->dbg) {
+                LOGE(TAG, "AT RESPONSE: Error allocating response scanner");
+            }
+            return 0;
         }
+        at_scanners[command->at_uart_num]->key_len = 0;
     }
+    at_scanner_t *scanner = at_scanners[command->at_uart_num];
+    if (!at_scan_compile(scanner, (const char * const *)command->responses->resp, command->responses->nresp)) {
+        if (command->dbg) {
+            LOGE(TAG, "AT RESPONSE: Error compiling responses");
+        }
+        return 0;
+    }
+    at_scan_start(scanner, mpy_uarts[command->at_uart_num].uart_buf, buf_pos);
     res = 0;
     pos = -1;
 
     while(1) {
         mp_hal_wdt_reset();
-        if (len > buf_len) buf_len = len;
         res = 0;
-        vTaskDelay(2 / portTICK_PERIOD_MS);
-        if (mp_hal_ticks_ms() > wait_end) {
+        if (at_scan_next(scanner, mpy_uarts[command->at_uart_num].uart_buf, &event)) {
+            pos = event.pos;
+            res = event.pattern + 1;
+            n_matched++;
+            command->result = res;
+            // ** terminating string found **
+            // if the response buffer is provided, move the received data,
+            // including the terminating string from uart buffer (if requested) to the response buffer
+            // else, just remove the data from uart buffer or mark it blank
+            if (command->respbuff != NULL) {
+                _copy_to_buf(command, buf_pos, pos - buf_pos + ((command->not_include_cond) ? 0 : event.len));
+            }
+            if (command->flush) {
+                // Delete all uart buffer content up to and including the found response
+                uart_buf_remove(mpy_uarts[command->at_uart_num].uart_buf, pos + event.len);
+                buf_pos = 0;
+            }
+            else {
+                // Blank the found response
+                uart_buf_blank(mpy_uarts[command->at_uart_num].uart_buf, pos, event.len);
+            }
             if (command->dbg) {
-                LOGW(TAG, "AT COMMAND: TIMEOUT (%d ms, %lu)", command->timeout, buf_len);
+                int wait_time = command->timeout - (wait_end - (int)mp_hal_ticks_ms());
+                size_t recv_bytes = (command->respbuff != NULL) ? strlen(command->respbuff) : 0;
+                LOGM(TAG, "AT RESPONSE: match condition %d at position %d (%d ms, %lu byte(s), buf_start=%lu)", res, pos, wait_time, recv_bytes, buf_pos);
             }
+            // === terminating string found ===
+            if ((res == command->repeat) && (n_matched < command->responses->nresp)) continue; // match all responses requested
             break;
         }
-        // get the current buffer length (from initial position)
-        len = uart_buf_length(mpy_uarts[command->at_uart_num].uart_buf, &bufsize) - buf_pos;
-        if (len < min_resp_len) continue; // not enough characters to check
-
-        // Try to find the terminating string
-        for (int i=0; i<command->responses->nresp; i++) {
-            if (command->responses->resp[i]) {
-                resp_len = strlen(command->responses->resp[i]);
-                if (len >= resp_len) {
-                    pos = uart_buf_find_from(mpy_uarts[command->at_uart_num].uart_buf, buf_pos,
-                            bufsize, command->responses->resp[i], resp_len, NULL);
-                    if (pos >= 0) {
-                        res = i+1;
-                        n_matched++;
-                        command->result = res;
-                        // ** terminating string found **
-                        // if the response buffer is provided, move the received data,
-                        // including the terminating string from uart buffer (if requested) to the response buffer
-                        // else, just remove the data from uart buffer or mark it blank
-                        if (command->respbuff != NULL) {
-                            _copy_to_buf(command, buf_pos, pos - buf_pos + ((command->not_include_cond) ? 0 : resp_len));
-                        }
-                        if (command->flush) {
-                            // Delete all uart buffer content up to and including the found response
-                            uart_buf_remove(mpy_uarts[command->at_uart_num].uart_buf, pos + resp_len);
-                        }
-                        else {
-                            // Blank the found response
-                            uart_buf_blank(mpy_uarts[command->at_uart_num].uart_buf, pos, resp_len);
-                        }
-                        if (command->dbg) {
-                            int wait_time = command->timeout - (wait_end - (int)mp_hal_ticks_ms());
-                            size_t recv_bytes = (command->respbuff != NULL) ? strlen(command->respbuff) : 0;
-                            LOGM(TAG, "AT RESPONSE: match condition %d at position %d (%d ms, %lu byte(s), buf_start=%lu)", res, pos, wait_time, recv_bytes, buf_pos);
-                        }
-                        break;
-                    }
-                }
+        buf_len = uart_buf_length(mpy_uarts[command->at_uart_num].uart_buf, NULL) - buf_pos;
+        if (mp_hal_ticks_ms() > wait_end) {
+            if (command->dbg) {
+                LOGW(TAG, "AT COMMAND: TIMEOUT (%d ms, %lu)", command->timeout, buf_len);
             }
-        }
-        if (res > 0) {
-            // === terminating string found ===
-            if ((res == command->repeat) && (n_matched < command->responses->nresp)) continue; // match all responses requested
             break;
         }
+        vTaskDelay(2 / portTICK_PERIOD_MS);
     }
 
     if (res <= 0) {
@@ -0,0 +1,397 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "image_ops.h"
+
+// === Color conversion ===
+
+// 'dst' can be the same buffer as 'src'
+//=========================================================
+void image_to_gray(const uint16_t *src, uint8_t *dst, int npix)
+{
+    for (int i=0; i<npix; i++) dst[i] = image_rgb565_luma(src[i]);
+}
+
+// 'dst' can be the same buffer as 'src' (must have the size for RGB565 image)
+//===========================================================
+void image_to_rgb565(const uint8_t *src, uint16_t *dst, int npix)
+{
+    // backwards, so that the conversion can be done in place
+    for (int i=npix-1; i>=0; i--) {
+        uint32_t v = src[i];
+        dst[i] = ((v & 0xF8) << 8) | ((v & 0xFC) << 3) | (v >> 3);
+    }
+}
+
+// Copy the region of interest to the start of 'dst', 'dst' can be the same buffer as 'src'
+//=================================================================================================
+void image_crop(uint8_t *src, uint8_t *dst, int width, int bpp, int x, int y, int w, int h)
+{
+    for (int row=0; row<h; row++) {
+        memmove(dst + (row * w * bpp), src + ((((y + row) * width) + x) * bpp), w * bpp);
+    }
+}
+
+// === Statistics ===
+
+// Luminance histogram (256 bins) of the region of interest
+//=============================================================================================================
+void image_histogram(const uint8_t *data, int format, int width, int x, int y, int w, int h, uint32_t *hist)
+{
+    memset(hist, 0, 256 * sizeof(uint32_t));
+    for (int row=y; row<(y + h); row++) {
+        if (format == IMAGE_FORMAT_GRAYSCALE) {
+            const uint8_t *p = data + (row * width) + x;
+            for (int i=0; i<w; i++) hist[p[i]]++;
+        }
+        else {
+            const uint16_t *p = (const uint16_t *)data + (row * width) + x;
+            for (int i=0; i<w; i++) hist[image_rgb565_luma(p[i])]++;
+        }
+    }
+}
+
+//===================================================================
+void image_hist_stats(const uint32_t *hist, image_stats_t *stats)
+{
+    uint64_t sum = 0, sum2 = 0;
+    uint32_t count = 0;
+    memset(stats, 0, sizeof(image_stats_t));
+    for (int i=0; i<256; i++) {
+        count += hist[i];
+        sum += (uint64_t)hist[i] * i;
+        sum2 += (uint64_t)hist[i] * i * i;
+    }
+    stats->count = count;
+    if (count == 0) return;
+
+    int i = 0;
+    while (hist[i] == 0) i++;
+    stats->min = i;
+    i = 255;
+    while (hist[i] == 0) i--;
+    stats->max = i;
+    uint32_t acc = 0;
+    for (i=0; i<256; i++) {
+        acc += hist[i];
+        if ((acc * 2) >= count) break;
+    }
+    stats->median = i;
+    stats->mean = (sum + (count / 2)) / count;
+
+    // integer square root of the variance
+    uint64_t var = ((sum2 * count) - (sum * sum)) / ((uint64_t)count * count);
+    uint32_t sd = 0;
+    while (((uint64_t)(sd + 1) * (sd + 1)) <= var) sd++;
+    stats->stdev = sd;
+}
+
+// === Point operations ===
+
+// Pixels in range low ~ high are set to 255, all other to 0 (or the opposite if 'invert' is set)
+//=====================================================================================
+void image_threshold(uint8_t *data, int npix, uint8_t low, uint8_t high, bool invert)
+{
+    uint8_t in = (invert) ? 0 : 255;
+    uint8_t out = (invert) ? 255 : 0;
+    for (int i=0; i<npix; i++) data[i] = ((data[i] >= low) && (data[i] <= high)) ? in : out;
+}
+
+// Absolute difference of two images, if 'threshold' > 0 the result is binary (255 if difference > threshold)
+// Returns the number of pixels with the difference above threshold
+// 'dst' can be the same buffer as 'a' or 'b'
+//===================================================================================================
+uint32_t image_diff(uint8_t *dst, const uint8_t *a, const uint8_t *b, int npix, uint8_t threshold)
+{
+    uint32_t count = 0;
+    for (int i=0; i<npix; i++) {
+        int d = (int)a[i] - (int)b[i];
+        if (d < 0) d = -d;
+        if (d > threshold) count++;
+        if (threshold) d = (d > threshold) ? 255 : 0;
+        dst[i] = d;
+    }
+    return count;
+}
+
+// === Neighborhood operations ===
+
+// The 3x3 operations process the image row by row, the original content of the row above and the
+// current row are kept in the row buffer, the row below is not yet changed.
+// Edge pixels are repeated outside the image.
+
+#define IMAGE_3X3_PROCESS(op) \
+    uint8_t *above = rowbuf; \
+    uint8_t *cur = rowbuf + width; \
+    memcpy(cur, data, width); \
+    memcpy(above, data, width); \
+    for (int y=0; y<height; y++) { \
+        const uint8_t *below = (y < (height - 1)) ? data + ((y + 1) * width) : cur; \
+        uint8_t *out = data + (y * width); \
+        for (int x=0; x<width; x++) { \
+            int xl = (x > 0) ? x - 1 : 0; \
+            int xr = (x < (width - 1)) ? x + 1 : x; \
+            op; \
+        } \
+        uint8_t *tmp = above; \
+        above = cur; \
+        cur = tmp; \
+        if (y < (height - 1)) memcpy(cur, below, width); \
+    }
+
+// Sobel edge detection, the result is the gradient magnitude |gx| + |gy|
+// 'rowbuf' must have IMAGE_ROWBUF_SIZE(width) bytes
+//================================================================================
+void image_sobel(uint8_t *data, int width, int height, uint8_t *rowbuf)
+{
+    IMAGE_3X3_PROCESS(
+        int gx = ((int)above[xr] + (2 * cur[xr]) + below[xr]) - ((int)above[xl] + (2 * cur[xl]) + below[xl]);
+        int gy = ((int)below[xl] + (2 * below[x]) + below[xr]) - ((int)above[xl] + (2 * above[x]) + above[xr]);
+        int mag = ((gx < 0) ? -gx : gx) + ((gy < 0) ? -gy : gy);
+        out[x] = (mag > 255) ? 255 : mag
+    )
+}
+
+//---------------------------------------------------------------------------------------------
+static inline uint8_t min3(uint8_t a, uint8_t b, uint8_t c)
+{
+    uint8_t m = (a < b) ? a : b;
+    return (m < c) ? m : c;
+}
+
+//---------------------------------------------------------------------------------------------
+static inline uint8_t max3(uint8_t a, uint8_t b, uint8_t c)
+{
+    uint8_t m = (a > b) ? a : b;
+    return (m > c) ? m : c;
+}
+
+// 3x3 erosion (minimum) or dilation (maximum), works on grayscale and binary images
+// 'rowbuf' must have IMAGE_ROWBUF_SIZE(width) bytes
+//===============================================================================================
+void image_morph(uint8_t *data, int width, int height, bool dilate, uint8_t *rowbuf)
+{
+    if (dilate) {
+        IMAGE_3X3_PROCESS(
+            out[x] = max3(max3(above[xl], above[x], above[xr]), max3(cur[xl], cur[x], cur[xr]), max3(below[xl], below[x], below[xr]))
+        )
+    }
+    else {
+        IMAGE_3X3_PROCESS(
+            out[x] = min3(min3(above[xl], above[x], above[xr]), min3(cur[xl], cur[x], cur[xr]), min3(below[xl], below[x], below[xr]))
+        )
+    }
+}
+
+// Box or Gaussian blur with 3x3 or 5x5 kernel
+// The kernel is separable, the rows are filtered first, then the columns.
+// 'rowbuf' must have IMAGE_BLUR_ROWBUF_SIZE(width) bytes
+//=========================================================================================================
+void image_blur(uint8_t *data, int width, int height, int size, bool gaussian, uint8_t *rowbuf)
+{
+    static const uint8_t box_kernel[5] = { 1, 1, 1, 1, 1 };
+    static const uint8_t gauss3_kernel[3] = { 1, 2, 1 };
+    static const uint8_t gauss5_kernel[5] = { 1, 4, 6, 4, 1 };
+    int r = (size >= 5) ? 2 : 1;
+    const uint8_t *k = (gaussian) ? ((r == 2) ? gauss5_kernel : gauss3_kernel) : box_kernel;
+    uint32_t k0 = k[0], k1 = k[1], k2 = k[2];
+    uint32_t norm = 0;
+    for (int i=0; i<=(2*r); i++) norm += k[i];
+    uint32_t recip = (65536 + (norm / 2)) / norm;
+
+    // Horizontal pass, the row is copied to the line buffer with 'r' edge pixels repeated on both sides
+    uint8_t *line = rowbuf + ((r + 1) * width);
+    for (int y=0; y<height; y++) {
+        uint8_t *row = data + (y * width);
+        memcpy(line + 2, row, width);
+        line[0] = line[1] = row[0];
+        line[width + 2] = line[width + 3] = row[width - 1];
+        const uint8_t *l = line + 2 - r;
+        if (r == 1) {
+            for (int x=0; x<width; x++) {
+                row[x] = ((((k0 * l[x]) + (k1 * l[x+1]) + (k0 * l[x+2])) * recip) + 32768) >> 16;
+            }
+        }
+        else {
+            for (int x=0; x<width; x++) {
+                uint32_t sum = (k0 * (l[x] + l[x+4])) + (k1 * (l[x+1] + l[x+3])) + (k2 * l[x+2]);
+                row[x] = ((sum * recip) + 32768) >> 16;
+            }
+        }
+    }
+
+    // Vertical pass, the ring of 'r' rows above and the current row (all unchanged) is kept in the row buffer
+    uint8_t *ring[3];
+    for (int i=0; i<=r; i++) {
+        ring[i] = rowbuf + (i * width);
+        memcpy(ring[i], data, width);
+    }
+    for (int y=0; y<height; y++) {
+        // ring[0] is the top row, ring[r] is the current row
+        const uint8_t *b1 = (y < (height - 1)) ? data + ((y + 1) * width) : ring[r];
+        uint8_t *out = data + (y * width);
+        if (r == 1) {
+            const uint8_t *a1 = ring[0];
+            const uint8_t *c = ring[1];
+            for (int x=0; x<width; x++) {
+                out[x] = ((((k0 * a1[x]) + (k1 * c[x]) + (k0 * b1[x])) * recip) + 32768) >> 16;
+            }
+        }
+        else {
+            const uint8_t *a2 = ring[0];
+            const uint8_t *a1 = ring[1];
+            const uint8_t *c = ring[2];
+            const uint8_t *b2 = (y < (height - 2)) ? data + ((y + 2) * width) : b1;
+            for (int x=0; x<width; x++) {
+                uint32_t sum = (k0 * (a2[x] + b2[x])) + (k1 * (a1[x] + b1[x])) + (k2 * c[x]);
+                out[x] = ((sum * recip) + 32768) >> 16;
+            }
+        }
+        // shift the ring and save the next row
+        if (y < (height - 1)) {
+            uint8_t *tmp = ring[0];
+            for (int i=0; i<r; i++) ring[i] = ring[i + 1];
+            ring[r] = tmp;
+            memcpy(ring[r], data + ((y + 1) * width), width);
+        }
+    }
+}
+
+// === Blob detection ===
+
+//-------------------------------------------------------
+static inline uint16_t uf_find(uint16_t *parent, uint16_t l)
+{
+    while (parent[l] != l) {
+        parent[l] = parent[parent[l]];
+        l = parent[l];
+    }
+    return l;
+}
+
+// Merge two components, the statistics are kept in the root entry
+//-------------------------------------------------------------------------------------------
+static uint16_t uf_union(uint16_t *parent, image_blob_t *stats, uint16_t a, uint16_t b)
+{
+    a = uf_find(parent, a);
+    b = uf_find(parent, b);
+    if (a == b) return a;
+    if (b < a) {
+        uint16_t t = a;
+        a = b;
+        b = t;
+    }
+    parent[b] = a;
+    image_blob_t *sa = &stats[a];
+    image_blob_t *sb = &stats[b];
+    if (sb->x1 < sa->x1) sa->x1 = sb->x1;
+    if (sb->y1 < sa->y1) sa->y1 = sb->y1;
+    if (sb->x2 > sa->x2) sa->x2 = sb->x2;
+    if (sb->y2 > sa->y2) sa->y2 = sb->y2;
+    sa->area += sb->area;
+    sa->sum_x += sb->sum_x;
+    sa->sum_y += sb->sum_y;
+    return a;
+}
+
+// Find 8-connected components of pixels above the threshold
+// Only the labels of the previous and current row are kept, the components are merged
+// with union-find and their bounding box, area and centroid sums are accumulated on the fly.
+// 'work' must have IMAGE_BLOBS_WORK_SIZE(width, max_labels) bytes and be aligned to 4 bytes.
+// On return, '*blobs' points to the array of found blobs (inside the work buffer).
+// If the number of labels exceeds 'max_labels', '*overflow' is set and the new components are ignored.
+// Returns the number of blobs found
+//============================================================================================================
+int image_blobs(const uint8_t *data, int width, int height, uint8_t threshold, int max_labels, void *work, image_blob_t **blobs, bool *overflow)
+{
+    image_blob_t *stats = (image_blob_t *)work;
+    uint16_t *parent = (uint16_t *)(stats + max_labels);
+    uint16_t *prev = parent + max_labels;
+    uint16_t *cur = prev + width;
+    uint16_t nlabels = 1;  // label 0 is background
+    if (max_labels > 65535) max_labels = 65535;
+    *overflow = false;
+
+    memset(prev, 0, width * sizeof(uint16_t));
+    for (int y=0; y<height; y++) {
+        const uint8_t *row = data + (y * width);
+        for (int x=0; x<width; x++) {
+            if (row[x] <= threshold) {
+                cur[x] = 0;
+                continue;
+            }
+            uint16_t nb[4];
+            int nn = 0;
+            if ((x > 0) && cur[x-1]) nb[nn++] = cur[x-1];
+            if ((x > 0) && prev[x-1]) nb[nn++] = prev[x-1];
+            if (prev[x]) nb[nn++] = prev[x];
+            if ((x < (width - 1)) && prev[x+1]) nb[nn++] = prev[x+1];
+
+            uint16_t l;
+            if (nn == 0) {
+                if (nlabels >= max_labels) {
+                    *overflow = true;
+                    cur[x] = 0;
+                    continue;
+                }
+                l = nlabels++;
+                parent[l] = l;
+                image_blob_t *s = &stats[l];
+                s->x1 = s->x2 = x;
+                s->y1 = s->y2 = y;
+                s->area = 0;
+                s->sum_x = s->sum_y = 0;
+            }
+            else {
+                l = uf_find(parent, nb[0]);
+                for (int i=1; i<nn; i++) {
+                    if (nb[i] != nb[i-1]) l = uf_union(parent, stats, l, nb[i]);
+                }
+            }
+            cur[x] = l;
+            image_blob_t *s = &stats[l];
+            if (x < s->x1) s->x1 = x;
+            if (x > s->x2) s->x2 = x;
+            if (y > s->y2) s->y2 = y;
+            s->area++;
+            s->sum_x += x;
+            s->sum_y += y;
+        }
+        uint16_t *tmp = prev;
+        prev = cur;
+        cur = tmp;
+    }
+
+    // Collect the root components to the start of the statistics array
+    int nblobs = 0;
+    for (uint16_t l=1; l<nlabels; l++) {
+        if (parent[l] == l) stats[nblobs++] = stats[l];
+    }
+    *blobs = stats;
+    return nblobs;
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Image processing functions for RGB565 and grayscale image buffers
+ *
+ * All functions use integer arithmetic and work in place.
+ * Neighborhood operations process the image row by row and keep only
+ * the few original rows they still need in the row buffer provided by the caller,
+ * no frame sized temporary buffers are used.
+ * The functions do not depend on MicroPython and can be built on the host.
+ */
+
+#ifndef _IMAGE_OPS_H_
+#define _IMAGE_OPS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define IMAGE_FORMAT_RGB565     0   // 16-bit native RGB565 pixels (frame buffer format)
+#define IMAGE_FORMAT_GRAYSCALE  1   // 8-bit gray pixels
+
+// Size of the row buffer needed by the neighborhood operations, in bytes
+#define IMAGE_ROWBUF_SIZE(width)        (2 * (width))
+#define IMAGE_BLUR_ROWBUF_SIZE(width)   ((4 * (width)) + 4)
+
+// Size of the work buffer needed by image_blobs(), in bytes
+#define IMAGE_BLOBS_WORK_SIZE(width, max_labels)  ((2 * (width) * sizeof(uint16_t)) + ((max_labels) * (sizeof(uint16_t) + sizeof(image_blob_t))))
+
+typedef struct _image_stats_t {
+    uint32_t    count;
+    uint8_t     min;
+    uint8_t     max;
+    uint8_t     median;
+    uint8_t     mean;
+    uint8_t     stdev;
+} image_stats_t;
+
+typedef struct _image_blob_t {
+    uint16_t    x1, y1, x2, y2;     // bounding box
+    uint32_t    area;               // number of pixels
+    uint32_t    sum_x, sum_y;       // for the centroid
+} image_blob_t;
+
+// Convert RGB565 color to 8-bit luminance
+//----------------------------------------------
+static inline uint8_t image_rgb565_luma(uint16_t c)
+{
+    uint32_t r = ((c >> 8) & 0xF8) | (c >> 13);
+    uint32_t g = ((c >> 3) & 0xFC) | ((c >> 9) & 0x03);
+    uint32_t b = ((c << 3) & 0xF8) | ((c >> 2) & 0x07);
+    return ((77 * r) + (150 * g) + (29 * b) + 128) >> 8;
+}
+
+void image_to_gray(const uint16_t *src, uint8_t *dst, int npix);
+void image_to_rgb565(const uint8_t *src, uint16_t *dst, int npix);
+void image_crop(uint8_t *src, uint8_t *dst, int width, int bpp, int x, int y, int w, int h);
+void image_histogram(const uint8_t *data, int format, int width, int x, int y, int w, int h, uint32_t *hist);
+void image_hist_stats(const uint32_t *hist, image_stats_t *stats);
+void image_threshold(uint8_t *data, int npix, uint8_t low, uint8_t high, bool invert);
+void image_blur(uint8_t *data, int width, int height, int size, bool gaussian, uint8_t *rowbuf);
+void image_sobel(uint8_t *data, int width, int height, uint8_t *rowbuf);
+void image_morph(uint8_t *data, int width, int height, bool dilate, uint8_t *rowbuf);
+uint32_t image_diff(uint8_t *dst, const uint8_t *a, const uint8_t *b, int npix, uint8_t threshold);
+int image_blobs(const uint8_t *data, int width, int height, uint8_t threshold, int max_labels, void *work, image_blob_t **blobs, bool *overflow);
+
+#endif
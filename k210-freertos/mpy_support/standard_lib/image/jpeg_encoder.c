@@ -0,0 +1,611 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Baseline JPEG encoder
+ * Integer DCT (the 'islow' algorithm from IJG libjpeg) and
+ * the standard (JPEG Annex K) quantization and Huffman tables are used.
+ */
+
+#include <string.h>
+
+#include "jpeg_encoder.h"
+
+#define DCT_CONST_BITS  13
+#define DCT_PASS1_BITS  2
+#define DCT_DESCALE(x,n)  (((x) + (1 << ((n)-1))) >> (n))
+
+#define FIX_0_298631336  2446
+#define FIX_0_390180644  3196
+#define FIX_0_541196100  4433
+#define FIX_0_765366865  6270
+#define FIX_0_899976223  7373
+#define FIX_1_175875602  9633
+#define FIX_1_501321110  12299
+#define FIX_1_847759065  15137
+#define FIX_1_961570560  16069
+#define FIX_2_053119869  16819
+#define FIX_2_562915447  20995
+#define FIX_3_072711026  25172
+
+// zig-zag index to natural order index
+static const uint8_t zigzag[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+static const uint8_t std_lum_qtab[64] = {
+    16, 11, 10, 16,  24,  40,  51,  61,
+    12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,
+    14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,
+    24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103,  99
+};
+
+static const uint8_t std_chrom_qtab[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99
+};
+
+static const uint8_t dc_lum_bits[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+static const uint8_t dc_chrom_bits[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+static const uint8_t dc_vals[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+static const uint8_t ac_lum_bits[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d };
+static const uint8_t ac_lum_vals[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+static const uint8_t ac_chrom_bits[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+static const uint8_t ac_chrom_vals[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+// Huffman code tables, built from the standard tables on first use
+typedef struct _huff_table_t {
+    uint16_t    code[256];
+    uint8_t     size[256];
+} huff_table_t;
+
+static huff_table_t huff_dc[2];
+static huff_table_t huff_ac[2];
+static bool huff_tables_ready = false;
+
+//---------------------------------------------------------------------------------------------
+static void build_huff_table(huff_table_t *table, const uint8_t *bits, const uint8_t *vals)
+{
+    uint16_t code = 0;
+    int k = 0;
+    memset(table, 0, sizeof(huff_table_t));
+    for (int len=1; len<=16; len++) {
+        for (int i=0; i<bits[len-1]; i++) {
+            table->code[vals[k]] = code;
+            table->size[vals[k]] = len;
+            code++;
+            k++;
+        }
+        code <<= 1;
+    }
+}
+
+//----------------------------------
+static void build_huff_tables(void)
+{
+    if (huff_tables_ready) return;
+    build_huff_table(&huff_dc[0], dc_lum_bits, dc_vals);
+    build_huff_table(&huff_dc[1], dc_chrom_bits, dc_vals);
+    build_huff_table(&huff_ac[0], ac_lum_bits, ac_lum_vals);
+    build_huff_table(&huff_ac[1], ac_chrom_bits, ac_chrom_vals);
+    huff_tables_ready = true;
+}
+
+// === Output ===
+
+//-----------------------------------------------
+static void flush_output(jpeg_encoder_t *enc)
+{
+    if ((enc->out_len > 0) && (enc->error == JPEG_OK)) {
+        if (enc->write(enc->ctx, enc->out_buf, enc->out_len) != 0) enc->error = JPEG_ERR_WRITE;
+        else enc->total += enc->out_len;
+    }
+    enc->out_len = 0;
+}
+
+//-------------------------------------------------------------
+static inline void put_byte(jpeg_encoder_t *enc, uint8_t data)
+{
+    enc->out_buf[enc->out_len++] = data;
+    if (enc->out_len >= JPEG_OUT_BUF_SIZE) flush_output(enc);
+}
+
+//---------------------------------------------------------------
+static void put_word(jpeg_encoder_t *enc, uint16_t data)
+{
+    put_byte(enc, data >> 8);
+    put_byte(enc, data & 0xFF);
+}
+
+// Add 'size' bits to the entropy coded data, 0xFF bytes are followed by the stuffed 0x00
+//---------------------------------------------------------------------------------
+static inline void put_bits(jpeg_encoder_t *enc, uint32_t code, int size)
+{
+    enc->bit_buf = (enc->bit_buf << size) | (code & ((1U << size) - 1));
+    enc->bit_cnt += size;
+    while (enc->bit_cnt >= 8) {
+        enc->bit_cnt -= 8;
+        uint8_t c = (uint8_t)(enc->bit_buf >> enc->bit_cnt);
+        put_byte(enc, c);
+        if (c == 0xFF) put_byte(enc, 0);
+    }
+}
+
+// === Headers ===
+
+//----------------------------------------------------------------------------------------------
+static void write_huff_table(jpeg_encoder_t *enc, uint8_t id, const uint8_t *bits, const uint8_t *vals, int nvals)
+{
+    put_byte(enc, id);
+    for (int i=0; i<16; i++) put_byte(enc, bits[i]);
+    for (int i=0; i<nvals; i++) put_byte(enc, vals[i]);
+}
+
+//-----------------------------------------------
+static void write_headers(jpeg_encoder_t *enc)
+{
+    // Grayscale images are also written as YCbCr, with constant chroma
+    // (3 components are required by the TJpgDec decoder used by display module)
+    int ncomp = 3;
+    int ntab = 2;
+
+    // SOI, APP0 (JFIF)
+    put_word(enc, 0xFFD8);
+    static const uint8_t app0[18] = { 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00, 0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00 };
+    for (int i=0; i<18; i++) put_byte(enc, app0[i]);
+
+    // DQT
+    put_word(enc, 0xFFDB);
+    put_word(enc, 2 + (ntab * 65));
+    for (int t=0; t<ntab; t++) {
+        put_byte(enc, t);
+        for (int i=0; i<64; i++) put_byte(enc, enc->qtab[t][zigzag[i]]);
+    }
+
+    // SOF0
+    put_word(enc, 0xFFC0);
+    put_word(enc, 8 + (3 * ncomp));
+    put_byte(enc, 8);
+    put_word(enc, enc->out_height);
+    put_word(enc, enc->out_width);
+    put_byte(enc, ncomp);
+    for (int c=0; c<ncomp; c++) {
+        put_byte(enc, c + 1);
+        put_byte(enc, (c == 0) ? 0x22 : 0x11);
+        put_byte(enc, (c == 0) ? 0 : 1);
+    }
+
+    // DHT
+    put_word(enc, 0xFFC4);
+    put_word(enc, 2 + (ntab * ((17 + 12) + (17 + 162))));
+    write_huff_table(enc, 0x00, dc_lum_bits, dc_vals, 12);
+    write_huff_table(enc, 0x10, ac_lum_bits, ac_lum_vals, 162);
+    write_huff_table(enc, 0x01, dc_chrom_bits, dc_vals, 12);
+    write_huff_table(enc, 0x11, ac_chrom_bits, ac_chrom_vals, 162);
+
+    // SOS
+    put_word(enc, 0xFFDA);
+    put_word(enc, 6 + (2 * ncomp));
+    put_byte(enc, ncomp);
+    for (int c=0; c<ncomp; c++) {
+        put_byte(enc, c + 1);
+        put_byte(enc, (c == 0) ? 0x00 : 0x11);
+    }
+    put_byte(enc, 0);
+    put_byte(enc, 63);
+    put_byte(enc, 0);
+}
+
+// === Block coding ===
+
+// Forward DCT of 8x8 block, the result is scaled up by 8
+//------------------------------------
+static void fdct_islow(int32_t *data)
+{
+    int32_t tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+    int32_t tmp10, tmp11, tmp12, tmp13;
+    int32_t z1, z2, z3, z4, z5;
+    int32_t *p;
+
+    // Pass 1: rows
+    p = data;
+    for (int i=0; i<8; i++, p+=8) {
+        tmp0 = p[0] + p[7];
+        tmp7 = p[0] - p[7];
+        tmp1 = p[1] + p[6];
+        tmp6 = p[1] - p[6];
+        tmp2 = p[2] + p[5];
+        tmp5 = p[2] - p[5];
+        tmp3 = p[3] + p[4];
+        tmp4 = p[3] - p[4];
+
+        tmp10 = tmp0 + tmp3;
+        tmp13 = tmp0 - tmp3;
+        tmp11 = tmp1 + tmp2;
+        tmp12 = tmp1 - tmp2;
+
+        p[0] = (tmp10 + tmp11) * (1 << DCT_PASS1_BITS);
+        p[4] = (tmp10 - tmp11) * (1 << DCT_PASS1_BITS);
+        z1 = (tmp12 + tmp13) * FIX_0_541196100;
+        p[2] = DCT_DESCALE(z1 + (tmp13 * FIX_0_765366865), DCT_CONST_BITS - DCT_PASS1_BITS);
+        p[6] = DCT_DESCALE(z1 - (tmp12 * FIX_1_847759065), DCT_CONST_BITS - DCT_PASS1_BITS);
+
+        z1 = tmp4 + tmp7;
+        z2 = tmp5 + tmp6;
+        z3 = tmp4 + tmp6;
+        z4 = tmp5 + tmp7;
+        z5 = (z3 + z4) * FIX_1_175875602;
+        tmp4 *= FIX_0_298631336;
+        tmp5 *= FIX_2_053119869;
+        tmp6 *= FIX_3_072711026;
+        tmp7 *= FIX_1_501321110;
+        z1 *= -FIX_0_899976223;
+        z2 *= -FIX_2_562915447;
+        z3 = (z3 * -FIX_1_961570560) + z5;
+        z4 = (z4 * -FIX_0_390180644) + z5;
+
+        p[7] = DCT_DESCALE(tmp4 + z1 + z3, DCT_CONST_BITS - DCT_PASS1_BITS);
+        p[5] = DCT_DESCALE(tmp5 + z2 + z4, DCT_CONST_BITS - DCT_PASS1_BITS);
+        p[3] = DCT_DESCALE(tmp6 + z2 + z3, DCT_CONST_BITS - DCT_PASS1_BITS);
+        p[1] = DCT_DESCALE(tmp7 + z1 + z4, DCT_CONST_BITS - DCT_PASS1_BITS);
+    }
+
+    // Pass 2: columns
+    p = data;
+    for (int i=0; i<8; i++, p++) {
+        tmp0 = p[0*8] + p[7*8];
+        tmp7 = p[0*8] - p[7*8];
+        tmp1 = p[1*8] + p[6*8];
+        tmp6 = p[1*8] - p[6*8];
+        tmp2 = p[2*8] + p[5*8];
+        tmp5 = p[2*8] - p[5*8];
+        tmp3 = p[3*8] + p[4*8];
+        tmp4 = p[3*8] - p[4*8];
+
+        tmp10 = tmp0 + tmp3;
+        tmp13 = tmp0 - tmp3;
+        tmp11 = tmp1 + tmp2;
+        tmp12 = tmp1 - tmp2;
+
+        p[0*8] = DCT_DESCALE(tmp10 + tmp11, DCT_PASS1_BITS);
+        p[4*8] = DCT_DESCALE(tmp10 - tmp11, DCT_PASS1_BITS);
+        z1 = (tmp12 + tmp13) * FIX_0_541196100;
+        p[2*8] = DCT_DESCALE(z1 + (tmp13 * FIX_0_765366865), DCT_CONST_BITS + DCT_PASS1_BITS);
+        p[6*8] = DCT_DESCALE(z1 - (tmp12 * FIX_1_847759065), DCT_CONST_BITS + DCT_PASS1_BITS);
+
+        z1 = tmp4 + tmp7;
+        z2 = tmp5 + tmp6;
+        z3 = tmp4 + tmp6;
+        z4 = tmp5 + tmp7;
+        z5 = (z3 + z4) * FIX_1_175875602;
+        tmp4 *= FIX_0_298631336;
+        tmp5 *= FIX_2_053119869;
+        tmp6 *= FIX_3_072711026;
+        tmp7 *= FIX_1_501321110;
+        z1 *= -FIX_0_899976223;
+        z2 *= -FIX_2_562915447;
+        z3 = (z3 * -FIX_1_961570560) + z5;
+        z4 = (z4 * -FIX_0_390180644) + z5;
+
+        p[7*8] = DCT_DESCALE(tmp4 + z1 + z3, DCT_CONST_BITS + DCT_PASS1_BITS);
+        p[5*8] = DCT_DESCALE(tmp5 + z2 + z4, DCT_CONST_BITS + DCT_PASS1_BITS);
+        p[3*8] = DCT_DESCALE(tmp6 + z2 + z3, DCT_CONST_BITS + DCT_PASS1_BITS);
+        p[1*8] = DCT_DESCALE(tmp7 + z1 + z4, DCT_CONST_BITS + DCT_PASS1_BITS);
+    }
+}
+
+//------------------------------------------
+static inline int bit_length(uint32_t value)
+{
+    return (value) ? 32 - __builtin_clz(value) : 0;
+}
+
+// Transform, quantize and Huffman code one 8x8 block of level shifted samples
+//-----------------------------------------------------------------------
+static void encode_block(jpeg_encoder_t *enc, int32_t *block, int comp)
+{
+    int tab = (comp == 0) ? 0 : 1;
+    const uint16_t *recip = enc->qrecip[tab];
+    const huff_table_t *dc = &huff_dc[tab];
+    const huff_table_t *ac = &huff_ac[tab];
+    int16_t coef[64];
+    int last = 0;
+
+    fdct_islow(block);
+
+    // quantize in zig-zag order, division is replaced by multiplication with reciprocal value
+    for (int k=0; k<64; k++) {
+        int n = zigzag[k];
+        int32_t v = block[n];
+        if (v < 0) v = -(int32_t)(((uint32_t)(-v) * recip[n] + 0x8000) >> 16);
+        else v = (int32_t)(((uint32_t)v * recip[n] + 0x8000) >> 16);
+        coef[k] = v;
+        if (v) last = k;
+    }
+
+    // DC coefficient, coded as the difference from the previous block
+    int diff = coef[0] - enc->dc_pred[comp];
+    enc->dc_pred[comp] = coef[0];
+    int nbits = bit_length((diff < 0) ? -diff : diff);
+    put_bits(enc, dc->code[nbits], dc->size[nbits]);
+    if (nbits) put_bits(enc, (diff < 0) ? diff - 1 : diff, nbits);
+
+    // AC coefficients, run length of zeros and value
+    int run = 0;
+    for (int k=1; k<=last; k++) {
+        int v = coef[k];
+        if (v == 0) {
+            run++;
+            continue;
+        }
+        while (run > 15) {
+            put_bits(enc, ac->code[0xF0], ac->size[0xF0]);
+            run -= 16;
+        }
+        nbits = bit_length((v < 0) ? -v : v);
+        int sym = (run << 4) | nbits;
+        put_bits(enc, ac->code[sym], ac->size[sym]);
+        put_bits(enc, (v < 0) ? v - 1 : v, nbits);
+        run = 0;
+    }
+    if (last < 63) put_bits(enc, ac->code[0x00], ac->size[0x00]);
+}
+
+// === Pixel input ===
+
+// Get the RGB888 color of the output pixel, average of scale x scale source pixels
+//---------------------------------------------------------------------------------------------------------
+static inline void get_rgb(jpeg_encoder_t *enc, const uint8_t *row, int stride, int x, int *r, int *g, int *b)
+{
+    if (enc->scale == 1) {
+        uint32_t c = ((const uint16_t *)row)[x];
+        *r = ((c >> 8) & 0xF8) | (c >> 13);
+        *g = ((c >> 3) & 0xFC) | ((c >> 9) & 0x03);
+        *b = ((c << 3) & 0xF8) | ((c >> 2) & 0x07);
+        return;
+    }
+    int sr = 0, sg = 0, sb = 0;
+    x *= enc->scale;
+    for (int j=0; j<enc->scale; j++) {
+        const uint16_t *p = (const uint16_t *)(row + (j * stride)) + x;
+        for (int i=0; i<enc->scale; i++) {
+            uint32_t c = p[i];
+            sr += ((c >> 8) & 0xF8) | (c >> 13);
+            sg += ((c >> 3) & 0xFC) | ((c >> 9) & 0x03);
+            sb += ((c << 3) & 0xF8) | ((c >> 2) & 0x07);
+        }
+    }
+    *r = sr >> enc->scale_shift;
+    *g = sg >> enc->scale_shift;
+    *b = sb >> enc->scale_shift;
+}
+
+//---------------------------------------------------------------------------------
+static inline int get_gray(jpeg_encoder_t *enc, const uint8_t *row, int stride, int x)
+{
+    if (enc->scale == 1) return row[x];
+    int sum = 0;
+    x *= enc->scale;
+    for (int j=0; j<enc->scale; j++) {
+        const uint8_t *p = row + (j * stride) + x;
+        for (int i=0; i<enc->scale; i++) sum += p[i];
+    }
+    return sum >> enc->scale_shift;
+}
+
+// Encode one MCU (16x16 output pixels) starting at output column 'x0'
+// Rows and columns outside the image are filled by repeating the last row and column
+//--------------------------------------------------------------------------------------------------------
+static void encode_mcu(jpeg_encoder_t *enc, const uint8_t *src, int stride, int x0, int nrows)
+{
+    int32_t block[4][64];
+    int32_t csum[3][64];
+    int ncols = enc->out_width - x0;
+    if (ncols > 16) ncols = 16;
+
+    if (!enc->gray) memset(csum, 0, sizeof(csum));
+    for (int py=0; py<16; py++) {
+        const uint8_t *row = src + (((py < nrows) ? py : nrows - 1) * enc->scale * stride);
+        int32_t *yblk = block[(py >> 3) << 1] + ((py & 7) << 3);
+        int cidx = (py >> 1) << 3;
+        for (int px=0; px<16; px++) {
+            int x = x0 + ((px < ncols) ? px : ncols - 1);
+            int luma;
+            if (enc->format == JPEG_FORMAT_GRAYSCALE) luma = get_gray(enc, row, stride, x);
+            else {
+                int r, g, b;
+                get_rgb(enc, row, stride, x, &r, &g, &b);
+                luma = ((77 * r) + (150 * g) + (29 * b) + 128) >> 8;
+                if (!enc->gray) {
+                    csum[0][cidx + (px >> 1)] += r;
+                    csum[1][cidx + (px >> 1)] += g;
+                    csum[2][cidx + (px >> 1)] += b;
+                }
+            }
+            yblk[((px >> 3) << 6) + (px & 7)] = luma - 128;
+        }
+    }
+    for (int i=0; i<4; i++) encode_block(enc, block[i], 0);
+
+    if (enc->gray) {
+        // Constant chroma: zero DC difference and end of block
+        for (int i=0; i<2; i++) {
+            put_bits(enc, huff_dc[1].code[0], huff_dc[1].size[0]);
+            put_bits(enc, huff_ac[1].code[0], huff_ac[1].size[0]);
+        }
+        return;
+    }
+
+    // Chroma from the sum of 2x2 pixels colors
+    int32_t *cb = block[0];
+    int32_t *cr = block[1];
+    for (int i=0; i<64; i++) {
+        cb[i] = ((-43 * csum[0][i]) - (85 * csum[1][i]) + (128 * csum[2][i]) + 512) >> 10;
+        cr[i] = ((128 * csum[0][i]) - (107 * csum[1][i]) - (21 * csum[2][i]) + 512) >> 10;
+    }
+    encode_block(enc, cb, 1);
+    encode_block(enc, cr, 2);
+}
+
+// === Public functions ===
+
+// Initialize the encoder and write the JPEG headers
+// 'scale' is the source image downscale factor (1, 2, 4 or 8)
+// If 'gray' is set, only the luminance of RGB565 image is encoded
+//================================================================================================
+int jpeg_encoder_init(jpeg_encoder_t *enc, int width, int height, int format, bool gray, int quality, int scale, jpeg_write_func_t write, void *ctx)
+{
+    memset(enc, 0, sizeof(jpeg_encoder_t));
+    if ((scale != 1) && (scale != 2) && (scale != 4) && (scale != 8)) return JPEG_ERR_PARAM;
+    if ((format != JPEG_FORMAT_RGB565) && (format != JPEG_FORMAT_GRAYSCALE)) return JPEG_ERR_PARAM;
+    if ((width < scale) || (height < scale) || (width > 65535) || (height > 65535)) return JPEG_ERR_PARAM;
+    if (write == NULL) return JPEG_ERR_PARAM;
+
+    build_huff_tables();
+    enc->write = write;
+    enc->ctx = ctx;
+    enc->width = width;
+    enc->height = height;
+    enc->scale = scale;
+    enc->scale_shift = (scale == 8) ? 6 : ((scale == 4) ? 4 : ((scale == 2) ? 2 : 0));
+    enc->out_width = width / scale;
+    enc->out_height = height / scale;
+    enc->format = format;
+    enc->gray = (gray || (format == JPEG_FORMAT_GRAYSCALE)) ? 1 : 0;
+    enc->mcu_size = 16;
+
+    // scale the quantization tables, as in IJG libjpeg
+    if (quality < 1) quality = 1;
+    if (quality > 100) quality = 100;
+    int qscale = (quality < 50) ? (5000 / quality) : (200 - (quality * 2));
+    for (int i=0; i<64; i++) {
+        for (int t=0; t<2; t++) {
+            int q = ((((t == 0) ? std_lum_qtab[i] : std_chrom_qtab[i]) * qscale) + 50) / 100;
+            if (q < 1) q = 1;
+            if (q > 255) q = 255;
+            enc->qtab[t][i] = q;
+            enc->qrecip[t][i] = (65536 + (4 * q)) / (8 * q);
+        }
+    }
+
+    write_headers(enc);
+    return enc->error;
+}
+
+// Number of source rows needed to encode one strip
+//================================================
+int jpeg_encoder_strip_rows(jpeg_encoder_t *enc)
+{
+    return enc->mcu_size * enc->scale;
+}
+
+// Encode the next strip (MCU row) of the image
+// 'src' points to the first source row of the strip, 'rows' is the number of source rows available,
+// it can be less than jpeg_encoder_strip_rows() only for the last strip
+//=================================================================================
+int jpeg_encoder_strip(jpeg_encoder_t *enc, const uint8_t *src, int stride, int rows)
+{
+    if (enc->error != JPEG_OK) return enc->error;
+    int y0 = enc->mcu_row * enc->mcu_size;
+    if (y0 >= enc->out_height) return JPEG_ERR_ROWS;
+    int nrows = enc->out_height - y0;
+    if (nrows > enc->mcu_size) nrows = enc->mcu_size;
+    if (rows < (nrows * enc->scale)) return JPEG_ERR_ROWS;
+
+    for (int x0=0; x0<enc->out_width; x0+=enc->mcu_size) {
+        encode_mcu(enc, src, stride, x0, nrows);
+    }
+    enc->mcu_row++;
+    flush_output(enc);
+    return enc->error;
+}
+
+// Write the remaining bits and EOI marker
+// Returns the size of the encoded image or error code
+//=========================================
+int jpeg_encoder_finish(jpeg_encoder_t *enc)
+{
+    if (enc->error != JPEG_OK) return enc->error;
+    if ((enc->mcu_row * enc->mcu_size) < enc->out_height) return JPEG_ERR_ROWS;
+    // fill the last byte with 1 bits
+    if (enc->bit_cnt > 0) put_bits(enc, 0x7F, 8 - enc->bit_cnt);
+    put_word(enc, 0xFFD9);
+    flush_output(enc);
+    return (enc->error == JPEG_OK) ? (int)enc->total : enc->error;
+}
+
+// Encode the whole image from the buffer, 'stride' is the source row size in bytes
+// The encoder must be initialized by jpeg_encoder_init()
+//====================================================================================
+int jpeg_encoder_encode(jpeg_encoder_t *enc, const uint8_t *src, int stride)
+{
+    int strip_rows = jpeg_encoder_strip_rows(enc);
+    while ((enc->mcu_row * enc->mcu_size) < enc->out_height) {
+        int y = enc->mcu_row * strip_rows;
+        int res = jpeg_encoder_strip(enc, src + (y * stride), stride, enc->height - y);
+        if (res != JPEG_OK) return res;
+    }
+    return jpeg_encoder_finish(enc);
+}
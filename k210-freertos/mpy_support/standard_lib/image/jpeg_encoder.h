@@ -0,0 +1,88 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Baseline JPEG encoder for RGB565 and grayscale image buffers
+ *
+ * The image is encoded in strips of one MCU row (16 output rows),
+ * the source rows are read directly from the image buffer, no frame sized
+ * temporary buffers are used.
+ * Images are encoded as YCbCr with 4:2:0 chroma subsampling.
+ * The encoder does not depend on MicroPython and can be built on the host.
+ */
+
+#ifndef _JPEG_ENCODER_H_
+#define _JPEG_ENCODER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Input image formats
+#define JPEG_FORMAT_RGB565      0   // 16-bit native RGB565 pixels (frame buffer format)
+#define JPEG_FORMAT_GRAYSCALE   1   // 8-bit gray pixels
+
+#define JPEG_OUT_BUF_SIZE       1024
+
+// Error codes
+#define JPEG_OK                 0
+#define JPEG_ERR_PARAM          -1
+#define JPEG_ERR_WRITE          -2
+#define JPEG_ERR_ROWS           -3
+
+// Output function, must write all 'len' bytes and return 0 on success
+typedef int (*jpeg_write_func_t)(void *ctx, const uint8_t *data, uint32_t len);
+
+typedef struct _jpeg_encoder_t {
+    jpeg_write_func_t   write;
+    void                *ctx;
+    uint16_t            width;          // source image size
+    uint16_t            height;
+    uint16_t            out_width;      // encoded image size
+    uint16_t            out_height;
+    uint16_t            mcu_row;        // next MCU row to encode
+    uint8_t             format;
+    uint8_t             gray;           // encode luminance only
+    uint8_t             scale;          // source downscale factor, 1, 2, 4 or 8
+    uint8_t             scale_shift;
+    uint8_t             mcu_size;       // MCU size in output pixels
+    int                 error;
+    int                 dc_pred[3];
+    uint64_t            bit_buf;
+    int                 bit_cnt;
+    uint32_t            out_len;        // bytes in the output buffer
+    uint32_t            total;          // total bytes written
+    uint8_t             qtab[2][64];    // quantization tables, natural order
+    uint16_t            qrecip[2][64];  // 2^16 / (8 * quantization value)
+    uint8_t             out_buf[JPEG_OUT_BUF_SIZE];
+} jpeg_encoder_t;
+
+int jpeg_encoder_init(jpeg_encoder_t *enc, int width, int height, int format, bool gray, int quality, int scale, jpeg_write_func_t write, void *ctx);
+int jpeg_encoder_strip_rows(jpeg_encoder_t *enc);
+int jpeg_encoder_strip(jpeg_encoder_t *enc, const uint8_t *src, int stride, int rows);
+int jpeg_encoder_finish(jpeg_encoder_t *enc);
+int jpeg_encoder_encode(jpeg_encoder_t *enc, const uint8_t *src, int stride);
+
+#endif
@@ -0,0 +1,642 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "mpconfigport.h"
+
+#if MICROPY_USE_IMAGE
+
+#include <stdio.h>
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/stream.h"
+#include "py/objarray.h"
+#include "py/objlist.h"
+#include "mphalport.h"
+#include "syslog.h"
+
+#include "jpeg_encoder.h"
+#include "image_ops.h"
+
+// Image buffer
+typedef struct _image_buf_t {
+    uint8_t         *data;
+    uint8_t         *header;    // raw frame buffer header or NULL
+    int             width;
+    int             height;
+    int             format;
+    int             stride;
+} image_buf_t;
+
+// Get the image data from the buffer object
+// If the buffer starts with the 8-byte raw frame buffer header (width, height, 'rawB'),
+// as created by camera and display modules, the image data starts after the header
+// and, if the width is not given, the image size is taken from the header.
+//--------------------------------------------------------------------------------------------------------
+STATIC void get_image_buffer(mp_obj_t buf_obj, int width, int height, int format, mp_uint_t flags, image_buf_t *img)
+{
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_obj, &bufinfo, flags);
+
+    img->data = (uint8_t *)bufinfo.buf;
+    img->header = NULL;
+    size_t len = bufinfo.len;
+    if ((len >= 8) && (memcmp(img->data+4, "rawB", 4) == 0)) {
+        img->header = img->data;
+        if (width <= 0) {
+            width = *(uint16_t *)(img->data);
+            height = *(uint16_t *)(img->data+2);
+        }
+        img->data += 8;
+        len -= 8;
+    }
+    else if (width <= 0) {
+        mp_raise_ValueError("image size not given and no frame buffer header");
+    }
+    if ((format != IMAGE_FORMAT_RGB565) && (format != IMAGE_FORMAT_GRAYSCALE)) {
+        mp_raise_ValueError("unsupported image format");
+    }
+    int bpp = (format == IMAGE_FORMAT_RGB565) ? 2 : 1;
+    if ((width <= 0) || (height <= 0) || (len < ((size_t)width * height * bpp))) {
+        mp_raise_ValueError("buffer too small for the image size");
+    }
+    if ((bpp == 2) && ((uintptr_t)img->data & 1)) {
+        mp_raise_ValueError("RGB565 image buffer not aligned");
+    }
+    img->width = width;
+    img->height = height;
+    img->format = format;
+    img->stride = width * bpp;
+}
+
+// Get the region of interest (x, y, w, h) tuple, clipped to the image
+//-------------------------------------------------------------------------------------------------
+STATIC void get_image_roi(mp_obj_t roi_obj, image_buf_t *img, int *x, int *y, int *w, int *h)
+{
+    if (roi_obj == mp_const_none) {
+        *x = 0;
+        *y = 0;
+        *w = img->width;
+        *h = img->height;
+        return;
+    }
+    mp_obj_t *roi;
+    mp_obj_get_array_fixed_n(roi_obj, 4, &roi);
+    int x1 = mp_obj_get_int(roi[0]);
+    int y1 = mp_obj_get_int(roi[1]);
+    int x2 = x1 + mp_obj_get_int(roi[2]);
+    int y2 = y1 + mp_obj_get_int(roi[3]);
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 > img->width) x2 = img->width;
+    if (y2 > img->height) y2 = img->height;
+    if ((x2 <= x1) || (y2 <= y1)) {
+        mp_raise_ValueError("roi outside the image");
+    }
+    *x = x1;
+    *y = y1;
+    *w = x2 - x1;
+    *h = y2 - y1;
+}
+
+// Get the destination buffer, if not given the source buffer is used (in place operation)
+//----------------------------------------------------------------------------------------------
+STATIC uint8_t *get_image_dest(mp_obj_t dst_obj, image_buf_t *img, size_t size, mp_obj_t *res)
+{
+    if (dst_obj == mp_const_none) return img->data;
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(dst_obj, &bufinfo, MP_BUFFER_WRITE);
+    if (bufinfo.len < size) {
+        mp_raise_ValueError("destination buffer too small");
+    }
+    if ((uintptr_t)bufinfo.buf & 1) {
+        mp_raise_ValueError("destination buffer not aligned");
+    }
+    *res = dst_obj;
+    return (uint8_t *)bufinfo.buf;
+}
+
+//----------------------------------------------------------------------
+STATIC int jpeg_write_vstr(void *ctx, const uint8_t *data, uint32_t len)
+{
+    vstr_add_strn((vstr_t *)ctx, (const char *)data, len);
+    return 0;
+}
+
+//------------------------------------------------------------------------
+STATIC int jpeg_write_stream(void *ctx, const uint8_t *data, uint32_t len)
+{
+    int errcode = 0;
+    mp_uint_t written = mp_stream_rw((mp_obj_t)ctx, (void *)data, len, &errcode, MP_STREAM_RW_WRITE);
+    return ((errcode == 0) && (written == len)) ? 0 : -1;
+}
+
+// Encode RGB565 or grayscale image to JPEG
+// Returns bytearray with JPEG data or, if the stream is given, the number of bytes written
+//---------------------------------------------------------------------------------------------
+STATIC mp_obj_t image_jpeg(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_buf, ARG_width, ARG_height, ARG_format, ARG_quality, ARG_scale, ARG_gray, ARG_stream };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buf,      MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_width,                      MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_height,                     MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_format,   MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = JPEG_FORMAT_RGB565} },
+        { MP_QSTR_quality,  MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 50} },
+        { MP_QSTR_scale,    MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 1} },
+        { MP_QSTR_gray,     MP_ARG_KW_ONLY  | MP_ARG_BOOL, {.u_bool = false} },
+        { MP_QSTR_stream,   MP_ARG_KW_ONLY  | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    image_buf_t img;
+    get_image_buffer(args[ARG_buf].u_obj, args[ARG_width].u_int, args[ARG_height].u_int, args[ARG_format].u_int, MP_BUFFER_READ, &img);
+
+    int scale = args[ARG_scale].u_int;
+    if ((scale != 1) && (scale != 2) && (scale != 4) && (scale != 8)) {
+        mp_raise_ValueError("scale must be 1, 2, 4 or 8");
+    }
+
+    mp_obj_t stream = args[ARG_stream].u_obj;
+    vstr_t vstr;
+    jpeg_write_func_t write_func;
+    void *write_ctx;
+    if (stream != mp_const_none) {
+        mp_get_stream_raise(stream, MP_STREAM_OP_WRITE);
+        write_func = jpeg_write_stream;
+        write_ctx = (void *)stream;
+    }
+    else {
+        // initial size for about 10:1 compression
+        vstr_init(&vstr, ((img.width / scale) * (img.height / scale) / 5) + 1024);
+        write_func = jpeg_write_vstr;
+        write_ctx = (void *)&vstr;
+    }
+
+    jpeg_encoder_t *enc = m_new_obj(jpeg_encoder_t);
+    int res = jpeg_encoder_init(enc, img.width, img.height, img.format, args[ARG_gray].u_bool, args[ARG_quality].u_int, scale, write_func, write_ctx);
+    if (res == JPEG_OK) {
+        // Encode strip by strip, the output is written after each strip
+        int strip_rows = jpeg_encoder_strip_rows(enc);
+        for (int y=0; (y / scale) < (img.height / scale); y+=strip_rows) {
+            res = jpeg_encoder_strip(enc, img.data + (y * img.stride), img.stride, img.height - y);
+            if (res != JPEG_OK) break;
+            mp_hal_wdt_reset();
+        }
+        if (res == JPEG_OK) res = jpeg_encoder_finish(enc);
+    }
+    m_del_obj(jpeg_encoder_t, enc);
+
+    if (res < 0) {
+        if (stream == mp_const_none) vstr_clear(&vstr);
+        if (res == JPEG_ERR_WRITE) mp_raise_msg(&mp_type_OSError, "error writing JPEG data");
+        mp_raise_ValueError("JPEG encoding error");
+    }
+    if (stream != mp_const_none) return mp_obj_new_int(res);
+
+    vstr.buf = m_renew(char, vstr.buf, vstr.alloc, vstr.len);
+    return mp_obj_new_bytearray_by_ref(vstr.len, vstr.buf);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(image_jpeg_obj, 1, image_jpeg);
+
+// === Image processing ===
+// All functions work on RGB565 or grayscale image buffers, the results are written
+// in place unless the destination buffer is given.
+// The neighborhood operations use only a small row buffer, no frame sized buffers are allocated.
+
+// Convert RGB565 image to grayscale, returns the buffer with the result
+//-------------------------------------------------------------------------------------------
+STATIC mp_obj_t image_gray(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_buf, ARG_width, ARG_height, ARG_dst };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buf,      MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_width,                      MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_height,                     MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_dst,      MP_ARG_KW_ONLY  | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    image_buf_t img;
+    mp_obj_t res = args[ARG_buf].u_obj;
+    get_image_buffer(args[ARG_buf].u_obj, args[ARG_width].u_int, args[ARG_height].u_int, IMAGE_FORMAT_RGB565, MP_BUFFER_RW, &img);
+    uint8_t *dst = get_image_dest(args[ARG_dst].u_obj, &img, img.width * img.height, &res);
+
+    image_to_gray((const uint16_t *)img.data, dst, img.width * img.height);
+    return res;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(image_gray_obj, 1, image_gray);
+
+// Convert grayscale image to RGB565, returns the buffer with the result
+// For in place conversion, the buffer must have the size of RGB565 image
+//---------------------------------------------------------------------------------------------
+STATIC mp_obj_t image_rgb565(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_buf, ARG_width, ARG_height, ARG_dst };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buf,      MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_width,                      MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_height,                     MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_dst,      MP_ARG_KW_ONLY  | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    image_buf_t img;
+    mp_obj_t res = args[ARG_buf].u_obj;
+    // in place conversion needs the buffer size of the RGB565 image
+    int format = (args[ARG_dst].u_obj == mp_const_none) ? IMAGE_FORMAT_RGB565 : IMAGE_FORMAT_GRAYSCALE;
+    get_image_buffer(args[ARG_buf].u_obj, args[ARG_width].u_int, args[ARG_height].u_int, format, MP_BUFFER_RW, &img);
+    uint8_t *dst = get_image_dest(args[ARG_dst].u_obj, &img, img.width * img.height * 2, &res);
+
+    image_to_rgb565(img.data, (uint16_t *)dst, img.width * img.height);
+    return res;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(image_rgb565_obj, 1, image_rgb565);
+
+// Crop the image to the region of interest
+// The cropped image is copied to the start of the image data (or to the destination buffer).
+// If the buffer has the frame buffer header, the image size in the header is updated.
+// Returns the size of the cropped image
+//------------------------------------------------------------------------------------------
+STATIC mp_obj_t image_crop_img(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_buf, ARG_width, ARG_height, ARG_roi, ARG_format, ARG_dst };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buf,      MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_width,                      MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_height,                     MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_roi,      MP_ARG_KW_ONLY  | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_format,   MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = IMAGE_FORMAT_RGB565} },
+        { MP_QSTR_dst,      MP_ARG_KW_ONLY  | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    image_buf_t img;
+    int x, y, w, h;
+    mp_obj_t res = args[ARG_buf].u_obj;
+    get_image_buffer(args[ARG_buf].u_obj, args[ARG_width].u_int, args[ARG_height].u_int, args[ARG_format].u_int, MP_BUFFER_RW, &img);
+    get_image_roi(args[ARG_roi].u_obj, &img, &x, &y, &w, &h);
+    int bpp = img.stride / img.width;
+    uint8_t *dst = get_image_dest(args[ARG_dst].u_obj, &img, w * h * bpp, &res);
+
+    image_crop(img.data, dst, img.width, bpp, x, y, w, h);
+    if ((dst == img.data) && (img.header)) {
+        *(uint16_t *)(img.header) = w;
+        *(uint16_t *)(img.header+2) = h;
+    }
+    mp_obj_t tuple[2] = { mp_obj_new_int(w), mp_obj_new_int(h) };
+    return mp_obj_new_tuple(2, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(image_crop_obj, 1, image_crop_img);
+
+//--------------------------------------------------------------------------------------------------
+STATIC void image_get_histogram(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args, uint32_t *hist)
+{
+    enum { ARG_buf, ARG_width, ARG_height, ARG_roi, ARG_format };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buf,      MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_width,                      MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_height,                     MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_roi,      MP_ARG_KW_ONLY  | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_format,   MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = IMAGE_FORMAT_RGB565} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    image_buf_t img;
+    int x, y, w, h;
+    get_image_buffer(args[ARG_buf].u_obj, args[ARG_width].u_int, args[ARG_height].u_int, args[ARG_format].u_int, MP_BUFFER_READ, &img);
+    get_image_roi(args[ARG_roi].u_obj, &img, &x, &y, &w, &h);
+    image_histogram(img.data, img.format, img.width, x, y, w, h, hist);
+}
+
+// Returns the luminance histogram (list of 256 pixel counts)
+//-----------------------------------------------------------------------------------------------
+STATIC mp_obj_t image_histogram_img(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    uint32_t *hist = m_new(uint32_t, 256);
+    image_get_histogram(n_args, pos_args, kw_args, hist);
+
+    mp_obj_t list = mp_obj_new_list(256, NULL);
+    mp_obj_list_t *l = MP_OBJ_TO_PTR(list);
+    for (int i=0; i<256; i++) l->items[i] = mp_obj_new_int_from_uint(hist[i]);
+    m_del(uint32_t, hist, 256);
+    return list;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(image_histogram_obj, 1, image_histogram_img);
+
+// Returns the luminance statistics: (min, max, mean, median, stdev)
+//-----------------------------------------------------------------------------------------
+STATIC mp_obj_t image_stats(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    uint32_t *hist = m_new(uint32_t, 256);
+    image_stats_t stats;
+    image_get_histogram(n_args, pos_args, kw_args, hist);
+    image_hist_stats(hist, &stats);
+    m_del(uint32_t, hist, 256);
+
+    mp_obj_t tuple[5] = {
+        mp_obj_new_int(stats.min),
+        mp_obj_new_int(stats.max),
+        mp_obj_new_int(stats.mean),
+        mp_obj_new_int(stats.median),
+        mp_obj_new_int(stats.stdev),
+    };
+    return mp_obj_new_tuple(5, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(image_stats_obj, 1, image_stats);
+
+// Binary threshold of grayscale image, pixels in range low ~ high are set to 255, all others to 0
+//---------------------------------------------------------------------------------------------
+STATIC mp_obj_t image_threshold_img(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_buf, ARG_width, ARG_height, ARG_low, ARG_high, ARG_invert };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buf,      MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_width,                      MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_height,                     MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_low,      MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 128} },
+        { MP_QSTR_high,     MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 255} },
+        { MP_QSTR_invert,   MP_ARG_KW_ONLY  | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    image_buf_t img;
+    get_image_buffer(args[ARG_buf].u_obj, args[ARG_width].u_int, args[ARG_height].u_int, IMAGE_FORMAT_GRAYSCALE, MP_BUFFER_RW, &img);
+    int low = args[ARG_low].u_int;
+    int high = args[ARG_high].u_int;
+    if ((low < 0) || (high > 255) || (low > high)) {
+        mp_raise_ValueError("threshold range must be 0 <= low <= high <= 255");
+    }
+
+    image_threshold(img.data, img.width * img.height, low, high, args[ARG_invert].u_bool);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(image_threshold_obj, 1, image_threshold_img);
+
+// Box or Gaussian blur of grayscale image
+//----------------------------------------------------------------------------------------
+STATIC mp_obj_t image_blur_img(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_buf, ARG_width, ARG_height, ARG_size, ARG_gaussian };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buf,      MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_width,                      MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_height,                     MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_size,     MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 3} },
+        { MP_QSTR_gaussian, MP_ARG_KW_ONLY  | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    image_buf_t img;
+    get_image_buffer(args[ARG_buf].u_obj, args[ARG_width].u_int, args[ARG_height].u_int, IMAGE_FORMAT_GRAYSCALE, MP_BUFFER_RW, &img);
+    int size = args[ARG_size].u_int;
+    if ((size != 3) && (size != 5)) {
+        mp_raise_ValueError("kernel size must be 3 or 5");
+    }
+
+    size_t buf_size = IMAGE_BLUR_ROWBUF_SIZE(img.width);
+    uint8_t *rowbuf = m_new(uint8_t, buf_size);
+    image_blur(img.data, img.width, img.height, size, args[ARG_gaussian].u_bool, rowbuf);
+    m_del(uint8_t, rowbuf, buf_size);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(image_blur_obj, 1, image_blur_img);
+
+// Sobel edge detection on grayscale image
+//-----------------------------------------------------------------------------------------
+STATIC mp_obj_t image_sobel_img(size_t n_args, const mp_obj_t *args)
+{
+    image_buf_t img;
+    int width = (n_args > 1) ? mp_obj_get_int(args[1]) : 0;
+    int height = (n_args > 2) ? mp_obj_get_int(args[2]) : 0;
+    get_image_buffer(args[0], width, height, IMAGE_FORMAT_GRAYSCALE, MP_BUFFER_RW, &img);
+
+    size_t buf_size = IMAGE_ROWBUF_SIZE(img.width);
+    uint8_t *rowbuf = m_new(uint8_t, buf_size);
+    image_sobel(img.data, img.width, img.height, rowbuf);
+    m_del(uint8_t, rowbuf, buf_size);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(image_sobel_obj, 1, 3, image_sobel_img);
+
+//--------------------------------------------------------------------------------------------------
+STATIC mp_obj_t image_morph_img(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args, bool dilate)
+{
+    enum { ARG_buf, ARG_width, ARG_height, ARG_iterations };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buf,          MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_width,                          MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_height,                         MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_iterations,   MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 1} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    image_buf_t img;
+    get_image_buffer(args[ARG_buf].u_obj, args[ARG_width].u_int, args[ARG_height].u_int, IMAGE_FORMAT_GRAYSCALE, MP_BUFFER_RW, &img);
+
+    size_t buf_size = IMAGE_ROWBUF_SIZE(img.width);
+    uint8_t *rowbuf = m_new(uint8_t, buf_size);
+    for (int i=0; i<args[ARG_iterations].u_int; i++) {
+        image_morph(img.data, img.width, img.height, dilate, rowbuf);
+    }
+    m_del(uint8_t, rowbuf, buf_size);
+    return mp_const_none;
+}
+
+// Erosion (3x3 minimum) of grayscale or binary image
+//-----------------------------------------------------------------------------------------
+STATIC mp_obj_t image_erode(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    return image_morph_img(n_args, pos_args, kw_args, false);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(image_erode_obj, 1, image_erode);
+
+// Dilation (3x3 maximum) of grayscale or binary image
+//------------------------------------------------------------------------------------------
+STATIC mp_obj_t image_dilate(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    return image_morph_img(n_args, pos_args, kw_args, true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(image_dilate_obj, 1, image_dilate);
+
+// Difference of two grayscale images (frame differencing for motion detection)
+// If 'threshold' > 0, the pixels with the difference above the threshold are counted
+// and the difference image is binary.
+// The difference image is written to 'dst' buffer only if it is given ('dst' can be one of the images).
+// Returns the number of pixels with the difference above the threshold
+//----------------------------------------------------------------------------------------
+STATIC mp_obj_t image_diff_img(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_buf, ARG_buf2, ARG_width, ARG_height, ARG_threshold, ARG_dst };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buf,          MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_buf2,         MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_width,                          MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_height,                         MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_threshold,    MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_dst,          MP_ARG_KW_ONLY  | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    image_buf_t img, img2;
+    get_image_buffer(args[ARG_buf].u_obj, args[ARG_width].u_int, args[ARG_height].u_int, IMAGE_FORMAT_GRAYSCALE, MP_BUFFER_READ, &img);
+    get_image_buffer(args[ARG_buf2].u_obj, img.width, img.height, IMAGE_FORMAT_GRAYSCALE, MP_BUFFER_READ, &img2);
+    int threshold = args[ARG_threshold].u_int;
+    if ((threshold < 0) || (threshold > 255)) {
+        mp_raise_ValueError("threshold must be 0 ~ 255");
+    }
+
+    uint32_t count = 0;
+    if (args[ARG_dst].u_obj != mp_const_none) {
+        image_buf_t dst;
+        get_image_buffer(args[ARG_dst].u_obj, img.width, img.height, IMAGE_FORMAT_GRAYSCALE, MP_BUFFER_WRITE, &dst);
+        count = image_diff(dst.data, img.data, img2.data, img.width * img.height, threshold);
+    }
+    else {
+        // only count the pixels, row by row
+        uint8_t *rowbuf = m_new(uint8_t, img.width);
+        for (int y=0; y<img.height; y++) {
+            count += image_diff(rowbuf, img.data + (y * img.width), img2.data + (y * img.width), img.width, threshold);
+        }
+        m_del(uint8_t, rowbuf, img.width);
+    }
+    return mp_obj_new_int_from_uint(count);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(image_diff_obj, 2, image_diff_img);
+
+// Find connected components (blobs) of pixels above the threshold in grayscale image
+// Returns the list of blobs sorted by area (largest first): [(x, y, w, h, area, cx, cy), ...]
+//------------------------------------------------------------------------------------------
+STATIC mp_obj_t image_blobs_img(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_buf, ARG_width, ARG_height, ARG_threshold, ARG_min_area, ARG_max_blobs, ARG_max_labels };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buf,          MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_width,                          MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_height,                         MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_threshold,    MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 127} },
+        { MP_QSTR_min_area,     MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 1} },
+        { MP_QSTR_max_blobs,    MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 16} },
+        { MP_QSTR_max_labels,   MP_ARG_KW_ONLY  | MP_ARG_INT,  {.u_int = 1024} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    image_buf_t img;
+    get_image_buffer(args[ARG_buf].u_obj, args[ARG_width].u_int, args[ARG_height].u_int, IMAGE_FORMAT_GRAYSCALE, MP_BUFFER_READ, &img);
+    int threshold = args[ARG_threshold].u_int;
+    if ((threshold < 0) || (threshold > 255)) {
+        mp_raise_ValueError("threshold must be 0 ~ 255");
+    }
+    int max_labels = args[ARG_max_labels].u_int;
+    if ((max_labels < 16) || (max_labels > 65535)) {
+        mp_raise_ValueError("max_labels must be 16 ~ 65535");
+    }
+
+    // uint32_t array, so that the work buffer is aligned
+    size_t work_size = (IMAGE_BLOBS_WORK_SIZE(img.width, max_labels) + 3) / 4;
+    uint32_t *work = m_new(uint32_t, work_size);
+    image_blob_t *blobs;
+    bool overflow;
+    int nblobs = image_blobs(img.data, img.width, img.height, threshold, max_labels, work, &blobs, &overflow);
+    if (overflow) {
+        LOGW("IMAGE", "Too many labels, some blobs are not detected");
+    }
+
+    // Remove small blobs and sort by area
+    int n = 0;
+    for (int i=0; i<nblobs; i++) {
+        if (blobs[i].area < (uint32_t)args[ARG_min_area].u_int) continue;
+        image_blob_t b = blobs[i];
+        int j = n++;
+        while ((j > 0) && (blobs[j-1].area < b.area)) {
+            blobs[j] = blobs[j-1];
+            j--;
+        }
+        blobs[j] = b;
+    }
+    if (n > args[ARG_max_blobs].u_int) n = args[ARG_max_blobs].u_int;
+
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for (int i=0; i<n; i++) {
+        image_blob_t *b = &blobs[i];
+        mp_obj_t tuple[7] = {
+            mp_obj_new_int(b->x1),
+            mp_obj_new_int(b->y1),
+            mp_obj_new_int(b->x2 - b->x1 + 1),
+            mp_obj_new_int(b->y2 - b->y1 + 1),
+            mp_obj_new_int_from_uint(b->area),
+            mp_obj_new_int((b->sum_x + (b->area / 2)) / b->area),
+            mp_obj_new_int((b->sum_y + (b->area / 2)) / b->area),
+        };
+        mp_obj_list_append(list, mp_obj_new_tuple(7, tuple));
+    }
+    m_del(uint32_t, work, work_size);
+    return list;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(image_blobs_obj, 1, image_blobs_img);
+
+
+//===========================================================
+STATIC const mp_rom_map_elem_t image_module_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__),    MP_ROM_QSTR(MP_QSTR_image) },
+
+    { MP_ROM_QSTR(MP_QSTR_jpeg),        MP_ROM_PTR(&image_jpeg_obj) },
+    { MP_ROM_QSTR(MP_QSTR_gray),        MP_ROM_PTR(&image_gray_obj) },
+    { MP_ROM_QSTR(MP_QSTR_rgb565),      MP_ROM_PTR(&image_rgb565_obj) },
+    { MP_ROM_QSTR(MP_QSTR_crop),        MP_ROM_PTR(&image_crop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_histogram),   MP_ROM_PTR(&image_histogram_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stats),       MP_ROM_PTR(&image_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_threshold),   MP_ROM_PTR(&image_threshold_obj) },
+    { MP_ROM_QSTR(MP_QSTR_blur),        MP_ROM_PTR(&image_blur_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sobel),       MP_ROM_PTR(&image_sobel_obj) },
+    { MP_ROM_QSTR(MP_QSTR_erode),       MP_ROM_PTR(&image_erode_obj) },
+    { MP_ROM_QSTR(MP_QSTR_dilate),      MP_ROM_PTR(&image_dilate_obj) },
+    { MP_ROM_QSTR(MP_QSTR_diff),        MP_ROM_PTR(&image_diff_obj) },
+    { MP_ROM_QSTR(MP_QSTR_blobs),       MP_ROM_PTR(&image_blobs_obj) },
+
+    { MP_ROM_QSTR(MP_QSTR_RGB565),      MP_ROM_INT(IMAGE_FORMAT_RGB565) },
+    { MP_ROM_QSTR(MP_QSTR_GRAYSCALE),   MP_ROM_INT(IMAGE_FORMAT_GRAYSCALE) },
+};
+STATIC MP_DEFINE_CONST_DICT(image_module_globals, image_module_globals_table);
+
+//---------------------------------------
+const mp_obj_module_t mp_module_image = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&image_module_globals,
+};
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Incremental multi-pattern scanner for AT responses
+ *
+ * The pattern set is compiled into an Aho-Corasick automaton.
+ * Received bytes are fed to it only once, as they arrive in the uart ring buffer.
+ * The scan position is kept as the buffer's free running index, so the bytes removed
+ * from the buffer head by other functions are detected and the scan resumes from the new head.
+ *
+ * Matches are reported in stream order: the match which ends first in the received data
+ * is reported first, regardless of the pattern's index. If more patterns end at the same byte
+ * (one is the suffix of the other, "OK" and "SEND OK"), they are reported in pattern index order.
+ * Overlapping matches are all reported; a pattern never matches across the bytes removed
+ * from the buffer head while its match was partial.
+ */
+
+#ifndef _AT_SCAN_H_
+#define _AT_SCAN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "uart_ringbuf.h"
+
+#define AT_SCAN_MAX_PATTERNS    8
+#define AT_SCAN_MAX_STATES      128
+#define AT_SCAN_MAX_CLASSES     32
+// Size of the compiled patterns copy used to detect the pattern set change
+#define AT_SCAN_KEY_SIZE        128
+
+typedef struct _at_scan_event_t {
+    int             pattern;    // index of the matched pattern
+    size_t          pos;        // position of the match start, relative to the buffer head
+    size_t          len;        // length of the matched pattern
+} at_scan_event_t;
+
+typedef struct _at_scanner_t {
+    size_t          scan_pos;   // free running buffer index of the next byte to scan
+    uint8_t         npatterns;
+    uint8_t         nstates;
+    uint8_t         state;
+    uint8_t         pending;    // patterns ending at the last scanned byte, not yet reported
+    uint8_t         pattern_len[AT_SCAN_MAX_PATTERNS];
+    uint8_t         depth[AT_SCAN_MAX_STATES];
+    uint8_t         output[AT_SCAN_MAX_STATES];
+    uint8_t         char_class[256];
+    uint8_t         next[AT_SCAN_MAX_STATES][AT_SCAN_MAX_CLASSES];
+    uint16_t        key_len;    // length of 'key', 0 if the patterns are not known
+    char            key[AT_SCAN_KEY_SIZE]; // compiled patterns, '\0' separated
+} at_scanner_t;
+
+bool at_scan_init(at_scanner_t *sc, const char * const *patterns, int npatterns);
+bool at_scan_compile(at_scanner_t *sc, const char * const *patterns, int npatterns);
+void at_scan_start(at_scanner_t *sc, uart_ringbuf_t *r, size_t pos);
+bool at_scan_next(at_scanner_t *sc, uart_ringbuf_t *r, at_scan_event_t *event);
+size_t at_scan_unmatched(at_scanner_t *sc, uart_ringbuf_t *r);
+
+#endif
@@ -65,6 +65,11 @@
 #define BDRATES_MAX             6
 #define MAX_SERVER_CONNECTIONS  4
 
+// Socket receive buffers are chained chunks from the shared pool
+#define AT_SOCKBUF_CHUNK_SIZE   1460
+#define AT_SOCKBUF_POOL_CHUNKS  16
+#define AT_SOCKBUF_QUOTA        (4 * AT_SOCKBUF_CHUNK_SIZE)
+
 #define AT_OK_Str               "\r\nOK\r\n"
 #define AT_Error_Str            "\r\nERROR\r\n"
 #define AT_Fail_Str             "FAIL"
@@ -75,6 +80,31 @@
 #define ACTIVE_INTERFACE_WIFI       2
 #define ACTIVE_INTERFACE_LWIP       4
 
+typedef struct _at_sockbuf_chunk_t {
+    struct _at_sockbuf_chunk_t  *next;
+    uint16_t                    start;      // read position
+    uint16_t                    end;        // write position
+    uint8_t                     data[AT_SOCKBUF_CHUNK_SIZE];
+} at_sockbuf_chunk_t;
+
+typedef struct _at_sockbuf_t {
+    at_sockbuf_chunk_t      *first;
+    at_sockbuf_chunk_t      *last;
+    size_t                  length;
+    size_t                  quota;          // receiving is held if more data is buffered
+    size_t                  overflow;
+    size_t                  max_used;
+    bool                    hold;
+} at_sockbuf_t;
+
+typedef struct _at_sockbuf_stats_t {
+    uint32_t                chunks;         // pool size
+    uint32_t                free;           // free pool chunks
+    uint32_t                min_free;       // minimal number of free pool chunks
+    uint32_t                heap_chunks;    // chunks allocated from heap, pool was empty
+    uint32_t                holds;          // receiving held because of the socket quota
+} at_sockbuf_stats_t;
+
 typedef struct _socket_obj_t {
     mp_obj_base_t           base;
     int                     fd;
@@ -88,7 +118,7 @@ typedef struct _socket_obj_t {
     mp_obj_t                events_callback;
     struct _socket_obj_t    *events_next;
     #endif
-    uart_ringbuf_t          buffer;
+    at_sockbuf_t            buffer;
     bool                    listening;
     bool                    accepting;
     bool                    is_accepted;
@@ -101,7 +131,6 @@ typedef struct _socket_obj_t {
     uint32_t                connected_time;
     mp_obj_t                cb;
     uint32_t                total_received;
-    mp_obj_t                static_buffer;
     QueueSetMemberHandle_t  semaphore;
     QueueHandle_t           mutex;
     char                    local_ip[16];
@@ -152,6 +181,14 @@ extern char at_canonname[DNS_MAX_NAME_LENGTH+1];
 socket_obj_t *_new_socket();
 int setNTP_cb(void *cb_func);
 
+void at_sockbuf_init(at_sockbuf_t *b, size_t quota);
+void at_sockbuf_free(at_sockbuf_t *b);
+int at_sockbuf_put(at_sockbuf_t *b, const uint8_t *src, size_t len);
+int at_sockbuf_get(at_sockbuf_t *b, uint8_t *dest, size_t len);
+int at_sockbuf_find(at_sockbuf_t *b, const char *pattern, int pattern_length);
+bool at_sockbuf_hold(at_sockbuf_t *b, bool hold);
+void at_sockbuf_get_stats(at_sockbuf_stats_t *stats);
+
 int at_uart_read_bytes(int uart_n, uint8_t *data, uint32_t size, uint32_t timeout);
 int at_uart_write(int uart_n, const uint8_t *data, size_t size);
 void at_uart_flush(int uart_n);
@@ -0,0 +1,53 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Camera frame to display frame buffer conversion
+ * The functions do not depend on the display or camera hardware or on MicroPython.
+ */
+
+#ifndef _CAMFRAME_H_
+#define _CAMFRAME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Swap the pixels in both RGB565 pixel pairs of the 64-bit word (camera pixel order)
+#define RGB565_SWAP_PAIRS64(v)  ((((v) >> 16) & 0x0000FFFF0000FFFFULL) | (((v) & 0x0000FFFF0000FFFFULL) << 16))
+
+// Frame buffer window written by camframe_convert() (inclusive coordinates)
+typedef struct _camframe_win_t {
+    int x1;
+    int y1;
+    int x2;
+    int y2;
+} camframe_win_t;
+
+bool camframe_convert(uint16_t *fb, int fb_width, int fb_height, int x1, int y1, int dst_width, int dst_height,
+                      const uint16_t *buf, int width, int height, uint8_t rot, bool bilinear, camframe_win_t *win);
+void camframe_fit(int width, int height, uint8_t rot, bool bilinear, int disp_width, int disp_height, int *dst_width, int *dst_height);
+
+#endif
@@ -107,6 +107,7 @@ void littleFlash_term();
 
 MP_DECLARE_CONST_FUN_OBJ_3(littlefs_vfs_open_obj);
 MP_DECLARE_CONST_FUN_OBJ_3(littlefs_vfs_open_ex_obj);
+MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(mod_os_flashcache_obj);
 
 #endif // MICROPY_VFS_LITTLEFS
 
@@ -9,8 +9,8 @@
 
 #include "modmachine.h"
 #include "py/runtime.h"
+#include "uart_ringbuf.h"
 
-#define UART_NUM_MAX            3
 #define UART_PIN_NO_CHANGE      -1
 
 #define UART_CB_TYPE_DATA		1
@@ -67,17 +67,6 @@ typedef struct _uart_driver_t {
     sysctl_clock_t clock;
 } uart_driver_t;
 
-typedef struct _uart_ringbuf_t {
-    size_t size;
-    size_t head;
-    size_t tail;
-    size_t length;
-    size_t overflow;
-    uint8_t *buf;
-    uint8_t uart_num;
-    uint8_t notify;
-} uart_ringbuf_t;
-
 typedef struct _uart_uarts_t {
     bool active;
     handle_t handle;
@@ -96,17 +85,6 @@ void mp_uart_close(uint32_t uart_num);
 char *_uart_read(handle_t uart_num, int timeout, char *lnend, char *lnstart);
 int uart_write(uint32_t uart_num, const uint8_t *buff, size_t len);
 int match_pattern(uint8_t *text, int text_length, uint8_t *pattern, int pattern_length);
-int uart_buf_put(uart_ringbuf_t *r, uint8_t *src, size_t len);
-int uart_buf_remove_from_end(uart_ringbuf_t *r, size_t len);
-size_t uart_buf_length(uart_ringbuf_t *r, size_t *size);
-int uart_buf_get(uart_ringbuf_t *r, uint8_t *dest, size_t len);
-int uart_buf_blank(uart_ringbuf_t *r, size_t pos, size_t len);
-int uart_buf_remove(uart_ringbuf_t *r, size_t len);
-int uart_buf_copy(uart_ringbuf_t *r, uint8_t *dest, size_t len);
-int uart_buf_copy_from(uart_ringbuf_t *r, size_t pos, uint8_t *dest, size_t len);
-int uart_buf_find_from(uart_ringbuf_t *r, size_t start_pos, size_t size, const char *pattern, int pattern_length, size_t *buflen);
-int uart_buf_find(uart_ringbuf_t *r, size_t size, const char *pattern, int pattern_length, size_t *buflen);
-void uart_buf_flush(uart_ringbuf_t *r);
 void uart_ringbuf_alloc(uint8_t uart_num, size_t sz);
 int uart_hard_init(uint32_t uart_num, uint8_t tx, int8_t rx, gpio_pin_func_t func, bool mutex, bool semaphore, int rb_size);
 bool uart_deinit(uint32_t uart_num, uint8_t *end_task, uint8_t tx, uint8_t rx);
@@ -27,6 +27,7 @@
 #ifndef MICROPY_MODMACHINE_H
 #define MICROPY_MODMACHINE_H
 
+#include <stddef.h>
 #include "FreeRTOS.h"
 #include "task.h"
 #include "pin_cfg.h"
@@ -267,6 +268,8 @@ typedef struct _mpy_flash_config_t {
     uint32_t    log_level;
     uint32_t    vm_divisor;
     bool        log_color;
+    uint32_t    gc_mode;            // GC allocation threshold mode
+    int32_t     gc_target;          // GC threshold mode target, 0 for default
 } __attribute__((aligned(8))) mpy_flash_config_t;
 
 typedef struct _mpy_config_t {
@@ -274,6 +277,11 @@ typedef struct _mpy_config_t {
     uint32_t           crc;
 } __attribute__((aligned(8))) mpy_config_t;
 
+// The configuration saved by the previous version is the part of 'mpy_flash_config_t'
+// before 'gc_mode', followed by its crc. It is migrated, the new fields get the defaults.
+#define MPY_CONFIG_PREV_VERSION_NUM     (0x011201)
+#define MPY_CONFIG_PREV_SIZE            ((offsetof(mpy_flash_config_t, gc_mode) + 7) & ~7)
+
 
 enum term_colors_t {
     BLACK = 0,
@@ -0,0 +1,76 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Single producer / single consumer ring buffer used for the uart and socket data
+ * The functions do not depend on the uart hardware or on MicroPython.
+ */
+
+#ifndef _UART_RINGBUF_H_
+#define _UART_RINGBUF_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define UART_NUM_MAX            3
+
+// Buffer index of the free running index 'i'
+#define RINGBUF_IDX(r, i)   ((i) & ((r)->size - 1))
+
+// Single producer / single consumer ring buffer
+// size is power of 2, 'head' and 'tail' are free running indexes
+// the buffers with 'uart_num' < UART_NUM_MAX are filled by the uart ISR
+typedef struct _uart_ringbuf_t {
+    size_t size;
+    volatile size_t head;       // changed only by the consumer
+    volatile size_t tail;       // changed only by the producer
+    size_t overflow;            // number of bytes dropped because the buffer was full, changed only by the producer
+    size_t overflow_ack;        // 'overflow' value at the last flush, changed only by the consumer
+    size_t max_used;            // high watermark
+    uint8_t *buf;
+    uint8_t uart_num;
+    uint8_t notify;
+} uart_ringbuf_t;
+
+size_t uart_buf_pow2_size(size_t size);
+void uart_buf_init(uart_ringbuf_t *r, uint8_t *buf, size_t size, uint8_t uart_num);
+void uart_buf_set_tail(uart_ringbuf_t *r, size_t tail);
+size_t uart_buf_overflow(uart_ringbuf_t *r);
+int uart_buf_put(uart_ringbuf_t *r, uint8_t *src, size_t len);
+int uart_buf_remove_from_end(uart_ringbuf_t *r, size_t len);
+size_t uart_buf_length(uart_ringbuf_t *r, size_t *size);
+size_t uart_buf_peek(uart_ringbuf_t *r, size_t pos, uint8_t **data);
+int uart_buf_get(uart_ringbuf_t *r, uint8_t *dest, size_t len);
+int uart_buf_blank(uart_ringbuf_t *r, size_t pos, size_t len);
+int uart_buf_remove(uart_ringbuf_t *r, size_t len);
+int uart_buf_copy(uart_ringbuf_t *r, uint8_t *dest, size_t len);
+int uart_buf_copy_from(uart_ringbuf_t *r, size_t pos, uint8_t *dest, size_t len);
+int uart_buf_find_from(uart_ringbuf_t *r, size_t start_pos, size_t size, const char *pattern, int pattern_length, size_t *buflen);
+int uart_buf_find(uart_ringbuf_t *r, size_t size, const char *pattern, int pattern_length, size_t *buflen);
+void uart_buf_flush(uart_ringbuf_t *r);
+
+#endif
@@ -140,6 +140,7 @@ const char *spiffs_local_path(const char *path);
 
 MP_DECLARE_CONST_FUN_OBJ_3(spiffs_vfs_open_obj);
 MP_DECLARE_CONST_FUN_OBJ_3(spiffs_vfs_open_ex_obj);
+MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(mod_os_flashcache_obj);
 
 #endif
 
@@ -0,0 +1,595 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * KPU (Neural Network Processor) module
+ *
+ * Runs kmodel (V3) models using the SDK's KPU driver.
+ * The model is loaded from file or from Flash directly into the FreeRTOS heap,
+ * MicroPython heap is not used for the model data.
+ *
+ * The model can not be used in place from Flash, even if the Flash can be read
+ * memory mapped (XIP, at SPI3_BASE_ADDR):
+ *  - the KPU fetches the convolution weights, batch normalization and activation
+ *    tables itself; the driver gives their addresses as SRAM address - IOMEM
+ *    (the uncached SRAM alias), the XIP window can not be addressed that way
+ *  - the driver asserts the model buffer is in cached SRAM and writes the model
+ *    body through the uncached alias when the model is loaded
+ *  - XIP mode would have to stay enabled while the model is used, the Flash
+ *    could not be used by the file system in that time
+ */
+
+#include "mpconfigport.h"
+
+#if MICROPY_USE_KPU
+
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "devices.h"
+#include "kpu.h"
+#include "kpu_layers.h"
+#include "syslog.h"
+
+#include "py/runtime.h"
+#include "py/stream.h"
+#include "py/objarray.h"
+#include "py/objlist.h"
+#include "extmod/vfs.h"
+#include "mphalport.h"
+#include "mpthreadport.h"
+#include "w25qxx.h"
+
+#define KPU_MODEL_VERSION       3
+#define KPU_MODEL_MAX_LAYERS    1024
+
+static const char *TAG = "[KPU]";
+
+typedef struct _kpu_model_obj_t {
+    mp_obj_base_t   base;
+    handle_t        handle;
+    uint8_t         *model;         // model data, allocated from FreeRTOS heap
+    uint32_t        model_size;
+    uint8_t         *input;         // buffer for converted input data, allocated from FreeRTOS heap
+    uint32_t        input_size;
+    uint16_t        in_width;
+    uint16_t        in_height;
+    uint8_t         in_channels;
+    bool            profile;
+    volatile bool   busy;
+    int             result;
+    mp_obj_t        callback;
+    TaskHandle_t    caller_task;
+} kpu_model_obj_t;
+
+// Model source, file or Flash address
+typedef struct _model_src_t {
+    mp_obj_t    file;
+    uint32_t    flash_addr;
+} model_src_t;
+
+const mp_obj_type_t kpu_model_type;
+
+// Sequential read from the model source
+// The Flash is read with the w25qxx driver, the model is copied to SRAM (see the module comment)
+//---------------------------------------------------------------------
+STATIC bool model_read(model_src_t *src, uint8_t *buf, uint32_t len)
+{
+    if (src->file != MP_OBJ_NULL) {
+        return (mp_stream_posix_read((void *)src->file, buf, len) == len);
+    }
+    uint32_t offset = 0;
+    while (offset < len) {
+        uint32_t size = len - offset;
+        if (size > 4096) size = 4096;
+        if (w25qxx_read_data(src->flash_addr, buf + offset, size) != W25QXX_OK) return false;
+        src->flash_addr += size;
+        offset += size;
+        mp_hal_wdt_reset();
+    }
+    return true;
+}
+
+// Read the model into the buffer allocated from FreeRTOS heap
+// The model size is calculated from the model header and layer headers
+//---------------------------------------------------------------
+STATIC uint8_t *model_load(model_src_t *src, uint32_t *model_size)
+{
+    kpu_model_header_t header;
+    if (!model_read(src, (uint8_t *)&header, sizeof(kpu_model_header_t))) {
+        mp_raise_msg(&mp_type_OSError, "error reading model");
+    }
+    if ((header.version != KPU_MODEL_VERSION) || (header.arch != 0) ||
+        (header.layers_length == 0) || (header.layers_length > KPU_MODEL_MAX_LAYERS) || (header.output_count == 0)) {
+        mp_raise_ValueError("not a supported kmodel");
+    }
+
+    // Read outputs and layer headers
+    uint32_t headers_size = (header.output_count * sizeof(kpu_model_output_t)) + (header.layers_length * sizeof(kpu_model_layer_header_t));
+    uint8_t *headers = m_new(uint8_t, headers_size);
+    if (!model_read(src, headers, headers_size)) {
+        m_del(uint8_t, headers, headers_size);
+        mp_raise_msg(&mp_type_OSError, "error reading model");
+    }
+    const kpu_model_layer_header_t *layer_headers = (const kpu_model_layer_header_t *)(headers + (header.output_count * sizeof(kpu_model_output_t)));
+    uint32_t size = sizeof(kpu_model_header_t) + headers_size;
+    for (int i=0; i<header.layers_length; i++) {
+        size += layer_headers[i].body_size;
+    }
+
+    uint8_t *model = pvPortMalloc(size);
+    if (model == NULL) {
+        m_del(uint8_t, headers, headers_size);
+        mp_raise_msg(&mp_type_OSError, "not enough memory for the model");
+    }
+    memcpy(model, &header, sizeof(kpu_model_header_t));
+    memcpy(model + sizeof(kpu_model_header_t), headers, headers_size);
+    m_del(uint8_t, headers, headers_size);
+
+    uint32_t offset = sizeof(kpu_model_header_t) + headers_size;
+    if (!model_read(src, model + offset, size - offset)) {
+        vPortFree(model);
+        mp_raise_msg(&mp_type_OSError, "error reading model");
+    }
+    *model_size = size;
+    return model;
+}
+
+// Get the model input size from the first (KPU convolution) layer
+//------------------------------------------------------
+STATIC bool model_input_size(kpu_model_obj_t *self)
+{
+    const kpu_model_header_t *header = (const kpu_model_header_t *)self->model;
+    const kpu_model_layer_header_t *layer_headers = (const kpu_model_layer_header_t *)(self->model + sizeof(kpu_model_header_t) + (header->output_count * sizeof(kpu_model_output_t)));
+    if (layer_headers[0].type != KL_K210_CONV) return false;
+
+    const kpu_model_conv_layer_argument_t *first_layer = (const kpu_model_conv_layer_argument_t *)(layer_headers + header->layers_length);
+    if ((first_layer->layer_offset + sizeof(kpu_layer_argument_t)) > self->model_size) return false;
+    const kpu_layer_argument_t *layer_arg = (const kpu_layer_argument_t *)(self->model + first_layer->layer_offset);
+    self->in_width = layer_arg->image_size.data.i_row_wid + 1;
+    self->in_height = layer_arg->image_size.data.i_col_high + 1;
+    self->in_channels = layer_arg->image_channel_num.data.i_ch_num + 1;
+    return true;
+}
+
+// Convert RGB565 frame to the model input format (planar RGB888 or grayscale)
+// The frame is resized to the model input size (nearest neighbor)
+//-------------------------------------------------------------------------------------------------------------
+STATIC void convert_frame(kpu_model_obj_t *self, const uint16_t *frame, int width, int height)
+{
+    int npix = self->in_width * self->in_height;
+    uint8_t *r = self->input;
+    uint8_t *g = r + npix;
+    uint8_t *b = g + npix;
+    uint32_t x_step = (width << 16) / self->in_width;
+    uint32_t y_step = (height << 16) / self->in_height;
+    uint32_t sy = y_step >> 1;
+
+    for (int y=0; y<self->in_height; y++) {
+        const uint16_t *row = frame + ((sy >> 16) * width);
+        uint32_t sx = x_step >> 1;
+        for (int x=0; x<self->in_width; x++) {
+            uint32_t c = row[sx >> 16];
+            uint32_t cr = ((c >> 8) & 0xF8) | (c >> 13);
+            uint32_t cg = ((c >> 3) & 0xFC) | ((c >> 9) & 0x03);
+            uint32_t cb = ((c << 3) & 0xF8) | ((c >> 2) & 0x07);
+            if (self->in_channels == 3) {
+                *r++ = cr;
+                *g++ = cg;
+                *b++ = cb;
+            }
+            else *r++ = ((77 * cr) + (150 * cg) + (29 * cb) + 128) >> 8;
+            sx += x_step;
+        }
+        sy += y_step;
+    }
+}
+
+// Prepare the model input from the buffer object
+// If the buffer is a frame buffer (with 'rawB' header), the RGB565 frame is converted to the model input format.
+// Otherwise the buffer must contain the input data in the model format (planar, 8-bit per channel).
+// The input data are copied if 'copy' is set or if the buffer is not aligned for DMA transfer.
+//-------------------------------------------------------------------------------------------
+STATIC const uint8_t *get_input(kpu_model_obj_t *self, mp_obj_t buf_obj, bool copy)
+{
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_obj, &bufinfo, MP_BUFFER_READ);
+    const uint8_t *data = (const uint8_t *)bufinfo.buf;
+
+    if ((bufinfo.len >= 8) && (memcmp(data+4, "rawB", 4) == 0)) {
+        int width = *(uint16_t *)(data);
+        int height = *(uint16_t *)(data+2);
+        if ((self->in_channels != 3) && (self->in_channels != 1)) {
+            mp_raise_ValueError("model input is not RGB or grayscale");
+        }
+        if ((width <= 0) || (height <= 0) || (bufinfo.len < ((size_t)width * height * 2) + 8) || ((uintptr_t)data & 1)) {
+            mp_raise_ValueError("wrong frame buffer");
+        }
+        convert_frame(self, (const uint16_t *)(data+8), width, height);
+        return self->input;
+    }
+
+    if (bufinfo.len < self->input_size) {
+        mp_raise_ValueError("input buffer too small");
+    }
+    if ((!copy) && (((uintptr_t)data & 7) == 0)) return data;
+    memcpy(self->input, data, self->input_size);
+    return self->input;
+}
+
+//------------------------------------------------------
+STATIC void check_model(kpu_model_obj_t *self, bool idle)
+{
+    if (self->handle == 0) {
+        mp_raise_msg(&mp_type_OSError, "model not loaded");
+    }
+    if ((idle) && (self->busy)) {
+        mp_raise_msg(&mp_type_OSError, "model is running");
+    }
+}
+
+//------------------------------------------------------
+STATIC void wait_model(kpu_model_obj_t *self)
+{
+    while (self->busy) {
+        mp_hal_delay_ms(2);
+    }
+}
+
+// === Model object ===
+
+//------------------------------------------------------------------------------------------
+STATIC void kpu_model_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    kpu_model_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->handle == 0) {
+        mp_printf(print, "KPU_Model(not loaded)");
+        return;
+    }
+    const kpu_model_header_t *header = (const kpu_model_header_t *)self->model;
+    mp_printf(print, "KPU_Model(size=%u, layers=%u, outputs=%u, input=%ux%ux%u, main_mem=%u, profile=%s, busy=%s)",
+            self->model_size, header->layers_length, header->output_count,
+            self->in_width, self->in_height, self->in_channels, header->main_mem_usage,
+            (self->profile) ? "True" : "False", (self->busy) ? "True" : "False");
+}
+
+// Load the model from file or Flash address
+//-------------------------------------------------------------------------------------
+STATIC mp_obj_t kpu_load(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_src, ARG_profile };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_src,      MP_ARG_REQUIRED | MP_ARG_OBJ,  {.u_obj = mp_const_none} },
+        { MP_QSTR_profile,  MP_ARG_KW_ONLY  | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    model_src_t src = { MP_OBJ_NULL, 0 };
+    if (mp_obj_is_str(args[ARG_src].u_obj)) {
+        mp_obj_t fargs[2];
+        fargs[0] = args[ARG_src].u_obj;
+        fargs[1] = mp_obj_new_str("rb", 2);
+        src.file = mp_vfs_open(2, fargs, (mp_map_t*)&mp_const_empty_map);
+    }
+    else src.flash_addr = mp_obj_get_int(args[ARG_src].u_obj);
+
+    uint32_t model_size = 0;
+    nlr_buf_t nlr;
+    uint8_t *model = NULL;
+    if (nlr_push(&nlr) == 0) {
+        model = model_load(&src, &model_size);
+        nlr_pop();
+    }
+    if (src.file != MP_OBJ_NULL) mp_stream_close(src.file);
+    if (model == NULL) nlr_jump(nlr.ret_val);
+
+    kpu_model_obj_t *self = m_new_obj_with_finaliser(kpu_model_obj_t);
+    memset(self, 0, sizeof(kpu_model_obj_t));
+    self->base.type = &kpu_model_type;
+    self->callback = mp_const_none;
+    self->model = model;
+    self->model_size = model_size;
+
+    if (!model_input_size(self)) {
+        vPortFree(model);
+        self->model = NULL;
+        mp_raise_ValueError("first model layer is not KPU convolution");
+    }
+    self->input_size = self->in_width * self->in_height * self->in_channels;
+    self->input = pvPortMalloc(self->input_size);
+    if (self->input == NULL) {
+        vPortFree(model);
+        self->model = NULL;
+        mp_raise_msg(&mp_type_OSError, "not enough memory for the input buffer");
+    }
+
+    self->handle = kpu_model_load_from_buffer(self->model);
+    if (self->handle == 0) {
+        vPortFree(self->input);
+        vPortFree(self->model);
+        self->input = NULL;
+        self->model = NULL;
+        mp_raise_msg(&mp_type_OSError, "error loading model");
+    }
+    if (args[ARG_profile].u_bool) {
+        kpu_set_profile(self->handle, true);
+        self->profile = true;
+    }
+    LOGD(TAG, "Model loaded: %u bytes, input %ux%ux%u", model_size, self->in_width, self->in_height, self->in_channels);
+    return MP_OBJ_FROM_PTR(self);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(kpu_load_obj, 1, kpu_load);
+
+// Run the model, wait until finished
+//---------------------------------------------------------------
+STATIC mp_obj_t kpu_model_run(mp_obj_t self_in, mp_obj_t buf_obj)
+{
+    kpu_model_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    check_model(self, true);
+    const uint8_t *input = get_input(self, buf_obj, false);
+
+    self->busy = true;
+    // allow other threads to run while the KPU is working
+    MP_THREAD_GIL_EXIT();
+    int res = kpu_run(self->handle, input);
+    MP_THREAD_GIL_ENTER();
+    self->busy = false;
+
+    if (res != 0) {
+        mp_raise_msg(&mp_type_OSError, "error running model");
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(kpu_model_run_obj, kpu_model_run);
+
+//-----------------------------------------------
+STATIC void kpu_run_task(void *pvParameters)
+{
+    kpu_model_obj_t *self = (kpu_model_obj_t *)pvParameters;
+    // the task schedules MicroPython callback, MicroPython state from the calling task is needed
+    vTaskSetThreadLocalStoragePointer(NULL, THREAD_LSP_STATE, pvTaskGetThreadLocalStoragePointer(self->caller_task, THREAD_LSP_STATE));
+    vTaskSetThreadLocalStoragePointer(NULL, THREAD_LSP_ARGS, pvTaskGetThreadLocalStoragePointer(self->caller_task, THREAD_LSP_ARGS));
+
+    self->result = kpu_run(self->handle, self->input);
+    self->busy = false;
+    if (self->callback != mp_const_none) {
+        if (!mp_sched_schedule(self->callback, MP_OBJ_FROM_PTR(self))) {
+            LOGW(TAG, "Callback not scheduled");
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+// Start the model run in background
+// The input data are copied to the model input buffer, the input buffer can be reused immediately.
+// The callback function (if given) is scheduled when finished, the model object is the argument.
+//------------------------------------------------------------------------------------------
+STATIC mp_obj_t kpu_model_run_async(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_input, ARG_callback };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_input,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_callback,                   MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    kpu_model_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args-1, pos_args+1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    check_model(self, true);
+    if ((args[ARG_callback].u_obj != mp_const_none) && (!mp_obj_is_callable(args[ARG_callback].u_obj))) {
+        mp_raise_ValueError("callback must be a function");
+    }
+    get_input(self, args[ARG_input].u_obj, true);
+
+    self->callback = args[ARG_callback].u_obj;
+    self->caller_task = xTaskGetCurrentTaskHandle();
+    self->result = 0;
+    self->busy = true;
+    BaseType_t res = xTaskCreate(
+            kpu_run_task,               // function entry
+            "KPU_run",                  // task name
+            configMINIMAL_STACK_SIZE,   // stack_deepth
+            (void *)self,               // function argument
+            MICROPY_TASK_PRIORITY,      // task priority
+            NULL);                      // task handle
+    if (res != pdPASS) {
+        self->busy = false;
+        mp_raise_msg(&mp_type_OSError, "error starting KPU task");
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(kpu_model_run_async_obj, 1, kpu_model_run_async);
+
+// Returns True if the model is running in background
+//----------------------------------------------------
+STATIC mp_obj_t kpu_model_busy(mp_obj_t self_in)
+{
+    kpu_model_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_bool(self->busy);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(kpu_model_busy_obj, kpu_model_busy);
+
+// Wait until the background model run is finished
+//----------------------------------------------------
+STATIC mp_obj_t kpu_model_wait(mp_obj_t self_in)
+{
+    kpu_model_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    check_model(self, false);
+    wait_model(self);
+    if (self->result != 0) {
+        mp_raise_msg(&mp_type_OSError, "error running model");
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(kpu_model_wait_obj, kpu_model_wait);
+
+// Returns the model output as memoryview of the KPU main buffer (no data is copied)
+// The content is valid until the next model run
+//------------------------------------------------------------------------------------------
+STATIC mp_obj_t kpu_model_output(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_index, ARG_float };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_index,                    MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_float,    MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = true} },
+    };
+    kpu_model_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args-1, pos_args+1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    check_model(self, true);
+    uint8_t *data;
+    size_t size;
+    if (kpu_get_output(self->handle, args[ARG_index].u_int, &data, &size) != 0) {
+        mp_raise_ValueError("wrong output index");
+    }
+    if (args[ARG_float].u_bool) return mp_obj_new_memoryview('f', size / sizeof(float), data);
+    return mp_obj_new_memoryview('B', size, data);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(kpu_model_output_obj, 1, kpu_model_output);
+
+// Enable or disable the layer run time profiling
+//-------------------------------------------------------------------------
+STATIC mp_obj_t kpu_model_profile(size_t n_args, const mp_obj_t *args)
+{
+    kpu_model_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    check_model(self, true);
+    if (n_args > 1) {
+        self->profile = mp_obj_is_true(args[1]);
+        kpu_set_profile(self->handle, self->profile);
+    }
+    return mp_obj_new_bool(self->profile);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(kpu_model_profile_obj, 1, 2, kpu_model_profile);
+
+// Returns the run times of the last model run
+// List of (layer_name, time_us) tuples, first entry is the input transfer time
+//-------------------------------------------------------
+STATIC mp_obj_t kpu_model_layer_times(mp_obj_t self_in)
+{
+    kpu_model_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    check_model(self, true);
+    if (!self->profile) {
+        mp_raise_msg(&mp_type_OSError, "profiling not enabled");
+    }
+    const kpu_model_header_t *header = (const kpu_model_header_t *)self->model;
+    const kpu_model_layer_header_t *layer_headers = (const kpu_model_layer_header_t *)(self->model + sizeof(kpu_model_header_t) + (header->output_count * sizeof(kpu_model_output_t)));
+    size_t count = header->layers_length + 1;
+    uint32_t *times = m_new(uint32_t, count);
+    int n = kpu_get_profile(self->handle, times, count);
+
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for (int i=0; i<n; i++) {
+        const char *name = (i == 0) ? "Input" : kpu_layer_type_name(layer_headers[i-1].type);
+        mp_obj_t tuple[2] = { mp_obj_new_str(name, strlen(name)), mp_obj_new_int_from_uint(times[i]) };
+        mp_obj_list_append(list, mp_obj_new_tuple(2, tuple));
+    }
+    m_del(uint32_t, times, count);
+    return list;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(kpu_model_layer_times_obj, kpu_model_layer_times);
+
+// Returns the model input size: (width, height, channels)
+//------------------------------------------------------
+STATIC mp_obj_t kpu_model_input_shape(mp_obj_t self_in)
+{
+    kpu_model_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    check_model(self, false);
+    mp_obj_t tuple[3] = {
+        mp_obj_new_int(self->in_width),
+        mp_obj_new_int(self->in_height),
+        mp_obj_new_int(self->in_channels),
+    };
+    return mp_obj_new_tuple(3, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(kpu_model_input_shape_obj, kpu_model_input_shape);
+
+// Free the model and all used memory
+//----------------------------------------------
+STATIC mp_obj_t kpu_model_free(mp_obj_t self_in)
+{
+    kpu_model_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->handle == 0) return mp_const_none;
+
+    // wait for the background run to finish (can be called from the finaliser)
+    while (self->busy) {
+        vTaskDelay(2);
+    }
+    // model context is freed by closing its handle
+    io_close(self->handle);
+    self->handle = 0;
+    if (self->input) vPortFree(self->input);
+    if (self->model) vPortFree(self->model);
+    self->input = NULL;
+    self->model = NULL;
+    self->callback = mp_const_none;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(kpu_model_free_obj, kpu_model_free);
+
+
+//===========================================================
+STATIC const mp_rom_map_elem_t kpu_model_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_run),             MP_ROM_PTR(&kpu_model_run_obj) },
+    { MP_ROM_QSTR(MP_QSTR_run_async),       MP_ROM_PTR(&kpu_model_run_async_obj) },
+    { MP_ROM_QSTR(MP_QSTR_busy),            MP_ROM_PTR(&kpu_model_busy_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait),            MP_ROM_PTR(&kpu_model_wait_obj) },
+    { MP_ROM_QSTR(MP_QSTR_output),          MP_ROM_PTR(&kpu_model_output_obj) },
+    { MP_ROM_QSTR(MP_QSTR_profile),         MP_ROM_PTR(&kpu_model_profile_obj) },
+    { MP_ROM_QSTR(MP_QSTR_layer_times),     MP_ROM_PTR(&kpu_model_layer_times_obj) },
+    { MP_ROM_QSTR(MP_QSTR_input_shape),     MP_ROM_PTR(&kpu_model_input_shape_obj) },
+    { MP_ROM_QSTR(MP_QSTR_free),            MP_ROM_PTR(&kpu_model_free_obj) },
+    { MP_ROM_QSTR(MP_QSTR___del__),         MP_ROM_PTR(&kpu_model_free_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(kpu_model_locals_dict, kpu_model_locals_dict_table);
+
+//======================================
+const mp_obj_type_t kpu_model_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_KPU_Model,
+    .print = kpu_model_print,
+    .locals_dict = (mp_obj_dict_t*)&kpu_model_locals_dict,
+};
+
+
+//===========================================================
+STATIC const mp_rom_map_elem_t kpu_module_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__),    MP_ROM_QSTR(MP_QSTR_kpu) },
+
+    { MP_ROM_QSTR(MP_QSTR_load),        MP_ROM_PTR(&kpu_load_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(kpu_module_globals, kpu_module_globals_table);
+
+//---------------------------------------
+const mp_obj_module_t mp_module_kpu = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&kpu_module_globals,
+};
+
+#endif
@@ -40,6 +40,7 @@
 #include "modmachine.h"
 #include "dvp_camera.h"
 #include "../display/moddisplay.h"
+#include "camframe.h"
 
 // Only for debug
 #define USE_DEBUG_PIN   0
@@ -49,6 +50,37 @@
 #define DEST_TFT        1
 #define DEST_FILE       2
 
+// Streaming mode
+#define CAM_STREAM_MAX_BUFFERS  8
+#define CAM_STREAM_NO_BUFFER    0xFF
+
+#define CAM_STREAM_DROP_OLDEST  0   // when no buffer is free, the oldest queued frame is overwritten
+#define CAM_STREAM_DROP_NEWEST  1   // when no buffer is free, the new frame is discarded
+
+#define CAM_FRAME_FREE          0
+#define CAM_FRAME_FILLING       1   // the frame is being captured
+#define CAM_FRAME_READY         2   // the frame is in the ready queue
+#define CAM_FRAME_HELD          3   // the frame is used by Python, until released
+
+typedef struct _cam_stream_t {
+    mp_obj_t            buff_obj[CAM_STREAM_MAX_BUFFERS];   // frame buffers (bytearray)
+    uint8_t             *buff[CAM_STREAM_MAX_BUFFERS];      // frame buffers data, with 8-byte 'rawB' header
+    uint32_t            gen[CAM_STREAM_MAX_BUFFERS];        // generation of the held frame, checked by its views
+    volatile uint8_t    state[CAM_STREAM_MAX_BUFFERS];
+    uint8_t             ready[CAM_STREAM_MAX_BUFFERS];      // ready frames queue, oldest first
+    volatile uint8_t    ready_head;
+    volatile uint8_t    ready_count;
+    uint8_t             filling;                            // buffer being captured
+    uint8_t             nbuff;
+    uint8_t             policy;
+    bool                active;
+    uint16_t            width;
+    uint16_t            height;
+    volatile uint32_t   captured;
+    volatile uint32_t   dropped;
+    uint32_t            delivered;
+} cam_stream_t;
+
 typedef struct _mod_camera_obj_t {
     mp_obj_base_t       base;
     mp_obj_t            buff_obj0;
@@ -56,13 +88,36 @@ typedef struct _mod_camera_obj_t {
     sensor_t            sensor;
     SemaphoreHandle_t   semaphore;
     TaskHandle_t        preview_task;
+    cam_stream_t        stream;
+    uint32_t            frame_gen;      // last generation given to a held frame, not reset when the stream restarts
 } mod_camera_obj_t;
 
+/*
+ * View of a frame held by Python in stream mode
+ * The frame buffer is reused by the DVP after the frame is released and dropped
+ * when the stream is stopped, so the view does not keep a pointer to it.
+ * The view refers to the camera object, the buffer index and the frame generation,
+ * every access checks that the frame is still held, stale views raise ValueError.
+ * Slices of a view are views of the same frame and are checked the same way.
+ */
+typedef struct _mp_obj_frame_view_t {
+    mp_obj_base_t       base;
+    struct _mod_camera_obj_t *camera;
+    uint32_t            gen;        // frame generation the view was made for
+    uint32_t            offset;     // start of the view in the frame buffer
+    uint32_t            len;
+    uint8_t             idx;        // stream buffer index
+} mp_obj_frame_view_t;
+
+STATIC const mp_obj_type_t mod_camera_frame_view_type;
+
 typedef struct _task_params_t {
     void        *cam_obj;
     void        *thread_handle;
     uint32_t    max_frames;
     uint8_t     disp_fps;
+    uint8_t     rotate;
+    bool        bilinear;
 } task_params_t;
 
 
@@ -198,6 +253,54 @@ static void check_preview(mod_camera_obj_t *self)
     }
 }
 
+//----------------------------------------------
+static void check_stream(mod_camera_obj_t *self)
+{
+    if (self->stream.active) {
+        mp_raise_msg(&mp_type_OSError, "Cannot execute while in stream mode");
+    }
+}
+
+// Streaming mode frame complete, executed from dvp interrupt
+// The captured frame is queued and the next free buffer is selected for capture
+//------------------------------------------------------
+static void stream_frame_done(mod_camera_obj_t *self)
+{
+    cam_stream_t *stream = &self->stream;
+    uint8_t done = stream->filling;
+    uint8_t next = CAM_STREAM_NO_BUFFER;
+
+    stream->captured++;
+    for (uint8_t i=0; i<stream->nbuff; i++) {
+        if (stream->state[i] == CAM_FRAME_FREE) {
+            next = i;
+            break;
+        }
+    }
+    if (next == CAM_STREAM_NO_BUFFER) {
+        stream->dropped++;
+        if ((stream->policy == CAM_STREAM_DROP_OLDEST) && (stream->ready_count > 0)) {
+            // reuse the oldest queued frame
+            next = stream->ready[stream->ready_head];
+            stream->ready_head = (stream->ready_head + 1) % stream->nbuff;
+            stream->ready_count--;
+        }
+        else {
+            // discard the new frame, capture the next one into the same buffer
+            next = done;
+            done = CAM_STREAM_NO_BUFFER;
+        }
+    }
+    if (done != CAM_STREAM_NO_BUFFER) {
+        stream->state[done] = CAM_FRAME_READY;
+        stream->ready[(stream->ready_head + stream->ready_count) % stream->nbuff] = done;
+        stream->ready_count++;
+    }
+    stream->state[next] = CAM_FRAME_FILLING;
+    stream->filling = next;
+    dvp_set_output_attributes(self->sensor.dvp_handle, DATA_FOR_DISPLAY, VIDEO_FMT_RGB565, stream->buff[next] + 8);
+}
+
 //---------------------------------------------
 // This function is executed from dvp interrupt
 //-------------------------------------------------------------
@@ -219,6 +322,17 @@ static void on_dvp_irq(dvp_frame_event_t event, void* userdata)
             break;
         case VIDEO_FE_END:
             // Frame complete
+            if (self->stream.active) {
+                stream_frame_done(self);
+                if (self->semaphore) {
+                    xSemaphoreGiveFromISR(self->semaphore, &xHigherPriorityTaskWoken);
+                    if (xHigherPriorityTaskWoken)
+                    {
+                        portYIELD_FROM_ISR();
+                    }
+                }
+                break;
+            }
             if (self->sensor.frame_count) self->sensor.frame_count--;
             self->sensor.gram_mux ^= 0x01; // select next (active) frame buffer
             if (self->sensor.frame_count) {
@@ -247,9 +361,30 @@ static void on_dvp_irq(dvp_frame_event_t event, void* userdata)
     }
 }
 
+// Stop the streaming mode and drop the frame buffers
+// The buffers are not deleted, an object made from a frame view (e.g. memoryview(frame))
+// may still point to one, they are left to the garbage collector. All frame views become invalid.
+//------------------------------------------------
+static void stream_stop(mod_camera_obj_t *self)
+{
+    cam_stream_t *stream = &self->stream;
+    if (!stream->active) return;
+
+    dvp_disable(&self->sensor);
+    stream->active = false;
+    for (uint8_t i=0; i<stream->nbuff; i++) {
+        stream->buff_obj[i] = mp_const_none;
+        stream->buff[i] = NULL;
+        stream->state[i] = CAM_FRAME_FREE;
+    }
+    stream->nbuff = 0;
+    stream->ready_count = 0;
+}
+
 //------------------------------------------------
 static void _camera_deinit(mod_camera_obj_t *self)
 {
+    stream_stop(self);
     dvp_deinit(&self->sensor);
     cam_delete_buffers(self);
     cam_pins_deinit();
@@ -263,13 +398,34 @@ static void _camera_deinit(mod_camera_obj_t *self)
 static void swap_pixels(uint16_t *cbuff, int size)
 {
     uint16_t tmpclr;
-    for (int i=0; i<size; i+=2) {
+    int i = 0;
+    if (((uintptr_t)cbuff & 7) == 0) {
+        uint64_t *cbuff64 = (uint64_t *)cbuff;
+        for (; (i+4)<=size; i+=4) {
+            *cbuff64 = RGB565_SWAP_PAIRS64(*cbuff64);
+            cbuff64++;
+        }
+    }
+    for (; i<size; i+=2) {
         tmpclr = cbuff[i];
         cbuff[i] = cbuff[i+1];
         cbuff[i+1] = tmpclr;
     }
 }
 
+// Show the captured frame on display, fitted to the display frame buffer
+// Pixels are swapped, scaled and rotated by one pass over the frame, the frame is not changed
+//-----------------------------------------------------------------------------------------
+static void show_frame(mod_camera_obj_t *self, uint16_t *cbuff, uint8_t rot, bool bilinear)
+{
+    int width = dvp_cam_resolution[self->sensor.framesize][0];
+    int height = dvp_cam_resolution[self->sensor.framesize][1];
+    int dst_width, dst_height;
+
+    camframe_fit(width, height, rot, bilinear, active_dstate->_width, active_dstate->_height, &dst_width, &dst_height);
+    send_camera_frame(0, 0, dst_width, dst_height, cbuff, width, height, rot, bilinear);
+}
+
 // After initialization capture frames to stabilize the operation
 //----------------------------------------------------------
 static void init_frames(mod_camera_obj_t *self, bool delete)
@@ -299,13 +455,11 @@ static void init_frames(mod_camera_obj_t *self, bool delete)
     bool show = true;
     if (self->sensor.pixformat == PIXFORMAT_JPEG) show = false;
     if (active_dstate->tft_frame_buffer == NULL) show = false;
-    if ((dvp_cam_resolution[self->sensor.framesize][0] > active_dstate->_width) || (dvp_cam_resolution[self->sensor.framesize][1] > active_dstate->_height)) show = false;
     if (show) {
         // Display the last captured frame
         color_t *cbuff = (uint16_t *)((self->sensor.gram_mux) ? self->sensor.gram0 : self->sensor.gram1);
-        swap_pixels(cbuff, dvp_cam_resolution[self->sensor.framesize][0] * dvp_cam_resolution[self->sensor.framesize][1]);
-        send_data_scale(0, 0, dvp_cam_resolution[self->sensor.framesize][0], dvp_cam_resolution[self->sensor.framesize][1], cbuff, 0);
-        send_frame_buffer();
+        show_frame(self, cbuff, 0, false);
+        send_frame_buffer(false);
     }
 }
 
@@ -357,15 +511,14 @@ static void preview_task(void *pvParameters)
         if (active_dstate->tft_frame_buffer) {
             // Display captured frame
             color_t *cbuff = (uint16_t *)((self->sensor.gram_mux) ? self->sensor.gram0 : self->sensor.gram1);
-            swap_pixels(cbuff, dvp_cam_resolution[self->sensor.framesize][0] * dvp_cam_resolution[self->sensor.framesize][1]);
-            send_data_scale(0, 0, dvp_cam_resolution[self->sensor.framesize][0], dvp_cam_resolution[self->sensor.framesize][1], cbuff, 0);
+            show_frame(self, cbuff, task_params->rotate, task_params->bilinear);
             if (task_params->disp_fps) {
                 sprintf(str_tft, "%0.2f fps", fps);
                 TFT_print(str_tft, 5, 5);
                 sprintf(str_tft, "%lu", frame_count);
                 TFT_print(str_tft, RIGHT, 5);
             }
-            send_frame_buffer();
+            send_frame_buffer(false);
         }
 
         mp_hal_wdt_reset();
@@ -387,7 +540,7 @@ static void preview_task(void *pvParameters)
         TFT_print(str_tft, 5, 5);
         sprintf(str_tft, "%lu", frame_count);
         TFT_print(str_tft, RIGHT, 5);
-        send_frame_buffer();
+        send_frame_buffer(false);
     }
     */
     printf("Frame rate: %0.2f fps\r\n", fps);
@@ -467,7 +620,7 @@ STATIC void mod_camera_print(const mp_print_t *print, mp_obj_t self_in, mp_print
                 dvp_cam_resolution[self->sensor.framesize][0], dvp_cam_resolution[self->sensor.framesize][1],
                 self->sensor.xclk,
                 (self->preview_task) ? "2*" : "", self->sensor.gram_size+8,
-                (self->preview_task) ? "Preview" : "Capture");
+                (self->preview_task) ? "Preview" : ((self->stream.active) ? "Stream" : "Capture"));
     }
     else {
         mp_printf(print, "Camera( deinitialized )");
@@ -523,6 +676,7 @@ STATIC mp_obj_t mod_camera_make_new(const mp_obj_type_t *type, size_t n_args, si
     self->sensor.irq_func_data = (void *)self;
     self->sensor.frame_count = 1;
     self->preview_task = NULL;
+    memset(&self->stream, 0, sizeof(cam_stream_t));
 
     LOGD(TAG, "Camera deinit");
     dvp_deinit(&self->sensor);
@@ -579,6 +733,7 @@ STATIC mp_obj_t mod_camera_reset(mp_obj_t self_in)
 
     check_camera(self);
     stop_preview_task(self);
+    stream_stop(self);
 
     LOGD(TAG, "Deinitialize camera");
     dvp_deinit(&self->sensor);
@@ -618,6 +773,7 @@ STATIC mp_obj_t mod_camera_set_size(mp_obj_t self_in, mp_obj_t size_in)
 {
     mod_camera_obj_t *self = MP_OBJ_TO_PTR(self_in);
 
+    check_stream(self);
     int size = mp_obj_get_int(size_in);
     if (size != self->sensor.framesize) {
         if (self->sensor.check_framesize(size) != 0) {
@@ -669,6 +825,7 @@ STATIC mp_obj_t mod_camera_capture(mp_uint_t n_args, const mp_obj_t *pos_args, m
     mp_arg_parse_all(n_args-1, pos_args+1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
     check_camera(self);
+    check_stream(self);
     stop_preview_task(self);
 
     #if USE_DEBUG_PIN
@@ -854,7 +1011,7 @@ STATIC mp_obj_t mod_camera_capture(mp_uint_t n_args, const mp_obj_t *pos_args, m
             if (TFT_jpg_image(0, 0, scale, mp_const_none, frame_buffer, jpeg_size)) {
                 tft_setup((uint8_t)(args[ARG_time].u_int & 3));
                 // show image
-                send_frame_buffer();
+                send_frame_buffer(false);
             }
             else LOGD(TAG, "JPEG decode error");
         }
@@ -887,7 +1044,7 @@ STATIC mp_obj_t mod_camera_capture(mp_uint_t n_args, const mp_obj_t *pos_args, m
             send_data_scale(0, 0, width, height, (color_t *)frame_buffer, 0);
 
             tft_setup((uint8_t)(args[ARG_time].u_int & 3));
-            send_frame_buffer();
+            send_frame_buffer(false);
         }
         else if ((dest == DEST_FILE) && (ffd != mp_const_none)) {
             LOGD(TAG, "Save to file");
@@ -913,11 +1070,13 @@ MP_DEFINE_CONST_FUN_OBJ_KW(mod_camera_capture_obj, 1, mod_camera_capture);
 //-----------------------------------------------------------------------------------------------
 STATIC mp_obj_t mod_camera_preview(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
 {
-    enum { ARG_stop, ARG_frames, ARG_fps };
+    enum { ARG_stop, ARG_frames, ARG_fps, ARG_rotate, ARG_bilinear };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_stop,                      MP_ARG_BOOL, {.u_bool = false} },
         { MP_QSTR_frames,   MP_ARG_KW_ONLY | MP_ARG_INT,  {.u_int = 10000000} },
         { MP_QSTR_fps,      MP_ARG_KW_ONLY | MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_rotate,   MP_ARG_KW_ONLY | MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_bilinear, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
     };
 
     mod_camera_obj_t *self = pos_args[0];
@@ -931,6 +1090,7 @@ STATIC mp_obj_t mod_camera_preview(mp_uint_t n_args, const mp_obj_t *pos_args, m
         if (args[ARG_stop].u_bool == true) stop_preview_task(self);
         return mp_const_none;
     }
+    check_stream(self);
 
     // Check conditions to run preview
     if (self->sensor.pixformat == PIXFORMAT_JPEG) {
@@ -959,6 +1119,8 @@ STATIC mp_obj_t mod_camera_preview(mp_uint_t n_args, const mp_obj_t *pos_args, m
     task_params.max_frames = 10000000;
     if (args[ARG_frames].u_int > 100) task_params.max_frames = args[ARG_frames].u_int;
     task_params.disp_fps = (uint8_t)(args[ARG_fps].u_int & 3);;
+    task_params.rotate = (uint8_t)((args[ARG_rotate].u_int / 90) & 3);
+    task_params.bilinear = args[ARG_bilinear].u_bool;
     task_params.cam_obj = (void *)self;
     task_params.thread_handle = xTaskGetCurrentTaskHandle();
 
@@ -978,6 +1140,312 @@ STATIC mp_obj_t mod_camera_preview(mp_uint_t n_args, const mp_obj_t *pos_args, m
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(mod_camera_preview_obj, 1, mod_camera_preview);
 
+// Start or stop continuous capturing into the ring of frame buffers
+//----------------------------------------------------------------------------------------------
+STATIC mp_obj_t mod_camera_stream(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_stop, ARG_buffers, ARG_policy };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_stop,                      MP_ARG_BOOL, {.u_bool = false} },
+        { MP_QSTR_buffers,  MP_ARG_KW_ONLY | MP_ARG_INT,  {.u_int = 3} },
+        { MP_QSTR_policy,   MP_ARG_KW_ONLY | MP_ARG_INT,  {.u_int = CAM_STREAM_DROP_OLDEST} },
+    };
+
+    mod_camera_obj_t *self = pos_args[0];
+    cam_stream_t *stream = &self->stream;
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args-1, pos_args+1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    check_preview(self);
+
+    if (args[ARG_stop].u_bool) {
+        stream_stop(self);
+        return mp_const_none;
+    }
+    if (stream->active) {
+        mp_raise_msg(&mp_type_OSError, "Stream mode already active");
+    }
+    if (self->sensor.pixformat == PIXFORMAT_JPEG) {
+        mp_raise_msg(&mp_type_OSError, "stream not supported when in JPEG mode.");
+    }
+    int nbuff = args[ARG_buffers].u_int;
+    if ((nbuff < 2) || (nbuff > CAM_STREAM_MAX_BUFFERS)) {
+        mp_raise_ValueError("buffers must be 2 ~ 8");
+    }
+    if ((args[ARG_policy].u_int != CAM_STREAM_DROP_OLDEST) && (args[ARG_policy].u_int != CAM_STREAM_DROP_NEWEST)) {
+        mp_raise_ValueError("Unsupported policy.");
+    }
+
+    // === Create the frame buffers ===
+    memset(stream, 0, sizeof(cam_stream_t));
+    stream->width = dvp_cam_resolution[self->sensor.framesize][0];
+    stream->height = dvp_cam_resolution[self->sensor.framesize][1];
+    for (int i=0; i<nbuff; i++) {
+        stream->buff_obj[i] = mp_obj_new_frame_buffer(self->sensor.gram_size+8);
+        if (stream->buff_obj[i] == mp_const_none) {
+            stream->nbuff = i;
+            stream->active = true;
+            stream_stop(self);
+            mp_raise_msg(&mp_type_OSError, "Error creating stream frame buffers.");
+        }
+        mp_obj_array_t *buff = (mp_obj_array_t *)stream->buff_obj[i];
+        stream->buff[i] = buff->items;
+        stream->state[i] = CAM_FRAME_FREE;
+    }
+    stream->nbuff = nbuff;
+    stream->policy = args[ARG_policy].u_int;
+    stream->filling = 0;
+    stream->state[0] = CAM_FRAME_FILLING;
+    stream->active = true;
+
+    // === Start capturing, the first frame goes to the 1st ring buffer ===
+    mp_hal_wdt_reset();
+    xSemaphoreTake(self->semaphore, 0);
+    void *gram0 = self->sensor.gram0;
+    self->sensor.gram0 = stream->buff[0] + 8;
+    dvp_enable(&self->sensor);
+    self->sensor.gram0 = gram0;
+
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(mod_camera_stream_obj, 1, mod_camera_stream);
+
+// ==== Frame views ====
+
+//------------------------------------------------------------------------------------------------------------------
+STATIC mp_obj_t mod_camera_new_frame_view(mod_camera_obj_t *camera, uint8_t idx, uint32_t gen, uint32_t offset, uint32_t len)
+{
+    mp_obj_frame_view_t *view = m_new_obj(mp_obj_frame_view_t);
+    view->base.type = &mod_camera_frame_view_type;
+    view->camera = camera;
+    view->idx = idx;
+    view->gen = gen;
+    view->offset = offset;
+    view->len = len;
+    return MP_OBJ_FROM_PTR(view);
+}
+
+// Returns the view's data, or NULL if the frame was released or the stream stopped
+//-------------------------------------------------------------------
+STATIC uint8_t *mod_camera_frame_view_data(mp_obj_frame_view_t *view)
+{
+    cam_stream_t *stream = &view->camera->stream;
+    if ((!stream->active) || (view->idx >= stream->nbuff)) return NULL;
+    if ((stream->state[view->idx] != CAM_FRAME_HELD) || (stream->gen[view->idx] != view->gen)) return NULL;
+    return stream->buff[view->idx] + view->offset;
+}
+
+//--------------------------------------------------------------------------
+STATIC uint8_t *mod_camera_frame_view_check(mp_obj_frame_view_t *view)
+{
+    uint8_t *data = mod_camera_frame_view_data(view);
+    if (data == NULL) {
+        mp_raise_ValueError("Frame view is no longer valid");
+    }
+    return data;
+}
+
+//------------------------------------------------------------------------------------------------------
+STATIC void mod_camera_frame_view_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    mp_obj_frame_view_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print, "<FrameView %u bytes%s>", self->len, (mod_camera_frame_view_data(self)) ? "" : ", invalid");
+}
+
+// A stale view has no data
+//-----------------------------------------------------------------------------
+STATIC mp_obj_t mod_camera_frame_view_unary_op(mp_unary_op_t op, mp_obj_t self_in)
+{
+    mp_obj_frame_view_t *self = MP_OBJ_TO_PTR(self_in);
+    uint32_t len = (mod_camera_frame_view_data(self)) ? self->len : 0;
+    switch (op) {
+        case MP_UNARY_OP_BOOL: return mp_obj_new_bool(len != 0);
+        case MP_UNARY_OP_LEN: return MP_OBJ_NEW_SMALL_INT(len);
+        default: return MP_OBJ_NULL; // op not supported
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+STATIC mp_obj_t mod_camera_frame_view_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t value)
+{
+    mp_obj_frame_view_t *self = MP_OBJ_TO_PTR(self_in);
+    if (value == MP_OBJ_NULL) {
+        // delete
+        return MP_OBJ_NULL; // op not supported
+    }
+    uint8_t *data = mod_camera_frame_view_check(self);
+    if (MP_OBJ_IS_TYPE(index_in, &mp_type_slice)) {
+        mp_bound_slice_t slice;
+        if (!mp_seq_get_fast_slice_indexes(self->len, index_in, &slice)) {
+            mp_raise_NotImplementedError("only slices with step=1 (aka None) are supported");
+        }
+        uint32_t len = slice.stop - slice.start;
+        if (value == MP_OBJ_SENTINEL) {
+            // load, the slice is a view of the same frame
+            return mod_camera_new_frame_view(self->camera, self->idx, self->gen, self->offset + slice.start, len);
+        }
+        // store
+        mp_buffer_info_t bufinfo;
+        mp_get_buffer_raise(value, &bufinfo, MP_BUFFER_READ);
+        if (bufinfo.len != len) {
+            mp_raise_ValueError("Slice assignment must not change the view size");
+        }
+        memmove(data + slice.start, bufinfo.buf, len);
+        return mp_const_none;
+    }
+    size_t index = mp_get_index(self->base.type, self->len, index_in, false);
+    if (value == MP_OBJ_SENTINEL) {
+        // load
+        return MP_OBJ_NEW_SMALL_INT(data[index]);
+    }
+    // store
+    data[index] = mp_obj_get_int_truncated(value);
+    return mp_const_none;
+}
+
+// Used by the iterator
+//--------------------------------------------------------------------------------
+STATIC mp_obj_t mod_camera_frame_view_getitem(mp_obj_t self_in, mp_obj_t index_in)
+{
+    return mod_camera_frame_view_subscr(self_in, index_in, MP_OBJ_SENTINEL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_camera_frame_view_getitem_obj, mod_camera_frame_view_getitem);
+
+/*
+ * The buffer is checked when it is requested. The functions using the buffer protocol
+ * use the data pointer during the call only, but an object made from the buffer,
+ * like memoryview(frame), gets the raw pointer and is not checked
+ */
+//-----------------------------------------------------------------------------------------------------------
+STATIC mp_int_t mod_camera_frame_view_get_buffer(mp_obj_t self_in, mp_buffer_info_t *bufinfo, mp_uint_t flags)
+{
+    mp_obj_frame_view_t *self = MP_OBJ_TO_PTR(self_in);
+    bufinfo->buf = mod_camera_frame_view_check(self);
+    bufinfo->len = self->len;
+    bufinfo->typecode = 'B';
+    return 0;
+}
+
+//========================================================================
+STATIC const mp_rom_map_elem_t mod_camera_frame_view_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___getitem__), MP_ROM_PTR(&mod_camera_frame_view_getitem_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(mod_camera_frame_view_locals_dict, mod_camera_frame_view_locals_dict_table);
+
+//===================================================
+STATIC const mp_obj_type_t mod_camera_frame_view_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_FrameView,
+    .print = mod_camera_frame_view_print,
+    .unary_op = mod_camera_frame_view_unary_op,
+    .subscr = mod_camera_frame_view_subscr,
+    .buffer_p = { .get_buffer = mod_camera_frame_view_get_buffer },
+    .locals_dict = (mp_obj_dict_t*)&mod_camera_frame_view_locals_dict,
+};
+
+// Get the oldest captured frame in stream mode
+// Returns a FrameView of the frame buffer ('rawB' header + RGB565 data) or None on timeout
+// The frame buffer is not reused until the frame is released, then the view becomes invalid
+//---------------------------------------------------------------------------
+STATIC mp_obj_t mod_camera_get_frame(size_t n_args, const mp_obj_t *args)
+{
+    mod_camera_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    cam_stream_t *stream = &self->stream;
+
+    check_camera(self);
+    if (!stream->active) {
+        mp_raise_msg(&mp_type_OSError, "Stream mode not active");
+    }
+    int timeout = 1000;
+    if (n_args > 1) timeout = mp_obj_get_int(args[1]);
+    if (timeout < 0) timeout = 0;
+
+    mp_uint_t tstart = mp_hal_ticks_ms();
+    uint8_t idx = CAM_STREAM_NO_BUFFER;
+    while (1) {
+        taskENTER_CRITICAL();
+        if (stream->ready_count > 0) {
+            idx = stream->ready[stream->ready_head];
+            stream->ready_head = (stream->ready_head + 1) % stream->nbuff;
+            stream->ready_count--;
+            stream->state[idx] = CAM_FRAME_HELD;
+            stream->gen[idx] = ++self->frame_gen;
+        }
+        taskEXIT_CRITICAL();
+        if (idx != CAM_STREAM_NO_BUFFER) break;
+
+        mp_uint_t elapsed = mp_hal_ticks_ms() - tstart;
+        if (elapsed >= timeout) return mp_const_none;
+        // wait for the next frame
+        xSemaphoreTake(self->semaphore, (timeout - elapsed) / portTICK_PERIOD_MS);
+        mp_hal_wdt_reset();
+    }
+
+    uint8_t *frame_buffer = stream->buff[idx];
+    // Captured data have swapped even and odd pixels, fix it
+    swap_pixels((uint16_t *)(frame_buffer+8), stream->width * stream->height);
+    *(uint16_t *)(frame_buffer) = stream->width;
+    *(uint16_t *)(frame_buffer+2) = stream->height;
+    memcpy(frame_buffer+4, "rawB", 4);
+    stream->delivered++;
+
+    // the whole buffer, including the 'rawB' header, is returned to Python
+    return mod_camera_new_frame_view(self, idx, stream->gen[idx], 0, (stream->width * stream->height * 2) + 8);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_camera_get_frame_obj, 1, 2, mod_camera_get_frame);
+
+// Return the frame obtained by get_frame() to the ring of free buffers
+// All views of the frame become invalid
+//-------------------------------------------------------------------
+STATIC mp_obj_t mod_camera_release(mp_obj_t self_in, mp_obj_t frame_in)
+{
+    mod_camera_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    cam_stream_t *stream = &self->stream;
+
+    if (!stream->active) return mp_const_none;
+
+    if (MP_OBJ_IS_TYPE(frame_in, &mod_camera_frame_view_type)) {
+        mp_obj_frame_view_t *view = MP_OBJ_TO_PTR(frame_in);
+        if ((view->camera != self) || (mod_camera_frame_view_data(view) == NULL)) {
+            mp_raise_ValueError("not a frame held by the stream");
+        }
+        taskENTER_CRITICAL();
+        stream->state[view->idx] = CAM_FRAME_FREE;
+        taskEXIT_CRITICAL();
+        return mp_const_none;
+    }
+    // a buffer made from the frame view, e.g. memoryview(frame)
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(frame_in, &bufinfo, MP_BUFFER_READ);
+    for (uint8_t i=0; i<stream->nbuff; i++) {
+        if ((stream->buff[i] == bufinfo.buf) && (stream->state[i] == CAM_FRAME_HELD)) {
+            taskENTER_CRITICAL();
+            stream->state[i] = CAM_FRAME_FREE;
+            taskEXIT_CRITICAL();
+            return mp_const_none;
+        }
+    }
+    mp_raise_ValueError("not a frame held by the stream");
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_camera_release_obj, mod_camera_release);
+
+// Returns tuple: (captured, delivered, dropped, queued)
+//-------------------------------------------------------
+STATIC mp_obj_t mod_camera_stream_stats(mp_obj_t self_in)
+{
+    mod_camera_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    cam_stream_t *stream = &self->stream;
+
+    mp_obj_t tuple[4];
+    tuple[0] = mp_obj_new_int_from_uint(stream->captured);
+    tuple[1] = mp_obj_new_int_from_uint(stream->delivered);
+    tuple[2] = mp_obj_new_int_from_uint(stream->dropped);
+    tuple[3] = mp_obj_new_int(stream->ready_count);
+    return mp_obj_new_tuple(4, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_camera_stream_stats_obj, mod_camera_stream_stats);
+
 //----------------------------------------------------------------------------------------------
 STATIC mp_obj_t mod_camera_orient(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
 {
@@ -1121,6 +1589,10 @@ STATIC const mp_rom_map_elem_t mod_camera_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_deinit),          MP_ROM_PTR(&mod_camera_deinit_obj) },
     { MP_ROM_QSTR(MP_QSTR_capture),         MP_ROM_PTR(&mod_camera_capture_obj) },
     { MP_ROM_QSTR(MP_QSTR_preview),         MP_ROM_PTR(&mod_camera_preview_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stream),          MP_ROM_PTR(&mod_camera_stream_obj) },
+    { MP_ROM_QSTR(MP_QSTR_get_frame),       MP_ROM_PTR(&mod_camera_get_frame_obj) },
+    { MP_ROM_QSTR(MP_QSTR_release),         MP_ROM_PTR(&mod_camera_release_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stream_stats),    MP_ROM_PTR(&mod_camera_stream_stats_obj) },
     { MP_ROM_QSTR(MP_QSTR_orient),          MP_ROM_PTR(&mod_camera_orient_obj) },
     { MP_ROM_QSTR(MP_QSTR_effect),          MP_ROM_PTR(&mod_camera_effects_obj) },
     { MP_ROM_QSTR(MP_QSTR_brightness),      MP_ROM_PTR(&mod_camera_brightness_obj) },
@@ -1162,6 +1634,9 @@ STATIC const mp_rom_map_elem_t mod_camera_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_DEST_BUFFER),     MP_ROM_INT(0) },
     { MP_ROM_QSTR(MP_QSTR_DEST_DISP),       MP_ROM_INT(1) },
     { MP_ROM_QSTR(MP_QSTR_DEST_FILE),       MP_ROM_INT(2) },
+
+    { MP_ROM_QSTR(MP_QSTR_DROP_OLDEST),     MP_ROM_INT(CAM_STREAM_DROP_OLDEST) },
+    { MP_ROM_QSTR(MP_QSTR_DROP_NEWEST),     MP_ROM_INT(CAM_STREAM_DROP_NEWEST) },
 };
 STATIC MP_DEFINE_CONST_DICT(mod_camera_locals_dict, mod_camera_locals_dict_table);
 
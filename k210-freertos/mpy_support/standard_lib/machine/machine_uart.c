@@ -73,8 +73,6 @@ static const char *TAG = "[UART]";
 uart_uarts_t mpy_uarts[UART_NUM_MAX] = { 0 };
 
 
-// ==== UART Ring Buffer functions =========================================
-
 //===========================================
 // Interrupt handler for UART
 // pushes received byte(s) to the uart buffer
@@ -84,20 +82,20 @@ static void uart_on_irq_recv(void *userdata)
     uint32_t *nuart = (uint32_t *)userdata;
     mpy_uarts[*nuart].irq_flag = true;
     uart_ringbuf_t *r = mpy_uarts[*nuart].uart_buf;
+    size_t tail = r->tail;
+    size_t room = (r->buf) ? (r->size - (tail - r->head)) : 0;
     uint8_t c;
 
     while (uart[*nuart]->LSR & 1) {
         c = (uint8_t)(uart[*nuart]->RBR & 0xff);
-        if (r->buf) {
-            if (r->length < r->size) {
-                r->buf[r->tail] = c;
-                r->tail = (r->tail + 1) % r->size;
-                r->length++;
-            }
-            else r->overflow++;
+        if (room) {
+            r->buf[RINGBUF_IDX(r, tail)] = c;
+            tail++;
+            room--;
         }
         else r->overflow++;
     }
+    if (tail != r->tail) uart_buf_set_tail(r, tail);
     mpy_uarts[*nuart].irq_flag = false;
     if ((mpy_uarts[*nuart].task_semaphore) && (r->notify)) {
         BaseType_t xHigherPriorityTaskWoken = pdFALSE;
@@ -109,239 +107,6 @@ static void uart_on_irq_recv(void *userdata)
     }
 }
 
-// Put data into buffer
-// Operation on uart's ringbuffer is not allowed
-//-----------------------------------------------------------
-int uart_buf_put(uart_ringbuf_t *r, uint8_t *src, size_t len)
-{
-    if (r->uart_num < UART_NUM_MAX) return 0;
-    if (r->buf == NULL) {
-        r->overflow += len;
-        return 0;
-    }
-    size_t cnt = 0;
-
-    for (int i=0; i<len; i++) {
-        if (r->length < r->size) {
-            r->buf[r->tail] = src[i];
-            r->tail = (r->tail + 1) % r->size;
-            r->length++;
-            cnt++;
-        }
-        else r->overflow++;
-    }
-    return cnt;
-}
-
-// Remove data from buffer end
-// Operation is not allowed on uart's ringbuffer
-//---------------------------------------------------------
-int uart_buf_remove_from_end(uart_ringbuf_t *r, size_t len)
-{
-    if (r->uart_num < UART_NUM_MAX) return 0;
-    if (r->buf == NULL) return 0;
-    size_t cnt = 0;
-    size_t length = r->length;
-
-    if (length == 0) return 0;
-
-    for (int i=len; i>=0; i--) {
-        if (r->length == 0) break;
-        r->tail--;
-        r->length--;
-        cnt++;
-    }
-    return cnt;
-}
-
-// Get current buffer length
-//-----------------------------------------------------
-size_t uart_buf_length(uart_ringbuf_t *r, size_t *size)
-{
-    if (r->uart_num < UART_NUM_MAX) taskENTER_CRITICAL();
-    size_t length = r->length;
-    if (size) *size = r->size;
-    if (r->uart_num < UART_NUM_MAX) taskEXIT_CRITICAL();
-
-    return length;
-}
-
-// Get and remove data from buffer
-//------------------------------------------------------------
-int uart_buf_get(uart_ringbuf_t *r, uint8_t *dest, size_t len)
-{
-    if (r->buf == NULL) return 0;
-
-    size_t cnt = 0;
-    if (r->uart_num < UART_NUM_MAX) taskENTER_CRITICAL();
-    size_t length = r->length;
-    if (r->uart_num < UART_NUM_MAX) taskEXIT_CRITICAL();
-
-    if (length == 0) return 0;
-
-    while (length) {
-        if (dest) dest[cnt] = r->buf[r->head];
-        r->head = (r->head + 1) % r->size;
-        length--;
-        cnt++;
-        if (cnt >= len) break;
-    }
-
-    if (r->uart_num < UART_NUM_MAX) taskENTER_CRITICAL();
-    r->length -= cnt;
-    if (r->uart_num < UART_NUM_MAX) taskEXIT_CRITICAL();
-
-    return cnt;
-}
-
-// Remove data from buffer
-//------------------------------------------------
-int uart_buf_remove(uart_ringbuf_t *r, size_t len)
-{
-    size_t cnt = 0;
-    if (r->uart_num < UART_NUM_MAX) taskENTER_CRITICAL();
-    size_t length = r->length;
-    if (r->uart_num < UART_NUM_MAX) taskEXIT_CRITICAL();
-
-    if (length == 0) return 0;
-
-    while (length) {
-        r->head = (r->head + 1) % r->size;
-        length--;
-        cnt++;
-        if (cnt >= len) break;
-    }
-
-    if (r->uart_num < UART_NUM_MAX) taskENTER_CRITICAL();
-    r->length -= cnt;
-    if (r->uart_num < UART_NUM_MAX) taskEXIT_CRITICAL();
-
-    return cnt;
-}
-
-// Set the data in uart buffer to blank
-//-----------------------------------------------------------
-int uart_buf_blank(uart_ringbuf_t *r, size_t pos, size_t len)
-{
-    size_t cnt = 0;
-    if (r->buf == NULL) return 0;
-
-    if (r->uart_num < UART_NUM_MAX) taskENTER_CRITICAL();
-    int length = r->length - pos;
-    size_t head = r->head;
-    if (r->uart_num < UART_NUM_MAX) taskEXIT_CRITICAL();
-
-    if (length <= 0) return 0;
-
-    head = (head + pos) % r->size;
-    while (length) {
-        r->buf[head] = '^';
-        head = (head + 1) % r->size;
-        length--;
-        cnt++;
-        if (cnt >= len) break;
-    }
-
-    return cnt;
-}
-
-// Get data from buffer, but leave it in buffer
-// Copy from the requested position in the buffer
-//------------------------------------------------------------------------------
-int uart_buf_copy_from(uart_ringbuf_t *r, size_t pos, uint8_t *dest, size_t len)
-{
-    if (r->buf == NULL) return 0;
-    if (dest == NULL) return 0;    // no destination buffer
-
-    size_t cnt = 0;
-    if (r->uart_num < UART_NUM_MAX) taskENTER_CRITICAL();
-    int length = r->length - pos;
-    size_t head = r->head;
-    if (r->uart_num < UART_NUM_MAX) taskEXIT_CRITICAL();
-
-    if (length <= 0) return 0;
-    if (len > length) len = length;
-
-    head = (head + pos) % r->size;
-    while (length) {
-        dest[cnt] = r->buf[head];
-        head = (head + 1) % r->size;
-        length--;
-        cnt++;
-        if (cnt >= len) break;
-    }
-
-    return cnt;
-}
-
-// Get data from buffer, but leave it in buffer
-// Copy from the buffer start
-//-------------------------------------------------------------
-int uart_buf_copy(uart_ringbuf_t *r, uint8_t *dest, size_t len)
-{
-    return uart_buf_copy_from(r, 0, dest, len);
-}
-
-// Find pattern in uart buffer
-//-------------------------------------------------------------------------------------------------------------------------------
-int uart_buf_find_from(uart_ringbuf_t *r, size_t start_pos, size_t size, const char *pattern, int pattern_length, size_t *buflen)
-{
-    if (r->buf == NULL) return -1;
-
-    int c, d, e, pos, position = -1;
-    //if ((pattern == NULL) || (pattern_length == 0)) return -1;
-
-    if (r->uart_num < UART_NUM_MAX) taskENTER_CRITICAL();
-    int length = r->length - start_pos;
-    size_t head = r->head;
-    if (r->uart_num < UART_NUM_MAX) taskEXIT_CRITICAL();
-
-    if (length <= 0) return -1;
-    if (size > length) size = length;
-
-    if (buflen) *buflen = (length > size) ? size : length;
-    if (pattern_length <= length) {
-        for (c = 0; c <= (length - pattern_length); c++) {
-            if (c > size) break;
-            position = e = c;
-            // check pattern
-            for (d = 0; d < pattern_length; d++) {
-                pos = (head + start_pos + e) % r->size;
-                if (pattern[d] == r->buf[pos]) e++;
-                else {
-                    position = -1;
-                    break;
-                }
-            }
-            if (d == pattern_length) break;
-        }
-    }
-
-    if (position >= 0) return (start_pos + position);
-    return position;
-}
-
-// Find pattern in uart buffer
-//--------------------------------------------------------------------------------------------------------
-int uart_buf_find(uart_ringbuf_t *r, size_t size, const char *pattern, int pattern_length, size_t *buflen)
-{
-    return uart_buf_find_from(r, 0, size, pattern, pattern_length, buflen);
-}
-
-// Empty uart buffer
-//-------------------------------------
-void uart_buf_flush(uart_ringbuf_t *r)
-{
-    if (r->uart_num < UART_NUM_MAX) taskENTER_CRITICAL();
-    if (r->length > 0) {
-        r->tail = 0;
-        r->head = 0;
-        r->length = 0;
-        r->overflow = 0;
-    }
-    if (r->uart_num < UART_NUM_MAX) taskEXIT_CRITICAL();
-}
-
 //--------------------------------------
 int uart_putc(uint32_t uart_num, char c)
 {
@@ -373,12 +138,8 @@ int uart_write(uint32_t uart_num, const uint8_t *buff, size_t len)
 void uart_ringbuf_alloc(uint8_t uart_num, size_t sz)
 {
     if (uart_num >= UART_NUM_MAX) return;
-    mpy_uarts[uart_num].uart_buffer.buf = pvPortMalloc(sz);
-    mpy_uarts[uart_num].uart_buffer.size = sz;
-    mpy_uarts[uart_num].uart_buffer.head = 0;
-    mpy_uarts[uart_num].uart_buffer.tail = 0;
-    mpy_uarts[uart_num].uart_buffer.length = 0;
-    mpy_uarts[uart_num].uart_buffer.uart_num = uart_num;
+    sz = uart_buf_pow2_size(sz);
+    uart_buf_init(&mpy_uarts[uart_num].uart_buffer, pvPortMalloc(sz), sz, uart_num);
     mpy_uarts[uart_num].uart_buffer.notify = false;
     mpy_uarts[uart_num].uart_buf = &mpy_uarts[uart_num].uart_buffer;
 }
@@ -389,9 +150,7 @@ void uart_ringbuf_alloc(uint8_t uart_num, size_t sz)
 int mp_uart_config(uint32_t uart_num, uint32_t baud_rate, uint32_t databits, uart_stopbits_t stopbits, uart_parity_t parity)
 {
 
-    mpy_uarts[uart_num].uart_buf->head = 0;
-    mpy_uarts[uart_num].uart_buf->tail = 0;
-    mpy_uarts[uart_num].uart_buf->length = 0;
+    uart_buf_flush(mpy_uarts[uart_num].uart_buf);
 
     configASSERT(databits >= 5 && databits <= 8);
     if (databits == 5) {
@@ -624,15 +383,15 @@ static void uart_event_task(void *pvParameters)
     while (1) {
     	if (self->end_task) break;
         // Waiting for UART event.
-        if ((mpy_uarts[self->uart_num].uart_buf->length > 0) &&
+        if ((uart_buf_length(mpy_uarts[self->uart_num].uart_buf, NULL) > 0) &&
             (xSemaphoreTake(mpy_uarts[self->uart_num].uart_mutex, UART_MUTEX_TIMEOUT) == pdTRUE)) {
         	// Received data already placed in MPy buffer
-            if ((self->error_cb) && (mpy_uarts[self->uart_num].uart_buf->overflow > 0)) {
+            if ((self->error_cb) && (uart_buf_overflow(mpy_uarts[self->uart_num].uart_buf) > 0)) {
                 // MPy buffer full (overflow)
                 _sched_callback(self->error_cb, self->uart_num, UART_CB_TYPE_ERROR, UART_ERROR_BUFFER_FULL, NULL);
             }
             else {
-                if ((self->data_cb) && (self->data_cb_size > 0) && (mpy_uarts[self->uart_num].uart_buf->length >= self->data_cb_size)) {
+                if ((self->data_cb) && (self->data_cb_size > 0) && (uart_buf_length(mpy_uarts[self->uart_num].uart_buf, NULL) >= self->data_cb_size)) {
                     // ** callback on data length received
                     uint8_t *dtmp = pvPortMalloc(self->data_cb_size);
                     if (dtmp) {
@@ -644,7 +403,7 @@ static void uart_event_task(void *pvParameters)
                 }
                 else if (self->pattern_cb) {
                     // ** callback on pattern received
-                    size_t len = mpy_uarts[self->uart_num].uart_buf->length;
+                    size_t len = uart_buf_length(mpy_uarts[self->uart_num].uart_buf, NULL);
                     uint8_t *dtmp = pvPortMalloc(len+self->pattern_len);
                     if (dtmp) {
                         uart_buf_copy(mpy_uarts[self->uart_num].uart_buf, dtmp, len);
@@ -758,7 +517,7 @@ char *_uart_read(handle_t uart_num, int timeout, char *lnend, char *lnstart)
             return NULL;
         }
     	// check for minimal length
-        size_t len = mpy_uarts[uart_num].uart_buf->length;
+        size_t len = uart_buf_length(mpy_uarts[uart_num].uart_buf, NULL);
 		if (len < minlen) {
 	    	xSemaphoreGive(mpy_uarts[uart_num].uart_mutex);
 	    	return NULL;
@@ -780,7 +539,7 @@ char *_uart_read(handle_t uart_num, int timeout, char *lnend, char *lnstart)
                 mp_hal_wdt_reset();
                 continue;
             }
-            len = mpy_uarts[uart_num].uart_buf->length;
+            len = uart_buf_length(mpy_uarts[uart_num].uart_buf, NULL);
 			if (buflen < len) {
 				// ** new data received, reset timeout
 				buflen = len;
@@ -881,6 +640,10 @@ STATIC void machine_uart_print(const mp_print_t *print, mp_obj_t self_in, mp_pri
     if (self->error_cb) {
     	mp_printf(print, "\n     error CB: True");
     }
+    if (mpy_uarts[self->uart_num].uart_buf) {
+        mp_printf(print, "\n     Rx buffer: size=%u, max used=%u, overflow=%u",
+                mpy_uarts[self->uart_num].uart_buf->size, mpy_uarts[self->uart_num].uart_buf->max_used, uart_buf_overflow(mpy_uarts[self->uart_num].uart_buf));
+    }
     if (mpy_uarts[self->uart_num].task_id) {
     	mp_printf(print, "\n     Event task minimum stack: %u of %u",
     	        uxTaskGetStackHighWaterMark(mpy_uarts[self->uart_num].task_id) * sizeof(StackType_t), configMINIMAL_STACK_SIZE * sizeof(StackType_t));
@@ -1020,7 +783,8 @@ STATIC mp_obj_t machine_uart_make_new(const mp_obj_type_t *type, size_t n_args,
     int bufsize = kargs[ARG_buffer_size].u_int;
     if (bufsize < 512) bufsize = 512;
     if (bufsize > 8192) bufsize = 8192;
-    self->buffer_size = bufsize;
+    // the ring buffer size is a power of 2
+    self->buffer_size = uart_buf_pow2_size(bufsize);
 
     LOGD(TAG, "Init");
     machine_uart_init_helper(self, n_args - 1, args + 1, &kw_args);
@@ -1081,7 +845,7 @@ STATIC mp_obj_t machine_uart_any(mp_obj_t self_in) {
     _check_uart(self);
     int res = 0;
 	if (xSemaphoreTake(mpy_uarts[self->uart_num].uart_mutex, UART_MUTEX_TIMEOUT) == pdTRUE) {
-	    res = mpy_uarts[self->uart_num].uart_buf->length;
+	    res = uart_buf_length(mpy_uarts[self->uart_num].uart_buf, NULL);
 	    xSemaphoreGive(mpy_uarts[self->uart_num].uart_mutex);
 	}
 
@@ -1287,7 +1051,7 @@ STATIC mp_uint_t machine_uart_read(mp_obj_t self_in, void *buf_in, mp_uint_t siz
                 continue;
             }
 
-            if (mpy_uarts[self->uart_num].uart_buf->length < size) {
+            if (uart_buf_length(mpy_uarts[self->uart_num].uart_buf, NULL) < size) {
 		    	xSemaphoreGive(mpy_uarts[self->uart_num].uart_mutex);
 	    		vTaskDelay(2 / portTICK_PERIOD_MS);
 				mp_hal_wdt_reset();
@@ -1348,7 +1112,7 @@ STATIC mp_uint_t machine_uart_ioctl(mp_obj_t self_in, mp_uint_t request, mp_uint
             *errcode = MP_EINVAL;
             return MP_STREAM_ERROR;
         }
-        rxbufsize = mpy_uarts[self->uart_num].uart_buf->length;
+        rxbufsize = uart_buf_length(mpy_uarts[self->uart_num].uart_buf, NULL);
     	xSemaphoreGive(mpy_uarts[self->uart_num].uart_mutex);
 
         if ((flags & MP_STREAM_POLL_RD) && rxbufsize > 0) {
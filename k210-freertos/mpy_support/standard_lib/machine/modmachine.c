@@ -41,6 +41,7 @@
 #include "hal.h"
 #include "modmachine.h"
 #include "mphalport.h"
+#include "gccollect.h"
 #include "extmod/machine_mem.h"
 #include "w25qxx.h"
 #include "platform_k210.h"
@@ -182,6 +183,27 @@ bool mpy_config_crc(bool set)
     return (mpy_config.crc == ccrc);
 }
 
+// Convert the configuration saved by the previous version
+//-----------------------------------------------------
+static bool mpy_config_migrate(const mpy_config_t *config)
+{
+    uint32_t crc;
+    if (config->config.ver != MPY_CONFIG_PREV_VERSION_NUM) return false;
+    memcpy((void *)&crc, (const uint8_t *)&config->config + MPY_CONFIG_PREV_SIZE, sizeof(uint32_t));
+    if (crc != hal_crc32((const void *)&config->config, MPY_CONFIG_PREV_SIZE, 0)) return false;
+
+    memcpy((void *)&mpy_config.config, (const void *)&config->config, MPY_CONFIG_PREV_SIZE);
+    mpy_config.config.ver = MICROPY_PY_LOBO_VERSION_NUM;
+    mpy_config.config.gc_mode = GC_THRESHOLD_MODE_FIXED;
+    mpy_config.config.gc_target = 0;
+    if (!mpy_config_crc(true)) {
+        LOGW("CONFIG", "Error saving migrated configuration");
+        return false;
+    }
+    LOGW("CONFIG", "Configuration migrated from version %06X", MPY_CONFIG_PREV_VERSION_NUM);
+    return true;
+}
+
 //--------------------
 bool mpy_read_config()
 {
@@ -201,6 +223,10 @@ bool mpy_read_config()
                 LOGW("CONFIG", "New MicroPython version");
             }
         }
+        else if (mpy_config_migrate(&config)) {
+            // previous version's configuration, shorter structure
+            ret = mpy_config_crc(false);
+        }
         else {
             LOGW("CONFIG", "Error reading configuration (crc)");
         }
@@ -227,6 +253,8 @@ void mpy_config_set_default()
     mpy_config.config.log_level = LOG_WARN;
     mpy_config.config.vm_divisor = MICROPY_PY_THREAD_GIL_VM_DIVISOR;
     mpy_config.config.log_color = MICROPY_PY_USE_LOG_COLORS;
+    mpy_config.config.gc_mode = GC_THRESHOLD_MODE_FIXED;
+    mpy_config.config.gc_target = 0;
 
     if (!mpy_config_crc(true)) LOGW("CONFIG", "Error setting default flash configuration");
 }
@@ -519,6 +547,11 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_machine_baudrate_obj, 0, 1, mod_m
 //---------------------------------
 STATIC mp_obj_t machine_reset(void)
 {
+    // write the cached file system sectors before reset
+    w25qxx_cache_flush();
+    #if MICRO_PY_FLASH_SAVE_ERASED_MAP
+    w25qxx_erased_map_save(MICRO_PY_FLASH_ERASED_MAP_ADDR);
+    #endif
     sysctl->soft_reset.soft_reset = 1; // This function does not return.
     while (1) {
         ;
@@ -549,7 +582,7 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_machine_flash_spi_check_obj, mod_machine_fl
 //--------------------------------------------------------------------------------------------
 STATIC mp_obj_t machine_mpy_config(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
 {
-    enum { ARG_twotasks, ARG_pystacken, ARG_heap, ARG_pyssize, ARG_mainssize, ARG_freq, ARG_bdr, ARG_pin, ARG_logl, ARG_logcolor, ARG_vmd, ARG_print };
+    enum { ARG_twotasks, ARG_pystacken, ARG_heap, ARG_pyssize, ARG_mainssize, ARG_freq, ARG_bdr, ARG_pin, ARG_logl, ARG_logcolor, ARG_vmd, ARG_gcmode, ARG_gctarget, ARG_print };
     const mp_arg_t allowed_args[] = {
        { MP_QSTR_two_tasks_enable,  MP_ARG_KW_ONLY | MP_ARG_OBJ, { .u_obj = mp_const_none } },
        { MP_QSTR_pystack_enable,    MP_ARG_KW_ONLY | MP_ARG_OBJ, { .u_obj = mp_const_none } },
@@ -562,6 +595,8 @@ STATIC mp_obj_t machine_mpy_config(size_t n_args, const mp_obj_t *pos_args, mp_m
        { MP_QSTR_log_level,         MP_ARG_KW_ONLY | MP_ARG_OBJ, { .u_obj = mp_const_none } },
        { MP_QSTR_log_color,         MP_ARG_KW_ONLY | MP_ARG_OBJ, { .u_obj = mp_const_none } },
        { MP_QSTR_vm_divisor,        MP_ARG_KW_ONLY | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+       { MP_QSTR_gc_mode,           MP_ARG_KW_ONLY | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+       { MP_QSTR_gc_target,         MP_ARG_KW_ONLY | MP_ARG_OBJ, { .u_obj = mp_const_none } },
        { MP_QSTR_print,             MP_ARG_KW_ONLY | MP_ARG_BOOL, { .u_bool = true } },
     };
 
@@ -661,6 +696,24 @@ STATIC mp_obj_t machine_mpy_config(size_t n_args, const mp_obj_t *pos_args, mp_m
         barg = mp_obj_is_true(args[ARG_logcolor].u_obj);
         config.config.log_color = barg;
     }
+    if (args[ARG_gcmode].u_obj != mp_const_none) {
+        iarg = gc_threshold_mode(mp_obj_str_get_str(args[ARG_gcmode].u_obj));
+        if (iarg < 0) {
+            mp_raise_ValueError("GC mode 'fixed', 'pause' or 'occupancy' expected");
+        }
+        if (iarg != config.config.gc_mode) config.config.gc_target = 0;
+        config.config.gc_mode = iarg;
+    }
+    if (args[ARG_gctarget].u_obj != mp_const_none) {
+        iarg = mp_obj_get_int(args[ARG_gctarget].u_obj);
+        if ((config.config.gc_mode == GC_THRESHOLD_MODE_OCCUPANCY) && ((iarg < 0) || (iarg > 95))) {
+            mp_raise_ValueError("GC occupancy target 0~95 % expected");
+        }
+        if ((config.config.gc_mode == GC_THRESHOLD_MODE_PAUSE) && (iarg < 0)) {
+            mp_raise_ValueError("GC pause target out of range");
+        }
+        config.config.gc_target = iarg;
+    }
 
     // Check configuration values
     if (mpy_config.config.use_two_main_tasks != config.config.use_two_main_tasks) changed = true;
@@ -675,6 +728,8 @@ STATIC mp_obj_t machine_mpy_config(size_t n_args, const mp_obj_t *pos_args, mp_m
     if (mpy_config.config.log_level != config.config.log_level) changed = true;
     if (mpy_config.config.log_color != config.config.log_color) changed = true;
     if (mpy_config.config.vm_divisor != config.config.vm_divisor) changed = true;
+    if (mpy_config.config.gc_mode != config.config.gc_mode) changed = true;
+    if (mpy_config.config.gc_target != config.config.gc_target) changed = true;
 
     if (args[ARG_print].u_bool) {
         mp_printf(&mp_plat_print, "\r\n%sMicroPython configuration:\r\n--------------------------%s\r\n", term_color(CYAN), term_color(DEFAULT));
@@ -697,6 +752,11 @@ STATIC mp_obj_t machine_mpy_config(size_t n_args, const mp_obj_t *pos_args, mp_m
         mp_printf(&mp_plat_print, "  Default log level: %u (%s)\r\n", config.config.log_level, log_levels[config.config.log_level]);
         mp_printf(&mp_plat_print, "     Use log colors: %u (%s)\r\n", config.config.log_color, (config.config.log_color) ? "True" : "False");
         mp_printf(&mp_plat_print, "         VM divisor: %u bytecodes\r\n", config.config.vm_divisor);
+        mp_printf(&mp_plat_print, "  GC threshold mode: %s", gc_threshold_modes[config.config.gc_mode]);
+        if (config.config.gc_target == 0) mp_printf(&mp_plat_print, " (default target)\r\n");
+        else if (config.config.gc_mode == GC_THRESHOLD_MODE_PAUSE) mp_printf(&mp_plat_print, " (max %d us)\r\n", config.config.gc_target);
+        else if (config.config.gc_mode == GC_THRESHOLD_MODE_OCCUPANCY) mp_printf(&mp_plat_print, " (%d %% of heap)\r\n", config.config.gc_target);
+        else mp_printf(&mp_plat_print, " (%d B)\r\n", config.config.gc_target);
         if (changed) {
             mp_printf(&mp_plat_print, "\r\nPress %sY%s to save", term_color(BROWN), term_color(DEFAULT));
             char key = '\0';
@@ -715,7 +775,7 @@ STATIC mp_obj_t machine_mpy_config(size_t n_args, const mp_obj_t *pos_args, mp_m
             }
         }
     }
-    mp_obj_t cfg_tuple[13];
+    mp_obj_t cfg_tuple[15];
     cfg_tuple[0] = (mpy_config.config.use_two_main_tasks) ? mp_const_true : mp_const_false;
     cfg_tuple[1] = (mpy_config.config.pystack_enabled) ? mp_const_true : mp_const_false;
     cfg_tuple[2] = mp_obj_new_int(MICRO_PY_MAX_HEAP_SIZE);
@@ -729,8 +789,10 @@ STATIC mp_obj_t machine_mpy_config(size_t n_args, const mp_obj_t *pos_args, mp_m
     cfg_tuple[10] = mp_obj_new_int(mpy_config.config.log_level);
     cfg_tuple[11] = (mpy_config.config.log_color) ? mp_const_true : mp_const_false;
     cfg_tuple[12] = mp_obj_new_int(mpy_config.config.vm_divisor);
+    cfg_tuple[13] = mp_obj_new_str(gc_threshold_modes[mpy_config.config.gc_mode], strlen(gc_threshold_modes[mpy_config.config.gc_mode]));
+    cfg_tuple[14] = mp_obj_new_int(mpy_config.config.gc_target);
 
-    return mp_obj_new_tuple(13, cfg_tuple);
+    return mp_obj_new_tuple(15, cfg_tuple);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(machine_mpy_config_obj, 0, machine_mpy_config);
 
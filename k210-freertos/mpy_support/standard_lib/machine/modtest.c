@@ -589,7 +589,7 @@ STATIC mp_obj_t test_camera(size_t n_args, const mp_obj_t *pos_args, mp_map_t *k
                     }
                 }
                 tft_frame_buffer = fb;
-                send_frame_buffer();
+                send_frame_buffer(true);
             }
             else {
                 uint8_t *frame_buffer = sensor.gram_mux ? sensor.gram0 : sensor.gram1;
@@ -618,7 +618,7 @@ STATIC mp_obj_t test_camera(size_t n_args, const mp_obj_t *pos_args, mp_map_t *k
                         fb_ok++;
                         fb_ok_n = sensor.frame_count;
                         if (buffer == mp_const_true) buffer = mp_obj_new_str_copy(&mp_type_bytes, (const byte*)frame_buffer, jpeg_buffer_idx+2);
-                        send_frame_buffer();
+                        send_frame_buffer(true);
                     }
                 }
             }
@@ -676,7 +676,7 @@ STATIC mp_obj_t test_camera(size_t n_args, const mp_obj_t *pos_args, mp_map_t *k
                     }
                 }
             }
-            send_frame_buffer();
+            send_frame_buffer(true);
         }
 
         for (int i= 0; i<1280; i++) {
@@ -0,0 +1,308 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "uart_ringbuf.h"
+
+
+// ==== UART Ring Buffer functions =========================================
+//
+// Single producer / single consumer ring buffer, no locking is needed.
+// Buffer size is always a power of 2, 'head' and 'tail' are free running indexes,
+// 'tail' is only changed by the producer (uart ISR or the task putting the data),
+// 'head' is only changed by the consumer. Used length is 'tail - head'.
+
+// Copy 'len' bytes starting at free running index 'idx' from the buffer
+//------------------------------------------------------------------------------------
+static void ringbuf_read(uart_ringbuf_t *r, size_t idx, uint8_t *dest, size_t len)
+{
+    size_t pos = RINGBUF_IDX(r, idx);
+    size_t first = r->size - pos;
+    if (first > len) first = len;
+    memcpy(dest, r->buf + pos, first);
+    if (len > first) memcpy(dest + first, r->buf, len - first);
+}
+
+// Copy 'len' bytes to the buffer starting at free running index 'idx'
+//-----------------------------------------------------------------------------------------
+static void ringbuf_write(uart_ringbuf_t *r, size_t idx, const uint8_t *src, size_t len)
+{
+    size_t pos = RINGBUF_IDX(r, idx);
+    size_t first = r->size - pos;
+    if (first > len) first = len;
+    memcpy(r->buf + pos, src, first);
+    if (len > first) memcpy(r->buf, src + first, len - first);
+}
+
+// Publish the new tail index, update the high watermark
+// Used by the producer after the data are written to the buffer
+//------------------------------------------------------------
+void uart_buf_set_tail(uart_ringbuf_t *r, size_t tail)
+{
+    // make sure the data are written before the index
+    __sync_synchronize();
+    r->tail = tail;
+    size_t used = tail - r->head;
+    if (used > r->max_used) r->max_used = used;
+}
+
+// Get the power of 2 buffer size not greater than 'size' (minimum 16)
+//---------------------------------------
+size_t uart_buf_pow2_size(size_t size)
+{
+    size_t sz = 16;
+    while ((sz << 1) <= size) sz <<= 1;
+    return sz;
+}
+
+// Initialize the ring buffer using the provided data buffer
+// 'size' must be power of 2, if not, the lower power of 2 is used
+//----------------------------------------------------------------------------------------
+void uart_buf_init(uart_ringbuf_t *r, uint8_t *buf, size_t size, uint8_t uart_num)
+{
+    r->buf = buf;
+    r->size = (buf) ? uart_buf_pow2_size(size) : 0;
+    r->head = 0;
+    r->tail = 0;
+    r->overflow = 0;
+    r->overflow_ack = 0;
+    r->max_used = 0;
+    r->uart_num = uart_num;
+}
+
+// Get the number of bytes dropped since the last buffer flush
+//-------------------------------------------------
+size_t uart_buf_overflow(uart_ringbuf_t *r)
+{
+    return r->overflow - r->overflow_ack;
+}
+
+// Put data into buffer
+// Operation on uart's ringbuffer is not allowed
+//-----------------------------------------------------------
+int uart_buf_put(uart_ringbuf_t *r, uint8_t *src, size_t len)
+{
+    if (r->uart_num < UART_NUM_MAX) return 0;
+    if (r->buf == NULL) {
+        r->overflow += len;
+        return 0;
+    }
+    size_t tail = r->tail;
+    size_t room = r->size - (tail - r->head);
+    if (len > room) {
+        r->overflow += len - room;
+        len = room;
+    }
+    if (len == 0) return 0;
+
+    ringbuf_write(r, tail, src, len);
+    uart_buf_set_tail(r, tail + len);
+    return len;
+}
+
+// Remove data from buffer end
+// Operation is not allowed on uart's ringbuffer
+//---------------------------------------------------------
+int uart_buf_remove_from_end(uart_ringbuf_t *r, size_t len)
+{
+    if (r->uart_num < UART_NUM_MAX) return 0;
+    if (r->buf == NULL) return 0;
+    size_t length = r->tail - r->head;
+
+    if (len > length) len = length;
+    r->tail -= len;
+    return len;
+}
+
+// Get current buffer length
+//-----------------------------------------------------
+size_t uart_buf_length(uart_ringbuf_t *r, size_t *size)
+{
+    if (size) *size = r->size;
+    return r->tail - r->head;
+}
+
+// Get the pointer to the buffer data at position 'pos' without copying it
+// Returns the length of the contiguous data block at that position,
+// if the data wraps around the buffer end, the rest is at 'pos + returned length'
+//---------------------------------------------------------------------
+size_t uart_buf_peek(uart_ringbuf_t *r, size_t pos, uint8_t **data)
+{
+    if (r->buf == NULL) return 0;
+    size_t head = r->head;
+    size_t length = r->tail - head;
+    __sync_synchronize();
+    if (pos >= length) return 0;
+
+    size_t idx = RINGBUF_IDX(r, head + pos);
+    length -= pos;
+    if (length > (r->size - idx)) length = r->size - idx;
+    *data = r->buf + idx;
+    return length;
+}
+
+// Get and remove data from buffer
+//------------------------------------------------------------
+int uart_buf_get(uart_ringbuf_t *r, uint8_t *dest, size_t len)
+{
+    if (r->buf == NULL) return 0;
+
+    size_t head = r->head;
+    size_t length = r->tail - head;
+    // make sure the index is read before the data
+    __sync_synchronize();
+
+    if (length == 0) return 0;
+    if (len > length) len = length;
+
+    if (dest) ringbuf_read(r, head, dest, len);
+    // make sure the data are read before the space is released
+    __sync_synchronize();
+    r->head = head + len;
+
+    return len;
+}
+
+// Remove data from buffer
+//------------------------------------------------
+int uart_buf_remove(uart_ringbuf_t *r, size_t len)
+{
+    size_t head = r->head;
+    size_t length = r->tail - head;
+
+    if (length == 0) return 0;
+    if (len > length) len = length;
+
+    __sync_synchronize();
+    r->head = head + len;
+
+    return len;
+}
+
+// Set the data in uart buffer to blank
+//-----------------------------------------------------------
+int uart_buf_blank(uart_ringbuf_t *r, size_t pos, size_t len)
+{
+    if (r->buf == NULL) return 0;
+
+    size_t head = r->head;
+    int length = (r->tail - head) - pos;
+    __sync_synchronize();
+
+    if (length <= 0) return 0;
+    if (len > length) len = length;
+
+    size_t idx = RINGBUF_IDX(r, head + pos);
+    size_t first = r->size - idx;
+    if (first > len) first = len;
+    memset(r->buf + idx, '^', first);
+    if (len > first) memset(r->buf, '^', len - first);
+
+    return len;
+}
+
+// Get data from buffer, but leave it in buffer
+// Copy from the requested position in the buffer
+//------------------------------------------------------------------------------
+int uart_buf_copy_from(uart_ringbuf_t *r, size_t pos, uint8_t *dest, size_t len)
+{
+    if (r->buf == NULL) return 0;
+    if (dest == NULL) return 0;    // no destination buffer
+
+    size_t head = r->head;
+    int length = (r->tail - head) - pos;
+    __sync_synchronize();
+
+    if (length <= 0) return 0;
+    if (len > length) len = length;
+
+    ringbuf_read(r, head + pos, dest, len);
+
+    return len;
+}
+
+// Get data from buffer, but leave it in buffer
+// Copy from the buffer start
+//-------------------------------------------------------------
+int uart_buf_copy(uart_ringbuf_t *r, uint8_t *dest, size_t len)
+{
+    return uart_buf_copy_from(r, 0, dest, len);
+}
+
+// Find pattern in uart buffer
+//-------------------------------------------------------------------------------------------------------------------------------
+int uart_buf_find_from(uart_ringbuf_t *r, size_t start_pos, size_t size, const char *pattern, int pattern_length, size_t *buflen)
+{
+    if (r->buf == NULL) return -1;
+
+    int c, d, e, position = -1;
+    //if ((pattern == NULL) || (pattern_length == 0)) return -1;
+
+    size_t head = r->head;
+    int length = (r->tail - head) - start_pos;
+    __sync_synchronize();
+
+    if (length <= 0) return -1;
+    if (size > length) size = length;
+
+    if (buflen) *buflen = (length > size) ? size : length;
+    head += start_pos;
+    if (pattern_length <= length) {
+        for (c = 0; c <= (length - pattern_length); c++) {
+            if (c > size) break;
+            position = e = c;
+            // check pattern
+            for (d = 0; d < pattern_length; d++) {
+                if ((uint8_t)pattern[d] == r->buf[RINGBUF_IDX(r, head + e)]) e++;
+                else {
+                    position = -1;
+                    break;
+                }
+            }
+            if (d == pattern_length) break;
+        }
+    }
+
+    if (position >= 0) return (start_pos + position);
+    return position;
+}
+
+// Find pattern in uart buffer
+//--------------------------------------------------------------------------------------------------------
+int uart_buf_find(uart_ringbuf_t *r, size_t size, const char *pattern, int pattern_length, size_t *buflen)
+{
+    return uart_buf_find_from(r, 0, size, pattern, pattern_length, buflen);
+}
+
+// Empty uart buffer
+// Only the consumer's index is changed, so it is safe while receiving
+//-------------------------------------
+void uart_buf_flush(uart_ringbuf_t *r)
+{
+    r->head = r->tail;
+    // 'overflow' is changed only by the producer
+    r->overflow_ack = r->overflow;
+}
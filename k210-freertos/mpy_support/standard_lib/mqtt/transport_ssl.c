@@ -345,7 +345,7 @@ static int ssl_read(transport_handle_t t, char *buffer, int len, int timeout_ms)
     transport_ssl_t *ssl = transport_get_context_data(t);
 
     if (net_active_interfaces & ACTIVE_INTERFACE_WIFI) {
-        if (ssl->sock->buffer.length <= 0) {
+        if (ssl->sock->buffer.length == 0) {
             if ((poll = transport_poll_read(t, timeout_ms)) <= 0) {
                 return poll;
             }
@@ -150,7 +150,7 @@ static int mqtcp_read(transport_handle_t t, char *buffer, int len, int timeout_m
 
     if (net_active_interfaces & ACTIVE_INTERFACE_WIFI) {
         #if MICROPY_PY_USE_WIFI
-        if (tcp->sock->buffer.length <= 0) {
+        if (tcp->sock->buffer.length == 0) {
             poll = transport_poll_read(t, timeout_ms);
             if (poll <= 0) return poll;
         }
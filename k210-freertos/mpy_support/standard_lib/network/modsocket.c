@@ -1368,15 +1368,14 @@ STATIC void socket_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kin
     mp_printf(print, "Socket (fd=%d, link_id=%d, domain=%s, type=%s, proto=%s%s\r\n",
             sock->fd, sock->link_id, domain, type, proto, (sock->parent_sock) ? ", connected from listening socket" : "");
     mp_printf(print, "        timeout=%d, peer_closed=%s, buffer=%s\r\n",
-            sock->timeout, (sock->peer_closed) ? "True" : "False", (sock->buffer.buf) ? "Yes" : "No");
+            sock->timeout, (sock->peer_closed) ? "True" : "False", (sock->buffer.first) ? "Yes" : "No");
     if (sock->connect_time > 0) {
         mp_printf(print, "        connected=%s, connect_time=%lu ms\r\n",
                 (sock->peer_closed) ? "False" : "True",
                 (sock->connected_time > 0) ? sock->connected_time : (mp_hal_ticks_ms() - sock->connect_time));
     }
-    if (sock->buffer.buf) {
-        mp_printf(print, "        buf_size=%d, buf_length=%d, buf_owerflow=%d\r\n", sock->buffer.size, sock->buffer.length, sock->buffer.overflow);
-    }
+    mp_printf(print, "        buf_quota=%d, buf_length=%d, buf_owerflow=%d, buf_max_used=%d%s\r\n",
+            sock->buffer.quota, sock->buffer.length, sock->buffer.overflow, sock->buffer.max_used, (sock->buffer.hold) ? ", receive hold" : "");
     if (sock->listening) {
         mp_printf(print, "        Listening");
         if (sock->bind_port > 0) mp_printf(print, " on port %d", sock->bind_port);
@@ -1447,8 +1446,6 @@ socket_obj_t *_new_socket()
     sock->domain = AF_INET;
     sock->type = SOCK_STREAM;
     sock->proto = IPPROTO_TCP;
-    sock->buffer.uart_num = 255;
-    sock->static_buffer = mp_const_none;
     sock->cb = mp_const_none;
     sock->max_conn = 1;
     sock->active_conn = 0;
@@ -1457,11 +1454,7 @@ socket_obj_t *_new_socket()
         sock->conn_fd[i] = -1;
     }
     sock->peer_closed = false;
-    sock->buffer.buf = NULL;
-    sock->buffer.size = 0;
-    sock->buffer.head = 0;
-    sock->buffer.tail = 0;
-    sock->buffer.length = 0;
+    at_sockbuf_init(&sock->buffer, AT_SOCKBUF_QUOTA);
     sock->semaphore = NULL;
     sock->mutex = NULL;
     sock->connect_time = 0;
@@ -1500,18 +1493,9 @@ STATIC mp_obj_t get_socket(mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t
 
     if ((net_active_interfaces & ACTIVE_INTERFACE_WIFI) || (net_active_interfaces & ACTIVE_INTERFACE_GSM)) {
         if (args[3].u_obj != mp_const_none) {
-            // 4th argument can be buffer size
-            int buf_size = mp_obj_get_int(args[3].u_obj);
-            vstr_t vstr;
-            vstr_init(&vstr, buf_size);
-            vstr.len = buf_size-1;
-            sock->buffer.buf = (uint8_t *)vstr.buf;
-            sock->buffer.size = buf_size-1;
-            sock->buffer.head = 0;
-            sock->buffer.tail = 0;
-            sock->buffer.length = 0;
-            sock->buffer.uart_num = 255;
-            sock->static_buffer = mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+            // 4th argument can be buffer size, the amount of received data
+            // buffered before receiving is held
+            at_sockbuf_init(&sock->buffer, mp_obj_get_int(args[3].u_obj));
         }
         sock->fd = at_get_socket(sock);
         sock->link_id = sock->fd;
@@ -1596,6 +1580,11 @@ STATIC mp_obj_t mod_socket_info()
     for (int i=0; i<AT_MAX_SOCKETS; i++) {
         if (at_sockets[i] != NULL) n++;
     }
+    at_sockbuf_stats_t stats;
+    at_sockbuf_get_stats(&stats);
+    mp_printf(&mp_plat_print, "Socket buffers: chunks=%u (%d bytes), free=%u, min_free=%u, heap_chunks=%u, holds=%u\r\n",
+            stats.chunks, AT_SOCKBUF_CHUNK_SIZE, stats.free, stats.min_free, stats.heap_chunks, stats.holds);
+
     mp_printf(&mp_plat_print, "Client sockets: %d\r\n", n);
     for (int i=0; i<AT_MAX_SOCKETS; i++) {
         if (at_sockets[i] != NULL) {
@@ -1682,6 +1671,7 @@ STATIC const mp_rom_map_elem_t mp_module_socket_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_socket),              MP_ROM_PTR(&get_socket_obj) },
     { MP_ROM_QSTR(MP_QSTR_getaddrinfo),         MP_ROM_PTR(&mod_socket_getaddrinfo_obj) },
     { MP_ROM_QSTR(MP_QSTR_check),               MP_ROM_PTR(&mod_socket_info_obj) },
+    { MP_ROM_QSTR(MP_QSTR_info),                MP_ROM_PTR(&mod_socket_info_obj) },
     { MP_ROM_QSTR(MP_QSTR_close),               MP_ROM_PTR(&mod_socket_closesocket_obj) },
 
     { MP_ROM_QSTR(MP_QSTR_AF_INET),             MP_ROM_INT(AF_INET) },
@@ -41,11 +41,14 @@
 #include "mphalport.h"
 #include "modmachine.h"
 #include "at_util.h"
+#include "at_scan.h"
 
 #define WIFI_TASK_PRIORITY      13
 #define WIFI_TASK_BUF_SIZE      3072
 #define RECEIVE_TIMEOUT         3000
-#define WIFI_UART_BUFFER_SIZE   3072
+#define WIFI_UART_BUFFER_SIZE   4096
+#define WIFI_IPD_HEADER_MAX     24
+#define WIFI_SCAN_PREFIX_LEN    3
 
 QueueSetMemberHandle_t wifi_task_semaphore = NULL;
 bool wifi_task_semaphore_active = false;
@@ -73,6 +76,21 @@ static bool wifi_tcpsend_wait_sent = true;
 
 static at_responses_t at_responses = { 0 };
 static at_command_t at_command = { 0 };
+
+// Patterns the WiFi module can send at any time
+enum {
+    WIFI_SCAN_CLOSED = 0,
+    WIFI_SCAN_CONNECT,
+    WIFI_SCAN_TCPCONNECT,
+    WIFI_SCAN_READY,
+    WIFI_SCAN_TCP,
+    WIFI_SCAN_IPD,
+    WIFI_SCAN_NPATTERNS
+};
+static const char * const wifi_scan_patterns[WIFI_SCAN_NPATTERNS] = {
+    ",CLOSED", ",CONNECT", ",TCPconnect:", "ready\r\n", "+TCP,", "+IPD,"
+};
+static at_scanner_t wifi_scanner;
 static const char *WIFI_TAG = "[WIFI]";
 static const char *WIFI_TASK_TAG = "[WIFI_TASK]";
 /*
@@ -136,11 +154,22 @@ static void _recv_hold(int link_id, int state)
     command.dbg = wifi_debug;
     command.responses = &responses;
     command.at_uart_num = wifi_uart_num;
-    command.flush = true;
+    command.flush = false;
     command.timeout = 200;
     at_Cmd_Response(&command);
 }
 
+// Resume receiving on the socket's link if it was held and enough buffered data was read
+// !!this should be executed protected by mutex !!
+//-------------------------------------------------
+static void _check_recv_hold(socket_obj_t *sock)
+{
+    if ((sock->buffer.length <= (sock->buffer.quota / 2)) && (at_sockbuf_hold(&sock->buffer, false))) {
+        if (wifi_debug) LOGY(WIFI_TAG, "Resume receiving (link_id=%d, len=%lu)", sock->link_id, sock->buffer.length);
+        _recv_hold(sock->link_id, 0);
+    }
+}
+
 //----------------------------------------------------------------------------
 static void _create_new_socket(int link_id, uint8_t srv_n, char *ip, int port)
 {
@@ -262,62 +291,13 @@ static void _get_data_to_socket(char* data, size_t size, int link_id, int len, u
 
     // Check if open socket with the link_id exists
     socket_obj_t *sock = NULL;
-    bool write_sock = false;
     for (int i=0; i<AT_MAX_SOCKETS; i++) {
         if ((at_sockets[i] != NULL) && (at_sockets[i]->link_id == link_id)) {
             sock = at_sockets[i];
             break;
         }
     }
-    if (sock) {
-        write_sock = true;
-        if (sock->buffer.buf == NULL) {
-            // Allocate socket receive buffer if not allocated
-            sock->buffer.buf = pvPortMalloc(len+1460);
-            if (sock->buffer.buf) {
-                sock->buffer.size = len+1460;
-                sock->buffer.head = 0;
-                sock->buffer.tail = 0;
-                sock->buffer.length = 0;
-                sock->buffer.uart_num = 255;
-            }
-            else {
-                write_sock = false;
-                sock = NULL;
-            }
-        }
-        else if (sock->total_received == 0) {
-            sock->buffer.head = 0;
-            sock->buffer.tail = 0;
-            sock->buffer.length = 0;
-            sock->buffer.uart_num = 255;
-        }
-    }
-    else if (wifi_debug) LOGW(WIFI_TASK_TAG, "no open socket for link_id %d", link_id);
-
-    // === Get all data to socket buffer ===
-    if (sock) {
-        // Check if socket buffer needs to be expanded
-        if ((sock->buffer.length + len) >= sock->buffer.size) {
-            // need to expand the socket buffer
-            if (sock->static_buffer == mp_const_none) {
-                size_t old_size = sock->buffer.size;
-                size_t new_size = sock->buffer.size + len + 1460;
-                uint8_t *ptemp = pvPortMalloc(new_size);
-                if (ptemp != NULL) {
-                    memcpy(ptemp, sock->buffer.buf, old_size);
-                    vPortFree(sock->buffer.buf);
-                    sock->buffer.buf = ptemp;
-                    sock->buffer.size = new_size;
-                }
-                else if (wifi_debug) {
-                    write_sock = false;
-                    LOGW(WIFI_TAG, "Error expanding socket buffer");
-                }
-            }
-            else write_sock = false;
-        }
-    }
+    if ((sock == NULL) && (wifi_debug)) LOGW(WIFI_TASK_TAG, "no open socket for link_id %d", link_id);
 
     if (type == 1) {
         MP_THREAD_GIL_ENTER();
@@ -352,13 +332,10 @@ static void _get_data_to_socket(char* data, size_t size, int link_id, int len, u
         rd_len += inbuf;
         // some data received in uart buffer, copy to the socket buffer
         if (sock) {
-            if (write_sock) {
-                int wr_len = uart_buf_put(&sock->buffer, (uint8_t *)data, inbuf);
-                if ((wr_len != inbuf) && (wifi_debug)) {
-                    LOGW(WIFI_TAG, "Socket buffer write error (%d <> %d)", wr_len, inbuf);
-                }
+            int wr_len = at_sockbuf_put(&sock->buffer, (uint8_t *)data, inbuf);
+            if ((wr_len != inbuf) && (wifi_debug)) {
+                LOGW(WIFI_TAG, "Socket buffer write error (%d <> %d)", wr_len, inbuf);
             }
-            else sock->buffer.overflow += inbuf;
             sock->total_received += inbuf;
         }
         wifi_rx_count += inbuf;
@@ -368,8 +345,8 @@ static void _get_data_to_socket(char* data, size_t size, int link_id, int len, u
     if (wifi_debug) {
         if (rd_len != len) LOGE(WIFI_TAG, "Not all data read (%d <> %d)", rd_len, len);
         if (sock) {
-            LOGM(WIFI_TASK_TAG, "received (%lu ms); socket: len=%lu, ovf=%lu, tail=%lu, head=%lu",
-                    mp_hal_ticks_ms()-receive_start_time, sock->buffer.length, sock->buffer.overflow, sock->buffer.tail, sock->buffer.head);
+            LOGM(WIFI_TASK_TAG, "received (%lu ms); socket: len=%lu, ovf=%lu, quota=%lu",
+                    mp_hal_ticks_ms()-receive_start_time, sock->buffer.length, sock->buffer.overflow, sock->buffer.quota);
         }
         else {
             LOGM(WIFI_TASK_TAG, "received (%lu ms); no socket, len=%d", mp_hal_ticks_ms()-receive_start_time, len);
@@ -424,6 +401,13 @@ static void _get_data_to_socket(char* data, size_t size, int link_id, int len, u
         mp_hal_usdelay(500);
         MP_THREAD_GIL_EXIT();
     }
+
+    // === Hold receiving on the link if the socket's buffer quota is reached ===
+    // it is resumed when the data is read from the socket
+    if ((sock) && (sock->buffer.length >= sock->buffer.quota) && (at_sockbuf_hold(&sock->buffer, true))) {
+        if (wifi_debug) LOGY(WIFI_TASK_TAG, "Socket buffer quota reached, hold receiving (link_id=%d, len=%lu)", link_id, sock->buffer.length);
+        _recv_hold(link_id, 1);
+    }
 }
 
 // Parse +IPD (type=0) or +TCP (type=1) data request from WiFi module
@@ -432,7 +416,7 @@ static void _get_data_to_socket(char* data, size_t size, int link_id, int len, u
 static void parse_IPD(char* data, size_t size, int start_pos, uint8_t type)
 {
     // === Data received pattern found, copy data from UART buffer and analyze ===
-    int position = -1, link_id = 0, srv_id = 9, len = 0;
+    int inbuf, link_id = 0, srv_id = 9, len = 0;
     char *pipd = NULL;
     char *pipd_cmdend = NULL;
     char *sep = NULL;
@@ -447,20 +431,18 @@ static void parse_IPD(char* data, size_t size, int start_pos, uint8_t type)
     int ntry = 10;
     // Wait for complete command to arrive
     while (ntry > 0) {
-        position = uart_buf_find_from(mpy_uarts[wifi_uart_num].uart_buf, start_pos, 9999, ":", 1, NULL);
-        if (position < 0) {
-            if (type == 0) position = uart_buf_find_from(mpy_uarts[wifi_uart_num].uart_buf, start_pos, 9999, "\r\n", 2, NULL);
-            if (position < 0) {
-                mp_hal_usdelay(500);
-                ntry--;
-                continue;
-            }
-            cmd_len = position - start_pos + 2;
+        // the command is short, copy its maximal length and check for the command end
+        inbuf = uart_buf_copy_from(mpy_uarts[wifi_uart_num].uart_buf, start_pos, (uint8_t *)data, WIFI_IPD_HEADER_MAX);
+        pipd_cmdend = memchr(data, ':', inbuf);
+        if ((pipd_cmdend == NULL) && (type == 0)) pipd_cmdend = memchr(data, '\n', inbuf);
+        if (pipd_cmdend == NULL) {
+            if (inbuf >= WIFI_IPD_HEADER_MAX) break; // no command end, not a valid command
+            mp_hal_usdelay(500);
+            ntry--;
+            continue;
         }
-        else cmd_len = position - start_pos + 1;
-
-        // copy the full command into data buffer
-        uart_buf_copy_from(mpy_uarts[wifi_uart_num].uart_buf, start_pos, (uint8_t *)data, cmd_len);
+        cmd_len = pipd_cmdend - data + 1;
+        // terminate the full command in data buffer
         data[cmd_len] = '\0';
 
         if (wifi_debug)
@@ -571,21 +553,25 @@ err_param:
 //-------------------------------------------------------
 static void _check_wifi_response(char* data, size_t size)
 {
-    size_t buflen, bufsize;
+    size_t buflen;
     int inbuf, position;
+    at_scan_event_t event;
 
 check_again:
 
-    buflen = uart_buf_length(mpy_uarts[wifi_uart_num].uart_buf, &bufsize);
+    buflen = uart_buf_length(mpy_uarts[wifi_uart_num].uart_buf, NULL);
     if (buflen == 0) {
         // === No data in buffer ===
         return;
     }
 
-    // =========================================================
-    // === Check if 'n,CLOSED' pattern exists in uart buffer ===
-    position = uart_buf_find(mpy_uarts[wifi_uart_num].uart_buf, buflen, ",CLOSED", 7, NULL);
-    if (position > 0) {
+    // === Get the next pattern received, only the new data in uart buffer is scanned ===
+    if (!at_scan_next(&wifi_scanner, mpy_uarts[wifi_uart_num].uart_buf, &event)) event.pattern = -1;
+    position = event.pos;
+
+    // =====================================
+    // === Check for 'n,CLOSED' pattern ===
+    if ((event.pattern == WIFI_SCAN_CLOSED) && (position > 0)) {
         inbuf = uart_buf_copy_from(mpy_uarts[wifi_uart_num].uart_buf, position-1, (uint8_t *)data, 8);
         int link_id = (int)data[0] - '0';
         // Check if open socket with the link_id exists
@@ -627,26 +613,22 @@ check_again:
         goto check_again;
     }
 
-    // ==============================================================================
-    // === Check if 'n,CONNECT' or 's,n,TCPconnect:' pattern exists in uart buffer ===
+    // ==========================================================
+    // === Check for 'n,CONNECT' or 's,n,TCPconnect:' pattern ===
     //     link_id,CONNECT (NOT SUPPORTED)
     //     link_id,srv_id,TCPconnect:"IPaddr",port\r\n
     uint8_t type = 0;
     int cmd_size = 0;
-    position = uart_buf_find(mpy_uarts[wifi_uart_num].uart_buf, buflen, ",CONNECT", 8, NULL);
-    if (position < 2) {
-        position = uart_buf_find(mpy_uarts[wifi_uart_num].uart_buf, buflen, ",TCPconnect:", 12, NULL);
-        if (position >= 3) {
-            // TCP Server connection detected, get the full command
-            type = 1;
-            int cmd_end = -1;
-            while (cmd_end < 0) {
-                cmd_end = uart_buf_find_from(mpy_uarts[wifi_uart_num].uart_buf, position, 9999, "\r\n", 2, NULL);
-            }
-            cmd_size = (cmd_end - position) + 3;
+    if ((event.pattern == WIFI_SCAN_CONNECT) && (position >= 2)) cmd_size = 9;
+    else if ((event.pattern == WIFI_SCAN_TCPCONNECT) && (position >= 3)) {
+        // TCP Server connection detected, get the full command
+        type = 1;
+        int cmd_end = -1;
+        while (cmd_end < 0) {
+            cmd_end = uart_buf_find_from(mpy_uarts[wifi_uart_num].uart_buf, position, 9999, "\r\n", 2, NULL);
         }
+        cmd_size = (cmd_end - position) + 3;
     }
-    else cmd_size = 9;
 
     if (cmd_size) {
         inbuf = uart_buf_copy_from(mpy_uarts[wifi_uart_num].uart_buf, position-((type == 0) ? 1 : 3), (uint8_t *)data, cmd_size);
@@ -716,13 +698,12 @@ check_again:
         goto check_again;
     }
 
-    // ======================================================
-    // === Check if 'ready' pattern exists in uart buffer ===
-    position = uart_buf_find(mpy_uarts[wifi_uart_num].uart_buf, buflen, "ready\r\n", 7, NULL);
-    if (position > 0) {
+    // ==================================
+    // === Check for 'ready' pattern ===
+    if (event.pattern == WIFI_SCAN_READY) {
         // *** probably WiFi device reset ***
         if (wifi_debug) {
-            inbuf = uart_buf_copy(mpy_uarts[wifi_uart_num].uart_buf, (uint8_t *)data, buflen-8);
+            inbuf = uart_buf_copy(mpy_uarts[wifi_uart_num].uart_buf, (uint8_t *)data, ((position+7) < size) ? position+7 : size-1);
             data[inbuf] = '\0';
             LOGE(WIFI_TASK_TAG, "WiFi RESET [%s]", data);
         }
@@ -731,34 +712,35 @@ check_again:
         return;
     }
 
-    // ======================================================
-    // === Check if '+TCP,' pattern exists in uart buffer ===
-    position = uart_buf_find(mpy_uarts[wifi_uart_num].uart_buf, buflen, "+TCP,", 5, NULL);
-    if (position >= 0) {
+    // ===================================
+    // === Check for '+TCP,' pattern ===
+    if (event.pattern == WIFI_SCAN_TCP) {
         parse_IPD(data, size, position, 1);
         goto check_again;
     }
 
-    // ======================================================
-    // === Check if '+IPD,' pattern exists in uart buffer ===
-    position = uart_buf_find(mpy_uarts[wifi_uart_num].uart_buf, buflen, "+IPD,", 5, NULL);
-    if (position >= 0) {
+    // ===================================
+    // === Check for '+IPD,' pattern ===
+    if (event.pattern == WIFI_SCAN_IPD) {
         parse_IPD(data, size, position, 0);
         goto check_again;
     }
 
+    // pattern found, but not complete; check for the next one
+    if (event.pattern >= 0) goto check_again;
+
     // === Remove other strings ===
-    // 'buflen' bytes has been checked and no match found, we can safely remove those bytes from buffer
-    // but we take into account that the partial check strings can be at the end
-    //if ((buflen > 16) && ((mp_hal_ticks_ms()-last_received_time) > RECEIVE_TIMEOUT)) {
-    if (buflen > 16) {
-        // leave 16 bytes in buffer
+    // All received bytes has been scanned, we can safely remove the bytes which are not a part
+    // of the partially received pattern at the end, except the few bytes which can precede the pattern
+    size_t unmatched = at_scan_unmatched(&wifi_scanner, mpy_uarts[wifi_uart_num].uart_buf);
+    if (unmatched > WIFI_SCAN_PREFIX_LEN) {
+        unmatched -= WIFI_SCAN_PREFIX_LEN;
         if (wifi_debug) {
-            inbuf = uart_buf_copy(mpy_uarts[wifi_uart_num].uart_buf, (uint8_t *)data, buflen-16);
+            inbuf = uart_buf_copy(mpy_uarts[wifi_uart_num].uart_buf, (uint8_t *)data, (unmatched < size) ? unmatched : size-1);
             data[inbuf] = '\0';
             LOGW(WIFI_TASK_TAG, "no match, removed [%s]", data);
         }
-        uart_buf_remove(mpy_uarts[wifi_uart_num].uart_buf, buflen-16);
+        uart_buf_remove(mpy_uarts[wifi_uart_num].uart_buf, unmatched);
     }
 
     if (mpy_uarts[wifi_uart_num].task_semaphore) {
@@ -844,6 +826,7 @@ static void wifi_task(void *pv)
         LOGM(WIFI_TAG,"UART #%d: initialized, tx=%d, rx=%d, bdr=%d", wifi_uart_num, wifi_pin_tx, wifi_pin_rx, bdr);
     }
     vTaskDelay(20 / portTICK_PERIOD_MS);
+    at_scan_init(&wifi_scanner, wifi_scan_patterns, WIFI_SCAN_NPATTERNS);
     // ==================================================================================
 
     data = pvPortMalloc(WIFI_TASK_BUF_SIZE);
@@ -960,6 +943,7 @@ static void wifi_task(void *pv)
 
         vTaskDelay(100 / portTICK_PERIOD_MS);
         uart_buf_flush(mpy_uarts[wifi_uart_num].uart_buf);
+        at_scan_start(&wifi_scanner, mpy_uarts[wifi_uart_num].uart_buf, 0);
 
         wifi_status = ATDEV_STATEIDLE;
         net_active_interfaces |= ACTIVE_INTERFACE_WIFI;
@@ -1478,13 +1462,8 @@ int wifi_close(socket_obj_t *sock)
             continue;
         }
 
-        if (sock->buffer.buf) {
-            if (sock->static_buffer == mp_const_none) {
-                // Free socket buffer if allocated on FreeRTOS heap
-                vPortFree(sock->buffer.buf);
-                sock->buffer.buf = NULL;
-            }
-        }
+        // Return socket buffer chunks to the pool
+        at_sockbuf_free(&sock->buffer);
 
         if ((sock->listening) && (srv_n < AT_MAX_SERV_SOCKETS)) at_server_socket[srv_n] = NULL;
         else at_sockets[sock->fd] = NULL;
@@ -1675,16 +1654,17 @@ char *wifi_read_lineend(socket_obj_t *sock, const char *lend, int *size)
 
     char *data = NULL;
     int pos = -1;
-    int buflen = uart_buf_length(&sock->buffer, NULL);
+    int buflen = sock->buffer.length;
 
-    if (buflen > 0) pos = uart_buf_find(&sock->buffer, buflen, (const char *)lend, strlen(lend), NULL);
+    if (buflen > 0) pos = at_sockbuf_find(&sock->buffer, lend, strlen(lend));
     if (pos >= 0) {
         //if (wifi_debug) LOGQ(WIFI_TAG, "Lineend: found [%s] at pos %d", lend, pos);
         data = pvPortMalloc(pos+strlen(lend)+1);
         if (data != NULL) {
             memset(data, 0, pos+strlen(lend)+1);
-            pos = uart_buf_get(&sock->buffer, (uint8_t *)data, pos+strlen(lend));
+            pos = at_sockbuf_get(&sock->buffer, (uint8_t *)data, pos+strlen(lend));
             *size = pos;
+            _check_recv_hold(sock);
             //if (wifi_debug) LOGQ(WIFI_TAG, "Lineend: got data [%s] len=%lu (%d)", data, strlen(data), pos);
         }
         else {
@@ -1711,7 +1691,7 @@ int wifi_read(socket_obj_t *sock, const char *data, size_t data_len)
         return -1;
     }
 
-    if (((sock->buffer.size == 0) || (sock->buffer.length == 0)) && (sock->peer_closed)) {
+    if ((sock->buffer.length == 0) && (sock->peer_closed)) {
         // no data in buffer and peer closed
         xSemaphoreGive(mpy_uarts[wifi_uart_num].uart_mutex);
         //errno = ENOTCONN;
@@ -1726,7 +1706,8 @@ int wifi_read(socket_obj_t *sock, const char *data, size_t data_len)
         return -1;
     }
 
-    int rdlen = uart_buf_get(&sock->buffer, (uint8_t *)data, data_len);
+    int rdlen = at_sockbuf_get(&sock->buffer, (uint8_t *)data, data_len);
+    _check_recv_hold(sock);
 
     xSemaphoreGive(mpy_uarts[wifi_uart_num].uart_mutex);
     errno = 0;
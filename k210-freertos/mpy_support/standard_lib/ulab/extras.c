@@ -19,15 +19,11 @@
 
 #if ULAB_EXTRAS_MODULE
 
-mp_obj_t extras_spectrogram(size_t n_args, const mp_obj_t *args) {
-    if(n_args == 2) {
-        return fft_fft_ifft_spectrum(n_args, args[0], args[1], FFT_SPECTRUM);
-    } else {
-        return fft_fft_ifft_spectrum(n_args, args[0], mp_const_none, FFT_SPECTRUM);
-    }
+mp_obj_t extras_spectrogram(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    return fft_parse_args(n_args, pos_args, kw_args, FFT_SPECTRUM);
 }
 
-MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(extras_spectrogram_obj, 1, 2, extras_spectrogram);
+MP_DEFINE_CONST_FUN_OBJ_KW(extras_spectrogram_obj, 1, extras_spectrogram);
 
 STATIC const mp_rom_map_elem_t ulab_extras_globals_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR___name__), MP_OBJ_NEW_QSTR(MP_QSTR_extras) },
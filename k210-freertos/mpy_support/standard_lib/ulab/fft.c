@@ -23,13 +23,75 @@
 
 #if ULAB_FFT_MODULE
 
+#if ULAB_FFT_HARDWARE
+#include "devices.h"
+#endif
+
+// Radix-4 decimation in frequency FFT, in place
+// Each radix-4 butterfly does the work of two radix-2 stages, with three
+// complex multiplications instead of four; a radix-2 stage is added if log2(n) is odd.
+// The output of the DIF stages is in bit reversed order, which is corrected at the end.
 void fft_kernel(mp_float_t *real, mp_float_t *imag, int n, int isign) {
-    // This is basically a modification of four1 from Numerical Recipes
-    // The main difference is that this function takes two arrays, one 
-    // for the real, and one for the imaginary parts. 
-    int j, m, mmax, istep;
-    mp_float_t tempr, tempi;
-    mp_float_t wtemp, wr, wpr, wpi, wi, theta;
+    int len, q, j, m;
+    mp_float_t theta, wtemp, wpr, wpi, wr, wi, w2r, w2i, w3r, w3i;
+    mp_float_t t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i, xr, xi;
+
+    for(len = n; len >= 4; len >>= 2) {
+        q = len >> 2;
+        theta = -2.0*isign*MP_PI/len;
+        wtemp = MICROPY_FLOAT_C_FUN(sin)(0.5 * theta);
+        wpr = -2.0 * wtemp * wtemp;
+        wpi = MICROPY_FLOAT_C_FUN(sin)(theta);
+        wr = 1.0;
+        wi = 0.0;
+        for(j = 0; j < q; j++) {
+            w2r = wr*wr - wi*wi;
+            w2i = 2.0*wr*wi;
+            w3r = w2r*wr - w2i*wi;
+            w3i = w2r*wi + w2i*wr;
+            for(int i = j; i < n; i += len) {
+                mp_float_t *r = real + i;
+                mp_float_t *im = imag + i;
+                t0r = r[0] + r[2*q];
+                t0i = im[0] + im[2*q];
+                t2r = r[0] - r[2*q];
+                t2i = im[0] - im[2*q];
+                t1r = r[q] + r[3*q];
+                t1i = im[q] + im[3*q];
+                // (x1 - x3) * (-i*isign)
+                t3r = isign * (im[q] - im[3*q]);
+                t3i = -isign * (r[q] - r[3*q]);
+
+                r[0] = t0r + t1r;
+                im[0] = t0i + t1i;
+                xr = t0r - t1r;
+                xi = t0i - t1i;
+                r[q] = xr*w2r - xi*w2i;
+                im[q] = xr*w2i + xi*w2r;
+                xr = t2r + t3r;
+                xi = t2i + t3i;
+                r[2*q] = xr*wr - xi*wi;
+                im[2*q] = xr*wi + xi*wr;
+                xr = t2r - t3r;
+                xi = t2i - t3i;
+                r[3*q] = xr*w3r - xi*w3i;
+                im[3*q] = xr*w3i + xi*w3r;
+            }
+            wtemp = wr;
+            wr = wr*wpr - wi*wpi + wr;
+            wi = wi*wpr + wtemp*wpi + wi;
+        }
+    }
+    if(len == 2) {
+        for(int i = 0; i < n; i += 2) {
+            xr = real[i+1];
+            xi = imag[i+1];
+            real[i+1] = real[i] - xr;
+            imag[i+1] = imag[i] - xi;
+            real[i] += xr;
+            imag[i] += xi;
+        }
+    }
 
     j = 0;
     for(int i = 0; i < n; i++) {
@@ -44,35 +106,112 @@ void fft_kernel(mp_float_t *real, mp_float_t *imag, int n, int isign) {
         }
         j += m;
     }
+}
 
-    mmax = 1;
-    while (n > mmax) {
-        istep = mmax << 1;
-        theta = -2.0*isign*MP_PI/istep;
-        wtemp = MICROPY_FLOAT_C_FUN(sin)(0.5 * theta);
-        wpr = -2.0 * wtemp * wtemp;
-        wpi = MICROPY_FLOAT_C_FUN(sin)(theta);
-        wr = 1.0;
-        wi = 0.0;
-        for(m = 0; m < mmax; m++) {
-            for(int i = m; i < n; i += istep) {
-                j = i + mmax;
-                tempr = wr * real[j] - wi * imag[j];
-                tempi = wr * imag[j] + wi * real[j];
-                real[j] = real[i] - tempr;
-                imag[j] = imag[i] - tempi;
-                real[i] += tempr;
-                imag[i] += tempi;
-            }
-            wtemp = wr;
-            wr = wr*wpr - wi*wpi + wr;
-            wi = wi*wpr + wtemp*wpi + wi;
-        }
-        mmax = istep;
+// Forward FFT of real data (imag is ignored)
+// The n real points are transformed as n/2 complex points (even samples in the real,
+// odd samples in the imaginary part), the spectrum is then split into the spectra of
+// the even and the odd samples and combined. The upper half is the complex conjugate.
+void fft_kernel_real(mp_float_t *real, mp_float_t *imag, int n) {
+    int h = n >> 1;
+    mp_float_t theta, wtemp, wpr, wpi, wr, wi;
+
+    for(int k = 0; k < h; k++) {
+        imag[k] = real[2*k+1];
+        real[k] = real[2*k];
     }
+    fft_kernel(real, imag, h, 1);
+
+    // k = 0, the DC and the Nyquist components are real
+    mp_float_t zr = real[0], zi = imag[0];
+    real[0] = zr + zi;
+    imag[0] = 0.0;
+    real[h] = zr - zi;
+    imag[h] = 0.0;
+
+    theta = -2.0*MP_PI/n;
+    wtemp = MICROPY_FLOAT_C_FUN(sin)(0.5 * theta);
+    wpr = -2.0 * wtemp * wtemp;
+    wpi = MICROPY_FLOAT_C_FUN(sin)(theta);
+    wr = 1.0 + wpr;
+    wi = wpi;
+    for(int k = 1; k <= (h >> 1); k++) {
+        int m = h - k;
+        // even and odd samples spectra: fe = (Z[k] + conj(Z[m]))/2, fo = (Z[k] - conj(Z[m]))/(2i)
+        mp_float_t fer = 0.5 * (real[k] + real[m]);
+        mp_float_t fei = 0.5 * (imag[k] - imag[m]);
+        mp_float_t for_ = 0.5 * (imag[k] + imag[m]);
+        mp_float_t foi = -0.5 * (real[k] - real[m]);
+        // X[k] = fe + W^k * fo, X[m] = conj(fe) - conj(W^k * fo), with W^m = -conj(W^k)
+        mp_float_t tr = wr*for_ - wi*foi;
+        mp_float_t ti = wr*foi + wi*for_;
+        real[k] = fer + tr;
+        imag[k] = fei + ti;
+        real[m] = fer - tr;
+        imag[m] = -fei + ti;
+        // the upper half of the spectrum
+        real[n-k] = real[k];
+        imag[n-k] = -imag[k];
+        real[n-m] = real[m];
+        imag[n-m] = -imag[m];
+
+        wtemp = wr;
+        wr = wr*wpr - wi*wpi + wr;
+        wi = wi*wpr + wtemp*wpi + wi;
+    }
+}
+
+#if ULAB_FFT_HARDWARE
+// The hardware accelerator transforms 64 to 512 complex int16 points; two points are packed
+// in each 64-bit word (fft_data_t: I1, R1, I2, R2).
+// The input is scaled so that the largest magnitude fills the int16 range and every
+// butterfly stage output is halved (all shift bits set), so the stages can not overflow.
+// The result is returned unnormalized, the same as from fft_kernel.
+// hosttest/mpyhost/fftmodel.c models the accelerator arithmetic for the host tests.
+#define FFT_HW_SHIFT_ALL    0x1ff
+
+static int16_t fft_hw_to_int16(mp_float_t value) {
+    return (int16_t)MICROPY_FLOAT_C_FUN(floor)(value + 0.5);
+}
+
+void fft_kernel_hardware(mp_float_t *real, mp_float_t *imag, int n, int isign) {
+    mp_float_t max = 0.0;
+    for(int i = 0; i < n; i++) {
+        mp_float_t mag = real[i]*real[i] + imag[i]*imag[i];
+        if(mag > max) max = mag;
+    }
+    if(max == 0.0) {
+        return; // the transform of zeros
+    }
+    mp_float_t scale = 32767.0 / MICROPY_FLOAT_C_FUN(sqrt)(max);
+
+    uint64_t *buffer = m_new(uint64_t, n);
+    fft_data_t *input = (fft_data_t *)buffer;
+    fft_data_t *output = (fft_data_t *)(buffer + n/2);
+    for(int i = 0; i < n/2; i++) {
+        input[i].R1 = fft_hw_to_int16(real[2*i] * scale);
+        input[i].I1 = fft_hw_to_int16(imag[2*i] * scale);
+        input[i].R2 = fft_hw_to_int16(real[2*i+1] * scale);
+        input[i].I2 = fft_hw_to_int16(imag[2*i+1] * scale);
+    }
+
+    MP_THREAD_GIL_EXIT();
+    fft_complex_uint16(FFT_HW_SHIFT_ALL, (isign > 0) ? FFT_DIR_FORWARD : FFT_DIR_BACKWARD, buffer, n, buffer + n/2);
+    MP_THREAD_GIL_ENTER();
+
+    // every stage was scaled by 1/2
+    scale = n / scale;
+    for(int i = 0; i < n/2; i++) {
+        real[2*i] = output[i].R1 * scale;
+        imag[2*i] = output[i].I1 * scale;
+        real[2*i+1] = output[i].R2 * scale;
+        imag[2*i+1] = output[i].I2 * scale;
+    }
+    m_del(uint64_t, buffer, n);
 }
+#endif
 
-mp_obj_t fft_fft_ifft_spectrum(size_t n_args, mp_obj_t arg_re, mp_obj_t arg_im, uint8_t type) {
+mp_obj_t fft_fft_ifft_spectrum(size_t n_args, mp_obj_t arg_re, mp_obj_t arg_im, uint8_t type, uint8_t backend) {
     if(!MP_OBJ_IS_TYPE(arg_re, &ulab_ndarray_type)) {
         mp_raise_NotImplementedError(translate("FFT is defined for ndarrays only"));
     } 
@@ -87,6 +226,13 @@ mp_obj_t fft_fft_ifft_spectrum(size_t n_args, mp_obj_t arg_re, mp_obj_t arg_im,
     if((len & (len-1)) != 0) {
         mp_raise_ValueError(translate("input array length must be power of 2"));
     }
+    if(backend == FFT_BACKEND_AUTO) {
+        backend = FFT_HW_SUPPORTED(len) ? FFT_BACKEND_HARDWARE : FFT_BACKEND_SOFTWARE;
+    } else if((backend == FFT_BACKEND_HARDWARE) && !FFT_HW_SUPPORTED(len)) {
+        mp_raise_ValueError(translate("hardware FFT length must be 64, 128, 256 or 512"));
+    } else if(backend > FFT_BACKEND_SOFTWARE) {
+        mp_raise_ValueError(translate("wrong FFT backend"));
+    }
     
     ndarray_obj_t *out_re = create_new_ndarray(1, len, NDARRAY_FLOAT);
     mp_float_t *data_re = (mp_float_t *)out_re->array->items;
@@ -119,17 +265,26 @@ mp_obj_t fft_fft_ifft_spectrum(size_t n_args, mp_obj_t arg_re, mp_obj_t arg_im,
         }
     }
 
-    if((type == FFT_FFT) || (type == FFT_SPECTRUM)) {
-        fft_kernel(data_re, data_im, len, 1);
-        if(type == FFT_SPECTRUM) {
-            for(size_t i=0; i < len; i++) {
-                *data_re = MICROPY_FLOAT_C_FUN(sqrt)(*data_re * *data_re + *data_im * *data_im);
-                data_re++;
-                data_im++;
-            }
+    int isign = (type == FFT_IFFT) ? -1 : 1;
+    #if ULAB_FFT_HARDWARE
+    if(backend == FFT_BACKEND_HARDWARE) {
+        fft_kernel_hardware(data_re, data_im, len, isign);
+    } else
+    #endif
+    if((n_args == 1) && (isign == 1) && (len >= 4)) {
+        // real input, only half length transform is needed
+        fft_kernel_real(data_re, data_im, len);
+    } else {
+        fft_kernel(data_re, data_im, len, isign);
+    }
+
+    if(type == FFT_SPECTRUM) {
+        for(size_t i=0; i < len; i++) {
+            *data_re = MICROPY_FLOAT_C_FUN(sqrt)(*data_re * *data_re + *data_im * *data_im);
+            data_re++;
+            data_im++;
         }
-    } else { // inverse transform
-        fft_kernel(data_re, data_im, len, -1);
+    } else if(type == FFT_IFFT) {
         // TODO: numpy accepts the norm keyword argument
         for(size_t i=0; i < len; i++) {
             *data_re++ /= len;
@@ -146,30 +301,42 @@ mp_obj_t fft_fft_ifft_spectrum(size_t n_args, mp_obj_t arg_re, mp_obj_t arg_im,
     }
 }
 
-mp_obj_t fft_fft(size_t n_args, const mp_obj_t *args) {
-    if(n_args == 2) {
-        return fft_fft_ifft_spectrum(n_args, args[0], args[1], FFT_FFT);
+mp_obj_t fft_parse_args(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args, uint8_t type) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_backend, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = FFT_BACKEND_AUTO} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if(args[1].u_obj == mp_const_none) {
+        return fft_fft_ifft_spectrum(1, args[0].u_obj, mp_const_none, type, args[2].u_int);
     } else {
-        return fft_fft_ifft_spectrum(n_args, args[0], mp_const_none, FFT_FFT);        
+        return fft_fft_ifft_spectrum(2, args[0].u_obj, args[1].u_obj, type, args[2].u_int);
     }
 }
 
-MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(fft_fft_obj, 1, 2, fft_fft);
+mp_obj_t fft_fft(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    return fft_parse_args(n_args, pos_args, kw_args, FFT_FFT);
+}
 
-mp_obj_t fft_ifft(size_t n_args, const mp_obj_t *args) {
-    if(n_args == 2) {
-        return fft_fft_ifft_spectrum(n_args, args[0], args[1], FFT_IFFT);
-    } else {
-        return fft_fft_ifft_spectrum(n_args, args[0], mp_const_none, FFT_IFFT);
-    }
+MP_DEFINE_CONST_FUN_OBJ_KW(fft_fft_obj, 1, fft_fft);
+
+mp_obj_t fft_ifft(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    return fft_parse_args(n_args, pos_args, kw_args, FFT_IFFT);
 }
 
-MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(fft_ifft_obj, 1, 2, fft_ifft);
+MP_DEFINE_CONST_FUN_OBJ_KW(fft_ifft_obj, 1, fft_ifft);
 
 STATIC const mp_rom_map_elem_t ulab_fft_globals_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR___name__), MP_OBJ_NEW_QSTR(MP_QSTR_fft) },
     { MP_OBJ_NEW_QSTR(MP_QSTR_fft), (mp_obj_t)&fft_fft_obj },
     { MP_OBJ_NEW_QSTR(MP_QSTR_ifft), (mp_obj_t)&fft_ifft_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_AUTO), MP_ROM_INT(FFT_BACKEND_AUTO) },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_HARDWARE), MP_ROM_INT(FFT_BACKEND_HARDWARE) },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_SOFTWARE), MP_ROM_INT(FFT_BACKEND_SOFTWARE) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_ulab_fft_globals, ulab_fft_globals_table);
@@ -25,15 +25,29 @@ enum FFT_TYPE {
     FFT_SPECTRUM,
 };
 
+enum FFT_BACKEND {
+    FFT_BACKEND_AUTO,
+    FFT_BACKEND_HARDWARE,
+    FFT_BACKEND_SOFTWARE,
+};
+
+// lengths (powers of 2) supported by the hardware FFT accelerator
+#if ULAB_FFT_HARDWARE
+#define FFT_HW_SUPPORTED(n) (((n) >= 64) && ((n) <= 512))
+#else
+#define FFT_HW_SUPPORTED(n) (0)
+#endif
+
 #if ULAB_FFT_MODULE
 
 extern mp_obj_module_t ulab_fft_module;
 
-MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(fft_fft_obj);
-MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(fft_ifft_obj);
-MP_DECLARE_CONST_FUN_OBJ_VAR_BETWEEN(fft_spectrum_obj);
+MP_DECLARE_CONST_FUN_OBJ_KW(fft_fft_obj);
+MP_DECLARE_CONST_FUN_OBJ_KW(fft_ifft_obj);
 
-mp_obj_t fft_fft_ifft_spectrum(size_t , mp_obj_t , mp_obj_t , uint8_t );
+void fft_kernel(mp_float_t *, mp_float_t *, int , int );
+mp_obj_t fft_fft_ifft_spectrum(size_t , mp_obj_t , mp_obj_t , uint8_t , uint8_t );
+mp_obj_t fft_parse_args(size_t , const mp_obj_t *, mp_map_t *, uint8_t );
 
 #endif
 #endif
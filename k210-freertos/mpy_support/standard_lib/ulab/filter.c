@@ -16,6 +16,7 @@
 #include "py/runtime.h"
 #include "py/misc.h"
 #include "filter.h"
+#include "fft.h"
 
 #if ULAB_FILTER_MODULE
 mp_obj_t filter_convolve(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
@@ -84,9 +85,436 @@ mp_obj_t filter_convolve(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_a
 
 MP_DEFINE_CONST_FUN_OBJ_KW(filter_convolve_obj, 2, filter_convolve);
 
+// checks that obj is a one-dimensional ndarray (a row or a column)
+static ndarray_obj_t *filter_get_vector(mp_obj_t obj) {
+    if(!MP_OBJ_IS_TYPE(obj, &ulab_ndarray_type)) {
+        mp_raise_TypeError(translate("filter arguments must be ndarrays"));
+    }
+    ndarray_obj_t *ndarray = MP_OBJ_TO_PTR(obj);
+    if((ndarray->m != 1) && (ndarray->n != 1)) {
+        mp_raise_TypeError(translate("filter arguments must be linear arrays"));
+    }
+    return ndarray;
+}
+
+// returns the out array of the shape of x, or a new array, if out_obj is None
+static ndarray_obj_t *filter_get_output(mp_obj_t out_obj, ndarray_obj_t *x, uint8_t typecode) {
+    if(out_obj == mp_const_none) {
+        return create_new_ndarray(x->m, x->n, typecode);
+    }
+    if(!MP_OBJ_IS_TYPE(out_obj, &ulab_ndarray_type)) {
+        mp_raise_TypeError(translate("out must be an ndarray"));
+    }
+    ndarray_obj_t *out = MP_OBJ_TO_PTR(out_obj);
+    if((out->array->typecode != typecode) || (out->array->len != x->array->len)) {
+        mp_raise_ValueError(translate("out must be an array of the type and length of the result"));
+    }
+    return out;
+}
+
+// returns the filter state zi, or a new zero state, if zi_obj is None
+// zi is updated in place by the filter functions
+static ndarray_obj_t *filter_get_state(mp_obj_t zi_obj, size_t len, uint8_t typecode) {
+    if(zi_obj == mp_const_none) {
+        return create_new_ndarray(1, len, typecode);
+    }
+    if(!MP_OBJ_IS_TYPE(zi_obj, &ulab_ndarray_type)) {
+        mp_raise_TypeError(translate("zi must be an ndarray"));
+    }
+    ndarray_obj_t *zi = MP_OBJ_TO_PTR(zi_obj);
+    if((zi->array->typecode != typecode) || (zi->array->len != len)) {
+        mp_raise_ValueError(translate("zi has the wrong type or length"));
+    }
+    return zi;
+}
+
+// the filtered data, and the state, if an initial state was supplied
+static mp_obj_t filter_result(ndarray_obj_t *out, mp_obj_t zi_obj) {
+    if(zi_obj == mp_const_none) {
+        return MP_OBJ_FROM_PTR(out);
+    }
+    mp_obj_t tuple[2] = { MP_OBJ_FROM_PTR(out), zi_obj };
+    return mp_obj_new_tuple(2, tuple);
+}
+
+// copies x to the float array data, converting the values, if necessary
+static void filter_copy_float(ndarray_obj_t *x, mp_float_t *data) {
+    if(x->array->typecode == NDARRAY_FLOAT) {
+        if(data != x->array->items) {
+            memcpy(data, x->array->items, x->array->len * sizeof(mp_float_t));
+        }
+    } else {
+        for(size_t i=0; i < x->array->len; i++) {
+            data[i] = ndarray_get_float_value(x->array->items, x->array->typecode, i);
+        }
+    }
+}
+
+// number of fractional bits of the fixed point coefficients
+static uint8_t filter_q15_qbits(mp_int_t shift) {
+    if((shift < 0) || (shift > 15)) {
+        mp_raise_ValueError(translate("shift must be between 0 and 15"));
+    }
+    return 15 - shift;
+}
+
+static inline int16_t filter_q15_saturate(int64_t acc, uint8_t qbits) {
+    if(qbits) {
+        acc = (acc + ((int64_t)1 << (qbits - 1))) >> qbits;
+    }
+    return (acc > INT16_MAX) ? INT16_MAX : ((acc < INT16_MIN) ? INT16_MIN : (int16_t)acc);
+}
+
+// Cascade of second order sections in transposed direct form II
+// The data are filtered in place, section by section; sos holds the six normalised
+// coefficients b0, b1, b2, 1, a1, a2 of each section, z two state values per section.
+static void filter_sos_float(const mp_float_t *sos, size_t sections, mp_float_t *z, mp_float_t *data, size_t len) {
+    for(size_t s=0; s < sections; s++, sos += 6, z += 2) {
+        mp_float_t b0 = sos[0], b1 = sos[1], b2 = sos[2], a1 = sos[4], a2 = sos[5];
+        mp_float_t z0 = z[0], z1 = z[1];
+        for(size_t i=0; i < len; i++) {
+            mp_float_t x = data[i];
+            mp_float_t y = b0 * x + z0;
+            z0 = b1 * x - a1 * y + z1;
+            z1 = b2 * x - a2 * y;
+            data[i] = y;
+        }
+        z[0] = z0;
+        z[1] = z1;
+    }
+}
+
+// Cascade of second order sections in direct form I with Q15 samples
+// The coefficients have qbits fractional bits, a0 is not used. z holds x[n-1], x[n-2],
+// y[n-1] and y[n-2] of each section; the sum is kept in 64 bits and saturated once per section.
+static void filter_sos_q15(const int16_t *sos, size_t sections, int16_t *z, int16_t *data, size_t len, uint8_t qbits) {
+    for(size_t s=0; s < sections; s++, sos += 6, z += 4) {
+        int64_t b0 = sos[0], b1 = sos[1], b2 = sos[2], a1 = sos[4], a2 = sos[5];
+        int32_t x1 = z[0], x2 = z[1], y1 = z[2], y2 = z[3];
+        for(size_t i=0; i < len; i++) {
+            int32_t x = data[i];
+            int64_t acc = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+            int16_t y = filter_q15_saturate(acc, qbits);
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+            data[i] = y;
+        }
+        z[0] = x1;
+        z[1] = x2;
+        z[2] = y1;
+        z[3] = y2;
+    }
+}
+
+// Linear filter in transposed direct form II, the data are filtered in place
+// b and a hold order+1 normalised coefficients, z the order state values.
+static void filter_lfilter_float(const mp_float_t *b, const mp_float_t *a, size_t order, mp_float_t *z, mp_float_t *data, size_t len) {
+    if(order == 0) {
+        for(size_t i=0; i < len; i++) {
+            data[i] *= b[0];
+        }
+        return;
+    }
+    for(size_t i=0; i < len; i++) {
+        mp_float_t x = data[i];
+        mp_float_t y = b[0] * x + z[0];
+        for(size_t k=1; k < order; k++) {
+            z[k-1] = b[k] * x - a[k] * y + z[k];
+        }
+        z[order-1] = b[order] * x - a[order] * y;
+        data[i] = y;
+    }
+}
+
+// Linear filter in direct form I with Q15 samples and coefficients with qbits fractional bits
+// The data are filtered in place. zx holds the nb-1 previous inputs and zy the na-1 previous
+// outputs, the oldest first; the delay lines are shifted while the products are summed,
+// so the caller's state is used directly. a[0] is not used.
+static void filter_lfilter_q15(const int16_t *b, size_t nb, const int16_t *a, size_t na, int16_t *zx, int16_t *zy, int16_t *data, size_t len, uint8_t qbits) {
+    for(size_t i=0; i < len; i++) {
+        int16_t x = data[i];
+        int64_t acc = (int32_t)b[0] * x;
+        if(nb > 1) {
+            for(size_t k=0; k < nb-2; k++) {
+                acc += (int32_t)b[nb-1-k] * zx[k];
+                zx[k] = zx[k+1];
+            }
+            acc += (int32_t)b[1] * zx[nb-2];
+            zx[nb-2] = x;
+        }
+        if(na > 1) {
+            for(size_t k=0; k < na-2; k++) {
+                acc -= (int32_t)a[na-1-k] * zy[k];
+                zy[k] = zy[k+1];
+            }
+            acc -= (int32_t)a[1] * zy[na-2];
+        }
+        int16_t y = filter_q15_saturate(acc, qbits);
+        if(na > 1) {
+            zy[na-2] = y;
+        }
+        data[i] = y;
+    }
+}
+
+#if ULAB_FFT_MODULE
+// adds the pending tail z of the earlier blocks to the convolution conv of a block of n inputs,
+// writes the n outputs to y, and keeps the remaining tail samples of the sum in z
+static void filter_fir_overlap(const mp_float_t *conv, size_t n, mp_float_t *z, size_t tail, mp_float_t *y) {
+    for(size_t k=0; k < n; k++) {
+        y[k] = conv[k] + ((k < tail) ? z[k] : 0.0);
+    }
+    for(size_t k=0; k < tail; k++) {
+        z[k] = conv[n+k] + ((n+k < tail) ? z[n+k] : 0.0);
+    }
+}
+
+// length of the transform used for an FIR filter with ntaps coefficients
+static size_t filter_fir_fft_size(size_t ntaps) {
+    size_t nfft = 1;
+    while(nfft < FILTER_FFT_SIZE_RATIO * ntaps) {
+        nfft <<= 1;
+    }
+    return nfft;
+}
+
+// spectrum of the FIR filter b, zero padded to nfft
+// The 1/nfft normalisation of the inverse transform is applied to the filter.
+static void filter_fir_transform(const mp_float_t *b, size_t ntaps, mp_float_t *h_re, mp_float_t *h_im, size_t nfft) {
+    memset(h_re, 0, nfft * sizeof(mp_float_t));
+    memset(h_im, 0, nfft * sizeof(mp_float_t));
+    memcpy(h_re, b, ntaps * sizeof(mp_float_t));
+    fft_kernel(h_re, h_im, nfft, 1);
+    for(size_t k=0; k < nfft; k++) {
+        h_re[k] /= nfft;
+        h_im[k] /= nfft;
+    }
+}
+
+// FIR filter with FFT overlap-add, the data are filtered in place
+// Blocks of nfft-ntaps+1 inputs are convolved with the filter spectrum h in the frequency
+// domain, two real blocks at a time as the real and the imaginary part of one complex transform.
+// z holds the ntaps-1 samples of the convolution tail that are still to be added to the
+// following outputs, which is the same state filter_lfilter_float() keeps for an FIR filter.
+static void filter_fir_fft(const mp_float_t *h_re, const mp_float_t *h_im, size_t nfft, size_t ntaps, mp_float_t *z, mp_float_t *data, size_t len) {
+    size_t block = nfft - ntaps + 1, tail = ntaps - 1;
+    mp_float_t *w_re = m_new(mp_float_t, 2 * nfft);
+    mp_float_t *w_im = w_re + nfft;
+
+    for(size_t pos=0; pos < len; pos += 2 * block) {
+        size_t n0 = MIN(block, len - pos);
+        size_t n1 = MIN(block, len - pos - n0);
+        memset(w_re, 0, 2 * nfft * sizeof(mp_float_t));
+        memcpy(w_re, data + pos, n0 * sizeof(mp_float_t));
+        memcpy(w_im, data + pos + n0, n1 * sizeof(mp_float_t));
+        fft_kernel(w_re, w_im, nfft, 1);
+        for(size_t k=0; k < nfft; k++) {
+            mp_float_t re = w_re[k] * h_re[k] - w_im[k] * h_im[k];
+            w_im[k] = w_re[k] * h_im[k] + w_im[k] * h_re[k];
+            w_re[k] = re;
+        }
+        fft_kernel(w_re, w_im, nfft, -1);
+        filter_fir_overlap(w_re, n0, z, tail, data + pos);
+        if(n1) {
+            filter_fir_overlap(w_im, n1, z, tail, data + pos + n0);
+        }
+    }
+    m_del(mp_float_t, w_re, 2 * nfft);
+}
+
+// returns the precomputed spectrum of an FIR filter with ntaps coefficients,
+// a float array of shape (2, nfft) with the real and the imaginary part
+static ndarray_obj_t *filter_get_spectrum(mp_obj_t obj, size_t ntaps) {
+    if(!MP_OBJ_IS_TYPE(obj, &ulab_ndarray_type)) {
+        mp_raise_TypeError(translate("spectrum must be an ndarray"));
+    }
+    ndarray_obj_t *h = MP_OBJ_TO_PTR(obj);
+    if((h->array->typecode != NDARRAY_FLOAT) || (h->m != 2) || (h->n != filter_fir_fft_size(ntaps))) {
+        mp_raise_ValueError(translate("spectrum does not match the filter length"));
+    }
+    return h;
+}
+
+// spectrum of the FIR filter b for lfilter(b, [1], x, spectrum=...), so that a filter
+// run on a stream of chunks is transformed only once
+mp_obj_t filter_fir_spectrum(mp_obj_t b_obj) {
+    ndarray_obj_t *b = filter_get_vector(b_obj);
+    size_t ntaps = b->array->len;
+    if(ntaps < FILTER_FFT_MIN_TAPS) {
+        mp_raise_ValueError(translate("FIR filter is too short for the FFT"));
+    }
+    size_t nfft = filter_fir_fft_size(ntaps);
+    ndarray_obj_t *h = create_new_ndarray(2, nfft, NDARRAY_FLOAT);
+    mp_float_t *h_re = (mp_float_t *)h->array->items;
+    mp_float_t *taps = m_new(mp_float_t, ntaps);
+    filter_copy_float(b, taps);
+    filter_fir_transform(taps, ntaps, h_re, h_re + nfft, nfft);
+    m_del(mp_float_t, taps, ntaps);
+    return MP_OBJ_FROM_PTR(h);
+}
+
+MP_DEFINE_CONST_FUN_OBJ_1(filter_fir_spectrum_obj, filter_fir_spectrum);
+
+#endif
+
+mp_obj_t filter_sosfilt(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_sos, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+        { MP_QSTR_x, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+        { MP_QSTR_zi, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+        { MP_QSTR_out, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+        { MP_QSTR_shift, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 1 } },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if(!MP_OBJ_IS_TYPE(args[0].u_obj, &ulab_ndarray_type)) {
+        mp_raise_TypeError(translate("sos must be an ndarray"));
+    }
+    ndarray_obj_t *sos = MP_OBJ_TO_PTR(args[0].u_obj);
+    if((sos->n != 6) || (sos->m == 0)) {
+        mp_raise_ValueError(translate("sos must be of shape (n_sections, 6)"));
+    }
+    ndarray_obj_t *x = filter_get_vector(args[1].u_obj);
+    size_t sections = sos->m, len = x->array->len;
+
+    if(sos->array->typecode == NDARRAY_INT16) {
+        // fixed point filter
+        if(x->array->typecode != NDARRAY_INT16) {
+            mp_raise_TypeError(translate("Q15 filter input must be an int16 array"));
+        }
+        uint8_t qbits = filter_q15_qbits(args[4].u_int);
+        ndarray_obj_t *zi = filter_get_state(args[2].u_obj, 4 * sections, NDARRAY_INT16);
+        ndarray_obj_t *out = filter_get_output(args[3].u_obj, x, NDARRAY_INT16);
+        if(out->array->items != x->array->items) {
+            memcpy(out->array->items, x->array->items, len * sizeof(int16_t));
+        }
+        filter_sos_q15((int16_t *)sos->array->items, sections, (int16_t *)zi->array->items, (int16_t *)out->array->items, len, qbits);
+        return filter_result(out, args[2].u_obj);
+    }
+
+    ndarray_obj_t *zi = filter_get_state(args[2].u_obj, 2 * sections, NDARRAY_FLOAT);
+    // the coefficients are normalised with a0
+    mp_float_t *coeffs = m_new(mp_float_t, 6 * sections);
+    for(size_t s=0; s < sections; s++) {
+        mp_float_t a0 = ndarray_get_float_value(sos->array->items, sos->array->typecode, 6*s+3);
+        if(a0 == 0.0) {
+            m_del(mp_float_t, coeffs, 6 * sections);
+            mp_raise_ValueError(translate("a0 of a section must not be 0"));
+        }
+        for(size_t i=0; i < 6; i++) {
+            coeffs[6*s+i] = ndarray_get_float_value(sos->array->items, sos->array->typecode, 6*s+i) / a0;
+        }
+    }
+    ndarray_obj_t *out = filter_get_output(args[3].u_obj, x, NDARRAY_FLOAT);
+    filter_copy_float(x, (mp_float_t *)out->array->items);
+    filter_sos_float(coeffs, sections, (mp_float_t *)zi->array->items, (mp_float_t *)out->array->items, len);
+    m_del(mp_float_t, coeffs, 6 * sections);
+    return filter_result(out, args[2].u_obj);
+}
+
+MP_DEFINE_CONST_FUN_OBJ_KW(filter_sosfilt_obj, 2, filter_sosfilt);
+
+mp_obj_t filter_lfilter(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_b, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+        { MP_QSTR_a, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+        { MP_QSTR_x, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+        { MP_QSTR_zi, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+        { MP_QSTR_out, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+        { MP_QSTR_shift, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 1 } },
+        { MP_QSTR_spectrum, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    ndarray_obj_t *b = filter_get_vector(args[0].u_obj);
+    ndarray_obj_t *a = filter_get_vector(args[1].u_obj);
+    ndarray_obj_t *x = filter_get_vector(args[2].u_obj);
+    size_t nb = b->array->len, na = a->array->len, len = x->array->len;
+    if((nb == 0) || (na == 0)) {
+        mp_raise_ValueError(translate("filter coefficients must not be empty"));
+    }
+
+    if((b->array->typecode == NDARRAY_INT16) || (a->array->typecode == NDARRAY_INT16)) {
+        // fixed point filter, the state holds the nb-1 previous inputs and the na-1 previous outputs
+        if((b->array->typecode != NDARRAY_INT16) || (a->array->typecode != NDARRAY_INT16) || (x->array->typecode != NDARRAY_INT16)) {
+            mp_raise_TypeError(translate("Q15 filter coefficients and input must be int16 arrays"));
+        }
+        uint8_t qbits = filter_q15_qbits(args[5].u_int);
+        ndarray_obj_t *zi = filter_get_state(args[3].u_obj, nb + na - 2, NDARRAY_INT16);
+        ndarray_obj_t *out = filter_get_output(args[4].u_obj, x, NDARRAY_INT16);
+        int16_t *state = (int16_t *)zi->array->items;
+        if(out->array->items != x->array->items) {
+            memcpy(out->array->items, x->array->items, len * sizeof(int16_t));
+        }
+        filter_lfilter_q15((int16_t *)b->array->items, nb, (int16_t *)a->array->items, na, state, state + nb - 1, (int16_t *)out->array->items, len, qbits);
+        return filter_result(out, args[3].u_obj);
+    }
+
+    // the coefficients are normalised with a[0], and padded with zeros to the same length
+    size_t order = MAX(nb, na) - 1;
+    mp_float_t a0 = ndarray_get_float_value(a->array->items, a->array->typecode, 0);
+    if(a0 == 0.0) {
+        mp_raise_ValueError(translate("a[0] must not be 0"));
+    }
+    ndarray_obj_t *zi = filter_get_state(args[3].u_obj, order, NDARRAY_FLOAT);
+    ndarray_obj_t *h = NULL;
+    if(args[6].u_obj != mp_const_none) {
+        #if ULAB_FFT_MODULE
+        // the spectrum is not normalised, so a must be [1]
+        if((na != 1) || (a0 != 1.0) || (nb < FILTER_FFT_MIN_TAPS)) {
+            mp_raise_ValueError(translate("spectrum can only be used with a long FIR filter and a = [1]"));
+        }
+        h = filter_get_spectrum(args[6].u_obj, nb);
+        #else
+        mp_raise_ValueError(translate("spectrum requires the fft module"));
+        #endif
+    }
+    mp_float_t *coeffs = m_new(mp_float_t, 2 * (order + 1));
+    mp_float_t *bn = coeffs, *an = coeffs + order + 1;
+    for(size_t k=0; k <= order; k++) {
+        bn[k] = (k < nb) ? ndarray_get_float_value(b->array->items, b->array->typecode, k) / a0 : 0.0;
+        an[k] = (k < na) ? ndarray_get_float_value(a->array->items, a->array->typecode, k) / a0 : 0.0;
+    }
+    ndarray_obj_t *out = filter_get_output(args[4].u_obj, x, NDARRAY_FLOAT);
+    mp_float_t *data = (mp_float_t *)out->array->items;
+    filter_copy_float(x, data);
+    #if ULAB_FFT_MODULE
+    if((na == 1) && (nb >= FILTER_FFT_MIN_TAPS) && (len >= nb)) {
+        // the filter spectrum is computed once per call, or taken from fir_spectrum()
+        size_t nfft = filter_fir_fft_size(nb);
+        mp_float_t *h_re = (h) ? (mp_float_t *)h->array->items : m_new(mp_float_t, 2 * nfft);
+        if(h == NULL) {
+            filter_fir_transform(bn, nb, h_re, h_re + nfft, nfft);
+        }
+        filter_fir_fft(h_re, h_re + nfft, nfft, nb, (mp_float_t *)zi->array->items, data, len);
+        if(h == NULL) {
+            m_del(mp_float_t, h_re, 2 * nfft);
+        }
+    } else
+    #endif
+    {
+        filter_lfilter_float(bn, an, order, (mp_float_t *)zi->array->items, data, len);
+    }
+    m_del(mp_float_t, coeffs, 2 * (order + 1));
+    return filter_result(out, args[3].u_obj);
+}
+
+MP_DEFINE_CONST_FUN_OBJ_KW(filter_lfilter_obj, 3, filter_lfilter);
+
 STATIC const mp_rom_map_elem_t ulab_filter_globals_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR___name__), MP_OBJ_NEW_QSTR(MP_QSTR_filter) },
     { MP_OBJ_NEW_QSTR(MP_QSTR_convolve), (mp_obj_t)&filter_convolve_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_sosfilt), (mp_obj_t)&filter_sosfilt_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_lfilter), (mp_obj_t)&filter_lfilter_obj },
+    #if ULAB_FFT_MODULE
+    { MP_OBJ_NEW_QSTR(MP_QSTR_fir_spectrum), (mp_obj_t)&filter_fir_spectrum_obj },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_ulab_filter_globals, ulab_filter_globals_table);
@@ -15,11 +15,19 @@
 #include "ulab.h"
 #include "ndarray.h"
 
+// FIR filters with at least this many taps are run with FFT overlap-add in lfilter()
+#define FILTER_FFT_MIN_TAPS (64)
+// the FFT length is the first power of 2 that is at least this many times the number of taps
+#define FILTER_FFT_SIZE_RATIO (4)
+
 #if ULAB_FILTER_MODULE
 
 extern mp_obj_module_t ulab_filter_module;
 
 MP_DECLARE_CONST_FUN_OBJ_KW(filter_convolve_obj);
+MP_DECLARE_CONST_FUN_OBJ_KW(filter_sosfilt_obj);
+MP_DECLARE_CONST_FUN_OBJ_KW(filter_lfilter_obj);
+MP_DECLARE_CONST_FUN_OBJ_1(filter_fir_spectrum_obj);
 
 #endif
 #endif
@@ -15,6 +15,7 @@
 #include "py/obj.h"
 #include "py/runtime.h"
 #include "py/misc.h"
+#include "py/binary.h"
 #include "linalg.h"
 
 #if ULAB_LINALG_MODULE
@@ -136,36 +137,195 @@ mp_obj_t linalg_inv(mp_obj_t o_in) {
 
 MP_DEFINE_CONST_FUN_OBJ_1(linalg_inv_obj, linalg_inv);
 
-mp_obj_t linalg_dot(mp_obj_t _m1, mp_obj_t _m2) {
+// Matrix multiplication kernels for linalg.dot
+//
+// The right hand operand is transposed into a packed buffer (keeping its own type),
+// so that both operands are read with unit stride. The result is computed in
+// 2x2 register blocks, and the columns are processed in panels, whose packed
+// data fit in the data cache, while the rows of the left hand operand are swept.
+// A kernel is generated for each type pair, so that there is no type dispatch
+// in the inner loop.
+
+#define LINALG_DOT_BLOCK_BYTES    16384
+#define LINALG_DOT_STACK_BYTES    512
+
+typedef void (*linalg_dot_kernel_t)(void *, void *, mp_float_t *, size_t , size_t , size_t , size_t );
+
+#define LINALG_DOT_KERNEL(name, type1, type2)\
+static void (name)(void *_a, void *_bt, mp_float_t *c, size_t M, size_t K, size_t N, size_t nb) {\
+    type1 *a = (type1 *)_a;\
+    type2 *bt = (type2 *)_bt;\
+    for(size_t jb=0; jb < N; jb += nb) {\
+        size_t je = (jb + nb < N) ? jb + nb : N;\
+        size_t i = 0;\
+        for(; i+1 < M; i += 2) {\
+            type1 *a0 = a + i*K, *a1 = a0 + K;\
+            size_t j = jb;\
+            for(; j+1 < je; j += 2) {\
+                type2 *b0 = bt + j*K, *b1 = b0 + K;\
+                mp_float_t c00 = 0.0, c01 = 0.0, c10 = 0.0, c11 = 0.0;\
+                for(size_t k=0; k < K; k++) {\
+                    mp_float_t x0 = a0[k], x1 = a1[k], y0 = b0[k], y1 = b1[k];\
+                    c00 += x0 * y0;\
+                    c01 += x0 * y1;\
+                    c10 += x1 * y0;\
+                    c11 += x1 * y1;\
+                }\
+                c[i*N+j] = c00;\
+                c[i*N+j+1] = c01;\
+                c[(i+1)*N+j] = c10;\
+                c[(i+1)*N+j+1] = c11;\
+            }\
+            if(j < je) {\
+                type2 *b0 = bt + j*K;\
+                mp_float_t c00 = 0.0, c10 = 0.0;\
+                for(size_t k=0; k < K; k++) {\
+                    mp_float_t y0 = b0[k];\
+                    c00 += a0[k] * y0;\
+                    c10 += a1[k] * y0;\
+                }\
+                c[i*N+j] = c00;\
+                c[(i+1)*N+j] = c10;\
+            }\
+        }\
+        if(i < M) {\
+            type1 *a0 = a + i*K;\
+            for(size_t j=jb; j < je; j++) {\
+                type2 *b0 = bt + j*K;\
+                mp_float_t c00 = 0.0;\
+                for(size_t k=0; k < K; k++) {\
+                    c00 += (mp_float_t)a0[k] * b0[k];\
+                }\
+                c[i*N+j] = c00;\
+            }\
+        }\
+    }\
+}
+
+#define LINALG_DOT_KERNELS(suffix, type1)\
+    LINALG_DOT_KERNEL(linalg_dot_##suffix##_uint8, type1, uint8_t)\
+    LINALG_DOT_KERNEL(linalg_dot_##suffix##_int8, type1, int8_t)\
+    LINALG_DOT_KERNEL(linalg_dot_##suffix##_uint16, type1, uint16_t)\
+    LINALG_DOT_KERNEL(linalg_dot_##suffix##_int16, type1, int16_t)\
+    LINALG_DOT_KERNEL(linalg_dot_##suffix##_float, type1, mp_float_t)
+
+LINALG_DOT_KERNELS(uint8, uint8_t)
+LINALG_DOT_KERNELS(int8, int8_t)
+LINALG_DOT_KERNELS(uint16, uint16_t)
+LINALG_DOT_KERNELS(int16, int16_t)
+LINALG_DOT_KERNELS(float, mp_float_t)
+
+#define LINALG_DOT_KERNEL_ROW(suffix)\
+    { linalg_dot_##suffix##_uint8, linalg_dot_##suffix##_int8, linalg_dot_##suffix##_uint16,\
+      linalg_dot_##suffix##_int16, linalg_dot_##suffix##_float }
+
+static const linalg_dot_kernel_t linalg_dot_kernels[5][5] = {
+    LINALG_DOT_KERNEL_ROW(uint8),
+    LINALG_DOT_KERNEL_ROW(int8),
+    LINALG_DOT_KERNEL_ROW(uint16),
+    LINALG_DOT_KERNEL_ROW(int16),
+    LINALG_DOT_KERNEL_ROW(float),
+};
+
+static uint8_t linalg_dot_type_index(uint8_t typecode) {
+    switch(typecode) {
+        case NDARRAY_UINT8: return 0;
+        case NDARRAY_INT8: return 1;
+        case NDARRAY_UINT16: return 2;
+        case NDARRAY_INT16: return 3;
+        default: return 4;
+    }
+}
+
+// transposes the (K, N) matrix 'in' into the (N, K) matrix 'out'
+#define LINALG_DOT_TRANSPOSE(type, in, out, K, N) do {\
+    type *_in = (type *)(in), *_out = (type *)(out);\
+    for(size_t k=0; k < (K); k++) {\
+        for(size_t j=0; j < (N); j++) {\
+            _out[j*(K)+k] = *_in++;\
+        }\
+    }\
+} while(0)
+
+static void linalg_dot_pack(ndarray_obj_t *m, void *packed, size_t itemsize) {
+    switch(itemsize) {
+        case 1:
+            LINALG_DOT_TRANSPOSE(uint8_t, m->array->items, packed, m->m, m->n);
+            break;
+        case 2:
+            LINALG_DOT_TRANSPOSE(uint16_t, m->array->items, packed, m->m, m->n);
+            break;
+        default:
+            LINALG_DOT_TRANSPOSE(mp_float_t, m->array->items, packed, m->m, m->n);
+            break;
+    }
+}
+
+mp_obj_t linalg_dot(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+        { MP_QSTR_, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+        { MP_QSTR_out, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
     // TODO: should the results be upcast?
-    if(!MP_OBJ_IS_TYPE(_m1, &ulab_ndarray_type) || !MP_OBJ_IS_TYPE(_m2, &ulab_ndarray_type)) {
+    if(!MP_OBJ_IS_TYPE(args[0].u_obj, &ulab_ndarray_type) || !MP_OBJ_IS_TYPE(args[1].u_obj, &ulab_ndarray_type)) {
         mp_raise_TypeError(translate("arguments must be ndarrays"));
     }
-    ndarray_obj_t *m1 = MP_OBJ_TO_PTR(_m1);
-    ndarray_obj_t *m2 = MP_OBJ_TO_PTR(_m2);    
+    ndarray_obj_t *m1 = MP_OBJ_TO_PTR(args[0].u_obj);
+    ndarray_obj_t *m2 = MP_OBJ_TO_PTR(args[1].u_obj);
     if(m1->n != m2->m) {
         mp_raise_ValueError(translate("matrix dimensions do not match"));
     }
-    // TODO: numpy uses upcasting here
-    ndarray_obj_t *out = create_new_ndarray(m1->m, m2->n, NDARRAY_FLOAT);
-    mp_float_t *outdata = (mp_float_t *)out->array->items;
-    mp_float_t sum, v1, v2;
-    for(size_t i=0; i < m1->m; i++) { // rows of m1
-        for(size_t j=0; j < m2->n; j++) { // columns of m2
-            sum = 0.0;
-            for(size_t k=0; k < m2->m; k++) {
-                // (i, k) * (k, j)
-                v1 = ndarray_get_float_value(m1->array->items, m1->array->typecode, i*m1->n+k);
-                v2 = ndarray_get_float_value(m2->array->items, m2->array->typecode, k*m2->n+j);
-                sum += v1 * v2;
-            }
-            outdata[j*m1->m+i] = sum;
+    ndarray_obj_t *out;
+    if(args[2].u_obj == mp_const_none) {
+        // TODO: numpy uses upcasting here
+        out = create_new_ndarray(m1->m, m2->n, NDARRAY_FLOAT);
+    } else {
+        if(!MP_OBJ_IS_TYPE(args[2].u_obj, &ulab_ndarray_type)) {
+            mp_raise_TypeError(translate("out must be an ndarray"));
         }
+        out = MP_OBJ_TO_PTR(args[2].u_obj);
+        if((out->array->typecode != NDARRAY_FLOAT) || (out->m != m1->m) || (out->n != m2->n)) {
+            mp_raise_ValueError(translate("out must be a float array of the shape of the result"));
+        }
+        if((out->array->items == m1->array->items) || (out->array->items == m2->array->items)) {
+            mp_raise_ValueError(translate("out must not be one of the operands"));
+        }
+    }
+    mp_float_t *outdata = (mp_float_t *)out->array->items;
+    size_t M = m1->m, K = m1->n, N = m2->n;
+    if(M*N == 0) {
+        return MP_OBJ_FROM_PTR(out);
+    }
+
+    // short vectors and small matrices are packed on the stack
+    size_t itemsize = mp_binary_get_size('@', m2->array->typecode, NULL);
+    size_t packed_bytes = K*N*itemsize;
+    uint64_t stack_buffer[LINALG_DOT_STACK_BYTES/sizeof(uint64_t)];
+    void *packed = stack_buffer;
+    if(packed_bytes > LINALG_DOT_STACK_BYTES) {
+        packed = m_new(uint8_t, packed_bytes);
+    }
+    linalg_dot_pack(m2, packed, itemsize);
+
+    // width of the column panel, whose packed data fit in the cache
+    size_t nb = K*itemsize > 0 ? LINALG_DOT_BLOCK_BYTES / (K*itemsize) : N;
+    nb = nb < 2 ? 2 : (nb & ~(size_t)1);
+
+    linalg_dot_kernel_t kernel = linalg_dot_kernels[linalg_dot_type_index(m1->array->typecode)][linalg_dot_type_index(m2->array->typecode)];
+    kernel(m1->array->items, packed, outdata, M, K, N, nb);
+
+    if(packed != stack_buffer) {
+        m_del(uint8_t, packed, packed_bytes);
     }
     return MP_OBJ_FROM_PTR(out);
 }
 
-MP_DEFINE_CONST_FUN_OBJ_2(linalg_dot_obj, linalg_dot);
+MP_DEFINE_CONST_FUN_OBJ_KW(linalg_dot_obj, 2, linalg_dot);
 
 mp_obj_t linalg_det(mp_obj_t oin) {
     if(!MP_OBJ_IS_TYPE(oin, &ulab_ndarray_type)) {
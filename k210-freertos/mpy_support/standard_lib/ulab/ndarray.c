@@ -144,6 +144,14 @@ ndarray_obj_t *create_new_ndarray(size_t m, size_t n, uint8_t typecode) {
     return ndarray;
 }
 
+ndarray_obj_t *ndarray_binary_output(ndarray_obj_t *ol, uint8_t typecode, bool inplace) {
+    // in-place operations write to the left hand side, if the type of the result allows it
+    if(inplace && (ol->array->typecode == typecode)) {
+        return ol;
+    }
+    return create_new_ndarray(ol->m, ol->n, typecode);
+}
+
 mp_obj_t ndarray_copy(mp_obj_t self_in) {
     // returns a verbatim (shape and typecode) copy of self_in
     ndarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
@@ -687,27 +695,56 @@ mp_obj_t ndarray_binary_op(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs) {
 //    if(op == MP_BINARY_OP_REVERSE_ADD) {
  //       return ndarray_binary_op(MP_BINARY_OP_ADD, rhs, lhs);
   //  }    
-    // One of the operands is a scalar
     // TODO: conform to numpy with the upcasting
-    // TODO: implement in-place operators
+    // In-place operators are run as the corresponding binary operator, whose result
+    // is written to the left hand side, if it has the same type.
+    // Otherwise a new array is returned, and the name is simply re-bound.
+    bool inplace = true;
+    switch(op) {
+        case MP_BINARY_OP_INPLACE_ADD: op = MP_BINARY_OP_ADD; break;
+        case MP_BINARY_OP_INPLACE_SUBTRACT: op = MP_BINARY_OP_SUBTRACT; break;
+        case MP_BINARY_OP_INPLACE_MULTIPLY: op = MP_BINARY_OP_MULTIPLY; break;
+        case MP_BINARY_OP_INPLACE_TRUE_DIVIDE: op = MP_BINARY_OP_TRUE_DIVIDE; break;
+        default: inplace = false; break;
+    }
+
+    // One of the operands is a scalar
+    // The scalar is wrapped in a single item array on the stack, which is only used
+    // during this call, so that it runs through the same typed loops without an allocation.
+    union {
+        uint8_t u8;
+        int8_t i8;
+        uint16_t u16;
+        int16_t i16;
+        mp_float_t f;
+    } scalar;
+    mp_obj_array_t scalar_array = { .base = { &mp_type_array }, .typecode = NDARRAY_FLOAT, .free = 0, .len = 1, .items = &scalar };
+    ndarray_obj_t scalar_ndarray = { .base = { &ulab_ndarray_type }, .m = 1, .n = 1, .len = 1, .array = &scalar_array, .bytes = 0 };
     mp_obj_t RHS = MP_OBJ_NULL;
     bool rhs_is_scalar = true;
     if(MP_OBJ_IS_INT(rhs)) {
-        int32_t ivalue = mp_obj_get_int(rhs);
-        if((ivalue > 0) && (ivalue < 256)) {
-            CREATE_SINGLE_ITEM(RHS, uint8_t, NDARRAY_UINT8, ivalue);
-        } else if((ivalue > 255) && (ivalue < 65535)) {
-            CREATE_SINGLE_ITEM(RHS, uint16_t, NDARRAY_UINT16, ivalue);
-        } else if((ivalue < 0) && (ivalue > -128)) {
-            CREATE_SINGLE_ITEM(RHS, int8_t, NDARRAY_INT8, ivalue);
-        } else if((ivalue < -127) && (ivalue > -32767)) {
-            CREATE_SINGLE_ITEM(RHS, int16_t, NDARRAY_INT16, ivalue);
+        mp_int_t ivalue = mp_obj_get_int(rhs);
+        if((ivalue >= 0) && (ivalue <= 255)) {
+            scalar_array.typecode = NDARRAY_UINT8;
+            scalar.u8 = ivalue;
+        } else if((ivalue > 255) && (ivalue <= 65535)) {
+            scalar_array.typecode = NDARRAY_UINT16;
+            scalar.u16 = ivalue;
+        } else if((ivalue < 0) && (ivalue >= -128)) {
+            scalar_array.typecode = NDARRAY_INT8;
+            scalar.i8 = ivalue;
+        } else if((ivalue < -128) && (ivalue >= -32768)) {
+            scalar_array.typecode = NDARRAY_INT16;
+            scalar.i16 = ivalue;
         } else { // the integer value clearly does not fit the ulab types, so move on to float
-            CREATE_SINGLE_ITEM(RHS, mp_float_t, NDARRAY_FLOAT, ivalue);
+            scalar.f = (mp_float_t)ivalue;
         }
+        scalar_ndarray.bytes = mp_binary_get_size('@', scalar_array.typecode, NULL);
+        RHS = MP_OBJ_FROM_PTR(&scalar_ndarray);
     } else if(mp_obj_is_float(rhs)) {
-        mp_float_t fvalue = mp_obj_get_float(rhs);        
-        CREATE_SINGLE_ITEM(RHS, mp_float_t, NDARRAY_FLOAT, fvalue);
+        scalar.f = mp_obj_get_float(rhs);
+        scalar_ndarray.bytes = sizeof(mp_float_t);
+        RHS = MP_OBJ_FROM_PTR(&scalar_ndarray);
     } else {
         RHS = rhs;
         rhs_is_scalar = false;
@@ -762,63 +799,63 @@ mp_obj_t ndarray_binary_op(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs) {
                 // typecode of result, type_out, type_left, type_right, lhs operand, rhs operand, operator
                 if(ol->array->typecode == NDARRAY_UINT8) {
                     if(or->array->typecode == NDARRAY_UINT8) {
-                        RUN_BINARY_LOOP(NDARRAY_UINT8, uint8_t, uint8_t, uint8_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_UINT8, uint8_t, uint8_t, uint8_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_INT8) {
-                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, uint8_t, int8_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, uint8_t, int8_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_UINT16) {
-                        RUN_BINARY_LOOP(NDARRAY_UINT16, uint16_t, uint8_t, uint16_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_UINT16, uint16_t, uint8_t, uint16_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_INT16) {
-                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, uint8_t, int16_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, uint8_t, int16_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_FLOAT) {
-                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, uint8_t, mp_float_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, uint8_t, mp_float_t, ol, or, op, inplace);
                     }
                 } else if(ol->array->typecode == NDARRAY_INT8) {
                     if(or->array->typecode == NDARRAY_UINT8) {
-                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, int8_t, uint8_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, int8_t, uint8_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_INT8) {
-                        RUN_BINARY_LOOP(NDARRAY_INT8, int8_t, int8_t, int8_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_INT8, int8_t, int8_t, int8_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_UINT16) {
-                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, int8_t, uint16_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, int8_t, uint16_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_INT16) {
-                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, int8_t, int16_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, int8_t, int16_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_FLOAT) {
-                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, int8_t, mp_float_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, int8_t, mp_float_t, ol, or, op, inplace);
                     }                
                 } else if(ol->array->typecode == NDARRAY_UINT16) {
                     if(or->array->typecode == NDARRAY_UINT8) {
-                        RUN_BINARY_LOOP(NDARRAY_UINT16, uint16_t, uint16_t, uint8_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_UINT16, uint16_t, uint16_t, uint8_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_INT8) {
-                        RUN_BINARY_LOOP(NDARRAY_UINT16, uint16_t, uint16_t, int8_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_UINT16, uint16_t, uint16_t, int8_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_UINT16) {
-                        RUN_BINARY_LOOP(NDARRAY_UINT16, uint16_t, uint16_t, uint16_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_UINT16, uint16_t, uint16_t, uint16_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_INT16) {
-                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, uint16_t, int16_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, uint16_t, int16_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_FLOAT) {
-                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, uint8_t, mp_float_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, uint16_t, mp_float_t, ol, or, op, inplace);
                     }
                 } else if(ol->array->typecode == NDARRAY_INT16) {
                     if(or->array->typecode == NDARRAY_UINT8) {
-                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, int16_t, uint8_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, int16_t, uint8_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_INT8) {
-                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, int16_t, int8_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, int16_t, int8_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_UINT16) {
-                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, int16_t, uint16_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, int16_t, uint16_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_INT16) {
-                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, int16_t, int16_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_INT16, int16_t, int16_t, int16_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_FLOAT) {
-                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, uint16_t, mp_float_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, int16_t, mp_float_t, ol, or, op, inplace);
                     }
                 } else if(ol->array->typecode == NDARRAY_FLOAT) {
                     if(or->array->typecode == NDARRAY_UINT8) {
-                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, mp_float_t, uint8_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, mp_float_t, uint8_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_INT8) {
-                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, mp_float_t, int8_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, mp_float_t, int8_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_UINT16) {
-                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, mp_float_t, uint16_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, mp_float_t, uint16_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_INT16) {
-                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, mp_float_t, int16_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, mp_float_t, int16_t, ol, or, op, inplace);
                     } else if(or->array->typecode == NDARRAY_FLOAT) {
-                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, mp_float_t, mp_float_t, ol, or, op);
+                        RUN_BINARY_LOOP(NDARRAY_FLOAT, mp_float_t, mp_float_t, mp_float_t, ol, or, op, inplace);
                     }
                 } else { // this should never happen
                     mp_raise_TypeError(translate("wrong input type"));
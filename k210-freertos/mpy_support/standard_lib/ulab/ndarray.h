@@ -58,6 +58,7 @@ void ndarray_print_row(const mp_print_t *, mp_obj_array_t *, size_t , size_t );
 void ndarray_print(const mp_print_t *, mp_obj_t , mp_print_kind_t );
 void ndarray_assign_elements(mp_obj_array_t *, mp_obj_t , uint8_t , size_t *);
 ndarray_obj_t *create_new_ndarray(size_t , size_t , uint8_t );
+ndarray_obj_t *ndarray_binary_output(ndarray_obj_t *, uint8_t , bool );
 
 mp_obj_t ndarray_copy(mp_obj_t );
 #ifdef CIRCUITPY
@@ -99,20 +100,23 @@ mp_int_t ndarray_get_buffer(mp_obj_t obj, mp_buffer_info_t *bufinfo, mp_uint_t f
     should work outside the loop, but it doesn't. Go figure! 
 */
 
-#define RUN_BINARY_LOOP(typecode, type_out, type_left, type_right, ol, or, op) do {\
+// The result of the arithmetic operations is written to the left hand side, if inplace is true,
+// and the result has the type of the left hand side, otherwise to a new array.
+// The operation is selected once, each loop runs over the typed arrays.
+#define RUN_BINARY_LOOP(typecode, type_out, type_left, type_right, ol, or, op, inplace) do {\
     type_left *left = (type_left *)(ol)->array->items;\
     type_right *right = (type_right *)(or)->array->items;\
     uint8_t inc = 0;\
     if((or)->array->len > 1) inc = 1;\
     if(((op) == MP_BINARY_OP_ADD) || ((op) == MP_BINARY_OP_SUBTRACT) || ((op) == MP_BINARY_OP_MULTIPLY)) {\
-        ndarray_obj_t *out = create_new_ndarray(ol->m, ol->n, typecode);\
+        ndarray_obj_t *out = ndarray_binary_output((ol), (typecode), (inplace));\
         type_out *(odata) = (type_out *)out->array->items;\
         if((op) == MP_BINARY_OP_ADD) { for(size_t i=0, j=0; i < (ol)->array->len; i++, j+=inc) odata[i] = left[i] + right[j];}\
         if((op) == MP_BINARY_OP_SUBTRACT) { for(size_t i=0, j=0; i < (ol)->array->len; i++, j+=inc) odata[i] = left[i] - right[j];}\
         if((op) == MP_BINARY_OP_MULTIPLY) { for(size_t i=0, j=0; i < (ol)->array->len; i++, j+=inc) odata[i] = left[i] * right[j];}\
         return MP_OBJ_FROM_PTR(out);\
     } else if((op) == MP_BINARY_OP_TRUE_DIVIDE) {\
-        ndarray_obj_t *out = create_new_ndarray(ol->m, ol->n, NDARRAY_FLOAT);\
+        ndarray_obj_t *out = ndarray_binary_output((ol), NDARRAY_FLOAT, (inplace));\
         mp_float_t *odata = (mp_float_t *)out->array->items;\
         for(size_t i=0, j=0; i < (ol)->array->len; i++, j+=inc) odata[i] = (mp_float_t)left[i]/(mp_float_t)right[j];\
         return MP_OBJ_FROM_PTR(out);\
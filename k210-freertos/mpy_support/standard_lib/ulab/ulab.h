@@ -29,8 +29,10 @@
 
 // FFT costs about 2 kB of flash space
 #define ULAB_FFT_MODULE (1)
+// use the K210 hardware FFT accelerator for 64 to 512 point transforms
+#define ULAB_FFT_HARDWARE (1)
 
-// the filter module takes about 1 kB of flash space
+// the filter module takes about 4 kB of flash space
 #define ULAB_FILTER_MODULE (1)
 
 // user-defined modules
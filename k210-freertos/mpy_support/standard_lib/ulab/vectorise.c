@@ -23,15 +23,40 @@
 #endif
     
 #if ULAB_VECTORISE_MODULE
-mp_obj_t vectorise_generic_vector(mp_obj_t o_in, mp_float_t (*f)(mp_float_t)) {
+// Returns the out array for a result of len elements, or a new array, if out_obj is None
+static ndarray_obj_t *vectorise_get_output(mp_obj_t out_obj, size_t m, size_t n) {
+    if(out_obj == mp_const_none) {
+        return create_new_ndarray(m, n, NDARRAY_FLOAT);
+    }
+    if(!MP_OBJ_IS_TYPE(out_obj, &ulab_ndarray_type)) {
+        mp_raise_TypeError(translate("out must be an ndarray"));
+    }
+    ndarray_obj_t *out = MP_OBJ_TO_PTR(out_obj);
+    if((out->array->typecode != NDARRAY_FLOAT) || (out->array->len != m*n)) {
+        mp_raise_ValueError(translate("out must be a float array of the length of the input"));
+    }
+    return out;
+}
+
+mp_obj_t vectorise_generic_vector(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args, mp_float_t (*f)(mp_float_t)) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+        { MP_QSTR_out, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = mp_const_none } },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    mp_obj_t o_in = args[0].u_obj;
+
     // Return a single value, if o_in is not iterable
     if(mp_obj_is_float(o_in) || MP_OBJ_IS_INT(o_in)) {
             return mp_obj_new_float(f(mp_obj_get_float(o_in)));
     }
     mp_float_t x;
     if(MP_OBJ_IS_TYPE(o_in, &ulab_ndarray_type)) {
+        // the loop is selected by the type once; out may be the input array itself
         ndarray_obj_t *source = MP_OBJ_TO_PTR(o_in);
-        ndarray_obj_t *ndarray = create_new_ndarray(source->m, source->n, NDARRAY_FLOAT);
+        ndarray_obj_t *ndarray = vectorise_get_output(args[1].u_obj, source->m, source->n);
         mp_float_t *dataout = (mp_float_t *)ndarray->array->items;
         if(source->array->typecode == NDARRAY_UINT8) {
             ITERATE_VECTOR(uint8_t, source, dataout);
@@ -47,8 +72,8 @@ mp_obj_t vectorise_generic_vector(mp_obj_t o_in, mp_float_t (*f)(mp_float_t)) {
         return MP_OBJ_FROM_PTR(ndarray);
     } else if(MP_OBJ_IS_TYPE(o_in, &mp_type_tuple) || MP_OBJ_IS_TYPE(o_in, &mp_type_list) || 
         MP_OBJ_IS_TYPE(o_in, &mp_type_range)) { // i.e., the input is a generic iterable
-            mp_obj_array_t *o = MP_OBJ_TO_PTR(o_in);
-            ndarray_obj_t *out = create_new_ndarray(1, o->len, NDARRAY_FLOAT);
+            size_t len = mp_obj_get_int(mp_obj_len(o_in));
+            ndarray_obj_t *out = vectorise_get_output(args[1].u_obj, 1, len);
             mp_float_t *dataout = (mp_float_t *)out->array->items;
             mp_obj_iter_buf_t iter_buf;
             mp_obj_t item, iterable = mp_getiter(o_in, &iter_buf);
@@ -62,78 +87,77 @@ mp_obj_t vectorise_generic_vector(mp_obj_t o_in, mp_float_t (*f)(mp_float_t)) {
     return mp_const_none;
 }
 
-
 MATH_FUN_1(acos, acos);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_acos_obj, vectorise_acos);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_acos_obj, 1, vectorise_acos);
 
 MATH_FUN_1(acosh, acosh);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_acosh_obj, vectorise_acosh);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_acosh_obj, 1, vectorise_acosh);
 
 MATH_FUN_1(asin, asin);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_asin_obj, vectorise_asin);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_asin_obj, 1, vectorise_asin);
 
 MATH_FUN_1(asinh, asinh);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_asinh_obj, vectorise_asinh);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_asinh_obj, 1, vectorise_asinh);
 
 MATH_FUN_1(atan, atan);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_atan_obj, vectorise_atan);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_atan_obj, 1, vectorise_atan);
 
 MATH_FUN_1(atanh, atanh);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_atanh_obj, vectorise_atanh);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_atanh_obj, 1, vectorise_atanh);
 
 MATH_FUN_1(ceil, ceil);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_ceil_obj, vectorise_ceil);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_ceil_obj, 1, vectorise_ceil);
 
 MATH_FUN_1(cos, cos);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_cos_obj, vectorise_cos);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_cos_obj, 1, vectorise_cos);
 
 MATH_FUN_1(cosh, cosh);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_cosh_obj, vectorise_cosh);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_cosh_obj, 1, vectorise_cosh);
 
 MATH_FUN_1(erf, erf);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_erf_obj, vectorise_erf);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_erf_obj, 1, vectorise_erf);
 
 MATH_FUN_1(erfc, erfc);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_erfc_obj, vectorise_erfc);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_erfc_obj, 1, vectorise_erfc);
 
 MATH_FUN_1(exp, exp);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_exp_obj, vectorise_exp);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_exp_obj, 1, vectorise_exp);
 
 MATH_FUN_1(expm1, expm1);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_expm1_obj, vectorise_expm1);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_expm1_obj, 1, vectorise_expm1);
 
 MATH_FUN_1(floor, floor);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_floor_obj, vectorise_floor);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_floor_obj, 1, vectorise_floor);
 
 MATH_FUN_1(gamma, tgamma);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_gamma_obj, vectorise_gamma);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_gamma_obj, 1, vectorise_gamma);
 
 MATH_FUN_1(lgamma, lgamma);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_lgamma_obj, vectorise_lgamma);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_lgamma_obj, 1, vectorise_lgamma);
 
 MATH_FUN_1(log, log);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_log_obj, vectorise_log);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_log_obj, 1, vectorise_log);
 
 MATH_FUN_1(log10, log10);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_log10_obj, vectorise_log10);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_log10_obj, 1, vectorise_log10);
 
 MATH_FUN_1(log2, log2);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_log2_obj, vectorise_log2);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_log2_obj, 1, vectorise_log2);
 
 MATH_FUN_1(sin, sin);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_sin_obj, vectorise_sin);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_sin_obj, 1, vectorise_sin);
 
 MATH_FUN_1(sinh, sinh);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_sinh_obj, vectorise_sinh);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_sinh_obj, 1, vectorise_sinh);
 
 MATH_FUN_1(sqrt, sqrt);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_sqrt_obj, vectorise_sqrt);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_sqrt_obj, 1, vectorise_sqrt);
 
 MATH_FUN_1(tan, tan);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_tan_obj, vectorise_tan);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_tan_obj, 1, vectorise_tan);
 
 MATH_FUN_1(tanh, tanh);
-MP_DEFINE_CONST_FUN_OBJ_1(vectorise_tanh_obj, vectorise_tanh);
+MP_DEFINE_CONST_FUN_OBJ_KW(vectorise_tanh_obj, 1, vectorise_tanh);
 
 STATIC const mp_rom_map_elem_t ulab_vectorise_globals_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR___name__), MP_OBJ_NEW_QSTR(MP_QSTR_vector) },
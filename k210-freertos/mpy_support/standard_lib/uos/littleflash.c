@@ -136,20 +136,14 @@ static int internal_erase(const struct lfs_config *c, lfs_block_t block)
     //if (w25qxx_debug) LOGD(TAG, "[ERASE] bkl=%u", block);
 
     // erase sector size is 4096!
-    uint8_t *pread = swap_buf;
-    w25qxx_read_data(phy_addr, swap_buf, w25qxx_FLASH_SECTOR_SIZE);
-    for (int index = 0; index < w25qxx_FLASH_SECTOR_SIZE; index++)
-    {
-        if (*pread != 0xFF) {
-            //if (w25qxx_debug) LOGD(TAG, "[ERASE] physical erase %0xx", phy_addr);
-            if (w25qxx_sector_erase(phy_addr) != W25QXX_OK) {
-                //if (w25qxx_debug) LOGE(TAG, "erase err");
-                xSemaphoreGive(littlefs_mutex);
-                return W25QXX_BUSY;
-            }
-            break;
+    // the flash driver keeps the map of erased sectors, the sector is read only if its state is not known
+    if (!w25qxx_sector_is_erased(phy_addr)) {
+        //if (w25qxx_debug) LOGD(TAG, "[ERASE] physical erase %0xx", phy_addr);
+        if (w25qxx_sector_erase(phy_addr) != W25QXX_OK) {
+            //if (w25qxx_debug) LOGE(TAG, "erase err");
+            xSemaphoreGive(littlefs_mutex);
+            return W25QXX_BUSY;
         }
-        pread++;
     }
     xSemaphoreGive(littlefs_mutex);
     return LFS_ERR_OK;
@@ -171,6 +165,8 @@ static int internal_dummy_erase(const struct lfs_config *c, lfs_block_t block)
 //--------------------------------------------------
 static int internal_sync(const struct lfs_config *c)
 {
+    // write all cached sectors to flash
+    if (w25qxx_cache_flush() != W25QXX_OK) return LFS_ERR_IO;
     return LFS_ERR_OK;
 }
 
@@ -320,6 +316,11 @@ MP_NOINLINE bool init_flash_filesystem()
     configASSERT(littlefs_mutex);
 
     w25qxx_clear_counters();
+    // cache the writes to the file system area
+    w25qxx_cache_set_range(LITTLEFS_CFG_START_ADDR, LITTLEFS_CFG_PHYS_SZ);
+    #if MICRO_PY_FLASH_SAVE_ERASED_MAP
+    w25qxx_erased_map_load(MICRO_PY_FLASH_ERASED_MAP_ADDR);
+    #endif
 
     int err;
 
@@ -441,6 +442,10 @@ void littleFlash_term(const char* partition_label)
         lfs_unmount(&littleFlash.lfs);
         littleFlash.mounted = false;
     }
+    w25qxx_cache_flush();
+    #if MICRO_PY_FLASH_SAVE_ERASED_MAP
+    w25qxx_erased_map_save(MICRO_PY_FLASH_ERASED_MAP_ADDR);
+    #endif
 }
 
 // ==============================================================================================================
@@ -954,20 +959,8 @@ STATIC mp_obj_t vfs_littlefs_trim(size_t n_args, const mp_obj_t *args)
                     }
                     if ((f) && (((sector[0] * LITTLEFS_CFG_SECTOR_SIZE) % LITTLEFS_CFG_PHYS_ERASE_SZ) == 0)) {
                         // All blocks in sector are free, erase the whole sector
-                        f = false;
                         // check if free blocks are already erased
-                        for (int n=0; n<(LITTLEFS_CFG_PHYS_ERASE_SZ / LITTLEFS_CFG_SECTOR_SIZE); n++) {
-                            if (internal_read(&littleFlash.lfs_cfg, sector[n], 0, block_buf, LITTLEFS_CFG_SECTOR_SIZE) == LFS_ERR_OK) {
-                                for (int bidx=0; bidx<LITTLEFS_CFG_SECTOR_SIZE; bidx++) {
-                                    if (block_buf[bidx] != 0xFF) {
-                                        f = true; // needs erase
-                                        break;
-                                    }
-                                }
-                            }
-                            else f = false;
-                            if (f == true) break;
-                        }
+                        f = !w25qxx_sector_is_erased(LITTLEFS_CFG_START_ADDR + (sector[0] * LITTLEFS_CFG_SECTOR_SIZE));
                         if (f) {
                             //LOGY(TAG, "Erase sector %u", sector[0]);
                             if (do_erase) internal_erase(&littleFlash.lfs_cfg, sector[0] / (LITTLEFS_CFG_PHYS_ERASE_SZ / LITTLEFS_CFG_SECTOR_SIZE));
@@ -1052,6 +1045,7 @@ STATIC const mp_rom_map_elem_t littlefs_vfs_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_statvfs),     MP_ROM_PTR(&littlefs_vfs_statvfs_obj) },
     { MP_ROM_QSTR(MP_QSTR_umount),      MP_ROM_PTR(&littlefs_vfs_umount_obj) },
     { MP_ROM_QSTR(MP_QSTR_counters),    MP_ROM_PTR(&littlefs_vfs_counters_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flashcache),  MP_ROM_PTR(&mod_os_flashcache_obj) },
     { MP_ROM_QSTR(MP_QSTR_trim),        MP_ROM_PTR(&littlefs_vfs_trim_obj) },
 };
 STATIC MP_DEFINE_CONST_DICT(littlefs_vfs_locals_dict, littlefs_vfs_locals_dict_table);
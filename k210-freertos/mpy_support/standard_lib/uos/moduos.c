@@ -52,6 +52,7 @@
 #include "vfs_sdcard.h"
 #endif
 #include "mphalport.h"
+#include "w25qxx.h"
 
 
 STATIC const qstr os_uname_info_fields[] = {
@@ -127,6 +128,10 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(os_dupterm_notify_obj, os_dupterm_notify);
 //---------------------------
 STATIC mp_obj_t os_sync(void)
 {
+    // write all cached Flash file system sectors
+    if (w25qxx_cache_flush() != W25QXX_OK) {
+        mp_raise_OSError(MP_EIO);
+    }
     #if MICROPY_VFS
     /*
     for (mp_vfs_mount_t *vfs = MP_STATE_VM(vfs_mount_table); vfs != NULL; vfs = vfs->next) {
@@ -139,6 +144,30 @@ STATIC mp_obj_t os_sync(void)
 }
 MP_DEFINE_CONST_FUN_OBJ_0(mod_os_sync_obj, os_sync);
 
+// Return the flash sector cache statistics
+// Used as the 'flashcache' method of the Flash file system VFS object
+//---------------------------------------------------------------
+STATIC mp_obj_t os_flashcache(size_t n_args, const mp_obj_t *args)
+{
+    w25qxx_cache_stats_t stats;
+    bool clear = false;
+    if (n_args > 1) clear = mp_obj_is_true(args[1]);
+    w25qxx_cache_get_stats(&stats, clear);
+
+    mp_obj_tuple_t *t = MP_OBJ_TO_PTR(mp_obj_new_tuple(9, NULL));
+    t->items[0] = mp_obj_new_int(stats.hits);
+    t->items[1] = mp_obj_new_int(stats.misses);
+    t->items[2] = mp_obj_new_int(stats.merged);
+    t->items[3] = mp_obj_new_int(stats.writebacks);
+    t->items[4] = mp_obj_new_int(stats.erases);
+    t->items[5] = mp_obj_new_int(stats.evictions);
+    t->items[6] = mp_obj_new_int(stats.max_wear);
+    t->items[7] = mp_obj_new_int(stats.max_wear_addr);
+    t->items[8] = mp_obj_new_int(stats.blank_hits);
+    return MP_OBJ_FROM_PTR(t);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_os_flashcache_obj, 1, 2, os_flashcache);
+
 #define PROXY_MAX_ARGS (2)
 
 //-----------------------------------------------------------------------------------------------------------
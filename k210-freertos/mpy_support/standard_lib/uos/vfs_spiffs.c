@@ -167,6 +167,11 @@ MP_NOINLINE bool init_flash_filesystem()
     configASSERT(spiffs_lock);
 
     w25qxx_clear_counters();
+    // cache the writes to the file system area
+    w25qxx_cache_set_range(MICRO_PY_FLASHFS_START_ADDRESS, MICRO_PY_FLASHFS_SIZE);
+    #if MICRO_PY_FLASH_SAVE_ERASED_MAP
+    w25qxx_erased_map_load(MICRO_PY_FLASH_ERASED_MAP_ADDR);
+    #endif
     vfs_spiffs->flags = SYS_SPIFFS;
     vfs_spiffs->base.type = &mp_spiffs_vfs_type;
     vfs_spiffs->fs.user_data = vfs_spiffs;
@@ -864,6 +869,7 @@ STATIC const mp_rom_map_elem_t spiffs_vfs_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_statvfs),     MP_ROM_PTR(&spiffs_vfs_statvfs_obj) },
     { MP_ROM_QSTR(MP_QSTR_umount),      MP_ROM_PTR(&spiffs_vfs_umount_obj) },
     { MP_ROM_QSTR(MP_QSTR_counters),    MP_ROM_PTR(&spiffs_vfs_counters_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flashcache),  MP_ROM_PTR(&mod_os_flashcache_obj) },
     { MP_ROM_QSTR(MP_QSTR_check),       MP_ROM_PTR(&spiffs_vfs_check_obj) },
     { MP_ROM_QSTR(MP_QSTR_gc),          MP_ROM_PTR(&spiffs_vfs_gc_obj) },
     { MP_ROM_QSTR(MP_QSTR_dbg_level),   MP_ROM_PTR(&spiffs_vfs_dbg_level_obj) },
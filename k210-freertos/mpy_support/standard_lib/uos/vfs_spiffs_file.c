@@ -232,6 +232,11 @@ STATIC mp_uint_t file_obj_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_t arg,
             SPIFFS_clearerr(fp.fs);
             return MP_STREAM_ERROR;
         }
+        // SPIFFS has no sync hook, write the cached Flash sectors here
+        if (w25qxx_cache_flush() != W25QXX_OK) {
+            *errcode = MP_EIO;
+            return MP_STREAM_ERROR;
+        }
         return 0;
 
     } else if (request == MP_STREAM_CLOSE) {
@@ -243,6 +248,10 @@ STATIC mp_uint_t file_obj_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_t arg,
                 SPIFFS_clearerr(fp.fs);
                 return MP_STREAM_ERROR;
             }
+            if (w25qxx_cache_flush() != W25QXX_OK) {
+                *errcode = MP_EIO;
+                return MP_STREAM_ERROR;
+            }
         }
         return 0;
 
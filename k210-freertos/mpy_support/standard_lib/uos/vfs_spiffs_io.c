@@ -61,18 +61,12 @@ s32_t sys_spiffs_erase(int addr, int size)
 #endif
 {
     // size is always 4096!
-    uint8_t *pread = swap_buf;
-    w25qxx_read_data(addr, swap_buf, w25qxx_FLASH_SECTOR_SIZE);
-    for (int index = 0; index < w25qxx_FLASH_SECTOR_SIZE; index++)
-    {
-        if (*pread != 0xFF) {
-            if (w25qxx_sector_erase(addr) != W25QXX_OK) {
-                LOGE(TAG, "spifalsh erase err");
-                return W25QXX_BUSY;
-            }
-            break;
+    // the sector is read only if the flash driver does not know if it is erased
+    if (!w25qxx_sector_is_erased(addr)) {
+        if (w25qxx_sector_erase(addr) != W25QXX_OK) {
+            LOGE(TAG, "spifalsh erase err");
+            return W25QXX_BUSY;
         }
-        pread++;
     }
     return W25QXX_OK;
 }
@@ -101,11 +101,38 @@
 #define REG1_WEL_MASK                       0x02
 #define REG2_QUAD_MASK                      0x02
 
+// ---- Sector write-back cache ----
+// Number of 4 KB sector slots held in RAM between the file system and the Flash chip
+#define W25QXX_CACHE_SLOTS                  4
+// Dirty sectors older than this are written back by the flush task
+#define W25QXX_CACHE_FLUSH_MS               500
+// Must be lower than the MicroPython tasks priority (8), the flush task only runs when they are idle
+#define W25QXX_FLUSH_TASK_PRIORITY          7
+// Maximum number of sectors which can be tracked for wear counting (16 MB Flash)
+#define W25QXX_MAX_SECTORS                  4096
+// Erased sectors map saved to flash
+#define W25QXX_ERASED_MAP_MAGIC             0x454D4150
+
 #define LETOBE(x)     ((x >> 24) | ((x & 0x00FF0000) >> 8) | ((x & 0x0000FF00) << 8) | (x << 24))
 /* clang-format on */
 
 #define SPI_DEFAULT_CLOCK 25000000
 
+/**
+ * @brief      w25qxx sector cache statistics
+ */
+typedef struct _w25qxx_cache_stats_t {
+    uint32_t hits;          // reads and writes served from a cached sector
+    uint32_t misses;        // sector loads from Flash into a cache slot
+    uint32_t merged;        // writes merged into an already dirty sector
+    uint32_t writebacks;    // dirty sectors written back to Flash
+    uint32_t erases;        // sector erases performed on write back
+    uint32_t evictions;     // dirty sectors written back to make room for another sector
+    uint32_t blank_hits;    // sector reads avoided using the erased sectors map
+    uint32_t max_wear;      // highest erase count of any sector in the cached range
+    uint32_t max_wear_addr; // address of the most worn sector
+} w25qxx_cache_stats_t;
+
 /**
  * @brief      w25qxx operating status enumerate
  */
@@ -122,6 +149,7 @@ extern uint32_t w25qxx_max_speed;
 extern uint32_t w25qxx_flash_speed;
 extern uint32_t w25qxx_actual_speed;
 extern uint8_t work_trans_mode;
+extern bool w25qxx_cache_enabled;
 extern uint8_t __attribute__((aligned(8))) swap_buf[w25qxx_FLASH_SECTOR_SIZE];
 extern uint8_t *w25qxx_flash_ptr;
 extern uint16_t *w25qxx_flash_ptr16;
@@ -131,6 +159,14 @@ extern bool w25qxx_swap_dat;
 void w25qxx_clear_counters();
 void w25qxx_get_counters(uint32_t *r, uint32_t *w, uint32_t *e, uint64_t *time);
 
+void w25qxx_cache_set_range(uint32_t start_addr, uint32_t size);
+enum w25qxx_status_t w25qxx_cache_flush(void);
+void w25qxx_cache_get_stats(w25qxx_cache_stats_t *stats, bool clear);
+uint32_t w25qxx_sector_wear(uint32_t addr);
+bool w25qxx_sector_is_erased(uint32_t addr);
+int w25qxx_erased_map_load(uint32_t map_addr);
+enum w25qxx_status_t w25qxx_erased_map_save(uint32_t map_addr);
+
 uint32_t w25qxx_init(uintptr_t spi_in, uint8_t mode, double clock_rate);
 enum w25qxx_status_t w25qxx_write_data(uint32_t addr, uint8_t* data_buf, uint32_t length);
 enum w25qxx_status_t w25qxx_read_data(uint32_t addr, uint8_t* data_buf, uint32_t length);
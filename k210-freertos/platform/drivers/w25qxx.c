@@ -40,6 +40,7 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <devices.h>
 #include "w25qxx.h"
@@ -47,6 +48,8 @@
 #include "sysctl.h"
 #include "FreeRTOS.h"
 #include "task.h"
+#include "semphr.h"
+#include "utility.h"
 
 #define CYCLES_PER_US   (uint64_t)(sysctl_clock_get_freq(SYSCTL_CLOCK_CPU)/1000000)
 
@@ -59,7 +62,7 @@ uint8_t work_trans_mode = 0;
 uint32_t w25qxx_max_speed = WQ25QXX_MAX_SPEED;
 uint32_t w25qxx_flash_speed = 0;
 uint32_t w25qxx_actual_speed = 0;
-// used only by 'w25qxx_write_data'
+// used by the file systems to check the sector content
 uint8_t __attribute__((aligned(8))) swap_buf[w25qxx_FLASH_SECTOR_SIZE];
 bool w25qxx_swap_dat = true;
 
@@ -73,6 +76,50 @@ static uint32_t wr_count;
 static uint32_t er_count;
 static uint64_t op_time;
 
+// ---- Sector write-back cache ----
+typedef struct _w25qxx_cache_slot_t {
+    uint8_t data[w25qxx_FLASH_SECTOR_SIZE];
+    uint32_t addr;          // cached sector address
+    uint32_t last_used;     // used to select the least recently used slot
+    uint32_t dirty_seq;     // order in which the dirty slots must be written back
+    TickType_t dirty_time;  // time of the first write since last write back
+    bool valid;
+    bool dirty;
+} __attribute__((aligned(8))) w25qxx_cache_slot_t;
+
+bool w25qxx_cache_enabled = true;
+
+static w25qxx_cache_slot_t cache_slots[W25QXX_CACHE_SLOTS];
+static w25qxx_cache_stats_t cache_stats = {0};
+static uint32_t cache_start = 0;
+static uint32_t cache_end = 0;
+static uint32_t cache_use_count = 0;
+static uint32_t cache_dirty_count = 0;
+static uint16_t *sector_wear = NULL;
+// Erased sectors map, two bits for each sector in the cached range:
+// 'known_map' bit is set if the sector state is known, 'erased_map' bit is set if the sector is erased
+static uint32_t *known_map = NULL;
+static uint32_t *erased_map = NULL;
+static TaskHandle_t w25qxx_flush_task_handle = NULL;
+static bool xip_active = false;
+// used by sector write functions, 'swap_buf' is used by the file systems
+static uint8_t __attribute__((aligned(8))) sector_buf[w25qxx_FLASH_SECTOR_SIZE];
+
+// Driver lock, the flash can be accessed from the file systems and from the cache flush task
+static SemaphoreHandle_t w25qxx_mutex = NULL;
+
+//--------------------------------
+static inline void w25qxx_lock(void)
+{
+    if (w25qxx_mutex) xSemaphoreTakeRecursive(w25qxx_mutex, portMAX_DELAY);
+}
+
+//----------------------------------
+static inline void w25qxx_unlock(void)
+{
+    if (w25qxx_mutex) xSemaphoreGiveRecursive(w25qxx_mutex);
+}
+
 //--------------------------------------------------------------------------------------------------------------------
 static enum w25qxx_status_t w25qxx_receive_data(uint8_t* cmd_buff, uint8_t cmd_len, uint8_t* rx_buff, uint32_t rx_len)
 {
@@ -277,8 +324,8 @@ static enum w25qxx_status_t _w25qxx_read_data(uint32_t addr, uint8_t* data_buf,
     return W25QXX_OK;
 }
 
-//======================================================================================
-enum w25qxx_status_t w25qxx_read_data(uint32_t addr, uint8_t* data_buf, uint32_t length)
+//-----------------------------------------------------------------------------------------------
+static enum w25qxx_status_t w25qxx_read_checked(uint32_t addr, uint8_t* data_buf, uint32_t length)
 {
     uint8_t *read_buf = NULL;
     int retry = 0;
@@ -300,11 +347,82 @@ start:
     return W25QXX_OK;
 }
 
+// ==== Erased sectors map =======================================================================
+
+// Header of the erased sectors map saved in flash, followed by the map
+typedef struct _erased_map_header_t {
+    uint32_t magic;
+    uint32_t valid;     // 0xFFFFFFFF if the map is valid, cleared (programmed to 0) when the map is loaded
+    uint32_t start;     // start address and size of the mapped flash range
+    uint32_t size;
+    uint32_t fs_crc;    // crc32 of the first two sectors of the mapped range when the map was saved
+    uint32_t map_crc;
+    uint32_t reserved[2];
+} erased_map_header_t;
+
+//----------------------------------------------
+static inline int erased_map_index(uint32_t addr)
+{
+    if ((known_map == NULL) || (addr < cache_start) || (addr >= cache_end)) return -1;
+    return (addr - cache_start) / w25qxx_FLASH_SECTOR_SIZE;
+}
+
+//---------------------------------------------------------
+static inline uint32_t erased_map_words(void)
+{
+    return (((cache_end - cache_start) / w25qxx_FLASH_SECTOR_SIZE) + 31) / 32;
+}
+
+//------------------------------------------------------------
+static void erased_map_set(uint32_t addr, bool erased)
+{
+    int sect = erased_map_index(addr);
+    if (sect < 0) return;
+    known_map[sect >> 5] |= (1 << (sect & 31));
+    if (erased) erased_map[sect >> 5] |= (1 << (sect & 31));
+    else erased_map[sect >> 5] &= ~(1 << (sect & 31));
+}
+
+// Returns 1 if the sector is erased, 0 if not, -1 if the sector state is not known
+//----------------------------------------
+static int erased_map_get(uint32_t addr)
+{
+    int sect = erased_map_index(addr);
+    if (sect < 0) return -1;
+    if ((known_map[sect >> 5] & (1 << (sect & 31))) == 0) return -1;
+    return ((erased_map[sect >> 5] & (1 << (sect & 31))) != 0);
+}
+
+// 'buf' must be 8-byte aligned
+//-------------------------------------------------------------
+static bool buffer_is_blank(const uint8_t *buf, uint32_t length)
+{
+    const uint64_t *pbuf = (const uint64_t *)buf;
+    for (uint32_t i = 0; i < (length / 8); i++) {
+        if (pbuf[i] != 0xFFFFFFFFFFFFFFFFUL) return false;
+    }
+    return true;
+}
+
+// Read the whole sector, known erased sectors are not read from flash
+//---------------------------------------------------------------------------
+static enum w25qxx_status_t w25qxx_read_sector(uint32_t sector_addr, uint8_t *buf)
+{
+    if (erased_map_get(sector_addr) == 1) {
+        memset(buf, 0xFF, w25qxx_FLASH_SECTOR_SIZE);
+        cache_stats.blank_hits++;
+        return W25QXX_OK;
+    }
+    enum w25qxx_status_t res = w25qxx_read_checked(sector_addr, buf, w25qxx_FLASH_SECTOR_SIZE);
+    if (res == W25QXX_OK) erased_map_set(sector_addr, buffer_is_blank(buf, w25qxx_FLASH_SECTOR_SIZE));
+    return res;
+}
+
 // ==== Flash write functions ====================================================================
 
-// Erase the flash sector at address 'addr'
-//=====================================================
-enum w25qxx_status_t w25qxx_sector_erase(uint32_t addr)
+// Erase the flash sector at address 'addr', the caller holds the driver lock
+//------------------------------------------------------------
+static enum w25qxx_status_t _w25qxx_sector_erase(uint32_t addr)
 {
     if (addr % w25qxx_FLASH_SECTOR_SIZE) {
         LOGE("w25qxx_erase", "Erase address not aligned (%u)",addr);
@@ -319,6 +437,17 @@ enum w25qxx_status_t w25qxx_sector_erase(uint32_t addr)
     w25qxx_send_data(spi_stand, cmd, 4, 0, 0);
     er_count++;
     enum w25qxx_status_t res = w25qxx_wait_busy();
+    if (res == W25QXX_OK) erased_map_set(addr, true);
+
+    if ((sector_wear) && (addr >= cache_start) && (addr < cache_end)) {
+        // update sector wear counter
+        uint32_t sect = (addr - cache_start) / w25qxx_FLASH_SECTOR_SIZE;
+        if (sector_wear[sect] < 0xFFFF) sector_wear[sect]++;
+        if (sector_wear[sect] > cache_stats.max_wear) {
+            cache_stats.max_wear = sector_wear[sect];
+            cache_stats.max_wear_addr = addr;
+        }
+    }
     return res;
 }
 
@@ -357,6 +486,7 @@ start:
         w25qxx_send_data(spi_stand, (uint8_t*)cmd, 4, data_buf, w25qxx_FLASH_PAGE_SIZE);
     }
     wr_count++;
+    erased_map_set(addr & (~(w25qxx_FLASH_SECTOR_SIZE - 1)), false);
     enum w25qxx_status_t res = w25qxx_wait_busy();
     if (res != W25QXX_OK) return res;
 
@@ -371,30 +501,517 @@ start:
     return res;
 }
 
-// Program all sector pages, 'addr' is the sector address
-//---------------------------------------------------------------------------------
-static enum w25qxx_status_t w25qxx_sector_program(uint32_t addr, uint8_t* data_buf)
+// Update the data in one flash sector
+// 'sector_data' holds the current sector content and is updated with the new data
+// Only the pages which are changed are programmed, the sector is erased only if
+// some bits must be set to '1'
+//-------------------------------------------------------------------------------------------------------------------------------------
+static enum w25qxx_status_t w25qxx_sector_update(uint32_t sector_addr, uint8_t *sector_data, uint32_t offset, uint8_t *data_buf, uint32_t length)
+{
+    uint8_t *pread = sector_data + offset;
+    uint8_t *pwrite = data_buf;
+    uint32_t changed_pages = 0;
+    bool needs_erase = false;
+    enum w25qxx_status_t res;
+
+    // Check which pages are changed and if some bits in sector needs to be erased
+    for (uint32_t index = 0; index < length; index++) {
+        if (*pwrite != *pread) {
+            changed_pages |= 1 << ((offset + index) / w25qxx_FLASH_PAGE_SIZE);
+            if ((*pwrite) != ((*pwrite) & (*pread))) needs_erase = true;
+        }
+        pwrite++;
+        pread++;
+    }
+    if (changed_pages == 0) return W25QXX_OK;
+
+    memcpy(sector_data + offset, data_buf, length);
+    if (needs_erase) {
+        // Some bits must be set to '1', sector must be erased
+        if (w25qxx_debug) LOGV("w25qxx_write", "erase sector %x (write at %x, len=%u)", sector_addr, sector_addr+offset, length);
+        if (_w25qxx_sector_erase(sector_addr) != W25QXX_OK) {
+            // This can actually never happen, as the Watchdog will reset the CPU
+            if (w25qxx_debug) LOGE("w25qxx_write", "sector NOT erased (timeout)");
+            return W25QXX_BUSY;
+        }
+        if (w25qxx_debug) LOGV("w25qxx_write", "sector %x erased", sector_addr);
+        // all pages which are not blank must be programmed
+        changed_pages = 0;
+        for (uint32_t page = 0; page < w25qxx_FLASH_PAGE_NUM_PER_SECTOR; page++) {
+            uint64_t *pdata = (uint64_t *)(sector_data + (page * w25qxx_FLASH_PAGE_SIZE));
+            for (uint32_t index = 0; index < (w25qxx_FLASH_PAGE_SIZE / 8); index++) {
+                if (pdata[index] != 0xFFFFFFFFFFFFFFFFUL) {
+                    changed_pages |= 1 << page;
+                    break;
+                }
+            }
+        }
+    }
+    for (uint32_t page = 0; page < w25qxx_FLASH_PAGE_NUM_PER_SECTOR; page++) {
+        if (changed_pages & (1 << page)) {
+            res = w25qxx_page_program(sector_addr + (page * w25qxx_FLASH_PAGE_SIZE), sector_data + (page * w25qxx_FLASH_PAGE_SIZE));
+            if (res != W25QXX_OK) {
+                if (w25qxx_debug) LOGE("w25qxx_write", "sector program error (%d)", res);
+                return res;
+            }
+        }
+    }
+    return W25QXX_OK;
+}
+
+// ==== Sector write-back cache ==================================================================
+
+//------------------------------------------------
+static inline bool w25qxx_in_cache(uint32_t addr)
+{
+    return ((w25qxx_cache_enabled) && (addr >= cache_start) && (addr < cache_end));
+}
+
+//-------------------------------------------------------------------
+static w25qxx_cache_slot_t *w25qxx_cache_find(uint32_t sector_addr)
+{
+    for (int i=0; i<W25QXX_CACHE_SLOTS; i++) {
+        if ((cache_slots[i].valid) && (cache_slots[i].addr == sector_addr)) return &cache_slots[i];
+    }
+    return NULL;
+}
+
+// Write the dirty cache slot to flash
+//-----------------------------------------------------------------------
+static enum w25qxx_status_t w25qxx_cache_writeback(w25qxx_cache_slot_t *slot)
+{
+    enum w25qxx_status_t res;
+    uint32_t er = er_count;
+
+    res = w25qxx_read_sector(slot->addr, sector_buf);
+    if (res != W25QXX_OK) return res;
+    res = w25qxx_sector_update(slot->addr, sector_buf, 0, slot->data, w25qxx_FLASH_SECTOR_SIZE);
+    if (res != W25QXX_OK) return res;
+
+    slot->dirty = false;
+    cache_stats.writebacks++;
+    cache_stats.erases += er_count - er;
+    return W25QXX_OK;
+}
+
+// Get the dirty slot which was dirtied first
+//---------------------------------------------------------
+static w25qxx_cache_slot_t *w25qxx_cache_oldest_dirty(void)
+{
+    w25qxx_cache_slot_t *slot = NULL;
+    for (int i=0; i<W25QXX_CACHE_SLOTS; i++) {
+        if ((cache_slots[i].valid) && (cache_slots[i].dirty)) {
+            if ((slot == NULL) || ((int32_t)(cache_slots[i].dirty_seq - slot->dirty_seq) < 0)) slot = &cache_slots[i];
+        }
+    }
+    return slot;
+}
+
+// Write back the dirty slots in the order in which they were dirtied,
+// up to and including the slot 'last' (all dirty slots if NULL).
+// The Flash content is then always the result of some prefix of the
+// file system writes, as it would be without the cache.
+//-----------------------------------------------------------------------------
+static enum w25qxx_status_t w25qxx_cache_writeback_upto(w25qxx_cache_slot_t *last)
+{
+    enum w25qxx_status_t res = W25QXX_OK;
+    w25qxx_cache_slot_t *slot;
+
+    while ((slot = w25qxx_cache_oldest_dirty()) != NULL) {
+        if ((last) && ((int32_t)(slot->dirty_seq - last->dirty_seq) > 0)) break;
+        res = w25qxx_cache_writeback(slot);
+        if (res != W25QXX_OK) {
+            if (w25qxx_debug) LOGE("w25qxx_cache", "write back error (%d) at %x", res, slot->addr);
+            break;
+        }
+        if (slot == last) break;
+    }
+    return res;
+}
+
+// Get the cache slot for the sector at 'sector_addr'
+// The least recently used slot is reused, if it is dirty it is written back first
+// If 'load' is false, the slot content is not read from flash (the whole sector will be overwritten)
+//--------------------------------------------------------------------------------------------
+static w25qxx_cache_slot_t *w25qxx_cache_load(uint32_t sector_addr, bool load, enum w25qxx_status_t *res)
+{
+    w25qxx_cache_slot_t *slot = &cache_slots[0];
+    for (int i=0; i<W25QXX_CACHE_SLOTS; i++) {
+        if (!cache_slots[i].valid) {
+            slot = &cache_slots[i];
+            break;
+        }
+        if (cache_slots[i].last_used < slot->last_used) slot = &cache_slots[i];
+    }
+    if ((slot->valid) && (slot->dirty)) {
+        // the sectors dirtied before this one must reach the Flash first
+        *res = w25qxx_cache_writeback_upto(slot);
+        if (*res != W25QXX_OK) return NULL;
+        cache_stats.evictions++;
+    }
+    slot->valid = false;
+    if (load) {
+        *res = w25qxx_read_sector(sector_addr, slot->data);
+        if (*res != W25QXX_OK) return NULL;
+    }
+    slot->addr = sector_addr;
+    slot->valid = true;
+    slot->dirty = false;
+    cache_stats.misses++;
+    *res = W25QXX_OK;
+    return slot;
+}
+
+// Write the data to the cached sector
+//---------------------------------------------------------------------------------------------------------------------------------
+static enum w25qxx_status_t w25qxx_cache_write(uint32_t sector_addr, uint32_t sector_offset, uint8_t *data_buf, uint32_t write_len)
+{
+    enum w25qxx_status_t res = W25QXX_OK;
+    bool fresh = false;
+    w25qxx_cache_slot_t *slot = w25qxx_cache_find(sector_addr);
+
+    if (slot) {
+        cache_stats.hits++;
+        if ((slot->dirty) && (slot->dirty_seq != cache_dirty_count) &&
+            (memcmp(slot->data + sector_offset, data_buf, write_len) != 0)) {
+            // Other sectors were dirtied after this one, merging the write would let it
+            // reach the Flash before them, write them all back first to keep the order
+            res = w25qxx_cache_writeback_upto(NULL);
+            if (res != W25QXX_OK) return res;
+        }
+    }
+    else {
+        fresh = (write_len == w25qxx_FLASH_SECTOR_SIZE);
+        slot = w25qxx_cache_load(sector_addr, !fresh, &res);
+        if (slot == NULL) return res;
+    }
+    if ((fresh) || (memcmp(slot->data + sector_offset, data_buf, write_len) != 0)) {
+        memcpy(slot->data + sector_offset, data_buf, write_len);
+        if (slot->dirty) cache_stats.merged++;
+        else {
+            slot->dirty = true;
+            slot->dirty_seq = ++cache_dirty_count;
+            slot->dirty_time = xTaskGetTickCount();
+        }
+    }
+    slot->last_used = ++cache_use_count;
+    return W25QXX_OK;
+}
+
+// Write all dirty cache slots to flash in the order in which they were dirtied
+// if 'age' > 0 only the slots dirty for more than 'age' ticks are written
+// (and the slots dirtied before them)
+//---------------------------------------------------------------
+static enum w25qxx_status_t _w25qxx_cache_flush(TickType_t age)
+{
+    TickType_t now = xTaskGetTickCount();
+    w25qxx_cache_slot_t *last = NULL;
+
+    if (age == 0) return w25qxx_cache_writeback_upto(NULL);
+
+    for (int i=0; i<W25QXX_CACHE_SLOTS; i++) {
+        if ((cache_slots[i].valid) && (cache_slots[i].dirty) && ((now - cache_slots[i].dirty_time) >= age)) {
+            if ((last == NULL) || ((int32_t)(cache_slots[i].dirty_seq - last->dirty_seq) > 0)) last = &cache_slots[i];
+        }
+    }
+    if (last == NULL) return W25QXX_OK;
+    return w25qxx_cache_writeback_upto(last);
+}
+
+// Low priority task writing back the sectors which were not written for some time
+//---------------------------------------------------
+static void w25qxx_flush_task(void *pvParameter)
+{
+    while (1) {
+        vTaskDelay(W25QXX_CACHE_FLUSH_MS / portTICK_PERIOD_MS);
+        w25qxx_lock();
+        if (!xip_active) _w25qxx_cache_flush(W25QXX_CACHE_FLUSH_MS / portTICK_PERIOD_MS);
+        w25qxx_unlock();
+    }
+    vTaskDelete(NULL);
+}
+
+// Set the flash address range in which the writes are cached (file system area)
+//================================================================
+void w25qxx_cache_set_range(uint32_t start_addr, uint32_t size)
+{
+    w25qxx_lock();
+    _w25qxx_cache_flush(0);
+    for (int i=0; i<W25QXX_CACHE_SLOTS; i++) {
+        cache_slots[i].valid = false;
+        cache_slots[i].dirty = false;
+    }
+    cache_start = start_addr & (~(w25qxx_FLASH_SECTOR_SIZE - 1));
+    cache_end = cache_start + (size & (~(w25qxx_FLASH_SECTOR_SIZE - 1)));
+    if ((cache_end - cache_start) > (W25QXX_MAX_SECTORS * w25qxx_FLASH_SECTOR_SIZE)) {
+        cache_end = cache_start + (W25QXX_MAX_SECTORS * w25qxx_FLASH_SECTOR_SIZE);
+    }
+
+    if (sector_wear) vPortFree(sector_wear);
+    sector_wear = pvPortMalloc(((cache_end - cache_start) / w25qxx_FLASH_SECTOR_SIZE) * sizeof(uint16_t));
+    if (sector_wear) memset(sector_wear, 0, ((cache_end - cache_start) / w25qxx_FLASH_SECTOR_SIZE) * sizeof(uint16_t));
+
+    // erased sectors map is built lazily, the state of all sectors is unknown
+    if (known_map) vPortFree(known_map);
+    if (erased_map) vPortFree(erased_map);
+    known_map = pvPortMalloc(erased_map_words() * sizeof(uint32_t));
+    erased_map = pvPortMalloc(erased_map_words() * sizeof(uint32_t));
+    if ((known_map) && (erased_map)) {
+        memset(known_map, 0, erased_map_words() * sizeof(uint32_t));
+        memset(erased_map, 0, erased_map_words() * sizeof(uint32_t));
+    }
+    else {
+        if (known_map) vPortFree(known_map);
+        if (erased_map) vPortFree(erased_map);
+        known_map = NULL;
+        erased_map = NULL;
+    }
+    cache_stats.max_wear = 0;
+    cache_stats.max_wear_addr = 0;
+
+    if (w25qxx_flush_task_handle == NULL) {
+        BaseType_t res = xTaskCreate(
+                w25qxx_flush_task,              // function entry
+                "w25qxx_flush_task",            // task name
+                configMINIMAL_STACK_SIZE,       // stack_deepth
+                NULL,                           // function argument
+                W25QXX_FLUSH_TASK_PRIORITY,     // task priority
+                &w25qxx_flush_task_handle);     // task handle
+        if (res != pdPASS) w25qxx_flush_task_handle = NULL;
+    }
+    w25qxx_unlock();
+}
+
+//============================================
+enum w25qxx_status_t w25qxx_cache_flush(void)
+{
+    w25qxx_lock();
+    enum w25qxx_status_t res = _w25qxx_cache_flush(0);
+    w25qxx_unlock();
+    return res;
+}
+
+//=====================================================================
+void w25qxx_cache_get_stats(w25qxx_cache_stats_t *stats, bool clear)
+{
+    w25qxx_lock();
+    if (stats) memcpy(stats, &cache_stats, sizeof(w25qxx_cache_stats_t));
+    if (clear) {
+        uint32_t max_wear = cache_stats.max_wear;
+        uint32_t max_wear_addr = cache_stats.max_wear_addr;
+        memset(&cache_stats, 0, sizeof(w25qxx_cache_stats_t));
+        // wear is not cleared, it is the property of the flash sector
+        cache_stats.max_wear = max_wear;
+        cache_stats.max_wear_addr = max_wear_addr;
+    }
+    w25qxx_unlock();
+}
+
+// Get the number of erases of the sector at 'addr' since boot
+//==========================================
+uint32_t w25qxx_sector_wear(uint32_t addr)
+{
+    if ((sector_wear == NULL) || (addr < cache_start) || (addr >= cache_end)) return 0;
+    return sector_wear[(addr - cache_start) / w25qxx_FLASH_SECTOR_SIZE];
+}
+
+// Check if the sector at 'addr' is erased (all bytes 0xFF)
+// The sector is read from flash only if its state is not known
+//==========================================
+bool w25qxx_sector_is_erased(uint32_t addr)
 {
-    uint8_t index;
+    uint32_t sector_addr = addr & (~(w25qxx_FLASH_SECTOR_SIZE - 1));
+    bool erased = false;
 
-    for (index = 0; index < w25qxx_FLASH_PAGE_NUM_PER_SECTOR; index++) {
-        enum w25qxx_status_t res = w25qxx_page_program(addr, data_buf);
+    w25qxx_lock();
+    w25qxx_cache_slot_t *slot = w25qxx_cache_find(sector_addr);
+    if (slot) erased = buffer_is_blank(slot->data, w25qxx_FLASH_SECTOR_SIZE);
+    else if (w25qxx_read_sector(sector_addr, sector_buf) == W25QXX_OK) {
+        erased = buffer_is_blank(sector_buf, w25qxx_FLASH_SECTOR_SIZE);
+    }
+    w25qxx_unlock();
+    return erased;
+}
+
+// Calculate crc32 of the first two sectors of the mapped range
+//-----------------------------------------------------------
+static enum w25qxx_status_t erased_map_fs_crc(uint32_t *crc)
+{
+    *crc = 0;
+    for (int i=0; i<2; i++) {
+        enum w25qxx_status_t res = w25qxx_read_checked(cache_start + (i * w25qxx_FLASH_SECTOR_SIZE), sector_buf, w25qxx_FLASH_SECTOR_SIZE);
         if (res != W25QXX_OK) return res;
-        addr += w25qxx_FLASH_PAGE_SIZE;
-        data_buf += w25qxx_FLASH_PAGE_SIZE;
+        *crc = hal_crc32(sector_buf, w25qxx_FLASH_SECTOR_SIZE, *crc);
     }
     return W25QXX_OK;
 }
 
+// Load the erased sectors map saved in the flash sector at 'map_addr'
+// The saved map is used only once, after loading it is marked as invalid
+// Returns the number of known erased sectors or -1 if no valid map was found
+//=======================================
+int w25qxx_erased_map_load(uint32_t map_addr)
+{
+    erased_map_header_t header;
+    uint32_t *map = NULL;
+    uint32_t crc;
+    int count = -1;
+
+    w25qxx_lock();
+    if ((known_map == NULL) || (w25qxx_read_checked(map_addr, (uint8_t *)&header, sizeof(erased_map_header_t)) != W25QXX_OK)) goto exit;
+    if ((header.magic != W25QXX_ERASED_MAP_MAGIC) || (header.valid != 0xFFFFFFFF) ||
+        (header.start != cache_start) || (header.size != (cache_end - cache_start))) goto exit;
+
+    map = pvPortMalloc(erased_map_words() * sizeof(uint32_t));
+    if (map == NULL) goto exit;
+    if (w25qxx_read_checked(map_addr + sizeof(erased_map_header_t), (uint8_t *)map, erased_map_words() * sizeof(uint32_t)) != W25QXX_OK) goto exit;
+    if (hal_crc32(map, erased_map_words() * sizeof(uint32_t), 0) != header.map_crc) goto exit;
+    // The file system area could be written by other means (flashing the image, for example)
+    if ((erased_map_fs_crc(&crc) != W25QXX_OK) || (crc != header.fs_crc)) {
+        if (w25qxx_debug) LOGW("w25qxx_map", "File system changed, erased map not used");
+    }
+    else {
+        count = 0;
+        for (uint32_t i = 0; i < erased_map_words(); i++) {
+            // only the erased sectors are taken from the saved map, the others are unknown
+            known_map[i] |= map[i];
+            erased_map[i] |= map[i];
+            count += __builtin_popcount(map[i]);
+        }
+    }
+
+    // Invalidate the saved map, only clears bits so no erase is needed
+    if (w25qxx_read_checked(map_addr, sector_buf, w25qxx_FLASH_SECTOR_SIZE) == W25QXX_OK) {
+        uint32_t invalid = 0;
+        w25qxx_sector_update(map_addr, sector_buf, offsetof(erased_map_header_t, valid), (uint8_t *)&invalid, sizeof(uint32_t));
+    }
+    if (w25qxx_debug) LOGD("w25qxx_map", "Erased map loaded, %d erased sectors", count);
+
+exit:
+    if (map) vPortFree(map);
+    w25qxx_unlock();
+    return count;
+}
+
+// Save the erased sectors map to the flash sector at 'map_addr'
+//=================================================================
+enum w25qxx_status_t w25qxx_erased_map_save(uint32_t map_addr)
+{
+    enum w25qxx_status_t res = W25QXX_ERROR;
+    uint32_t size = sizeof(erased_map_header_t) + (erased_map_words() * sizeof(uint32_t));
+    uint8_t *buf = NULL;
+
+    w25qxx_lock();
+    // the map must describe the actual flash content, the cache is flushed even if no map is saved
+    res = _w25qxx_cache_flush(0);
+    if (res != W25QXX_OK) goto exit;
+    if ((known_map == NULL) || (size > w25qxx_FLASH_SECTOR_SIZE)) {
+        res = W25QXX_ERROR;
+        goto exit;
+    }
+
+    buf = pvPortMalloc(size);
+    if (buf == NULL) {
+        res = W25QXX_ERROR;
+        goto exit;
+    }
+    erased_map_header_t *header = (erased_map_header_t *)buf;
+    uint32_t *map = (uint32_t *)(buf + sizeof(erased_map_header_t));
+    memset(header, 0xFF, sizeof(erased_map_header_t));
+    header->magic = W25QXX_ERASED_MAP_MAGIC;
+    header->start = cache_start;
+    header->size = cache_end - cache_start;
+    res = erased_map_fs_crc(&header->fs_crc);
+    if (res != W25QXX_OK) goto exit;
+    for (uint32_t i = 0; i < erased_map_words(); i++) {
+        map[i] = known_map[i] & erased_map[i];
+    }
+    header->map_crc = hal_crc32(map, erased_map_words() * sizeof(uint32_t), 0);
+
+    res = w25qxx_read_checked(map_addr, sector_buf, w25qxx_FLASH_SECTOR_SIZE);
+    if (res == W25QXX_OK) res = w25qxx_sector_update(map_addr, sector_buf, 0, buf, size);
+
+exit:
+    if (buf) vPortFree(buf);
+    w25qxx_unlock();
+    return res;
+}
+
+// ==== Flash read/write API =====================================================================
+
+//======================================================================================
+enum w25qxx_status_t w25qxx_read_data(uint32_t addr, uint8_t* data_buf, uint32_t length)
+{
+    enum w25qxx_status_t res = W25QXX_OK;
+    uint32_t sector_addr, sector_offset, sector_remain, read_len;
+    w25qxx_cache_slot_t *slot;
+    bool all_cached = true;
+
+    w25qxx_lock();
+    if (!w25qxx_in_cache(addr)) {
+        res = w25qxx_read_checked(addr, data_buf, length);
+        w25qxx_unlock();
+        return res;
+    }
+
+    // Check if all data can be read from the cache
+    for (uint32_t pos = 0; pos < length; pos += read_len) {
+        sector_addr = (addr + pos) & (~(w25qxx_FLASH_SECTOR_SIZE - 1));
+        sector_remain = w25qxx_FLASH_SECTOR_SIZE - ((addr + pos) & (w25qxx_FLASH_SECTOR_SIZE - 1));
+        read_len = (length - pos) < sector_remain ? (length - pos) : sector_remain;
+        if (w25qxx_cache_find(sector_addr) == NULL) {
+            all_cached = false;
+            break;
+        }
+    }
+    // If not, read from flash and overlay the cached sectors
+    if (!all_cached) res = w25qxx_read_checked(addr, data_buf, length);
+
+    if (res == W25QXX_OK) {
+        for (uint32_t pos = 0; pos < length; pos += read_len) {
+            sector_addr = (addr + pos) & (~(w25qxx_FLASH_SECTOR_SIZE - 1));
+            sector_offset = (addr + pos) & (w25qxx_FLASH_SECTOR_SIZE - 1);
+            sector_remain = w25qxx_FLASH_SECTOR_SIZE - sector_offset;
+            read_len = (length - pos) < sector_remain ? (length - pos) : sector_remain;
+            slot = w25qxx_cache_find(sector_addr);
+            if ((slot) && ((all_cached) || (slot->dirty))) {
+                memcpy(data_buf + pos, slot->data + sector_offset, read_len);
+                cache_stats.hits++;
+            }
+        }
+    }
+    w25qxx_unlock();
+    return res;
+}
+
+// Erase the flash sector at address 'addr'
+//=====================================================
+enum w25qxx_status_t w25qxx_sector_erase(uint32_t addr)
+{
+    w25qxx_lock();
+    w25qxx_cache_slot_t *slot = w25qxx_cache_find(addr);
+    if (slot) {
+        // the cached sector data is discarded, the slot now holds the erased sector
+        memset(slot->data, 0xFF, w25qxx_FLASH_SECTOR_SIZE);
+        slot->dirty = false;
+    }
+    // the erase goes directly to Flash, the writes cached before it must reach it first
+    enum w25qxx_status_t res = w25qxx_cache_writeback_upto(NULL);
+    if (res == W25QXX_OK) res = _w25qxx_sector_erase(addr);
+    w25qxx_unlock();
+    return res;
+}
+
 // Write data buffer of arbitrary length to flash address 'addr'
+// Writes to the cached address range are written to the sector cache
+// and written to the flash on cache flush or when the cache slot is needed
 //=======================================================================================
 enum w25qxx_status_t w25qxx_write_data(uint32_t addr, uint8_t* data_buf, uint32_t length)
 {
-    uint32_t sector_addr, sector_offset, sector_remain, write_len, index;
-    uint8_t *pread, *pwrite;
-    bool needs_program;
-    enum w25qxx_status_t res;
+    uint32_t sector_addr, sector_offset, sector_remain, write_len;
+    enum w25qxx_status_t res = W25QXX_OK;
 
+    w25qxx_lock();
     // Write all data
     while (length) {
         // Calculate sector address and data offset in the sector
@@ -403,61 +1020,30 @@ enum w25qxx_status_t w25qxx_write_data(uint32_t addr, uint8_t* data_buf, uint32_
         sector_remain = w25qxx_FLASH_SECTOR_SIZE - sector_offset;
         write_len = length < sector_remain ? length : sector_remain;
 
-        res = w25qxx_read_data(sector_addr, swap_buf, w25qxx_FLASH_SECTOR_SIZE);
-        if (res != W25QXX_OK) {
-            if (w25qxx_debug) LOGE("w25qxx_write", "sector read error");
-            return res;
+        if (w25qxx_in_cache(sector_addr)) {
+            res = w25qxx_cache_write(sector_addr, sector_offset, data_buf, write_len);
+            if (res != W25QXX_OK) break;
         }
-        pread = swap_buf + sector_offset;
-        pwrite = data_buf;
-        needs_program = false;
-        // Check if some bits in sector needs to be erased
-        for (index = 0; index < write_len; index++) {
-            if ((*pwrite) != ((*pwrite) & (*pread))) {
-                // Some bits must be set to '1', sector must be erased
-                needs_program = true;
-                if (w25qxx_debug) LOGV("w25qxx_write", "erase sector %x (write at %x, len=%u)", sector_addr, addr, length);
-                if (w25qxx_sector_erase(sector_addr) != W25QXX_OK) {
-                    // This can actually never happen, as the Watchdog will reset the CPU
-                    if (w25qxx_debug) LOGE("w25qxx_write", "sector NOT erased (timeout)");
-                    return W25QXX_BUSY;
-                }
-                if (w25qxx_debug) LOGV("w25qxx_write", "sector %x erased", sector_addr);
-                break;
-            }
-            if (*pwrite != *pread) needs_program = true;
-            pwrite++;
-            pread++;
-        }
-        if (needs_program) {
-            if (write_len == w25qxx_FLASH_SECTOR_SIZE) {
-                // write the whole sector
-                res = w25qxx_sector_program(sector_addr, data_buf);
-            }
-            else  {
-                // modify the sector data and write it
-                pread = swap_buf + sector_offset;
-                pwrite = data_buf;
-                for (index = 0; index < write_len; index++) {
-                    *pread++ = *pwrite++;
-                }
-                res = w25qxx_sector_program(sector_addr, swap_buf);
-            }
+        else {
+            res = w25qxx_read_sector(sector_addr, sector_buf);
             if (res != W25QXX_OK) {
-                if (w25qxx_debug) LOGE("w25qxx_write", "sector program error (%d)", res);
-                return res;
+                if (w25qxx_debug) LOGE("w25qxx_write", "sector read error");
+                break;
             }
+            res = w25qxx_sector_update(sector_addr, sector_buf, sector_offset, data_buf, write_len);
+            if (res != W25QXX_OK) break;
         }
         // advance to the next sector
         length -= write_len;
         addr += write_len;
         data_buf += write_len;
     }
-    return W25QXX_OK;
+    w25qxx_unlock();
+    return res;
 }
 
-//=====================================================================
-uint32_t w25qxx_init(uintptr_t spi_in, uint8_t mode, double clock_rate)
+//----------------------------------------------------------------------------
+static uint32_t _w25qxx_init(uintptr_t spi_in, uint8_t mode, double clock_rate)
 {
     configASSERT(mode < 3);
     work_trans_mode = mode;
@@ -510,6 +1096,21 @@ uint32_t w25qxx_init(uintptr_t spi_in, uint8_t mode, double clock_rate)
     return w25qxx_actual_speed;
 }
 
+//=====================================================================
+uint32_t w25qxx_init(uintptr_t spi_in, uint8_t mode, double clock_rate)
+{
+    if (w25qxx_mutex == NULL) {
+        w25qxx_mutex = xSemaphoreCreateRecursiveMutex();
+        configASSERT(w25qxx_mutex);
+    }
+    w25qxx_lock();
+    // write back the cached sectors before the flash SPI is reconfigured
+    if (spi_adapter) _w25qxx_cache_flush(0);
+    uint32_t res = _w25qxx_init(spi_in, mode, clock_rate);
+    w25qxx_unlock();
+    return res;
+}
+
 
 // ==== Flash special functions ==================================================================
 
@@ -517,7 +1118,12 @@ uint32_t w25qxx_init(uintptr_t spi_in, uint8_t mode, double clock_rate)
 enum w25qxx_status_t w25qxx_enable_xip_mode(void)
 {
     if (!spi_adapter) return W25QXX_ERROR;
+    w25qxx_lock();
+    // XIP reads the flash directly, all cached data must be written first
+    _w25qxx_cache_flush(0);
+    xip_active = true;
     spi_dev_set_xip_mode(spi_adapter, true);
+    w25qxx_unlock();
     return W25QXX_OK;
 }
 
@@ -525,7 +1131,10 @@ enum w25qxx_status_t w25qxx_enable_xip_mode(void)
 enum w25qxx_status_t w25qxx_disable_xip_mode(void)
 {
     if (!spi_adapter) return W25QXX_ERROR;
+    w25qxx_lock();
     spi_dev_set_xip_mode(spi_adapter, false);
+    xip_active = false;
+    w25qxx_unlock();
     return W25QXX_OK;
 }
 
@@ -535,7 +1144,9 @@ enum w25qxx_status_t w25qxx_read_id(uint8_t *manuf_id, uint8_t *device_id)
     uint8_t cmd[4] = {READ_ID, 0x00, 0x00, 0x00};
     uint8_t data[2] = {0};
 
+    w25qxx_lock();
     w25qxx_receive_data(cmd, 4, data, 2);
+    w25qxx_unlock();
     *manuf_id = data[0];
     *device_id = data[1];
     return W25QXX_OK;
@@ -546,7 +1157,9 @@ enum w25qxx_status_t w25qxx_read_jedec_id(uint8_t *jedec_id)
 {
     uint8_t cmd[1] = {READ_JEDEC_ID};
 
+    w25qxx_lock();
     w25qxx_receive_data(cmd, 1, jedec_id, 3);
+    w25qxx_unlock();
     return W25QXX_OK;
 }
 
@@ -555,7 +1168,9 @@ enum w25qxx_status_t w25qxx_read_unique(uint8_t *unique_id)
 {
     uint8_t cmd[5] = {READ_UNIQUE, 0x00, 0x00, 0x00, 0x00};
 
+    w25qxx_lock();
     w25qxx_receive_data(cmd, 5, unique_id, 8);
+    w25qxx_unlock();
     return W25QXX_OK;
 }
 
@@ -21,24 +21,16 @@
 #include <kernel/driver_impl.hpp>
 #include <kpu.h>
 #include <sysctl.h>
-#include <math.h>
-#include <float.h>
-#include <time.h>
-#include <sys/time.h>
 #include <assert.h>
 #include <iomem.h>
-#include <printf.h>
+#include <encoding.h>
+#include <kpu_layers.h>
 
 using namespace sys;
 
-#define KPU_DEBUG 0
 #define NNCASE_DEBUG 0
 #define USE_CACHED_AI_RAM 0
 
-#define min(a, b) (((a) < (b)) ? (a) : (b))
-#define max(a, b) (((a) > (b)) ? (a) : (b))
-#define ALIGN_UP(x, align) ((x + (align - 1)) & (~(align - 1)))
-
 #define COMMON_ENTRY \
     semaphore_lock locker(free_mutex_);
 
@@ -74,6 +66,7 @@ public:
 
             storage_ = std::make_unique<uint8_t[]>(header->main_mem_usage);
             main_buffer_ = { storage_.get(), ptrdiff_t(header->main_mem_usage) };
+            prepare_layers();
         }
         else
         {
@@ -91,7 +84,69 @@ public:
         ctx->output_count = output_count_;
         ctx->outputs = outputs_;
     }
+
+    // Layer run times in CPU cycles, entry 0 is the input transfer, entry n+1 is layer n
+    void set_profile(bool enable)
+    {
+        if (enable && !profile_)
+            profile_ = std::make_unique<uint64_t[]>(layers_length_ + 1);
+        else if (!enable)
+            profile_.reset();
+    }
+
+    uint64_t *profile() { return profile_.get(); }
+    uint32_t profile_length() const { return layers_length_ + 1; }
+
+    // Aligned weights of the fully connected layers, indexed by layer
+    const float *const *layer_weights() const { return layer_weights_.get(); }
 private:
+    // Resolve the weights of the fully connected layers once at load time.
+    // The weights are used in place when they are 4-byte aligned in the model,
+    // otherwise they are copied (with the bias) to an aligned buffer owned by the context.
+    void prepare_layers()
+    {
+        const uint8_t *body = body_start_;
+        size_t copy_size = 0;
+
+        layer_weights_ = std::make_unique<const float *[]>(layers_length_);
+        for (uint32_t i = 0; i < layers_length_; i++)
+        {
+            if (layer_headers_[i].type == KL_FULLY_CONNECTED)
+            {
+                auto arg = (const kpu_model_fully_connected_layer_argument_t *)body;
+                if ((uintptr_t)arg->weights & 3)
+                    copy_size += (arg->in_channels + 1) * arg->out_channels;
+            }
+            body += layer_headers_[i].body_size;
+        }
+
+        if (copy_size)
+            weights_storage_ = std::make_unique<float[]>(copy_size);
+
+        float *copy = weights_storage_.get();
+        body = body_start_;
+        for (uint32_t i = 0; i < layers_length_; i++)
+        {
+            layer_weights_[i] = nullptr;
+            if (layer_headers_[i].type == KL_FULLY_CONNECTED)
+            {
+                auto arg = (const kpu_model_fully_connected_layer_argument_t *)body;
+                if ((uintptr_t)arg->weights & 3)
+                {
+                    size_t size = (arg->in_channels + 1) * arg->out_channels;
+                    memcpy(copy, arg->weights, size * sizeof(float));
+                    layer_weights_[i] = copy;
+                    copy += size;
+                }
+                else
+                {
+                    layer_weights_[i] = arg->weights;
+                }
+            }
+            body += layer_headers_[i].body_size;
+        }
+    }
+
     const uint8_t *model_buffer_;
     const kpu_model_layer_header_t *layer_headers_;
     const uint8_t *body_start_;
@@ -100,6 +155,9 @@ private:
     const kpu_model_output_t * outputs_;
     gsl::span<uint8_t> main_buffer_;
     std::unique_ptr<uint8_t[]> storage_;
+    std::unique_ptr<uint64_t[]> profile_;
+    std::unique_ptr<const float *[]> layer_weights_;
+    std::unique_ptr<float[]> weights_storage_;
 };
 
 class k_kpu_driver : public kpu_driver, public static_object, public free_object_access
@@ -140,6 +198,8 @@ public:
 
         auto model_context = system_handle_to_object(context).as<k_model_context>();
         model_context->get(&ctx_);
+        profile_ = model_context->profile();
+        layer_weights_ = model_context->layer_weights();
         
         ctx_.current_layer = 0;
         ctx_.current_body = ctx_.body_start;
@@ -163,9 +223,8 @@ public:
         const kpu_model_conv_layer_argument_t *first_layer = (const kpu_model_conv_layer_argument_t *)ctx_.body_start;
         kpu_layer_argument_t layer_arg = *(kpu_layer_argument_t *)(ctx_.model_buffer + first_layer->layer_offset);
 
-#if KPU_DEBUG
-        gettimeofday(&last_time_, NULL);
-#endif
+        if (profile_)
+            last_cycle_ = read_csr64(mcycle);
         if ((layer_arg.image_size.data.i_row_wid + 1) % 64 != 0)
         {
             kpu_input_with_padding(&layer_arg, src);
@@ -197,10 +256,37 @@ public:
             }
         }
         done_flag_ = 0;
+        profile_ = nullptr;
+        layer_weights_ = nullptr;
         
         return 0;
     }
 
+    virtual int set_profile(handle_t context, bool enable) override
+    {
+        COMMON_ENTRY;
+        auto model_context = system_handle_to_object(context).as<k_model_context>();
+        model_context->set_profile(enable);
+        return 0;
+    }
+
+    virtual int get_profile(handle_t context, uint32_t *times, size_t count) override
+    {
+        COMMON_ENTRY;
+        auto model_context = system_handle_to_object(context).as<k_model_context>();
+        const uint64_t *profile = model_context->profile();
+        if (!profile)
+            return -1;
+
+        uint64_t cycles_per_us = sysctl_clock_get_freq(SYSCTL_CLOCK_CPU) / 1000000;
+        size_t n = model_context->profile_length();
+        if (n > count)
+            n = count;
+        for (size_t i = 0; i < n; i++)
+            times[i] = profile[i] / cycles_per_us;
+        return n;
+    }
+
     virtual int get_output(handle_t context, uint32_t index, uint8_t **data, size_t *size) override
     {
         COMMON_ENTRY;
@@ -368,433 +454,6 @@ private:
         kpu_upload_core(width, height, channels, src, layer->image_addr.data.image_src_addr);
     }
 
-    void kpu_add(const kpu_model_add_layer_argument_t *arg)
-    {
-        const float *src_a = (const float *)(ctx_.main_buffer + arg->main_mem_in_a_address);
-        const float *src_b = (const float *)(ctx_.main_buffer + arg->main_mem_in_b_address);
-        float *dest = (float *)(ctx_.main_buffer + arg->main_mem_out_address);
-        size_t i, count = arg->count;
-        
-        for (i = 0; i < count; i++)
-            dest[i] = src_a[i] + src_b[i];
-    }
-
-    void kpu_quantized_add(const kpu_model_quant_add_layer_argument_t *arg)
-    {
-        const uint8_t *src_a = (const uint8_t *)(ctx_.main_buffer + arg->main_mem_in_a_address);
-        const uint8_t *src_b = (const uint8_t *)(ctx_.main_buffer + arg->main_mem_in_b_address);
-        size_t count = ALIGN_UP(arg->count, 8) / 8;
-        int64_t off_a = arg->in_a_offset, mul_a = arg->in_a_mul, sh_a = arg->in_a_shift;
-        int64_t off_b = arg->in_b_offset, mul_b = arg->in_b_mul, sh_b = arg->in_b_shift;
-        int64_t off_o = arg->out_offset, mul_o = arg->out_mul, sh_o = arg->out_shift;
-    
-        uint8_t *dest = (uint8_t *)(ctx_.main_buffer + arg->main_mem_out_address);
-        size_t i;
-
-        if (sh_a == sh_b)
-        {
-#define QADD_UNROLL_1(x)     \
-            int64_t a##x = *src_a++; \
-            int64_t b##x = *src_b++;
-        
-#define QADD_UNROLL_2(x) \
-            a##x += off_a; \
-            b##x += off_b;
-        
-#define QADD_UNROLL_3(x) \
-            a##x *= mul_a; \
-            b##x *= mul_b;
-        
-#define QADD_UNROLL_4(x) \
-            int64_t v##x = a##x + b##x;
-        
-#define QADD_UNROLL_5(x) \
-            v##x >>= sh_a;
-        
-#define QADD_UNROLL_6(x) \
-            v##x *= mul_o;
-        
-#define QADD_UNROLL_7(x) \
-            v##x >>= sh_o;
-        
-#define QADD_UNROLL_8(x) \
-            v##x += off_o;
-        
-#define QADD_UNROLL_9(x) \
-            v##x = min(0xFF, max(0, v##x));
-        
-#define QADD_UNROLL_10(x) \
-            *dest++ = v##x;
-        
-#define QADD_UNROLL_S(x) \
-            QADD_UNROLL_##x(0) \
-            QADD_UNROLL_##x(1) \
-            QADD_UNROLL_##x(2) \
-            QADD_UNROLL_##x(3) \
-            QADD_UNROLL_##x(4) \
-            QADD_UNROLL_##x(5) \
-            QADD_UNROLL_##x(6) \
-            QADD_UNROLL_##x(7)
-
-            for (i = 0; i < count; i++)
-            {
-                QADD_UNROLL_S(1);
-                QADD_UNROLL_S(2);
-                QADD_UNROLL_S(3);
-                QADD_UNROLL_S(4);
-                QADD_UNROLL_S(5);
-                QADD_UNROLL_S(6);
-                QADD_UNROLL_S(7);
-                QADD_UNROLL_S(8);
-                QADD_UNROLL_S(9);
-                QADD_UNROLL_S(10);
-            }
-        }
-        else
-        {
-#undef QADD_UNROLL_1
-#define QADD_UNROLL_1(x)     \
-            int64_t a##x = *src_a++; \
-            int64_t b##x = *src_b++;
-
-#undef QADD_UNROLL_2
-#define QADD_UNROLL_2(x) \
-            a##x += off_a; \
-            b##x += off_b;
-
-#undef QADD_UNROLL_3
-#define QADD_UNROLL_3(x) \
-            a##x *= mul_a; \
-            b##x *= mul_b;
-
-#undef QADD_UNROLL_4
-#define QADD_UNROLL_4(x) \
-            a##x >>= sh_a; \
-            b##x >>= sh_b;
-
-#undef QADD_UNROLL_5
-#define QADD_UNROLL_5(x) \
-            int64_t v##x = a##x + b##x;
-
-#undef QADD_UNROLL_6
-#define QADD_UNROLL_6(x) \
-            v##x *= mul_o;
-
-#undef QADD_UNROLL_7
-#define QADD_UNROLL_7(x) \
-            v##x >>= sh_o;
-
-#undef QADD_UNROLL_8
-#define QADD_UNROLL_8(x) \
-            v##x += off_o;
-
-#undef QADD_UNROLL_9
-#define QADD_UNROLL_9(x) \
-            v##x = min(0xFF, max(0, v##x));
-
-#undef QADD_UNROLL_10
-#define QADD_UNROLL_10(x) \
-            *dest++ = v##x;
-
-#undef QADD_UNROLL_S
-#define QADD_UNROLL_S(x) \
-            QADD_UNROLL_##x(0) \
-            QADD_UNROLL_##x(1) \
-            QADD_UNROLL_##x(2) \
-            QADD_UNROLL_##x(3) \
-            QADD_UNROLL_##x(4) \
-            QADD_UNROLL_##x(5) \
-            QADD_UNROLL_##x(6) \
-            QADD_UNROLL_##x(7)
-
-            for (i = 0; i < count; i++)
-            {
-                QADD_UNROLL_S(1);
-                QADD_UNROLL_S(2);
-                QADD_UNROLL_S(3);
-                QADD_UNROLL_S(4);
-                QADD_UNROLL_S(5);
-                QADD_UNROLL_S(6);
-                QADD_UNROLL_S(7);
-                QADD_UNROLL_S(8);
-                QADD_UNROLL_S(9);
-                QADD_UNROLL_S(10);
-            }
-        }
-    }
-
-    void kpu_global_average_pool2d(const kpu_model_gap2d_layer_argument_t *arg)
-    {
-        const float *src = (const float *)(ctx_.main_buffer + arg->main_mem_in_address);
-        float *dest = (float *)(ctx_.main_buffer + arg->main_mem_out_address);
-        size_t oc, channels = arg->channels, kernel_size = arg->kernel_size;
-        
-        for (oc = 0; oc < channels; oc++)
-        {
-            float sum = 0.f;
-            size_t i;
-            for (i = 0; i < kernel_size; i++)
-                sum += *src++;
-
-            dest[oc] = sum / kernel_size;
-        }
-    }
-
-    void kpu_quantized_max_pool2d(const kpu_model_quant_max_pool2d_layer_argument_t *arg)
-    {
-        const uint8_t *src = (const uint8_t *)(ctx_.main_buffer + arg->main_mem_in_address);
-        uint8_t *dest = (uint8_t *)(ctx_.main_buffer + arg->main_mem_out_address);
-        kpu_model_shape_t in_shape = arg->in_shape, out_shape = arg->out_shape;
-        uint32_t kernel_width = arg->kernel_width, kernel_height = arg->kernel_height;
-        uint32_t stride_width = arg->stride_width, stride_height = arg->stride_height;
-        uint32_t padding_width = arg->padding_width, padding_height = arg->padding_height;
-    
-        uint32_t out_y, out_x, oc;
-    
-        for (oc = 0; oc < out_shape.channels; oc++)
-        {
-            const uint8_t *channel_src = src + in_shape.width * in_shape.height * oc;
-            for (out_y = 0; out_y < out_shape.height; out_y++)
-            {
-                for (out_x = 0; out_x < out_shape.width; out_x++)
-                {
-                    int32_t in_x_origin = (int32_t)(out_x * stride_width) - padding_width;
-                    int32_t in_y_origin = (int32_t)(out_y * stride_height) - padding_height;
-                    int32_t kernel_x_start = max(0, -in_x_origin);
-                    int32_t kernel_x_end = min(kernel_width, in_shape.width - in_x_origin);
-                    int32_t kernel_y_start = max(0, -in_y_origin);
-                    int32_t kernel_y_end = min(kernel_height, in_shape.height - in_y_origin);
-                    uint8_t value = 0;
-    
-                    int32_t kernel_y, kernel_x;
-                    for (kernel_y = kernel_y_start; kernel_y < kernel_y_end; kernel_y++)
-                    {
-                        for (kernel_x = kernel_x_start; kernel_x < kernel_x_end; kernel_x++)
-                        {
-                            int32_t in_x = in_x_origin + kernel_x;
-                            int32_t in_y = in_y_origin + kernel_y;
-                            value = max(value, channel_src[in_y * in_shape.width + in_x]);
-                        }
-                    }
-    
-                    *dest++ = value;
-                }
-            }
-        }
-    }
-
-    void kpu_average_pool2d(const kpu_model_ave_pool2d_layer_argument_t *arg)
-    {
-        const float *src = (const float *)(ctx_.main_buffer + arg->main_mem_in_address);
-        float *dest = (float *)(ctx_.main_buffer + arg->main_mem_out_address);
-        kpu_model_shape_t in_shape = arg->in_shape, out_shape = arg->out_shape;
-        uint32_t kernel_width = arg->kernel_width, kernel_height = arg->kernel_height;
-        uint32_t stride_width = arg->stride_width, stride_height = arg->stride_height;
-        uint32_t padding_width = arg->padding_width, padding_height = arg->padding_height;
-    
-        uint32_t out_y, out_x, oc;
-    
-        for (oc = 0; oc < out_shape.channels; oc++)
-        {
-            const float *channel_src = src + in_shape.width * in_shape.height * oc;
-            for (out_y = 0; out_y < out_shape.height; out_y++)
-            {
-                for (out_x = 0; out_x < out_shape.width; out_x++)
-                {
-                    int32_t in_x_origin = (int32_t)(out_x * stride_width) - padding_width;
-                    int32_t in_y_origin = (int32_t)(out_y * stride_height) - padding_height;
-                    int32_t kernel_x_start = max(0, -in_x_origin);
-                    int32_t kernel_x_end = min(kernel_width, in_shape.width - in_x_origin);
-                    int32_t kernel_y_start = max(0, -in_y_origin);
-                    int32_t kernel_y_end = min(kernel_height, in_shape.height - in_y_origin);
-                    float value = 0;
-                    float kernel_count = 0;
-    
-                    int32_t kernel_y, kernel_x;
-                    for (kernel_y = kernel_y_start; kernel_y < kernel_y_end; kernel_y++)
-                    {
-                        for (kernel_x = kernel_x_start; kernel_x < kernel_x_end; kernel_x++)
-                        {
-                            int32_t in_x = in_x_origin + kernel_x;
-                            int32_t in_y = in_y_origin + kernel_y;
-                            value += channel_src[in_y * in_shape.width + in_x];
-                            kernel_count++;
-                        }
-                    }
-    
-                    *dest++ = value / kernel_count;
-                }
-            }
-        }
-    }
-
-    void kpu_quantize(const kpu_model_quantize_layer_argument_t *arg)
-    {
-        size_t count = arg->count;
-        const float *src = (const float *)(ctx_.main_buffer + arg->main_mem_in_address);
-        kpu_model_quant_param_t q = arg->quant_param;
-
-        float scale = 1.f / q.scale;
-
-        uint8_t *dest = (uint8_t *)(ctx_.main_buffer + arg->mem_out_address);
-        size_t i;
-        for (i = 0; i < count; i++)
-        {
-            int value = (*src++ - q.bias) * scale;
-            if (value < 0) value = 0;
-            if (value > 0xFF) value = 0xFF;
-            *dest++ = (uint8_t)value;
-        }
-    }
-
-    void kpu_dequantize(const kpu_model_dequantize_layer_argument_t *arg)
-    {
-        const uint8_t *src = (const uint8_t *)(ctx_.main_buffer + arg->main_mem_in_address);
-        float *dest = (float *)(ctx_.main_buffer + arg->main_mem_out_address);
-        size_t oc, count = arg->count;
-        kpu_model_quant_param_t q = arg->quant_param;
-
-        for (oc = 0; oc < count; oc++)
-            dest[oc] = *src++ * q.scale + q.bias;
-    }
-
-    void kpu_requantize(const kpu_model_requantize_layer_argument_t *arg)
-    {
-        const uint8_t *src = (const uint8_t *)(ctx_.main_buffer + arg->main_mem_in_address);
-        uint8_t *dest = (uint8_t *)(ctx_.main_buffer + arg->main_mem_out_address);
-        size_t oc, count = ALIGN_UP(arg->count, 8) / 8;
-        const uint8_t *table = arg->table;
-        
-		for (oc = 0; oc < count;)
-	    {
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-	    }
-	}
-
-    void kpu_l2_normalization(const kpu_model_l2_norm_layer_argument_t *arg)
-    {
-        const float *src = (const float *)(ctx_.main_buffer + arg->main_mem_in_address);
-        float *dest = (float *)(ctx_.main_buffer + arg->main_mem_out_address);
-        size_t oc, channels = arg->channels;
-
-        float sum = 0.f;
-        const float epsilon = 1e-10f;
-        for (oc = 0; oc < channels; oc++)
-            sum += src[oc] * src[oc];
-        if (sum < epsilon)
-            sum = epsilon;
-        sum = 1.f / sqrtf(sum);
-        for (oc = 0; oc < channels; oc++)
-            dest[oc] = src[oc] * sum;
-    }
-
-    void kpu_softmax(const kpu_model_softmax_layer_argument_t *arg)
-    {
-        const float *src = (const float *)(ctx_.main_buffer + arg->main_mem_in_address);
-        float *dest = (float *)(ctx_.main_buffer + arg->main_mem_out_address);
-        size_t oc, channels = arg->channels;
-    
-        float max = FLT_MIN;
-        for (oc = 0; oc < channels; oc++)
-            max = fmaxf(max, src[oc]);
-    
-        float sum = 0.f;
-        for (oc = 0; oc < channels; oc++)
-        {
-            float value = expf(src[oc] - max);
-            sum += value;
-            dest[oc] = value;
-        }
-            
-        for (oc = 0; oc < channels; oc++)
-            dest[oc] /= sum;
-    }
-
-    void kpu_concat(const kpu_model_concat_layer_argument_t *arg)
-    {
-        uint8_t *dest = (uint8_t *)(ctx_.main_buffer + arg->main_mem_out_address);
-        uint32_t count = arg->input_count, i;
-    
-        for (i = 0; i < count; i++)
-        {
-            kpu_model_memory_range_t input = arg->inputs_mem[i];
-            const uint8_t *src = (const uint8_t *)(ctx_.main_buffer + input.start);
-            memcpy(dest, src, input.size);
-            dest += input.size;
-        }
-    }
-
-    void kpu_fully_connected(const kpu_model_fully_connected_layer_argument_t *arg)
-    {
-        const float *src = (const float *)(ctx_.main_buffer + arg->main_mem_in_address);
-        float *dest = (float *)(ctx_.main_buffer + arg->main_mem_out_address);
-        uint32_t in_channels = arg->in_channels, out_channels = arg->out_channels, ic, oc;
-
-        float *weights = (float *)malloc(out_channels * in_channels);
-        float *bias = (float *)malloc(out_channels);
-        memcpy(weights, arg->weights, out_channels * in_channels * sizeof(float));
-        memcpy(bias, arg->weights + in_channels * out_channels, out_channels * sizeof(float));
-
-        for (oc = 0; oc < out_channels; oc++)
-        {
-            const float *c_weights = weights + oc * in_channels;
-
-            float sum = 0.0f;
-            for (ic = 0; ic < in_channels; ic++)
-                sum += src[ic] * c_weights[ic];
-            dest[oc] = sum + bias[oc];
-        }
-		free(weights);
-		free(bias);
-    }
-
-    void kpu_tf_flatten(const kpu_model_tf_flatten_layer_argument_t *arg)
-    {
-        const float *src = (const float *)(ctx_.main_buffer + arg->main_mem_in_address);
-        float *dest = (float *)(ctx_.main_buffer + arg->main_mem_out_address);
-        kpu_model_shape_t in_shape = arg->shape;
-        uint32_t oc, oy, ox;
-    
-        for (oy = 0; oy < in_shape.height; oy++)
-            for (ox = 0; ox < in_shape.width; ox++)
-                for (oc = 0; oc < in_shape.channels; oc++)
-                    *dest++ = src[(oc * in_shape.height + oy) * in_shape.width + ox];
-    }
-
-    void kpu_resize_nearest_neighbor(const kpu_model_resize_nearest_neighbor_layer_argument_t *arg)
-    {
-        const float *src = (const float *)(ctx_.main_buffer + arg->main_mem_in_address);
-        float *dest = (float *)(ctx_.main_buffer + arg->main_mem_out_address);
-        kpu_model_shape_t in_shape = arg->in_shape;
-        uint32_t out_width = arg->out_width, out_height = arg->out_height;
-        uint32_t oc, oy, ox;
-    
-        float height_scale = (float)in_shape.height / out_height;
-        float width_scale = (float)in_shape.width / out_width;
-    
-        for (oc = 0; oc < in_shape.channels; oc++)
-        {
-            const float *channel_src = src + in_shape.width * in_shape.height * oc;
-            for (oy = 0; oy <out_height; oy++)
-            {
-                uint32_t in_y = (uint32_t)min(floorf(oy * height_scale), in_shape.height - 1);
-                const float *y_origin = channel_src + in_y * in_shape.width;
-                for (ox = 0; ox < out_width; ox++)
-                {
-                    uint32_t in_x = (uint32_t)min(floorf(ox * width_scale), in_shape.width - 1);
-                    *dest++ = y_origin[in_x];
-                }
-            }
-        }
-    }
-
     void kpu_conv(const kpu_model_conv_layer_argument_t *arg)
     {
         volatile kpu_layer_argument_t layer = *(kpu_layer_argument_t *)(ctx_.model_buffer + arg->layer_offset);
@@ -863,16 +522,6 @@ private:
 #endif
     }
 
-    void kpu_remove_padding(const kpu_model_remove_padding_layer_argument_t *arg)
-    {
-        const uint8_t *src = (const uint8_t *)(ctx_.main_buffer + arg->main_mem_in_address);
-        uint8_t *dest = (uint8_t *)(ctx_.main_buffer + arg->main_mem_out_address);
-        uint32_t oc, channels = arg->channels;
-
-        for (oc = 0; oc < channels; oc++)
-            *dest++ = src[oc * 16];
-    }
-
     void kpu_upload(const kpu_model_upload_layer_argument_t *arg)
     {
         size_t width = arg->width;
@@ -882,71 +531,21 @@ private:
         kpu_upload_core(width, height, channels, ctx_.main_buffer + arg->main_mem_in_address, arg->kpu_mem_out_address);
     }
 
-#if KPU_DEBUG
-    const char *str_layer_type(uint32_t type)
+    // Record the time since the last mark as the run time of the profile entry 'index'
+    void profile_mark(uint32_t index)
     {
-        switch (type)
-        {
-            case KL_ADD:
-                return "Add";
-            case KL_QUANTIZED_ADD:
-                return "QuantAdd";
-            case KL_GLOBAL_AVERAGE_POOL2D:
-                return "GAP";
-            case KL_QUANTIZED_MAX_POOL2D:
-                return "QuantMaxPool2d";
-            case KL_AVERAGE_POOL2D:
-                return "AveragePool2d";
-            case KL_QUANTIZE:
-                return "Quantize";
-            case KL_DEQUANTIZE:
-                return "Dequantize";
-            case KL_REQUANTIZE:
-                return "Requantize";
-            case KL_L2_NORMALIZATION:
-                return "L2Norm";
-            case KL_SOFTMAX:
-                return "Softmax";
-            case KL_CONCAT:
-                return "Concat";
-            case KL_QUANTIZED_CONCAT:
-                return "QuantConcat";
-            case KL_FULLY_CONNECTED:
-                return "FullyConnected";
-            case KL_TENSORFLOW_FLATTEN:
-                return "TFFlatten";
-            case KL_RESIZE_NEAREST_NEIGHBOR:
-                return "ResizeNearestNeighbor";
-            case KL_K210_CONV:
-                return "K210Conv";
-            case KL_K210_ADD_PADDING:
-                return "K210AddPad";
-            case KL_K210_REMOVE_PADDING:
-                return "K210RemovePad";
-            case KL_K210_UPLOAD:
-                return "K210Upload";
-            default:
-                return "Unknown";
-        }
+        uint64_t cycle = read_csr64(mcycle);
+        profile_[index] = cycle - last_cycle_;
+        last_cycle_ = cycle;
     }
-#endif
 
     int kpu_done()
     {
         kpu_.interrupt_clear.reg = 0b111;
 
         kpu_.interrupt_mask.reg = 0b111;
-#if KPU_DEBUG
-        uint32_t cnt_layer_id = ctx_.current_layer - 1;
-        gettimeofday(&time_, NULL);
-        if (total_time_ != 0)
-        {
-            uint64_t layer_time = (time_.tv_sec -last_time_.tv_sec) * 1000*1000 + (time_.tv_usec - last_time_.tv_usec);
-            printf("layer %d [%s]: %f ms\n", cnt_layer_id, str_layer_type(last_layer_type_), layer_time / 1000.0);
-            total_time_ += layer_time;
-        }
-        printf("Model: %f ms\n", total_time_ / 1000.0);
-#endif
+        if (profile_)
+            profile_mark(ctx_.layers_length);
 
         done_flag_ = 1;
         return 0;
@@ -959,63 +558,52 @@ private:
         const kpu_model_layer_header_t *cnt_layer_header = ctx_.layer_headers + cnt_layer_id;
         ctx_.current_body += cnt_layer_header->body_size;
 
-#if KPU_DEBUG
-        uint64_t layer_time;
-        gettimeofday(&time_, NULL);
-        layer_time = (time_.tv_sec -last_time_.tv_sec) * 1000*1000 + (time_.tv_usec - last_time_.tv_usec);
-        if(total_time_ == 0)
-            printf("DMA INPUT: %f ms\n", layer_time / 1000.0);
-        else
-            printf("layer %d [%s]: %f ms\n", cnt_layer_id - 1, str_layer_type(last_layer_type_), layer_time / 1000.0);
-        total_time_ += layer_time;
-
-        last_layer_type_ = cnt_layer_header->type;
-        gettimeofday(&last_time_, NULL);
-#endif
+        if (profile_)
+            profile_mark(cnt_layer_id);
         switch (cnt_layer_header->type)
         {
             case KL_ADD:
-                kpu_add((const kpu_model_add_layer_argument_t *)layer_body);
+                kpu_layer_add(ctx_.main_buffer, (const kpu_model_add_layer_argument_t *)layer_body);
                 break;
             case KL_QUANTIZED_ADD:
-                kpu_quantized_add((const kpu_model_quant_add_layer_argument_t *)layer_body);
+                kpu_layer_quantized_add(ctx_.main_buffer, (const kpu_model_quant_add_layer_argument_t *)layer_body);
                 break;
             case KL_GLOBAL_AVERAGE_POOL2D:
-                kpu_global_average_pool2d((const kpu_model_gap2d_layer_argument_t *)layer_body);
+                kpu_layer_global_average_pool2d(ctx_.main_buffer, (const kpu_model_gap2d_layer_argument_t *)layer_body);
                 break;
             case KL_QUANTIZED_MAX_POOL2D:
-                kpu_quantized_max_pool2d((const kpu_model_quant_max_pool2d_layer_argument_t *)layer_body);
+                kpu_layer_quantized_max_pool2d(ctx_.main_buffer, (const kpu_model_quant_max_pool2d_layer_argument_t *)layer_body);
                 break;
             case KL_AVERAGE_POOL2D:
-                kpu_average_pool2d((const kpu_model_ave_pool2d_layer_argument_t *)layer_body);
+                kpu_layer_average_pool2d(ctx_.main_buffer, (const kpu_model_ave_pool2d_layer_argument_t *)layer_body);
                 break;
             case KL_QUANTIZE:
-                kpu_quantize((const kpu_model_quantize_layer_argument_t *)layer_body);
+                kpu_layer_quantize(ctx_.main_buffer, (const kpu_model_quantize_layer_argument_t *)layer_body);
                 break;
             case KL_DEQUANTIZE:
-                kpu_dequantize((const kpu_model_dequantize_layer_argument_t *)layer_body);
+                kpu_layer_dequantize(ctx_.main_buffer, (const kpu_model_dequantize_layer_argument_t *)layer_body);
                 break;
             case KL_REQUANTIZE:
-                kpu_requantize((const kpu_model_requantize_layer_argument_t *)layer_body);
+                kpu_layer_requantize(ctx_.main_buffer, (const kpu_model_requantize_layer_argument_t *)layer_body);
                 break;
             case KL_L2_NORMALIZATION:
-                kpu_l2_normalization((const kpu_model_l2_norm_layer_argument_t *)layer_body);
+                kpu_layer_l2_normalization(ctx_.main_buffer, (const kpu_model_l2_norm_layer_argument_t *)layer_body);
                 break;
             case KL_SOFTMAX:
-                kpu_softmax((const kpu_model_softmax_layer_argument_t *)layer_body);
+                kpu_layer_softmax(ctx_.main_buffer, (const kpu_model_softmax_layer_argument_t *)layer_body);
                 break;
             case KL_CONCAT:
             case KL_QUANTIZED_CONCAT:
-                kpu_concat((const kpu_model_concat_layer_argument_t *)layer_body);
+                kpu_layer_concat(ctx_.main_buffer, (const kpu_model_concat_layer_argument_t *)layer_body);
                 break;
             case KL_FULLY_CONNECTED:
-                kpu_fully_connected((const kpu_model_fully_connected_layer_argument_t *)layer_body);
+                kpu_layer_fully_connected(ctx_.main_buffer, (const kpu_model_fully_connected_layer_argument_t *)layer_body, layer_weights_[cnt_layer_id]);
                 break;
             case KL_TENSORFLOW_FLATTEN:
-                kpu_tf_flatten((const kpu_model_tf_flatten_layer_argument_t *)layer_body);
+                kpu_layer_tf_flatten(ctx_.main_buffer, (const kpu_model_tf_flatten_layer_argument_t *)layer_body);
                 break;
             case KL_RESIZE_NEAREST_NEIGHBOR:
-                kpu_resize_nearest_neighbor((const kpu_model_resize_nearest_neighbor_layer_argument_t *)layer_body);
+                kpu_layer_resize_nearest_neighbor(ctx_.main_buffer, (const kpu_model_resize_nearest_neighbor_layer_argument_t *)layer_body);
                 break;
             case KL_K210_CONV:
                 kpu_conv((const kpu_model_conv_layer_argument_t *)layer_body);
@@ -1024,7 +612,7 @@ private:
                 kpu_add_padding((const kpu_model_add_padding_layer_argument_t *)layer_body);
                 break;
             case KL_K210_REMOVE_PADDING:
-                kpu_remove_padding((const kpu_model_remove_padding_layer_argument_t *)layer_body);
+                kpu_layer_remove_padding(ctx_.main_buffer, (const kpu_model_remove_padding_layer_argument_t *)layer_body);
                 break;
             case KL_K210_UPLOAD:
                 kpu_upload((const kpu_model_upload_layer_argument_t *)layer_body);
@@ -1059,12 +647,9 @@ private:
     size_t dest_len_;
     size_t max_len_;
     uint8_t mem_out_flag_;
-#if KPU_DEBUG
-    struct timeval time_;
-    struct timeval last_time_;
-    uint64_t total_time_ = 0;
-    uint32_t last_layer_type_;
-#endif
+    uint64_t *profile_ = nullptr;
+    uint64_t last_cycle_;
+    const float *const *layer_weights_ = nullptr;
 };
 
 static k_kpu_driver dev0_driver(AI_BASE_ADDR, SYSCTL_CLOCK_AI, SYSCTL_DMA_SELECT_AI_RX_REQ);
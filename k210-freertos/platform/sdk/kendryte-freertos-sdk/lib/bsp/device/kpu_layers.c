@@ -0,0 +1,663 @@
+/* Copyright 2018 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <kpu_layers.h>
+
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#define ALIGN_UP(x, align) ((x + (align - 1)) & (~(align - 1)))
+
+void kpu_layer_add(uint8_t *main_buffer, const kpu_model_add_layer_argument_t *arg)
+{
+    const float *src_a = (const float *)(main_buffer + arg->main_mem_in_a_address);
+    const float *src_b = (const float *)(main_buffer + arg->main_mem_in_b_address);
+    float *dest = (float *)(main_buffer + arg->main_mem_out_address);
+    size_t i, count = arg->count;
+
+    for (i = 0; i < count; i++)
+        dest[i] = src_a[i] + src_b[i];
+}
+
+void kpu_layer_quantized_add(uint8_t *main_buffer, const kpu_model_quant_add_layer_argument_t *arg)
+{
+    const uint8_t *src_a = (const uint8_t *)(main_buffer + arg->main_mem_in_a_address);
+    const uint8_t *src_b = (const uint8_t *)(main_buffer + arg->main_mem_in_b_address);
+    size_t count = ALIGN_UP(arg->count, 8) / 8;
+    int64_t off_a = arg->in_a_offset, mul_a = arg->in_a_mul, sh_a = arg->in_a_shift;
+    int64_t off_b = arg->in_b_offset, mul_b = arg->in_b_mul, sh_b = arg->in_b_shift;
+    int64_t off_o = arg->out_offset, mul_o = arg->out_mul, sh_o = arg->out_shift;
+
+    uint8_t *dest = (uint8_t *)(main_buffer + arg->main_mem_out_address);
+    size_t i;
+
+    if (sh_a == sh_b)
+    {
+#define QADD_UNROLL_1(x)     \
+        int64_t a##x = *src_a++; \
+        int64_t b##x = *src_b++;
+
+#define QADD_UNROLL_2(x) \
+        a##x += off_a; \
+        b##x += off_b;
+
+#define QADD_UNROLL_3(x) \
+        a##x *= mul_a; \
+        b##x *= mul_b;
+
+#define QADD_UNROLL_4(x) \
+        int64_t v##x = a##x + b##x;
+
+#define QADD_UNROLL_5(x) \
+        v##x >>= sh_a;
+
+#define QADD_UNROLL_6(x) \
+        v##x *= mul_o;
+
+#define QADD_UNROLL_7(x) \
+        v##x >>= sh_o;
+
+#define QADD_UNROLL_8(x) \
+        v##x += off_o;
+
+#define QADD_UNROLL_9(x) \
+        v##x = min(0xFF, max(0, v##x));
+
+#define QADD_UNROLL_10(x) \
+        *dest++ = v##x;
+
+#define QADD_UNROLL_S(x) \
+        QADD_UNROLL_##x(0) \
+        QADD_UNROLL_##x(1) \
+        QADD_UNROLL_##x(2) \
+        QADD_UNROLL_##x(3) \
+        QADD_UNROLL_##x(4) \
+        QADD_UNROLL_##x(5) \
+        QADD_UNROLL_##x(6) \
+        QADD_UNROLL_##x(7)
+
+        for (i = 0; i < count; i++)
+        {
+            QADD_UNROLL_S(1);
+            QADD_UNROLL_S(2);
+            QADD_UNROLL_S(3);
+            QADD_UNROLL_S(4);
+            QADD_UNROLL_S(5);
+            QADD_UNROLL_S(6);
+            QADD_UNROLL_S(7);
+            QADD_UNROLL_S(8);
+            QADD_UNROLL_S(9);
+            QADD_UNROLL_S(10);
+        }
+    }
+    else
+    {
+#undef QADD_UNROLL_1
+#define QADD_UNROLL_1(x)     \
+        int64_t a##x = *src_a++; \
+        int64_t b##x = *src_b++;
+
+#undef QADD_UNROLL_2
+#define QADD_UNROLL_2(x) \
+        a##x += off_a; \
+        b##x += off_b;
+
+#undef QADD_UNROLL_3
+#define QADD_UNROLL_3(x) \
+        a##x *= mul_a; \
+        b##x *= mul_b;
+
+#undef QADD_UNROLL_4
+#define QADD_UNROLL_4(x) \
+        a##x >>= sh_a; \
+        b##x >>= sh_b;
+
+#undef QADD_UNROLL_5
+#define QADD_UNROLL_5(x) \
+        int64_t v##x = a##x + b##x;
+
+#undef QADD_UNROLL_6
+#define QADD_UNROLL_6(x) \
+        v##x *= mul_o;
+
+#undef QADD_UNROLL_7
+#define QADD_UNROLL_7(x) \
+        v##x >>= sh_o;
+
+#undef QADD_UNROLL_8
+#define QADD_UNROLL_8(x) \
+        v##x += off_o;
+
+#undef QADD_UNROLL_9
+#define QADD_UNROLL_9(x) \
+        v##x = min(0xFF, max(0, v##x));
+
+#undef QADD_UNROLL_10
+#define QADD_UNROLL_10(x) \
+        *dest++ = v##x;
+
+#undef QADD_UNROLL_S
+#define QADD_UNROLL_S(x) \
+        QADD_UNROLL_##x(0) \
+        QADD_UNROLL_##x(1) \
+        QADD_UNROLL_##x(2) \
+        QADD_UNROLL_##x(3) \
+        QADD_UNROLL_##x(4) \
+        QADD_UNROLL_##x(5) \
+        QADD_UNROLL_##x(6) \
+        QADD_UNROLL_##x(7)
+
+        for (i = 0; i < count; i++)
+        {
+            QADD_UNROLL_S(1);
+            QADD_UNROLL_S(2);
+            QADD_UNROLL_S(3);
+            QADD_UNROLL_S(4);
+            QADD_UNROLL_S(5);
+            QADD_UNROLL_S(6);
+            QADD_UNROLL_S(7);
+            QADD_UNROLL_S(8);
+            QADD_UNROLL_S(9);
+            QADD_UNROLL_S(10);
+        }
+    }
+}
+
+void kpu_layer_global_average_pool2d(uint8_t *main_buffer, const kpu_model_gap2d_layer_argument_t *arg)
+{
+    const float *src = (const float *)(main_buffer + arg->main_mem_in_address);
+    float *dest = (float *)(main_buffer + arg->main_mem_out_address);
+    size_t oc, channels = arg->channels, kernel_size = arg->kernel_size;
+
+    for (oc = 0; oc < channels; oc++)
+    {
+        float sum = 0.f;
+        size_t i;
+        for (i = 0; i < kernel_size; i++)
+            sum += *src++;
+
+        dest[oc] = sum / kernel_size;
+    }
+}
+
+static inline float kpu_float_activation(float value, kpu_model_activation_t act)
+{
+    switch (act)
+    {
+        case KLA_RELU:
+            return value < 0.f ? 0.f : value;
+        case KLA_RELU6:
+            return value < 0.f ? 0.f : (value > 6.f ? 6.f : value);
+        default:
+            return value;
+    }
+}
+
+/* Range [start, end) of the output positions whose pooling window lies completely inside the input,
+ * only the positions outside of it need the window clipped to the input borders */
+static void kpu_pool_inner_range(uint32_t out_size, uint32_t in_size, uint32_t kernel, uint32_t stride, uint32_t padding, uint32_t *start, uint32_t *end)
+{
+    uint32_t first = (padding + stride - 1) / stride;
+    uint32_t last = (in_size + padding >= kernel) ? ((in_size + padding - kernel) / stride + 1) : 0;
+
+    *end = min(last, out_size);
+    *start = min(first, *end);
+}
+
+static uint8_t kpu_max_pool_clipped(const uint8_t *channel_src, kpu_model_shape_t in_shape, int32_t in_x_origin, int32_t in_y_origin, uint32_t kernel_width, uint32_t kernel_height)
+{
+    int32_t kernel_x_start = max(0, -in_x_origin);
+    int32_t kernel_x_end = min((int32_t)kernel_width, (int32_t)in_shape.width - in_x_origin);
+    int32_t kernel_y_start = max(0, -in_y_origin);
+    int32_t kernel_y_end = min((int32_t)kernel_height, (int32_t)in_shape.height - in_y_origin);
+    uint8_t value = 0;
+
+    int32_t kernel_y, kernel_x;
+    for (kernel_y = kernel_y_start; kernel_y < kernel_y_end; kernel_y++)
+    {
+        const uint8_t *row = channel_src + (in_y_origin + kernel_y) * (int32_t)in_shape.width + in_x_origin;
+        for (kernel_x = kernel_x_start; kernel_x < kernel_x_end; kernel_x++)
+            value = max(value, row[kernel_x]);
+    }
+
+    return value;
+}
+
+void kpu_layer_quantized_max_pool2d(uint8_t *main_buffer, const kpu_model_quant_max_pool2d_layer_argument_t *arg)
+{
+    const uint8_t *src = (const uint8_t *)(main_buffer + arg->main_mem_in_address);
+    uint8_t *dest = (uint8_t *)(main_buffer + arg->main_mem_out_address);
+    kpu_model_shape_t in_shape = arg->in_shape, out_shape = arg->out_shape;
+    uint32_t kernel_width = arg->kernel_width, kernel_height = arg->kernel_height;
+    uint32_t stride_width = arg->stride_width, stride_height = arg->stride_height;
+    uint32_t padding_width = arg->padding_width, padding_height = arg->padding_height;
+    uint32_t width = in_shape.width;
+    uint32_t x_start, x_end, y_start, y_end;
+
+    kpu_pool_inner_range(out_shape.width, in_shape.width, kernel_width, stride_width, padding_width, &x_start, &x_end);
+    kpu_pool_inner_range(out_shape.height, in_shape.height, kernel_height, stride_height, padding_height, &y_start, &y_end);
+
+    uint32_t out_y, out_x, oc;
+
+    for (oc = 0; oc < out_shape.channels; oc++)
+    {
+        const uint8_t *channel_src = src + in_shape.width * in_shape.height * oc;
+        for (out_y = 0; out_y < out_shape.height; out_y++)
+        {
+            int32_t in_y_origin = (int32_t)(out_y * stride_height) - padding_height;
+
+            if (out_y < y_start || out_y >= y_end)
+            {
+                for (out_x = 0; out_x < out_shape.width; out_x++)
+                    *dest++ = kpu_max_pool_clipped(channel_src, in_shape, (int32_t)(out_x * stride_width) - padding_width, in_y_origin, kernel_width, kernel_height);
+                continue;
+            }
+
+            for (out_x = 0; out_x < x_start; out_x++)
+                *dest++ = kpu_max_pool_clipped(channel_src, in_shape, (int32_t)(out_x * stride_width) - padding_width, in_y_origin, kernel_width, kernel_height);
+
+            const uint8_t *p = channel_src + in_y_origin * width + (x_start * stride_width - padding_width);
+            if (kernel_width == 2 && kernel_height == 2)
+            {
+                for (out_x = x_start; out_x < x_end; out_x++, p += stride_width)
+                {
+                    uint8_t v0 = max(p[0], p[1]);
+                    uint8_t v1 = max(p[width], p[width + 1]);
+                    *dest++ = max(v0, v1);
+                }
+            }
+            else if (kernel_width == 3 && kernel_height == 3)
+            {
+                for (out_x = x_start; out_x < x_end; out_x++, p += stride_width)
+                {
+                    const uint8_t *p1 = p + width, *p2 = p1 + width;
+                    uint8_t v0 = max(max(p[0], p[1]), p[2]);
+                    uint8_t v1 = max(max(p1[0], p1[1]), p1[2]);
+                    uint8_t v2 = max(max(p2[0], p2[1]), p2[2]);
+                    *dest++ = max(max(v0, v1), v2);
+                }
+            }
+            else
+            {
+                for (out_x = x_start; out_x < x_end; out_x++, p += stride_width)
+                {
+                    const uint8_t *row = p;
+                    uint8_t value = 0;
+                    uint32_t kernel_y, kernel_x;
+                    for (kernel_y = 0; kernel_y < kernel_height; kernel_y++, row += width)
+                    {
+                        for (kernel_x = 0; kernel_x < kernel_width; kernel_x++)
+                            value = max(value, row[kernel_x]);
+                    }
+                    *dest++ = value;
+                }
+            }
+
+            for (out_x = x_end; out_x < out_shape.width; out_x++)
+                *dest++ = kpu_max_pool_clipped(channel_src, in_shape, (int32_t)(out_x * stride_width) - padding_width, in_y_origin, kernel_width, kernel_height);
+        }
+    }
+}
+
+/* The padding is not counted, at the borders the average is taken over the part of the window inside the input */
+static float kpu_average_pool_clipped(const float *channel_src, kpu_model_shape_t in_shape, int32_t in_x_origin, int32_t in_y_origin, uint32_t kernel_width, uint32_t kernel_height)
+{
+    int32_t kernel_x_start = max(0, -in_x_origin);
+    int32_t kernel_x_end = min((int32_t)kernel_width, (int32_t)in_shape.width - in_x_origin);
+    int32_t kernel_y_start = max(0, -in_y_origin);
+    int32_t kernel_y_end = min((int32_t)kernel_height, (int32_t)in_shape.height - in_y_origin);
+    float value = 0;
+    float kernel_count = 0;
+
+    int32_t kernel_y, kernel_x;
+    for (kernel_y = kernel_y_start; kernel_y < kernel_y_end; kernel_y++)
+    {
+        const float *row = channel_src + (in_y_origin + kernel_y) * (int32_t)in_shape.width + in_x_origin;
+        for (kernel_x = kernel_x_start; kernel_x < kernel_x_end; kernel_x++)
+        {
+            value += row[kernel_x];
+            kernel_count++;
+        }
+    }
+
+    return value / kernel_count;
+}
+
+void kpu_layer_average_pool2d(uint8_t *main_buffer, const kpu_model_ave_pool2d_layer_argument_t *arg)
+{
+    const float *src = (const float *)(main_buffer + arg->main_mem_in_address);
+    float *dest = (float *)(main_buffer + arg->main_mem_out_address);
+    kpu_model_shape_t in_shape = arg->in_shape, out_shape = arg->out_shape;
+    uint32_t kernel_width = arg->kernel_width, kernel_height = arg->kernel_height;
+    uint32_t stride_width = arg->stride_width, stride_height = arg->stride_height;
+    uint32_t padding_width = arg->padding_width, padding_height = arg->padding_height;
+    kpu_model_activation_t act = arg->act;
+    uint32_t width = in_shape.width;
+    uint32_t x_start, x_end, y_start, y_end;
+    float scale = 1.f / (kernel_width * kernel_height);
+
+    kpu_pool_inner_range(out_shape.width, in_shape.width, kernel_width, stride_width, padding_width, &x_start, &x_end);
+    kpu_pool_inner_range(out_shape.height, in_shape.height, kernel_height, stride_height, padding_height, &y_start, &y_end);
+
+    uint32_t out_y, out_x, oc;
+
+    for (oc = 0; oc < out_shape.channels; oc++)
+    {
+        const float *channel_src = src + in_shape.width * in_shape.height * oc;
+        for (out_y = 0; out_y < out_shape.height; out_y++)
+        {
+            int32_t in_y_origin = (int32_t)(out_y * stride_height) - padding_height;
+            float *row_dest = dest;
+
+            if (out_y < y_start || out_y >= y_end)
+            {
+                for (out_x = 0; out_x < out_shape.width; out_x++)
+                    *dest++ = kpu_average_pool_clipped(channel_src, in_shape, (int32_t)(out_x * stride_width) - padding_width, in_y_origin, kernel_width, kernel_height);
+            }
+            else
+            {
+                for (out_x = 0; out_x < x_start; out_x++)
+                    *dest++ = kpu_average_pool_clipped(channel_src, in_shape, (int32_t)(out_x * stride_width) - padding_width, in_y_origin, kernel_width, kernel_height);
+
+                const float *p = channel_src + in_y_origin * width + (x_start * stride_width - padding_width);
+                if (kernel_width == 2 && kernel_height == 2)
+                {
+                    for (out_x = x_start; out_x < x_end; out_x++, p += stride_width)
+                        *dest++ = ((p[0] + p[1]) + (p[width] + p[width + 1])) * scale;
+                }
+                else if (kernel_width == 3 && kernel_height == 3)
+                {
+                    for (out_x = x_start; out_x < x_end; out_x++, p += stride_width)
+                    {
+                        const float *p1 = p + width, *p2 = p1 + width;
+                        *dest++ = ((p[0] + p[1] + p[2]) + (p1[0] + p1[1] + p1[2]) + (p2[0] + p2[1] + p2[2])) * scale;
+                    }
+                }
+                else
+                {
+                    for (out_x = x_start; out_x < x_end; out_x++, p += stride_width)
+                    {
+                        const float *row = p;
+                        float value = 0;
+                        uint32_t kernel_y, kernel_x;
+                        for (kernel_y = 0; kernel_y < kernel_height; kernel_y++, row += width)
+                        {
+                            for (kernel_x = 0; kernel_x < kernel_width; kernel_x++)
+                                value += row[kernel_x];
+                        }
+                        *dest++ = value * scale;
+                    }
+                }
+
+                for (out_x = x_end; out_x < out_shape.width; out_x++)
+                    *dest++ = kpu_average_pool_clipped(channel_src, in_shape, (int32_t)(out_x * stride_width) - padding_width, in_y_origin, kernel_width, kernel_height);
+            }
+
+            if (act != KLA_LINEAR)
+            {
+                for (; row_dest < dest; row_dest++)
+                    *row_dest = kpu_float_activation(*row_dest, act);
+            }
+        }
+    }
+}
+
+void kpu_layer_quantize(uint8_t *main_buffer, const kpu_model_quantize_layer_argument_t *arg)
+{
+    size_t count = arg->count;
+    const float *src = (const float *)(main_buffer + arg->main_mem_in_address);
+    kpu_model_quant_param_t q = arg->quant_param;
+
+    float scale = 1.f / q.scale;
+
+    uint8_t *dest = (uint8_t *)(main_buffer + arg->mem_out_address);
+    size_t i;
+    for (i = 0; i < count; i++)
+    {
+        int value = (*src++ - q.bias) * scale;
+        if (value < 0) value = 0;
+        if (value > 0xFF) value = 0xFF;
+        *dest++ = (uint8_t)value;
+    }
+}
+
+void kpu_layer_dequantize(uint8_t *main_buffer, const kpu_model_dequantize_layer_argument_t *arg)
+{
+    const uint8_t *src = (const uint8_t *)(main_buffer + arg->main_mem_in_address);
+    float *dest = (float *)(main_buffer + arg->main_mem_out_address);
+    size_t oc, count = arg->count;
+    kpu_model_quant_param_t q = arg->quant_param;
+
+    for (oc = 0; oc < count; oc++)
+        dest[oc] = *src++ * q.scale + q.bias;
+}
+
+void kpu_layer_requantize(uint8_t *main_buffer, const kpu_model_requantize_layer_argument_t *arg)
+{
+    const uint8_t *src = (const uint8_t *)(main_buffer + arg->main_mem_in_address);
+    uint8_t *dest = (uint8_t *)(main_buffer + arg->main_mem_out_address);
+    size_t oc, count = ALIGN_UP(arg->count, 8);
+    const uint8_t *table = arg->table;
+
+    for (oc = 0; oc < count;)
+    {
+        dest[oc++] = table[*src++];
+        dest[oc++] = table[*src++];
+        dest[oc++] = table[*src++];
+        dest[oc++] = table[*src++];
+        dest[oc++] = table[*src++];
+        dest[oc++] = table[*src++];
+        dest[oc++] = table[*src++];
+        dest[oc++] = table[*src++];
+    }
+}
+
+void kpu_layer_l2_normalization(uint8_t *main_buffer, const kpu_model_l2_norm_layer_argument_t *arg)
+{
+    const float *src = (const float *)(main_buffer + arg->main_mem_in_address);
+    float *dest = (float *)(main_buffer + arg->main_mem_out_address);
+    size_t oc, channels = arg->channels;
+
+    float sum = 0.f;
+    const float epsilon = 1e-10f;
+    for (oc = 0; oc < channels; oc++)
+        sum += src[oc] * src[oc];
+    if (sum < epsilon)
+        sum = epsilon;
+    sum = 1.f / sqrtf(sum);
+    for (oc = 0; oc < channels; oc++)
+        dest[oc] = src[oc] * sum;
+}
+
+void kpu_layer_softmax(uint8_t *main_buffer, const kpu_model_softmax_layer_argument_t *arg)
+{
+    const float *src = (const float *)(main_buffer + arg->main_mem_in_address);
+    float *dest = (float *)(main_buffer + arg->main_mem_out_address);
+    size_t oc, channels = arg->channels;
+
+    float max = -FLT_MAX;
+    for (oc = 0; oc < channels; oc++)
+        max = fmaxf(max, src[oc]);
+
+    float sum = 0.f;
+    for (oc = 0; oc < channels; oc++)
+    {
+        float value = expf(src[oc] - max);
+        sum += value;
+        dest[oc] = value;
+    }
+
+    float scale = 1.f / sum;
+    for (oc = 0; oc < channels; oc++)
+        dest[oc] *= scale;
+}
+
+void kpu_layer_concat(uint8_t *main_buffer, const kpu_model_concat_layer_argument_t *arg)
+{
+    uint8_t *dest = (uint8_t *)(main_buffer + arg->main_mem_out_address);
+    uint32_t count = arg->input_count, i;
+
+    for (i = 0; i < count; i++)
+    {
+        kpu_model_memory_range_t input = arg->inputs_mem[i];
+        const uint8_t *src = (const uint8_t *)(main_buffer + input.start);
+        memcpy(dest, src, input.size);
+        dest += input.size;
+    }
+}
+
+/* 'weights' points to the layer weights (out_channels rows of in_channels floats)
+ * followed by the bias, it must be 4-byte aligned.
+ * Four output channels are computed at once to share the input loads,
+ * each sum is still accumulated in input order. */
+void kpu_layer_fully_connected(uint8_t *main_buffer, const kpu_model_fully_connected_layer_argument_t *arg, const float *weights)
+{
+    const float *src = (const float *)(main_buffer + arg->main_mem_in_address);
+    float *dest = (float *)(main_buffer + arg->main_mem_out_address);
+    uint32_t in_channels = arg->in_channels, out_channels = arg->out_channels, ic, oc;
+    kpu_model_activation_t act = arg->act;
+    const float *bias = weights + in_channels * out_channels;
+
+    for (oc = 0; oc + 4 <= out_channels; oc += 4)
+    {
+        const float *w0 = weights + oc * in_channels;
+        const float *w1 = w0 + in_channels;
+        const float *w2 = w1 + in_channels;
+        const float *w3 = w2 + in_channels;
+
+        float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+        for (ic = 0; ic < in_channels; ic++)
+        {
+            float value = src[ic];
+            sum0 += value * w0[ic];
+            sum1 += value * w1[ic];
+            sum2 += value * w2[ic];
+            sum3 += value * w3[ic];
+        }
+        dest[oc] = kpu_float_activation(sum0 + bias[oc], act);
+        dest[oc + 1] = kpu_float_activation(sum1 + bias[oc + 1], act);
+        dest[oc + 2] = kpu_float_activation(sum2 + bias[oc + 2], act);
+        dest[oc + 3] = kpu_float_activation(sum3 + bias[oc + 3], act);
+    }
+
+    for (; oc < out_channels; oc++)
+    {
+        const float *c_weights = weights + oc * in_channels;
+
+        float sum = 0.0f;
+        for (ic = 0; ic < in_channels; ic++)
+            sum += src[ic] * c_weights[ic];
+        dest[oc] = kpu_float_activation(sum + bias[oc], act);
+    }
+}
+
+void kpu_layer_tf_flatten(uint8_t *main_buffer, const kpu_model_tf_flatten_layer_argument_t *arg)
+{
+    const float *src = (const float *)(main_buffer + arg->main_mem_in_address);
+    float *dest = (float *)(main_buffer + arg->main_mem_out_address);
+    kpu_model_shape_t in_shape = arg->shape;
+    uint32_t oc, oy, ox;
+
+    for (oy = 0; oy < in_shape.height; oy++)
+        for (ox = 0; ox < in_shape.width; ox++)
+            for (oc = 0; oc < in_shape.channels; oc++)
+                *dest++ = src[(oc * in_shape.height + oy) * in_shape.width + ox];
+}
+
+void kpu_layer_resize_nearest_neighbor(uint8_t *main_buffer, const kpu_model_resize_nearest_neighbor_layer_argument_t *arg)
+{
+    const float *src = (const float *)(main_buffer + arg->main_mem_in_address);
+    float *dest = (float *)(main_buffer + arg->main_mem_out_address);
+    kpu_model_shape_t in_shape = arg->in_shape;
+    uint32_t out_width = arg->out_width, out_height = arg->out_height;
+    uint32_t oc, oy, ox;
+
+    float height_scale = (float)in_shape.height / out_height;
+    float width_scale = (float)in_shape.width / out_width;
+
+    for (oc = 0; oc < in_shape.channels; oc++)
+    {
+        const float *channel_src = src + in_shape.width * in_shape.height * oc;
+        for (oy = 0; oy <out_height; oy++)
+        {
+            uint32_t in_y = (uint32_t)min(floorf(oy * height_scale), in_shape.height - 1);
+            const float *y_origin = channel_src + in_y * in_shape.width;
+            for (ox = 0; ox < out_width; ox++)
+            {
+                uint32_t in_x = (uint32_t)min(floorf(ox * width_scale), in_shape.width - 1);
+                *dest++ = y_origin[in_x];
+            }
+        }
+    }
+}
+
+void kpu_layer_remove_padding(uint8_t *main_buffer, const kpu_model_remove_padding_layer_argument_t *arg)
+{
+    const uint8_t *src = (const uint8_t *)(main_buffer + arg->main_mem_in_address);
+    uint8_t *dest = (uint8_t *)(main_buffer + arg->main_mem_out_address);
+    uint32_t oc, channels = arg->channels;
+
+    for (oc = 0; oc < channels; oc++)
+        *dest++ = src[oc * 16];
+}
+
+const char *kpu_layer_type_name(uint32_t type)
+{
+    switch (type)
+    {
+        case KL_ADD:
+            return "Add";
+        case KL_QUANTIZED_ADD:
+            return "QuantAdd";
+        case KL_GLOBAL_AVERAGE_POOL2D:
+            return "GAP";
+        case KL_QUANTIZED_MAX_POOL2D:
+            return "QuantMaxPool2d";
+        case KL_AVERAGE_POOL2D:
+            return "AveragePool2d";
+        case KL_QUANTIZE:
+            return "Quantize";
+        case KL_DEQUANTIZE:
+            return "Dequantize";
+        case KL_REQUANTIZE:
+            return "Requantize";
+        case KL_L2_NORMALIZATION:
+            return "L2Norm";
+        case KL_SOFTMAX:
+            return "Softmax";
+        case KL_CONCAT:
+            return "Concat";
+        case KL_QUANTIZED_CONCAT:
+            return "QuantConcat";
+        case KL_FULLY_CONNECTED:
+            return "FullyConnected";
+        case KL_TENSORFLOW_FLATTEN:
+            return "TFFlatten";
+        case KL_RESIZE_NEAREST_NEIGHBOR:
+            return "ResizeNearestNeighbor";
+        case KL_K210_CONV:
+            return "K210Conv";
+        case KL_K210_ADD_PADDING:
+            return "K210AddPad";
+        case KL_K210_REMOVE_PADDING:
+            return "K210RemovePad";
+        case KL_K210_UPLOAD:
+            return "K210Upload";
+        default:
+            return "Unknown";
+    }
+}
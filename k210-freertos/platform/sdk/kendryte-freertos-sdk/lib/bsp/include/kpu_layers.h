@@ -0,0 +1,54 @@
+/* Copyright 2018 Canaan Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * KPU model layers executed on the CPU
+ *
+ * The functions operate on the model main buffer and the layer arguments
+ * from the kmodel only, they do not depend on the KPU hardware or the
+ * operating system and can be built and tested on the host.
+ */
+
+#ifndef _KPU_LAYERS_H
+#define _KPU_LAYERS_H
+#include <stdint.h>
+#include <kpu.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void kpu_layer_add(uint8_t *main_buffer, const kpu_model_add_layer_argument_t *arg);
+void kpu_layer_quantized_add(uint8_t *main_buffer, const kpu_model_quant_add_layer_argument_t *arg);
+void kpu_layer_global_average_pool2d(uint8_t *main_buffer, const kpu_model_gap2d_layer_argument_t *arg);
+void kpu_layer_quantized_max_pool2d(uint8_t *main_buffer, const kpu_model_quant_max_pool2d_layer_argument_t *arg);
+void kpu_layer_average_pool2d(uint8_t *main_buffer, const kpu_model_ave_pool2d_layer_argument_t *arg);
+void kpu_layer_quantize(uint8_t *main_buffer, const kpu_model_quantize_layer_argument_t *arg);
+void kpu_layer_dequantize(uint8_t *main_buffer, const kpu_model_dequantize_layer_argument_t *arg);
+void kpu_layer_requantize(uint8_t *main_buffer, const kpu_model_requantize_layer_argument_t *arg);
+void kpu_layer_l2_normalization(uint8_t *main_buffer, const kpu_model_l2_norm_layer_argument_t *arg);
+void kpu_layer_softmax(uint8_t *main_buffer, const kpu_model_softmax_layer_argument_t *arg);
+void kpu_layer_concat(uint8_t *main_buffer, const kpu_model_concat_layer_argument_t *arg);
+void kpu_layer_fully_connected(uint8_t *main_buffer, const kpu_model_fully_connected_layer_argument_t *arg, const float *weights);
+void kpu_layer_tf_flatten(uint8_t *main_buffer, const kpu_model_tf_flatten_layer_argument_t *arg);
+void kpu_layer_resize_nearest_neighbor(uint8_t *main_buffer, const kpu_model_resize_nearest_neighbor_layer_argument_t *arg);
+void kpu_layer_remove_padding(uint8_t *main_buffer, const kpu_model_remove_padding_layer_argument_t *arg);
+const char *kpu_layer_type_name(uint32_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1038,6 +1038,32 @@ int kpu_run(handle_t context, const uint8_t *src);
  */
 int kpu_get_output(handle_t context, uint32_t index, uint8_t **data, size_t *size);
 
+/**
+ * @brief       Enable or disable the layer run time profiling of the model.
+ *
+ * @param[in]   context         The kpu context handle
+ * @param[in]   enable          Enable profiling
+ *
+ * @return      result
+ *     - 0      Success
+ *     - other  Fail
+ */
+int kpu_set_profile(handle_t context, bool enable);
+
+/**
+ * @brief       Get the layer run times of the last model run.
+ *
+ * @param[in]   context         The kpu context handle
+ * @param[out]  times           The run times in microseconds, the first entry is the input transfer time,
+ *                              followed by the run time of each layer
+ * @param[in]   count           The number of entries in 'times'
+ *
+ * @return      result
+ *     - -1     Profiling not enabled
+ *     - other  The number of entries written
+ */
+int kpu_get_profile(handle_t context, uint32_t *times, size_t count);
+
 #ifdef __cplusplus
 }
 #endif
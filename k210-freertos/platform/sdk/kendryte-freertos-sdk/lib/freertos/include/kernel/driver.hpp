@@ -375,6 +375,8 @@ public:
     virtual handle_t model_load_from_buffer(uint8_t *buffer) = 0;
     virtual int run(handle_t context, const uint8_t *src) = 0;
     virtual int get_output(handle_t context, uint32_t index, uint8_t **data, size_t *size) = 0;
+    virtual int set_profile(handle_t context, bool enable) = 0;
+    virtual int get_profile(handle_t context, uint32_t *times, size_t count) = 0;
 };
 
 class custom_driver : public driver
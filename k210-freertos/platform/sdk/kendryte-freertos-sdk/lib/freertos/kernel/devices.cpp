@@ -918,6 +918,18 @@ int kpu_get_output(handle_t context, uint32_t index, uint8_t **data, size_t *siz
     return kpu->get_output(context, index, data, size);
 }
 
+int kpu_set_profile(handle_t context, bool enable)
+{
+    COMMON_ENTRY_FILE(kpu_file_, kpu);
+    return kpu->set_profile(context, enable);
+}
+
+int kpu_get_profile(handle_t context, uint32_t *times, size_t count)
+{
+    COMMON_ENTRY_FILE(kpu_file_, kpu);
+    return kpu->get_profile(context, times, count);
+}
+
 /* HAL */
 
 static uintptr_t pic_file_;
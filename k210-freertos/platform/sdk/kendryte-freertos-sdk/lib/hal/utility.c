@@ -15,6 +15,7 @@
 #include "clint.h"
 #include "sysctl.h"
 #include "utility.h"
+#include <stdbool.h>
 #include <printf.h>
 
 
@@ -148,23 +149,117 @@ void busy_wait(uint64_t millionseconds)
         ;
 }
 
+// Slicing-by-8 CRC tables, generated from the byte lookup tables on first use
+// Table 'n' gives the CRC of the byte followed by 'n' zero bytes,
+// so 8 bytes (one 64-bit load) can be processed in one step
+static uint32_t crc32_slice_table[8][256];
+static uint16_t crc16_slice_table[8][256];
+static uint8_t crc8_slice_table[8][256];
+static volatile bool crc32_slice_ready = false;
+static volatile bool crc16_slice_ready = false;
+static volatile bool crc8_slice_ready = false;
+
+// Generating the tables twice from two tasks is harmless, the same values are written
+//------------------------------------
+static void crc32_slice_init(void)
+{
+    for (int i = 0; i < 256; i++) {
+        crc32_slice_table[0][i] = Crc32LookupTable[i];
+    }
+    for (int n = 1; n < 8; n++) {
+        for (int i = 0; i < 256; i++) {
+            uint32_t crc = crc32_slice_table[n-1][i];
+            crc32_slice_table[n][i] = (crc >> 8) ^ Crc32LookupTable[crc & 0xFF];
+        }
+    }
+    __sync_synchronize();
+    crc32_slice_ready = true;
+}
+
+//------------------------------------
+static void crc16_slice_init(void)
+{
+    for (int i = 0; i < 256; i++) {
+        crc16_slice_table[0][i] = Crc16LookupTable[i];
+    }
+    for (int n = 1; n < 8; n++) {
+        for (int i = 0; i < 256; i++) {
+            uint16_t crc = crc16_slice_table[n-1][i];
+            crc16_slice_table[n][i] = (crc << 8) ^ Crc16LookupTable[crc >> 8];
+        }
+    }
+    __sync_synchronize();
+    crc16_slice_ready = true;
+}
+
+//-----------------------------------
+static void crc8_slice_init(void)
+{
+    for (int i = 0; i < 256; i++) {
+        crc8_slice_table[0][i] = Crc8LookupTable[i];
+    }
+    for (int n = 1; n < 8; n++) {
+        for (int i = 0; i < 256; i++) {
+            crc8_slice_table[n][i] = Crc8LookupTable[crc8_slice_table[n-1][i]];
+        }
+    }
+    __sync_synchronize();
+    crc8_slice_ready = true;
+}
+
+// K210 does not support unaligned access, single bytes are processed
+// until the data pointer is 8-byte aligned, then 8 bytes at a time
 //---------------------------------------------------------------------
 uint8_t hal_crc8(const void* data, size_t length, uint8_t previousCrc8)
 {
     uint8_t crc = previousCrc8;
     const uint8_t *pbuf = (const uint8_t *)data;
+
+    if (length >= 16) {
+        if (!crc8_slice_ready) crc8_slice_init();
+        while ((uintptr_t)pbuf & 7) {
+            crc = Crc8LookupTable[crc ^ *pbuf++];
+            length--;
+        }
+        while (length >= 8) {
+            uint64_t v = *(const uint64_t *)pbuf ^ crc;
+            crc = crc8_slice_table[7][v & 0xFF] ^ crc8_slice_table[6][(v >> 8) & 0xFF] ^
+                  crc8_slice_table[5][(v >> 16) & 0xFF] ^ crc8_slice_table[4][(v >> 24) & 0xFF] ^
+                  crc8_slice_table[3][(v >> 32) & 0xFF] ^ crc8_slice_table[2][(v >> 40) & 0xFF] ^
+                  crc8_slice_table[1][(v >> 48) & 0xFF] ^ crc8_slice_table[0][v >> 56];
+            pbuf += 8;
+            length -= 8;
+        }
+    }
     while (length--) {
         crc = Crc8LookupTable[crc ^ *pbuf++];
     }
     return crc;
 }
 
+// CRC16 is not reflected, the first two bytes of each 8-byte block are combined with the crc
 //-------------------------------------------------------------------------
 uint16_t hal_crc16(const void* data, size_t length, uint16_t previousCrc16)
 {
     uint16_t crc = ~previousCrc16;
     const uint8_t *pbuf = (const uint8_t *)data;
 
+    if (length >= 16) {
+        if (!crc16_slice_ready) crc16_slice_init();
+        while ((uintptr_t)pbuf & 7) {
+            crc = (crc<<8) ^ Crc16LookupTable[((crc>>8) ^ *pbuf++) & 0x00FF];
+            length--;
+        }
+        while (length >= 8) {
+            uint64_t v = *(const uint64_t *)pbuf ^ (uint64_t)((crc >> 8) | ((crc & 0xFF) << 8));
+            crc = crc16_slice_table[7][v & 0xFF] ^ crc16_slice_table[6][(v >> 8) & 0xFF] ^
+                  crc16_slice_table[5][(v >> 16) & 0xFF] ^ crc16_slice_table[4][(v >> 24) & 0xFF] ^
+                  crc16_slice_table[3][(v >> 32) & 0xFF] ^ crc16_slice_table[2][(v >> 40) & 0xFF] ^
+                  crc16_slice_table[1][(v >> 48) & 0xFF] ^ crc16_slice_table[0][v >> 56];
+            pbuf += 8;
+            length -= 8;
+        }
+    }
     while (length--) {
         crc = (crc<<8) ^ Crc16LookupTable[((crc>>8) ^ *pbuf++) & 0x00FF];
     }
@@ -178,10 +273,25 @@ uint32_t hal_crc32(const void* data, size_t length, uint32_t previousCrc32)
   uint32_t crc = ~previousCrc32; // same as previousCrc32 ^ 0xFFFFFFFF
   const uint8_t* current = (const uint8_t*) data;
 
+  if (length >= 16) {
+    if (!crc32_slice_ready) crc32_slice_init();
+    while ((uintptr_t)current & 7) {
+      crc = (crc >> 8) ^ Crc32LookupTable[(crc & 0xFF) ^ *current++];
+      length--;
+    }
+    while (length >= 8) {
+      uint64_t v = *(const uint64_t *)current ^ crc;
+      crc = crc32_slice_table[7][v & 0xFF] ^ crc32_slice_table[6][(v >> 8) & 0xFF] ^
+            crc32_slice_table[5][(v >> 16) & 0xFF] ^ crc32_slice_table[4][(v >> 24) & 0xFF] ^
+            crc32_slice_table[3][(v >> 32) & 0xFF] ^ crc32_slice_table[2][(v >> 40) & 0xFF] ^
+            crc32_slice_table[1][(v >> 48) & 0xFF] ^ crc32_slice_table[0][v >> 56];
+      current += 8;
+      length -= 8;
+    }
+  }
   while (length-- != 0) {
     crc = (crc >> 8) ^ Crc32LookupTable[(crc & 0xFF) ^ *current++];
   }
 
   return ~crc; // same as crc ^ 0xFFFFFFFF
 }
-
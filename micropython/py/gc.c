@@ -215,12 +215,18 @@ bool gc_is_locked(void) {
 STATIC void gc_mark_subtree(size_t block) {
     // Start with the block passed in the argument.
     size_t sp = 0;
+    #if MICROPY_GC_PROFILE
+    size_t n_scanned = 0;
+    #endif
     for (;;) {
         // work out number of consecutive blocks in the chain starting with this one
         size_t n_blocks = 0;
         do {
             n_blocks += 1;
         } while (ATB_GET_KIND(block + n_blocks) == AT_TAIL);
+        #if MICROPY_GC_PROFILE
+        n_scanned += n_blocks;
+        #endif
 
         // check this block's children
         void **ptrs = (void**)PTR_FROM_BLOCK(block);
@@ -250,6 +256,9 @@ STATIC void gc_mark_subtree(size_t block) {
         // pop the next block off the stack
         block = MP_STATE_MEM(gc_stack)[--sp];
     }
+    #if MICROPY_GC_PROFILE
+    gc_profile_scanned(GC_PROFILE_SCAN_HEAP, n_scanned * BYTES_PER_BLOCK);
+    #endif
 }
 
 STATIC void gc_deal_with_stack_overflow(void) {
@@ -270,6 +279,9 @@ STATIC void gc_sweep(void) {
     #if MICROPY_PY_GC_COLLECT_RETVAL
     MP_STATE_MEM(gc_collected) = 0;
     #endif
+    #if MICROPY_GC_ADAPTIVE_THRESHOLD
+    size_t n_live = 0;
+    #endif
     // free unmarked heads and their tails
     int free_tail = 0;
     for (size_t block = 0; block < MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB; block++) {
@@ -312,15 +324,26 @@ STATIC void gc_sweep(void) {
                     memset((void*)PTR_FROM_BLOCK(block), 0, BYTES_PER_BLOCK);
                     #endif
                 }
+                #if MICROPY_GC_ADAPTIVE_THRESHOLD
+                else {
+                    n_live++;
+                }
+                #endif
                 break;
 
             case AT_MARK:
                 DEBUG_GC_printf("gc_sweep [MARK] (%p)\r\n", (void *)PTR_FROM_BLOCK(block));
                 ATB_MARK_TO_HEAD(block);
                 free_tail = 0;
+                #if MICROPY_GC_ADAPTIVE_THRESHOLD
+                n_live++;
+                #endif
                 break;
         }
     }
+    #if MICROPY_GC_ADAPTIVE_THRESHOLD
+    MP_STATE_MEM(gc_live_blocks) = n_live;
+    #endif
 }
 
 void gc_collect_start(void) {
@@ -342,6 +365,9 @@ void gc_collect_start(void) {
     size_t root_end = offsetof(mp_state_ctx_t, vm.qstr_last_chunk);
 
     DEBUG_GC_printf("[GC_COLLECT] root pointers\r\n");
+    #if MICROPY_GC_PROFILE
+    gc_profile_scan_class(GC_PROFILE_SCAN_ROOTS);
+    #endif
     gc_collect_root(ptrs + root_start / sizeof(void*), (root_end - root_start) / sizeof(void*));
 
     mp_obj_t args = MP_GET_ARGS();
@@ -354,6 +380,9 @@ void gc_collect_start(void) {
     if (MP_STATE_THREAD(pystack_enabled)) {
         // Trace root pointers from the Python stack.
         DEBUG_GC_printf("[GC_COLLECT] pystack\r\n");
+        #if MICROPY_GC_PROFILE
+        gc_profile_scan_class(GC_PROFILE_SCAN_PYSTACK);
+        #endif
         ptrs = (void**)(void*)MP_STATE_THREAD(pystack_start);
         gc_collect_root(ptrs, (MP_STATE_THREAD(pystack_cur) - MP_STATE_THREAD(pystack_start)) / sizeof(void*));
     }
@@ -361,6 +390,9 @@ void gc_collect_start(void) {
 
 void gc_collect_root(void **ptrs, size_t len) {
     DEBUG_GC_printf("  --> root at %p, size: %lu (%lu)\r\n", ptrs, len, len*sizeof(void *));
+    #if MICROPY_GC_PROFILE
+    gc_profile_scanned(GC_PROFILE_SCAN_CURRENT, len * sizeof(void*));
+    #endif
     size_t n = 0;
     for (size_t i = 0; i < len; i++) {
         void *ptr = ptrs[i];
@@ -484,6 +516,9 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
     #if MICROPY_GC_ALLOC_THRESHOLD
     if (!collected && MP_STATE_MEM(gc_alloc_amount) >= MP_STATE_MEM(gc_alloc_threshold)) {
         GC_EXIT();
+        #if MICROPY_GC_PROFILE
+        gc_profile_reason(GC_PROFILE_REASON_THRESHOLD);
+        #endif
         gc_collect();
         collected = 1;
         GC_ENTER();
@@ -508,6 +543,9 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
             return NULL;
         }
         DEBUG_printf("gc_alloc(" UINT_FMT "): no free mem, triggering GC\r\n", n_bytes);
+        #if MICROPY_GC_PROFILE
+        gc_profile_reason(GC_PROFILE_REASON_NOMEM);
+        #endif
         gc_collect();
         collected = 1;
         GC_ENTER();
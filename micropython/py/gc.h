@@ -75,4 +75,39 @@ void gc_info(gc_info_t *info);
 void gc_dump_info(void);
 void gc_dump_alloc_table(void);
 
+#if MICROPY_GC_ADAPTIVE_THRESHOLD
+// Adaptive allocation threshold, a port enabling MICROPY_GC_ADAPTIVE_THRESHOLD must implement it.
+// Set the threshold mode ("fixed", "pause" or "occupancy") and its target,
+// in the fixed mode the target is the threshold in bytes (-1 to disable),
+// a target of 0 selects the mode's default.
+void gc_threshold_set(const char *mode, mp_int_t target);
+#endif
+
+#if MICROPY_GC_PROFILE
+// GC profiler, a port enabling MICROPY_GC_PROFILE must implement these functions.
+
+// Reason for the next collection
+enum {
+    GC_PROFILE_REASON_EXPLICIT = 0,     // gc.collect() or called by the port
+    GC_PROFILE_REASON_THRESHOLD,        // allocation threshold reached
+    GC_PROFILE_REASON_NOMEM,            // no free blocks for the allocation
+    GC_PROFILE_REASON_MAX,
+};
+
+// Class of the memory scanned for heap pointers
+enum {
+    GC_PROFILE_SCAN_CURRENT = -1,       // class set by the last gc_profile_scan_class()
+    GC_PROFILE_SCAN_ROOTS = 0,          // root pointers and thread arguments
+    GC_PROFILE_SCAN_PYSTACK,            // Python stacks
+    GC_PROFILE_SCAN_STACK,              // C stacks of the threads
+    GC_PROFILE_SCAN_HEAP,               // heap blocks reachable from the roots
+    GC_PROFILE_SCAN_MAX,
+};
+
+void gc_profile_reason(int reason);
+void gc_profile_scan_class(int scan_class);
+void gc_profile_scanned(int scan_class, size_t n_bytes);
+void gc_profile_alloc(size_t n_bytes, void *site);
+#endif
+
 #endif // MICROPY_INCLUDED_PY_GC_H
@@ -61,6 +61,11 @@
 #define free gc_free
 #define realloc(ptr, n) gc_realloc(ptr, n, true)
 #define realloc_ext(ptr, n, mv) gc_realloc(ptr, n, mv)
+
+#if MICROPY_GC_PROFILE
+// The allocation site is the return address into the caller of the m_ function
+#define GC_PROFILE_ALLOC(n) gc_profile_alloc((n), __builtin_return_address(0))
+#endif
 #else
 
 // GC is disabled.  Use system malloc/realloc/free.
@@ -82,11 +87,16 @@ STATIC void *realloc_ext(void *ptr, size_t n_bytes, bool allow_move) {
 
 #endif // MICROPY_ENABLE_GC
 
+#ifndef GC_PROFILE_ALLOC
+#define GC_PROFILE_ALLOC(n)
+#endif
+
 void *m_malloc(size_t num_bytes) {
     void *ptr = malloc(num_bytes);
     if (ptr == NULL && num_bytes != 0) {
         m_malloc_fail(num_bytes);
     }
+    GC_PROFILE_ALLOC(num_bytes);
 #if MICROPY_MEM_STATS
     MP_STATE_MEM(total_bytes_allocated) += num_bytes;
     MP_STATE_MEM(current_bytes_allocated) += num_bytes;
@@ -98,6 +108,9 @@ void *m_malloc(size_t num_bytes) {
 
 void *m_malloc_maybe(size_t num_bytes) {
     void *ptr = malloc(num_bytes);
+    if (ptr != NULL) {
+        GC_PROFILE_ALLOC(num_bytes);
+    }
 #if MICROPY_MEM_STATS
     MP_STATE_MEM(total_bytes_allocated) += num_bytes;
     MP_STATE_MEM(current_bytes_allocated) += num_bytes;
@@ -113,6 +126,7 @@ void *m_malloc_with_finaliser(size_t num_bytes) {
     if (ptr == NULL && num_bytes != 0) {
         m_malloc_fail(num_bytes);
     }
+    GC_PROFILE_ALLOC(num_bytes);
 #if MICROPY_MEM_STATS
     MP_STATE_MEM(total_bytes_allocated) += num_bytes;
     MP_STATE_MEM(current_bytes_allocated) += num_bytes;
@@ -124,7 +138,21 @@ void *m_malloc_with_finaliser(size_t num_bytes) {
 #endif
 
 void *m_malloc0(size_t num_bytes) {
+    #if MICROPY_GC_PROFILE
+    // don't call m_malloc() so that the caller is recorded as the allocation site
+    void *ptr = malloc(num_bytes);
+    if (ptr == NULL && num_bytes != 0) {
+        m_malloc_fail(num_bytes);
+    }
+    GC_PROFILE_ALLOC(num_bytes);
+    #if MICROPY_MEM_STATS
+    MP_STATE_MEM(total_bytes_allocated) += num_bytes;
+    MP_STATE_MEM(current_bytes_allocated) += num_bytes;
+    UPDATE_PEAK();
+    #endif
+    #else
     void *ptr = m_malloc(num_bytes);
+    #endif
     // If this config is set then the GC clears all memory, so we don't need to.
     #if !MICROPY_GC_CONSERVATIVE_CLEAR
     memset(ptr, 0, num_bytes);
@@ -141,6 +169,7 @@ void *m_realloc(void *ptr, size_t new_num_bytes) {
     if (new_ptr == NULL && new_num_bytes != 0) {
         m_malloc_fail(new_num_bytes);
     }
+    GC_PROFILE_ALLOC(new_num_bytes);
 #if MICROPY_MEM_STATS
     // At first thought, "Total bytes allocated" should only grow,
     // after all, it's *total*. But consider for example 2K block
@@ -166,6 +195,9 @@ void *m_realloc_maybe(void *ptr, size_t old_num_bytes, size_t new_num_bytes, boo
 void *m_realloc_maybe(void *ptr, size_t new_num_bytes, bool allow_move) {
 #endif
     void *new_ptr = realloc_ext(ptr, new_num_bytes, allow_move);
+    if (new_ptr != NULL) {
+        GC_PROFILE_ALLOC(new_num_bytes);
+    }
 #if MICROPY_MEM_STATS
     // At first thought, "Total bytes allocated" should only grow,
     // after all, it's *total*. But consider for example 2K block
@@ -26,6 +26,7 @@
 
 #include "py/mpstate.h"
 #include "py/obj.h"
+#include "py/runtime.h"
 #include "py/gc.h"
 
 #if MICROPY_PY_GC && MICROPY_ENABLE_GC
@@ -76,7 +77,36 @@ STATIC mp_obj_t gc_mem_alloc(void) {
 }
 MP_DEFINE_CONST_FUN_OBJ_0(gc_mem_alloc_obj, gc_mem_alloc);
 
-#if MICROPY_GC_ALLOC_THRESHOLD
+#if MICROPY_GC_ADAPTIVE_THRESHOLD
+// threshold([amount], *, mode, target): setting the amount selects the fixed mode,
+// in the "pause" and "occupancy" modes the port adapts the threshold after each collection
+STATIC mp_obj_t gc_threshold(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_amount, ARG_mode, ARG_target };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_amount, MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_mode, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_target, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[ARG_amount].u_obj != MP_OBJ_NULL) {
+        gc_threshold_set("fixed", mp_obj_get_int(args[ARG_amount].u_obj));
+    } else if (args[ARG_mode].u_obj != MP_OBJ_NULL) {
+        gc_threshold_set(mp_obj_str_get_str(args[ARG_mode].u_obj), args[ARG_target].u_int);
+    } else {
+        if (MP_STATE_MEM(gc_alloc_threshold) == (size_t)-1) {
+            return MP_OBJ_NEW_SMALL_INT(-1);
+        }
+        return mp_obj_new_int(MP_STATE_MEM(gc_alloc_threshold) * MICROPY_BYTES_PER_GC_BLOCK);
+    }
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(gc_threshold_obj, 0, gc_threshold);
+
+// provided by the port, returns the adaptive threshold controller state
+MP_DECLARE_CONST_FUN_OBJ_0(gc_threshold_info_obj);
+#elif MICROPY_GC_ALLOC_THRESHOLD
 STATIC mp_obj_t gc_threshold(size_t n_args, const mp_obj_t *args) {
     if (n_args == 0) {
         if (MP_STATE_MEM(gc_alloc_threshold) == (size_t)-1) {
@@ -106,6 +136,9 @@ STATIC const mp_rom_map_elem_t mp_module_gc_globals_table[] = {
     #if MICROPY_GC_ALLOC_THRESHOLD
     { MP_ROM_QSTR(MP_QSTR_threshold), MP_ROM_PTR(&gc_threshold_obj) },
     #endif
+    #if MICROPY_GC_ADAPTIVE_THRESHOLD
+    { MP_ROM_QSTR(MP_QSTR_threshold_info), MP_ROM_PTR(&gc_threshold_info_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_gc_globals, mp_module_gc_globals_table);
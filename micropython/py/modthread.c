@@ -38,6 +38,8 @@
 #include "modmachine.h"
 #include "mphalport.h"
 #include "gccollect.h"
+#include "ipc_channel.h"
+#include "ipc_rpc.h"
 
 
 /****************************************************************/
@@ -1075,6 +1077,10 @@ STATIC const mp_rom_map_elem_t mp_module_thread_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_ipc_busy),            MP_ROM_PTR(&mod_thread_get_ipc_state_obj) },
     { MP_ROM_QSTR(MP_QSTR_ipc_break),           MP_ROM_PTR(&mod_thread_get_ipc_setexception_obj) },
     { MP_ROM_QSTR(MP_QSTR_ipc_notify),          MP_ROM_PTR(&mod_thread_ipc_notify_obj) },
+    { MP_ROM_QSTR(MP_QSTR_Channel),             MP_ROM_PTR(&mp_thread_channel_type) },
+    { MP_ROM_QSTR(MP_QSTR_rpc_call),            MP_ROM_PTR(&mod_thread_rpc_call_obj) },
+    { MP_ROM_QSTR(MP_QSTR_rpc_register),        MP_ROM_PTR(&mod_thread_rpc_register_obj) },
+    { MP_ROM_QSTR(MP_QSTR_rpc_stats),           MP_ROM_PTR(&mod_thread_rpc_stats_obj) },
 
     { MP_ROM_QSTR(MP_QSTR_IPC_EXEC),            MP_ROM_INT(THREAD_IPC_TYPE_EXECUTE) },
 
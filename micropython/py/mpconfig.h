@@ -148,6 +148,21 @@
 #define MICROPY_GC_ALLOC_THRESHOLD (1)
 #endif
 
+// Whether the port adapts the allocation threshold after each collection,
+// gc.threshold() then also accepts the threshold mode (see gc.h)
+#ifndef MICROPY_GC_ADAPTIVE_THRESHOLD
+#define MICROPY_GC_ADAPTIVE_THRESHOLD (0)
+#endif
+#if MICROPY_GC_ADAPTIVE_THRESHOLD && !MICROPY_GC_ALLOC_THRESHOLD
+#error MICROPY_GC_ADAPTIVE_THRESHOLD requires MICROPY_GC_ALLOC_THRESHOLD
+#endif
+
+// Whether to call the port's GC profiler hooks (see gc.h)
+// on collections, root scanning and allocations
+#ifndef MICROPY_GC_PROFILE
+#define MICROPY_GC_PROFILE (0)
+#endif
+
 // Number of bytes to allocate initially when creating new chunks to store
 // interned string data.  Smaller numbers lead to more chunks being needed
 // and more wastage at the end of the chunk.  Larger numbers lead to wasted
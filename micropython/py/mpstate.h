@@ -93,6 +93,11 @@ typedef struct _mp_state_mem_t {
     size_t gc_alloc_threshold;
     #endif
 
+    #if MICROPY_GC_ADAPTIVE_THRESHOLD
+    // number of blocks in use after the last sweep
+    size_t gc_live_blocks;
+    #endif
+
     size_t gc_last_free_atb_index;
 
     #if MICROPY_PY_GC_COLLECT_RETVAL
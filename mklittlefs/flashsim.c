@@ -0,0 +1,260 @@
+/*
+ * Host side simulator of the K210 SPI Flash (w25qxx driver API)
+ *
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "flashsim.h"
+
+flashsim_timing_t flashsim_timing = {
+    .page_program_us = FLASHSIM_PAGE_PROGRAM_US,
+    .sector_erase_us = FLASHSIM_SECTOR_ERASE_US,
+    .command_us = FLASHSIM_COMMAND_US,
+    .spi_clock = FLASHSIM_SPI_CLOCK,
+};
+
+static uint8_t *flash = NULL;
+static uint32_t flash_size = 0;
+static int flash_fd = -1;
+static flashsim_counters_t counters = {0};
+static uint8_t sector_buf[w25qxx_FLASH_SECTOR_SIZE] __attribute__((aligned (8)));
+
+// === Simulated chip operations ===
+
+//---------------------------------------------
+static uint64_t transfer_time_us(uint32_t bytes)
+{
+    // quad mode, 2 clocks per byte
+    return flashsim_timing.command_us + (((uint64_t)bytes * 2 * 1000000) / flashsim_timing.spi_clock);
+}
+
+//-------------------------------------------------------------------
+static void chip_read(uint32_t addr, uint8_t *data_buf, uint32_t length)
+{
+    memcpy(data_buf, flash + addr, length);
+    counters.read_ops++;
+    counters.read_bytes += length;
+    counters.time_us += transfer_time_us(length);
+}
+
+// Page program can only change bits from '1' to '0'
+//----------------------------------------------------------
+static void chip_page_program(uint32_t addr, const uint8_t *data_buf)
+{
+    for (uint32_t i = 0; i < w25qxx_FLASH_PAGE_SIZE; i++) {
+        flash[addr + i] &= data_buf[i];
+    }
+    counters.program_ops++;
+    counters.program_bytes += w25qxx_FLASH_PAGE_SIZE;
+    counters.time_us += transfer_time_us(w25qxx_FLASH_PAGE_SIZE) + flashsim_timing.page_program_us;
+}
+
+//-------------------------------------------
+static void chip_sector_erase(uint32_t addr)
+{
+    memset(flash + addr, 0xFF, w25qxx_FLASH_SECTOR_SIZE);
+    counters.erase_ops++;
+    counters.time_us += flashsim_timing.command_us + flashsim_timing.sector_erase_us;
+}
+
+// === Simulator management ===
+
+// Create the simulated flash of 'size' bytes
+// If 'image_file' is given, the flash content is memory mapped from that file
+//------------------------------------------------------
+bool flashsim_init(uint32_t size, const char *image_file)
+{
+    flashsim_deinit();
+    size &= ~(w25qxx_FLASH_SECTOR_SIZE - 1);
+    if (size == 0) return false;
+
+    if (image_file) {
+        flash_fd = open(image_file, O_RDWR | O_CREAT, 0644);
+        if (flash_fd < 0) {
+            printf("error: cannot open flash image '%s'\r\n", image_file);
+            return false;
+        }
+        struct stat st;
+        fstat(flash_fd, &st);
+        if ((uint32_t)st.st_size < size) {
+            // new or short image, extend it with erased flash content
+            uint8_t blank[w25qxx_FLASH_SECTOR_SIZE];
+            memset(blank, 0xFF, w25qxx_FLASH_SECTOR_SIZE);
+            lseek(flash_fd, st.st_size & ~(w25qxx_FLASH_SECTOR_SIZE - 1), SEEK_SET);
+            for (uint32_t pos = st.st_size & ~(w25qxx_FLASH_SECTOR_SIZE - 1); pos < size; pos += w25qxx_FLASH_SECTOR_SIZE) {
+                if (write(flash_fd, blank, w25qxx_FLASH_SECTOR_SIZE) != w25qxx_FLASH_SECTOR_SIZE) {
+                    printf("error: cannot write flash image '%s'\r\n", image_file);
+                    close(flash_fd);
+                    flash_fd = -1;
+                    return false;
+                }
+            }
+        }
+        flash = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, flash_fd, 0);
+        if (flash == MAP_FAILED) {
+            printf("error: cannot map flash image '%s'\r\n", image_file);
+            flash = NULL;
+            close(flash_fd);
+            flash_fd = -1;
+            return false;
+        }
+    }
+    else {
+        flash = malloc(size);
+        if (flash == NULL) return false;
+        memset(flash, 0xFF, size);
+    }
+    flash_size = size;
+    flashsim_clear_counters();
+    return true;
+}
+
+//-------------------------
+void flashsim_deinit(void)
+{
+    if (flash == NULL) return;
+    if (flash_fd >= 0) {
+        munmap(flash, flash_size);
+        close(flash_fd);
+        flash_fd = -1;
+    }
+    else free(flash);
+    flash = NULL;
+    flash_size = 0;
+}
+
+//--------------------------
+uint8_t *flashsim_image(void)
+{
+    return flash;
+}
+
+//---------------------------------------------------------
+void flashsim_get_counters(flashsim_counters_t *counters_out)
+{
+    memcpy(counters_out, &counters, sizeof(flashsim_counters_t));
+}
+
+//-------------------------------
+void flashsim_clear_counters(void)
+{
+    memset(&counters, 0, sizeof(flashsim_counters_t));
+}
+
+// === w25qxx driver API ===
+
+//======================================================================================
+enum w25qxx_status_t w25qxx_read_data(uint32_t addr, uint8_t* data_buf, uint32_t length)
+{
+    if ((flash == NULL) || ((addr + length) > flash_size)) return W25QXX_ERROR;
+    chip_read(addr, data_buf, length);
+    return W25QXX_OK;
+}
+
+//=====================================================
+enum w25qxx_status_t w25qxx_sector_erase(uint32_t addr)
+{
+    if ((flash == NULL) || (addr >= flash_size) || (addr % w25qxx_FLASH_SECTOR_SIZE)) return W25QXX_ERROR;
+    chip_sector_erase(addr);
+    return W25QXX_OK;
+}
+
+// Same as the driver: read the sector, erase it only if some bits must be set to '1'
+// and program only the changed pages
+//=======================================================================================
+enum w25qxx_status_t w25qxx_write_data(uint32_t addr, uint8_t* data_buf, uint32_t length)
+{
+    uint32_t sector_addr, sector_offset, sector_remain, write_len;
+
+    if ((flash == NULL) || ((addr + length) > flash_size)) return W25QXX_ERROR;
+
+    while (length) {
+        sector_addr = addr & (~(w25qxx_FLASH_SECTOR_SIZE - 1));
+        sector_offset = addr & (w25qxx_FLASH_SECTOR_SIZE - 1);
+        sector_remain = w25qxx_FLASH_SECTOR_SIZE - sector_offset;
+        write_len = length < sector_remain ? length : sector_remain;
+
+        chip_read(sector_addr, sector_buf, w25qxx_FLASH_SECTOR_SIZE);
+
+        uint32_t changed_pages = 0;
+        bool needs_erase = false;
+        for (uint32_t index = 0; index < write_len; index++) {
+            uint8_t old = sector_buf[sector_offset + index];
+            if (data_buf[index] != old) {
+                changed_pages |= 1 << ((sector_offset + index) / w25qxx_FLASH_PAGE_SIZE);
+                if (data_buf[index] != (data_buf[index] & old)) needs_erase = true;
+            }
+        }
+        if (changed_pages) {
+            memcpy(sector_buf + sector_offset, data_buf, write_len);
+            if (needs_erase) {
+                chip_sector_erase(sector_addr);
+                changed_pages = 0;
+                for (uint32_t page = 0; page < w25qxx_FLASH_PAGE_NUM_PER_SECTOR; page++) {
+                    for (uint32_t index = 0; index < w25qxx_FLASH_PAGE_SIZE; index++) {
+                        if (sector_buf[(page * w25qxx_FLASH_PAGE_SIZE) + index] != 0xFF) {
+                            changed_pages |= 1 << page;
+                            break;
+                        }
+                    }
+                }
+            }
+            for (uint32_t page = 0; page < w25qxx_FLASH_PAGE_NUM_PER_SECTOR; page++) {
+                if (changed_pages & (1 << page)) {
+                    chip_page_program(sector_addr + (page * w25qxx_FLASH_PAGE_SIZE), sector_buf + (page * w25qxx_FLASH_PAGE_SIZE));
+                }
+            }
+        }
+        length -= write_len;
+        addr += write_len;
+        data_buf += write_len;
+    }
+    return W25QXX_OK;
+}
+
+//--------------------------
+void w25qxx_clear_counters()
+{
+    flashsim_clear_counters();
+}
+
+//-----------------------------------------------------------------------------
+void w25qxx_get_counters(uint32_t *r, uint32_t *w, uint32_t *e, uint64_t *time)
+{
+    if (r) *r = counters.read_ops;
+    if (w) *w = counters.program_ops;
+    if (e) *e = counters.erase_ops;
+    if (time) *time = counters.time_us;
+}
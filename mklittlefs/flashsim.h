@@ -0,0 +1,94 @@
+/*
+ * Host side simulator of the K210 SPI Flash (w25qxx driver API)
+ *
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The simulator provides the same read/write/erase API as the w25qxx driver
+ * in 'k210-freertos/platform/drivers/w25qxx.c', backed by a RAM buffer or a
+ * memory mapped image file.
+ * Like the real chip, page program can only clear bits; the write function
+ * erases and reprograms the sector the same way the driver does.
+ * The time needed by the chip for each operation is accumulated, so the
+ * file system code running on top of it can be measured on the host.
+ */
+
+#ifndef _FLASHSIM_H_
+#define _FLASHSIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define w25qxx_FLASH_PAGE_SIZE              256
+#define w25qxx_FLASH_SECTOR_SIZE            4096
+#define w25qxx_FLASH_PAGE_NUM_PER_SECTOR    16
+
+// Default timing, W25Q128JV typical values
+#define FLASHSIM_PAGE_PROGRAM_US            400
+#define FLASHSIM_SECTOR_ERASE_US            45000
+#define FLASHSIM_COMMAND_US                 2
+#define FLASHSIM_SPI_CLOCK                  40000000
+
+enum w25qxx_status_t
+{
+    W25QXX_OK = 0,
+    W25QXX_BUSY,
+    W25QXX_ERROR,
+};
+
+typedef struct _flashsim_timing_t {
+    uint32_t page_program_us;   // time to program one 256 byte page
+    uint32_t sector_erase_us;   // time to erase one 4 KB sector
+    uint32_t command_us;        // command and address overhead of each transfer
+    uint32_t spi_clock;         // SPI clock, quad mode transfers 4 bits per clock
+} flashsim_timing_t;
+
+typedef struct _flashsim_counters_t {
+    uint32_t read_ops;
+    uint32_t program_ops;       // page programs
+    uint32_t erase_ops;         // sector erases
+    uint64_t read_bytes;
+    uint64_t program_bytes;
+    uint64_t time_us;           // simulated flash busy time
+} flashsim_counters_t;
+
+extern flashsim_timing_t flashsim_timing;
+
+bool flashsim_init(uint32_t size, const char *image_file);
+void flashsim_deinit(void);
+uint8_t *flashsim_image(void);
+void flashsim_get_counters(flashsim_counters_t *counters);
+void flashsim_clear_counters(void);
+
+// w25qxx driver API
+enum w25qxx_status_t w25qxx_read_data(uint32_t addr, uint8_t* data_buf, uint32_t length);
+enum w25qxx_status_t w25qxx_write_data(uint32_t addr, uint8_t* data_buf, uint32_t length);
+enum w25qxx_status_t w25qxx_sector_erase(uint32_t addr);
+void w25qxx_clear_counters();
+void w25qxx_get_counters(uint32_t *r, uint32_t *w, uint32_t *e, uint64_t *time);
+
+#endif
@@ -0,0 +1,35 @@
+# Adaptive GC allocation threshold
+#
+# Modes:
+#   'fixed'      collect after 'target' bytes were allocated (default: 4/5 of the heap)
+#   'pause'      adapt the threshold to keep the collection pause below 'target' us
+#   'occupancy'  collect when 'target' percent of the heap is used
+# The default mode can be saved in the configuration:
+#   machine.mpy_config(gc_mode='pause', gc_target=1500)
+
+import gc, utime
+
+def control_step(buf):
+    # allocates some garbage on each step
+    return [x * 2 for x in buf]
+
+gc.threshold(mode='pause', target=1500)
+
+buf = list(range(32))
+max_dt = 0
+for i in range(5000):
+    t = utime.ticks_us()
+    control_step(buf)
+    dt = utime.ticks_diff(utime.ticks_us(), t)
+    if dt > max_dt:
+        max_dt = dt
+    utime.sleep_ms(1)
+
+mode, target, threshold, last_pause, max_pause, live, collections, adjustments, over = gc.threshold_info()
+print('mode={} target={} threshold={} bytes'.format(mode, target, threshold))
+print('pause last={} max={} us, live heap={} bytes'.format(last_pause, max_pause, live))
+print('{} collections, {} threshold changes, {} over the target'.format(collections, adjustments, over))
+print('max control step time: {} us'.format(max_dt))
+
+# back to the fixed threshold
+gc.threshold(mode='fixed')
@@ -0,0 +1,57 @@
+# Passing data blocks to the second MicroPython instance through a shared channel
+#
+# The firmware must be built with two MicroPython instances.
+# The main instance fills the channel slots in place and commits them,
+# the second instance reads them in place and releases them, the data is never copied.
+
+import _thread, utime
+
+SLOT_SIZE = 32 * 1024
+NBLOCKS = 200
+
+CONSUMER = """
+import _thread, utime
+def _consumer():
+    ch = _thread.Channel('blocks')
+    n = 0
+    nbytes = 0
+    errors = 0
+    t = utime.ticks_ms()
+    while True:
+        buf = ch.get()
+        if len(buf) == 1:
+            # end marker
+            ch.release()
+            break
+        if buf[0] != (n & 0xff) or buf[-1] != (n & 0xff):
+            errors += 1
+        n += 1
+        nbytes += len(buf)
+        ch.release()
+    t = utime.ticks_diff(utime.ticks_ms(), t)
+    print('[consumer] {} blocks, {} bytes in {} ms, {} errors'.format(n, nbytes, t, errors))
+    ch.close()
+_thread.start_new_thread('consumer', _consumer, ())
+"""
+
+# Create the channel before the consumer opens it by name
+ch = _thread.Channel('blocks', SLOT_SIZE, 4)
+print(ch)
+_thread.ipc_command(CONSUMER)
+
+t = utime.ticks_ms()
+for i in range(NBLOCKS):
+    buf = ch.claim()          # blocks until a slot is free
+    buf[0] = i & 0xff         # fill the slot in place
+    buf[-1] = i & 0xff
+    ch.commit()               # 'buf' and its slices are not valid any more
+
+# end marker
+buf = ch.claim()
+ch.commit(1)
+print('[producer] {} blocks sent in {} ms'.format(NBLOCKS, utime.ticks_diff(utime.ticks_ms(), t)))
+
+# Wait until the consumer has taken all slots
+while ch.info()[2] > 0:
+    utime.sleep_ms(10)
+ch.close()
@@ -0,0 +1,430 @@
+/*
+ * LittleFS benchmark on simulated K210 SPI Flash
+ *
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The file system is accessed the same way as in 'littleflash.c' on the K210,
+ * through the w25qxx driver API provided by the flash simulator.
+ * Simulated flash time and the number of flash operations per call are reported
+ * for each benchmark, so the file system parameters can be compared on host.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "lfs.h"
+#include "flashsim.h"
+
+static struct lfs_config config = {0};
+static lfs_t lfs = {0};
+
+static uint32_t block_size = 512;
+static uint32_t block_count = (10*1024*1024) / 512;
+static uint32_t cache_size = 0;
+static uint32_t lookahead = 32;
+static uint32_t bench_count = 100;
+static uint32_t spi_clock = FLASHSIM_SPI_CLOCK;
+static bool real_erase = false;
+static char *image_name = NULL;
+
+static uint8_t *read_buffer __attribute__((aligned (8)));
+static uint8_t *prog_buffer __attribute__((aligned (8)));
+static uint8_t *lookahead_buffer __attribute__((aligned (8)));
+
+// === LittleFS flash interface, same as in 'littleflash.c' ===
+
+//-------------------------------------------------------------------------------------------------------------------
+static int internal_read(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size)
+{
+    uint32_t phy_addr = (block * c->block_size) + off;
+    if (w25qxx_read_data(phy_addr, (uint8_t *)buffer, size) != W25QXX_OK) return LFS_ERR_IO;
+    return LFS_ERR_OK;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------
+static int internal_prog(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size)
+{
+    uint32_t phy_addr = (block * c->block_size) + off;
+    if (w25qxx_write_data(phy_addr, (uint8_t *)buffer, size) != W25QXX_OK) return LFS_ERR_IO;
+    return LFS_ERR_OK;
+}
+
+// Used if the block size is the physical sector size
+//----------------------------------------------------------------------
+static int internal_erase(const struct lfs_config *c, lfs_block_t block)
+{
+    uint32_t phy_addr = block * c->block_size;
+    if (w25qxx_sector_erase(phy_addr) != W25QXX_OK) return LFS_ERR_IO;
+    return LFS_ERR_OK;
+}
+
+// Flash driver takes care of erasing the sector when performing program command
+//----------------------------------------------------------------------------
+static int internal_dummy_erase(__attribute__((unused)) const struct lfs_config *c, __attribute__((unused)) lfs_block_t block)
+{
+    return LFS_ERR_OK;
+}
+
+//-------------------------------------------------------------------
+static int internal_sync(__attribute__((unused)) const struct lfs_config *c)
+{
+    return LFS_ERR_OK;
+}
+
+// === Benchmark reporting ===
+
+static flashsim_counters_t bench_start;
+
+//------------------------------
+static void bench_begin(void)
+{
+    flashsim_get_counters(&bench_start);
+}
+
+//-------------------------------------------------------
+static void bench_end(const char *name, uint32_t calls)
+{
+    flashsim_counters_t cnt;
+    flashsim_get_counters(&cnt);
+    uint64_t time_us = cnt.time_us - bench_start.time_us;
+    double n = (calls) ? (double)calls : 1.0;
+
+    printf("%-16s %7u %11.2f %10.1f %8.2f %8.2f %8.2f\r\n", name, calls,
+            (double)time_us / 1000.0, (double)time_us / n,
+            (double)(cnt.read_ops - bench_start.read_ops) / n,
+            (double)(cnt.program_ops - bench_start.program_ops) / n,
+            (double)(cnt.erase_ops - bench_start.erase_ops) / n);
+}
+
+// === Benchmarks ===
+
+// Create 'count' small files in one directory
+//--------------------------------------
+static int bench_create(uint32_t count)
+{
+    lfs_file_t file;
+    char path[64];
+    uint8_t data[64];
+    int err;
+
+    memset(data, 0x5A, sizeof(data));
+    err = lfs_mkdir(&lfs, "/create");
+    if ((err < 0) && (err != LFS_ERR_EXIST)) return err;
+
+    bench_begin();
+    for (uint32_t i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), "/create/file%05u.txt", i);
+        err = lfs_file_open(&lfs, &file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+        if (err < 0) return err;
+        err = lfs_file_write(&lfs, &file, data, sizeof(data));
+        if (err < 0) return err;
+        err = lfs_file_close(&lfs, &file);
+        if (err < 0) return err;
+    }
+    bench_end("create", count);
+    return 0;
+}
+
+// Append 16-byte records to a log file, sync after each record
+//--------------------------------------
+static int bench_append(uint32_t count)
+{
+    lfs_file_t file;
+    uint8_t record[16];
+    int err;
+
+    err = lfs_file_open(&lfs, &file, "/append.log", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND);
+    if (err < 0) return err;
+
+    bench_begin();
+    for (uint32_t i = 0; i < count; i++) {
+        memset(record, (uint8_t)i, sizeof(record));
+        err = lfs_file_write(&lfs, &file, record, sizeof(record));
+        if (err < 0) return err;
+        err = lfs_file_sync(&lfs, &file);
+        if (err < 0) return err;
+    }
+    bench_end("append+sync", count);
+    return lfs_file_close(&lfs, &file);
+}
+
+// Overwrite 16-byte records at random positions of a 64 KB file
+//--------------------------------------------
+static int bench_random_write(uint32_t count)
+{
+    lfs_file_t file;
+    uint8_t buf[256];
+    int err;
+
+    err = lfs_file_open(&lfs, &file, "/random.dat", LFS_O_RDWR | LFS_O_CREAT | LFS_O_TRUNC);
+    if (err < 0) return err;
+    memset(buf, 0, sizeof(buf));
+    for (int i = 0; i < (65536 / (int)sizeof(buf)); i++) {
+        err = lfs_file_write(&lfs, &file, buf, sizeof(buf));
+        if (err < 0) return err;
+    }
+    err = lfs_file_sync(&lfs, &file);
+    if (err < 0) return err;
+
+    srand(1);
+    bench_begin();
+    for (uint32_t i = 0; i < count; i++) {
+        lfs_soff_t pos = (lfs_soff_t)((rand() % (65536 / 16)) * 16);
+        memset(buf, (uint8_t)i, 16);
+        err = lfs_file_seek(&lfs, &file, pos, LFS_SEEK_SET);
+        if (err < 0) return err;
+        err = lfs_file_write(&lfs, &file, buf, 16);
+        if (err < 0) return err;
+        err = lfs_file_sync(&lfs, &file);
+        if (err < 0) return err;
+    }
+    bench_end("random write", count);
+    return lfs_file_close(&lfs, &file);
+}
+
+// Read all files back
+//--------------------------------------
+static int bench_read(uint32_t count)
+{
+    lfs_file_t file;
+    char path[64];
+    uint8_t data[64];
+    int err;
+
+    bench_begin();
+    for (uint32_t i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), "/create/file%05u.txt", i);
+        err = lfs_file_open(&lfs, &file, path, LFS_O_RDONLY);
+        if (err < 0) return err;
+        err = lfs_file_read(&lfs, &file, data, sizeof(data));
+        if (err < 0) return err;
+        err = lfs_file_close(&lfs, &file);
+        if (err < 0) return err;
+    }
+    bench_end("read", count);
+    return 0;
+}
+
+// List the directory and stat each entry, as 'os.ilistdir()' + 'os.stat()' does
+//---------------------------
+static int bench_dirscan(void)
+{
+    lfs_dir_t dir;
+    struct lfs_info info;
+    struct lfs_info finfo;
+    char path[LFS_NAME_MAX + 16];
+    uint32_t entries = 0;
+    int err;
+
+    bench_begin();
+    err = lfs_dir_open(&lfs, &dir, "/create");
+    if (err < 0) return err;
+    while ((err = lfs_dir_read(&lfs, &dir, &info)) > 0) {
+        if (info.type != LFS_TYPE_REG) continue;
+        snprintf(path, sizeof(path), "/create/%s", info.name);
+        err = lfs_stat(&lfs, path, &finfo);
+        if (err < 0) return err;
+        entries++;
+    }
+    if (err < 0) return err;
+    err = lfs_dir_close(&lfs, &dir);
+    bench_end("dir scan+stat", entries);
+    return err;
+}
+
+//---------------------------
+static int run_benchmarks(void)
+{
+    int err;
+
+    config.read = internal_read;
+    config.prog = internal_prog;
+    config.erase = (real_erase) ? internal_erase : internal_dummy_erase;
+    config.sync = internal_sync;
+
+    config.read_size = cache_size;      // LITTLEFS_CFG_RWBLOCK_SIZE
+    config.prog_size = cache_size;      // LITTLEFS_CFG_RWBLOCK_SIZE
+    config.block_size = block_size;     // LITTLEFS_CFG_SECTOR_SIZE
+    config.block_count = block_count;
+    config.cache_size = cache_size;     // LITTLEFS_CFG_SECTOR_SIZE
+    config.lookahead_size = lookahead;  // LITTLEFS_CFG_LOOKAHEAD_SIZE
+    config.block_cycles = 64;           // LITTLEFS_CFG_BLOCK_CYCLES
+
+    read_buffer = malloc(cache_size);
+    prog_buffer = malloc(cache_size);
+    lookahead_buffer = malloc(lookahead);
+    if ((read_buffer == NULL) || (prog_buffer == NULL) || (lookahead_buffer == NULL)) {
+        printf("Error allocating buffers\r\n");
+        return -1;
+    }
+    config.read_buffer = read_buffer;
+    config.prog_buffer = prog_buffer;
+    config.lookahead_buffer = lookahead_buffer;
+
+    flashsim_timing.spi_clock = spi_clock;
+    if (!flashsim_init(block_size * block_count, image_name)) {
+        printf("Error creating simulated flash\r\n");
+        return -1;
+    }
+
+    bench_begin();
+    err = lfs_mount(&lfs, &config);
+    if (err < 0) {
+        err = lfs_format(&lfs, &config);
+        if (err == 0) {
+            bench_end("format", 1);
+            err = lfs_mount(&lfs, &config);
+        }
+    }
+    else bench_end("mount", 1);
+    if (err < 0) {
+        printf("Error mounting file system (%d)\r\n", err);
+        flashsim_deinit();
+        return err;
+    }
+
+    printf("-----------------------------------------------------------------------------\r\n");
+    printf("%-16s %7s %11s %10s %8s %8s %8s\r\n", "Benchmark", "calls", "time [ms]", "us/call", "rd/call", "pg/call", "er/call");
+    printf("-----------------------------------------------------------------------------\r\n");
+
+    err = bench_create(bench_count);
+    if (err == 0) err = bench_append(bench_count);
+    if (err == 0) err = bench_random_write(bench_count);
+    if (err == 0) err = bench_read(bench_count);
+    if (err == 0) err = bench_dirscan();
+    printf("-----------------------------------------------------------------------------\r\n");
+    if (err < 0) printf("Benchmark error (%d)\r\n", err);
+
+    flashsim_counters_t cnt;
+    flashsim_get_counters(&cnt);
+    printf("Total: time=%.2f ms, read=%llu B, programmed=%llu B, erased sectors=%u\r\n",
+            (double)cnt.time_us / 1000.0, (unsigned long long)cnt.read_bytes,
+            (unsigned long long)cnt.program_bytes, cnt.erase_ops);
+
+    int uerr = lfs_unmount(&lfs);
+    if (err == 0) err = uerr;
+    flashsim_deinit();
+    return err;
+}
+
+
+//===============================
+int main(int argc, char **argv) {
+    // parse options
+    int c;
+    char *cvalue = NULL;
+    char *ptr;
+    bool help = false;
+
+    printf("\r\n");
+    while ( (c = getopt(argc, argv, "b:c:C:l:n:s:i:eh")) != -1) {
+        switch (c) {
+        case 'b':
+            cvalue = optarg;
+            block_size = (uint32_t)strtol(cvalue, &ptr, 10);
+            break;
+        case 'c':
+            cvalue = optarg;
+            block_count = (uint32_t)strtol(cvalue, &ptr, 10);
+            break;
+        case 'C':
+            cvalue = optarg;
+            cache_size = (uint32_t)strtol(cvalue, &ptr, 10);
+            break;
+        case 'l':
+            cvalue = optarg;
+            lookahead = (uint32_t)strtol(cvalue, &ptr, 10);
+            break;
+        case 'n':
+            cvalue = optarg;
+            bench_count = (uint32_t)strtol(cvalue, &ptr, 10);
+            break;
+        case 's':
+            cvalue = optarg;
+            spi_clock = (uint32_t)strtol(cvalue, &ptr, 10);
+            break;
+        case 'i':
+            image_name = optarg;
+            break;
+        case 'e':
+            real_erase = true;
+            break;
+        case 'h':
+            help = true;
+            break;
+        case '?':
+            help = true;
+            break;
+        default:
+            printf ("?? getopt returned character code 0%o ??\r\n", c);
+        }
+    }
+
+    if (real_erase) block_size = w25qxx_FLASH_SECTOR_SIZE;
+    if (cache_size == 0) cache_size = block_size;
+    if ((block_size == 0) || (block_size % w25qxx_FLASH_PAGE_SIZE) || (cache_size == 0) || (cache_size % w25qxx_FLASH_PAGE_SIZE) || (block_size % cache_size) ||
+        (lookahead == 0) || (lookahead % 8) || (spi_clock == 0) || ((uint64_t)block_size * block_count > 0x80000000ULL)) {
+        printf("Wrong parameters\r\n");
+        help = true;
+    }
+    if (help) {
+        printf("Usage:\r\n");
+        printf("  lfsbench [-b block_size] [-c block_count] [-C cache_size] [-l lookahead_size]\r\n");
+        printf("           [-n count] [-s spi_clock] [-e] [-i image_name]\r\n");
+        printf("      block_size: default=512      (MICRO_PY_LITTLEFS_SECTOR_SIZE)\r\n");
+        printf("     block_count: default=20480    (MICRO_PY_FLASHFS_SIZE / MICRO_PY_LITTLEFS_SECTOR_SIZE)\r\n");
+        printf("      cache_size: default=block_size, also used as read/program size\r\n");
+        printf("  lookahead_size: default=32       (LITTLEFS_CFG_LOOKAHEAD_SIZE)\r\n");
+        printf("           count: default=100      number of calls in each benchmark\r\n");
+        printf("       spi_clock: default=%u\r\n", FLASHSIM_SPI_CLOCK);
+        printf("              -e: use real 4K sector erase instead of the dummy erase\r\n");
+        printf("      image_name: run on the image file (e.g. created by 'mklfs') instead of RAM\r\n");
+        printf("\r\n");
+        return 0;
+    }
+
+    printf("LittleFS benchmark on simulated Flash\r\n");
+    printf("=====================================\r\n");
+    printf("Block size=%u, Block count=%u, cache=%u, lookahead=%u, erase=%s, SPI clock=%u\r\n",
+            block_size, block_count, cache_size, lookahead, (real_erase) ? "real" : "dummy", spi_clock);
+    if (image_name) printf("Image: '%s'\r\n", image_name);
+
+    int err = run_benchmarks();
+    if (read_buffer) free(read_buffer);
+    if (prog_buffer) free(prog_buffer);
+    if (lookahead_buffer) free(lookahead_buffer);
+    printf("=====================================\r\n");
+    printf("\r\n");
+
+    return (err < 0) ? 1 : 0;
+}